@@ -0,0 +1,130 @@
+#include "fixture_database.hpp"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool make_directory(const std::string& path)
+{
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool write_file(const std::string& path, const std::string& content)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+    return static_cast<bool>(out);
+}
+
+std::string package_name(const std::string& repository, size_t index)
+{
+    return repository + "-fixture-" + std::to_string(index);
+}
+
+std::string package_desc(const std::string& name, const std::string& version, const std::string& repository)
+{
+    std::ostringstream desc;
+    desc << "%FILENAME%\n" << name << "-" << version << "-x86_64.pkg.tar.zst\n\n"
+         << "%NAME%\n" << name << "\n\n"
+         << "%VERSION%\n" << version << "\n\n"
+         << "%DESC%\nFixture package " << name << " from " << repository << "\n\n"
+         << "%CSIZE%\n1048576\n\n"
+         << "%ISIZE%\n4194304\n\n"
+         << "%ARCH%\nx86_64\n\n";
+    return desc.str();
+}
+
+/**
+ * @brief Append one ustar entry; sync databases are plain tar archives
+ */
+void append_tar_entry(std::string& archive, const std::string& path, const std::string& content, bool directory)
+{
+    char header[512] = {};
+    snprintf(header, 100, "%s", path.c_str());
+    snprintf(header + 100, 8, "%07o", directory ? 0755 : 0644);
+    snprintf(header + 108, 8, "%07o", 0);
+    snprintf(header + 116, 8, "%07o", 0);
+    snprintf(header + 124, 12, "%011lo", static_cast<unsigned long>(directory ? 0 : content.size()));
+    snprintf(header + 136, 12, "%011lo", static_cast<unsigned long>(time(nullptr)));
+    header[156] = directory ? '5' : '0';
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+
+    // The checksum is computed with its own field filled with spaces
+    memset(header + 148, ' ', 8);
+    unsigned int checksum = 0;
+    for (unsigned char byte : header) {
+        checksum += byte;
+    }
+    snprintf(header + 148, 8, "%06o", checksum);
+    header[155] = ' ';
+
+    archive.append(header, sizeof(header));
+    if (!directory) {
+        archive.append(content);
+        archive.append((512 - content.size() % 512) % 512, '\0');
+    }
+}
+
+} // namespace
+
+bool create_fixture_database(const std::string& dir, size_t installed, size_t available,
+                             const std::vector<std::string>& repositories)
+{
+    std::string db = dir + "/db";
+    std::string local = db + "/local";
+    std::string sync = db + "/sync";
+    if (!make_directory(dir) || !make_directory(db) || !make_directory(local) ||
+        !make_directory(sync) || !make_directory(dir + "/cache")) {
+        std::cerr << "startup_benchmark: Failed to create " << dir << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    write_file(local + "/ALPM_DB_VERSION", "9\n");
+
+    const size_t repository_count = repositories.size();
+    std::ostringstream config;
+    config << "[options]\nArchitecture = x86_64\nCacheDir = " << dir << "/cache/\n\n";
+
+    for (size_t r = 0; r < repository_count; ++r) {
+        const std::string& repository = repositories[r];
+        std::string archive;
+        for (size_t i = r; i < available; i += repository_count) {
+            std::string name = package_name(repository, i);
+            std::string entry = name + "-1.0-1";
+            append_tar_entry(archive, entry + "/", "", true);
+            append_tar_entry(archive, entry + "/desc", package_desc(name, "1.0-1", repository), false);
+        }
+        archive.append(1024, '\0');
+
+        if (!write_file(sync + "/" + repository + ".db", archive)) {
+            std::cerr << "startup_benchmark: Failed to write " << repository << ".db" << std::endl;
+            return false;
+        }
+        config << "[" << repository << "]\nServer = file://" << dir << "/repo/" << repository << "\n\n";
+    }
+
+    // Installed packages are a slice of the available ones, some of them outdated
+    for (size_t i = 0; i < installed && i < available; ++i) {
+        const std::string& repository = repositories[i % repository_count];
+        std::string name = package_name(repository, i);
+        std::string version = i % 10 == 0 ? "0.9-1" : "1.0-1";
+        std::string entry = local + "/" + name + "-" + version;
+        if (!make_directory(entry) ||
+            !write_file(entry + "/desc", package_desc(name, version, repository) + "%REASON%\n0\n\n") ||
+            !write_file(entry + "/files", "%FILES%\n\n")) {
+            std::cerr << "startup_benchmark: Failed to write " << entry << std::endl;
+            return false;
+        }
+    }
+
+    return write_file(dir + "/pacman.conf", config.str());
+}
+
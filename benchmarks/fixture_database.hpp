@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Write a pacman root with a local database, sync databases and a pacman.conf
+ *
+ * Available packages are spread round-robin over the repositories, which are
+ * written as uncompressed tar databases. The first installed packages are a
+ * slice of the available ones, every tenth of them one version behind.
+ *
+ * @param dir Directory to create the fixture in, the root and db path are dir/ and dir/db/
+ * @param installed Number of packages in the local database
+ * @param available Number of packages in all sync databases together
+ * @param repositories Names of the sync databases
+ * @return bool True if every file was written
+ */
+bool create_fixture_database(const std::string& dir, size_t installed, size_t available,
+                             const std::vector<std::string>& repositories = {"core", "extra", "multilib"});
@@ -0,0 +1,225 @@
+#include "core/repository.hpp"
+#include "core/pacman_config.hpp"
+#include "core/search_index.hpp"
+#include "fixture_database.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Measures how loading, converting and searching the repositories scales
+ * with the number of worker threads.
+ *
+ * For every database size a fixture with four sync databases is generated.
+ * Each worker count runs in a forked process, because the shared thread pool
+ * reads PACMANGUI_THREADS once when it is first used. The calling thread
+ * takes part in the work, so one worker means two threads at most.
+ *
+ * Usage: pacmangui-repository-benchmark [--sizes 1000,10000,100000] [--threads 1,2,4] [--runs N]
+ */
+
+using namespace pacmangui::core;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadTimes {
+    double load_ms = 0;     ///< RepositoryManager::initialize(), reading every database and indexing it
+    double convert_ms = 0;  ///< RepositoryManager::get_all_packages()
+    double search_ms = 0;   ///< Ranked search over names and descriptions
+};
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::vector<size_t> parse_list(const std::string& text)
+{
+    std::vector<size_t> values;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        values.push_back(std::stoul(text.substr(start, end - start)));
+        start = end + 1;
+    }
+    return values;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+/**
+ * @brief Load the fixture from scratch and time each step, median of several runs
+ */
+bool measure(const std::string& fixture, int runs, LoadTimes& result)
+{
+    PacmanConfig config;
+    if (!config.load(fixture + "/pacman.conf")) {
+        std::cerr << "repository_benchmark: " << config.get_last_error() << std::endl;
+        return false;
+    }
+
+    std::vector<double> load;
+    std::vector<double> convert;
+    std::vector<double> search;
+    for (int run = 0; run < runs; ++run) {
+        alpm_errno_t err;
+        alpm_handle_t* handle = alpm_initialize((fixture + "/").c_str(), (fixture + "/db/").c_str(), &err);
+        if (!handle) {
+            std::cerr << "repository_benchmark: " << alpm_strerror(err) << std::endl;
+            return false;
+        }
+        config.apply(handle);
+
+        {
+            RepositoryManager manager(handle);
+            Clock::time_point start = Clock::now();
+            manager.initialize();
+            load.push_back(elapsed_ms(start));
+
+            start = Clock::now();
+            std::vector<Package> packages = manager.get_all_packages();
+            convert.push_back(elapsed_ms(start));
+
+            start = Clock::now();
+            std::vector<SearchHit> hits = manager.get_search_index()->search("fixture package 1");
+            search.push_back(elapsed_ms(start));
+        }
+
+        alpm_release(handle);
+    }
+
+    result.load_ms = median(load);
+    result.convert_ms = median(convert);
+    result.search_ms = median(search);
+    return true;
+}
+
+/**
+ * @brief Run measure() in a child process with the given number of workers
+ */
+bool measure_with_workers(const std::string& fixture, size_t workers, int runs, LoadTimes& result)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        setenv("PACMANGUI_THREADS", std::to_string(workers).c_str(), 1);
+
+        // Keep the per-database log lines out of the table
+        if (!freopen("/dev/null", "w", stdout)) {
+            _exit(1);
+        }
+        LoadTimes times;
+        bool ok = measure(fixture, runs, times) &&
+                  write(fds[1], &times, sizeof(times)) == static_cast<ssize_t>(sizeof(times));
+        _exit(ok ? 0 : 1);
+    }
+
+    close(fds[1]);
+    bool ok = read(fds[0], &result, sizeof(result)) == static_cast<ssize_t>(sizeof(result));
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    std::vector<size_t> worker_counts;
+    int runs = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sizes" && i + 1 < argc) {
+            sizes = parse_list(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            worker_counts = parse_list(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::stoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--sizes 1000,10000,100000] [--threads 1,2,4] [--runs N]" << std::endl;
+            return 2;
+        }
+    }
+
+    // Powers of two up to the number of cores
+    if (worker_counts.empty()) {
+        size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t workers = 1; workers < cores; workers *= 2) {
+            worker_counts.push_back(workers);
+        }
+        worker_counts.push_back(cores);
+    }
+
+    const std::vector<std::string> repositories = {"core", "extra", "multilib", "chaotic-aur"};
+
+    printf("%10s %8s %12s %12s %12s %9s\n", "packages", "workers", "load ms", "convert ms", "search ms", "speedup");
+    for (size_t size : sizes) {
+        char pattern[] = "/tmp/pacmangui-repositoriesXXXXXX";
+        if (!mkdtemp(pattern)) {
+            std::cerr << "repository_benchmark: Failed to create a temporary directory" << std::endl;
+            return 1;
+        }
+        std::string fixture = pattern;
+        if (!create_fixture_database(fixture, std::min<size_t>(size / 10, 2000), size, repositories)) {
+            return 1;
+        }
+
+        double baseline = 0;
+        for (size_t workers : worker_counts) {
+            LoadTimes times;
+            if (!measure_with_workers(fixture, workers, runs, times)) {
+                std::cerr << "repository_benchmark: Measuring " << size << " packages with "
+                          << workers << " workers failed" << std::endl;
+                continue;
+            }
+
+            double total = times.load_ms + times.convert_ms + times.search_ms;
+            if (baseline == 0) {
+                baseline = total;
+            }
+            printf("%10zu %8zu %12.1f %12.1f %12.2f %8.2fx\n", size, workers,
+                   times.load_ms, times.convert_ms, times.search_ms, baseline / total);
+        }
+
+        std::string command = "rm -rf '" + fixture + "'";
+        if (system(command.c_str()) != 0) {
+            std::cerr << "repository_benchmark: Failed to remove " << fixture << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "core/packagemanager.hpp"
+#include "fixture_database.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Measures how long PackageManager takes until the main window could be shown.
+ *
+ * The GUI constructs its window as soon as PackageManager::initialize()
+ * returns and fills the installed list once the local catalog is published,
+ * so both points are reported next to the total load time. The databases are
+ * a generated fixture so runs are comparable between machines. The snapshot
+ * row starts from a catalog snapshot written by a warm-up run.
+ *
+ * Usage: pacmangui-startup-benchmark [--fixture DIR] [--installed N] [--available N] [--runs N]
+ */
+
+using namespace pacmangui::core;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+struct StartupTimes {
+    double initialize_ms = 0;  ///< initialize() returned, the window can be constructed
+    double installed_ms = 0;   ///< Local catalog published, the installed list can be filled
+    double complete_ms = 0;    ///< All catalogs and the search index published
+};
+
+StartupTimes measure(const std::string& fixture, bool background, const std::string& snapshot = "")
+{
+    StartupTimes times;
+
+    Clock::time_point start = Clock::now();
+    PackageManager manager;
+    manager.set_config_path(fixture + "/pacman.conf");
+    manager.set_snapshot_path(snapshot);
+
+    CatalogLoadedCallback on_loaded;
+    if (background) {
+        on_loaded = [&](bool all) {
+            (all ? times.complete_ms : times.installed_ms) = elapsed_ms(start, Clock::now());
+        };
+    }
+
+    if (!manager.initialize(fixture + "/", fixture + "/db/", on_loaded)) {
+        std::cerr << "startup_benchmark: " << manager.get_last_error() << std::endl;
+        exit(1);
+    }
+    times.initialize_ms = elapsed_ms(start, Clock::now());
+
+    if (background) {
+        // The callback's writes are visible once the loader has finished
+        manager.wait_until_loaded();
+
+        // Started from a snapshot, the installed list was there right away
+        if (times.installed_ms == 0) {
+            times.installed_ms = times.initialize_ms;
+        }
+    } else {
+        times.installed_ms = times.initialize_ms;
+        times.complete_ms = times.initialize_ms;
+    }
+    return times;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void report(const std::string& label, const std::vector<StartupTimes>& runs)
+{
+    std::vector<double> initialize;
+    std::vector<double> installed;
+    std::vector<double> complete;
+    for (const StartupTimes& run : runs) {
+        initialize.push_back(run.initialize_ms);
+        installed.push_back(run.installed_ms);
+        complete.push_back(run.complete_ms);
+    }
+
+    printf("%-12s first window %8.1f ms   installed list %8.1f ms   all databases %8.1f ms\n",
+           label.c_str(), median(initialize), median(installed), median(complete));
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::string fixture;
+    size_t installed = 1500;
+    size_t available = 15000;
+    int runs = 5;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fixture" && i + 1 < argc) {
+            fixture = argv[++i];
+        } else if (arg == "--installed" && i + 1 < argc) {
+            installed = std::stoul(argv[++i]);
+        } else if (arg == "--available" && i + 1 < argc) {
+            available = std::stoul(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::stoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--fixture DIR] [--installed N] [--available N] [--runs N]" << std::endl;
+            return 2;
+        }
+    }
+
+    // Without a fixture directory a fresh one is generated and removed afterwards
+    bool generated = fixture.empty();
+    if (generated) {
+        char pattern[] = "/tmp/pacmangui-startupXXXXXX";
+        if (!mkdtemp(pattern)) {
+            std::cerr << "startup_benchmark: Failed to create a temporary directory" << std::endl;
+            return 1;
+        }
+        fixture = pattern;
+    }
+    if (generated || access((fixture + "/pacman.conf").c_str(), R_OK) != 0) {
+        std::cout << "startup_benchmark: Writing fixture with " << installed << " installed and "
+                  << available << " available packages to " << fixture << std::endl;
+        if (!create_fixture_database(fixture, installed, available)) {
+            return 1;
+        }
+    }
+
+    std::vector<StartupTimes> synchronous;
+    std::vector<StartupTimes> background;
+    std::vector<StartupTimes> from_snapshot;
+    std::string snapshot = fixture + "/catalog.snapshot";
+    unlink(snapshot.c_str());
+    measure(fixture, false, snapshot);
+    for (int i = 0; i < runs; ++i) {
+        synchronous.push_back(measure(fixture, false));
+        background.push_back(measure(fixture, true));
+        from_snapshot.push_back(measure(fixture, true, snapshot));
+    }
+
+    printf("\nMedian of %d runs\n", runs);
+    report("synchronous", synchronous);
+    report("background", background);
+    report("snapshot", from_snapshot);
+
+    if (generated) {
+        std::string command = "rm -rf '" + fixture + "'";
+        if (system(command.c_str()) != 0) {
+            std::cerr << "startup_benchmark: Failed to remove " << fixture << std::endl;
+        }
+    }
+    return 0;
+}
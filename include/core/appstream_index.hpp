@@ -0,0 +1,183 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "core/fuzzy_matcher.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief An application or runtime described by a remote's appstream data
+ */
+struct AppstreamComponent {
+    std::string id;                       ///< Flatpak ID, from the bundle ref when there is one
+    std::string name;                     ///< Untranslated display name
+    std::string summary;                  ///< Untranslated one-line summary
+    std::string branch;                   ///< Branch of the bundle ref, e.g. stable
+    std::string version;                  ///< Version of the newest release, if listed
+    std::vector<std::string> keywords;    ///< Untranslated search keywords
+    std::vector<std::string> categories;  ///< Desktop menu categories
+};
+
+/**
+ * @brief A component as stored in an index, pointing into the mapped file
+ *
+ * Keywords and categories are joined with ';'. The views stay valid while
+ * the index that returned them is open.
+ */
+struct AppstreamEntry {
+    std::string_view id;          ///< Flatpak ID
+    std::string_view name;        ///< Display name
+    std::string_view summary;     ///< One-line summary
+    std::string_view branch;      ///< Branch
+    std::string_view version;     ///< Newest release
+    std::string_view keywords;    ///< Search keywords
+    std::string_view categories;  ///< Menu categories
+};
+
+/**
+ * @brief Compact on-disk index of one remote's appstream catalog
+ *
+ * The appstream XML of a remote is parsed once and written as fixed-size
+ * records over a string pool, tagged with the checksum of the data it was
+ * built from. Opening an index maps the file and serves lookups and
+ * searches straight from the mapping, so a search touches no XML and
+ * starts no process.
+ */
+class AppstreamIndex {
+public:
+    static constexpr uint32_t kFormatVersion = 1; ///< Bumped when the layout changes
+
+    /**
+     * @brief Constructor, the index starts closed
+     */
+    AppstreamIndex();
+
+    /**
+     * @brief Destructor, unmaps the file
+     */
+    ~AppstreamIndex();
+
+    AppstreamIndex(const AppstreamIndex&) = delete;
+    AppstreamIndex& operator=(const AppstreamIndex&) = delete;
+
+    /**
+     * @brief Read an appstream file, gzip-compressed or not
+     * @param path File to read, usually appstream.xml.gz
+     * @param xml Receives the uncompressed document
+     * @param error Receives the reason on failure
+     * @return bool True if the file was read
+     */
+    static bool read_file(const std::string& path, std::string& xml, std::string& error);
+
+    /**
+     * @brief Parse an appstream document
+     *
+     * Keeps the untranslated name, summary and keywords of each component,
+     * its categories, the newest release and the ID and branch of its
+     * Flatpak bundle. Components without an ID or a name are skipped.
+     *
+     * @param xml The document
+     * @param components Receives the components in document order
+     * @param error Receives the reason on failure
+     * @return bool True if the document is well formed
+     */
+    static bool parse(const std::string& xml, std::vector<AppstreamComponent>& components, std::string& error);
+
+    /**
+     * @brief Write components to an index file, replacing it atomically
+     * @param path Index file, parent directories are created
+     * @param checksum Checksum of the appstream data the components came from
+     * @param components Components to store
+     * @param error Receives the reason on failure
+     * @return bool True if the file was written
+     */
+    static bool write(const std::string& path, const std::string& checksum,
+                      const std::vector<AppstreamComponent>& components, std::string& error);
+
+    /**
+     * @brief Map an index file, closing the one open before
+     * @param path Index file
+     * @return bool True if the file is a valid index
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmap the file
+     */
+    void close();
+
+    /**
+     * @brief Check whether an index is open
+     * @return bool True if open
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Get the checksum the index was built from
+     * @return const std::string& The checksum, empty when closed
+     */
+    const std::string& get_checksum() const;
+
+    /**
+     * @brief Get the number of components
+     * @return size_t The count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get a component
+     * @param index Component number, below size()
+     * @return AppstreamEntry The component
+     */
+    AppstreamEntry at(size_t index) const;
+
+    /**
+     * @brief Rank the components against a query
+     *
+     * Names and IDs are both scored as names; summaries and keywords count
+     * as the description.
+     *
+     * @param matcher Matcher built from the query
+     * @param limit Maximum number of matches, 0 for no limit
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<FuzzyMatch> Matches, best first, with the component number as index
+     */
+    std::vector<FuzzyMatch> search(const FuzzyMatcher& matcher, size_t limit,
+                                   const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief Offsets of one component's strings in the pool
+     */
+    struct Record {
+        uint32_t offset[7];   ///< Start of each field, in AppstreamEntry order
+        uint32_t length[7];   ///< Length of each field
+    };
+
+    std::string_view field(const Record& record, int number) const;
+    Record record(size_t index) const;
+
+    void* m_mapping;           ///< Mapped file, or null
+    size_t m_length;           ///< Mapped length
+    const char* m_records;     ///< First record in the mapping
+    const char* m_pool;        ///< String pool in the mapping
+    uint32_t m_count;          ///< Number of records
+    uint32_t m_pool_size;      ///< Size of the string pool
+    std::string m_checksum;    ///< Checksum stored in the header
+    std::string m_last_error;  ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
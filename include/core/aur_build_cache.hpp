@@ -0,0 +1,211 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <sys/types.h>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief One cached build
+ */
+struct AurCacheEntry {
+    std::string key;         ///< Build key, names the directory
+    std::string path;        ///< Directory holding the package files
+    uint64_t size = 0;       ///< Bytes used by the package files
+    time_t last_used = 0;    ///< When the entry was last stored or used
+};
+
+/**
+ * @brief Content-addressed cache of built AUR packages
+ *
+ * A build is keyed by a SHA-256 over the PKGBUILD, the .SRCINFO (which holds
+ * the source checksums), local source files such as patches, and the
+ * makepkg.conf files, so anything that changes the result of makepkg changes
+ * the key. Each key is a directory holding the package files built from it.
+ *
+ * Bases with VCS sources (git+, svn+, ...) are never cached, their result
+ * depends on the upstream repository rather than the checkout.
+ *
+ * A shared directory, for example on a network mount, can be set in addition
+ * to the user's own. Lookups fall back to it. Its packages are installed as
+ * root, so it is only used while it, its entries and their files belong to
+ * the trusted owner and are not writable by group or others, and each of its
+ * parents belongs to root or the trusted owner and is not writable by others
+ * or has the sticky bit. None of them may be a symbolic link. New builds are
+ * only copied to it when running as the trusted owner, by default root, so a
+ * normal user only reads it. Only the user's own directory is pruned.
+ */
+class AurBuildCache {
+public:
+    /**
+     * @brief Constructor
+     * @param directory Directory holding the cache entries
+     */
+    explicit AurBuildCache(const std::string& directory = default_directory());
+
+    /**
+     * @brief Get the cache directory for the current user
+     * @return std::string $XDG_CACHE_HOME/pacmangui/aur-packages, or the same under ~/.cache
+     */
+    static std::string default_directory();
+
+    /**
+     * @brief Get the makepkg configuration files that exist on this system
+     * @return std::vector<std::string> /etc/makepkg.conf, its drop-ins and the user's makepkg.conf
+     */
+    static std::vector<std::string> default_config_files();
+
+    /**
+     * @brief Get the package name from a package file name
+     * @param path "/dest/foo-bar-1.0-2-x86_64.pkg.tar.zst"
+     * @return std::string "foo-bar", or empty if the name is not a package file
+     */
+    static std::string package_name(const std::string& path);
+
+    /**
+     * @brief Get the cache directory
+     * @return const std::string& The path
+     */
+    const std::string& get_directory() const;
+
+    /**
+     * @brief Set a directory shared with other users or machines
+     * @param directory Shared directory, empty for none
+     * @param trusted_owner User the directory and its entries have to belong to
+     */
+    void set_shared_directory(const std::string& directory, uid_t trusted_owner = 0);
+
+    /**
+     * @brief Get the shared directory
+     * @return const std::string& The path, empty if none is set
+     */
+    const std::string& get_shared_directory() const;
+
+    /**
+     * @brief Set the makepkg configuration files that are part of the key
+     * @param files Paths, missing files are part of the key as missing
+     */
+    void set_config_files(const std::vector<std::string>& files);
+
+    /**
+     * @brief Compute the build key of a checkout
+     * @param checkout Directory holding PKGBUILD and .SRCINFO
+     * @param key Receives the key
+     * @return bool False if the checkout cannot be cached
+     */
+    bool compute_key(const std::string& checkout, std::string& key);
+
+    /**
+     * @brief Find the cached files of a build
+     *
+     * A hit marks the entry as used.
+     *
+     * @param key Build key
+     * @param packages Packages that have to be in the entry
+     * @param files Receives the package files, in the order of packages
+     * @return bool True if every package was found
+     */
+    bool lookup(const std::string& key, const std::vector<std::string>& packages, std::vector<std::string>& files);
+
+    /**
+     * @brief Copy built package files into the cache
+     *
+     * They are also copied to the shared directory when running as its trusted owner.
+     *
+     * @param key Build key
+     * @param files Package files
+     * @return bool True if the files were stored in the user's directory
+     */
+    bool store(const std::string& key, const std::vector<std::string>& files);
+
+    /**
+     * @brief List the entries in the user's directory
+     * @return std::vector<AurCacheEntry> The entries, least recently used first
+     */
+    std::vector<AurCacheEntry> get_entries() const;
+
+    /**
+     * @brief Remove old entries
+     *
+     * Entries unused for longer than max_age go first, then the least
+     * recently used ones until the cache fits into max_bytes.
+     *
+     * @param max_bytes Size limit, 0 for none
+     * @param max_age Age limit in seconds, 0 for none
+     * @return size_t Number of entries removed
+     */
+    size_t prune(uint64_t max_bytes, time_t max_age);
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief Find the cached files of a build in one directory
+     * @param directory Cache directory
+     * @param key Build key
+     * @param packages Packages that have to be in the entry
+     * @param files Receives the package files
+     * @return bool True if every package was found
+     */
+    bool lookup_in(const std::string& directory, const std::string& key, const std::vector<std::string>& packages,
+                   std::vector<std::string>& files);
+
+    /**
+     * @brief Copy package files into one directory
+     * @param directory Cache directory
+     * @param key Build key
+     * @param files Package files
+     * @return bool True if every file was copied
+     */
+    bool store_in(const std::string& directory, const std::string& key, const std::vector<std::string>& files);
+
+    /**
+     * @brief Find the cached files of a build in the shared directory
+     *
+     * The entry and its files are resolved from the directory descriptor
+     * without following symbolic links, and each has to be trusted.
+     *
+     * @param shared_fd Descriptor of the shared directory
+     * @param key Build key
+     * @param packages Packages that have to be in the entry
+     * @param files Receives the package files
+     * @return bool True if every package was found
+     */
+    bool lookup_shared(int shared_fd, const std::string& key, const std::vector<std::string>& packages,
+                       std::vector<std::string>& files);
+
+    /**
+     * @brief Open the shared directory if only the trusted owner and root can have changed it
+     *
+     * Each component is opened relative to its parent without following
+     * symbolic links and checked through the open descriptor.
+     *
+     * @return int Descriptor of the directory, -1 if it is not trusted, the reason is logged
+     */
+    int open_shared_directory();
+
+    /**
+     * @brief Set the last error message and log it
+     * @param error Error message, empty on success
+     */
+    void set_last_error(const std::string& error);
+
+    std::string m_directory;                 ///< The user's entries
+    std::string m_shared_directory;          ///< Entries shared with others
+    uid_t m_shared_owner;                    ///< Required owner of the shared entries
+    std::vector<std::string> m_config_files; ///< makepkg.conf files in the key
+    mutable std::mutex m_mutex;              ///< Guards m_last_error
+    std::string m_last_error;                ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include "core/aur_client.hpp"
+
+namespace pacmangui {
+namespace core {
+
+class ProcessRunner;
+class AurBuildCache;
+
+/**
+ * @brief Where a dependency of an AUR package can be satisfied from
+ */
+enum class AurDependencyState {
+    INSTALLED,   ///< An installed package satisfies it
+    REPOSITORY,  ///< A package in the sync databases satisfies it
+    MISSING      ///< Neither, it has to come from the AUR
+};
+
+/**
+ * @brief Callback deciding where a dependency string such as "glibc>=2.38" is satisfied from
+ */
+using AurDependencyResolver = std::function<AurDependencyState(const std::string& depend)>;
+
+/**
+ * @brief One package base to build
+ */
+struct AurBuildTarget {
+    std::string base;                     ///< Package base, names the git repository
+    std::string version;                  ///< Version in the AUR
+    std::vector<std::string> packages;    ///< Packages of the base to install
+    std::vector<std::string> depends_on;  ///< Bases that have to be installed before this one is built
+    bool dependency = false;              ///< Only pulled in by other targets
+};
+
+/**
+ * @brief Everything needed to build and install a set of AUR packages
+ */
+struct AurBuildPlan {
+    std::vector<AurBuildTarget> targets;         ///< Package bases, dependencies before their dependents
+    std::vector<std::string> repo_dependencies;  ///< Sync packages needed to build the targets
+};
+
+/**
+ * @brief Builds AUR packages with makepkg and installs them
+ *
+ * resolve() follows depends, makedepends and checkdepends through the AUR
+ * RPC, one info request per level of the graph, and orders the package bases
+ * so dependencies come first. build() installs missing repository
+ * dependencies, clones or updates every git repository in parallel and runs
+ * makepkg for independent bases concurrently, up to the job limit. A base is
+ * built once every AUR base it needs is installed; built packages that a
+ * pending build needs are installed right away, all others together in one
+ * transaction at the end. With a build cache set, bases whose PKGBUILD and
+ * configuration were built before are installed from the cache instead.
+ *
+ * Output of git and makepkg is passed to the output callback line by line,
+ * prefixed with the package base.
+ */
+class AurBuilder {
+public:
+    static constexpr const char* kGitUrl = "https://aur.archlinux.org"; ///< Hosts <base>.git
+
+    /**
+     * @brief Callback installing sync packages as dependencies
+     */
+    using RepoInstallCallback = std::function<bool(const std::vector<std::string>& names)>;
+
+    /**
+     * @brief Callback installing package files in one transaction
+     *
+     * The second argument lists the files to install as dependencies.
+     */
+    using FileInstallCallback = std::function<bool(const std::vector<std::string>& files,
+                                                   const std::vector<std::string>& dependencies)>;
+
+    /**
+     * @brief Constructor
+     * @param client Client used to look up packages
+     * @param build_dir Directory holding one git checkout per package base
+     */
+    explicit AurBuilder(AurClient& client, const std::string& build_dir = default_build_dir());
+
+    /**
+     * @brief Destructor
+     */
+    ~AurBuilder();
+
+    AurBuilder(const AurBuilder&) = delete;
+    AurBuilder& operator=(const AurBuilder&) = delete;
+
+    /**
+     * @brief Get the build directory for the current user
+     * @return std::string $XDG_CACHE_HOME/pacmangui/aur, or the same under ~/.cache
+     */
+    static std::string default_build_dir();
+
+    /**
+     * @brief Get the build directory
+     * @return const std::string& The path
+     */
+    const std::string& get_build_dir() const;
+
+    /**
+     * @brief Set how many makepkg processes may run at once
+     * @param jobs Job limit, 0 for half the CPUs
+     */
+    void set_jobs(size_t jobs);
+
+    /**
+     * @brief Get how many makepkg processes may run at once
+     * @return size_t The job limit
+     */
+    size_t get_jobs() const;
+
+    /**
+     * @brief Set where the package repositories are cloned from
+     * @param url Base URL, <url>/<base>.git is cloned
+     */
+    void set_git_url(const std::string& url);
+
+    /**
+     * @brief Set the program that builds packages
+     * @param program makepkg or a compatible program
+     */
+    void set_makepkg(const std::string& program);
+
+    /**
+     * @brief Set the cache built packages are reused from and stored in
+     * @param cache The cache, must outlive the builder (may be null)
+     */
+    void set_cache(AurBuildCache* cache);
+
+    /**
+     * @brief Set the callback receiving build output
+     * @param callback Receives one line at a time, including the newline
+     */
+    void set_output_callback(std::function<void(const std::string&)> callback);
+
+    /**
+     * @brief Resolve the AUR packages needed to install a set of packages
+     * @param names Packages to install
+     * @param resolver Decides which dependencies are already available
+     * @param plan Receives the package bases in build order
+     * @return bool True if every package and dependency was found
+     */
+    bool resolve(const std::vector<std::string>& names, const AurDependencyResolver& resolver, AurBuildPlan& plan);
+
+    /**
+     * @brief Sort package bases so each comes after the bases it depends on
+     *
+     * The order is otherwise kept, so independent bases stay in the order given.
+     *
+     * @param targets Package bases, sorted in place
+     * @param error Receives the error message on failure
+     * @return bool False if the bases depend on each other in a cycle
+     */
+    static bool order(std::vector<AurBuildTarget>& targets, std::string& error);
+
+    /**
+     * @brief Build and install the packages of a plan
+     *
+     * Independent bases keep building when one fails, bases depending on a
+     * failed one are skipped. Whatever was built is installed.
+     *
+     * @param plan Plan from resolve()
+     * @param install_repo Installs the repository dependencies
+     * @param install_files Installs built package files
+     * @return bool True if every base was built and installed
+     */
+    bool build(const AurBuildPlan& plan, const RepoInstallCallback& install_repo,
+               const FileInstallCallback& install_files);
+
+    /**
+     * @brief Stop running builds and start no new ones
+     *
+     * Safe to call from any thread.
+     */
+    void cancel();
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief Clone or update the git repository of a base
+     * @param base Package base
+     * @param error Receives the error message on failure
+     * @return bool True if the checkout is up to date
+     */
+    bool fetch(const std::string& base, std::string& error);
+
+    /**
+     * @brief Build a base and collect the files of the wanted packages
+     * @param target The base
+     * @param files Receives the package files
+     * @param error Receives the error message on failure
+     * @return bool True if every wanted package was built
+     */
+    bool make(const AurBuildTarget& target, std::vector<std::string>& files, std::string& error);
+
+    /**
+     * @brief Run a program and forward its output
+     * @param base Package base the output is prefixed with
+     * @param args Program and arguments
+     * @param directory Working directory, empty for ours
+     * @param output Receives stdout lines instead of the output callback (may be null)
+     * @param error Receives the error message on failure
+     * @return bool True if the program exited with status 0
+     */
+    bool run(const std::string& base, const std::vector<std::string>& args, const std::string& directory,
+             std::vector<std::string>* output, std::string& error);
+
+    /**
+     * @brief Pass a line to the output callback
+     * @param base Package base, empty for messages about the whole build
+     * @param line Line without its newline
+     */
+    void emit(const std::string& base, const std::string& line);
+
+    /**
+     * @brief Set the last error message and log it
+     * @param error Error message, empty on success
+     */
+    void set_last_error(const std::string& error);
+
+    AurClient& m_client;                                       ///< Package lookups
+    std::string m_build_dir;                                   ///< One checkout per base
+    std::string m_git_url;                                     ///< Clone source
+    std::string m_makepkg;                                     ///< Build program
+    size_t m_jobs;                                             ///< Concurrent builds
+    AurBuildCache* m_cache;                                    ///< Reused builds, may be null
+    std::function<void(const std::string&)> m_output_callback; ///< Build output
+    std::atomic<bool> m_cancelled;                             ///< cancel() was called
+    std::vector<ProcessRunner*> m_runners;                     ///< Running processes, for cancel()
+    std::mutex m_runner_mutex;                                 ///< Guards m_runners
+    std::mutex m_output_mutex;                                 ///< Keeps lines of parallel builds whole
+    mutable std::mutex m_mutex;                                ///< Guards m_last_error
+    std::string m_last_error;                                  ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include "core/package.hpp"
+#include "core/json_parser.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief A package as described by the AUR RPC interface
+ */
+struct AurPackage {
+    std::string name;                        ///< Package name
+    std::string package_base;                ///< Package base the package is built from
+    std::string version;                     ///< Version including the release
+    std::string description;                 ///< Description
+    std::string url;                         ///< Upstream URL
+    std::string url_path;                    ///< Path of the snapshot tarball on the AUR
+    std::string maintainer;                  ///< Maintainer, empty if orphaned
+    std::vector<std::string> depends;        ///< Run-time dependencies
+    std::vector<std::string> make_depends;   ///< Build-time dependencies
+    std::vector<std::string> check_depends;  ///< Dependencies of the check() step
+    std::vector<std::string> opt_depends;    ///< Optional dependencies with their reason
+    std::vector<std::string> provides;       ///< Provided names
+    std::vector<std::string> conflicts;      ///< Conflicting packages
+    std::vector<std::string> replaces;       ///< Replaced packages
+    std::vector<std::string> licenses;       ///< Licenses
+    std::vector<std::string> keywords;       ///< Keywords
+    uint32_t num_votes = 0;                  ///< Number of votes
+    double popularity = 0.0;                 ///< Popularity score
+    int64_t out_of_date = 0;                 ///< Time it was flagged out of date, 0 if not flagged
+    int64_t first_submitted = 0;             ///< Time of the first submission
+    int64_t last_modified = 0;               ///< Time of the last update
+
+    /**
+     * @brief Convert to a package for the package lists
+     * @return Package Package in the "aur" repository
+     */
+    Package to_package() const;
+};
+
+/**
+ * @brief Field an AUR search matches against
+ */
+enum class AurSearchField {
+    NAME,            ///< Package name
+    NAME_DESC,       ///< Package name and description
+    MAINTAINER,      ///< Maintainer's user name
+    DEPENDS,         ///< Packages depending on the term
+    MAKE_DEPENDS,    ///< Packages with the term as build dependency
+    OPT_DEPENDS,     ///< Packages with the term as optional dependency
+    CHECK_DEPENDS    ///< Packages with the term as check dependency
+};
+
+/**
+ * @brief Builds AurPackages from the JSON the AUR serves
+ *
+ * Understands RPC responses, whose "results" array holds the packages, as
+ * well as the metadata dumps, which are a bare array of the same objects.
+ * Each package is handed over as soon as its object is complete.
+ */
+class AurJsonHandler : public JsonHandler {
+public:
+    using PackageCallback = std::function<void(AurPackage&& package)>;
+
+    /**
+     * @brief Constructor
+     * @param rpc_response True for an RPC response, false for a dump
+     * @param on_package Receives every complete package
+     */
+    AurJsonHandler(bool rpc_response, PackageCallback on_package);
+
+    void begin_object() override;
+    void end_object() override;
+    void begin_array() override;
+    void end_array() override;
+    void key(std::string_view name) override;
+    void string_value(std::string_view value) override;
+    void number_value(double value, std::string_view text) override;
+
+    /**
+     * @brief Get the "type" of an RPC response
+     * @return const std::string& "search", "multiinfo" or "error"
+     */
+    const std::string& get_type() const;
+
+    /**
+     * @brief Get the message of an RPC error response
+     * @return const std::string& The message, empty if there was none
+     */
+    const std::string& get_error() const;
+
+private:
+    using StringField = std::string AurPackage::*;
+    using ListField = std::vector<std::string> AurPackage::*;
+
+    static const std::unordered_map<std::string_view, StringField>& string_fields();
+    static const std::unordered_map<std::string_view, ListField>& list_fields();
+
+    PackageCallback m_on_package;        ///< Receives the packages
+    int m_package_depth;                 ///< Nesting level of the package objects
+    int m_depth;                         ///< Current nesting level
+    bool m_in_results;                   ///< Inside the package array
+    bool m_in_package;                   ///< Inside a package object
+    AurPackage m_package;                ///< Package being read
+    std::vector<std::string>* m_list;    ///< List field being read, nullptr if unknown
+    std::string m_key;                   ///< Last member name at the response or package level
+    std::string m_type;                  ///< RPC response type
+    std::string m_error;                 ///< RPC error message
+    bool m_rpc_response;                 ///< Reading an RPC response rather than a dump
+};
+
+/**
+ * @brief Client for version 5 of the AUR RPC interface
+ *
+ * Requests go through libcurl handles that are kept between calls, so the
+ * connection to the AUR (and its TLS session) is reused instead of being set
+ * up for every query. Responses are requested gzip compressed and run
+ * through a streaming JSON parser while they arrive; packages are built
+ * directly from the parser events without keeping the response text around.
+ * The client is thread-safe; concurrent calls each get their own handle.
+ */
+class AurClient {
+public:
+    static constexpr const char* kDefaultUrl = "https://aur.archlinux.org/rpc/"; ///< Official RPC endpoint
+    static constexpr size_t kMaxUrlLength = 4400;  ///< The AUR rejects longer request URIs
+
+    /**
+     * @brief Constructor
+     * @param rpc_url RPC endpoint the query string is appended to
+     */
+    explicit AurClient(const std::string& rpc_url = kDefaultUrl);
+
+    /**
+     * @brief Destructor
+     */
+    ~AurClient();
+
+    AurClient(const AurClient&) = delete;
+    AurClient& operator=(const AurClient&) = delete;
+
+    /**
+     * @brief Search the AUR
+     * @param term Search term, the AUR wants at least two characters
+     * @param by Field to match
+     * @param results Receives the matching packages
+     * @return bool True if the query succeeded, even without matches
+     */
+    bool search(const std::string& term, AurSearchField by, std::vector<AurPackage>& results);
+
+    /**
+     * @brief Get the details of packages by name
+     *
+     * Names are sent several at a time with one request per chunk that fits
+     * the URL length limit; the chunks are requested concurrently.
+     *
+     * @param names Package names; unknown names are left out of the results
+     * @param results Receives the packages found, in the order of the responses
+     * @return bool True if every request succeeded
+     */
+    bool info(const std::vector<std::string>& names, std::vector<AurPackage>& results);
+
+    /**
+     * @brief Get the RPC endpoint
+     * @return const std::string& The endpoint URL
+     */
+    const std::string& get_rpc_url() const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief Run a query and parse the response
+     * @param query Query string without the leading '?'
+     * @param results Receives the packages of the response
+     * @param error Receives the error message on failure
+     * @return bool True if the response was valid and not an error
+     */
+    bool request(const std::string& query, std::vector<AurPackage>& results, std::string& error);
+
+    /**
+     * @brief Take an idle libcurl handle or create one
+     * @return void* The handle, nullptr if libcurl failed
+     */
+    void* acquire_handle();
+
+    /**
+     * @brief Return a handle, keeping its connection for the next request
+     * @param handle Handle from acquire_handle()
+     */
+    void release_handle(void* handle);
+
+    /**
+     * @brief Set the last error message and log it
+     * @param error Error message, empty on success
+     */
+    void set_last_error(const std::string& error);
+
+    std::string m_rpc_url;         ///< RPC endpoint
+    std::vector<void*> m_handles;  ///< Idle libcurl easy handles with open connections
+    mutable std::mutex m_mutex;    ///< Guards m_handles and m_last_error
+    std::string m_last_error;      ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
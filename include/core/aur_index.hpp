@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "core/aur_client.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Local copy of the AUR package metadata for offline search
+ *
+ * Built from the packages-meta-ext-v1.json.gz dump the AUR publishes. The
+ * index is a single file with fixed-size records sorted by name followed by
+ * a pool of deduplicated strings; it is mapped into memory and searched in
+ * place, so opening it costs no parsing. Exact name lookups use binary
+ * search over the sorted records, and searches go through trigram postings
+ * of the names and descriptions that the first search needing them builds
+ * in memory.
+ *
+ * refresh() downloads the dump with If-None-Match/If-Modified-Since using
+ * the ETag and modification time stored in the index, so an unchanged dump
+ * is not transferred again. The dump is decompressed and parsed while it
+ * arrives and the index file is replaced atomically.
+ */
+class AurIndex {
+public:
+    static constexpr const char* kDumpUrl = "https://aur.archlinux.org/packages-meta-ext-v1.json.gz"; ///< Official dump
+    static constexpr uint32_t kFormatVersion = 1; ///< Bumped when the layout changes
+
+    /**
+     * @brief Constructor
+     * @param path Index file
+     */
+    explicit AurIndex(const std::string& path = default_path());
+
+    /**
+     * @brief Destructor
+     */
+    ~AurIndex();
+
+    AurIndex(const AurIndex&) = delete;
+    AurIndex& operator=(const AurIndex&) = delete;
+
+    /**
+     * @brief Get the index file for the current user
+     * @return std::string $XDG_CACHE_HOME/pacmangui/aur.index, or the same under ~/.cache
+     */
+    static std::string default_path();
+
+    /**
+     * @brief Get the index file
+     * @return const std::string& The path
+     */
+    const std::string& get_path() const;
+
+    /**
+     * @brief Map the index file if it is not mapped yet
+     * @return bool True if an index is available
+     */
+    bool open();
+
+    /**
+     * @brief Check whether an index is mapped
+     * @return bool True if open() or refresh() succeeded
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Download the dump if it changed and rebuild the index from it
+     * @param url Dump location, any URL libcurl supports
+     * @return bool True if the index is up to date afterwards
+     */
+    bool refresh(const std::string& url = kDumpUrl);
+
+    /**
+     * @brief Rebuild the index from a dump on disk
+     * @param dump_path Gzip compressed or plain JSON dump
+     * @return bool True if the index was written and mapped
+     */
+    bool build(const std::string& dump_path);
+
+    /**
+     * @brief Get the number of packages in the index
+     * @return size_t Package count, 0 if no index is open
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the modification time of the dump the index was built from
+     * @return int64_t Seconds since the epoch, 0 if unknown
+     */
+    int64_t get_source_time() const;
+
+    /**
+     * @brief Get the ETag of the dump the index was built from
+     * @return std::string The ETag, empty if unknown
+     */
+    std::string get_etag() const;
+
+    /**
+     * @brief Look up a package by its exact name
+     * @param name Package name
+     * @param package Receives the package
+     * @return bool True if the package is in the index
+     */
+    bool find(const std::string& name, AurPackage& package) const;
+
+    /**
+     * @brief Search like the AUR's name-desc search
+     *
+     * Matches the term case-insensitively as a substring of the name or,
+     * optionally, the description. The exact name comes first, then names
+     * starting with the term, other name matches and description matches;
+     * each group is ordered by popularity. Terms shorter than three
+     * characters only match an exact name, so no search scans every record.
+     *
+     * @param term Search term
+     * @param include_descriptions Whether to match descriptions
+     * @param limit Maximum number of results, 0 for no limit
+     * @return std::vector<AurPackage> Matching packages, best first
+     */
+    std::vector<AurPackage> search(const std::string& term, bool include_descriptions = true, size_t limit = 0) const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    struct Mapping;
+
+    /**
+     * @brief Map and validate an index file
+     * @param error Receives the error message on failure
+     * @return std::shared_ptr<const Mapping> The mapping, nullptr on failure
+     */
+    std::shared_ptr<const Mapping> map_file(std::string& error) const;
+
+    /**
+     * @brief Get the current mapping
+     * @return std::shared_ptr<const Mapping> The mapping, nullptr if no index is open
+     */
+    std::shared_ptr<const Mapping> get_mapping() const;
+
+    /**
+     * @brief Set the last error message and log it
+     * @param error Error message, empty on success
+     */
+    void set_last_error(const std::string& error);
+
+    std::string m_path;                          ///< Index file
+    std::shared_ptr<const Mapping> m_mapping;    ///< Mapped index, replaced by refresh()
+    std::mutex m_refresh_mutex;                  ///< Serializes refresh() and build()
+    mutable std::mutex m_mutex;                  ///< Guards m_mapping and m_last_error
+    std::string m_last_error;                    ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <alpm.h>
+#include "core/package_catalog.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief State of a database file when its catalog was read
+ */
+struct DatabaseStamp {
+    std::string name;  ///< "local" or the sync database name
+    int64_t mtime;     ///< Modification time in nanoseconds, -1 if the file is missing
+    int64_t size;      ///< File size in bytes, -1 if the file is missing
+
+    bool operator==(const DatabaseStamp& other) const
+    {
+        return name == other.name && mtime == other.mtime && size == other.size;
+    }
+    bool operator!=(const DatabaseStamp& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief On-disk copy of a package catalog for fast startup
+ *
+ * Stores every repository catalog in a binary file together with the stamps
+ * of the database files it was built from. A later launch maps the file and
+ * gets the catalog back without going through libalpm, as long as the
+ * databases have not changed since. The file is replaced atomically.
+ */
+class CatalogSnapshot {
+public:
+    static constexpr uint32_t kFormatVersion = 1; ///< Bumped when the layout changes
+
+    /**
+     * @brief Constructor
+     * @param path Snapshot file
+     */
+    explicit CatalogSnapshot(const std::string& path = default_path());
+
+    /**
+     * @brief Get the snapshot file for the current user
+     * @return std::string $XDG_CACHE_HOME/pacmangui/catalog.snapshot, or the same under ~/.cache
+     */
+    static std::string default_path();
+
+    /**
+     * @brief Stamp the local database and every registered sync database
+     * @param handle ALPM handle with the sync databases registered
+     * @return std::vector<DatabaseStamp> Local database first, then the sync databases in order
+     */
+    static std::vector<DatabaseStamp> current_stamps(alpm_handle_t* handle);
+
+    /**
+     * @brief Get the snapshot file
+     * @return const std::string& The path
+     */
+    const std::string& get_path() const;
+
+    /**
+     * @brief Read the snapshot if it matches the databases
+     * @param stamps Current stamps of the databases
+     * @param generation Generation to give the catalog
+     * @return std::shared_ptr<const PackageCatalog> The catalog, or nullptr if missing, stale or damaged
+     */
+    std::shared_ptr<const PackageCatalog> load(const std::vector<DatabaseStamp>& stamps, uint64_t generation);
+
+    /**
+     * @brief Write a catalog to the snapshot file
+     * @param catalog Catalog to store
+     * @param stamps Stamps of the databases the catalog was read from
+     * @return bool True if the file was written
+     */
+    bool save(const PackageCatalog& catalog, const std::vector<DatabaseStamp>& stamps);
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    std::string m_path;        ///< Snapshot file
+    std::string m_last_error;  ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
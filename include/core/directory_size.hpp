@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace pacmangui {
+namespace core {
+
+class ThreadPool;
+
+/**
+ * @brief Disk usage of a directory tree
+ */
+struct DirectoryUsage {
+    uint64_t bytes = 0;        ///< Allocated size, as du reports it
+    uint64_t files = 0;        ///< Entries that are not directories
+    uint64_t directories = 0;  ///< Directories, the root included
+    uint64_t unreadable = 0;   ///< Entries that could not be read and are not counted
+};
+
+/**
+ * @brief Measures directory trees with statx, spreading the walk over a thread pool
+ *
+ * The tree is walked one level at a time: the directories of a level are
+ * read in parallel and their subdirectories form the next level. Symbolic
+ * links are not followed and files with several hard links are counted
+ * once, so the result matches du -s without spawning it.
+ */
+class DirectorySizeWalker {
+public:
+    /**
+     * @brief Constructor
+     * @param pool Pool reading the directories, the shared pool if null
+     */
+    explicit DirectorySizeWalker(ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Measure a directory tree
+     *
+     * Unreadable subdirectories are skipped and counted in usage.unreadable.
+     *
+     * @param path Root of the tree
+     * @param usage Receives the usage
+     * @param cancelled Checked before every directory, the walk stops once it is set (may be null)
+     * @return bool False if the root could not be read or the walk was cancelled
+     */
+    bool measure(const std::string& path, DirectoryUsage& usage, const std::atomic<bool>* cancelled = nullptr);
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    ThreadPool& m_pool;        ///< Pool reading the directories
+    std::string m_last_error;  ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
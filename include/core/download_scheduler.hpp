@@ -0,0 +1,173 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief A file to download
+ */
+struct DownloadRequest {
+    std::string filename;              ///< Name of the file in the destination directory
+    std::vector<std::string> urls;     ///< Candidate URLs on different mirrors, preferred first
+    std::string destination;           ///< Directory the file is written to
+    uint64_t expected_size = 0;        ///< Expected size in bytes, 0 if unknown
+};
+
+/**
+ * @brief Progress of a download run
+ */
+struct DownloadProgress {
+    std::string filename;          ///< File this update is about
+    uint64_t downloaded = 0;       ///< Bytes of the file on disk, including resumed data
+    uint64_t total = 0;            ///< Size of the file, 0 if unknown
+    double rate = 0.0;             ///< Bytes per second for the file
+    uint64_t total_downloaded = 0; ///< Bytes on disk across all files
+    uint64_t total_size = 0;       ///< Known size of all files
+    double total_rate = 0.0;       ///< Aggregate bytes per second
+    size_t completed = 0;          ///< Number of finished files
+    size_t count = 0;              ///< Number of requested files
+};
+
+/**
+ * @brief Callback receiving download progress
+ */
+using DownloadProgressCallback = std::function<void(const DownloadProgress& progress)>;
+
+/**
+ * @brief Parallel downloader spreading files over several mirrors
+ *
+ * Files are fetched concurrently with libcurl's multi interface. Each mirror
+ * gets at most a fixed number of connections, so a run fans out over the
+ * mirrorlist instead of hammering the first server. Data is written to a
+ * ".part" file that is resumed on the next attempt and renamed once complete.
+ * A failed mirror hands the file to the next candidate URL.
+ */
+class DownloadScheduler {
+public:
+    /**
+     * @brief Constructor
+     * @param max_parallel Maximum number of concurrent transfers
+     * @param max_per_mirror Maximum number of concurrent transfers per mirror host
+     */
+    explicit DownloadScheduler(size_t max_parallel = 5, size_t max_per_mirror = 2);
+
+    /**
+     * @brief Destructor
+     */
+    ~DownloadScheduler();
+
+    DownloadScheduler(const DownloadScheduler&) = delete;
+    DownloadScheduler& operator=(const DownloadScheduler&) = delete;
+
+    /**
+     * @brief Set the maximum number of concurrent transfers
+     * @param max_parallel Maximum transfers
+     */
+    void set_max_parallel(size_t max_parallel);
+
+    /**
+     * @brief Set the maximum number of concurrent transfers per mirror host
+     * @param max_per_mirror Maximum transfers per mirror
+     */
+    void set_max_per_mirror(size_t max_per_mirror);
+
+    /**
+     * @brief Set the callback for progress updates
+     * @param callback Progress callback
+     */
+    void set_progress_callback(DownloadProgressCallback callback);
+
+    /**
+     * @brief Register a group of interchangeable servers
+     *
+     * fetch() uses the group to find alternative mirrors for a URL that starts
+     * with one of the servers, e.g. all mirrors of one repository.
+     *
+     * @param servers Server base URLs, preferred first
+     */
+    void add_server_group(const std::vector<std::string>& servers);
+
+    /**
+     * @brief Remove all server groups
+     */
+    void clear_server_groups();
+
+    /**
+     * @brief Download files in parallel
+     * @param requests Files to download
+     * @return bool True if every file was downloaded
+     */
+    bool download(const std::vector<DownloadRequest>& requests);
+
+    /**
+     * @brief Download a single file, trying other mirrors of its server group
+     * @param url File URL
+     * @param local_dir Directory to store the file in
+     * @param force Download even if a current copy exists
+     * @return int 0 on success, 1 if the local copy is up to date, -1 on error
+     */
+    int fetch(const std::string& url, const std::string& local_dir, bool force);
+
+    /**
+     * @brief ALPM fetch callback forwarding to fetch()
+     * @param ctx The DownloadScheduler
+     * @param url File URL
+     * @param localpath Directory to store the file in
+     * @param force Download even if a current copy exists
+     * @return int 0 on success, 1 if up to date, -1 on error
+     */
+    static int fetch_callback(void* ctx, const char* url, const char* localpath, int force);
+
+    /**
+     * @brief Abort running and future downloads until reset_cancel()
+     *
+     * Partial files are kept so a later run resumes them. Safe to call from
+     * any thread.
+     */
+    void cancel();
+
+    /**
+     * @brief Allow downloads again after cancel()
+     */
+    void reset_cancel();
+
+    /**
+     * @brief Get the files that failed in the last run
+     * @return const std::vector<std::string>& File names
+     */
+    const std::vector<std::string>& get_failed() const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    struct Transfer;
+
+    bool run(std::vector<DownloadRequest> requests, bool conditional);
+    bool start_transfer(Transfer& transfer, std::vector<size_t>& mirror_load);
+    void report(const std::vector<Transfer>& transfers, const Transfer& current, double elapsed) const;
+    std::vector<std::string> alternatives(const std::string& url) const;
+
+    void* m_multi;                                   ///< CURLM handle
+    size_t m_max_parallel;                           ///< Maximum concurrent transfers
+    size_t m_max_per_mirror;                         ///< Maximum concurrent transfers per host
+    DownloadProgressCallback m_progress_callback;    ///< Progress callback
+    std::vector<std::vector<std::string>> m_server_groups; ///< Interchangeable servers
+    std::vector<std::string> m_failed;               ///< Files that failed in the last run
+    bool m_up_to_date;                               ///< Last conditional fetch found nothing newer
+    std::atomic<bool> m_cancelled;                   ///< cancel() was called
+    std::string m_last_error;                        ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <atomic>
+#include "core/appstream_index.hpp"
+#include "core/flatpak_deploy_scanner.hpp"
+#include "core/flatpak_package.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Appstream data flatpak has downloaded for one remote
+ */
+struct AppstreamSource {
+    std::string installation;   ///< Installation name, "system" or "user"
+    std::string remote;         ///< Remote name
+    std::string arch;           ///< Architecture the data is for
+    std::string file;           ///< appstream.xml.gz, or appstream.xml
+    std::string checksum;       ///< Commit the active link points to, or the file's size and mtime
+};
+
+/**
+ * @brief Searchable catalog of every configured remote's applications
+ *
+ * flatpak keeps the appstream data of each remote under
+ * <installation>/appstream/<remote>/<arch>/active. Each one is turned into
+ * an AppstreamIndex in the cache directory, which is rebuilt only when the
+ * data's checksum changes, so searches are answered from memory-mapped
+ * indexes instead of running flatpak search. The data is read again only
+ * after invalidate(), not on every search.
+ *
+ * refresh() and search() may be called from several threads.
+ */
+class FlatpakAppstreamCatalog {
+public:
+    /**
+     * @brief Constructor, reads the system and user installations
+     */
+    FlatpakAppstreamCatalog();
+
+    /**
+     * @brief Constructor
+     * @param installations Installations whose remotes are read
+     * @param cache_dir Directory the indexes are written to
+     * @param arch Architecture to read the data of
+     */
+    FlatpakAppstreamCatalog(std::vector<FlatpakInstallation> installations, std::string cache_dir, std::string arch);
+
+    /**
+     * @brief Get the index directory for the current user
+     * @return std::string $XDG_CACHE_HOME/pacmangui/appstream, or the same under ~/.cache
+     */
+    static std::string default_cache_dir();
+
+    /**
+     * @brief Get the flatpak name of the machine architecture
+     * @return std::string e.g. x86_64, aarch64, i386 or arm
+     */
+    static std::string default_arch();
+
+    /**
+     * @brief Find the appstream data of every remote and compute its checksum
+     * @return std::vector<AppstreamSource> Sources, by installation then remote name
+     */
+    std::vector<AppstreamSource> find_sources() const;
+
+    /**
+     * @brief Bring the indexes in line with the appstream data on disk
+     *
+     * Unchanged sources keep their open index, others reuse the index file
+     * when its checksum matches and are parsed again otherwise. Sources that
+     * fail are logged and left out.
+     *
+     * @return bool True if at least one index is open
+     */
+    bool refresh();
+
+    /**
+     * @brief Refresh only if nothing was read yet or invalidate() was called
+     *
+     * Searches call this, so they do no filesystem work while the data is
+     * known to be current.
+     *
+     * @return bool True if at least one index is open
+     */
+    bool refresh_if_stale();
+
+    /**
+     * @brief Make the next refresh_if_stale() read the data again
+     *
+     * Called after remotes are added and after transactions, which may
+     * bring new appstream data.
+     */
+    void invalidate();
+
+    /**
+     * @brief Check whether no index is open
+     * @return bool True if there is nothing to search
+     */
+    bool empty() const;
+
+    /**
+     * @brief Search all remotes
+     *
+     * Matches are ranked by FuzzyMatcher across remotes; an application
+     * offered by the same remote of several installations is listed once.
+     *
+     * @param query Search text
+     * @param limit Maximum number of results, 0 for no limit
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<FlatpakPackage> Matches, best first, with the remote as repository
+     */
+    std::vector<FlatpakPackage> search(const std::string& query, size_t limit,
+                                       const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief An open index and the data it was built from
+     */
+    struct LoadedIndex {
+        AppstreamSource source;
+        std::shared_ptr<const AppstreamIndex> index;
+    };
+
+    /**
+     * @brief Open the index of a source, building it if missing or stale
+     * @param source Source to index
+     * @param error Receives the reason on failure
+     * @return std::shared_ptr<const AppstreamIndex> The index, or nullptr
+     */
+    std::shared_ptr<const AppstreamIndex> load_index(const AppstreamSource& source, std::string& error) const;
+
+    std::vector<FlatpakInstallation> m_installations;  ///< Installations whose remotes are read
+    std::string m_cache_dir;                           ///< Directory of the index files
+    std::string m_arch;                                ///< Architecture to read
+    std::mutex m_refresh_mutex;                        ///< Serializes refresh()
+    std::set<std::string> m_failed;                    ///< File and checksum of data that failed to index
+    std::atomic<bool> m_stale;                         ///< The data on disk may have changed since refresh()
+    mutable std::mutex m_mutex;                        ///< Guards m_indexes and m_last_error
+    std::vector<LoadedIndex> m_indexes;                ///< Open indexes, in source order
+    std::string m_last_error;                          ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
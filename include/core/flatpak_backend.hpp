@@ -0,0 +1,128 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/flatpak_package.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Source of Flatpak installation and remote data
+ *
+ * FlatpakManager asks a backend first and falls back to another one when a
+ * call fails, so an implementation may leave out what it cannot do cheaply by
+ * returning false with an error.
+ */
+class FlatpakBackend {
+public:
+    /**
+     * @brief Destructor
+     */
+    virtual ~FlatpakBackend() = default;
+
+    /**
+     * @brief Get the backend name, for log messages
+     * @return std::string The name
+     */
+    virtual std::string get_name() const = 0;
+
+    /**
+     * @brief Check whether the backend can be used on this system
+     * @return bool True if usable
+     */
+    virtual bool is_available() const = 0;
+
+    /**
+     * @brief List installed applications and runtimes
+     * @param packages Receives the installed refs
+     * @return bool True on success
+     */
+    virtual bool list_installed(std::vector<FlatpakPackage>& packages) const = 0;
+
+    /**
+     * @brief Search the configured remotes
+     * @param query Search text
+     * @param packages Receives the matches, unranked
+     * @return bool True on success
+     */
+    virtual bool search(const std::string& query, std::vector<FlatpakPackage>& packages) const = 0;
+
+    /**
+     * @brief Check whether an application is installed
+     * @param app_id Application ID
+     * @param installed Receives the answer
+     * @return bool True if the answer could be determined
+     */
+    virtual bool is_installed(const std::string& app_id, bool& installed) const = 0;
+
+    /**
+     * @brief List the enabled remotes of all installations
+     * @param remotes Receives the remote names
+     * @return bool True on success
+     */
+    virtual bool list_remotes(std::vector<std::string>& remotes) const = 0;
+
+    /**
+     * @brief List installed refs that have updates
+     * @param app_ids Receives the IDs
+     * @return bool True on success
+     */
+    virtual bool list_updates(std::vector<std::string>& app_ids) const = 0;
+
+    /**
+     * @brief Fill in the display name, summary, origin, version, branch, size and runtime of an installed application
+     * @param package Package whose app ID is looked up
+     * @return bool True if the application was found
+     */
+    virtual bool get_app_info(FlatpakPackage& package) const = 0;
+
+    /**
+     * @brief Get the error of the last failed call
+     * @return std::string The error message
+     */
+    std::string get_last_error() const;
+
+protected:
+    /**
+     * @brief Set the error message
+     * @param error The error message
+     */
+    void set_last_error(const std::string& error) const;
+
+private:
+    mutable std::mutex m_error_mutex;   ///< Guards m_last_error
+    mutable std::string m_last_error;   ///< Last error message
+};
+
+/**
+ * @brief Backend that runs the flatpak command and parses its output
+ */
+class ProcessFlatpakBackend : public FlatpakBackend {
+public:
+    std::string get_name() const override;
+    bool is_available() const override;
+    bool list_installed(std::vector<FlatpakPackage>& packages) const override;
+    bool search(const std::string& query, std::vector<FlatpakPackage>& packages) const override;
+    bool is_installed(const std::string& app_id, bool& installed) const override;
+    bool list_remotes(std::vector<std::string>& remotes) const override;
+    bool list_updates(std::vector<std::string>& app_ids) const override;
+    bool get_app_info(FlatpakPackage& package) const override;
+};
+
+/**
+ * @brief Create the in-process backend built on libflatpak
+ *
+ * Reads installations, installed refs, their appdata and the remotes through
+ * libflatpak, without starting a process. Searching remotes is left to the
+ * fallback.
+ *
+ * @return std::unique_ptr<FlatpakBackend> The backend, or null if built without
+ *         libflatpak or no installation could be opened
+ */
+std::unique_ptr<FlatpakBackend> create_libflatpak_backend();
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief A deployed Flatpak application, as described by its metadata file
+ */
+struct FlatpakDeployment {
+    std::string app_id;         ///< Application ID
+    std::string arch;           ///< Architecture, e.g. x86_64
+    std::string branch;         ///< Branch, e.g. stable
+    std::string installation;   ///< Installation name, "system" or "user"
+    std::string runtime;        ///< Runtime ref, e.g. org.kde.Platform/x86_64/6.7
+    std::string sdk;            ///< SDK ref, if any
+    std::string command;        ///< Command run by flatpak run
+};
+
+/**
+ * @brief A Flatpak installation directory
+ */
+struct FlatpakInstallation {
+    std::string path;   ///< Installation root, e.g. /var/lib/flatpak
+    std::string name;   ///< Name flatpak list reports for it
+};
+
+/**
+ * @brief Reads the metadata of installed Flatpak applications from disk
+ *
+ * Every deployed application has a keyfile at
+ * <installation>/app/<id>/<arch>/<branch>/active/metadata naming its
+ * runtime. Reading those files directly gives the metadata of all
+ * applications in one pass, instead of one flatpak info process per
+ * application.
+ */
+class FlatpakDeployScanner {
+public:
+    /**
+     * @brief Constructor, scans the system and user installations
+     */
+    FlatpakDeployScanner();
+
+    /**
+     * @brief Constructor
+     * @param installations Installations to scan
+     */
+    explicit FlatpakDeployScanner(std::vector<FlatpakInstallation> installations);
+
+    /**
+     * @brief Get the installations flatpak itself uses
+     *
+     * Honours FLATPAK_SYSTEM_DIR, FLATPAK_USER_DIR and XDG_DATA_HOME the way
+     * flatpak does.
+     *
+     * @return std::vector<FlatpakInstallation> System installation, then the user one
+     */
+    static std::vector<FlatpakInstallation> default_installations();
+
+    /**
+     * @brief Get the installations this scanner reads
+     * @return const std::vector<FlatpakInstallation>& The installations
+     */
+    const std::vector<FlatpakInstallation>& get_installations() const;
+
+    /**
+     * @brief Read the metadata of every deployed application
+     *
+     * Missing installation directories are skipped, as are deployments
+     * without a readable metadata file.
+     *
+     * @return std::vector<FlatpakDeployment> Deployments, ordered by installation, ID, arch and branch
+     */
+    std::vector<FlatpakDeployment> scan() const;
+
+    /**
+     * @brief Parse a metadata keyfile
+     * @param text Contents of the metadata file
+     * @param deployment Receives the runtime, SDK and command of the [Application] group
+     * @return bool True if the file has an [Application] group
+     */
+    static bool parse_metadata(const std::string& text, FlatpakDeployment& deployment);
+
+private:
+    std::vector<FlatpakInstallation> m_installations;   ///< Installations to scan
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -4,13 +4,22 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <mutex>
 #include "core/flatpak_package.hpp"
+#include "core/flatpak_transaction.hpp"
+#include "core/flatpak_backend.hpp"
+#include "core/flatpak_appstream_catalog.hpp"
 
 namespace pacmangui {
 namespace core {
 
 /**
  * @brief Class for managing Flatpak packages
+ *
+ * Queries go to an in-process libflatpak backend when one is available, and
+ * to the flatpak command when it is not or when the backend cannot answer.
+ * Searches are answered from the local appstream indexes of the remotes
+ * while there are any.
  */
 class FlatpakManager {
 public:
@@ -19,6 +28,15 @@ public:
      */
     FlatpakManager();
     
+    /**
+     * @brief Constructor with given backends, initialize() then keeps them
+     * @param backend Backend asked first
+     * @param fallback Backend asked when the first one fails (may be null)
+     * @param appstream Catalog searched before the backends (may be null)
+     */
+    FlatpakManager(std::unique_ptr<FlatpakBackend> backend, std::unique_ptr<FlatpakBackend> fallback,
+                   std::unique_ptr<FlatpakAppstreamCatalog> appstream = nullptr);
+    
     /**
      * @brief Destructor
      */
@@ -44,6 +62,10 @@ public:
     
     /**
      * @brief Search for Flatpak packages by name
+     *
+     * Uses the appstream catalog, brought up to date first, and only runs a
+     * backend search when no remote has appstream data on disk.
+     *
      * @param name Package name to search for
      * @return std::vector<std::shared_ptr<FlatpakPackage>> List of matching Flatpak packages
      */
@@ -77,6 +99,37 @@ public:
      */
     bool update_all();
     
+    /**
+     * @brief Install Flatpak packages in one transaction
+     * @param app_ids Flatpak application IDs to install
+     * @param remote Flatpak remote they are installed from
+     * @param callback Receives the progress of each ref while flatpak runs (may be null)
+     * @return bool True if the transaction succeeded
+     */
+    bool install_packages(const std::vector<std::string>& app_ids, const std::string& remote = "flathub",
+                          FlatpakProgressCallback callback = nullptr);
+    
+    /**
+     * @brief Remove Flatpak packages in one transaction
+     * @param app_ids Flatpak application IDs to remove
+     * @param callback Receives the progress of each ref while flatpak runs (may be null)
+     * @return bool True if the transaction succeeded
+     */
+    bool remove_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback = nullptr);
+    
+    /**
+     * @brief Update Flatpak packages in one transaction
+     * @param app_ids Flatpak application IDs to update, empty for all
+     * @param callback Receives the progress of each ref while flatpak runs (may be null)
+     * @return bool True if the transaction succeeded
+     */
+    bool update_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback = nullptr);
+    
+    /**
+     * @brief Stop the running transactions, from any thread
+     */
+    void cancel_transactions();
+    
     /**
      * @brief Check if a Flatpak package is installed
      * @param app_id Flatpak application ID to check
@@ -115,30 +168,49 @@ public:
      * @return std::vector<std::string> List of available remotes
      */
     std::vector<std::string> list_remotes() const;
+    
+    /**
+     * @brief Fill in the display name, summary, origin, version, branch, size and runtime of an installed application
+     * @param package Package whose app ID is looked up
+     * @return bool True if the application was found
+     */
+    bool get_app_info(FlatpakPackage& package) const;
+    
+    /**
+     * @brief Get the name of the backend asked first
+     * @return std::string The backend name, empty before initialize()
+     */
+    std::string get_backend_name() const;
 
 private:
     /**
-     * @brief Execute a Flatpak command and parse the JSON output
-     * @param args Command arguments
-     * @return std::string Command output (JSON)
+     * @brief Run a query on the backend, then on the fallback if that fails
+     * @param call The query
+     * @return bool True if one of the backends answered
      */
-    std::string execute_flatpak_command(const std::vector<std::string>& args) const;
+    bool call_backend(const std::function<bool(const FlatpakBackend&)>& call) const;
     
     /**
-     * @brief Parse JSON output from Flatpak command into FlatpakPackage objects
-     * @param json_output JSON output from Flatpak command
-     * @return std::vector<FlatpakPackage> List of Flatpak packages
+     * @brief Run a transaction where cancel_transactions() can reach it
+     * @param transaction The transaction
+     * @return bool True if it succeeded
      */
-    std::vector<FlatpakPackage> parse_json_output(const std::string& json_output) const;
+    bool run_transaction(FlatpakTransaction& transaction);
     
     /**
-     * @brief Get the application name and description for a Flatpak package
-     * @param package The Flatpak package to update with name and description
+     * @brief Set the last error message
+     * @param error The error message
      */
-    void getAppNameAndDescription(FlatpakPackage& package) const;
+    void set_last_error(const std::string& error) const;
     
     bool m_is_available;              ///< Flag indicating if Flatpak is available
+    mutable std::mutex m_error_mutex; ///< Guards m_last_error, queries run on several workers
     mutable std::string m_last_error; ///< Last error message
+    std::unique_ptr<FlatpakBackend> m_backend;   ///< Backend asked first
+    std::unique_ptr<FlatpakBackend> m_fallback;  ///< flatpak command, when m_backend is in-process
+    std::unique_ptr<FlatpakAppstreamCatalog> m_appstream;  ///< Local index of the remotes' applications
+    std::mutex m_transaction_mutex;                        ///< Guards m_running_transactions
+    std::vector<FlatpakTransaction*> m_running_transactions; ///< Transactions reached by cancel_transactions()
 };
 
 } // namespace core
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "core/process_runner.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief What a Flatpak transaction does with its refs
+ */
+enum class FlatpakOperation {
+    INSTALL,   ///< flatpak install
+    REMOVE,    ///< flatpak uninstall
+    UPDATE     ///< flatpak update
+};
+
+/**
+ * @brief Where a ref is in its transaction
+ */
+enum class FlatpakRefState {
+    QUEUED,    ///< Waiting for its turn
+    RUNNING,   ///< Being downloaded, deployed or removed
+    DONE,      ///< Finished
+    FAILED     ///< Finished with an error
+};
+
+/**
+ * @brief Progress of one ref of a transaction
+ */
+struct FlatpakRefProgress {
+    std::string ref;                                ///< Requested app ID, or the ref of a dependency flatpak added
+    FlatpakRefState state = FlatpakRefState::QUEUED; ///< Current state
+    int percent = 0;                                ///< Progress of the running step, 0 to 100
+    std::string message;                            ///< Last line flatpak printed about the ref
+    bool requested = true;                          ///< False for refs flatpak pulled in itself
+};
+
+/**
+ * @brief Callback receiving every change of a ref's progress
+ */
+using FlatpakProgressCallback = std::function<void(const FlatpakRefProgress& progress)>;
+
+/**
+ * @brief One flatpak install, uninstall or update over a set of refs
+ *
+ * All refs go to a single flatpak command, so flatpak resolves their
+ * runtimes once and runs them as one transaction. The command's output is
+ * read line by line as it arrives and turned into per-ref progress, with
+ * refs pulled in as dependencies reported as well. run() blocks the calling
+ * thread; cancel() may be called from any other.
+ */
+class FlatpakTransaction {
+public:
+    /**
+     * @brief Constructor
+     * @param operation What to do
+     * @param refs App IDs or full refs, may be empty to update everything
+     * @param remote Remote to install from, ignored for other operations
+     */
+    FlatpakTransaction(FlatpakOperation operation, std::vector<std::string> refs, std::string remote = "");
+
+    /**
+     * @brief Set the callback receiving progress
+     * @param callback Called on the thread running run() (may be null)
+     */
+    void set_progress_callback(FlatpakProgressCallback callback);
+
+    /**
+     * @brief Get the flatpak command the transaction runs
+     * @return std::vector<std::string> Program and arguments
+     */
+    std::vector<std::string> get_command() const;
+
+    /**
+     * @brief Run the transaction until it finishes or is cancelled
+     * @return bool True if flatpak succeeded
+     */
+    bool run();
+
+    /**
+     * @brief Stop the running flatpak command
+     */
+    void cancel();
+
+    /**
+     * @brief Update the progress from one line of flatpak output
+     *
+     * flatpak redraws its progress with carriage returns, each part is read
+     * as a line of its own.
+     *
+     * @param line Output line without its newline
+     */
+    void parse_line(const std::string& line);
+
+    /**
+     * @brief Settle the refs still queued or running once flatpak exits
+     * @param success Whether flatpak succeeded
+     */
+    void finish(bool success);
+
+    /**
+     * @brief Get the progress of every ref seen so far
+     * @return const std::vector<FlatpakRefProgress>& Requested refs first, then dependencies in order
+     */
+    const std::vector<FlatpakRefProgress>& get_progress() const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief Find the entry for a ref named in the output, adding one if new
+     * @param ref Ref as printed by flatpak, e.g. app/org.gnome.Calculator/x86_64/stable
+     * @return size_t Index into m_progress
+     */
+    size_t find_ref(const std::string& ref);
+
+    void parse_part(const std::string& part);
+    void report(size_t index);
+
+    FlatpakOperation m_operation;              ///< What to do
+    std::vector<std::string> m_refs;           ///< Requested refs
+    std::string m_remote;                      ///< Remote to install from
+    FlatpakProgressCallback m_callback;        ///< Progress callback
+    std::vector<FlatpakRefProgress> m_progress; ///< Progress per ref
+    size_t m_current;                          ///< Entry flatpak is working on, or m_progress.size()
+    ProcessRunner m_runner;                    ///< Runs flatpak
+    std::string m_last_error;                  ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
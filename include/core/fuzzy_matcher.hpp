@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief How a candidate matched a fuzzy query, best first
+ */
+enum class FuzzyMatchKind {
+    EXACT,        ///< Name equals the query
+    PREFIX,       ///< Name starts with the query
+    WORD,         ///< A word of the name starts with the query
+    SUBSTRING,    ///< Name contains the query
+    TYPO,         ///< Name contains the query with a few edits
+    DESCRIPTION   ///< Only the description contains the query
+};
+
+/**
+ * @brief A scored candidate
+ */
+struct FuzzyMatch {
+    size_t index = 0;                              ///< Candidate number
+    int score = 0;                                 ///< Relevance, higher is better
+    FuzzyMatchKind kind = FuzzyMatchKind::EXACT;   ///< Best way the candidate matched
+    int distance = 0;                              ///< Edits needed to find the query in the name
+    size_t name_length = 0;                        ///< Shorter names win ties
+};
+
+/**
+ * @brief Ranked, typo-tolerant matcher for package and application names
+ *
+ * A name matches if some part of it is within get_max_distance() edits
+ * (insertions, deletions, substitutions) of the query, ignoring case. The
+ * edit distance is computed with Myers' bit-parallel algorithm, which handles
+ * one character of the name per step for queries of up to kMaxQuery
+ * characters, without allocating. Exact, prefix and word-start matches rank
+ * above plain substring matches, which rank above matches with typos;
+ * descriptions that contain the query add a bonus or match on their own.
+ *
+ * Matching does not change the matcher, so one can be shared by threads.
+ */
+class FuzzyMatcher {
+public:
+    static constexpr size_t kMaxQuery = 64;   ///< Longer queries only match without typos
+
+    /**
+     * @brief Returns the name and description of a candidate
+     */
+    using Candidate = std::function<std::pair<std::string_view, std::string_view>(size_t index)>;
+
+    /**
+     * @brief Constructor
+     * @param query Search text
+     * @param max_distance Edits allowed, -1 to pick by query length (none below 4 characters, 2 from 8)
+     */
+    explicit FuzzyMatcher(std::string_view query, int max_distance = -1);
+
+    /**
+     * @brief Get the lowercase query
+     * @return const std::string& The query
+     */
+    const std::string& get_query() const;
+
+    /**
+     * @brief Get the number of edits allowed
+     * @return int The maximum distance
+     */
+    int get_max_distance() const;
+
+    /**
+     * @brief Only match names that need edits to contain the query
+     *
+     * For results shown next to those of an exact substring search.
+     *
+     * @param typos_only Whether exact matches are skipped
+     */
+    void set_typos_only(bool typos_only);
+
+    /**
+     * @brief Get the smallest number of edits that turn a part of text into the query
+     * @param text Text to search, any case
+     * @return int The distance, or get_max_distance() + 1 if it is larger
+     */
+    int distance(std::string_view text) const;
+
+    /**
+     * @brief Score one candidate
+     * @param name Candidate name
+     * @param description Candidate description, may be empty
+     * @param result Receives score, kind, distance and name length; the index is left alone
+     * @return bool True if the candidate matches
+     */
+    bool match(std::string_view name, std::string_view description, FuzzyMatch& result) const;
+
+    /**
+     * @brief Score candidates and keep the best ones
+     *
+     * Only the best limit matches are kept while scanning, in a heap, so
+     * large candidate sets do not produce large results.
+     *
+     * @param count Number of candidates
+     * @param candidate Returns candidate i
+     * @param limit Maximum number of matches, 0 for no limit
+     * @param cancelled Stops the scan early once set, the result is then empty (may be null)
+     * @return std::vector<FuzzyMatch> Matches, best first
+     */
+    std::vector<FuzzyMatch> rank(size_t count, const Candidate& candidate, size_t limit,
+                                 const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Check whether one match ranks before another
+     * @param a First match
+     * @param b Second match
+     * @return bool True if a is better
+     */
+    static bool better(const FuzzyMatch& a, const FuzzyMatch& b);
+
+private:
+    std::string m_query;                  ///< Lowercase query
+    int m_max_distance;                   ///< Edits allowed
+    bool m_typos_only;                    ///< Skip names that contain the query
+    uint64_t m_last_bit;                  ///< Bit of the last query character
+    std::vector<uint64_t> m_peq;          ///< Positions of each byte in the query, both cases
+};
+
+} // namespace core
+} // namespace pacmangui
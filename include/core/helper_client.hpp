@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <sys/types.h>
+#include "core/helper_protocol.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Callback receiving each message the helper sends for a request
+ */
+using HelperMessageCallback = std::function<void(const HelperMessage&)>;
+
+/**
+ * @brief Connection to the pacmangui-helper daemon
+ *
+ * The daemon runs as root and keeps its ALPM handle loaded between requests,
+ * so only starting it needs authentication. It serves a single connection
+ * from the process that started it and exits when that connection closes,
+ * so a lost connection means starting it again. Requests are sent one at a time
+ * as binary frames; cancel() may be called from another thread while a
+ * request is running.
+ */
+class HelperClient {
+public:
+    /**
+     * @brief Constructor
+     * @param socket_path Path of the daemon's Unix socket
+     * @param trusted_uid User the daemon has to run as
+     */
+    explicit HelperClient(const std::string& socket_path = default_socket_path(), uid_t trusted_uid = 0);
+
+    /**
+     * @brief Destructor, closes the connection but leaves the daemon running
+     */
+    ~HelperClient();
+
+    HelperClient(const HelperClient&) = delete;
+    HelperClient& operator=(const HelperClient&) = delete;
+
+    /**
+     * @brief Get the socket path for the current process
+     * @return std::string $XDG_RUNTIME_DIR/pacmangui-helper-<pid>.sock, or a per-user path in /tmp
+     */
+    static std::string default_socket_path();
+
+    /**
+     * @brief Get the socket path
+     * @return const std::string& The socket path
+     */
+    const std::string& get_socket_path() const;
+
+    /**
+     * @brief Connect to a running daemon
+     * @return bool True if connected
+     */
+    bool connect();
+
+    /**
+     * @brief Check if a connection is open
+     * @return bool True if connected
+     */
+    bool is_connected() const;
+
+    /**
+     * @brief Send a request and wait until the daemon has finished it
+     * @param request The request
+     * @param on_message Receives every message including the final DONE (may be null)
+     * @return bool True if the daemon reported success
+     */
+    bool request(const HelperRequest& request, HelperMessageCallback on_message);
+
+    /**
+     * @brief Ask the daemon to interrupt the running request
+     * @return bool True if the cancel request was sent
+     */
+    bool cancel();
+
+    /**
+     * @brief Stop the daemon and close the connection
+     */
+    void shutdown();
+
+    /**
+     * @brief Close the connection
+     */
+    void disconnect();
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    std::string m_socket_path;   ///< Daemon socket
+    uid_t m_trusted_uid;         ///< Required owner of the daemon process
+    std::atomic<int> m_fd;       ///< Connected socket, -1 if none
+    std::mutex m_request_mutex;  ///< Serializes requests
+    std::mutex m_write_mutex;    ///< Serializes writes and closing the socket
+    std::string m_last_error;    ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
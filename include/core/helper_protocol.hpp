@@ -0,0 +1,149 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/download_scheduler.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Kind of message written by pacmangui-helper
+ */
+enum class HelperMessageType {
+    EVENT,     ///< Human-readable transaction event
+    PROGRESS,  ///< Per-package progress
+    DOWNLOAD,  ///< Per-file and aggregate download progress
+    ADD,       ///< Package in the resolved add set
+    REMOVE,    ///< Package in the resolved remove set
+    ERROR,     ///< Error message
+    DONE       ///< Final status
+};
+
+/**
+ * @brief A single line of helper output
+ *
+ * Each message is one line starting with '@' and a type tag, followed by
+ * tab-separated fields. Text fields have tabs, newlines and backslashes escaped,
+ * so output from sudo or ALPM's log callback can be told apart and skipped.
+ */
+struct HelperMessage {
+    HelperMessageType type = HelperMessageType::EVENT;  ///< Message type
+    std::string text;       ///< Event or error text, package name for ADD/REMOVE
+    std::string operation;  ///< Progress operation
+    std::string target;     ///< Progress target, package version for ADD/REMOVE
+    int percent = 0;        ///< Progress percentage
+    size_t current = 0;     ///< Progress position
+    size_t total = 0;       ///< Progress count
+    DownloadProgress download; ///< Progress carried by DOWNLOAD
+    bool success = false;   ///< Result carried by DONE
+};
+
+/**
+ * @brief Operation requested from the pacmangui-helper daemon
+ */
+enum class HelperOperation : uint8_t {
+    INSTALL = 1,        ///< Install packages from the sync databases
+    REMOVE,             ///< Remove packages
+    UPDATE,             ///< Install or upgrade packages
+    SYSUPGRADE,         ///< Upgrade the whole system
+    REFRESH,            ///< Refresh the sync databases
+    CLEAN_CACHE,        ///< Remove cached package files
+    REMOVE_ORPHANS,     ///< Remove packages nothing depends on
+    CHECK_DATABASE,     ///< Check the databases for consistency
+    CANCEL,             ///< Interrupt the running operation
+    SHUTDOWN,           ///< Stop the daemon
+    INSTALL_FILES       ///< Install package files, e.g. packages built from the AUR
+};
+
+/**
+ * @brief Option flags of a helper request
+ */
+enum HelperRequestFlags : uint8_t {
+    HELPER_FLAG_OVERWRITE = 1 << 0,   ///< Overwrite conflicting files
+    HELPER_FLAG_REFRESH = 1 << 1,     ///< Refresh the sync databases first
+    HELPER_FLAG_CLEAN_ALL = 1 << 2,   ///< Remove every cached package, not just unused ones
+    HELPER_FLAG_CHECK_SYNC = 1 << 3,  ///< Check the sync databases as well
+    HELPER_FLAG_RECURSIVE = 1 << 4    ///< Remove unneeded dependencies of the targets as well
+};
+
+/**
+ * @brief A request sent to the pacmangui-helper daemon
+ */
+struct HelperRequest {
+    HelperOperation operation = HelperOperation::INSTALL;  ///< Requested operation
+    uint8_t flags = 0;                                     ///< HelperRequestFlags
+    std::vector<std::string> targets;                      ///< Package names, or absolute paths for INSTALL_FILES
+    std::vector<std::string> dependencies;                 ///< Targets installed as dependencies
+};
+
+/**
+ * @brief Largest frame accepted from the socket
+ */
+constexpr uint32_t kMaxHelperFrameSize = 1 << 20;
+
+/**
+ * @brief Serialize a message to a protocol line, including the trailing newline
+ * @param message The message
+ * @return std::string The protocol line
+ */
+std::string format_helper_message(const HelperMessage& message);
+
+/**
+ * @brief Parse a protocol line
+ * @param line Line without its trailing newline
+ * @param message Receives the parsed message
+ * @return bool True if the line was a protocol message
+ */
+bool parse_helper_message(const std::string& line, HelperMessage& message);
+
+/**
+ * @brief Encode a request as a length-prefixed binary frame for the daemon socket
+ * @param request The request
+ * @return std::string The frame
+ */
+std::string encode_helper_request(const HelperRequest& request);
+
+/**
+ * @brief Decode the payload of a request frame
+ * @param payload Frame payload without the length prefix
+ * @param request Receives the request
+ * @return bool True if the payload was a valid request
+ */
+bool decode_helper_request(const std::string& payload, HelperRequest& request);
+
+/**
+ * @brief Encode a message as a length-prefixed binary frame for the daemon socket
+ * @param message The message
+ * @return std::string The frame
+ */
+std::string encode_helper_message(const HelperMessage& message);
+
+/**
+ * @brief Decode the payload of a message frame
+ * @param payload Frame payload without the length prefix
+ * @param message Receives the message
+ * @return bool True if the payload was a valid message
+ */
+bool decode_helper_message(const std::string& payload, HelperMessage& message);
+
+/**
+ * @brief Read one frame from a socket, blocking until it is complete
+ * @param fd The socket
+ * @param payload Receives the frame payload
+ * @return bool False on end of file, error or an oversized frame
+ */
+bool read_helper_frame(int fd, std::string& payload);
+
+/**
+ * @brief Write an encoded frame to a socket
+ * @param fd The socket
+ * @param frame Frame from encode_helper_request() or encode_helper_message()
+ * @return bool True if the whole frame was written
+ */
+bool write_helper_frame(int fd, const std::string& frame);
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Receives the events of a JsonParser
+ *
+ * Views passed to the callbacks are only valid during the call.
+ */
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual void begin_object() {}
+    virtual void end_object() {}
+    virtual void begin_array() {}
+    virtual void end_array() {}
+
+    /**
+     * @brief An object member name; the member's value follows
+     * @param name Decoded name
+     */
+    virtual void key(std::string_view name) { (void)name; }
+
+    virtual void string_value(std::string_view value) { (void)value; }
+
+    /**
+     * @brief A number
+     * @param value Parsed value
+     * @param text Number as written, for callers that need exact integers
+     */
+    virtual void number_value(double value, std::string_view text) { (void)value; (void)text; }
+
+    virtual void bool_value(bool value) { (void)value; }
+    virtual void null_value() {}
+};
+
+/**
+ * @brief Incremental JSON parser
+ *
+ * Input can be fed in chunks of any size as it arrives from the network;
+ * only an incomplete token at the end of a chunk is kept back. Events are
+ * reported to the handler as soon as a token is complete, so nothing but the
+ * handler's own state is built up.
+ */
+class JsonParser {
+public:
+    static constexpr size_t kMaxDepth = 256; ///< Deepest allowed nesting
+
+    /**
+     * @brief Constructor
+     * @param handler Receives the events
+     */
+    explicit JsonParser(JsonHandler& handler);
+
+    /**
+     * @brief Parse the next chunk of input
+     * @param data Chunk data
+     * @param size Chunk size
+     * @return bool False on a syntax error, see get_last_error()
+     */
+    bool feed(const char* data, size_t size);
+
+    /**
+     * @brief Signal the end of the input
+     * @return bool True if exactly one complete value was read
+     */
+    bool finish();
+
+    /**
+     * @brief Start over with a new document
+     */
+    void reset();
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    enum class Expect {
+        VALUE,         ///< Any value
+        FIRST_VALUE,   ///< A value or ']' right after '['
+        FIRST_KEY,     ///< A member name or '}' right after '{'
+        KEY,           ///< A member name after ','
+        COLON,         ///< ':' after a member name
+        AFTER_VALUE,   ///< ',' or the closing bracket
+        END            ///< Only whitespace after the top-level value
+    };
+
+    /**
+     * @brief Parse as many complete tokens from m_buffer as possible
+     * @param at_end No more input follows, so numbers end at the buffer end
+     * @return bool False on a syntax error
+     */
+    bool parse(bool at_end);
+
+    /**
+     * @brief Decode the string token starting at m_buffer[pos]
+     * @param pos Position of the opening quote, moved past the closing quote
+     * @param complete Set to false if the token continues in the next chunk
+     * @return bool False on a syntax error
+     */
+    bool read_string(size_t& pos, bool& complete);
+
+    /**
+     * @brief Update the state after a complete value
+     */
+    void value_done();
+
+    bool fail(const std::string& message);
+
+    JsonHandler& m_handler;
+    std::string m_buffer;           ///< Unparsed input, starting with an incomplete token
+    std::string m_text;             ///< Decoded string token
+    std::vector<char> m_stack;      ///< Open containers, '{' or '['
+    Expect m_expect;                ///< What the grammar allows next
+    size_t m_offset;                ///< Input offset of m_buffer[0], for error messages
+    bool m_failed;                  ///< A syntax error was found
+    std::string m_last_error;       ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+#include "core/package.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Append-only pool of interned strings
+ *
+ * Every distinct string is stored once in a single contiguous buffer and is
+ * addressed by a 32-bit id. Views handed out by get() remain valid until the
+ * next call to intern().
+ */
+class StringPool {
+public:
+    static constexpr uint32_t npos = UINT32_MAX; ///< Returned by find() when a string is not pooled
+
+    /**
+     * @brief Default constructor
+     */
+    StringPool();
+
+    /**
+     * @brief Reserve room for a number of strings
+     * @param strings Expected number of distinct strings
+     * @param bytes Expected total size of all strings
+     */
+    void reserve(size_t strings, size_t bytes);
+
+    /**
+     * @brief Add a string to the pool, reusing an existing copy if present
+     * @param value String to intern
+     * @return uint32_t Id of the pooled string
+     */
+    uint32_t intern(std::string_view value);
+
+    /**
+     * @brief Look up a string without adding it
+     * @param value String to look up
+     * @return uint32_t Id of the pooled string or npos
+     */
+    uint32_t find(std::string_view value) const;
+
+    /**
+     * @brief Get a pooled string
+     * @param id String id returned by intern()
+     * @return std::string_view View into the pool
+     */
+    std::string_view get(uint32_t id) const;
+
+    /**
+     * @brief Get the number of distinct strings
+     * @return size_t Number of strings
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the number of bytes used by string data
+     * @return size_t Size of the string buffer
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief Append the pool to a snapshot buffer
+     * @param out Buffer receiving the string offsets and data
+     */
+    void save(std::string& out) const;
+
+    /**
+     * @brief Replace the pool with one written by save()
+     *
+     * Hashes are not stored, they are computed again so a snapshot stays
+     * usable across standard library versions.
+     *
+     * @param cursor Read position, advanced past the pool
+     * @param end End of the buffer
+     * @return bool False if the data is truncated or inconsistent
+     */
+    bool restore(const char*& cursor, const char* end);
+
+private:
+    void grow_table();
+    size_t slot_for(std::string_view value, size_t hash) const;
+
+    std::string m_data;               ///< Concatenated string data
+    std::vector<uint32_t> m_offsets;  ///< Start offset of each string, plus a trailing end offset
+    std::vector<size_t> m_hashes;     ///< Cached hash of each string
+    std::vector<uint32_t> m_table;    ///< Open addressing table of id + 1 (0 marks a free slot)
+};
+
+/**
+ * @brief Non-owning view of a package stored in a catalog
+ *
+ * The views point into the owning RepositoryCatalog and are only valid while
+ * the catalog is alive.
+ */
+struct PackageView {
+    std::string_view name;         ///< Package name
+    std::string_view version;      ///< Package version
+    std::string_view description;  ///< Package description
+    std::string_view repository;   ///< Repository name
+    bool installed = false;        ///< True if the package comes from the local database
+
+    /**
+     * @brief Copy the viewed data into an owning Package
+     * @return Package The materialized package
+     */
+    Package to_package() const;
+};
+
+/**
+ * @brief Column-oriented package storage for a single database
+ *
+ * Names, versions and descriptions are kept as parallel arrays of ids into a
+ * shared string pool instead of one heap object per package.
+ */
+class RepositoryCatalog {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1); ///< Returned by find() when a package is missing
+
+    /**
+     * @brief Constructor
+     * @param name Repository name
+     * @param local True if this catalog describes the local (installed) database
+     */
+    RepositoryCatalog(const std::string& name, bool local);
+
+    /**
+     * @brief Reserve room for a number of packages
+     * @param count Expected number of packages
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Append a package to the catalog
+     * @param name Package name
+     * @param version Package version
+     * @param description Package description
+     */
+    void add(std::string_view name, std::string_view version, std::string_view description);
+
+    /**
+     * @brief Get the repository name
+     * @return const std::string& Repository name
+     */
+    const std::string& get_name() const;
+
+    /**
+     * @brief Check if this is the local database
+     * @return bool True for the local database
+     */
+    bool is_local() const;
+
+    /**
+     * @brief Get the number of packages
+     * @return size_t Number of packages
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get a view of a package
+     * @param index Package index
+     * @return PackageView View of the package
+     */
+    PackageView at(size_t index) const;
+
+    /**
+     * @brief Get the name of a package
+     * @param index Package index
+     * @return std::string_view Package name
+     */
+    std::string_view name_at(size_t index) const;
+
+    /**
+     * @brief Find a package by exact name
+     * @param name Package name
+     * @return size_t Package index or npos
+     */
+    size_t find(std::string_view name) const;
+
+    /**
+     * @brief Get a hash over all package names and versions
+     *
+     * Two catalogs of the same database with equal fingerprints hold the same
+     * packages, which lets a reload keep the catalog it already has.
+     *
+     * @return uint64_t Content fingerprint
+     */
+    uint64_t get_fingerprint() const;
+
+    /**
+     * @brief Append the catalog to a snapshot buffer
+     * @param out Buffer receiving the name, columns and string pool
+     */
+    void save(std::string& out) const;
+
+    /**
+     * @brief Read a catalog written by save()
+     *
+     * The columns are copied out of the buffer in bulk, so the buffer can be
+     * unmapped afterwards.
+     *
+     * @param cursor Read position, advanced past the catalog
+     * @param end End of the buffer
+     * @return std::shared_ptr<const RepositoryCatalog> The catalog, or nullptr if the data is malformed
+     */
+    static std::shared_ptr<const RepositoryCatalog> restore(const char*& cursor, const char* end);
+
+private:
+    /**
+     * @brief Fold a package into the fingerprint
+     * @param name Package name
+     * @param version Package version
+     */
+    void add_to_fingerprint(std::string_view name, std::string_view version);
+
+    std::string m_name;                     ///< Repository name
+    bool m_local;                           ///< Whether this is the local database
+    uint64_t m_fingerprint;                 ///< Hash over names and versions in insertion order
+    StringPool m_strings;                   ///< Interned strings for all columns
+    std::vector<uint32_t> m_names;          ///< Name column
+    std::vector<uint32_t> m_versions;       ///< Version column
+    std::vector<uint32_t> m_descriptions;   ///< Description column
+    std::vector<uint32_t> m_name_index;     ///< String id of a name to package index
+};
+
+/**
+ * @brief Immutable snapshot of all package databases for one generation
+ *
+ * A new catalog is built whenever the databases are (re)loaded. Readers hold a
+ * shared pointer to the catalog they started with, so a refresh never
+ * invalidates views that are still in use.
+ */
+class PackageCatalog {
+public:
+    using RepositoryPtr = std::shared_ptr<const RepositoryCatalog>;
+
+    /**
+     * @brief Constructor
+     * @param generation Database generation this catalog was built from
+     * @param local Local database catalog (may be null)
+     * @param sync Sync database catalogs in configuration order
+     */
+    PackageCatalog(uint64_t generation, RepositoryPtr local, std::vector<RepositoryPtr> sync);
+
+    /**
+     * @brief Get the database generation
+     * @return uint64_t Generation counter
+     */
+    uint64_t get_generation() const;
+
+    /**
+     * @brief Get the local database catalog
+     * @return const RepositoryCatalog* Local catalog or nullptr
+     */
+    const RepositoryCatalog* get_local() const;
+
+    /**
+     * @brief Get shared ownership of the local database catalog
+     * @return const RepositoryPtr& Local catalog, may be null
+     */
+    const RepositoryPtr& get_local_ptr() const;
+
+    /**
+     * @brief Get the sync database catalogs
+     * @return const std::vector<RepositoryPtr>& Sync catalogs in configuration order
+     */
+    const std::vector<RepositoryPtr>& get_sync() const;
+
+    /**
+     * @brief Get the total number of packages in all databases
+     * @return size_t Number of packages
+     */
+    size_t size() const;
+
+    /**
+     * @brief Find a package, preferring the installed version
+     * @param name Package name
+     * @return std::optional<PackageView> The package if found
+     */
+    std::optional<PackageView> find(std::string_view name) const;
+
+    /**
+     * @brief Check if a package is installed
+     * @param name Package name
+     * @return bool True if the package is in the local database
+     */
+    bool is_installed(std::string_view name) const;
+
+    /**
+     * @brief Visit every package, local database first
+     * @param fn Callable taking a const PackageView&
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        if (m_local) {
+            for (size_t i = 0; i < m_local->size(); ++i) {
+                fn(m_local->at(i));
+            }
+        }
+        for (const auto& repo : m_sync) {
+            for (size_t i = 0; i < repo->size(); ++i) {
+                fn(repo->at(i));
+            }
+        }
+    }
+
+private:
+    uint64_t m_generation;            ///< Database generation
+    RepositoryPtr m_local;            ///< Local database
+    std::vector<RepositoryPtr> m_sync; ///< Sync databases
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -3,17 +3,38 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include <alpm.h>
 #include "core/package.hpp"
 #include "core/repository.hpp"
+#include "core/package_catalog.hpp"
+#include "core/search_index.hpp"
+#include "core/search_pipeline.hpp"
 #include "core/transaction.hpp"
+#include "core/process_runner.hpp"
+#include "core/helper_client.hpp"
+#include "core/aur_client.hpp"
+#include "core/aur_index.hpp"
+#include "core/aur_builder.hpp"
 #include "core/flatpak_manager.hpp"
 #include "core/flatpak_package.hpp"
 #include <functional>
+#include <mutex>
 
 namespace pacmangui {
 namespace core {
 
+/**
+ * @brief An installed package with a newer version in a sync database
+ */
+struct PackageUpdate {
+    std::string name;             ///< Package name
+    std::string old_version;      ///< Installed version
+    std::string new_version;      ///< Version in the sync database
+    std::string repository;       ///< Repository providing the new version
+    uint64_t download_size = 0;   ///< Bytes to download, 0 if already cached
+};
+
 /**
  * @brief Main class for managing packages
  */
@@ -32,11 +53,38 @@ public:
     /**
      * @brief Initialize the package manager
      * 
+     * Registers the databases and loads them. With a callback the packages
+     * are loaded on a background thread and initialize() returns right after
+     * registration. If the snapshot matches the databases its catalog is
+     * available at once, otherwise the catalog is empty until the callback
+     * first runs.
+     * 
      * @param root_dir Root directory (e.g., "/")
      * @param db_path Database path (e.g., "/var/lib/pacman")
+     * @param on_loaded Load in the background and call this from the loader thread (may be null)
      * @return bool True if initialization successful
      */
-    bool initialize(const std::string& root_dir, const std::string& db_path);
+    bool initialize(const std::string& root_dir, const std::string& db_path,
+                    CatalogLoadedCallback on_loaded = nullptr);
+    
+    /**
+     * @brief Set the pacman configuration read by initialize()
+     * 
+     * @param config_path Path of pacman.conf (default /etc/pacman.conf)
+     */
+    void set_config_path(const std::string& config_path);
+    
+    /**
+     * @brief Set the catalog snapshot used to start without reading the databases
+     * 
+     * @param snapshot_path Snapshot file, empty to disable (default under ~/.cache)
+     */
+    void set_snapshot_path(const std::string& snapshot_path);
+    
+    /**
+     * @brief Block until a background load started by initialize() has finished
+     */
+    void wait_until_loaded() const;
     
     /**
      * @brief Get all installed packages
@@ -52,22 +100,130 @@ public:
      */
     std::vector<Package> get_available_packages() const;
     
+    /**
+     * @brief Get the package catalog for the current database generation
+     * 
+     * The catalog is immutable; callers can keep it and read package views
+     * without copying while the databases are refreshed in the meantime.
+     * 
+     * @return std::shared_ptr<const PackageCatalog> The catalog, or nullptr if not initialized
+     */
+    std::shared_ptr<const PackageCatalog> get_catalog() const;
+    
     /**
      * @brief Search for packages by name
      * 
+     * When name contains the previous query, as it does while a query is
+     * typed, only the previous matches are filtered instead of searching
+     * every package again.
+     * 
      * @param name Package name to search for
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
      * @return std::vector<Package> List of matching packages
      */
-    std::vector<Package> search_by_name(const std::string& name) const;
+    std::vector<Package> search_by_name(const std::string& name, const std::atomic<bool>* cancelled = nullptr) const;
+    
+    /**
+     * @brief Ranked search over package names and descriptions
+     * 
+     * Exact and prefix name matches rank first, followed by substring name
+     * matches and packages whose name or description contains every query word.
+     * 
+     * @param query Search query
+     * @param include_descriptions Whether to match description words
+     * @param limit Maximum number of results, 0 for no limit
+     * @return std::vector<Package> Matching packages, best first
+     */
+    std::vector<Package> search_packages(const std::string& query, bool include_descriptions = true, size_t limit = 0) const;
+    
+    /**
+     * @brief Typo-tolerant ranked search over package names and descriptions
+     * 
+     * Uses the same matcher as the Flatpak search, so "firefx" finds firefox.
+     * 
+     * @param query Search query
+     * @param limit Maximum number of results, 0 for no limit
+     * @return std::vector<Package> Matching packages, best first
+     */
+    std::vector<Package> search_fuzzy(const std::string& query, size_t limit = 50) const;
+    
+    /**
+     * @brief Get the search index for the current database generation
+     * 
+     * @return std::shared_ptr<const SearchIndex> The index, or nullptr if not initialized
+     */
+    std::shared_ptr<const SearchIndex> get_search_index() const;
     
     /**
      * @brief Search for packages in the AUR
      * 
+     * Uses the local AUR index when the "aur/local_index" setting is on and
+     * the index has been built, and the AUR RPC interface otherwise.
+     * 
      * @param name Package name to search for
      * @return std::vector<Package> List of matching AUR packages
      */
     std::vector<Package> search_aur(const std::string& name) const;
     
+    /**
+     * @brief Get the stages of a streaming search
+     * 
+     * One stage for the installed packages, one per sync database, one for
+     * database packages that only match with typos, one for the AUR if
+     * enabled in settings and, optionally, one for Flatpak. The
+     * stages search the databases as they are now, so a refresh in the
+     * meantime does not mix two generations. Like search_by_name(), a
+     * database stage only filters its previous matches when the query grew.
+     * 
+     * @param include_flatpak Whether to search Flatpak remotes as well
+     * @return std::vector<SearchStage> The stages, fastest first
+     */
+    std::vector<SearchStage> get_search_stages(bool include_flatpak) const;
+    
+    /**
+     * @brief Search every source at once and stream the results
+     * 
+     * Results arrive per source as soon as that source is done, instead of
+     * after the slowest one like with search_by_name(). Starting a search
+     * cancels the one before. The callbacks run on worker threads.
+     * 
+     * @param name Package name to search for
+     * @param include_flatpak Whether to search Flatpak remotes as well
+     * @param on_batch Receives the results in batches
+     * @param on_finished Called once when every source is done or the search was cancelled
+     * @return uint64_t Id of the search, passed along with its batches
+     */
+    uint64_t search_streaming(const std::string& name, bool include_flatpak,
+                              SearchPipeline::BatchCallback on_batch,
+                              SearchPipeline::FinishedCallback on_finished);
+    
+    /**
+     * @brief Cancel the running streaming search
+     * 
+     * @param wait Also wait for sources that are still busy, so no callback runs afterwards
+     */
+    void cancel_search(bool wait = false);
+    
+    /**
+     * @brief Get the timing of the latest completed streaming search
+     * 
+     * @return SearchStats Time to the first result and to the last source
+     */
+    SearchStats get_search_stats() const;
+    
+    /**
+     * @brief Bring the local AUR index up to date
+     * 
+     * Downloads the AUR metadata dump only if it changed since the index was
+     * built. Blocks for the download, so call it off the GUI thread; the
+     * error is returned instead of being stored as the last error, which
+     * other threads may be using.
+     * 
+     * @param error Receives the error message on failure
+     * @return bool True if the index is up to date
+     */
+    bool refresh_aur_index(std::string& error);
+    
     /**
      * @brief Get detailed information for a package
      * 
@@ -155,13 +311,33 @@ public:
     /**
      * @brief Install a package from AUR with authentication
      * 
+     * Builds the package with install_aur_packages() if the aur/native_build
+     * setting is on, otherwise runs the AUR helper.
+     * 
      * @param package_name Name of the AUR package to install
      * @param password The password to use for sudo authentication
-     * @param aur_helper AUR helper to use (yay, paru, etc.)
+     * @param aur_helper AUR helper to use (yay, paru, etc.) when not building natively
+     * @param output_callback Receives the build and transaction output of a native build (may be null)
      * @return bool True if installation successful
      */
     bool install_aur_package(const std::string& package_name, const std::string& password, 
-                            const std::string& aur_helper = "yay");
+                            const std::string& aur_helper = "yay",
+                            std::function<void(const std::string&)> output_callback = nullptr);
+    
+    /**
+     * @brief Build AUR packages with makepkg and install them
+     * 
+     * Resolves the AUR dependencies of the packages, builds independent
+     * package bases in parallel up to the aur/build_jobs setting and installs
+     * the results through the helper, see AurBuilder. No AUR helper is needed.
+     * 
+     * @param package_names Names of the AUR packages to install
+     * @param password The password to use for sudo authentication
+     * @param output_callback Receives build and transaction output, build lines prefixed with the package base
+     * @return bool True if every package was built and installed
+     */
+    bool install_aur_packages(const std::vector<std::string>& package_names, const std::string& password,
+                              std::function<void(const std::string&)> output_callback = nullptr);
     
     /**
      * @brief Check if a package is installed
@@ -207,17 +383,43 @@ public:
     /**
      * @brief Check for available system updates (without installing)
      * 
-     * @return std::vector<std::pair<std::string, std::string>> List of packages with updates (name, new_version)
+     * Compares the local database with the sync databases of the open handle,
+     * reloading databases that changed on disk since they were read.
+     * 
+     * @return std::vector<PackageUpdate> Packages with a newer version, in local database order
      */
-    std::vector<std::pair<std::string, std::string>> check_updates() const;
+    std::vector<PackageUpdate> check_updates();
     
     /**
      * @brief Check for available AUR updates (without installing)
      * 
-     * @param aur_helper The AUR helper to use (e.g., "yay", "paru")
-     * @return std::vector<std::pair<std::string, std::string>> List of AUR packages with updates (name, new_version)
+     * Looks up every foreign package (installed but in no sync database) on
+     * the AUR, many packages per request, and compares the versions with
+     * alpm_pkg_vercmp. No AUR helper is needed.
+     * 
+     * @return std::vector<PackageUpdate> Foreign packages with a newer AUR version, in local database order
      */
-    std::vector<std::pair<std::string, std::string>> check_aur_updates(const std::string& aur_helper = "") const;
+    std::vector<PackageUpdate> check_aur_updates();
+    
+    /**
+     * @brief Check the given foreign packages for AUR updates
+     * 
+     * Only talks to the AUR, so it may run on a worker thread while the
+     * caller keeps using the ALPM handle.
+     * 
+     * @param foreign Packages as returned by get_foreign_packages()
+     * @return std::vector<PackageUpdate> Packages with a newer AUR version, in the given order
+     */
+    std::vector<PackageUpdate> check_aur_updates(const std::vector<std::pair<std::string, std::string>>& foreign) const;
+    
+    /**
+     * @brief Get the installed packages that are in no sync database
+     * 
+     * Reloads the databases first if they changed on disk since they were read.
+     * 
+     * @return std::vector<std::pair<std::string, std::string>> Name and installed version, in local database order
+     */
+    std::vector<std::pair<std::string, std::string>> get_foreign_packages();
     
     /**
      * @brief Update all AUR packages
@@ -239,23 +441,6 @@ public:
                            const std::string& aur_helper = "",
                            std::function<void(const std::string&)> output_callback = nullptr);
     
-    /**
-     * @brief Execute a command with sudo authentication
-     * 
-     * @param command The command to execute
-     * @param password The password to use for sudo authentication
-     * @return bool True if command executed successfully
-     */
-    bool execute_with_sudo(const std::string& command, const std::string& password);
-    
-    /**
-     * @brief Execute a command with sudo (no password)
-     * 
-     * @param command The command to execute
-     * @return bool True if command executed successfully
-     */
-    bool execute_with_sudo(const std::string& command);
-    
     /**
      * @brief Clear the package cache (pacman -Sc)
      * 
@@ -277,6 +462,20 @@ public:
     bool remove_orphaned_packages(const std::string& password,
                                 std::function<void(const std::string&)> output_callback = nullptr);
     
+    /**
+     * @brief Cancel the commands this package manager is running
+     * 
+     * Safe to call from any thread. The cancelled operations return false.
+     */
+    void cancel_running_operations();
+    
+    /**
+     * @brief Cancel the running Flatpak transactions only
+     * 
+     * Safe to call from any thread. The cancelled transactions return false.
+     */
+    void cancel_flatpak_transactions();
+    
     /**
      * @brief Get a list of orphaned packages (not required by any other package)
      * 
@@ -329,6 +528,14 @@ public:
      */
     std::vector<FlatpakPackage> get_installed_flatpak_packages() const;
     
+    /**
+     * @brief Get the details of one installed Flatpak application
+     * 
+     * @param package Package whose app ID is looked up, receives the details
+     * @return bool True if the application is installed
+     */
+    bool get_flatpak_app_info(FlatpakPackage& package) const;
+    
     /**
      * @brief Search for Flatpak packages by name
      * 
@@ -369,6 +576,35 @@ public:
      */
     bool update_all_flatpak_packages();
     
+    /**
+     * @brief Install Flatpak packages in one flatpak transaction
+     * 
+     * @param app_ids Application IDs of the Flatpak packages to install
+     * @param remote Remote name (e.g., "flathub")
+     * @param callback Receives per-ref progress on the calling thread (may be null)
+     * @return bool True if installation successful
+     */
+    bool install_flatpak_packages(const std::vector<std::string>& app_ids, const std::string& remote,
+                                  FlatpakProgressCallback callback = nullptr);
+    
+    /**
+     * @brief Remove Flatpak packages in one flatpak transaction
+     * 
+     * @param app_ids Application IDs of the Flatpak packages to remove
+     * @param callback Receives per-ref progress on the calling thread (may be null)
+     * @return bool True if removal successful
+     */
+    bool remove_flatpak_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback = nullptr);
+    
+    /**
+     * @brief Update Flatpak packages in one flatpak transaction
+     * 
+     * @param app_ids Application IDs of the Flatpak packages to update, empty for all
+     * @param callback Receives per-ref progress on the calling thread (may be null)
+     * @return bool True if update successful
+     */
+    bool update_flatpak_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback = nullptr);
+    
     /**
      * @brief Check if Flatpak is available on the system
      * 
@@ -388,6 +624,20 @@ private:
     RepositoryManager* m_repo_manager;                ///< Repository manager
     TransactionManager* m_trans_manager;              ///< Transaction manager
     std::string m_last_error;                         ///< Last error message
+    std::string m_config_path;                        ///< pacman.conf to register the databases from
+    std::string m_snapshot_path;                      ///< Catalog snapshot file, empty if disabled
+    int64_t m_sync_stamp;                             ///< Modification time of the sync directory when it was read
+    int64_t m_local_stamp;                            ///< Modification time of the local directory when it was read
+    mutable std::recursive_mutex m_handle_mutex;      ///< Held while m_handle is used or replaced
+    std::mutex m_process_mutex;                       ///< Guards m_running_processes
+    std::vector<ProcessRunner*> m_running_processes;  ///< Processes reached by cancel_running_operations()
+    std::unique_ptr<HelperClient> m_helper;           ///< Connection to the privileged helper daemon
+    std::mutex m_helper_mutex;                        ///< Serializes starting the helper
+    std::unique_ptr<AurClient> m_aur_client;          ///< AUR RPC client keeping its connection open
+    std::unique_ptr<AurIndex> m_aur_index;            ///< Local AUR metadata for offline search
+    AurBuilder* m_aur_builder;                        ///< Running AUR build, guarded by m_process_mutex
+    std::unique_ptr<IncrementalSearch> m_name_search; ///< Narrows name searches while a query is typed
+    std::unique_ptr<SearchPipeline> m_search_pipeline; ///< Runs streaming searches
     
     /**
      * @brief Set the last error message
@@ -403,6 +653,79 @@ private:
      */
     bool register_sync_databases();
     
+    /**
+     * @brief Re-register the sync databases if they changed on disk
+     * 
+     * ALPM keeps database contents in memory, so a refresh by the helper or
+     * pacman is only seen after the databases are registered again.
+     * 
+     * @return bool True if the databases are current
+     */
+    bool reload_changed_sync_databases();
+    
+    /**
+     * @brief Open a new alpm handle if the local database changed on disk
+     * 
+     * ALPM reads the local database once per handle and has no way to drop
+     * it, so packages installed or removed by the helper or pacman are only
+     * seen through a new handle. The catalog is reloaded from it.
+     * Callers that keep using m_handle afterwards hold m_handle_mutex.
+     * 
+     * @return bool True if the local database is current
+     */
+    bool reload_changed_local_database();
+    
+    /**
+     * @brief Reload the local and sync databases that changed on disk
+     * 
+     * @return bool True if the databases are current
+     */
+    bool reload_changed_databases();
+    
+    /**
+     * @brief Connect to the privileged helper daemon, starting it if needed
+     * 
+     * The daemon is started once through pkexec, or sudo when a password is
+     * given, and serves later requests of this process until it disconnects.
+     * 
+     * @param password Password for sudo, empty to authenticate through pkexec
+     * @return bool True if connected
+     */
+    bool ensure_helper(const std::string& password);
+    
+    /**
+     * @brief Run an operation in the privileged helper daemon
+     * 
+     * @param request Operation, flags and targets
+     * @param password Password for sudo if the daemon has to be started
+     * @param output_callback Receives events as lines of text (may be null)
+     * @return bool True if the helper reported success
+     */
+    bool run_helper_request(const HelperRequest& request, const std::string& password,
+                            std::function<void(const std::string&)> output_callback = nullptr);
+    
+    /**
+     * @brief Run a command, streaming its output, until it exits or is cancelled
+     * 
+     * @param command Program and arguments, passed without a shell
+     * @param input Data written to the command's stdin (may be empty)
+     * @param callback Receives each output line
+     * @return ProcessStatus How the command ended
+     */
+    ProcessStatus run_process(const std::vector<std::string>& command, const std::string& input,
+                              ProcessOutputCallback callback);
+    
+    /**
+     * @brief Run a command as root through sudo, streaming its output
+     * 
+     * @param command Program and arguments, passed without a shell
+     * @param password Password for sudo, empty to let sudo ask on its own
+     * @param output_callback Receives each output line with its newline (may be null)
+     * @return bool True if the command exited with status 0
+     */
+    bool run_privileged(const std::vector<std::string>& command, const std::string& password,
+                        std::function<void(const std::string&)> output_callback);
+    
     // Flatpak manager
     FlatpakManager m_flatpak_manager;
 };
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <alpm.h>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief A repository section of pacman.conf
+ */
+struct PacmanRepository {
+    std::string name;                  ///< Repository name
+    std::vector<std::string> servers;  ///< Mirror URLs with $repo and $arch expanded
+};
+
+/**
+ * @brief Parser for pacman.conf
+ *
+ * Reads the options and repository sections pacman itself uses to set up a
+ * handle, following Include directives such as the mirrorlist.
+ */
+class PacmanConfig {
+public:
+    /**
+     * @brief Default constructor, fills in pacman's built-in defaults
+     */
+    PacmanConfig();
+
+    /**
+     * @brief Load a configuration file
+     * @param path Path to pacman.conf
+     * @return bool True if the file was read
+     */
+    bool load(const std::string& path = "/etc/pacman.conf");
+
+    /**
+     * @brief Apply the configuration to an alpm handle
+     *
+     * Sets the cache, hook and GPG directories, the log file and architectures,
+     * and registers every repository together with its servers.
+     *
+     * @param handle The alpm handle
+     * @return bool True if every repository was registered
+     */
+    bool apply(alpm_handle_t* handle) const;
+
+    /**
+     * @brief Register every repository together with its servers
+     *
+     * Used by apply(), and on its own to replace the sync databases of a
+     * handle after alpm_unregister_all_syncdbs().
+     *
+     * @param handle The alpm handle
+     * @return bool True if every repository was registered
+     */
+    bool register_repositories(alpm_handle_t* handle) const;
+
+    /**
+     * @brief Get the repositories in configuration order
+     * @return const std::vector<PacmanRepository>& The repositories
+     */
+    const std::vector<PacmanRepository>& get_repositories() const;
+
+    /**
+     * @brief Get the package cache directories
+     * @return const std::vector<std::string>& Cache directories
+     */
+    const std::vector<std::string>& get_cache_dirs() const;
+
+    /**
+     * @brief Get the hook directories
+     * @return const std::vector<std::string>& Hook directories
+     */
+    const std::vector<std::string>& get_hook_dirs() const;
+
+    /**
+     * @brief Get the architectures packages may be installed for
+     * @return const std::vector<std::string>& Architectures
+     */
+    const std::vector<std::string>& get_architectures() const;
+
+    /**
+     * @brief Get the root directory
+     * @return const std::string& Root directory
+     */
+    const std::string& get_root_dir() const;
+
+    /**
+     * @brief Get the database path
+     * @return const std::string& Database path
+     */
+    const std::string& get_db_path() const;
+
+    /**
+     * @brief Get the GPG directory
+     * @return const std::string& GPG directory
+     */
+    const std::string& get_gpg_dir() const;
+
+    /**
+     * @brief Get the log file
+     * @return const std::string& Log file path
+     */
+    const std::string& get_log_file() const;
+
+    /**
+     * @brief Get the number of parallel downloads
+     * @return unsigned int Parallel downloads
+     */
+    unsigned int get_parallel_downloads() const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    bool parse_file(const std::string& path, std::string& section, int depth);
+    void set_option(const std::string& key, const std::string& value);
+    std::string expand_server(const std::string& url, const std::string& repo) const;
+
+    std::vector<PacmanRepository> m_repositories;  ///< Repository sections
+    std::vector<std::string> m_cache_dirs;         ///< CacheDir entries
+    std::vector<std::string> m_hook_dirs;          ///< HookDir entries
+    std::vector<std::string> m_architectures;      ///< Architecture entries, "auto" resolved
+    std::string m_root_dir;                        ///< RootDir
+    std::string m_db_path;                         ///< DBPath
+    std::string m_gpg_dir;                         ///< GPGDir
+    std::string m_log_file;                        ///< LogFile
+    unsigned int m_parallel_downloads;             ///< ParallelDownloads
+    bool m_cache_dirs_set;                         ///< Whether the file listed its own cache directories
+    std::string m_last_error;                      ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
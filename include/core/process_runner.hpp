@@ -0,0 +1,130 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <sys/types.h>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Output stream a line was read from
+ */
+enum class OutputStream {
+    STDOUT,  ///< Standard output
+    STDERR   ///< Standard error
+};
+
+/**
+ * @brief Callback receiving one line of process output, without its newline
+ */
+using ProcessOutputCallback = std::function<void(const std::string& line, OutputStream stream)>;
+
+/**
+ * @brief How a process ended
+ */
+struct ProcessStatus {
+    bool started = false;    ///< The process was spawned
+    bool exited = false;     ///< The process exited normally
+    int exit_code = -1;      ///< Exit code if the process exited
+    int signal = 0;          ///< Signal that terminated the process, 0 if none
+    bool cancelled = false;  ///< cancel() was called while it ran
+    bool abandoned = false;  ///< The process could not be stopped, e.g. a setuid one, and was left running
+
+    /**
+     * @brief Check if the process ran to completion with exit code 0
+     * @return bool True on success
+     */
+    bool success() const { return started && exited && exit_code == 0 && !cancelled; }
+
+    /**
+     * @brief Describe the status for error messages
+     * @return std::string e.g. "exited with status 1"
+     */
+    std::string describe() const;
+};
+
+/**
+ * @brief Runs a child process and streams its output line by line
+ *
+ * The process is started with posix_spawn, so no shell is involved and
+ * arguments are passed verbatim. stdout and stderr are read from pipes by an
+ * epoll loop on the calling thread as soon as data arrives. The child runs in
+ * its own process group, which cancel() signals from any thread.
+ */
+class ProcessRunner {
+public:
+    /**
+     * @brief Constructor
+     */
+    ProcessRunner();
+
+    /**
+     * @brief Destructor
+     */
+    ~ProcessRunner();
+
+    ProcessRunner(const ProcessRunner&) = delete;
+    ProcessRunner& operator=(const ProcessRunner&) = delete;
+
+    /**
+     * @brief Set data written to the child's stdin before it is closed
+     *
+     * Without input the child inherits stdin from this process.
+     *
+     * @param input Data for stdin, e.g. a password for sudo -S
+     */
+    void set_input(const std::string& input);
+
+    /**
+     * @brief Set the directory the child starts in
+     *
+     * Without one the child inherits the working directory of this process.
+     *
+     * @param directory Working directory, e.g. a PKGBUILD checkout for makepkg
+     */
+    void set_working_directory(const std::string& directory);
+
+    /**
+     * @brief Run a process until it exits or is cancelled
+     * @param args Program and arguments, the program is looked up in PATH
+     * @param callback Receives each output line (may be null)
+     * @return ProcessStatus How the process ended
+     */
+    ProcessStatus run(const std::vector<std::string>& args, ProcessOutputCallback callback);
+
+    /**
+     * @brief Ask the running process to stop
+     *
+     * Sends SIGTERM to the process group and SIGKILL if it is still running
+     * after a grace period. Safe to call from any thread. Called before the
+     * process is spawned, it makes the next run() return cancelled without
+     * starting anything.
+     */
+    void cancel();
+
+    /**
+     * @brief Check if a process is running
+     * @return bool True while run() is active
+     */
+    bool is_running() const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    std::string m_input;                 ///< Data for the child's stdin
+    std::string m_working_directory;     ///< Child's working directory, empty to inherit ours
+    std::atomic<pid_t> m_pid;            ///< Running child, 0 if none
+    std::atomic<bool> m_cancelled;       ///< cancel() was called
+    int m_wake_fd;                       ///< eventfd waking the epoll loop on cancel()
+    std::string m_last_error;            ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -4,7 +4,15 @@
 #include <vector>
 #include <memory>
 #include <alpm.h>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
 #include "core/package.hpp"
+#include "core/package_catalog.hpp"
+#include "core/search_index.hpp"
+#include "core/catalog_snapshot.hpp"
 
 namespace pacmangui {
 namespace core {
@@ -48,13 +56,6 @@ public:
      */
     bool is_sync() const;
     
-    /**
-     * @brief Get all packages in the repository
-     * 
-     * @return std::vector<Package> List of packages
-     */
-    std::vector<Package> get_packages() const;
-    
     /**
      * @brief Find a package by name
      * 
@@ -63,6 +64,46 @@ public:
      */
     Package find_package(const std::string& name) const;
     
+    /**
+     * @brief Strings of one package in the ALPM package cache
+     * 
+     * The pointers belong to ALPM and stay valid until the database is
+     * unregistered or its cache is reloaded.
+     */
+    struct CacheEntry {
+        const char* name;
+        const char* version;
+        const char* desc;
+    };
+    
+    /**
+     * @brief Fill the package cache and collect its strings
+     * 
+     * Goes through the ALPM handle, which is not thread-safe, so databases
+     * sharing a handle must be read one after another.
+     * 
+     * @return std::vector<CacheEntry> One entry per valid package
+     */
+    std::vector<CacheEntry> read_cache() const;
+    
+    /**
+     * @brief Copy entries read by read_cache() into a column-oriented catalog
+     * 
+     * Touches no ALPM state, so catalogs of different databases can be
+     * built concurrently.
+     * 
+     * @param entries Entries of this database
+     * @return std::shared_ptr<const RepositoryCatalog> Catalog of this database's packages
+     */
+    std::shared_ptr<const RepositoryCatalog> build_catalog(const std::vector<CacheEntry>& entries) const;
+    
+    /**
+     * @brief Load the package cache into a column-oriented catalog
+     * 
+     * @return std::shared_ptr<const RepositoryCatalog> Catalog of this database's packages
+     */
+    std::shared_ptr<const RepositoryCatalog> load_catalog() const;
+    
     /**
      * @brief Set the internal alpm database pointer
      * 
@@ -83,6 +124,14 @@ private:
     alpm_db_t* m_db;      ///< Pointer to the alpm database
 };
 
+/**
+ * @brief Callback told that a new catalog was published
+ *
+ * Receives false once the installed packages are available and true once
+ * the sync databases are loaded as well.
+ */
+using CatalogLoadedCallback = std::function<void(bool complete)>;
+
 /**
  * @brief Manager class for repositories
  */
@@ -107,19 +156,84 @@ public:
      */
     bool initialize();
     
+    /**
+     * @brief Load the databases on a background thread
+     * 
+     * The local catalog is published as soon as it is read, so the installed
+     * packages can be shown while the sync databases are still loading.
+     * Nothing else may use the alpm handle until wait_until_loaded() returns.
+     * 
+     * @param on_loaded Called on the loader thread after each published catalog (may be null)
+     * @return bool True if the loader was started
+     */
+    bool initialize_async(CatalogLoadedCallback on_loaded);
+    
+    /**
+     * @brief Set the snapshot file written after every load
+     * 
+     * @param path Snapshot file, empty to disable snapshots
+     */
+    void set_snapshot_path(const std::string& path);
+    
+    /**
+     * @brief Switch to another alpm handle
+     * 
+     * Waits for a background load first. The repositories keep pointing at
+     * the old handle's databases until initialize() runs again.
+     * 
+     * @param handle The new alpm handle
+     */
+    void set_handle(alpm_handle_t* handle);
+    
+    /**
+     * @brief Publish the catalog from the snapshot if the databases are unchanged
+     * 
+     * The next load still reads the databases; repositories whose packages
+     * match the snapshot keep its catalogs.
+     * 
+     * @return bool True if a snapshot was published
+     */
+    bool load_snapshot();
+    
+    /**
+     * @brief Block until a background load has finished
+     */
+    void wait_until_loaded() const;
+    
+    /**
+     * @brief Check if a background load is running
+     * 
+     * @return bool True while the loader thread owns the alpm handle
+     */
+    bool is_loading() const;
+    
     /**
      * @brief Get local database repository
      * 
-     * @return Repository The local database
+     * @return const Repository& The local database
      */
-    Repository get_local_db() const;
+    const Repository& get_local_db() const;
     
     /**
      * @brief Get all sync repositories
      * 
-     * @return std::vector<Repository> List of sync repositories
+     * @return const std::vector<Repository>& List of sync repositories
      */
-    std::vector<Repository> get_sync_dbs() const;
+    const std::vector<Repository>& get_sync_dbs() const;
+    
+    /**
+     * @brief Get the package catalog for the current database generation
+     * 
+     * @return std::shared_ptr<const PackageCatalog> The catalog, or nullptr before initialization
+     */
+    std::shared_ptr<const PackageCatalog> get_catalog() const;
+    
+    /**
+     * @brief Get the search index for the current database generation
+     * 
+     * @return std::shared_ptr<const SearchIndex> The index, or nullptr before initialization
+     */
+    std::shared_ptr<const SearchIndex> get_search_index() const;
     
     /**
      * @brief Find a package across all repositories
@@ -137,9 +251,38 @@ public:
     std::vector<Package> get_all_packages() const;
 
 private:
+    /**
+     * @brief Read the databases and publish their catalogs
+     * 
+     * @param on_loaded Also publish the local catalog on its own and report both steps (may be null)
+     * @return bool True if the local database could be read
+     */
+    bool load(const CatalogLoadedCallback& on_loaded);
+    
+    /**
+     * @brief Publish a catalog and its search index
+     * 
+     * @param catalog The new catalog
+     */
+    void publish(std::shared_ptr<const PackageCatalog> catalog);
+    
+
     alpm_handle_t* m_handle;            ///< The alpm handle
     Repository m_local_db;              ///< The local database
     std::vector<Repository> m_sync_dbs; ///< List of sync databases
+    
+    mutable std::mutex m_catalog_mutex;              ///< Guards m_catalog and m_search_index
+    std::shared_ptr<const PackageCatalog> m_catalog; ///< Catalog for the current generation
+    std::shared_ptr<const SearchIndex> m_search_index; ///< Search index for the current generation
+    uint64_t m_generation;                           ///< Number of times the databases were loaded
+    
+    std::string m_snapshot_path;                     ///< Snapshot file, empty if disabled
+    std::vector<DatabaseStamp> m_snapshot_stamps;    ///< Stamps stored in the snapshot file
+    
+    std::thread m_loader;                         ///< Background loader started by initialize_async()
+    std::atomic<bool> m_loading;                  ///< True while the loader runs
+    mutable std::mutex m_load_mutex;              ///< Guards waiting for m_loading
+    mutable std::condition_variable m_load_done;  ///< Signalled when the loader finishes
 };
 
 } // namespace core
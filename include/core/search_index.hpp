@@ -0,0 +1,330 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include "core/package_catalog.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief How a search hit matched the query
+ */
+enum class MatchKind {
+    Exact,       ///< Name equals the query
+    Prefix,      ///< Name starts with the query
+    Substring,   ///< Name contains the query
+    Fuzzy,       ///< Name contains the query with a few typos
+    Description  ///< Only the description or name words matched
+};
+
+/**
+ * @brief A single search result
+ */
+struct SearchHit {
+    PackageView package;  ///< Matched package, valid while the index is alive
+    MatchKind match;      ///< Best way the package matched
+    int score;            ///< Relevance, higher is better
+};
+
+/**
+ * @brief Options for ranked searches
+ */
+struct SearchOptions {
+    bool descriptions = true;  ///< Also match words in package descriptions
+    size_t limit = 0;          ///< Maximum number of hits, 0 for no limit
+    bool typos_only = false;   ///< Fuzzy search: only names that need edits to match the query
+    const std::atomic<bool>* cancelled = nullptr; ///< Stops the search early once set (may be null)
+};
+
+/**
+ * @brief Search structures for a single repository catalog
+ *
+ * Holds the lowercase names, a name-sorted permutation for prefix lookups,
+ * trigram postings for substring lookups and a word index over descriptions.
+ * Postings are stored as flat arrays addressed by offset tables.
+ */
+class SearchSegment {
+public:
+    /**
+     * @brief Build the segment for a repository
+     * @param repo Repository catalog to index
+     */
+    explicit SearchSegment(std::shared_ptr<const RepositoryCatalog> repo);
+
+    /**
+     * @brief Get the indexed repository
+     * @return const RepositoryCatalog& The repository catalog
+     */
+    const RepositoryCatalog& get_repository() const;
+
+    /**
+     * @brief Get the lowercase name of a package
+     * @param index Package index
+     * @return std::string_view Lowercase name
+     */
+    std::string_view lower_name(uint32_t index) const;
+
+    /**
+     * @brief Find packages whose name contains a string
+     * @param needle Lowercase string to look for
+     * @param out Receives matching package indices in ascending order
+     * @param cancelled Stops the scan early once set, leaving out incomplete (may be null)
+     */
+    void find_substring(std::string_view needle, std::vector<uint32_t>& out,
+                        const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Find packages whose name starts with a string
+     * @param prefix Lowercase prefix
+     * @param out Receives matching package indices in name order
+     */
+    void find_prefix(std::string_view prefix, std::vector<uint32_t>& out) const;
+
+    /**
+     * @brief Find packages with name or description words matching all terms
+     *
+     * A term matches a word it equals (weight 2) or is a prefix of (weight 1).
+     *
+     * @param terms Lowercase query terms
+     * @param out Receives (package index, summed weight) pairs in ascending index order
+     */
+    void find_words(const std::vector<std::string>& terms,
+                    std::vector<std::pair<uint32_t, int>>& out) const;
+
+private:
+    std::shared_ptr<const RepositoryCatalog> m_repo;  ///< Indexed repository
+
+    std::string m_lower_names;                 ///< Concatenated lowercase names
+    std::vector<uint32_t> m_name_offsets;      ///< Start offset of each name, plus an end offset
+    std::vector<uint32_t> m_sorted;            ///< Package indices ordered by lowercase name
+
+    std::vector<uint32_t> m_trigram_keys;      ///< Sorted distinct name trigrams
+    std::vector<uint32_t> m_trigram_offsets;   ///< Postings range of each trigram, plus an end offset
+    std::vector<uint32_t> m_trigram_postings;  ///< Package indices per trigram, ascending
+
+    std::string m_words;                       ///< Concatenated sorted vocabulary
+    std::vector<uint32_t> m_word_offsets;      ///< Start offset of each word, plus an end offset
+    std::vector<uint32_t> m_word_post_offsets; ///< Postings range of each word, plus an end offset
+    std::vector<uint32_t> m_word_postings;     ///< Package indices per word, ascending
+};
+
+/**
+ * @brief Search index over every database of a package catalog
+ *
+ * The index is immutable and built alongside the catalog generation it
+ * indexes. Segments are shared between generations, so rebuilding after one
+ * repository changed only indexes that repository again.
+ */
+class SearchIndex {
+public:
+    using SegmentPtr = std::shared_ptr<const SearchSegment>;
+
+    /**
+     * @brief Build an index
+     * @param catalog Catalog to index
+     * @param previous Index of an earlier generation whose unchanged segments are reused (may be null)
+     */
+    explicit SearchIndex(std::shared_ptr<const PackageCatalog> catalog, const SearchIndex* previous = nullptr);
+
+    /**
+     * @brief Get the indexed catalog
+     * @return std::shared_ptr<const PackageCatalog> The catalog
+     */
+    std::shared_ptr<const PackageCatalog> get_catalog() const;
+
+    /**
+     * @brief Get the number of segments taken over from the previous index
+     * @return size_t Number of reused segments
+     */
+    size_t get_reused_segments() const;
+
+    /**
+     * @brief Search package names for a substring
+     *
+     * Installed packages come first, followed by each sync database in
+     * configuration order. Within a database hits are ranked exact, prefix,
+     * substring, then by name. Sync packages that are installed are skipped.
+     *
+     * @param query Text to look for, case-insensitive
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<SearchHit> Matching packages
+     */
+    std::vector<SearchHit> search_names(std::string_view query, const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Search the package names of one database for a substring
+     *
+     * Ranked like search_names(), so the databases can be searched and shown
+     * one at a time with the same overall result.
+     *
+     * @param query Text to look for, case-insensitive
+     * @param segment Segment number, see get_segment()
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<SearchHit> Matching packages of that database
+     */
+    std::vector<SearchHit> search_names(std::string_view query, size_t segment,
+                                        const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Narrow the hits of an earlier name search to a query that contains its query
+     *
+     * Every name that contains query also contains the earlier query, so the
+     * earlier hits are the only candidates. The result equals
+     * search_names(query), or the single-segment variant the hits came from,
+     * at a cost of O(earlier hits) instead of a look at every package.
+     *
+     * @param query Text to look for, case-insensitive
+     * @param previous Hits of a name search on this index for a part of query
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<SearchHit> Matching packages
+     */
+    std::vector<SearchHit> refine_names(std::string_view query, const std::vector<SearchHit>& previous,
+                                        const std::atomic<bool>* cancelled = nullptr) const;
+
+    /**
+     * @brief Get the number of segments
+     * @return size_t One per database
+     */
+    size_t get_segment_count() const;
+
+    /**
+     * @brief Get a segment
+     * @param index Segment number, the local database first, then the sync databases in configuration order
+     * @return const SearchSegment& The segment
+     */
+    const SearchSegment& get_segment(size_t index) const;
+
+    /**
+     * @brief Search package names for a prefix
+     * @param prefix Prefix to look for, case-insensitive
+     * @return std::vector<SearchHit> Matching packages in name order, installed first
+     */
+    std::vector<SearchHit> search_prefix(std::string_view prefix) const;
+
+    /**
+     * @brief Ranked search over names and, optionally, descriptions
+     *
+     * Name matches rank above description matches. Every word of the query
+     * must occur in the name or description for a description match.
+     *
+     * @param query Search query, case-insensitive
+     * @param options Search options
+     * @return std::vector<SearchHit> Matching packages, best first
+     */
+    std::vector<SearchHit> search(std::string_view query, const SearchOptions& options = SearchOptions()) const;
+
+    /**
+     * @brief Typo-tolerant ranked search over names and, optionally, descriptions
+     *
+     * Scores every package with a FuzzyMatcher, so "firefx" still finds
+     * firefox. Only the best options.limit hits of each database are kept
+     * while scanning.
+     *
+     * @param query Search query, case-insensitive
+     * @param options Search options
+     * @return std::vector<SearchHit> Matching packages, best first
+     */
+    std::vector<SearchHit> search_fuzzy(std::string_view query, const SearchOptions& options = SearchOptions()) const;
+
+private:
+    using SegmentCollector = std::function<void(const SearchSegment& segment, bool skip_installed,
+                                                std::vector<SearchHit>& hits)>;
+
+    /**
+     * @brief Collect the name substring matches of one segment
+     * @param segment Segment to search
+     * @param skip_installed Whether installed packages are skipped
+     * @param needle Lowercase query
+     * @param hits Receives the ranked hits
+     * @param cancelled Stops the search early once set, leaving hits empty (may be null)
+     */
+    void find_names(const SearchSegment& segment, bool skip_installed, const std::string& needle,
+                    std::vector<SearchHit>& hits, const std::atomic<bool>* cancelled) const;
+
+    /**
+     * @brief Search every segment in parallel
+     * @param collect Appends the hits of one segment; told whether installed packages are skipped
+     * @param cancelled Skips the remaining segments once set, the result is then empty (may be null)
+     * @return std::vector<SearchHit> Hits of the local segment, then of each sync segment in order
+     */
+    std::vector<SearchHit> collect_segments(const SegmentCollector& collect, const std::atomic<bool>* cancelled) const;
+
+    std::shared_ptr<const PackageCatalog> m_catalog;  ///< Indexed catalog
+    SegmentPtr m_local;                               ///< Segment of the local database
+    std::vector<SegmentPtr> m_sync;                   ///< Segments of the sync databases
+    size_t m_reused;                                  ///< Segments reused from the previous index
+};
+
+/**
+ * @brief Name search that narrows its previous result while a query is typed
+ *
+ * Remembers the hits of the last query, per segment searched. When the next
+ * query contains the last one, as it does while characters are typed, only
+ * those hits are filtered. Deleting or editing characters, or a new index
+ * generation, falls back to a search of the index.
+ *
+ * Only a weak reference to the index is kept, so a refresh frees the old
+ * generation; hits of an index that is gone are never looked at.
+ */
+class IncrementalSearch {
+public:
+    static constexpr size_t kAllSegments = static_cast<size_t>(-1); ///< Key of searches over every segment
+
+    /**
+     * @brief Search package names for a substring, see SearchIndex::search_names()
+     * @param index Index to search
+     * @param query Text to look for, case-insensitive
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<SearchHit> Matching packages
+     */
+    std::vector<SearchHit> search_names(const std::shared_ptr<const SearchIndex>& index, std::string_view query,
+                                        const std::atomic<bool>* cancelled = nullptr);
+
+    /**
+     * @brief Search the package names of one database for a substring
+     * @param index Index to search
+     * @param query Text to look for, case-insensitive
+     * @param segment Segment number, or kAllSegments for every segment
+     * @param cancelled Stops the search early once set, the result is then empty (may be null)
+     * @return std::vector<SearchHit> Matching packages
+     */
+    std::vector<SearchHit> search_names(const std::shared_ptr<const SearchIndex>& index, std::string_view query,
+                                        size_t segment, const std::atomic<bool>* cancelled = nullptr);
+
+    /**
+     * @brief Forget the remembered hits
+     */
+    void clear();
+
+    /**
+     * @brief Get the number of searches answered by narrowing earlier hits
+     * @return size_t Number of narrowed searches
+     */
+    size_t get_narrowed_searches() const;
+
+private:
+    /**
+     * @brief Hits of the last query on one segment
+     */
+    struct Entry {
+        std::weak_ptr<const SearchIndex> index;              ///< Index the hits point into
+        std::string needle;                                  ///< Lowercase query
+        std::shared_ptr<const std::vector<SearchHit>> hits;  ///< Its hits
+    };
+
+    mutable std::mutex m_mutex;                  ///< Guards the members below
+    std::unordered_map<size_t, Entry> m_entries; ///< Last query per segment
+    size_t m_narrowed = 0;                       ///< Searches answered by narrowing
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include "core/package.hpp"
+#include "core/package_catalog.hpp"
+#include "core/flatpak_package.hpp"
+#include "core/thread_pool.hpp"
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Kind of source a search stage reads
+ */
+enum class SearchSource {
+    LOCAL,    ///< Installed packages
+    SYNC,     ///< One sync database
+    FUZZY,    ///< Database packages whose name matches with typos
+    AUR,      ///< The AUR
+    FLATPAK   ///< Flatpak remotes
+};
+
+/**
+ * @brief Packages found by one search stage
+ */
+struct SearchResults {
+    std::shared_ptr<const PackageCatalog> catalog; ///< Catalog the views point into
+    std::vector<PackageView> views;                ///< Database packages, valid while catalog is alive
+    std::vector<Package> packages;                 ///< Native packages not in a catalog, e.g. from the AUR
+    std::vector<FlatpakPackage> flatpak_packages;  ///< Flatpak applications
+};
+
+/**
+ * @brief One source of search results
+ */
+struct SearchStage {
+    SearchSource source = SearchSource::LOCAL; ///< Kind of source
+    std::string name;                          ///< Shown name, e.g. the database name
+    bool slow = false;                         ///< Waits on the network, kept off the shared pool
+
+    /**
+     * @brief Runs the search; may check the flag to give up early on a newer query
+     */
+    std::function<SearchResults(const std::string& query, const std::atomic<bool>& cancelled)> run;
+};
+
+/**
+ * @brief A chunk of results from one stage
+ */
+struct SearchBatch {
+    uint64_t query_id = 0;                         ///< Query the batch belongs to
+    SearchSource source = SearchSource::LOCAL;     ///< Kind of stage that found it
+    std::string stage;                             ///< Name of that stage
+    std::shared_ptr<const PackageCatalog> catalog; ///< Catalog the views point into, pinned by the batch
+    std::vector<PackageView> views;                ///< Database packages
+    std::vector<Package> packages;                 ///< Native packages not in a catalog
+    std::vector<FlatpakPackage> flatpak_packages;  ///< Flatpak applications
+};
+
+/**
+ * @brief Timing of a finished query
+ */
+struct SearchStats {
+    uint64_t query_id = 0;         ///< The query
+    std::string query;             ///< Search text
+    bool cancelled = false;        ///< A newer query or cancel() stopped it
+    size_t stages = 0;             ///< Number of stages
+    size_t results = 0;            ///< Packages delivered
+    double first_result_ms = -1;   ///< Time until the first batch was delivered, -1 if none was
+    double total_ms = 0;           ///< Time until the last stage finished
+};
+
+/**
+ * @brief Runs the stages of a search concurrently and streams their results
+ *
+ * Every stage of a query starts at once. Its results are delivered in
+ * batches of at most get_batch_size() packages as soon as the stage is done,
+ * catalog views first, then owned packages, then Flatpak applications,
+ * so fast sources like the local database show up without waiting for the
+ * AUR. Starting a query cancels the previous one: its stages are told
+ * through their flag, and results they still return are dropped.
+ *
+ * Callbacks run on worker threads. A batch can race with a newer start(),
+ * so receivers compare the query id with the one start() returned.
+ */
+class SearchPipeline {
+public:
+    static constexpr size_t kDefaultBatchSize = 100; ///< Packages per batch
+    static constexpr size_t kSlowWorkers = 4;        ///< Threads for network stages
+
+    using BatchCallback = std::function<void(const SearchBatch& batch)>;
+    using FinishedCallback = std::function<void(const SearchStats& stats)>;
+
+    /**
+     * @brief Constructor
+     * @param batch_size Maximum packages per batch, 0 for the default
+     */
+    explicit SearchPipeline(size_t batch_size = kDefaultBatchSize);
+
+    /**
+     * @brief Destructor, cancels the running query and waits for its stages
+     */
+    ~SearchPipeline();
+
+    SearchPipeline(const SearchPipeline&) = delete;
+    SearchPipeline& operator=(const SearchPipeline&) = delete;
+
+    /**
+     * @brief Get the maximum number of packages per batch
+     * @return size_t The batch size
+     */
+    size_t get_batch_size() const;
+
+    /**
+     * @brief Start a query, cancelling the one before
+     * @param query Search text
+     * @param stages Sources to search
+     * @param on_batch Receives the results (may be null)
+     * @param on_finished Called once after the last stage, also when cancelled (may be null)
+     * @return uint64_t Id of the query
+     */
+    uint64_t start(const std::string& query, std::vector<SearchStage> stages, BatchCallback on_batch,
+                   FinishedCallback on_finished);
+
+    /**
+     * @brief Cancel the running query
+     *
+     * Returns at once; stages that are stuck in a request finish in the
+     * background and their results are dropped.
+     */
+    void cancel();
+
+    /**
+     * @brief Wait until no stage of any query is running
+     */
+    void wait();
+
+    /**
+     * @brief Get the id of the latest query
+     * @return uint64_t The id, 0 before the first query
+     */
+    uint64_t get_current_query() const;
+
+    /**
+     * @brief Get the timing of the latest query that finished without being cancelled
+     * @return SearchStats The stats, query_id 0 if there was none
+     */
+    SearchStats get_last_stats() const;
+
+private:
+    struct Query;
+
+    /**
+     * @brief Run one stage of a query and deliver its results
+     * @param query The query
+     * @param stage The stage
+     */
+    void run_stage(const std::shared_ptr<Query>& query, const SearchStage& stage);
+
+    /**
+     * @brief Record that a stage finished, finishing the query after the last one
+     * @param query The query
+     */
+    void finish_stage(const std::shared_ptr<Query>& query);
+
+    size_t m_batch_size;              ///< Packages per batch
+    ThreadPool m_slow_pool;           ///< Runs the slow stages
+    mutable std::mutex m_mutex;       ///< Guards the members below
+    std::condition_variable m_idle;   ///< Signalled when the last running query finishes
+    std::shared_ptr<Query> m_current; ///< Latest query
+    uint64_t m_next_id;               ///< Id of the next query
+    size_t m_running;                 ///< Queries with stages still running
+    SearchStats m_last_stats;         ///< Latest completed query
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Handle of one scheduled search
+ *
+ * Copies share the cancellation flag, so a search task can hand the flag to
+ * the core search loops and have them give up once a newer query arrives.
+ */
+class SearchToken {
+public:
+    /**
+     * @brief Constructor for a token that is never cancelled
+     */
+    SearchToken();
+
+    /**
+     * @brief Get the generation of the search
+     * @return uint64_t The generation, increasing with every scheduled query
+     */
+    uint64_t get_generation() const;
+
+    /**
+     * @brief Get the search text
+     * @return const std::string& The query
+     */
+    const std::string& get_query() const;
+
+    /**
+     * @brief Check whether a newer query or cancel() superseded this one
+     * @return bool True if the search should stop
+     */
+    bool is_cancelled() const;
+
+    /**
+     * @brief Get the cancellation flag for the core search functions
+     * @return const std::atomic<bool>* The flag, valid while a copy of the token is alive
+     */
+    const std::atomic<bool>* get_flag() const;
+
+private:
+    friend class SearchScheduler;
+
+    uint64_t m_generation;                          ///< Generation of the query
+    std::string m_query;                            ///< Search text
+    std::shared_ptr<std::atomic<bool>> m_cancelled; ///< Set when superseded
+};
+
+/**
+ * @brief Debounces and orders the searches of a search box
+ *
+ * Every schedule() starts a new generation and cancels the one before, both
+ * while it is still waiting out its delay and while it runs. The delay adapts
+ * to how long recent searches took: fast searches run almost at once, slow
+ * ones wait until typing pauses so they are not started for every keystroke.
+ * Queries shorter than kShortQuery match most packages and wait the longest.
+ *
+ * Tasks run on the shared thread pool. Their duration is the duration of the
+ * search unless they only start asynchronous work; then the scheduler is told
+ * so and the real duration is passed to report_duration().
+ * Results delivered to another thread should be checked with is_current()
+ * before they are shown.
+ */
+class SearchScheduler {
+public:
+    static constexpr int kMinDelayMs = 30;       ///< Delay after fast searches
+    static constexpr int kMaxDelayMs = 300;      ///< Delay after slow searches and for short queries
+    static constexpr size_t kShortQuery = 3;     ///< Queries shorter than this get the longest delay
+
+    using Task = std::function<void(const SearchToken& token)>;
+
+    /**
+     * @brief Constructor
+     * @param time_tasks Whether tasks are timed, false if they return before their search is done
+     */
+    explicit SearchScheduler(bool time_tasks = true);
+
+    /**
+     * @brief Destructor, cancels the pending search and waits for running ones
+     */
+    ~SearchScheduler();
+
+    SearchScheduler(const SearchScheduler&) = delete;
+    SearchScheduler& operator=(const SearchScheduler&) = delete;
+
+    /**
+     * @brief Run a search once typing pauses
+     * @param query Search text
+     * @param task Runs the search unless a newer query arrives during the delay
+     * @return uint64_t Generation of the query
+     */
+    uint64_t schedule(const std::string& query, Task task);
+
+    /**
+     * @brief Run a search without a delay, e.g. when the search button was clicked
+     * @param query Search text
+     * @param task Runs the search
+     * @return uint64_t Generation of the query
+     */
+    uint64_t run_now(const std::string& query, Task task);
+
+    /**
+     * @brief Cancel the pending and the running search
+     */
+    void cancel();
+
+    /**
+     * @brief Wait until no search is pending or running
+     */
+    void wait();
+
+    /**
+     * @brief Check whether a generation is the latest one
+     * @param generation Generation returned by schedule() or run_now()
+     * @return bool True if no newer query was scheduled and it was not cancelled
+     */
+    bool is_current(uint64_t generation) const;
+
+    /**
+     * @brief Get the latest generation
+     * @return uint64_t The generation, 0 before the first query
+     */
+    uint64_t get_generation() const;
+
+    /**
+     * @brief Get the delay a query would wait now
+     * @param query Search text
+     * @return int Delay in milliseconds
+     */
+    int get_delay_ms(const std::string& query) const;
+
+    /**
+     * @brief Record how long a search took
+     * @param milliseconds Duration of the search
+     */
+    void report_duration(double milliseconds);
+
+    /**
+     * @brief Set the bounds of the adaptive delay
+     * @param min_ms Delay after fast searches
+     * @param max_ms Delay after slow searches and for short queries
+     */
+    void set_delay_limits(int min_ms, int max_ms);
+
+    /**
+     * @brief Check whether a query only narrows a previous one
+     *
+     * Every package whose name contains query then also contains previous,
+     * so the results of previous can be filtered instead of searching again.
+     *
+     * @param query New search text
+     * @param previous Earlier search text
+     * @return bool True if previous is a non-empty part of query, ignoring case
+     */
+    static bool extends(const std::string& query, const std::string& previous);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Start a new generation, cancelling the current one
+     * @param query Search text
+     * @return SearchToken Token of the new generation
+     */
+    SearchToken next_token(const std::string& query);
+
+    /**
+     * @brief Hand a task to the thread pool
+     * @param token Token of the search
+     * @param task The search
+     */
+    void dispatch(const SearchToken& token, Task task);
+
+    /**
+     * @brief Wait out the delays of scheduled searches and dispatch them
+     */
+    void run_timer();
+
+    /**
+     * @brief Get the delay of a query, with m_mutex held
+     * @param query Search text
+     * @return int Delay in milliseconds
+     */
+    int delay_locked(const std::string& query) const;
+
+    mutable std::mutex m_mutex;            ///< Guards the members below
+    std::condition_variable m_wakeup;      ///< Signalled when a search was scheduled or on shutdown
+    std::condition_variable m_idle;        ///< Signalled when nothing is pending or running
+    SearchToken m_current;                 ///< Latest generation
+    Task m_pending;                        ///< Search waiting for its delay, null if none
+    Clock::time_point m_deadline;          ///< When the pending search starts
+    size_t m_running;                      ///< Dispatched searches that have not returned
+    double m_average_ms;                   ///< Moving average of search durations, -1 before the first
+    int m_min_delay_ms;                    ///< Lower bound of the delay
+    int m_max_delay_ms;                    ///< Upper bound of the delay
+    bool m_time_tasks;                     ///< Whether dispatch() times the tasks
+    bool m_stopping;                       ///< Set by the destructor
+    std::thread m_timer;                   ///< Runs run_timer()
+};
+
+} // namespace core
+} // namespace pacmangui
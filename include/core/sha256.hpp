@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Incremental SHA-256 (FIPS 180-4)
+ *
+ * Used for content-addressed cache keys, so data can be hashed as it is
+ * read without holding it in memory.
+ */
+class Sha256 {
+public:
+    /**
+     * @brief Constructor
+     */
+    Sha256();
+
+    /**
+     * @brief Hash more data
+     * @param data Bytes to add
+     * @param size Number of bytes
+     */
+    void update(const void* data, size_t size);
+
+    /**
+     * @brief Hash more data
+     * @param data Bytes to add
+     */
+    void update(const std::string& data);
+
+    /**
+     * @brief Hash the contents of a file
+     * @param path File to read
+     * @return bool False if the file could not be read
+     */
+    bool update_file(const std::string& path);
+
+    /**
+     * @brief Finish the hash
+     *
+     * The object has to be reset() before it is used again.
+     *
+     * @return std::string The digest as 64 lowercase hex digits
+     */
+    std::string hex_digest();
+
+    /**
+     * @brief Start a new hash
+     */
+    void reset();
+
+    /**
+     * @brief Hash a string in one go
+     * @param data Bytes to hash
+     * @return std::string The digest as 64 lowercase hex digits
+     */
+    static std::string hash(const std::string& data);
+
+private:
+    /**
+     * @brief Process one 64-byte block
+     * @param block The block
+     */
+    void transform(const uint8_t* block);
+
+    uint32_t m_state[8];     ///< Intermediate hash value
+    uint64_t m_length;       ///< Bytes hashed so far
+    uint8_t m_buffer[64];    ///< Partial block
+    size_t m_buffered;       ///< Bytes in m_buffer
+};
+
+} // namespace core
+} // namespace pacmangui
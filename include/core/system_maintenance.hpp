@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <alpm.h>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Callback receiving one line of maintenance output
+ */
+using MaintenanceOutputCallback = std::function<void(const std::string&)>;
+
+/**
+ * @brief Split a cached package filename into name and version
+ *
+ * Understands "name-pkgver-pkgrel-arch.pkg.tar.*" with an optional ".sig" suffix.
+ *
+ * @param filename File name without directory
+ * @param name Receives the package name
+ * @param version Receives "pkgver-pkgrel", including any epoch
+ * @return bool True if the file is a package or package signature
+ */
+bool parse_package_filename(const std::string& filename, std::string& name, std::string& version);
+
+/**
+ * @brief Cache cleaning, orphan detection and database checks on an alpm handle
+ *
+ * Does natively what pacman -Sc, -Qdtq and -Dk do, so the helper daemon can
+ * run them on its already loaded handle instead of starting pacman.
+ */
+class SystemMaintenance {
+public:
+    /**
+     * @brief Constructor
+     * @param handle The alpm handle, owned by the caller
+     */
+    explicit SystemMaintenance(alpm_handle_t* handle);
+
+    /**
+     * @brief Find installed dependencies nothing requires or optionally requires
+     * @return std::vector<std::string> Names of the orphaned packages
+     */
+    std::vector<std::string> find_orphans() const;
+
+    /**
+     * @brief Remove package files from the cache directories
+     *
+     * Without clean_all only files of packages that are not installed in the
+     * cached version are removed, like pacman -Sc. Partial downloads are always
+     * removed.
+     *
+     * @param clean_all Remove every cached package, like pacman -Scc
+     * @param output_callback Receives a summary line per cache directory (may be null)
+     * @return bool True if every file could be removed
+     */
+    bool clean_cache(bool clean_all, MaintenanceOutputCallback output_callback);
+
+    /**
+     * @brief Check the databases for missing dependencies and conflicts
+     * @param check_sync Check the sync databases as well, like pacman -Dkk
+     * @param output_callback Receives one line per problem found (may be null)
+     * @return bool True if no problems were found
+     */
+    bool check_database(bool check_sync, MaintenanceOutputCallback output_callback);
+
+    /**
+     * @brief Get the number of bytes freed by the last clean_cache()
+     * @return uint64_t Freed bytes
+     */
+    uint64_t get_freed_bytes() const;
+
+    /**
+     * @brief Get the last error message
+     * @return std::string The last error message
+     */
+    std::string get_last_error() const;
+
+private:
+    /**
+     * @brief Check a package list for unsatisfied dependencies and conflicts
+     * @param packages The packages, checked against each other
+     * @param label Database name used in the output
+     * @param output_callback Receives one line per problem (may be null)
+     * @return size_t Number of problems found
+     */
+    size_t check_packages(alpm_list_t* packages, const std::string& label,
+                          const MaintenanceOutputCallback& output_callback);
+
+    alpm_handle_t* m_handle;     ///< ALPM handle, not owned
+    uint64_t m_freed_bytes;      ///< Bytes freed by the last clean_cache()
+    std::string m_last_error;    ///< Last error message
+};
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pacmangui {
+namespace core {
+
+/**
+ * @brief Fixed set of worker threads running queued tasks
+ *
+ * Used to spread per-repository work over the available cores. Tasks are
+ * started in submission order; results come back through futures, so
+ * callers merge them in whatever order they need.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Constructor
+     * @param threads Number of workers, 0 for one per hardware thread
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * @brief Destructor, finishes the queued tasks and joins the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Get the pool shared by the core classes
+     * @return ThreadPool& Pool with one worker per hardware thread, or $PACMANGUI_THREADS workers
+     */
+    static ThreadPool& shared();
+
+    /**
+     * @brief Get the number of workers
+     * @return size_t Number of worker threads
+     */
+    size_t size() const;
+
+    /**
+     * @brief Queue a task
+     * @param task Callable without arguments
+     * @return std::future Result of the task, or the exception it threw
+     */
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn>> submit(Fn&& task)
+    {
+        using Result = std::invoke_result_t<Fn>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Fn>(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    /**
+     * @brief Run fn(0) ... fn(count - 1) across the workers and wait for all of them
+     *
+     * The calling thread takes part, so this is safe to call from inside a
+     * task and never waits for a worker that is busy elsewhere.
+     *
+     * @param count Number of indices
+     * @param fn Called once per index, possibly concurrently
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    /**
+     * @brief Add a task to the queue and wake a worker
+     * @param task The task
+     */
+    void enqueue(std::function<void()> task);
+
+    /**
+     * @brief Worker loop
+     */
+    void run();
+
+    std::vector<std::thread> m_workers;        ///< Worker threads
+    std::deque<std::function<void()>> m_queue; ///< Tasks not started yet
+    std::mutex m_mutex;                        ///< Guards m_queue and m_stopping
+    std::condition_variable m_wakeup;          ///< Signalled when a task is queued or the pool stops
+    bool m_stopping;                           ///< Set by the destructor
+};
+
+} // namespace core
+} // namespace pacmangui
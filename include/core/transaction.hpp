@@ -6,6 +6,7 @@
 #include <functional>
 #include <alpm.h>
 #include "core/package.hpp"
+#include "core/download_scheduler.hpp"
 
 namespace pacmangui {
 namespace core {
@@ -19,7 +20,8 @@ enum class TransactionType {
     INSTALL,    ///< Install packages
     REMOVE,     ///< Remove packages
     UPDATE,     ///< Update packages
-    SYNC        ///< Sync repositories
+    SYNC,       ///< Sync repositories
+    INSTALL_FILES ///< Install package files, e.g. packages built from the AUR
 };
 
 /**
@@ -33,6 +35,25 @@ enum class TransactionState {
     FAILED      ///< Transaction has failed
 };
 
+/**
+ * @brief Callback receiving human-readable transaction events
+ */
+using TransactionEventCallback = std::function<void(const std::string& message)>;
+
+/**
+ * @brief Callback receiving transaction progress
+ *
+ * Called with the operation (e.g. "installing"), the package it applies to,
+ * the percentage for that package and the package's position in the transaction.
+ */
+using TransactionProgressCallback = std::function<void(const std::string& operation, const std::string& target,
+                                                       int percent, size_t current, size_t total)>;
+
+/**
+ * @brief Callback receiving per-file and aggregate download progress
+ */
+using TransactionDownloadCallback = std::function<void(const DownloadProgress& progress)>;
+
 /**
  * @brief Class representing a package transaction
  */
@@ -87,10 +108,140 @@ public:
 
     /**
      * @brief Get the list of packages in the transaction
+     *
+     * After the transaction has been prepared this is the resolved set,
+     * packages to install or upgrade followed by packages to remove.
+     *
      * @return The list of packages
      */
     std::vector<Package> get_packages() const;
 
+    /**
+     * @brief Get the packages the transaction will install or upgrade
+     * @return The resolved add set
+     */
+    const std::vector<Package>& get_add_packages() const;
+
+    /**
+     * @brief Get the packages the transaction will remove
+     * @return The resolved remove set
+     */
+    const std::vector<Package>& get_remove_packages() const;
+
+    /**
+     * @brief Store the resolved package sets
+     * @param add Packages to install or upgrade
+     * @param remove Packages to remove
+     */
+    void set_resolved_packages(std::vector<Package> add, std::vector<Package> remove);
+
+    /**
+     * @brief Allow the transaction to overwrite conflicting files
+     * @param overwrite True to overwrite any conflicting file
+     */
+    void set_overwrite_files(bool overwrite);
+
+    /**
+     * @brief Check if conflicting files may be overwritten
+     * @return True if conflicting files are overwritten
+     */
+    bool get_overwrite_files() const;
+
+    /**
+     * @brief Refresh the sync databases before a system upgrade
+     * @param refresh True to refresh the databases first
+     */
+    void set_refresh_databases(bool refresh);
+
+    /**
+     * @brief Check if the sync databases are refreshed first
+     * @return True if the databases are refreshed
+     */
+    bool get_refresh_databases() const;
+
+    /**
+     * @brief Also remove dependencies no other package needs, like pacman -Rs
+     * @param recursive True to remove unneeded dependencies of the targets
+     */
+    void set_remove_dependencies(bool recursive);
+
+    /**
+     * @brief Check if unneeded dependencies are removed as well
+     * @return True if removal is recursive
+     */
+    bool get_remove_dependencies() const;
+
+    /**
+     * @brief Set targets that are installed as dependencies
+     *
+     * Packages from these targets that are not installed yet are recorded
+     * with the dependency install reason, like pacman --asdeps. Upgrades keep
+     * their reason.
+     *
+     * @param targets Subset of the targets
+     */
+    void set_dependency_targets(const std::vector<std::string>& targets);
+
+    /**
+     * @brief Check if a target is installed as a dependency
+     * @param target The target
+     * @return True if the target was passed to set_dependency_targets()
+     */
+    bool is_dependency_target(const std::string& target) const;
+
+    /**
+     * @brief Set the callback for transaction events
+     * @param callback Event callback
+     */
+    void set_event_callback(TransactionEventCallback callback);
+
+    /**
+     * @brief Set the callback for transaction progress
+     * @param callback Progress callback
+     */
+    void set_progress_callback(TransactionProgressCallback callback);
+
+    /**
+     * @brief Set the callback for download progress
+     * @param callback Download callback
+     */
+    void set_download_callback(TransactionDownloadCallback callback);
+
+    /**
+     * @brief Report an event to the event callback
+     * @param message Event description
+     */
+    void notify_event(const std::string& message) const;
+
+    /**
+     * @brief Report progress to the progress callback
+     * @param operation Current operation
+     * @param target Package being processed
+     * @param percent Progress of the package
+     * @param current Position of the package in the transaction
+     * @param total Number of packages in the transaction
+     */
+    void notify_progress(const std::string& operation, const std::string& target,
+                         int percent, size_t current, size_t total) const;
+
+    /**
+     * @brief Report download progress to the download callback
+     * @param progress Download progress
+     */
+    void notify_download(const DownloadProgress& progress) const;
+
+    /**
+     * @brief Get the last error message
+     * @return The last error message
+     */
+    std::string get_last_error() const;
+
+    /**
+     * @brief Set the last error message
+     * @param error The error message
+     */
+    void set_last_error(const std::string& error);
+
     /**
      * @brief Set the ALPM transaction
      * @param trans The ALPM transaction
@@ -107,6 +258,16 @@ private:
     TransactionType m_type;                  ///< The type of transaction
     TransactionState m_state;                ///< The state of the transaction
     std::vector<std::string> m_targets;      ///< The list of package targets
+    std::vector<Package> m_add_packages;     ///< Resolved packages to install or upgrade
+    std::vector<Package> m_remove_packages;  ///< Resolved packages to remove
+    bool m_overwrite_files;                  ///< Overwrite conflicting files
+    bool m_refresh_databases;                ///< Refresh sync databases before upgrading
+    bool m_remove_dependencies;              ///< Remove unneeded dependencies of removed targets
+    std::vector<std::string> m_dependency_targets; ///< Targets installed as dependencies
+    TransactionEventCallback m_event_callback;       ///< Event callback
+    TransactionProgressCallback m_progress_callback; ///< Progress callback
+    TransactionDownloadCallback m_download_callback; ///< Download callback
+    std::string m_last_error;                ///< Last error message
     void* m_trans;                           ///< Pointer to the alpm transaction - using void* for compatibility
 };
 
@@ -155,12 +316,62 @@ public:
 
     /**
      * @brief Resolve dependencies for a transaction
+     *
+     * Prepares the transaction if that has not happened yet.
+     *
      * @param transaction The transaction to resolve dependencies for
      * @return The list of packages to install
      */
     std::vector<Package> resolve_dependencies(Transaction* transaction);
 
+    /**
+     * @brief Refresh the sync databases
+     * @param transaction Transaction receiving events and errors
+     * @param force Download the databases even if they are up to date
+     * @return True if the databases were refreshed
+     */
+    bool refresh_databases(Transaction* transaction, bool force = false);
+
+    /**
+     * @brief Download packages and databases through a scheduler
+     *
+     * Installs the scheduler as ALPM's fetch callback and registers the servers
+     * of each sync database as interchangeable mirrors, so commits fetch their
+     * whole add set in parallel before ALPM reads the cache. Call this after the
+     * sync databases have been registered.
+     *
+     * @param scheduler The scheduler, owned by the caller, or nullptr for ALPM's downloader
+     */
+    void set_download_scheduler(DownloadScheduler* scheduler);
+
 private:
+    /**
+     * @brief Add the transaction targets to the ALPM transaction
+     * @param transaction The transaction
+     * @return True if every target was found
+     */
+    bool add_targets(Transaction* transaction);
+
+    /**
+     * @brief Describe the data list returned by a failed prepare or commit
+     * @param err The ALPM error
+     * @param data The list returned by ALPM, freed by this function
+     * @return Human-readable error message
+     */
+    std::string describe_failure(alpm_errno_t err, alpm_list_t* data);
+
+    /**
+     * @brief Download the packages of a prepared transaction into the cache
+     * @param transaction The transaction
+     * @return True if every missing package was downloaded
+     */
+    bool download_packages(Transaction* transaction);
+
+    static void event_callback(void* ctx, alpm_event_t* event);
+    static void progress_callback(void* ctx, alpm_progress_t progress, const char* pkg,
+                                  int percent, size_t howmany, size_t current);
+    static void question_callback(void* ctx, alpm_question_t* question);
+
     /**
      * @brief Initialize an ALPM transaction
      * @param transaction The transaction to initialize
@@ -169,6 +380,8 @@ private:
     bool init_alpm_transaction(Transaction* transaction);
 
     alpm_handle_t* m_handle;                     ///< The ALPM handle
+    DownloadScheduler* m_scheduler;              ///< Parallel downloader, not owned
+    std::vector<std::string> m_new_dependencies; ///< Packages the committed transaction marks as dependencies
 };
 
 } // namespace core
@@ -12,13 +12,38 @@
 #include <QRadioButton>
 #include <QButtonGroup>
 #include <QFutureWatcher>
-#include <QDateTime>
 #include <QList>
+#include <QCache>
+#include <atomic>
+#include <memory>
 #include "core/packagemanager.hpp"
 
 namespace pacmangui {
 namespace gui {
 
+/**
+ * @brief What the details panel shows for an installed application
+ */
+struct FlatpakDetails {
+    QString appId;
+    bool found = false;
+    core::FlatpakPackage package;
+    QStringList filesystemPerms;
+    QStringList devicePerms;
+    QStringList featurePerms;
+    QStringList socketPerms;
+    QStringList otherPerms;
+};
+
+/**
+ * @brief Size of an application's user data
+ */
+struct UserDataSize {
+    QString appId;
+    QString path;
+    QString size;
+};
+
 class FlatpakManagerTab : public QWidget
 {
     Q_OBJECT
@@ -40,7 +65,6 @@ public slots:
     void setShowInstalledOnly(bool show);
     void setShowSystemApps(bool show);
     void setShowUserApps(bool show);
-    void clearSearchCache();
 
 private slots:
     void onManageUserData();
@@ -53,6 +77,9 @@ private slots:
     void onSearchResultSelected(const QModelIndex& current, const QModelIndex& previous);
     void onInstallSelected();
     void onSearchCompleted();
+    void onDetailsLoaded();
+    void onUserDataMeasured();
+    void onRemotesLoaded();
 
 protected:
     void resizeEvent(QResizeEvent* event) override;
@@ -62,13 +89,13 @@ private:
     void connectSignals();
     void updateFlatpakDetails(const QString& appId);
     void updateUserDataInfo(const QString& appId);
-    QString calculateDirSize(const QString& path);
+    void showFlatpakDetails(const FlatpakDetails& details);
+    void showUserDataSize(const UserDataSize& size);
+    void cancelPendingRequests();
     QString getDataPath(const QString& appId);
     QString getCurrentAppId() const;
     void performAsyncSearch(const QString& searchTerm);
     void applySearchFilters(const QString& searchTerm);
-    void addToSearchCache(const QString& searchTerm, const std::vector<pacmangui::core::FlatpakPackage>& results);
-    bool getFromSearchCache(const QString& searchTerm, std::vector<pacmangui::core::FlatpakPackage>& results);
     void filterResults(std::vector<pacmangui::core::FlatpakPackage>& results);
     void updateSearchResults(const std::vector<pacmangui::core::FlatpakPackage>& results);
     
@@ -86,16 +113,6 @@ private:
     QPushButton* m_installSelectedButton = nullptr;
     QFutureWatcher<std::vector<pacmangui::core::FlatpakPackage>>* m_searchWatcher = nullptr;
     
-    // Search cache
-    struct SearchCacheEntry {
-        QString searchTerm;
-        std::vector<pacmangui::core::FlatpakPackage> results;
-        QDateTime timestamp;
-    };
-    QList<SearchCacheEntry> m_searchCache;
-    static const int MAX_CACHE_SIZE = 100;
-    static const int CACHE_TIMEOUT_MS = 300000; // 5 minutes
-    
     // Search filters
     QString m_currentFilter;
     bool m_showInstalledOnly = false;
@@ -131,6 +148,18 @@ private:
     QPushButton* m_createSnapshotButton = nullptr;
     QPushButton* m_restoreSnapshotButton = nullptr;
     
+    // Details and user data are loaded off the GUI thread; a new selection
+    // sets the cancel flag of the requests still running for the old one
+    QFutureWatcher<FlatpakDetails>* m_detailsWatcher = nullptr;
+    QFutureWatcher<UserDataSize>* m_userDataWatcher = nullptr;
+    QFutureWatcher<std::vector<std::string>>* m_remotesWatcher = nullptr;
+    std::shared_ptr<std::atomic<bool>> m_requestCancelled;
+    QString m_requestedAppId;
+    
+    // Least recently used entries are dropped first
+    QCache<QString, FlatpakDetails> m_detailsCache{64};
+    QCache<QString, UserDataSize> m_userDataCache{64};
+    
     // Data
     core::PackageManager* m_packageManager = nullptr;
     bool m_selectingFlatpak = false;
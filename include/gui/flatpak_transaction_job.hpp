@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QString>
+#include <QStringList>
+
+#include "core/packagemanager.hpp"
+#include "core/flatpak_transaction.hpp"
+
+namespace pacmangui {
+namespace gui {
+
+/**
+ * @brief Runs one Flatpak transaction off the GUI thread
+ *
+ * The transaction runs on a worker thread; its per-ref progress arrives as
+ * refProgress() signals, which queued connections deliver to the GUI thread
+ * while flatpak works, and finished() is emitted once it exits.
+ */
+class FlatpakTransactionJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor
+     * @param packageManager Package manager that runs the transaction
+     * @param operation Install, remove or update
+     * @param appIds Application IDs, empty to update everything
+     * @param remote Remote to install from, empty to let flatpak pick one
+     * @param parent The parent object
+     */
+    FlatpakTransactionJob(core::PackageManager* packageManager, core::FlatpakOperation operation,
+                          const QStringList& appIds, const QString& remote = QString(), QObject* parent = nullptr);
+
+    /**
+     * @brief Start the transaction
+     */
+    void start();
+
+    /**
+     * @brief Ask flatpak to stop, finished() follows
+     */
+    void cancel();
+
+    /**
+     * @brief Check whether the transaction is running
+     * @return bool True between start() and finished()
+     */
+    bool isRunning() const;
+
+signals:
+    /**
+     * @brief Progress of one ref changed
+     * @param ref Requested app ID, or the ref of a dependency
+     * @param state A core::FlatpakRefState value
+     * @param percent Progress of the running step
+     * @param message Last line flatpak printed about the ref
+     * @param requested False for refs flatpak pulled in itself
+     */
+    void refProgress(const QString& ref, int state, int percent, const QString& message, bool requested);
+
+    /**
+     * @brief The transaction ended
+     * @param success Whether flatpak succeeded
+     * @param error The error if it did not
+     */
+    void finished(bool success, const QString& error);
+
+private:
+    core::PackageManager* m_packageManager;
+    core::FlatpakOperation m_operation;
+    std::vector<std::string> m_appIds;
+    std::string m_remote;
+    QString m_error;
+    QFutureWatcher<bool>* m_watcher;
+};
+
+} // namespace gui
+} // namespace pacmangui
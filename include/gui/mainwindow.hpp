@@ -38,13 +38,16 @@
 #include <QSortFilterProxyModel>
 #include "core/packagemanager.hpp"
 #include "core/flatpak_package.hpp"
+#include "core/search_scheduler.hpp"
 #include "gui/flatpak_manager_tab.hpp"
+#include "gui/package_table_model.hpp"
 #include <functional>
 
 // Forward declarations
 namespace pacmangui {
 namespace gui {
     class SettingsDialog;
+    class FlatpakTransactionJob;
 }
 namespace wayland {
     class WaylandBackend;
@@ -146,6 +149,7 @@ private slots:
     void onCheckIntegrityAllPackages();
     void onRefreshMirrorList();
     void checkForUpdatesAfterSync();
+    void onAurUpdatesChecked();
     
     // Theme
     void toggleTheme();
@@ -195,6 +199,7 @@ private:
     void refreshUpdatesList();
     void updateBatchInstallButton();
     void checkAurHelper();
+    void refreshAurIndex();
     void downloadYayHelper();
     void showDetailPanel(const QString& packageName, const QString& version, const QString& repo, const QString& description);
     void checkForUpdates();
@@ -203,8 +208,9 @@ private:
     // Table styling helper
     void applyTableStyle(QTreeView* tableView);
     
-    // Async search helper method
+    // Async search helper methods
     void performAsyncSearch(const QString& searchTerm);
+    void appendSearchBatch(const pacmangui::core::SearchBatch& batch);
     
     // Wayland Support
     void applyWaylandOptimizations();
@@ -306,8 +312,8 @@ private:
     bool m_detailPanelVisible;
     
     // Models for tables
-    QStandardItemModel* m_packagesModel;
-    QStandardItemModel* m_installedModel;
+    PackageTableModel* m_packagesModel;
+    PackageTableModel* m_installedModel;
     
     // Actions map for menu setup
     QMap<QString, QAction*> m_actions;
@@ -393,7 +399,8 @@ private:
     QString m_currentStatusMessage;
 
     // Async search variables
-    QFutureWatcher<std::vector<pacmangui::core::Package>>* m_searchWatcher;
+    quint64 m_searchQueryId;  // Streaming search whose results are shown
+    core::SearchScheduler m_searchScheduler;  // Debounces searches while typing
 
     // Flatpak functionality
     void setupFlatpakSupport();
@@ -403,11 +410,17 @@ private:
     void setupFlatpakTab();
     void refreshFlatpakList();
     void refreshFlatpakRemotes();
+    void appendSystemUpdates(const std::vector<pacmangui::core::PackageUpdate>& updates);
+    void showSystemUpdateCount();
+    void runFlatpakTransaction(core::FlatpakOperation operation, const QStringList& appIds,
+                               const QStringList& names, const QString& remote = QString());
     
     // Flatpak related members
-    QStandardItemModel* m_flatpakModel;
-    QStandardItemModel* m_installedFlatpakModel;
+    PackageTableModel* m_flatpakModel;
+    PackageTableModel* m_installedFlatpakModel;
     QFutureWatcher<std::vector<pacmangui::core::FlatpakPackage>>* m_flatpakSearchWatcher;
+    FlatpakTransactionJob* m_flatpakJob;  // Running Flatpak install or removal, if any
+    QFutureWatcher<std::vector<pacmangui::core::PackageUpdate>>* m_aurUpdatesWatcher;  // AUR update check after a sync
     
     // Flatpak UI elements
     QCheckBox* m_flatpakSearchCheckbox;
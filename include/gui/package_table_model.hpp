@@ -0,0 +1,180 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QList>
+#include <QString>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/package.hpp"
+#include "core/package_catalog.hpp"
+#include "core/flatpak_package.hpp"
+
+namespace pacmangui {
+namespace gui {
+
+/**
+ * @brief Table model over package views, without an item object per cell
+ *
+ * Rows are PackageViews into pinned catalog generations, or into strings
+ * the model owns for packages that come as Package objects (search results,
+ * Flatpak packages). Text is only converted to QString when a view asks for
+ * a cell, so only the visible rows are ever touched. Check states are kept
+ * in a bitset next to the rows.
+ *
+ * Roles on every column of a row:
+ * - Qt::UserRole: the Flatpak application ID, if any
+ * - Qt::UserRole + 1: "aur" or "flatpak" for packages not from a repository
+ */
+class PackageTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Columns a model can show
+     */
+    enum Column {
+        CHECK_COLUMN,         ///< Checkbox for multi-selection
+        NAME_COLUMN,          ///< Package name
+        VERSION_COLUMN,       ///< Package version
+        REPOSITORY_COLUMN,    ///< Repository, AUR or Flatpak remote
+        DESCRIPTION_COLUMN    ///< Package description
+    };
+
+    static constexpr int AppIdRole = Qt::UserRole;            ///< Flatpak application ID
+    static constexpr int PackageTypeRole = Qt::UserRole + 1;  ///< "aur", "flatpak" or nothing
+
+    /**
+     * @brief Constructor
+     * @param columns Columns to show, in order
+     * @param parent The parent object
+     */
+    explicit PackageTableModel(const QList<Column>& columns, QObject* parent = nullptr);
+
+    /**
+     * @brief Show packages of a catalog generation, replacing all rows
+     * @param catalog Catalog the views point into, kept alive by the model
+     * @param packages The packages to show
+     */
+    void setCatalogPackages(std::shared_ptr<const core::PackageCatalog> catalog,
+                            std::vector<core::PackageView> packages);
+
+    /**
+     * @brief Append packages of a catalog generation in one insertion
+     *
+     * Rows already shown keep pointing into their own generation, so a
+     * refresh between two appends leaves both pinned.
+     *
+     * @param catalog Catalog the views point into, kept alive by the model
+     * @param packages The packages to append
+     */
+    void appendCatalogPackages(std::shared_ptr<const core::PackageCatalog> catalog,
+                               const std::vector<core::PackageView>& packages);
+
+    /**
+     * @brief Append repository or AUR packages that are not in a catalog in one insertion
+     * @param packages The packages to append
+     */
+    void appendPackages(const std::vector<core::Package>& packages);
+
+    /**
+     * @brief Append Flatpak packages in one insertion
+     * @param packages The packages to append
+     * @param repository Repository shown for every package, empty to show their own
+     */
+    void appendFlatpakPackages(const std::vector<core::FlatpakPackage>& packages,
+                               const std::string& repository = std::string());
+
+    /**
+     * @brief Remove all rows
+     */
+    void clear();
+
+    /**
+     * @brief Get the package shown in a row
+     * @param row The row
+     * @return core::PackageView The package, valid while the model keeps it
+     */
+    core::PackageView packageAt(int row) const;
+
+    /**
+     * @brief Get the names of the checked packages
+     * @return QStringList Package names in row order
+     */
+    QStringList checkedPackageNames() const;
+
+    // QAbstractTableModel interface
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+private:
+    /**
+     * @brief Where the package of a row comes from
+     */
+    enum class Source {
+        REPOSITORY,
+        AUR,
+        FLATPAK
+    };
+
+    /**
+     * @brief One table row
+     */
+    struct Row {
+        core::PackageView package;   ///< Points into a catalog or m_owned
+        std::string_view app_id;     ///< Flatpak application ID, points into m_owned
+        Source source = Source::REPOSITORY;
+    };
+
+    /**
+     * @brief Strings of a package that did not come from a catalog
+     */
+    struct OwnedPackage {
+        std::string name;
+        std::string version;
+        std::string description;
+        std::string repository;
+        std::string app_id;
+    };
+
+    /**
+     * @brief Get the text of a cell
+     * @param row The row
+     * @param column The column shown
+     * @return QString The text
+     */
+    QString text(const Row& row, Column column) const;
+
+    /**
+     * @brief Get the repository label of a row, with the usual capitalization
+     * @param row The row
+     * @return QString The label
+     */
+    static QString repositoryLabel(const Row& row);
+
+    /**
+     * @brief Store the strings of a package and point a row at them
+     * @param owned The strings to keep
+     * @param source Where the package comes from
+     */
+    void appendOwned(OwnedPackage owned, Source source);
+
+    QList<Column> m_columns;                                 ///< Columns shown, in order
+    std::vector<Row> m_rows;                                 ///< Shown packages, in display order
+    std::vector<bool> m_checked;                             ///< Check state of each row
+    std::deque<OwnedPackage> m_owned;                        ///< Strings of non-catalog rows, never moved
+    std::vector<std::shared_ptr<const core::PackageCatalog>> m_catalogs; ///< Catalogs the other rows point into
+};
+
+} // namespace gui
+} // namespace pacmangui
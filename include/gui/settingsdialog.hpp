@@ -10,6 +10,8 @@
 #include <QTabWidget>
 #include <QGroupBox>
 #include <QRadioButton>
+#include <QSpinBox>
+#include <QLineEdit>
 #include <QSettings>
 
 namespace pacmangui {
@@ -93,6 +95,12 @@ signals:
      */
     void aurStatusChanged(bool enabled);
     
+    /**
+     * @brief Signal emitted when the local AUR index is switched on or off
+     * @param enabled Whether AUR searches use the local index
+     */
+    void aurLocalIndexChanged(bool enabled);
+    
     /**
      * @brief Signal emitted when Flatpak status is changed
      * @param enabled Whether Flatpak is enabled
@@ -137,6 +145,13 @@ private:
     // AUR tab
     QWidget* m_aurTab;
     QCheckBox* m_enableAurCheckbox;
+    QCheckBox* m_aurLocalIndexCheckbox;
+    QCheckBox* m_aurNativeBuildCheckbox;
+    QSpinBox* m_aurBuildJobsSpinBox;
+    QCheckBox* m_aurBuildCacheCheckbox;
+    QSpinBox* m_aurCacheSizeSpinBox;
+    QSpinBox* m_aurCacheAgeSpinBox;
+    QLineEdit* m_aurSharedCacheEdit;
     
     // Flatpak tab
     QWidget* m_flatpakTab;
@@ -156,6 +171,7 @@ private:
     
     // Settings
     bool m_aurEnabled;
+    bool m_aurLocalIndex;
     bool m_flatpakEnabled;
     QString m_selectedTheme;
     double m_scalingFactor;
@@ -0,0 +1,744 @@
+#include "core/appstream_index.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    constexpr char kMagic[8] = {'P', 'M', 'G', 'A', 'P', 'P', 'I', 'X'};
+    constexpr int kFieldCount = 7;
+    constexpr size_t kCancelCheckInterval = 256;
+
+    enum Field { ID, NAME, SUMMARY, BRANCH, VERSION, KEYWORDS, CATEGORIES };
+
+    template <typename T>
+    void append(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    bool read(const char*& cursor, const char* end, T& value)
+    {
+        if (static_cast<size_t>(end - cursor) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, cursor, sizeof(value));
+        cursor += sizeof(value);
+        return true;
+    }
+
+    bool make_directories(const std::string& path)
+    {
+        for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+            std::string dir = path.substr(0, slash);
+            if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+                return false;
+            }
+            if (slash == std::string::npos) {
+                return true;
+            }
+        }
+    }
+
+    std::string join(const std::vector<std::string>& values)
+    {
+        std::string joined;
+        for (const std::string& value : values) {
+            if (!joined.empty()) {
+                joined += ';';
+            }
+            joined += value;
+        }
+        return joined;
+    }
+
+    // Appends text with the predefined and numeric entities replaced
+    bool append_decoded(std::string_view raw, std::string& out)
+    {
+        size_t pos = 0;
+        while (pos < raw.size()) {
+            size_t amp = raw.find('&', pos);
+            out.append(raw.substr(pos, amp == std::string_view::npos ? std::string_view::npos : amp - pos));
+            if (amp == std::string_view::npos) {
+                return true;
+            }
+
+            size_t semicolon = raw.find(';', amp);
+            if (semicolon == std::string_view::npos) {
+                return false;
+            }
+            std::string_view entity = raw.substr(amp + 1, semicolon - amp - 1);
+            if (entity == "amp") out += '&';
+            else if (entity == "lt") out += '<';
+            else if (entity == "gt") out += '>';
+            else if (entity == "quot") out += '"';
+            else if (entity == "apos") out += '\'';
+            else if (entity.size() > 1 && entity[0] == '#') {
+                bool hex = entity[1] == 'x' || entity[1] == 'X';
+                std::string digits(entity.substr(hex ? 2 : 1));
+                char* end = nullptr;
+                unsigned long code = strtoul(digits.c_str(), &end, hex ? 16 : 10);
+                if (digits.empty() || *end != '\0' || code == 0 || code > 0x10FFFF) {
+                    return false;
+                }
+                // UTF-8 encode the code point
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            } else {
+                return false;
+            }
+            pos = semicolon + 1;
+        }
+        return true;
+    }
+
+    std::string_view trim(std::string_view text)
+    {
+        const char* spaces = " \t\r\n";
+        size_t first = text.find_first_not_of(spaces);
+        if (first == std::string_view::npos) {
+            return std::string_view();
+        }
+        return text.substr(first, text.find_last_not_of(spaces) - first + 1);
+    }
+
+    bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool is_name_end(char c)
+    {
+        return is_space(c) || c == '/' || c == '>' || c == '=';
+    }
+
+    /**
+     * @brief A start tag, with its attributes
+     */
+    struct Tag {
+        std::string name;
+        std::vector<std::pair<std::string, std::string>> attributes;
+        bool self_closing = false;
+
+        std::string attribute(const std::string& key) const
+        {
+            for (const auto& attribute : attributes) {
+                if (attribute.first == key) {
+                    return attribute.second;
+                }
+            }
+            return "";
+        }
+    };
+
+    // Parses the inside of a start tag, between '<' and '>'
+    bool parse_tag(std::string_view body, Tag& tag)
+    {
+        if (!body.empty() && body.back() == '/') {
+            tag.self_closing = true;
+            body.remove_suffix(1);
+        }
+
+        size_t pos = 0;
+        while (pos < body.size() && !is_name_end(body[pos])) ++pos;
+        tag.name.assign(body.substr(0, pos));
+        if (tag.name.empty()) {
+            return false;
+        }
+
+        while (true) {
+            while (pos < body.size() && is_space(body[pos])) ++pos;
+            if (pos == body.size()) {
+                return true;
+            }
+
+            size_t key_start = pos;
+            while (pos < body.size() && !is_name_end(body[pos])) ++pos;
+            std::string key(body.substr(key_start, pos - key_start));
+            while (pos < body.size() && is_space(body[pos])) ++pos;
+            if (key.empty() || pos >= body.size() || body[pos] != '=') {
+                return false;
+            }
+            ++pos;
+            while (pos < body.size() && is_space(body[pos])) ++pos;
+            if (pos >= body.size() || (body[pos] != '"' && body[pos] != '\'')) {
+                return false;
+            }
+            size_t close = body.find(body[pos], pos + 1);
+            if (close == std::string_view::npos) {
+                return false;
+            }
+            std::string value;
+            if (!append_decoded(body.substr(pos + 1, close - pos - 1), value)) {
+                return false;
+            }
+            tag.attributes.emplace_back(std::move(key), std::move(value));
+            pos = close + 1;
+        }
+    }
+
+    /**
+     * @brief Collects components while the document is walked
+     *
+     * Keeps a stack of open elements, each marked when it or an ancestor
+     * carries a translation, and captures the text of the elements that
+     * make up a component.
+     */
+    class ComponentBuilder {
+    public:
+        explicit ComponentBuilder(std::vector<AppstreamComponent>& components)
+            : m_components(components)
+        {
+        }
+
+        void start(const Tag& tag)
+        {
+            std::string lang = tag.attribute("xml:lang");
+            bool translated = (!m_stack.empty() && m_stack.back().translated) || (!lang.empty() && lang != "C");
+            const std::string& parent = m_stack.empty() ? std::string() : m_stack.back().name;
+
+            m_capture = CAPTURE_NONE;
+            if (tag.name == "component" && (parent.empty() || parent == "components")) {
+                m_current = AppstreamComponent();
+                m_bundle_id.clear();
+                m_in_component = true;
+            } else if (m_in_component && !translated) {
+                const std::string& grandparent = m_stack.size() > 1 ? m_stack[m_stack.size() - 2].name : std::string();
+                if (parent == "component") {
+                    if (tag.name == "id") m_capture = CAPTURE_ID;
+                    else if (tag.name == "name" && m_current.name.empty()) m_capture = CAPTURE_NAME;
+                    else if (tag.name == "summary" && m_current.summary.empty()) m_capture = CAPTURE_SUMMARY;
+                    else if (tag.name == "bundle" && tag.attribute("type") == "flatpak") m_capture = CAPTURE_BUNDLE;
+                } else if (grandparent == "component") {
+                    if (tag.name == "keyword" && parent == "keywords") m_capture = CAPTURE_KEYWORD;
+                    else if (tag.name == "category" && parent == "categories") m_capture = CAPTURE_CATEGORY;
+                    else if (tag.name == "release" && parent == "releases" && m_current.version.empty()) {
+                        // Releases are listed newest first
+                        m_current.version = tag.attribute("version");
+                    }
+                }
+            }
+            m_text.clear();
+
+            m_stack.push_back(Element{tag.name, translated, m_capture});
+            if (tag.self_closing) {
+                end();
+            }
+        }
+
+        bool end()
+        {
+            Element element = m_stack.back();
+            m_stack.pop_back();
+
+            std::string text(trim(m_text));
+            switch (element.capture) {
+            case CAPTURE_ID: m_current.id = text; break;
+            case CAPTURE_NAME: m_current.name = text; break;
+            case CAPTURE_SUMMARY: m_current.summary = text; break;
+            case CAPTURE_KEYWORD: if (!text.empty()) m_current.keywords.push_back(text); break;
+            case CAPTURE_CATEGORY: if (!text.empty()) m_current.categories.push_back(text); break;
+            case CAPTURE_BUNDLE: set_bundle(text); break;
+            case CAPTURE_NONE: break;
+            }
+            m_capture = CAPTURE_NONE;
+            m_text.clear();
+
+            if (element.name == "component" && m_in_component &&
+                (m_stack.empty() || m_stack.back().name == "components")) {
+                finish_component();
+            }
+            return true;
+        }
+
+        bool text(std::string_view raw, bool cdata)
+        {
+            if (m_capture == CAPTURE_NONE) {
+                return true;
+            }
+            if (cdata) {
+                m_text.append(raw);
+                return true;
+            }
+            return append_decoded(raw, m_text);
+        }
+
+        const std::string& open_element() const
+        {
+            static const std::string none;
+            return m_stack.empty() ? none : m_stack.back().name;
+        }
+
+        bool has_open_elements() const
+        {
+            return !m_stack.empty();
+        }
+
+    private:
+        enum Capture {
+            CAPTURE_NONE,
+            CAPTURE_ID,
+            CAPTURE_NAME,
+            CAPTURE_SUMMARY,
+            CAPTURE_KEYWORD,
+            CAPTURE_CATEGORY,
+            CAPTURE_BUNDLE
+        };
+
+        struct Element {
+            std::string name;
+            bool translated;
+            Capture capture;
+        };
+
+        // A bundle holds the ref, e.g. app/org.gnome.Calculator/x86_64/stable
+        void set_bundle(const std::string& ref)
+        {
+            size_t first = ref.find('/');
+            size_t second = first == std::string::npos ? first : ref.find('/', first + 1);
+            size_t third = second == std::string::npos ? second : ref.find('/', second + 1);
+            if (third == std::string::npos) {
+                return;
+            }
+            m_bundle_id = ref.substr(first + 1, second - first - 1);
+            m_current.branch = ref.substr(third + 1);
+        }
+
+        void finish_component()
+        {
+            m_in_component = false;
+
+            // Older catalogs give desktop file names as IDs, the bundle has the real one
+            if (!m_bundle_id.empty()) {
+                m_current.id = m_bundle_id;
+            } else if (m_current.id.size() > 8 &&
+                       m_current.id.compare(m_current.id.size() - 8, 8, ".desktop") == 0) {
+                m_current.id.resize(m_current.id.size() - 8);
+            }
+
+            if (!m_current.id.empty() && !m_current.name.empty()) {
+                m_components.push_back(std::move(m_current));
+            }
+            m_current = AppstreamComponent();
+        }
+
+        std::vector<AppstreamComponent>& m_components;
+        std::vector<Element> m_stack;
+        AppstreamComponent m_current;
+        std::string m_bundle_id;
+        std::string m_text;
+        Capture m_capture = CAPTURE_NONE;
+        bool m_in_component = false;
+    };
+}
+
+AppstreamIndex::AppstreamIndex()
+    : m_mapping(nullptr)
+    , m_length(0)
+    , m_records(nullptr)
+    , m_pool(nullptr)
+    , m_count(0)
+    , m_pool_size(0)
+{
+}
+
+AppstreamIndex::~AppstreamIndex()
+{
+    close();
+}
+
+bool AppstreamIndex::read_file(const std::string& path, std::string& xml, std::string& error)
+{
+    // gzread passes files that are not compressed through unchanged
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (!file) {
+        error = "Failed to open " + path;
+        return false;
+    }
+    gzbuffer(file, 128 * 1024);
+
+    xml.clear();
+    char buffer[64 * 1024];
+    int count = 0;
+    while ((count = gzread(file, buffer, sizeof(buffer))) > 0) {
+        xml.append(buffer, static_cast<size_t>(count));
+    }
+
+    int status = Z_OK;
+    const char* message = gzerror(file, &status);
+    bool ok = count == 0 && (status == Z_OK || status == Z_STREAM_END);
+    if (!ok) {
+        error = "Failed to read " + path + ": " + (message ? message : "unknown error");
+    }
+    gzclose(file);
+    return ok;
+}
+
+bool AppstreamIndex::parse(const std::string& xml, std::vector<AppstreamComponent>& components, std::string& error)
+{
+    ComponentBuilder builder(components);
+    std::string_view document(xml);
+    size_t pos = 0;
+
+    while (pos < document.size()) {
+        if (document[pos] != '<') {
+            size_t next = document.find('<', pos);
+            if (next == std::string_view::npos) {
+                next = document.size();
+            }
+            if (!builder.text(document.substr(pos, next - pos), false)) {
+                error = "Bad entity at offset " + std::to_string(pos);
+                return false;
+            }
+            pos = next;
+            continue;
+        }
+
+        std::string_view rest = document.substr(pos);
+        size_t end = std::string_view::npos;
+        if (rest.compare(0, 4, "<!--") == 0) {
+            end = document.find("-->", pos + 4);
+            pos = end == std::string_view::npos ? end : end + 3;
+        } else if (rest.compare(0, 9, "<![CDATA[") == 0) {
+            end = document.find("]]>", pos + 9);
+            if (end != std::string_view::npos) {
+                builder.text(document.substr(pos + 9, end - pos - 9), true);
+            }
+            pos = end == std::string_view::npos ? end : end + 3;
+        } else if (rest.compare(0, 2, "<?") == 0) {
+            end = document.find("?>", pos + 2);
+            pos = end == std::string_view::npos ? end : end + 2;
+        } else if (rest.compare(0, 2, "<!") == 0) {
+            end = document.find('>', pos + 2);
+            pos = end == std::string_view::npos ? end : end + 1;
+        } else if (rest.compare(0, 2, "</") == 0) {
+            end = document.find('>', pos + 2);
+            if (end != std::string_view::npos) {
+                std::string_view name = trim(document.substr(pos + 2, end - pos - 2));
+                if (!builder.has_open_elements() || name != builder.open_element()) {
+                    error = "Unexpected </" + std::string(name) + "> at offset " + std::to_string(pos);
+                    return false;
+                }
+                builder.end();
+                pos = end + 1;
+            }
+        } else {
+            // Attribute values may contain '>'
+            char quote = 0;
+            for (size_t i = pos + 1; i < document.size(); ++i) {
+                char c = document[i];
+                if (quote) {
+                    if (c == quote) quote = 0;
+                } else if (c == '"' || c == '\'') {
+                    quote = c;
+                } else if (c == '>') {
+                    end = i;
+                    break;
+                }
+            }
+            if (end != std::string_view::npos) {
+                Tag tag;
+                if (!parse_tag(document.substr(pos + 1, end - pos - 1), tag)) {
+                    error = "Malformed tag at offset " + std::to_string(pos);
+                    return false;
+                }
+                builder.start(tag);
+                pos = end + 1;
+            }
+        }
+
+        if (end == std::string_view::npos) {
+            error = "Unterminated markup at offset " + std::to_string(document.size() - rest.size());
+            return false;
+        }
+    }
+
+    if (builder.has_open_elements()) {
+        error = "Unclosed <" + builder.open_element() + "> at end of document";
+        return false;
+    }
+    return true;
+}
+
+bool AppstreamIndex::write(const std::string& path, const std::string& checksum,
+                           const std::vector<AppstreamComponent>& components, std::string& error)
+{
+    // Summary and keywords are pooled back to back, so the search text of
+    // a component is one view from the start of one to the end of the other
+    std::string pool;
+    std::string records;
+    for (const AppstreamComponent& component : components) {
+        std::string keywords = join(component.keywords);
+        std::string categories = join(component.categories);
+        const std::string* fields[kFieldCount] = {};
+        fields[ID] = &component.id;
+        fields[NAME] = &component.name;
+        fields[SUMMARY] = &component.summary;
+        fields[KEYWORDS] = &keywords;
+        fields[BRANCH] = &component.branch;
+        fields[VERSION] = &component.version;
+        fields[CATEGORIES] = &categories;
+
+        Record record;
+        for (int field : {ID, NAME, SUMMARY, KEYWORDS, BRANCH, VERSION, CATEGORIES}) {
+            record.offset[field] = static_cast<uint32_t>(pool.size());
+            record.length[field] = static_cast<uint32_t>(fields[field]->size());
+            pool += *fields[field];
+            if (field == SUMMARY) {
+                pool += '\n';
+            }
+        }
+        records.append(reinterpret_cast<const char*>(&record), sizeof(record));
+
+        if (pool.size() > UINT32_MAX) {
+            error = "Appstream catalog is too large to index";
+            return false;
+        }
+    }
+
+    std::string body;
+    append<uint32_t>(body, static_cast<uint32_t>(checksum.size()));
+    body.append(checksum);
+    append<uint32_t>(body, static_cast<uint32_t>(components.size()));
+    append<uint32_t>(body, static_cast<uint32_t>(pool.size()));
+
+    std::string header(kMagic, sizeof(kMagic));
+    append<uint32_t>(header, kFormatVersion);
+    append<uint64_t>(header, static_cast<uint64_t>(body.size() + records.size() + pool.size()));
+
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0 && !make_directories(path.substr(0, slash))) {
+        error = "Failed to create " + path.substr(0, slash) + ": " + strerror(errno);
+        return false;
+    }
+
+    // Write a temporary file and rename it, so readers never map half an index
+    std::string temporary = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        error = "Failed to create " + temporary + ": " + strerror(errno);
+        return false;
+    }
+
+    bool written = true;
+    for (const std::string* part : {&header, &body, &records, &pool}) {
+        const char* data = part->data();
+        size_t remaining = part->size();
+        while (written && remaining > 0) {
+            ssize_t count = ::write(fd, data, remaining);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            written = count > 0;
+            if (written) {
+                data += count;
+                remaining -= static_cast<size_t>(count);
+            }
+        }
+    }
+
+    if (::close(fd) != 0 || !written) {
+        error = "Failed to write " + temporary + ": " + strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "Failed to replace " + path + ": " + strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AppstreamIndex::open(const std::string& path)
+{
+    close();
+    m_last_error.clear();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        m_last_error = "No index at " + path;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        m_last_error = "Empty index at " + path;
+        ::close(fd);
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        m_last_error = std::string("Failed to map index: ") + strerror(errno);
+        return false;
+    }
+
+    const char* cursor = static_cast<const char*>(mapping);
+    const char* end = cursor + length;
+    uint32_t version = 0;
+    uint64_t payload = 0;
+    uint32_t checksum_length = 0;
+    bool valid = length >= sizeof(kMagic) && memcmp(cursor, kMagic, sizeof(kMagic)) == 0;
+    if (valid) {
+        cursor += sizeof(kMagic);
+        valid = read(cursor, end, version) && version == kFormatVersion &&
+                read(cursor, end, payload) && payload == static_cast<uint64_t>(end - cursor) &&
+                read(cursor, end, checksum_length) && static_cast<size_t>(end - cursor) >= checksum_length;
+    }
+    if (valid) {
+        m_checksum.assign(cursor, checksum_length);
+        cursor += checksum_length;
+        valid = read(cursor, end, m_count) && read(cursor, end, m_pool_size) &&
+                static_cast<uint64_t>(end - cursor) == static_cast<uint64_t>(m_count) * sizeof(Record) + m_pool_size;
+    }
+    if (!valid) {
+        m_last_error = "Index at " + path + " has an unknown format";
+        m_checksum.clear();
+        munmap(mapping, length);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_length = length;
+    m_records = cursor;
+    m_pool = cursor + static_cast<size_t>(m_count) * sizeof(Record);
+
+    // Checked once here, so lookups can trust the offsets
+    for (size_t i = 0; i < m_count; ++i) {
+        Record current = record(i);
+        for (int field = 0; field < kFieldCount; ++field) {
+            if (static_cast<uint64_t>(current.offset[field]) + current.length[field] > m_pool_size) {
+                m_last_error = "Index at " + path + " is damaged";
+                close();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void AppstreamIndex::close()
+{
+    if (m_mapping) {
+        munmap(m_mapping, m_length);
+    }
+    m_mapping = nullptr;
+    m_length = 0;
+    m_records = nullptr;
+    m_pool = nullptr;
+    m_count = 0;
+    m_pool_size = 0;
+    m_checksum.clear();
+}
+
+bool AppstreamIndex::is_open() const
+{
+    return m_mapping != nullptr;
+}
+
+const std::string& AppstreamIndex::get_checksum() const
+{
+    return m_checksum;
+}
+
+size_t AppstreamIndex::size() const
+{
+    return m_count;
+}
+
+AppstreamEntry AppstreamIndex::at(size_t index) const
+{
+    Record current = record(index);
+    AppstreamEntry entry;
+    entry.id = field(current, ID);
+    entry.name = field(current, NAME);
+    entry.summary = field(current, SUMMARY);
+    entry.branch = field(current, BRANCH);
+    entry.version = field(current, VERSION);
+    entry.keywords = field(current, KEYWORDS);
+    entry.categories = field(current, CATEGORIES);
+    return entry;
+}
+
+std::vector<FuzzyMatch> AppstreamIndex::search(const FuzzyMatcher& matcher, size_t limit,
+                                               const std::atomic<bool>* cancelled) const
+{
+    std::vector<FuzzyMatch> matches;
+    FuzzyMatch by_name;
+    FuzzyMatch by_id;
+
+    for (size_t i = 0; i < m_count; ++i) {
+        if (i % kCancelCheckInterval == 0 && cancelled && cancelled->load(std::memory_order_relaxed)) {
+            return {};
+        }
+
+        Record current = record(i);
+        std::string_view text = field(current, SUMMARY);
+        if (current.offset[KEYWORDS] >= current.offset[SUMMARY]) {
+            text = std::string_view(m_pool + current.offset[SUMMARY],
+                                    current.offset[KEYWORDS] + current.length[KEYWORDS] - current.offset[SUMMARY]);
+        }
+
+        bool found = matcher.match(field(current, NAME), text, by_name);
+        if (matcher.match(field(current, ID), text, by_id) && (!found || by_id.score > by_name.score)) {
+            by_name = by_id;
+            found = true;
+        }
+        if (found) {
+            by_name.index = i;
+            matches.push_back(by_name);
+        }
+    }
+
+    if (limit > 0 && matches.size() > limit) {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), FuzzyMatcher::better);
+        matches.resize(limit);
+    } else {
+        std::sort(matches.begin(), matches.end(), FuzzyMatcher::better);
+    }
+    return matches;
+}
+
+std::string AppstreamIndex::get_last_error() const
+{
+    return m_last_error;
+}
+
+std::string_view AppstreamIndex::field(const Record& record, int number) const
+{
+    return std::string_view(m_pool + record.offset[number], record.length[number]);
+}
+
+AppstreamIndex::Record AppstreamIndex::record(size_t index) const
+{
+    Record current;
+    memcpy(&current, m_records + index * sizeof(Record), sizeof(Record));
+    return current;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,569 @@
+#include "core/aur_build_cache.hpp"
+#include "core/sha256.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    // Changing what goes into a key invalidates every entry
+    const char* const kKeyVersion = "pacmangui-aur-build-cache 1\n";
+
+    // Source protocols whose content is not pinned by a checksum
+    const char* const kVcsProtocols[] = {"bzr", "fossil", "git", "hg", "svn"};
+
+    bool make_directories(const std::string& path)
+    {
+        for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+            std::string dir = path.substr(0, slash);
+            if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+            if (slash == std::string::npos) {
+                return true;
+            }
+        }
+    }
+
+    bool is_file(const std::string& path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+    }
+
+    bool is_key(const std::string& name)
+    {
+        return name.size() == 64 && name.find_first_not_of("0123456789abcdef") == std::string::npos;
+    }
+
+    std::vector<std::string> read_directory(DIR* dir)
+    {
+        std::vector<std::string> names;
+        if (!dir) {
+            return names;
+        }
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    std::vector<std::string> list_directory(const std::string& path)
+    {
+        return read_directory(opendir(path.c_str()));
+    }
+
+    // The listing gets its own descriptor, closedir() closes it
+    std::vector<std::string> list_directory_at(int dir_fd)
+    {
+        int fd = fcntl(dir_fd, F_DUPFD_CLOEXEC, 0);
+        DIR* dir = fd >= 0 ? fdopendir(fd) : nullptr;
+        if (fd >= 0 && !dir) {
+            close(fd);
+        }
+        return read_directory(dir);
+    }
+
+    // Shared entries and files: only the trusted owner may have written them
+    bool owned_by(const struct stat& info, uid_t owner)
+    {
+        return info.st_uid == owner && !(info.st_mode & (S_IWGRP | S_IWOTH));
+    }
+
+    // Parents of the shared directory: nobody else may rename or replace what is in them
+    bool parent_owned_by(const struct stat& info, uid_t owner)
+    {
+        return (info.st_uid == 0 || info.st_uid == owner) &&
+               (!(info.st_mode & (S_IWGRP | S_IWOTH)) || (info.st_mode & S_ISVTX));
+    }
+
+    bool copy_file(const std::string& source, const std::string& destination)
+    {
+        int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            return false;
+        }
+        int out = open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out < 0) {
+            close(in);
+            return false;
+        }
+
+        char buffer[65536];
+        bool ok = true;
+        ssize_t n;
+        while (ok && (n = read(in, buffer, sizeof(buffer))) != 0) {
+            if (n < 0) {
+                ok = errno == EINTR;
+                continue;
+            }
+            for (ssize_t written = 0; ok && written < n;) {
+                ssize_t w = write(out, buffer + written, n - written);
+                if (w < 0) {
+                    ok = errno == EINTR;
+                } else {
+                    written += w;
+                }
+            }
+        }
+        close(in);
+        ok = close(out) == 0 && ok;
+        return ok;
+    }
+
+    bool remove_entry(const std::string& path)
+    {
+        DIR* dir = opendir(path.c_str());
+        if (dir) {
+            while (dirent* entry = readdir(dir)) {
+                if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                    unlink((path + "/" + entry->d_name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+        return rmdir(path.c_str()) == 0;
+    }
+
+    // Adds "<label> <sha256 of the file>" so neither name nor content can run into the next file
+    void hash_input(Sha256& sha, const std::string& label, const std::string& path)
+    {
+        Sha256 file;
+        std::string digest = file.update_file(path) ? file.hex_digest() : "missing";
+        sha.update(label + " " + digest + "\n");
+    }
+}
+
+AurBuildCache::AurBuildCache(const std::string& directory)
+    : m_directory(directory)
+    , m_shared_owner(0)
+    , m_config_files(default_config_files())
+{
+}
+
+std::string AurBuildCache::default_directory()
+{
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home && cache_home[0] == '/') {
+        return std::string(cache_home) + "/pacmangui/aur-packages";
+    }
+
+    const char* home = getenv("HOME");
+    if (home && home[0] == '/') {
+        return std::string(home) + "/.cache/pacmangui/aur-packages";
+    }
+    return "";
+}
+
+std::vector<std::string> AurBuildCache::default_config_files()
+{
+    // The same files makepkg reads, in the same order
+    std::vector<std::string> files;
+    const char* makepkg_conf = getenv("MAKEPKG_CONF");
+    std::string system_conf = makepkg_conf && makepkg_conf[0] == '/' ? makepkg_conf : "/etc/makepkg.conf";
+    files.push_back(system_conf);
+    for (const auto& name : list_directory(system_conf + ".d")) {
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".conf") == 0) {
+            files.push_back(system_conf + ".d/" + name);
+        }
+    }
+
+    const char* config_home = getenv("XDG_CONFIG_HOME");
+    const char* home = getenv("HOME");
+    if (config_home && config_home[0] == '/') {
+        files.push_back(std::string(config_home) + "/pacman/makepkg.conf");
+    } else if (home && home[0] == '/') {
+        files.push_back(std::string(home) + "/.config/pacman/makepkg.conf");
+    }
+    if (home && home[0] == '/') {
+        files.push_back(std::string(home) + "/.makepkg.conf");
+    }
+
+    files.erase(std::remove_if(files.begin(), files.end(), [](const std::string& file) {
+        return !is_file(file);
+    }), files.end());
+    return files;
+}
+
+std::string AurBuildCache::package_name(const std::string& path)
+{
+    std::string filename = path.substr(path.find_last_of('/') + 1);
+    size_t end = filename.find(".pkg.tar");
+    if (end == std::string::npos) {
+        return "";
+    }
+    // Strip pkgver, pkgrel and arch, none of which contain a dash
+    for (int field = 0; field < 3; ++field) {
+        end = filename.rfind('-', end - 1);
+        if (end == std::string::npos || end == 0) {
+            return "";
+        }
+    }
+    return filename.substr(0, end);
+}
+
+const std::string& AurBuildCache::get_directory() const
+{
+    return m_directory;
+}
+
+void AurBuildCache::set_shared_directory(const std::string& directory, uid_t trusted_owner)
+{
+    m_shared_directory = directory;
+    m_shared_owner = trusted_owner;
+}
+
+const std::string& AurBuildCache::get_shared_directory() const
+{
+    return m_shared_directory;
+}
+
+void AurBuildCache::set_config_files(const std::vector<std::string>& files)
+{
+    m_config_files = files;
+}
+
+bool AurBuildCache::compute_key(const std::string& checkout, std::string& key)
+{
+    key.clear();
+    std::ifstream srcinfo(checkout + "/.SRCINFO");
+    if (!srcinfo || !is_file(checkout + "/PKGBUILD")) {
+        set_last_error("No PKGBUILD and .SRCINFO in " + checkout);
+        return false;
+    }
+
+    // Downloaded sources are pinned by their checksums in .SRCINFO, local ones are hashed here
+    std::set<std::string> local_files;
+    for (std::string line; std::getline(srcinfo, line);) {
+        size_t start = line.find_first_not_of(" \t");
+        size_t equals = line.find(" = ");
+        if (start == std::string::npos || equals == std::string::npos || equals < start) {
+            continue;
+        }
+        std::string field = line.substr(start, equals - start);
+        std::string value = line.substr(equals + 3);
+
+        if (field == "install" || field == "changelog") {
+            local_files.insert(value.substr(value.find_last_of('/') + 1));
+            continue;
+        }
+        if (field != "source" && field.compare(0, 7, "source_") != 0) {
+            continue;
+        }
+
+        size_t rename = value.find("::");
+        std::string location = rename == std::string::npos ? value : value.substr(rename + 2);
+        size_t scheme_end = location.find("://");
+        if (scheme_end == std::string::npos) {
+            local_files.insert(location.substr(location.find_last_of('/') + 1));
+            continue;
+        }
+
+        std::string protocol = location.substr(0, std::min(location.find('+'), scheme_end));
+        for (const char* vcs : kVcsProtocols) {
+            if (protocol == vcs) {
+                // Not an error, so not logged
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_last_error = "VCS sources are built from upstream and not cached";
+                return false;
+            }
+        }
+    }
+
+    Sha256 sha;
+    sha.update(kKeyVersion);
+    hash_input(sha, "PKGBUILD", checkout + "/PKGBUILD");
+    hash_input(sha, ".SRCINFO", checkout + "/.SRCINFO");
+    for (const auto& file : local_files) {
+        hash_input(sha, "source:" + file, checkout + "/" + file);
+    }
+    for (const auto& file : m_config_files) {
+        hash_input(sha, "config:" + file, file);
+    }
+
+    key = sha.hex_digest();
+    set_last_error("");
+    return true;
+}
+
+bool AurBuildCache::lookup(const std::string& key, const std::vector<std::string>& packages,
+                           std::vector<std::string>& files)
+{
+    if (lookup_in(m_directory, key, packages, files)) {
+        return true;
+    }
+    if (m_shared_directory.empty()) {
+        return false;
+    }
+
+    int shared_fd = open_shared_directory();
+    if (shared_fd < 0) {
+        return false;
+    }
+    bool found = lookup_shared(shared_fd, key, packages, files);
+    close(shared_fd);
+    return found;
+}
+
+bool AurBuildCache::store(const std::string& key, const std::vector<std::string>& files)
+{
+    if (!store_in(m_directory, key, files)) {
+        return false;
+    }
+    // Entries there have to belong to the trusted owner, so other users only read it.
+    // Somebody else's disk, a failure there is logged but does not matter for this build.
+    if (!m_shared_directory.empty() && geteuid() == m_shared_owner) {
+        int shared_fd = open_shared_directory();
+        if (shared_fd >= 0) {
+            store_in(m_shared_directory, key, files);
+            close(shared_fd);
+        }
+    }
+    set_last_error("");
+    return true;
+}
+
+std::vector<AurCacheEntry> AurBuildCache::get_entries() const
+{
+    std::vector<AurCacheEntry> entries;
+    for (const auto& name : list_directory(m_directory)) {
+        AurCacheEntry entry;
+        entry.key = name;
+        entry.path = m_directory + "/" + name;
+
+        struct stat info;
+        if (!is_key(name) || stat(entry.path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+            continue;
+        }
+        entry.last_used = info.st_mtime;
+        for (const auto& file : list_directory(entry.path)) {
+            if (stat((entry.path + "/" + file).c_str(), &info) == 0) {
+                entry.size += info.st_size;
+            }
+        }
+        entries.push_back(std::move(entry));
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const AurCacheEntry& a, const AurCacheEntry& b) {
+        return a.last_used < b.last_used;
+    });
+    return entries;
+}
+
+size_t AurBuildCache::prune(uint64_t max_bytes, time_t max_age)
+{
+    std::vector<AurCacheEntry> entries = get_entries();
+    uint64_t total = 0;
+    for (const auto& entry : entries) {
+        total += entry.size;
+    }
+
+    time_t now = time(nullptr);
+    size_t removed = 0;
+    for (const auto& entry : entries) {
+        bool expired = max_age > 0 && now - entry.last_used > max_age;
+        bool too_big = max_bytes > 0 && total > max_bytes;
+        if (!expired && !too_big) {
+            continue;
+        }
+        if (remove_entry(entry.path)) {
+            total -= entry.size;
+            removed++;
+        } else {
+            std::cerr << "AurBuildCache: Failed to remove " << entry.path << ": " << strerror(errno) << std::endl;
+        }
+    }
+
+    if (removed > 0) {
+        std::cout << "AurBuildCache: Removed " << removed << " cached builds, " << total << " bytes left"
+                  << std::endl;
+    }
+    return removed;
+}
+
+std::string AurBuildCache::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_error;
+}
+
+bool AurBuildCache::lookup_in(const std::string& directory, const std::string& key,
+                              const std::vector<std::string>& packages, std::vector<std::string>& files)
+{
+    if (directory.empty() || !is_key(key)) {
+        return false;
+    }
+
+    std::string entry = directory + "/" + key;
+    std::vector<std::string> names = list_directory(entry);
+    std::vector<std::string> found;
+    for (const auto& package : packages) {
+        auto it = std::find_if(names.begin(), names.end(), [&package](const std::string& name) {
+            return package_name(name) == package;
+        });
+        if (it == names.end() || !is_file(entry + "/" + *it)) {
+            return false;
+        }
+        found.push_back(entry + "/" + *it);
+    }
+
+    // The modification time of the entry records when it was last used, for prune()
+    utimensat(AT_FDCWD, entry.c_str(), nullptr, 0);
+    files = std::move(found);
+    return true;
+}
+
+bool AurBuildCache::store_in(const std::string& directory, const std::string& key,
+                             const std::vector<std::string>& files)
+{
+    if (directory.empty() || !is_key(key)) {
+        set_last_error("Invalid cache directory or key");
+        return false;
+    }
+
+    std::string entry = directory + "/" + key;
+    if (!make_directories(entry)) {
+        set_last_error("Failed to create " + entry + ": " + strerror(errno));
+        return false;
+    }
+
+    // Copies are renamed into place so a lookup never sees half a package
+    for (const auto& file : files) {
+        std::string filename = file.substr(file.find_last_of('/') + 1);
+        std::string partial = entry + "/." + filename + ".part";
+        if (!copy_file(file, partial) || rename(partial.c_str(), (entry + "/" + filename).c_str()) != 0) {
+            int saved_errno = errno;
+            unlink(partial.c_str());
+            set_last_error("Failed to copy " + file + " to " + entry + ": " + strerror(saved_errno));
+            return false;
+        }
+    }
+
+    utimensat(AT_FDCWD, entry.c_str(), nullptr, 0);
+    return true;
+}
+
+bool AurBuildCache::lookup_shared(int shared_fd, const std::string& key, const std::vector<std::string>& packages,
+                                  std::vector<std::string>& files)
+{
+    if (!is_key(key)) {
+        return false;
+    }
+
+    // Anyone who could write an entry could plant a package under a valid key
+    std::string entry = m_shared_directory + "/" + key;
+    int entry_fd = openat(shared_fd, key.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (entry_fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(entry_fd, &info) != 0 || !owned_by(info, m_shared_owner)) {
+        set_last_error("Not using the shared cache, " + entry + " is writable by users other than " +
+                       std::to_string(m_shared_owner));
+        close(entry_fd);
+        return false;
+    }
+
+    std::vector<std::string> names = list_directory_at(entry_fd);
+    std::vector<std::string> found;
+    for (const auto& package : packages) {
+        auto it = std::find_if(names.begin(), names.end(), [&package](const std::string& name) {
+            return package_name(name) == package;
+        });
+        if (it == names.end() || fstatat(entry_fd, it->c_str(), &info, AT_SYMLINK_NOFOLLOW) != 0 ||
+            !S_ISREG(info.st_mode)) {
+            close(entry_fd);
+            return false;
+        }
+        if (!owned_by(info, m_shared_owner)) {
+            set_last_error("Not using the shared cache, " + entry + "/" + *it + " is writable by users other than " +
+                           std::to_string(m_shared_owner));
+            close(entry_fd);
+            return false;
+        }
+        found.push_back(entry + "/" + *it);
+    }
+
+    futimens(entry_fd, nullptr);
+    close(entry_fd);
+    files = std::move(found);
+    return true;
+}
+
+int AurBuildCache::open_shared_directory()
+{
+    if (m_shared_directory.empty() || m_shared_directory[0] != '/') {
+        set_last_error("Not using the shared cache, " + m_shared_directory + " is not an absolute path");
+        return -1;
+    }
+
+    std::vector<std::string> components;
+    for (size_t start = 1; start <= m_shared_directory.size();) {
+        size_t slash = std::min(m_shared_directory.find('/', start), m_shared_directory.size());
+        std::string name = m_shared_directory.substr(start, slash - start);
+        if (name == "..") {
+            set_last_error("Not using the shared cache, " + m_shared_directory + " contains ..");
+            return -1;
+        }
+        if (!name.empty() && name != ".") {
+            components.push_back(name);
+        }
+        start = slash + 1;
+    }
+
+    // Walked from the root, so neither a symbolic link nor a swapped parent can redirect it
+    std::string path = "/";
+    int fd = open("/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    for (size_t i = 0; ; ++i) {
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            set_last_error("Not using the shared cache, " + path + ": " + strerror(errno));
+            if (fd >= 0) {
+                close(fd);
+            }
+            return -1;
+        }
+
+        bool last = i == components.size();
+        if (!(last ? owned_by(info, m_shared_owner) : parent_owned_by(info, m_shared_owner))) {
+            set_last_error("Not using the shared cache, " + path + " is writable by users other than " +
+                           (last ? std::to_string(m_shared_owner) : "root and " + std::to_string(m_shared_owner)));
+            close(fd);
+            return -1;
+        }
+        if (last) {
+            return fd;
+        }
+
+        int next = openat(fd, components[i].c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        close(fd);
+        fd = next;
+        path += (path.size() > 1 ? "/" : "") + components[i];
+    }
+}
+
+void AurBuildCache::set_last_error(const std::string& error)
+{
+    if (!error.empty()) {
+        std::cerr << "AurBuildCache: " << error << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_last_error = error;
+}
+
+} // namespace core
+} // namespace pacmangui
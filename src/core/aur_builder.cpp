@@ -0,0 +1,672 @@
+#include "core/aur_builder.hpp"
+#include "core/aur_build_cache.hpp"
+#include "core/process_runner.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    enum class BuildState {
+        PENDING,
+        BUILDING,
+        BUILT,
+        INSTALLED,
+        FAILED
+    };
+
+    // "python>=3.11" -> "python"
+    std::string dependency_name(const std::string& depend)
+    {
+        return depend.substr(0, depend.find_first_of("<>="));
+    }
+
+    bool make_directories(const std::string& path)
+    {
+        for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+            std::string dir = path.substr(0, slash);
+            if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+                return false;
+            }
+            if (slash == std::string::npos) {
+                return true;
+            }
+        }
+    }
+
+    bool is_directory(const std::string& path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+
+    bool is_file(const std::string& path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+    }
+
+    std::string join(const std::vector<std::string>& items)
+    {
+        std::string joined;
+        for (const auto& item : items) {
+            joined += (joined.empty() ? "" : ", ") + item;
+        }
+        return joined;
+    }
+}
+
+AurBuilder::AurBuilder(AurClient& client, const std::string& build_dir)
+    : m_client(client)
+    , m_build_dir(build_dir)
+    , m_git_url(kGitUrl)
+    , m_makepkg("makepkg")
+    , m_jobs(0)
+    , m_cache(nullptr)
+    , m_cancelled(false)
+{
+    set_jobs(0);
+}
+
+AurBuilder::~AurBuilder()
+{
+}
+
+std::string AurBuilder::default_build_dir()
+{
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home && cache_home[0] == '/') {
+        return std::string(cache_home) + "/pacmangui/aur";
+    }
+
+    const char* home = getenv("HOME");
+    if (home && home[0] == '/') {
+        return std::string(home) + "/.cache/pacmangui/aur";
+    }
+    return "";
+}
+
+const std::string& AurBuilder::get_build_dir() const
+{
+    return m_build_dir;
+}
+
+void AurBuilder::set_jobs(size_t jobs)
+{
+    // makepkg builds are usually parallel themselves, so only use half the CPUs by default
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+    m_jobs = jobs;
+}
+
+size_t AurBuilder::get_jobs() const
+{
+    return m_jobs;
+}
+
+void AurBuilder::set_git_url(const std::string& url)
+{
+    m_git_url = url;
+}
+
+void AurBuilder::set_makepkg(const std::string& program)
+{
+    m_makepkg = program;
+}
+
+void AurBuilder::set_cache(AurBuildCache* cache)
+{
+    m_cache = cache;
+}
+
+void AurBuilder::set_output_callback(std::function<void(const std::string&)> callback)
+{
+    m_output_callback = std::move(callback);
+}
+
+bool AurBuilder::resolve(const std::vector<std::string>& names, const AurDependencyResolver& resolver,
+                         AurBuildPlan& plan)
+{
+    plan = AurBuildPlan();
+
+    std::map<std::string, AurPackage> found;                    // By package name
+    std::vector<std::string> found_order;                      // Discovery order
+    std::map<std::string, std::vector<std::string>> needs;     // Package -> AUR dependency names
+    std::map<std::string, std::string> required_by;            // AUR dependency name -> first dependent
+    std::set<std::string> queried;
+    std::set<std::string> repo_dependencies;
+    std::set<std::string> requested(names.begin(), names.end());
+
+    auto provider = [&found](const std::string& name) -> const AurPackage* {
+        auto it = found.find(name);
+        if (it != found.end()) {
+            return &it->second;
+        }
+        for (const auto& entry : found) {
+            for (const auto& provide : entry.second.provides) {
+                if (dependency_name(provide) == name) {
+                    return &entry.second;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    std::vector<std::string> pending;
+    for (const auto& name : names) {
+        if (queried.insert(name).second) {
+            pending.push_back(name);
+        }
+    }
+
+    // One info request per level of the dependency graph
+    while (!pending.empty()) {
+        std::vector<AurPackage> results;
+        if (!m_client.info(pending, results)) {
+            set_last_error("Failed to look up AUR packages: " + m_client.get_last_error());
+            return false;
+        }
+
+        std::vector<std::string> round;
+        for (auto& package : results) {
+            if (found.count(package.name) == 0) {
+                round.push_back(package.name);
+                found_order.push_back(package.name);
+                found[package.name] = std::move(package);
+            }
+        }
+
+        for (const auto& name : pending) {
+            if (provider(name)) {
+                continue;
+            }
+            if (requested.count(name)) {
+                set_last_error("Package not found in the AUR: " + name);
+            } else {
+                set_last_error("Dependency " + name + " of " + required_by[name] +
+                               " was not found in the repositories or the AUR");
+            }
+            return false;
+        }
+
+        std::vector<std::string> next;
+        for (const auto& name : round) {
+            const AurPackage& package = found[name];
+            std::vector<std::string> depends = package.depends;
+            depends.insert(depends.end(), package.make_depends.begin(), package.make_depends.end());
+            depends.insert(depends.end(), package.check_depends.begin(), package.check_depends.end());
+
+            for (const auto& depend : depends) {
+                std::string depend_name = dependency_name(depend);
+                if (depend_name.empty()) {
+                    continue;
+                }
+                // Packages that are part of the build are always built, even if installed
+                if (provider(depend_name) || queried.count(depend_name)) {
+                    needs[name].push_back(depend_name);
+                    continue;
+                }
+
+                switch (resolver(depend)) {
+                    case AurDependencyState::INSTALLED:
+                        break;
+                    case AurDependencyState::REPOSITORY:
+                        // The sync databases only carry one version, so the name is enough
+                        if (repo_dependencies.insert(depend_name).second) {
+                            plan.repo_dependencies.push_back(depend_name);
+                        }
+                        break;
+                    case AurDependencyState::MISSING:
+                        queried.insert(depend_name);
+                        next.push_back(depend_name);
+                        required_by[depend_name] = name;
+                        needs[name].push_back(depend_name);
+                        break;
+                }
+            }
+        }
+        pending = std::move(next);
+    }
+
+    // Group the packages by base, split packages are built together
+    std::map<std::string, size_t> base_index;
+    for (const auto& name : found_order) {
+        const AurPackage& package = found[name];
+        std::string base = package.package_base.empty() ? package.name : package.package_base;
+
+        // The base names the checkout directory
+        if (base.empty() || base[0] == '.' || base.find('/') != std::string::npos) {
+            set_last_error("Invalid package base in the AUR response: " + base);
+            return false;
+        }
+
+        auto it = base_index.find(base);
+        if (it == base_index.end()) {
+            it = base_index.emplace(base, plan.targets.size()).first;
+            AurBuildTarget target;
+            target.base = base;
+            target.version = package.version;
+            target.dependency = true;
+            plan.targets.push_back(std::move(target));
+        }
+        AurBuildTarget& target = plan.targets[it->second];
+        target.packages.push_back(package.name);
+        if (requested.count(package.name)) {
+            target.dependency = false;
+        }
+    }
+
+    for (const auto& entry : needs) {
+        const AurPackage& package = found[entry.first];
+        AurBuildTarget& target = plan.targets[base_index[package.package_base.empty() ? package.name
+                                                                                      : package.package_base]];
+        for (const auto& depend_name : entry.second) {
+            const AurPackage* dependency = provider(depend_name);
+            if (!dependency) {
+                continue;
+            }
+            std::string base = dependency->package_base.empty() ? dependency->name : dependency->package_base;
+            if (base != target.base &&
+                std::find(target.depends_on.begin(), target.depends_on.end(), base) == target.depends_on.end()) {
+                target.depends_on.push_back(base);
+            }
+        }
+    }
+
+    std::string error;
+    if (!order(plan.targets, error)) {
+        set_last_error(error);
+        return false;
+    }
+
+    set_last_error("");
+    return true;
+}
+
+bool AurBuilder::order(std::vector<AurBuildTarget>& targets, std::string& error)
+{
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        index[targets[i].base] = i;
+    }
+
+    // Kahn's algorithm, always taking the first ready base to keep the given order
+    std::vector<size_t> remaining(targets.size(), 0);
+    std::vector<std::vector<size_t>> dependents(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        for (const auto& base : targets[i].depends_on) {
+            auto it = index.find(base);
+            if (it != index.end() && it->second != i) {
+                dependents[it->second].push_back(i);
+                remaining[i]++;
+            }
+        }
+    }
+
+    std::vector<size_t> sorted;
+    std::vector<bool> done(targets.size(), false);
+    sorted.reserve(targets.size());
+    while (sorted.size() < targets.size()) {
+        size_t next = targets.size();
+        for (size_t i = 0; i < targets.size(); ++i) {
+            if (!done[i] && remaining[i] == 0) {
+                next = i;
+                break;
+            }
+        }
+        if (next == targets.size()) {
+            std::vector<std::string> cycle;
+            for (size_t i = 0; i < targets.size(); ++i) {
+                if (!done[i]) {
+                    cycle.push_back(targets[i].base);
+                }
+            }
+            error = "Dependency cycle between AUR packages: " + join(cycle);
+            return false;
+        }
+        done[next] = true;
+        sorted.push_back(next);
+        for (size_t dependent : dependents[next]) {
+            remaining[dependent]--;
+        }
+    }
+
+    std::vector<AurBuildTarget> ordered;
+    ordered.reserve(targets.size());
+    for (size_t i : sorted) {
+        ordered.push_back(std::move(targets[i]));
+    }
+    targets = std::move(ordered);
+    return true;
+}
+
+bool AurBuilder::build(const AurBuildPlan& plan, const RepoInstallCallback& install_repo,
+                       const FileInstallCallback& install_files)
+{
+    m_cancelled = false;
+    const std::vector<AurBuildTarget>& targets = plan.targets;
+    if (targets.empty()) {
+        set_last_error("");
+        return true;
+    }
+
+    if (m_build_dir.empty() || !make_directories(m_build_dir)) {
+        set_last_error("Failed to create build directory " + m_build_dir + ": " + strerror(errno));
+        return false;
+    }
+
+    // makepkg only checks build dependencies, it cannot install them without a terminal for sudo
+    if (!plan.repo_dependencies.empty()) {
+        emit("", "Installing " + std::to_string(plan.repo_dependencies.size()) + " dependencies from the repositories");
+        if (!install_repo(plan.repo_dependencies)) {
+            set_last_error("Failed to install dependencies from the repositories");
+            return false;
+        }
+    }
+
+    // Clones are independent of each other and mostly wait for the network
+    std::vector<std::string> fetch_errors(targets.size());
+    ThreadPool::shared().parallel_for(targets.size(), [&](size_t i) {
+        fetch(targets[i].base, fetch_errors[i]);
+    });
+    std::vector<std::string> errors;
+    for (const auto& error : fetch_errors) {
+        if (!error.empty()) {
+            errors.push_back(error);
+        }
+    }
+    if (!errors.empty() || m_cancelled) {
+        set_last_error(m_cancelled ? "Build cancelled" : join(errors));
+        return false;
+    }
+
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        index[targets[i].base] = i;
+    }
+    std::vector<std::vector<size_t>> depends_on(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        for (const auto& base : targets[i].depends_on) {
+            auto it = index.find(base);
+            if (it != index.end()) {
+                depends_on[i].push_back(it->second);
+            }
+        }
+    }
+
+    std::vector<BuildState> states(targets.size(), BuildState::PENDING);
+    std::vector<std::vector<std::string>> files(targets.size());
+
+    // A base built before from the same PKGBUILD and configuration is not built again
+    std::vector<std::string> keys(targets.size());
+    if (m_cache) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            if (!m_cache->compute_key(m_build_dir + "/" + targets[i].base, keys[i])) {
+                emit(targets[i].base, "Not using the build cache: " + m_cache->get_last_error());
+            } else if (m_cache->lookup(keys[i], targets[i].packages, files[i])) {
+                states[i] = BuildState::BUILT;
+                emit(targets[i].base, "Using cached build of " + join(targets[i].packages));
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t running = 0;
+
+    auto install = [&](const std::vector<size_t>& built) {
+        std::vector<std::string> paths;
+        std::vector<std::string> dependencies;
+        for (size_t i : built) {
+            paths.insert(paths.end(), files[i].begin(), files[i].end());
+            if (targets[i].dependency) {
+                dependencies.insert(dependencies.end(), files[i].begin(), files[i].end());
+            }
+        }
+        return install_files(paths, dependencies);
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        bool changed = false;
+
+        // Nothing depending on a failed base can be built
+        for (size_t i = 0; i < targets.size(); ++i) {
+            if (states[i] != BuildState::PENDING) {
+                continue;
+            }
+            for (size_t dependency : depends_on[i]) {
+                if (states[dependency] == BuildState::FAILED) {
+                    states[i] = BuildState::FAILED;
+                    errors.push_back(targets[i].base + " skipped, " + targets[dependency].base + " failed");
+                    emit(targets[i].base, "Skipped, dependency " + targets[dependency].base + " failed");
+                    changed = true;
+                    break;
+                }
+            }
+        }
+
+        // Start every base whose dependencies are installed, up to the job limit
+        for (size_t i = 0; i < targets.size() && running < m_jobs && !m_cancelled; ++i) {
+            if (states[i] != BuildState::PENDING) {
+                continue;
+            }
+            bool ready = std::all_of(depends_on[i].begin(), depends_on[i].end(), [&states](size_t dependency) {
+                return states[dependency] == BuildState::INSTALLED;
+            });
+            if (!ready) {
+                continue;
+            }
+
+            states[i] = BuildState::BUILDING;
+            running++;
+            workers.emplace_back([&, i]() {
+                std::vector<std::string> built;
+                std::string error;
+                bool success = make(targets[i], built, error);
+                if (success && !keys[i].empty() && !m_cache->store(keys[i], built)) {
+                    emit(targets[i].base, "Failed to cache the build: " + m_cache->get_last_error());
+                }
+
+                std::lock_guard<std::mutex> guard(mutex);
+                files[i] = std::move(built);
+                states[i] = success ? BuildState::BUILT : BuildState::FAILED;
+                if (!success) {
+                    errors.push_back(error);
+                }
+                running--;
+                finished.notify_one();
+            });
+            changed = true;
+        }
+
+        // Builds waiting for a finished base need it installed, the others keep running meanwhile
+        std::vector<size_t> needed;
+        for (size_t i = 0; i < targets.size() && !m_cancelled; ++i) {
+            if (states[i] != BuildState::PENDING) {
+                continue;
+            }
+            for (size_t dependency : depends_on[i]) {
+                if (states[dependency] == BuildState::BUILT &&
+                    std::find(needed.begin(), needed.end(), dependency) == needed.end()) {
+                    needed.push_back(dependency);
+                }
+            }
+        }
+        if (!needed.empty()) {
+            lock.unlock();
+            bool installed = install(needed);
+            lock.lock();
+            for (size_t i : needed) {
+                states[i] = installed ? BuildState::INSTALLED : BuildState::FAILED;
+                if (!installed) {
+                    errors.push_back("Failed to install " + targets[i].base);
+                }
+            }
+            continue;
+        }
+
+        if (running == 0) {
+            break;
+        }
+        if (!changed) {
+            finished.wait(lock);
+        }
+    }
+    lock.unlock();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Everything else goes into one transaction
+    std::vector<size_t> built;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (states[i] == BuildState::BUILT) {
+            built.push_back(i);
+        }
+    }
+    if (!built.empty() && !m_cancelled) {
+        emit("", "Installing " + std::to_string(built.size()) + " built package bases");
+        if (!install(built)) {
+            errors.push_back("Failed to install the built packages");
+        }
+    }
+
+    if (m_cancelled) {
+        errors.insert(errors.begin(), "Build cancelled");
+    }
+    set_last_error(join(errors));
+    return errors.empty();
+}
+
+void AurBuilder::cancel()
+{
+    m_cancelled = true;
+    std::lock_guard<std::mutex> lock(m_runner_mutex);
+    for (ProcessRunner* runner : m_runners) {
+        runner->cancel();
+    }
+}
+
+std::string AurBuilder::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_error;
+}
+
+bool AurBuilder::fetch(const std::string& base, std::string& error)
+{
+    std::string directory = m_build_dir + "/" + base;
+    if (is_directory(directory + "/.git")) {
+        emit(base, "Updating " + directory);
+        return run(base, {"git", "-C", directory, "pull", "--ff-only", "--quiet"}, "", nullptr, error);
+    }
+
+    emit(base, "Cloning " + m_git_url + "/" + base + ".git");
+    return run(base, {"git", "clone", "--quiet", m_git_url + "/" + base + ".git", directory}, "", nullptr, error);
+}
+
+bool AurBuilder::make(const AurBuildTarget& target, std::vector<std::string>& files, std::string& error)
+{
+    std::string directory = m_build_dir + "/" + target.base;
+    emit(target.base, "Building " + target.base + " " + target.version);
+
+    // -f rebuilds packages left over from an earlier run of an older version
+    if (!run(target.base, {m_makepkg, "--force", "--noconfirm", "--noprogressbar"}, directory, nullptr, error)) {
+        return false;
+    }
+
+    // The file names honour PKGDEST and PKGEXT from makepkg.conf
+    std::vector<std::string> listed;
+    if (!run(target.base, {m_makepkg, "--packagelist"}, directory, &listed, error)) {
+        return false;
+    }
+    for (const auto& path : listed) {
+        std::string name = AurBuildCache::package_name(path);
+        if (std::find(target.packages.begin(), target.packages.end(), name) != target.packages.end() &&
+            is_file(path)) {
+            files.push_back(path);
+        }
+    }
+    if (files.size() < target.packages.size()) {
+        error = target.base + ": makepkg did not produce " + join(target.packages);
+        return false;
+    }
+
+    emit(target.base, "Built " + join(target.packages));
+    return true;
+}
+
+bool AurBuilder::run(const std::string& base, const std::vector<std::string>& args, const std::string& directory,
+                     std::vector<std::string>* output, std::string& error)
+{
+    ProcessRunner runner;
+    runner.set_working_directory(directory);
+    {
+        std::lock_guard<std::mutex> lock(m_runner_mutex);
+        if (m_cancelled) {
+            error = base + ": cancelled";
+            return false;
+        }
+        m_runners.push_back(&runner);
+    }
+
+    ProcessStatus status = runner.run(args, [this, &base, output](const std::string& line, OutputStream stream) {
+        if (output && stream == OutputStream::STDOUT) {
+            output->push_back(line);
+        } else {
+            emit(base, line);
+        }
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(m_runner_mutex);
+        m_runners.erase(std::remove(m_runners.begin(), m_runners.end(), &runner), m_runners.end());
+    }
+
+    if (!status.success()) {
+        error = base + ": " + args[0] + " " + status.describe();
+        if (!status.started) {
+            error += " (" + runner.get_last_error() + ")";
+        }
+        return false;
+    }
+    return true;
+}
+
+void AurBuilder::emit(const std::string& base, const std::string& line)
+{
+    std::lock_guard<std::mutex> lock(m_output_mutex);
+    std::string text = base.empty() ? line : "[" + base + "] " + line;
+    if (m_output_callback) {
+        m_output_callback(text + "\n");
+    } else {
+        std::cout << "AurBuilder: " << text << std::endl;
+    }
+}
+
+void AurBuilder::set_last_error(const std::string& error)
+{
+    if (!error.empty()) {
+        std::cerr << "AurBuilder: " << error << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_last_error = error;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,373 @@
+#include "core/aur_client.hpp"
+#include "core/json_parser.hpp"
+#include "core/thread_pool.hpp"
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <curl/curl.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    constexpr long kConnectTimeout = 10;
+    constexpr long kRequestTimeout = 30;
+
+    std::once_flag g_curl_init;
+
+    const char* field_name(AurSearchField by)
+    {
+        switch (by) {
+        case AurSearchField::NAME:          return "name";
+        case AurSearchField::NAME_DESC:     return "name-desc";
+        case AurSearchField::MAINTAINER:    return "maintainer";
+        case AurSearchField::DEPENDS:       return "depends";
+        case AurSearchField::MAKE_DEPENDS:  return "makedepends";
+        case AurSearchField::OPT_DEPENDS:   return "optdepends";
+        case AurSearchField::CHECK_DEPENDS: return "checkdepends";
+        }
+        return "name-desc";
+    }
+
+    // Percent-encode everything but the unreserved characters of RFC 3986
+    std::string escape(const std::string& value)
+    {
+        static const char kHex[] = "0123456789ABCDEF";
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (unsigned char c : value) {
+            if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                c == '-' || c == '.' || c == '_' || c == '~') {
+                escaped += static_cast<char>(c);
+            } else {
+                escaped += '%';
+                escaped += kHex[c >> 4];
+                escaped += kHex[c & 0xF];
+            }
+        }
+        return escaped;
+    }
+
+    struct Transfer {
+        JsonParser* parser;
+        bool parse_failed;
+
+        static size_t write_data(char* data, size_t size, size_t count, void* user)
+        {
+            Transfer* transfer = static_cast<Transfer*>(user);
+            if (!transfer->parser->feed(data, size * count)) {
+                // Aborts the transfer, no point in reading the rest
+                transfer->parse_failed = true;
+                return 0;
+            }
+            return size * count;
+        }
+    };
+}
+
+Package AurPackage::to_package() const
+{
+    Package package(name, version);
+    package.set_description(description);
+    package.set_repository("aur");
+    package.set_aur_info("AUR Package");
+    return package;
+}
+
+AurJsonHandler::AurJsonHandler(bool rpc_response, PackageCallback on_package)
+    : m_on_package(std::move(on_package))
+    , m_package_depth(rpc_response ? 2 : 1)
+    , m_depth(0)
+    , m_in_results(false)
+    , m_in_package(false)
+    , m_list(nullptr)
+    , m_rpc_response(rpc_response)
+{
+}
+
+void AurJsonHandler::begin_object()
+{
+    if (m_depth == m_package_depth && m_in_results) {
+        m_package = AurPackage();
+        m_in_package = true;
+    }
+    ++m_depth;
+}
+
+void AurJsonHandler::end_object()
+{
+    --m_depth;
+    if (m_depth == m_package_depth && m_in_package) {
+        m_in_package = false;
+        m_on_package(std::move(m_package));
+    }
+}
+
+void AurJsonHandler::begin_array()
+{
+    if (m_rpc_response ? (m_depth == 1 && m_key == "results") : m_depth == 0) {
+        m_in_results = true;
+    } else if (m_depth == m_package_depth + 1 && m_in_package) {
+        auto it = list_fields().find(m_key);
+        m_list = it != list_fields().end() ? &(m_package.*(it->second)) : nullptr;
+    }
+    ++m_depth;
+}
+
+void AurJsonHandler::end_array()
+{
+    --m_depth;
+    if (m_depth == m_package_depth - 1) {
+        m_in_results = false;
+    } else if (m_depth == m_package_depth + 1) {
+        m_list = nullptr;
+    }
+}
+
+void AurJsonHandler::key(std::string_view name)
+{
+    if (m_depth == 1 || m_depth == m_package_depth + 1) {
+        m_key.assign(name);
+    }
+}
+
+void AurJsonHandler::string_value(std::string_view value)
+{
+    if (m_depth == m_package_depth + 2 && m_list) {
+        m_list->emplace_back(value);
+    } else if (m_depth == m_package_depth + 1 && m_in_package) {
+        auto it = string_fields().find(m_key);
+        if (it != string_fields().end()) {
+            (m_package.*(it->second)).assign(value);
+        }
+    } else if (m_rpc_response && m_depth == 1 && m_key == "type") {
+        m_type.assign(value);
+    } else if (m_rpc_response && m_depth == 1 && m_key == "error") {
+        m_error.assign(value);
+    }
+}
+
+void AurJsonHandler::number_value(double value, std::string_view text)
+{
+    (void)text;
+    if (m_depth != m_package_depth + 1 || !m_in_package) {
+        return;
+    }
+    if (m_key == "NumVotes") {
+        m_package.num_votes = static_cast<uint32_t>(value);
+    } else if (m_key == "Popularity") {
+        m_package.popularity = value;
+    } else if (m_key == "OutOfDate") {
+        m_package.out_of_date = static_cast<int64_t>(value);
+    } else if (m_key == "FirstSubmitted") {
+        m_package.first_submitted = static_cast<int64_t>(value);
+    } else if (m_key == "LastModified") {
+        m_package.last_modified = static_cast<int64_t>(value);
+    }
+}
+
+const std::string& AurJsonHandler::get_type() const
+{
+    return m_type;
+}
+
+const std::string& AurJsonHandler::get_error() const
+{
+    return m_error;
+}
+
+const std::unordered_map<std::string_view, AurJsonHandler::StringField>& AurJsonHandler::string_fields()
+{
+    static const std::unordered_map<std::string_view, StringField> fields = {
+        {"Name", &AurPackage::name},
+        {"PackageBase", &AurPackage::package_base},
+        {"Version", &AurPackage::version},
+        {"Description", &AurPackage::description},
+        {"URL", &AurPackage::url},
+        {"URLPath", &AurPackage::url_path},
+        {"Maintainer", &AurPackage::maintainer},
+    };
+    return fields;
+}
+
+const std::unordered_map<std::string_view, AurJsonHandler::ListField>& AurJsonHandler::list_fields()
+{
+    static const std::unordered_map<std::string_view, ListField> fields = {
+        {"Depends", &AurPackage::depends},
+        {"MakeDepends", &AurPackage::make_depends},
+        {"CheckDepends", &AurPackage::check_depends},
+        {"OptDepends", &AurPackage::opt_depends},
+        {"Provides", &AurPackage::provides},
+        {"Conflicts", &AurPackage::conflicts},
+        {"Replaces", &AurPackage::replaces},
+        {"License", &AurPackage::licenses},
+        {"Keywords", &AurPackage::keywords},
+    };
+    return fields;
+}
+
+AurClient::AurClient(const std::string& rpc_url)
+    : m_rpc_url(rpc_url)
+{
+    std::call_once(g_curl_init, []() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+    });
+}
+
+AurClient::~AurClient()
+{
+    for (void* handle : m_handles) {
+        curl_easy_cleanup(static_cast<CURL*>(handle));
+    }
+}
+
+bool AurClient::search(const std::string& term, AurSearchField by, std::vector<AurPackage>& results)
+{
+    std::string query = std::string("v=5&type=search&by=") + field_name(by) + "&arg=" + escape(term);
+    std::string error;
+    bool ok = request(query, results, error);
+    set_last_error(error);
+    return ok;
+}
+
+bool AurClient::info(const std::vector<std::string>& names, std::vector<AurPackage>& results)
+{
+    results.clear();
+
+    // As many names per request as fit in the URL, at least one
+    const std::string base = "v=5&type=info";
+    std::vector<std::string> queries;
+    for (const std::string& name : names) {
+        std::string arg = "&arg[]=" + escape(name);
+        if (queries.empty() || m_rpc_url.size() + 1 + queries.back().size() + arg.size() > kMaxUrlLength) {
+            queries.push_back(base);
+        }
+        queries.back() += arg;
+    }
+
+    std::vector<std::vector<AurPackage>> responses(queries.size());
+    std::vector<std::string> errors(queries.size());
+    ThreadPool::shared().parallel_for(queries.size(), [&](size_t i) {
+        request(queries[i], responses[i], errors[i]);
+    });
+
+    std::string error;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        if (!errors[i].empty()) {
+            error = errors[i];
+            break;
+        }
+    }
+    if (error.empty()) {
+        for (std::vector<AurPackage>& response : responses) {
+            results.insert(results.end(), std::make_move_iterator(response.begin()),
+                           std::make_move_iterator(response.end()));
+        }
+    }
+
+    if (queries.size() > 1) {
+        std::cout << "AurClient: Requested " << names.size() << " packages in " << queries.size()
+                  << " requests" << std::endl;
+    }
+    set_last_error(error);
+    return error.empty();
+}
+
+const std::string& AurClient::get_rpc_url() const
+{
+    return m_rpc_url;
+}
+
+std::string AurClient::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_error;
+}
+
+void AurClient::set_last_error(const std::string& error)
+{
+    if (!error.empty()) {
+        std::cerr << "AurClient: " << error << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_last_error = error;
+}
+
+void* AurClient::acquire_handle()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_handles.empty()) {
+            void* handle = m_handles.back();
+            m_handles.pop_back();
+            return handle;
+        }
+    }
+    return curl_easy_init();
+}
+
+void AurClient::release_handle(void* handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handles.push_back(handle);
+}
+
+bool AurClient::request(const std::string& query, std::vector<AurPackage>& results, std::string& error)
+{
+    results.clear();
+    error.clear();
+
+    CURL* curl = static_cast<CURL*>(acquire_handle());
+    if (!curl) {
+        error = "Failed to initialize libcurl";
+        return false;
+    }
+
+    AurJsonHandler handler(true, [&results](AurPackage&& package) {
+        results.push_back(std::move(package));
+    });
+    JsonParser parser(handler);
+    Transfer transfer{&parser, false};
+    char curl_error[CURL_ERROR_SIZE] = "";
+
+    // The handle keeps its options and its connection cache between requests
+    std::string url = m_rpc_url + "?" + query;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &Transfer::write_data);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, curl_error);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, kConnectTimeout);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, kRequestTimeout);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "pacmangui/libalpm");
+
+    CURLcode result = curl_easy_perform(curl);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, nullptr);
+
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    release_handle(curl);
+
+    bool parsed = !transfer.parse_failed && result == CURLE_OK && parser.finish();
+    if (parsed && handler.get_type() == "error") {
+        error = "AUR error: " + (handler.get_error().empty() ? std::string("unknown") : handler.get_error());
+    } else if (result != CURLE_OK && !transfer.parse_failed) {
+        error = std::string("AUR request failed: ") + (curl_error[0] ? curl_error : curl_easy_strerror(result));
+    } else if (status != 200) {
+        error = "AUR request failed: HTTP " + std::to_string(status);
+    } else if (!parsed) {
+        error = "Invalid AUR response: " + parser.get_last_error();
+    }
+
+    if (!error.empty()) {
+        results.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace core
+} // namespace pacmangui
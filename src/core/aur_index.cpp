@@ -0,0 +1,890 @@
+#include "core/aur_index.hpp"
+#include "core/json_parser.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
+#include <curl/curl.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    constexpr char kMagic[8] = {'P', 'M', 'G', 'A', 'U', 'R', 'I', 'X'};
+
+    constexpr long kConnectTimeout = 10;
+    constexpr long kLowSpeedLimit = 1;
+    constexpr long kLowSpeedTime = 30;
+
+    std::once_flag g_curl_init;
+
+    // String fields of a record; lists are stored joined by '\n'
+    enum Field {
+        FIELD_NAME,
+        FIELD_PACKAGE_BASE,
+        FIELD_VERSION,
+        FIELD_DESCRIPTION,
+        FIELD_URL,
+        FIELD_URL_PATH,
+        FIELD_MAINTAINER,
+        FIELD_DEPENDS,
+        FIELD_MAKE_DEPENDS,
+        FIELD_CHECK_DEPENDS,
+        FIELD_OPT_DEPENDS,
+        FIELD_PROVIDES,
+        FIELD_CONFLICTS,
+        FIELD_COUNT
+    };
+
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;          ///< Number of records
+        int64_t source_time;     ///< Modification time of the dump, 0 if unknown
+        uint32_t etag;           ///< ETag of the dump in the string pool
+        uint32_t reserved;
+        uint64_t strings_size;   ///< Size of the string pool after the records
+    };
+    static_assert(sizeof(FileHeader) == 40, "FileHeader layout");
+
+    // Strings are offsets of NUL-terminated strings in the pool; offset 0 is ""
+    struct Record {
+        uint32_t strings[FIELD_COUNT];
+        uint32_t num_votes;
+        double popularity;
+        int64_t out_of_date;
+        int64_t last_modified;
+    };
+    static_assert(sizeof(Record) == 80, "Record layout");
+
+    std::string join(const std::vector<std::string>& list)
+    {
+        std::string joined;
+        for (const std::string& item : list) {
+            if (!joined.empty()) {
+                joined += '\n';
+            }
+            joined += item;
+        }
+        return joined;
+    }
+
+    std::vector<std::string> split(const char* joined)
+    {
+        std::vector<std::string> list;
+        while (*joined) {
+            const char* end = strchr(joined, '\n');
+            if (!end) {
+                list.emplace_back(joined);
+                break;
+            }
+            list.emplace_back(joined, end);
+            joined = end + 1;
+        }
+        return list;
+    }
+
+    char lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // True if text contains the lowercase term, ignoring ASCII case
+    bool contains(std::string_view text, std::string_view term)
+    {
+        return std::search(text.begin(), text.end(), term.begin(), term.end(),
+                           [](char a, char b) { return lower(a) == b; }) != text.end();
+    }
+
+    bool equals(std::string_view text, std::string_view term)
+    {
+        return text.size() == term.size() && contains(text, term);
+    }
+
+    bool starts_with(std::string_view text, std::string_view term)
+    {
+        return text.size() >= term.size() && equals(text.substr(0, term.size()), term);
+    }
+
+    // The three characters at pos, lowercased
+    uint32_t trigram_key(std::string_view text, size_t pos)
+    {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(lower(text[pos]))) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(lower(text[pos + 1]))) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(lower(text[pos + 2])));
+    }
+
+    /**
+     * @brief Collects packages into records and a deduplicated string pool
+     */
+    class IndexBuilder {
+    public:
+        IndexBuilder()
+            : m_strings(1, '\0')
+        {
+        }
+
+        void add(const AurPackage& package)
+        {
+            if (package.name.empty()) {
+                return;
+            }
+
+            Record record{};
+            record.strings[FIELD_NAME] = intern(package.name);
+            record.strings[FIELD_PACKAGE_BASE] = intern(package.package_base);
+            record.strings[FIELD_VERSION] = intern(package.version);
+            record.strings[FIELD_DESCRIPTION] = intern(package.description);
+            record.strings[FIELD_URL] = intern(package.url);
+            record.strings[FIELD_URL_PATH] = intern(package.url_path);
+            record.strings[FIELD_MAINTAINER] = intern(package.maintainer);
+            record.strings[FIELD_DEPENDS] = intern(join(package.depends));
+            record.strings[FIELD_MAKE_DEPENDS] = intern(join(package.make_depends));
+            record.strings[FIELD_CHECK_DEPENDS] = intern(join(package.check_depends));
+            record.strings[FIELD_OPT_DEPENDS] = intern(join(package.opt_depends));
+            record.strings[FIELD_PROVIDES] = intern(join(package.provides));
+            record.strings[FIELD_CONFLICTS] = intern(join(package.conflicts));
+            record.num_votes = package.num_votes;
+            record.popularity = package.popularity;
+            record.out_of_date = package.out_of_date;
+            record.last_modified = package.last_modified;
+            m_records.push_back(record);
+        }
+
+        bool write(const std::string& path, const std::string& etag, int64_t source_time, std::string& error)
+        {
+            const char* strings = m_strings.data();
+            auto name_of = [strings](const Record& record) {
+                return std::string_view(strings + record.strings[FIELD_NAME]);
+            };
+            std::sort(m_records.begin(), m_records.end(), [&name_of](const Record& a, const Record& b) {
+                return name_of(a) < name_of(b);
+            });
+            m_records.erase(std::unique(m_records.begin(), m_records.end(), [&name_of](const Record& a, const Record& b) {
+                return name_of(a) == name_of(b);
+            }), m_records.end());
+
+            FileHeader header{};
+            memcpy(header.magic, kMagic, sizeof(kMagic));
+            header.version = AurIndex::kFormatVersion;
+            header.count = static_cast<uint32_t>(m_records.size());
+            header.source_time = source_time;
+            header.etag = intern(etag);
+            header.strings_size = m_strings.size();
+
+            size_t slash = path.rfind('/');
+            if (slash != std::string::npos && slash > 0 && !make_directories(path.substr(0, slash))) {
+                error = "Failed to create " + path.substr(0, slash) + ": " + strerror(errno);
+                return false;
+            }
+
+            // Write a temporary file and rename it, so readers never see half an index
+            std::string temporary = path + ".tmp." + std::to_string(getpid());
+            FILE* file = fopen(temporary.c_str(), "wbe");
+            if (!file) {
+                error = "Failed to create " + temporary + ": " + strerror(errno);
+                return false;
+            }
+            bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                           (m_records.empty() ||
+                            fwrite(m_records.data(), sizeof(Record), m_records.size(), file) == m_records.size()) &&
+                           fwrite(m_strings.data(), 1, m_strings.size(), file) == m_strings.size();
+            if (fclose(file) != 0 || !written) {
+                error = "Failed to write " + temporary + ": " + strerror(errno);
+                unlink(temporary.c_str());
+                return false;
+            }
+            if (rename(temporary.c_str(), path.c_str()) != 0) {
+                error = "Failed to replace " + path + ": " + strerror(errno);
+                unlink(temporary.c_str());
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        uint32_t intern(const std::string& value)
+        {
+            if (value.empty()) {
+                return 0;
+            }
+            auto it = m_offsets.find(value);
+            if (it != m_offsets.end()) {
+                return it->second;
+            }
+            uint32_t offset = static_cast<uint32_t>(m_strings.size());
+            m_strings.append(value).push_back('\0');
+            m_offsets.emplace(value, offset);
+            return offset;
+        }
+
+        static bool make_directories(const std::string& path)
+        {
+            for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+                std::string dir = path.substr(0, slash);
+                if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+                    return false;
+                }
+                if (slash == std::string::npos) {
+                    return true;
+                }
+            }
+        }
+
+        std::vector<Record> m_records;
+        std::string m_strings;
+        std::unordered_map<std::string, uint32_t> m_offsets;
+    };
+
+    /**
+     * @brief Feeds a dump to the JSON parser, inflating it if it is gzip compressed
+     */
+    class DumpReader {
+    public:
+        explicit DumpReader(IndexBuilder& builder)
+            : m_handler(false, [&builder](AurPackage&& package) { builder.add(package); })
+            , m_parser(m_handler)
+            , m_stream{}
+            , m_gzip(false)
+            , m_started(false)
+        {
+        }
+
+        ~DumpReader()
+        {
+            if (m_gzip) {
+                inflateEnd(&m_stream);
+            }
+        }
+
+        bool feed(const char* data, size_t size)
+        {
+            // The format is known from the first byte: '{' or '[' for JSON, 0x1f for gzip
+            if (!m_started && size > 0) {
+                m_started = true;
+                m_gzip = static_cast<unsigned char>(data[0]) == 0x1f;
+                if (m_gzip && inflateInit2(&m_stream, 15 + 32) != Z_OK) {
+                    m_gzip = false;
+                    m_error = "Failed to initialize zlib";
+                    return false;
+                }
+            }
+            if (!m_gzip) {
+                return parse(data, size);
+            }
+
+            m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            m_stream.avail_in = static_cast<uInt>(size);
+            while (m_stream.avail_in > 0) {
+                char out[65536];
+                m_stream.next_out = reinterpret_cast<Bytef*>(out);
+                m_stream.avail_out = sizeof(out);
+                int status = inflate(&m_stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    m_error = std::string("Corrupt dump: ") + (m_stream.msg ? m_stream.msg : "inflate failed");
+                    return false;
+                }
+                if (!parse(out, sizeof(out) - m_stream.avail_out)) {
+                    return false;
+                }
+                if (status == Z_STREAM_END) {
+                    break;
+                }
+            }
+            return true;
+        }
+
+        bool finish()
+        {
+            if (!m_started) {
+                m_error = "Empty dump";
+                return false;
+            }
+            if (!m_parser.finish()) {
+                m_error = "Invalid dump: " + m_parser.get_last_error();
+                return false;
+            }
+            return true;
+        }
+
+        const std::string& get_error() const { return m_error; }
+
+        static size_t write_data(char* data, size_t size, size_t count, void* user)
+        {
+            return static_cast<DumpReader*>(user)->feed(data, size * count) ? size * count : 0;
+        }
+
+    private:
+        bool parse(const char* data, size_t size)
+        {
+            if (!m_parser.feed(data, size)) {
+                m_error = "Invalid dump: " + m_parser.get_last_error();
+                return false;
+            }
+            return true;
+        }
+
+        AurJsonHandler m_handler;
+        JsonParser m_parser;
+        z_stream m_stream;
+        bool m_gzip;
+        bool m_started;
+        std::string m_error;
+    };
+
+    // Remembers the ETag of the final response, redirects start a new header block
+    size_t read_header(char* data, size_t size, size_t count, void* user)
+    {
+        std::string* etag = static_cast<std::string*>(user);
+        std::string_view line(data, size * count);
+        if (line.rfind("HTTP/", 0) == 0) {
+            etag->clear();
+        } else if (line.size() > 5 && strncasecmp(line.data(), "etag:", 5) == 0) {
+            std::string_view value = line.substr(5);
+            size_t start = value.find_first_not_of(" \t");
+            size_t end = value.find_last_not_of(" \t\r\n");
+            if (start != std::string_view::npos && end != std::string_view::npos && end >= start) {
+                etag->assign(value.substr(start, end - start + 1));
+            }
+        }
+        return size * count;
+    }
+}
+
+struct AurIndex::Mapping {
+    void* data = nullptr;
+    size_t length = 0;
+    const FileHeader* header = nullptr;
+    const Record* records = nullptr;
+    const char* strings = nullptr;
+
+    // Trigrams of the lowercase text of one field, built by the first search that needs them
+    struct Trigrams {
+        std::once_flag built;
+        std::vector<uint32_t> keys;      // Sorted distinct trigrams
+        std::vector<uint32_t> offsets;   // Postings range of each trigram, plus an end offset
+        std::vector<uint32_t> postings;  // Record indices per trigram, ascending
+    };
+    mutable Trigrams name_trigrams;
+    mutable Trigrams description_trigrams;
+
+    ~Mapping()
+    {
+        if (data) {
+            munmap(data, length);
+        }
+    }
+
+    std::string_view string(const Record& record, Field field) const
+    {
+        return strings + record.strings[field];
+    }
+
+    void build_trigrams(Trigrams& trigrams, Field field) const
+    {
+        std::vector<uint64_t> pairs;
+        pairs.reserve(static_cast<size_t>(header->count) * (field == FIELD_NAME ? 12 : 48));
+        for (uint32_t i = 0; i < header->count; ++i) {
+            std::string_view text = string(records[i], field);
+            for (size_t pos = 0; pos + 3 <= text.size(); ++pos) {
+                pairs.push_back((static_cast<uint64_t>(trigram_key(text, pos)) << 32) | i);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        trigrams.postings.reserve(pairs.size());
+        for (uint64_t pair : pairs) {
+            uint32_t key = static_cast<uint32_t>(pair >> 32);
+            if (trigrams.keys.empty() || trigrams.keys.back() != key) {
+                trigrams.keys.push_back(key);
+                trigrams.offsets.push_back(static_cast<uint32_t>(trigrams.postings.size()));
+            }
+            trigrams.postings.push_back(static_cast<uint32_t>(pair));
+        }
+        trigrams.offsets.push_back(static_cast<uint32_t>(trigrams.postings.size()));
+    }
+
+    // Records whose field has every trigram of the term, ascending; the term has at least three characters
+    std::vector<uint32_t> candidates(std::string_view term, Field field) const
+    {
+        Trigrams& trigrams = field == FIELD_NAME ? name_trigrams : description_trigrams;
+        std::call_once(trigrams.built, [this, &trigrams, field]() { build_trigrams(trigrams, field); });
+
+        const std::vector<uint32_t>& postings = trigrams.postings;
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        for (size_t pos = 0; pos + 3 <= term.size(); ++pos) {
+            uint32_t key = trigram_key(term, pos);
+            auto it = std::lower_bound(trigrams.keys.begin(), trigrams.keys.end(), key);
+            if (it == trigrams.keys.end() || *it != key) {
+                return std::vector<uint32_t>();
+            }
+            size_t k = it - trigrams.keys.begin();
+            ranges.emplace_back(trigrams.offsets[k], trigrams.offsets[k + 1]);
+        }
+        std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) {
+            return (a.second - a.first) < (b.second - b.first);
+        });
+
+        std::vector<uint32_t> found(postings.begin() + ranges[0].first, postings.begin() + ranges[0].second);
+        std::vector<uint32_t> narrowed;
+        for (size_t r = 1; r < ranges.size() && !found.empty(); ++r) {
+            narrowed.clear();
+            std::set_intersection(found.begin(), found.end(),
+                                  postings.begin() + ranges[r].first,
+                                  postings.begin() + ranges[r].second,
+                                  std::back_inserter(narrowed));
+            found.swap(narrowed);
+        }
+        return found;
+    }
+
+    AurPackage to_package(const Record& record) const
+    {
+        AurPackage package;
+        package.name = string(record, FIELD_NAME);
+        package.package_base = string(record, FIELD_PACKAGE_BASE);
+        package.version = string(record, FIELD_VERSION);
+        package.description = string(record, FIELD_DESCRIPTION);
+        package.url = string(record, FIELD_URL);
+        package.url_path = string(record, FIELD_URL_PATH);
+        package.maintainer = string(record, FIELD_MAINTAINER);
+        package.depends = split(strings + record.strings[FIELD_DEPENDS]);
+        package.make_depends = split(strings + record.strings[FIELD_MAKE_DEPENDS]);
+        package.check_depends = split(strings + record.strings[FIELD_CHECK_DEPENDS]);
+        package.opt_depends = split(strings + record.strings[FIELD_OPT_DEPENDS]);
+        package.provides = split(strings + record.strings[FIELD_PROVIDES]);
+        package.conflicts = split(strings + record.strings[FIELD_CONFLICTS]);
+        package.num_votes = record.num_votes;
+        package.popularity = record.popularity;
+        package.out_of_date = record.out_of_date;
+        package.last_modified = record.last_modified;
+        return package;
+    }
+};
+
+AurIndex::AurIndex(const std::string& path)
+    : m_path(path)
+{
+    std::call_once(g_curl_init, []() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+    });
+}
+
+AurIndex::~AurIndex() = default;
+
+std::string AurIndex::default_path()
+{
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home && cache_home[0] == '/') {
+        return std::string(cache_home) + "/pacmangui/aur.index";
+    }
+
+    const char* home = getenv("HOME");
+    if (home && home[0] == '/') {
+        return std::string(home) + "/.cache/pacmangui/aur.index";
+    }
+    return "";
+}
+
+const std::string& AurIndex::get_path() const
+{
+    return m_path;
+}
+
+bool AurIndex::open()
+{
+    if (is_open()) {
+        return true;
+    }
+
+    std::string error;
+    std::shared_ptr<const Mapping> mapping = map_file(error);
+    if (!mapping) {
+        set_last_error(error);
+        return false;
+    }
+
+    std::cout << "AurIndex: Opened " << mapping->header->count << " packages from " << m_path << std::endl;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mapping = std::move(mapping);
+    m_last_error.clear();
+    return true;
+}
+
+bool AurIndex::is_open() const
+{
+    return get_mapping() != nullptr;
+}
+
+bool AurIndex::refresh(const std::string& url)
+{
+    std::lock_guard<std::mutex> refresh_lock(m_refresh_mutex);
+    if (m_path.empty()) {
+        set_last_error("No index path");
+        return false;
+    }
+
+    // The stored validators make the server skip an unchanged dump
+    std::shared_ptr<const Mapping> current = get_mapping();
+    if (!current) {
+        std::string ignored;
+        current = map_file(ignored);
+    }
+    std::string current_etag = current ? std::string(current->strings + current->header->etag) : "";
+    int64_t current_time = current ? current->header->source_time : 0;
+
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        set_last_error("Failed to initialize libcurl");
+        return false;
+    }
+
+    IndexBuilder builder;
+    DumpReader reader(builder);
+    std::string etag;
+    char error[CURL_ERROR_SIZE] = "";
+    curl_slist* headers = nullptr;
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &DumpReader::write_data);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &reader);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, &read_header);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &etag);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_FILETIME, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, kConnectTimeout);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, kLowSpeedLimit);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, kLowSpeedTime);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "pacmangui/libalpm");
+    if (!current_etag.empty()) {
+        headers = curl_slist_append(headers, ("If-None-Match: " + current_etag).c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    }
+    if (current_time > 0) {
+        curl_easy_setopt(curl, CURLOPT_TIMECONDITION, static_cast<long>(CURL_TIMECOND_IFMODSINCE));
+        curl_easy_setopt(curl, CURLOPT_TIMEVALUE_LARGE, static_cast<curl_off_t>(current_time));
+    }
+
+    std::cout << "AurIndex: Fetching " << url << std::endl;
+    CURLcode result = curl_easy_perform(curl);
+
+    long status = 0;
+    long unmet = 0;
+    curl_off_t filetime = -1;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_getinfo(curl, CURLINFO_CONDITION_UNMET, &unmet);
+    curl_easy_getinfo(curl, CURLINFO_FILETIME_T, &filetime);
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(headers);
+
+    if (result == CURLE_OK && current && (status == 304 || unmet)) {
+        std::cout << "AurIndex: Dump not modified, keeping " << current->header->count << " packages" << std::endl;
+        set_last_error("");
+        return true;
+    }
+    if (result != CURLE_OK) {
+        if (result == CURLE_WRITE_ERROR && !reader.get_error().empty()) {
+            set_last_error(reader.get_error());
+        } else {
+            set_last_error(std::string("Failed to download ") + url + ": " +
+                           (error[0] ? error : curl_easy_strerror(result)));
+        }
+        return false;
+    }
+    if (!reader.finish()) {
+        set_last_error(reader.get_error());
+        return false;
+    }
+
+    std::string write_error;
+    if (!builder.write(m_path, etag, filetime > 0 ? static_cast<int64_t>(filetime) : 0, write_error)) {
+        set_last_error(write_error);
+        return false;
+    }
+
+    std::shared_ptr<const Mapping> mapping = map_file(write_error);
+    if (!mapping) {
+        set_last_error(write_error);
+        return false;
+    }
+    std::cout << "AurIndex: Indexed " << mapping->header->count << " packages" << std::endl;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mapping = std::move(mapping);
+    m_last_error.clear();
+    return true;
+}
+
+bool AurIndex::build(const std::string& dump_path)
+{
+    std::lock_guard<std::mutex> refresh_lock(m_refresh_mutex);
+    if (m_path.empty()) {
+        set_last_error("No index path");
+        return false;
+    }
+
+    FILE* file = fopen(dump_path.c_str(), "rbe");
+    if (!file) {
+        set_last_error("Failed to open " + dump_path + ": " + strerror(errno));
+        return false;
+    }
+
+    IndexBuilder builder;
+    DumpReader reader(builder);
+    char buffer[65536];
+    bool ok = true;
+    size_t count;
+    while (ok && (count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        ok = reader.feed(buffer, count);
+    }
+    bool read_error = ferror(file) != 0;
+
+    struct stat info;
+    int64_t source_time = fstat(fileno(file), &info) == 0 ? static_cast<int64_t>(info.st_mtime) : 0;
+    fclose(file);
+
+    if (read_error) {
+        set_last_error("Failed to read " + dump_path);
+        return false;
+    }
+    if (!ok || !reader.finish()) {
+        set_last_error(reader.get_error());
+        return false;
+    }
+
+    std::string error;
+    if (!builder.write(m_path, "", source_time, error)) {
+        set_last_error(error);
+        return false;
+    }
+    std::shared_ptr<const Mapping> mapping = map_file(error);
+    if (!mapping) {
+        set_last_error(error);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mapping = std::move(mapping);
+    m_last_error.clear();
+    return true;
+}
+
+size_t AurIndex::size() const
+{
+    std::shared_ptr<const Mapping> mapping = get_mapping();
+    return mapping ? mapping->header->count : 0;
+}
+
+int64_t AurIndex::get_source_time() const
+{
+    std::shared_ptr<const Mapping> mapping = get_mapping();
+    return mapping ? mapping->header->source_time : 0;
+}
+
+std::string AurIndex::get_etag() const
+{
+    std::shared_ptr<const Mapping> mapping = get_mapping();
+    return mapping ? std::string(mapping->strings + mapping->header->etag) : "";
+}
+
+bool AurIndex::find(const std::string& name, AurPackage& package) const
+{
+    std::shared_ptr<const Mapping> mapping = get_mapping();
+    if (!mapping) {
+        return false;
+    }
+
+    const Record* begin = mapping->records;
+    const Record* end = begin + mapping->header->count;
+    const Record* it = std::lower_bound(begin, end, name, [&mapping](const Record& record, const std::string& key) {
+        return mapping->string(record, FIELD_NAME) < key;
+    });
+    if (it == end || mapping->string(*it, FIELD_NAME) != name) {
+        return false;
+    }
+
+    package = mapping->to_package(*it);
+    return true;
+}
+
+std::vector<AurPackage> AurIndex::search(const std::string& term, bool include_descriptions, size_t limit) const
+{
+    std::vector<AurPackage> results;
+    std::shared_ptr<const Mapping> mapping = get_mapping();
+    if (!mapping || term.empty()) {
+        return results;
+    }
+
+    std::string lowered(term);
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), lower);
+
+    // Rank 0: exact name, 1: name prefix, 2: name substring, 3: description
+    struct Hit {
+        int rank;
+        double popularity;
+        uint32_t index;
+    };
+    std::vector<Hit> hits;
+    auto match = [&](uint32_t i, bool names, bool descriptions) {
+        const Record& record = mapping->records[i];
+        std::string_view name = mapping->string(record, FIELD_NAME);
+        int rank;
+        if (names && equals(name, lowered)) {
+            rank = 0;
+        } else if (names && starts_with(name, lowered)) {
+            rank = 1;
+        } else if (names && contains(name, lowered)) {
+            rank = 2;
+        } else if (descriptions && contains(mapping->string(record, FIELD_DESCRIPTION), lowered)) {
+            rank = 3;
+        } else {
+            return;
+        }
+        hits.push_back(Hit{rank, record.popularity, i});
+    };
+
+    if (lowered.size() < 3) {
+        // Too short for trigrams, and nearly every record would match anyway
+        const Record* begin = mapping->records;
+        const Record* end = begin + mapping->header->count;
+        const Record* it = std::lower_bound(begin, end, lowered, [&mapping](const Record& record, const std::string& key) {
+            return mapping->string(record, FIELD_NAME) < key;
+        });
+        if (it != end && mapping->string(*it, FIELD_NAME) == lowered) {
+            match(static_cast<uint32_t>(it - begin), true, false);
+        }
+    } else {
+        // Candidates come from the trigram postings; trigrams can match out of order, so each is confirmed
+        for (uint32_t i : mapping->candidates(lowered, FIELD_NAME)) {
+            match(i, true, false);
+        }
+        if (include_descriptions) {
+            // Both candidate lists are ascending, records whose name matched are skipped
+            size_t named = hits.size();
+            size_t next = 0;
+            for (uint32_t i : mapping->candidates(lowered, FIELD_DESCRIPTION)) {
+                while (next < named && hits[next].index < i) {
+                    ++next;
+                }
+                if (next < named && hits[next].index == i) {
+                    continue;
+                }
+                match(i, false, true);
+            }
+        }
+    }
+
+    // Records are sorted by name, so the name breaks ties
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        if (a.rank != b.rank) {
+            return a.rank < b.rank;
+        }
+        if (a.popularity != b.popularity) {
+            return a.popularity > b.popularity;
+        }
+        return a.index < b.index;
+    });
+    if (limit > 0 && hits.size() > limit) {
+        hits.resize(limit);
+    }
+
+    results.reserve(hits.size());
+    for (const Hit& hit : hits) {
+        results.push_back(mapping->to_package(mapping->records[hit.index]));
+    }
+    return results;
+}
+
+std::string AurIndex::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_error;
+}
+
+std::shared_ptr<const AurIndex::Mapping> AurIndex::map_file(std::string& error) const
+{
+    if (m_path.empty()) {
+        error = "No index path";
+        return nullptr;
+    }
+
+    int fd = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "No AUR index at " + m_path;
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+        error = "AUR index at " + m_path + " is too small";
+        close(fd);
+        return nullptr;
+    }
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->length = static_cast<size_t>(info.st_size);
+    mapping->data = mmap(nullptr, mapping->length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping->data == MAP_FAILED) {
+        mapping->data = nullptr;
+        error = std::string("Failed to map the AUR index: ") + strerror(errno);
+        return nullptr;
+    }
+
+    // Everything is checked once here, so lookups can trust the offsets
+    const char* base = static_cast<const char*>(mapping->data);
+    const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+    bool valid = memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 && header->version == kFormatVersion &&
+                 header->strings_size > 0 &&
+                 mapping->length == sizeof(FileHeader) + static_cast<uint64_t>(header->count) * sizeof(Record) +
+                                    header->strings_size;
+    if (valid) {
+        mapping->header = header;
+        mapping->records = reinterpret_cast<const Record*>(base + sizeof(FileHeader));
+        mapping->strings = base + sizeof(FileHeader) + header->count * sizeof(Record);
+        valid = mapping->strings[header->strings_size - 1] == '\0' && header->etag < header->strings_size;
+    }
+    for (uint32_t i = 0; valid && i < header->count; ++i) {
+        for (uint32_t offset : mapping->records[i].strings) {
+            valid = valid && offset < header->strings_size;
+        }
+    }
+    if (!valid) {
+        error = "AUR index at " + m_path + " is damaged or has an unknown format";
+        return nullptr;
+    }
+
+    return mapping;
+}
+
+std::shared_ptr<const AurIndex::Mapping> AurIndex::get_mapping() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_mapping;
+}
+
+void AurIndex::set_last_error(const std::string& error)
+{
+    if (!error.empty()) {
+        std::cerr << "AurIndex: " << error << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_last_error = error;
+}
+
+} // namespace core
+} // namespace pacmangui
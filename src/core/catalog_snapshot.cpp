@@ -0,0 +1,280 @@
+#include "core/catalog_snapshot.hpp"
+#include <iostream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    constexpr char kMagic[8] = {'P', 'M', 'G', 'C', 'A', 'T', 'L', 'G'};
+
+    template <typename T>
+    void append(std::string& out, T value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    bool read(const char*& cursor, const char* end, T& value)
+    {
+        if (static_cast<size_t>(end - cursor) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, cursor, sizeof(value));
+        cursor += sizeof(value);
+        return true;
+    }
+
+    DatabaseStamp stamp_file(const std::string& name, const std::string& path)
+    {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            return DatabaseStamp{name, -1, -1};
+        }
+        int64_t mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+        return DatabaseStamp{name, mtime, static_cast<int64_t>(info.st_size)};
+    }
+
+    bool make_directories(const std::string& path)
+    {
+        for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+            std::string dir = path.substr(0, slash);
+            if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+                return false;
+            }
+            if (slash == std::string::npos) {
+                return true;
+            }
+        }
+    }
+}
+
+CatalogSnapshot::CatalogSnapshot(const std::string& path)
+    : m_path(path)
+{
+}
+
+std::string CatalogSnapshot::default_path()
+{
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home && cache_home[0] == '/') {
+        return std::string(cache_home) + "/pacmangui/catalog.snapshot";
+    }
+
+    const char* home = getenv("HOME");
+    if (home && home[0] == '/') {
+        return std::string(home) + "/.cache/pacmangui/catalog.snapshot";
+    }
+    return "";
+}
+
+std::vector<DatabaseStamp> CatalogSnapshot::current_stamps(alpm_handle_t* handle)
+{
+    std::vector<DatabaseStamp> stamps;
+    if (!handle) {
+        return stamps;
+    }
+
+    // Installing or removing adds and removes entries in the local directory
+    std::string dbpath = alpm_option_get_dbpath(handle);
+    stamps.push_back(stamp_file("local", dbpath + "local"));
+
+    for (alpm_list_t* i = alpm_get_syncdbs(handle); i; i = alpm_list_next(i)) {
+        std::string name = alpm_db_get_name(static_cast<alpm_db_t*>(i->data));
+        stamps.push_back(stamp_file(name, dbpath + "sync/" + name + ".db"));
+    }
+
+    return stamps;
+}
+
+const std::string& CatalogSnapshot::get_path() const
+{
+    return m_path;
+}
+
+std::shared_ptr<const PackageCatalog> CatalogSnapshot::load(const std::vector<DatabaseStamp>& stamps, uint64_t generation)
+{
+    m_last_error.clear();
+    if (m_path.empty()) {
+        m_last_error = "No snapshot path";
+        return nullptr;
+    }
+
+    int fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        m_last_error = "No snapshot at " + m_path;
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        m_last_error = "Empty snapshot at " + m_path;
+        close(fd);
+        return nullptr;
+    }
+
+    size_t length = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        m_last_error = std::string("Failed to map snapshot: ") + strerror(errno);
+        return nullptr;
+    }
+    madvise(mapping, length, MADV_SEQUENTIAL);
+
+    const char* cursor = static_cast<const char*>(mapping);
+    const char* end = cursor + length;
+    std::shared_ptr<const PackageCatalog> catalog;
+
+    // Header, then the stamps the catalogs were built from, then the catalogs
+    uint32_t version = 0;
+    uint64_t payload = 0;
+    uint32_t stamp_count = 0;
+    bool valid = static_cast<size_t>(end - cursor) >= sizeof(kMagic) &&
+                 memcmp(cursor, kMagic, sizeof(kMagic)) == 0;
+    if (valid) {
+        cursor += sizeof(kMagic);
+        valid = read(cursor, end, version) && version == kFormatVersion &&
+                read(cursor, end, payload) && payload == static_cast<uint64_t>(end - cursor) &&
+                read(cursor, end, stamp_count) && stamp_count == stamps.size();
+    }
+    if (!valid) {
+        m_last_error = "Snapshot has an unknown format";
+    }
+
+    for (uint32_t i = 0; valid && i < stamp_count; ++i) {
+        uint32_t name_length = 0;
+        DatabaseStamp stamp;
+        valid = read(cursor, end, name_length) && static_cast<size_t>(end - cursor) >= name_length;
+        if (valid) {
+            stamp.name.assign(cursor, name_length);
+            cursor += name_length;
+            valid = read(cursor, end, stamp.mtime) && read(cursor, end, stamp.size) && stamp == stamps[i];
+        }
+        if (!valid) {
+            m_last_error = "Snapshot is out of date";
+        }
+    }
+
+    if (valid) {
+        uint32_t has_local = 0;
+        uint32_t sync_count = 0;
+        PackageCatalog::RepositoryPtr local;
+        std::vector<PackageCatalog::RepositoryPtr> sync;
+
+        valid = read(cursor, end, has_local);
+        if (valid && has_local) {
+            local = RepositoryCatalog::restore(cursor, end);
+            valid = local != nullptr;
+        }
+        valid = valid && read(cursor, end, sync_count) && sync_count + 1 == stamps.size();
+        for (uint32_t i = 0; valid && i < sync_count; ++i) {
+            PackageCatalog::RepositoryPtr repo = RepositoryCatalog::restore(cursor, end);
+            valid = repo != nullptr;
+            sync.push_back(std::move(repo));
+        }
+
+        if (valid && cursor == end) {
+            catalog = std::make_shared<const PackageCatalog>(generation, std::move(local), std::move(sync));
+        } else {
+            m_last_error = "Snapshot is damaged";
+        }
+    }
+
+    munmap(mapping, length);
+
+    if (catalog) {
+        std::cout << "CatalogSnapshot: Loaded " << catalog->size() << " packages from " << m_path << std::endl;
+    }
+    return catalog;
+}
+
+bool CatalogSnapshot::save(const PackageCatalog& catalog, const std::vector<DatabaseStamp>& stamps)
+{
+    m_last_error.clear();
+    if (m_path.empty()) {
+        m_last_error = "No snapshot path";
+        return false;
+    }
+
+    std::string body;
+    append<uint32_t>(body, static_cast<uint32_t>(stamps.size()));
+    for (const DatabaseStamp& stamp : stamps) {
+        append<uint32_t>(body, static_cast<uint32_t>(stamp.name.size()));
+        body.append(stamp.name);
+        append<int64_t>(body, stamp.mtime);
+        append<int64_t>(body, stamp.size);
+    }
+
+    append<uint32_t>(body, catalog.get_local() ? 1 : 0);
+    if (catalog.get_local()) {
+        catalog.get_local()->save(body);
+    }
+    append<uint32_t>(body, static_cast<uint32_t>(catalog.get_sync().size()));
+    for (const auto& repo : catalog.get_sync()) {
+        repo->save(body);
+    }
+
+    std::string header(kMagic, sizeof(kMagic));
+    append<uint32_t>(header, kFormatVersion);
+    append<uint64_t>(header, static_cast<uint64_t>(body.size()));
+
+    size_t slash = m_path.rfind('/');
+    if (slash != std::string::npos && slash > 0 && !make_directories(m_path.substr(0, slash))) {
+        m_last_error = "Failed to create " + m_path.substr(0, slash) + ": " + strerror(errno);
+        return false;
+    }
+
+    // Write a temporary file and rename it, so readers never see half a snapshot
+    std::string temporary = m_path + ".tmp." + std::to_string(getpid());
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        m_last_error = "Failed to create " + temporary + ": " + strerror(errno);
+        return false;
+    }
+
+    bool written = true;
+    for (const std::string* part : {&header, &body}) {
+        const char* data = part->data();
+        size_t remaining = part->size();
+        while (written && remaining > 0) {
+            ssize_t count = write(fd, data, remaining);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            written = count > 0;
+            if (written) {
+                data += count;
+                remaining -= static_cast<size_t>(count);
+            }
+        }
+    }
+
+    if (close(fd) != 0 || !written) {
+        m_last_error = "Failed to write " + temporary + ": " + strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+    if (rename(temporary.c_str(), m_path.c_str()) != 0) {
+        m_last_error = "Failed to replace " + m_path + ": " + strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    std::cout << "CatalogSnapshot: Wrote " << catalog.size() << " packages to " << m_path << std::endl;
+    return true;
+}
+
+std::string CatalogSnapshot::get_last_error() const
+{
+    return m_last_error;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,157 @@
+#include "core/directory_size.hpp"
+#include "core/thread_pool.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <set>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    const unsigned int kStatxMask = STATX_TYPE | STATX_INO | STATX_NLINK | STATX_BLOCKS;
+
+    // What the walk of one directory found
+    struct DirectoryResult {
+        DirectoryUsage usage;
+        std::vector<std::string> subdirectories;
+        std::vector<std::pair<uint64_t, uint64_t>> linked;  // (device, inode) of files with hard links
+        std::vector<uint64_t> linked_blocks;                // Size of each of them
+        int error = 0;                                      // errno if the directory could not be opened
+    };
+
+    uint64_t device_of(const struct statx& info)
+    {
+        return (static_cast<uint64_t>(info.stx_dev_major) << 32) | info.stx_dev_minor;
+    }
+
+    void read_directory(const std::string& path, DirectoryResult& result)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        DIR* dir = fd >= 0 ? fdopendir(fd) : nullptr;
+        if (!dir) {
+            result.error = errno;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return;
+        }
+
+        while (struct dirent* entry = readdir(dir)) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            // Relative to the open directory, so the kernel does not resolve the path again
+            struct statx info;
+            if (statx(dirfd(dir), entry->d_name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, kStatxMask, &info) != 0) {
+                ++result.usage.unreadable;
+                continue;
+            }
+
+            uint64_t bytes = static_cast<uint64_t>(info.stx_blocks) * 512;
+            if (S_ISDIR(info.stx_mode)) {
+                result.usage.bytes += bytes;
+                ++result.usage.directories;
+                result.subdirectories.push_back(path + "/" + entry->d_name);
+            } else if (info.stx_nlink > 1) {
+                result.linked.emplace_back(device_of(info), info.stx_ino);
+                result.linked_blocks.push_back(bytes);
+            } else {
+                result.usage.bytes += bytes;
+                ++result.usage.files;
+            }
+        }
+        closedir(dir);
+    }
+}
+
+DirectorySizeWalker::DirectorySizeWalker(ThreadPool* pool)
+    : m_pool(pool ? *pool : ThreadPool::shared())
+{
+}
+
+bool DirectorySizeWalker::measure(const std::string& path, DirectoryUsage& usage, const std::atomic<bool>* cancelled)
+{
+    usage = DirectoryUsage();
+    m_last_error.clear();
+
+    struct statx root;
+    if (statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, kStatxMask, &root) != 0) {
+        m_last_error = "Cannot read " + path + ": " + strerror(errno);
+        return false;
+    }
+    if (!S_ISDIR(root.stx_mode)) {
+        m_last_error = path + " is not a directory";
+        return false;
+    }
+    usage.bytes = static_cast<uint64_t>(root.stx_blocks) * 512;
+    usage.directories = 1;
+
+    std::set<std::pair<uint64_t, uint64_t>> seen_links;
+    std::vector<std::string> level = {path};
+    bool root_level = true;
+
+    while (!level.empty()) {
+        std::vector<DirectoryResult> results(level.size());
+        m_pool.parallel_for(level.size(), [&](size_t i) {
+            if (cancelled && cancelled->load()) {
+                return;
+            }
+            read_directory(level[i], results[i]);
+        });
+
+        if (cancelled && cancelled->load()) {
+            m_last_error = "Measuring " + path + " was cancelled";
+            return false;
+        }
+        if (root_level && results[0].error != 0) {
+            m_last_error = "Cannot read " + path + ": " + strerror(results[0].error);
+            return false;
+        }
+        root_level = false;
+
+        // Merged in directory order, so hard links count the same way every time
+        std::vector<std::string> next;
+        for (DirectoryResult& result : results) {
+            if (result.error != 0) {
+                ++usage.unreadable;
+                continue;
+            }
+            usage.bytes += result.usage.bytes;
+            usage.files += result.usage.files;
+            usage.directories += result.usage.directories;
+            usage.unreadable += result.usage.unreadable;
+            for (size_t i = 0; i < result.linked.size(); ++i) {
+                ++usage.files;
+                if (seen_links.insert(result.linked[i]).second) {
+                    usage.bytes += result.linked_blocks[i];
+                }
+            }
+            for (std::string& subdirectory : result.subdirectories) {
+                next.push_back(std::move(subdirectory));
+            }
+        }
+        level = std::move(next);
+    }
+
+    if (usage.unreadable > 0) {
+        std::cerr << "DirectorySizeWalker: Skipped " << usage.unreadable << " unreadable entries under "
+                  << path << std::endl;
+    }
+    return true;
+}
+
+std::string DirectorySizeWalker::get_last_error() const
+{
+    return m_last_error;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,578 @@
+#include "core/download_scheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <curl/curl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Progress is reported at most this often per run, plus once per finished file
+    constexpr auto kReportInterval = std::chrono::milliseconds(200);
+
+    // Like pacman, give up on a mirror that sends less than 1 byte/s for 10 seconds
+    constexpr long kLowSpeedLimit = 1;
+    constexpr long kLowSpeedTime = 10;
+    constexpr long kConnectTimeout = 10;
+
+    std::once_flag g_curl_init;
+
+    // Mirrors are told apart by scheme, host and port
+    std::string host_of(const std::string& url)
+    {
+        size_t scheme = url.find("://");
+        size_t start = scheme == std::string::npos ? 0 : scheme + 3;
+        size_t end = url.find('/', start);
+        return url.substr(0, end);
+    }
+
+    std::string join_path(const std::string& dir, const std::string& name)
+    {
+        if (dir.empty() || dir.back() == '/') {
+            return dir + name;
+        }
+        return dir + "/" + name;
+    }
+
+    bool file_size(const std::string& path, uint64_t& size)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return false;
+        }
+        size = static_cast<uint64_t>(st.st_size);
+        return true;
+    }
+
+    // Package archives never change under the same name, everything else
+    // (databases and their signatures) may be replaced on the mirror
+    bool is_package_file(const std::string& filename)
+    {
+        return filename.find(".pkg.tar") != std::string::npos &&
+               (filename.size() < 4 || filename.compare(filename.size() - 4, 4, ".sig") != 0);
+    }
+}
+
+struct DownloadScheduler::Transfer {
+    DownloadRequest request;
+    std::vector<size_t> hosts;      ///< Host index of each candidate URL
+    std::vector<bool> tried;        ///< Candidate URLs that already failed
+    std::string part_path;
+    std::string final_path;
+    FILE* file = nullptr;
+    CURL* easy = nullptr;
+    size_t url_index = 0;
+    uint64_t resume_from = 0;       ///< Bytes already on disk when the attempt started
+    uint64_t on_disk = 0;           ///< Bytes currently in the .part file
+    uint64_t received = 0;          ///< Bytes received by the current attempt
+    uint64_t total = 0;             ///< Size of the file, once known
+    int64_t time_condition = 0;     ///< Only fetch if newer than this, 0 for always
+    bool restarted = false;
+    bool active = false;
+    bool done = false;
+    bool failed = false;
+    bool up_to_date = false;
+    Clock::time_point started;
+    char error[CURL_ERROR_SIZE] = {0};
+
+    static size_t write_data(char* data, size_t size, size_t nmemb, void* userdata)
+    {
+        auto* transfer = static_cast<Transfer*>(userdata);
+        size_t bytes = size * nmemb;
+
+        // The file is opened on the first body byte, so an error page or a
+        // "not modified" reply never truncates an existing .part file
+        if (!transfer->file) {
+            long code = 0;
+            curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &code);
+            if (transfer->resume_from > 0 && code == 200) {
+                // The server ignored the range and sends the whole file
+                transfer->resume_from = 0;
+                transfer->on_disk = 0;
+            }
+            transfer->file = fopen(transfer->part_path.c_str(), transfer->resume_from > 0 ? "ab" : "wb");
+            if (!transfer->file) {
+                snprintf(transfer->error, sizeof(transfer->error), "Cannot write %s", transfer->part_path.c_str());
+                return 0;
+            }
+        }
+
+        if (fwrite(data, 1, bytes, transfer->file) != bytes) {
+            snprintf(transfer->error, sizeof(transfer->error), "Write error on %s", transfer->part_path.c_str());
+            return 0;
+        }
+
+        transfer->on_disk += bytes;
+        transfer->received += bytes;
+        return bytes;
+    }
+};
+
+DownloadScheduler::DownloadScheduler(size_t max_parallel, size_t max_per_mirror)
+    : m_multi(nullptr)
+    , m_max_parallel(std::max<size_t>(1, max_parallel))
+    , m_max_per_mirror(std::max<size_t>(1, max_per_mirror))
+    , m_up_to_date(false)
+    , m_cancelled(false)
+{
+    std::call_once(g_curl_init, []() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+    });
+    m_multi = curl_multi_init();
+}
+
+DownloadScheduler::~DownloadScheduler()
+{
+    if (m_multi) {
+        curl_multi_cleanup(static_cast<CURLM*>(m_multi));
+    }
+}
+
+void DownloadScheduler::set_max_parallel(size_t max_parallel)
+{
+    m_max_parallel = std::max<size_t>(1, max_parallel);
+}
+
+void DownloadScheduler::set_max_per_mirror(size_t max_per_mirror)
+{
+    m_max_per_mirror = std::max<size_t>(1, max_per_mirror);
+}
+
+void DownloadScheduler::set_progress_callback(DownloadProgressCallback callback)
+{
+    m_progress_callback = std::move(callback);
+}
+
+void DownloadScheduler::add_server_group(const std::vector<std::string>& servers)
+{
+    if (!servers.empty()) {
+        m_server_groups.push_back(servers);
+    }
+}
+
+void DownloadScheduler::clear_server_groups()
+{
+    m_server_groups.clear();
+}
+
+bool DownloadScheduler::download(const std::vector<DownloadRequest>& requests)
+{
+    return run(requests, false);
+}
+
+int DownloadScheduler::fetch(const std::string& url, const std::string& local_dir, bool force)
+{
+    DownloadRequest request;
+    size_t slash = url.find_last_of('/');
+    request.filename = slash == std::string::npos ? url : url.substr(slash + 1);
+    request.destination = local_dir;
+    request.urls = alternatives(url);
+
+    // A partial database may belong to an older version on the mirror
+    std::string part_path = join_path(local_dir, request.filename) + ".part";
+    if (force || !is_package_file(request.filename)) {
+        std::remove(part_path.c_str());
+    }
+
+    uint64_t existing = 0;
+    bool conditional = !force && file_size(join_path(local_dir, request.filename), existing);
+
+    if (!run({request}, conditional)) {
+        return -1;
+    }
+    return m_up_to_date ? 1 : 0;
+}
+
+int DownloadScheduler::fetch_callback(void* ctx, const char* url, const char* localpath, int force)
+{
+    auto* scheduler = static_cast<DownloadScheduler*>(ctx);
+    if (!scheduler || !url || !localpath) {
+        return -1;
+    }
+    return scheduler->fetch(url, localpath, force != 0);
+}
+
+void DownloadScheduler::cancel()
+{
+    m_cancelled = true;
+    if (m_multi) {
+        curl_multi_wakeup(static_cast<CURLM*>(m_multi));
+    }
+}
+
+void DownloadScheduler::reset_cancel()
+{
+    m_cancelled = false;
+}
+
+const std::vector<std::string>& DownloadScheduler::get_failed() const
+{
+    return m_failed;
+}
+
+std::string DownloadScheduler::get_last_error() const
+{
+    return m_last_error;
+}
+
+std::vector<std::string> DownloadScheduler::alternatives(const std::string& url) const
+{
+    std::vector<std::string> urls{url};
+
+    for (const auto& group : m_server_groups) {
+        for (const auto& server : group) {
+            std::string prefix = server.back() == '/' ? server : server + "/";
+            if (url.compare(0, prefix.size(), prefix) != 0) {
+                continue;
+            }
+
+            // Same path on every other server of the group, in mirrorlist order
+            std::string path = url.substr(prefix.size());
+            for (const auto& other : group) {
+                if (other != server) {
+                    urls.push_back(join_path(other, path));
+                }
+            }
+            return urls;
+        }
+    }
+
+    return urls;
+}
+
+bool DownloadScheduler::run(std::vector<DownloadRequest> requests, bool conditional)
+{
+    auto* multi = static_cast<CURLM*>(m_multi);
+    m_failed.clear();
+    m_up_to_date = false;
+    m_last_error.clear();
+
+    if (!multi) {
+        m_last_error = "Failed to initialize libcurl";
+        return false;
+    }
+
+    // Transfers are referenced by curl through their address, so the vector
+    // is sized once up front and never reallocated during the run
+    std::vector<Transfer> transfers(requests.size());
+    std::map<std::string, size_t> host_ids;
+    std::deque<size_t> queue;
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        Transfer& transfer = transfers[i];
+        transfer.request = std::move(requests[i]);
+        transfer.final_path = join_path(transfer.request.destination, transfer.request.filename);
+        transfer.part_path = transfer.final_path + ".part";
+        transfer.total = transfer.request.expected_size;
+        transfer.tried.assign(transfer.request.urls.size(), false);
+        for (const auto& url : transfer.request.urls) {
+            auto inserted = host_ids.emplace(host_of(url), host_ids.size());
+            transfer.hosts.push_back(inserted.first->second);
+        }
+
+        if (conditional) {
+            struct stat st;
+            if (stat(transfer.final_path.c_str(), &st) == 0) {
+                transfer.time_condition = static_cast<int64_t>(st.st_mtime);
+            }
+        }
+        file_size(transfer.part_path, transfer.on_disk);
+        queue.push_back(i);
+    }
+
+    std::vector<size_t> mirror_load(host_ids.size(), 0);
+    size_t active = 0;
+    Clock::time_point run_started = Clock::now();
+    Clock::time_point last_report = run_started;
+
+    auto elapsed_since = [](Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    while (!queue.empty() || active > 0) {
+        if (m_cancelled) {
+            // Keep the .part files, the next run resumes them
+            for (auto& transfer : transfers) {
+                if (transfer.active) {
+                    curl_multi_remove_handle(multi, transfer.easy);
+                    curl_easy_cleanup(transfer.easy);
+                    transfer.easy = nullptr;
+                    transfer.active = false;
+                }
+                if (transfer.file) {
+                    fclose(transfer.file);
+                    transfer.file = nullptr;
+                }
+                if (!transfer.done && !transfer.failed) {
+                    transfer.failed = true;
+                    m_failed.push_back(transfer.request.filename);
+                }
+            }
+            m_last_error = "Download cancelled";
+            break;
+        }
+
+        // Start as many queued files as the global and per-mirror limits allow.
+        // A file whose mirrors are all busy waits without blocking the ones behind it.
+        for (auto it = queue.begin(); it != queue.end() && active < m_max_parallel;) {
+            Transfer& transfer = transfers[*it];
+
+            bool untried = std::find(transfer.tried.begin(), transfer.tried.end(), false) != transfer.tried.end();
+            if (!untried) {
+                transfer.failed = true;
+                m_failed.push_back(transfer.request.filename);
+                if (m_last_error.empty()) {
+                    m_last_error = "No mirror left to download " + transfer.request.filename;
+                }
+                std::cerr << "DownloadScheduler: Failed to download " << transfer.request.filename << std::endl;
+                it = queue.erase(it);
+                continue;
+            }
+
+            if (start_transfer(transfer, mirror_load)) {
+                ++active;
+                it = queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (active == 0) {
+            // Nothing could be started even with every mirror idle
+            for (size_t index : queue) {
+                transfers[index].failed = true;
+                m_failed.push_back(transfers[index].request.filename);
+            }
+            m_last_error = "Failed to start downloads";
+            break;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int pending = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi, &pending)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&transfer));
+            CURLcode result = msg->data.result;
+
+            long code = 0;
+            long unmet = 0;
+            curl_off_t filetime = -1;
+            curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &code);
+            curl_easy_getinfo(transfer->easy, CURLINFO_CONDITION_UNMET, &unmet);
+            curl_easy_getinfo(transfer->easy, CURLINFO_FILETIME_T, &filetime);
+
+            curl_multi_remove_handle(multi, transfer->easy);
+            curl_easy_cleanup(transfer->easy);
+            transfer->easy = nullptr;
+            transfer->active = false;
+            --active;
+            --mirror_load[transfer->hosts[transfer->url_index]];
+
+            if (transfer->file) {
+                if (fclose(transfer->file) != 0 && result == CURLE_OK) {
+                    result = CURLE_WRITE_ERROR;
+                }
+                transfer->file = nullptr;
+            }
+
+            const std::string& url = transfer->request.urls[transfer->url_index];
+            std::string error;
+
+            // curl reports a 416 on a resumed transfer as success, assuming the file is complete
+            bool range_error = code == 416;
+
+            if (result == CURLE_OK && unmet) {
+                transfer->up_to_date = true;
+                transfer->done = true;
+            } else if (result == CURLE_OK && !range_error) {
+                if (!file_size(transfer->part_path, transfer->on_disk)) {
+                    // Empty body, nothing was written
+                    FILE* empty = fopen(transfer->part_path.c_str(), "wb");
+                    if (empty) {
+                        fclose(empty);
+                    }
+                    transfer->on_disk = 0;
+                }
+
+                if (transfer->request.expected_size > 0 && transfer->on_disk != transfer->request.expected_size) {
+                    error = "size mismatch, got " + std::to_string(transfer->on_disk) + " of " +
+                            std::to_string(transfer->request.expected_size) + " bytes";
+                    std::remove(transfer->part_path.c_str());
+                    transfer->on_disk = 0;
+                } else if (std::rename(transfer->part_path.c_str(), transfer->final_path.c_str()) != 0) {
+                    error = "cannot rename " + transfer->part_path;
+                } else {
+                    if (filetime >= 0) {
+                        // Keep the server's timestamp for the next conditional fetch
+                        struct timeval times[2] = {{static_cast<time_t>(filetime), 0},
+                                                   {static_cast<time_t>(filetime), 0}};
+                        utimes(transfer->final_path.c_str(), times);
+                    }
+                    transfer->total = transfer->on_disk;
+                    transfer->done = true;
+                }
+            } else if (range_error && !transfer->restarted) {
+                // The range did not fit the file, start it over on the same mirror
+                std::remove(transfer->part_path.c_str());
+                transfer->on_disk = 0;
+                transfer->restarted = true;
+                queue.push_front(transfer - transfers.data());
+                continue;
+            } else if (range_error) {
+                error = "requested range not satisfiable";
+                std::remove(transfer->part_path.c_str());
+                transfer->on_disk = 0;
+            } else {
+                error = transfer->error[0] ? transfer->error : curl_easy_strerror(result);
+            }
+
+            if (transfer->done) {
+                if (transfer->up_to_date) {
+                    m_up_to_date = true;
+                }
+                report(transfers, *transfer, elapsed_since(run_started));
+                continue;
+            }
+
+            // Keep what was received, the next mirror resumes from there
+            std::cerr << "DownloadScheduler: " << transfer->request.filename << " from " << url
+                      << " failed: " << error << std::endl;
+            m_last_error = transfer->request.filename + ": " + error;
+            transfer->tried[transfer->url_index] = true;
+            queue.push_front(transfer - transfers.data());
+        }
+
+        if (Clock::now() - last_report >= kReportInterval) {
+            last_report = Clock::now();
+            double elapsed = elapsed_since(run_started);
+            for (const auto& transfer : transfers) {
+                if (transfer.active) {
+                    report(transfers, transfer, elapsed);
+                }
+            }
+        }
+
+        if (active > 0) {
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+        }
+    }
+
+    if (m_failed.empty()) {
+        m_last_error.clear();
+    }
+    return m_failed.empty();
+}
+
+bool DownloadScheduler::start_transfer(Transfer& transfer, std::vector<size_t>& mirror_load)
+{
+    // First untried candidate whose mirror still has a free connection
+    size_t index = transfer.request.urls.size();
+    for (size_t i = 0; i < transfer.request.urls.size(); ++i) {
+        if (!transfer.tried[i] && mirror_load[transfer.hosts[i]] < m_max_per_mirror) {
+            index = i;
+            break;
+        }
+    }
+    if (index == transfer.request.urls.size()) {
+        return false;
+    }
+
+    CURL* easy = curl_easy_init();
+    if (!easy) {
+        return false;
+    }
+
+    transfer.easy = easy;
+    transfer.url_index = index;
+    transfer.resume_from = transfer.time_condition > 0 ? 0 : transfer.on_disk;
+    transfer.on_disk = transfer.resume_from;
+    transfer.received = 0;
+    transfer.error[0] = '\0';
+    transfer.started = Clock::now();
+    transfer.active = true;
+
+    curl_easy_setopt(easy, CURLOPT_URL, transfer.request.urls[index].c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &Transfer::write_data);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer.error);
+    curl_easy_setopt(easy, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_FILETIME, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT, kConnectTimeout);
+    curl_easy_setopt(easy, CURLOPT_LOW_SPEED_LIMIT, kLowSpeedLimit);
+    curl_easy_setopt(easy, CURLOPT_LOW_SPEED_TIME, kLowSpeedTime);
+    curl_easy_setopt(easy, CURLOPT_USERAGENT, "pacmangui/libalpm");
+
+    if (transfer.resume_from > 0) {
+        curl_easy_setopt(easy, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(transfer.resume_from));
+    }
+    if (transfer.time_condition > 0) {
+        curl_easy_setopt(easy, CURLOPT_TIMECONDITION, static_cast<long>(CURL_TIMECOND_IFMODSINCE));
+        curl_easy_setopt(easy, CURLOPT_TIMEVALUE_LARGE, static_cast<curl_off_t>(transfer.time_condition));
+    }
+
+    curl_multi_add_handle(static_cast<CURLM*>(m_multi), easy);
+    ++mirror_load[transfer.hosts[index]];
+    return true;
+}
+
+void DownloadScheduler::report(const std::vector<Transfer>& transfers, const Transfer& current, double elapsed) const
+{
+    if (!m_progress_callback) {
+        return;
+    }
+
+    DownloadProgress progress;
+    progress.filename = current.request.filename;
+    progress.downloaded = current.on_disk;
+    progress.total = current.total;
+    progress.count = transfers.size();
+
+    if (current.active && current.easy) {
+        curl_off_t length = -1;
+        curl_easy_getinfo(current.easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+        if (length > 0) {
+            progress.total = current.resume_from + static_cast<uint64_t>(length);
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - current.started).count();
+        progress.rate = seconds > 0 ? current.received / seconds : 0.0;
+    } else if (current.done) {
+        progress.total = current.on_disk;
+        progress.downloaded = current.on_disk;
+        double seconds = std::chrono::duration<double>(Clock::now() - current.started).count();
+        progress.rate = seconds > 0 ? current.received / seconds : 0.0;
+    }
+
+    uint64_t received = 0;
+    for (const auto& transfer : transfers) {
+        progress.total_downloaded += transfer.on_disk;
+        progress.total_size += std::max(transfer.total, transfer.on_disk);
+        received += transfer.received;
+        if (transfer.done || transfer.failed) {
+            ++progress.completed;
+        }
+    }
+    progress.total_rate = elapsed > 0 ? received / elapsed : 0.0;
+
+    m_progress_callback(progress);
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,292 @@
+#include "core/flatpak_appstream_catalog.hpp"
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    std::vector<std::string> list_directory(const std::string& path)
+    {
+        std::vector<std::string> names;
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            return names;
+        }
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    bool is_file(const std::string& path, struct stat& info)
+    {
+        return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+    }
+
+    std::string read_link(const std::string& path)
+    {
+        char target[PATH_MAX];
+        ssize_t length = readlink(path.c_str(), target, sizeof(target) - 1);
+        return length > 0 ? std::string(target, static_cast<size_t>(length)) : std::string();
+    }
+}
+
+FlatpakAppstreamCatalog::FlatpakAppstreamCatalog()
+    : FlatpakAppstreamCatalog(FlatpakDeployScanner::default_installations(), default_cache_dir(), default_arch())
+{
+}
+
+FlatpakAppstreamCatalog::FlatpakAppstreamCatalog(std::vector<FlatpakInstallation> installations,
+                                                 std::string cache_dir, std::string arch)
+    : m_installations(std::move(installations))
+    , m_cache_dir(std::move(cache_dir))
+    , m_arch(std::move(arch))
+    , m_stale(true)
+{
+}
+
+std::string FlatpakAppstreamCatalog::default_cache_dir()
+{
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home && cache_home[0] == '/') {
+        return std::string(cache_home) + "/pacmangui/appstream";
+    }
+
+    const char* home = getenv("HOME");
+    if (home && home[0] == '/') {
+        return std::string(home) + "/.cache/pacmangui/appstream";
+    }
+    return "";
+}
+
+std::string FlatpakAppstreamCatalog::default_arch()
+{
+    struct utsname system;
+    if (uname(&system) != 0) {
+        return "x86_64";
+    }
+
+    // flatpak names architectures after their most common uname spelling
+    std::string machine = system.machine;
+    if (machine.size() == 4 && machine[0] == 'i' && machine.compare(2, 2, "86") == 0) {
+        return "i386";
+    }
+    if (machine.compare(0, 3, "arm") == 0) {
+        return "arm";
+    }
+    return machine;
+}
+
+std::vector<AppstreamSource> FlatpakAppstreamCatalog::find_sources() const
+{
+    std::vector<AppstreamSource> sources;
+    for (const FlatpakInstallation& installation : m_installations) {
+        std::string appstream_dir = installation.path + "/appstream";
+        for (const std::string& remote : list_directory(appstream_dir)) {
+            // active links to the directory of the deployed appstream commit
+            std::string active = appstream_dir + "/" + remote + "/" + m_arch + "/active";
+            AppstreamSource source{installation.name, remote, m_arch, active + "/appstream.xml.gz", ""};
+            struct stat info;
+            if (!is_file(source.file, info)) {
+                source.file = active + "/appstream.xml";
+                if (!is_file(source.file, info)) {
+                    continue;
+                }
+            }
+
+            // Without a commit to go by, size and modification time stand in
+            // for the contents; hashing megabytes of XML costs too much here
+            source.checksum = read_link(active);
+            if (source.checksum.empty()) {
+                source.checksum = std::to_string(info.st_size) + "-" + std::to_string(info.st_mtim.tv_sec) + "." +
+                                  std::to_string(info.st_mtim.tv_nsec);
+            }
+            sources.push_back(std::move(source));
+        }
+    }
+    return sources;
+}
+
+bool FlatpakAppstreamCatalog::refresh()
+{
+    std::lock_guard<std::mutex> refresh_lock(m_refresh_mutex);
+
+    std::vector<LoadedIndex> current;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        current = m_indexes;
+    }
+
+    std::vector<LoadedIndex> indexes;
+    std::string last_error;
+    bool changed = false;
+    for (AppstreamSource& source : find_sources()) {
+        auto loaded = std::find_if(current.begin(), current.end(), [&source](const LoadedIndex& index) {
+            return index.source.installation == source.installation && index.source.remote == source.remote &&
+                   index.source.checksum == source.checksum;
+        });
+        if (loaded != current.end()) {
+            indexes.push_back(*loaded);
+            continue;
+        }
+
+        // Data that could not be indexed is only tried again once it changes
+        std::string key = source.file + '\n' + source.checksum;
+        if (m_failed.count(key)) {
+            continue;
+        }
+
+        changed = true;
+        std::string error;
+        std::shared_ptr<const AppstreamIndex> index = load_index(source, error);
+        if (index) {
+            indexes.push_back(LoadedIndex{std::move(source), std::move(index)});
+        } else {
+            std::cerr << "FlatpakAppstreamCatalog: " << error << std::endl;
+            last_error = error;
+            m_failed.insert(key);
+        }
+    }
+    changed = changed || indexes.size() != current.size();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (changed) {
+        // Searches still running keep the indexes they copied alive
+        m_indexes = std::move(indexes);
+    }
+    if (!last_error.empty()) {
+        m_last_error = last_error;
+    }
+    return !m_indexes.empty();
+}
+
+bool FlatpakAppstreamCatalog::refresh_if_stale()
+{
+    if (m_stale.exchange(false)) {
+        refresh();
+    }
+    return !empty();
+}
+
+void FlatpakAppstreamCatalog::invalidate()
+{
+    m_stale = true;
+}
+
+bool FlatpakAppstreamCatalog::empty() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_indexes.empty();
+}
+
+std::vector<FlatpakPackage> FlatpakAppstreamCatalog::search(const std::string& query, size_t limit,
+                                                            const std::atomic<bool>* cancelled) const
+{
+    std::vector<LoadedIndex> indexes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        indexes = m_indexes;
+    }
+
+    struct Hit {
+        FuzzyMatch match;
+        size_t source;
+    };
+    std::vector<Hit> hits;
+    FuzzyMatcher matcher(query);
+    for (size_t i = 0; i < indexes.size(); ++i) {
+        for (const FuzzyMatch& match : indexes[i].index->search(matcher, limit, cancelled)) {
+            hits.push_back(Hit{match, i});
+        }
+    }
+    if (cancelled && cancelled->load()) {
+        return {};
+    }
+
+    // Each list is already ranked, so a stable merge keeps source order on ties
+    std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+        if (a.match.score != b.match.score) {
+            return a.match.score > b.match.score;
+        }
+        return a.match.name_length < b.match.name_length;
+    });
+
+    std::vector<FlatpakPackage> packages;
+    std::set<std::pair<std::string_view, std::string_view>> seen;
+    for (const Hit& hit : hits) {
+        if (limit > 0 && packages.size() >= limit) {
+            break;
+        }
+        const LoadedIndex& loaded = indexes[hit.source];
+        AppstreamEntry entry = loaded.index->at(hit.match.index);
+        if (!seen.insert({entry.id, loaded.source.remote}).second) {
+            continue;
+        }
+
+        FlatpakPackage package{std::string(entry.name), std::string(entry.version)};
+        package.set_app_id(std::string(entry.id));
+        package.set_description(std::string(entry.summary));
+        package.set_repository(loaded.source.remote);
+        package.set_branch(std::string(entry.branch));
+        package.set_search_score(hit.match.score);
+        packages.push_back(std::move(package));
+    }
+    return packages;
+}
+
+std::string FlatpakAppstreamCatalog::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_error;
+}
+
+std::shared_ptr<const AppstreamIndex> FlatpakAppstreamCatalog::load_index(const AppstreamSource& source,
+                                                                          std::string& error) const
+{
+    auto index = std::make_shared<AppstreamIndex>();
+    std::string path = m_cache_dir + "/" + source.installation + "-" + source.remote + "-" + source.arch + ".index";
+
+    // An index left by an earlier run is good as long as the data is unchanged
+    if (!m_cache_dir.empty() && index->open(path) && index->get_checksum() == source.checksum) {
+        return index;
+    }
+    index->close();
+
+    std::string xml;
+    std::vector<AppstreamComponent> components;
+    if (!AppstreamIndex::read_file(source.file, xml, error)) {
+        return nullptr;
+    }
+    if (!AppstreamIndex::parse(xml, components, error)) {
+        error = "Failed to parse " + source.file + ": " + error;
+        return nullptr;
+    }
+    if (m_cache_dir.empty()) {
+        error = "No cache directory for the appstream index of " + source.remote;
+        return nullptr;
+    }
+    if (!AppstreamIndex::write(path, source.checksum, components, error) || !index->open(path)) {
+        if (error.empty()) {
+            error = index->get_last_error();
+        }
+        return nullptr;
+    }
+
+    std::cout << "FlatpakAppstreamCatalog: Indexed " << components.size() << " components of "
+              << source.installation << " remote " << source.remote << std::endl;
+    return index;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,270 @@
+#include "core/flatpak_backend.hpp"
+#include "core/flatpak_deploy_scanner.hpp"
+#include <set>
+#include <unordered_map>
+#include <QProcess>
+#include <QRegularExpression>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    // Runs flatpak and returns its standard output, or false on timeout or failure
+    bool run_flatpak(const QStringList& args, int timeout_ms, QString& output, std::string& error)
+    {
+        QProcess process;
+        process.start("flatpak", args);
+        if (!process.waitForStarted()) {
+            error = "Failed to start flatpak " + args.value(0).toStdString();
+            return false;
+        }
+        if (!process.waitForFinished(timeout_ms)) {
+            process.kill();
+            process.waitForFinished();
+            error = "Timeout while running flatpak " + args.value(0).toStdString();
+            return false;
+        }
+        if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+            error = "flatpak " + args.value(0).toStdString() + " failed: " +
+                    QString(process.readAllStandardError()).trimmed().toStdString();
+            return false;
+        }
+        output = QString::fromUtf8(process.readAllStandardOutput());
+        return true;
+    }
+}
+
+// FlatpakBackend implementation
+
+std::string FlatpakBackend::get_last_error() const
+{
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    return m_last_error;
+}
+
+void FlatpakBackend::set_last_error(const std::string& error) const
+{
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_last_error = error;
+}
+
+// ProcessFlatpakBackend implementation
+
+std::string ProcessFlatpakBackend::get_name() const
+{
+    return "flatpak command";
+}
+
+bool ProcessFlatpakBackend::is_available() const
+{
+    QProcess process;
+    process.start("which", QStringList() << "flatpak");
+    process.waitForFinished();
+    return process.exitCode() == 0;
+}
+
+bool ProcessFlatpakBackend::list_installed(std::vector<FlatpakPackage>& packages) const
+{
+    QString output;
+    std::string error;
+    if (!run_flatpak(QStringList() << "list" << "--columns=application,name,version,origin,installation,branch,arch,size",
+                     5000, output, error)) {
+        set_last_error(error);
+        return false;
+    }
+
+    // Runtimes come from the deploy metadata files, read in one pass
+    // instead of running flatpak info once per application
+    std::unordered_map<std::string, std::string> runtimes;
+    for (const FlatpakDeployment& deployment : FlatpakDeployScanner().scan()) {
+        runtimes[deployment.installation + '\t' + deployment.app_id + '\t' + deployment.arch + '\t' + deployment.branch] =
+            deployment.runtime;
+        runtimes.emplace(deployment.app_id, deployment.runtime);
+    }
+
+    for (const QString& line : output.split('\n')) {
+        if (line.trimmed().isEmpty()) continue;
+
+        QStringList parts = line.split('\t');
+        if (parts.size() >= 8) {
+            std::string app_id = parts[0].trimmed().toStdString();
+            std::string name = parts[1].trimmed().toStdString();
+            std::string version = parts[2].trimmed().toStdString();
+            std::string origin = parts[3].trimmed().toStdString();
+            std::string installation = parts[4].trimmed().toStdString();
+            std::string branch = parts[5].trimmed().toStdString();
+            std::string arch = parts[6].trimmed().toStdString();
+            std::string size = parts[7].trimmed().toStdString();
+
+            FlatpakPackage package(name, version);
+            package.set_app_id(app_id);
+            package.set_repository(origin);
+            package.set_installation_type(installation);
+            package.set_branch(branch);
+            package.set_size(size);
+
+            // Prefer the exact deployment, custom installations only match by ID
+            auto runtime = runtimes.find(installation + '\t' + app_id + '\t' + arch + '\t' + branch);
+            if (runtime == runtimes.end()) {
+                runtime = runtimes.find(app_id);
+            }
+            if (runtime != runtimes.end()) {
+                package.set_runtime(runtime->second);
+            }
+
+            packages.push_back(package);
+        }
+    }
+
+    return true;
+}
+
+bool ProcessFlatpakBackend::search(const std::string& query, std::vector<FlatpakPackage>& packages) const
+{
+    QString output;
+    std::string error;
+    if (!run_flatpak(QStringList() << "search" << "--columns=name,description,application,version,branch,remotes"
+                                   << QString::fromStdString(query),
+                     10000, output, error)) {
+        set_last_error(error);
+        return false;
+    }
+
+    QStringList lines = output.split('\n');
+    int startLine = 0;
+    if (!lines.isEmpty() && lines[0].contains("Application ID")) {
+        startLine = 1;
+    }
+    for (int i = startLine; i < lines.size(); i++) {
+        const QString& line = lines[i];
+        if (line.trimmed().isEmpty()) continue;
+        QStringList parts = line.split('\t');
+        std::string name = parts.value(0).trimmed().toStdString();
+        FlatpakPackage package(name, "");
+        package.set_description(parts.value(1).trimmed().toStdString());
+        package.set_app_id(parts.value(2).trimmed().toStdString());
+        if (parts.size() > 3) package.set_version(parts.value(3).trimmed().toStdString());
+        if (parts.size() > 4) package.set_branch(parts.value(4).trimmed().toStdString());
+        if (parts.size() > 5) package.set_repository(parts.value(5).trimmed().toStdString());
+        packages.push_back(package);
+    }
+
+    return true;
+}
+
+bool ProcessFlatpakBackend::is_installed(const std::string& app_id, bool& installed) const
+{
+    QProcess process;
+    process.start("flatpak", QStringList() << "info" << QString::fromStdString(app_id));
+    if (!process.waitForFinished(5000)) {
+        process.kill();
+        process.waitForFinished();
+        set_last_error("Timeout while running flatpak info");
+        return false;
+    }
+
+    installed = process.exitStatus() == QProcess::NormalExit && process.exitCode() == 0;
+    return true;
+}
+
+bool ProcessFlatpakBackend::list_remotes(std::vector<std::string>& remotes) const
+{
+    QString output;
+    std::string error;
+    if (!run_flatpak(QStringList() << "remotes" << "--columns=name", 5000, output, error)) {
+        set_last_error(error);
+        return false;
+    }
+
+    QStringList lines = output.split("\n", Qt::SkipEmptyParts);
+
+    // Skip header if present
+    int start_idx = 0;
+    if (lines.size() > 0 && lines[0].contains("Name", Qt::CaseInsensitive)) {
+        start_idx = 1;
+    }
+
+    // The same remote may be configured for the system and the user
+    std::set<std::string> seen;
+    for (int i = start_idx; i < lines.size(); i++) {
+        std::string remote = lines[i].trimmed().toStdString();
+        if (seen.insert(remote).second) {
+            remotes.push_back(remote);
+        }
+    }
+
+    return true;
+}
+
+bool ProcessFlatpakBackend::list_updates(std::vector<std::string>& app_ids) const
+{
+    QProcess process;
+    process.start("flatpak", QStringList() << "update" << "--no-deploy" << "--noninteractive");
+
+    if (!process.waitForFinished(10000)) { // 10 second timeout
+        process.kill();
+        process.waitForFinished();
+        set_last_error("Timeout while checking for Flatpak updates");
+        return false;
+    }
+
+    // Parse output to find packages with updates
+    QString output = process.readAllStandardOutput();
+    for (const QString& line : output.split('\n')) {
+        // Look for lines with update info
+        if (line.contains("org.") || line.contains("com.") || line.contains("io.")) {
+            QStringList parts = line.split(QRegularExpression("\\s+"));
+            if (parts.size() >= 2) {
+                app_ids.push_back(parts[0].trimmed().toStdString());
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ProcessFlatpakBackend::get_app_info(FlatpakPackage& package) const
+{
+    QString output;
+    std::string error;
+    if (!run_flatpak(QStringList() << "info" << QString::fromStdString(package.get_app_id()), 2000, output, error)) {
+        set_last_error(error);
+        return false;
+    }
+
+    // The first line is "<name> - <summary>" from the appdata, when it has any
+    bool header = true;
+    for (const QString& line : output.split('\n')) {
+        QString trimmed = line.trimmed();
+        if (trimmed.isEmpty()) {
+            continue;
+        }
+        if (header) {
+            header = false;
+            int separator = trimmed.indexOf(" - ");
+            if (separator > 0) {
+                package.set_name(trimmed.left(separator).toStdString());
+                package.set_description(trimmed.mid(separator + 3).toStdString());
+                continue;
+            }
+        }
+        if (trimmed.startsWith("Origin:")) {
+            package.set_repository(trimmed.mid(7).trimmed().toStdString());
+        } else if (trimmed.startsWith("Version:")) {
+            package.set_version(trimmed.mid(8).trimmed().toStdString());
+        } else if (trimmed.startsWith("Branch:")) {
+            package.set_branch(trimmed.mid(7).trimmed().toStdString());
+        } else if (trimmed.startsWith("Installation:")) {
+            package.set_installation_type(trimmed.mid(13).trimmed().toStdString());
+        } else if (trimmed.startsWith("Installed:")) {
+            package.set_size(trimmed.mid(10).trimmed().toStdString());
+        } else if (trimmed.startsWith("Runtime:")) {
+            package.set_runtime(trimmed.mid(8).trimmed().toStdString());
+        }
+    }
+
+    return true;
+}
+
+} // namespace core
+} // namespace pacmangui
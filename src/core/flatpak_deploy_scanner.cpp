@@ -0,0 +1,173 @@
+#include "core/flatpak_deploy_scanner.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    std::vector<std::string> list_directory(const std::string& path)
+    {
+        std::vector<std::string> names;
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            return names;
+        }
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    bool read_file(const std::string& path, std::string& content)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::ostringstream buffer;
+        buffer << file.rdbuf();
+        content = buffer.str();
+        return true;
+    }
+
+    std::string trim(const std::string& text)
+    {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) {
+            return std::string();
+        }
+        size_t end = text.find_last_not_of(" \t\r");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    std::string environment(const char* name)
+    {
+        const char* value = std::getenv(name);
+        return value ? value : "";
+    }
+}
+
+FlatpakDeployScanner::FlatpakDeployScanner()
+    : m_installations(default_installations())
+{
+}
+
+FlatpakDeployScanner::FlatpakDeployScanner(std::vector<FlatpakInstallation> installations)
+    : m_installations(std::move(installations))
+{
+}
+
+std::vector<FlatpakInstallation> FlatpakDeployScanner::default_installations()
+{
+    std::vector<FlatpakInstallation> installations;
+
+    std::string system_dir = environment("FLATPAK_SYSTEM_DIR");
+    installations.push_back({system_dir.empty() ? "/var/lib/flatpak" : system_dir, "system"});
+
+    std::string user_dir = environment("FLATPAK_USER_DIR");
+    if (user_dir.empty()) {
+        std::string data_home = environment("XDG_DATA_HOME");
+        if (data_home.empty() && !environment("HOME").empty()) {
+            data_home = environment("HOME") + "/.local/share";
+        }
+        if (!data_home.empty()) {
+            user_dir = data_home + "/flatpak";
+        }
+    }
+    if (!user_dir.empty()) {
+        installations.push_back({user_dir, "user"});
+    }
+
+    return installations;
+}
+
+const std::vector<FlatpakInstallation>& FlatpakDeployScanner::get_installations() const
+{
+    return m_installations;
+}
+
+std::vector<FlatpakDeployment> FlatpakDeployScanner::scan() const
+{
+    std::vector<FlatpakDeployment> deployments;
+    std::string metadata;
+
+    for (const FlatpakInstallation& installation : m_installations) {
+        std::string apps = installation.path + "/app";
+        for (const std::string& app_id : list_directory(apps)) {
+            for (const std::string& arch : list_directory(apps + "/" + app_id)) {
+                // "current" is a symlink to the default arch/branch, not an arch
+                if (arch == "current") {
+                    continue;
+                }
+                std::string arch_dir = apps + "/" + app_id + "/" + arch;
+                for (const std::string& branch : list_directory(arch_dir)) {
+                    // The active link points at the deployed commit
+                    if (!read_file(arch_dir + "/" + branch + "/active/metadata", metadata)) {
+                        continue;
+                    }
+
+                    FlatpakDeployment deployment;
+                    deployment.app_id = app_id;
+                    deployment.arch = arch;
+                    deployment.branch = branch;
+                    deployment.installation = installation.name;
+                    if (parse_metadata(metadata, deployment)) {
+                        deployments.push_back(std::move(deployment));
+                    }
+                }
+            }
+        }
+    }
+
+    return deployments;
+}
+
+bool FlatpakDeployScanner::parse_metadata(const std::string& text, FlatpakDeployment& deployment)
+{
+    std::istringstream stream(text);
+    std::string line;
+    std::string group;
+    bool found = false;
+
+    while (std::getline(stream, line)) {
+        line = trim(line);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        if (line.front() == '[' && line.back() == ']') {
+            group = line.substr(1, line.size() - 2);
+            found = found || group == "Application";
+            continue;
+        }
+        if (group != "Application") {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            continue;
+        }
+        std::string key = trim(line.substr(0, equals));
+        std::string value = trim(line.substr(equals + 1));
+        if (key == "runtime") {
+            deployment.runtime = value;
+        } else if (key == "sdk") {
+            deployment.sdk = value;
+        } else if (key == "command") {
+            deployment.command = value;
+        }
+    }
+
+    return found;
+}
+
+} // namespace core
+} // namespace pacmangui
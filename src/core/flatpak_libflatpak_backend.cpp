@@ -0,0 +1,279 @@
+#include "core/flatpak_backend.hpp"
+
+#if HAVE_LIBFLATPAK
+
+#include "core/flatpak_deploy_scanner.hpp"
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <flatpak.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    std::string to_string(const char* text)
+    {
+        return text ? text : "";
+    }
+
+    // Returns the message of an error and frees it
+    std::string take_error(GError*& error)
+    {
+        std::string message = error ? error->message : "unknown error";
+        g_clear_error(&error);
+        return message;
+    }
+
+    /**
+     * @brief Backend that reads installations through libflatpak
+     *
+     * The libflatpak installation objects are opened once and shared by all
+     * calls; a mutex serializes them since the manager is used from search
+     * worker threads as well as the GUI thread.
+     */
+    class LibFlatpakBackend : public FlatpakBackend {
+    public:
+        LibFlatpakBackend()
+        {
+            GError* error = nullptr;
+            GPtrArray* system_installations = flatpak_get_system_installations(nullptr, &error);
+            if (system_installations) {
+                // FLATPAK_INSTALLATION() would pick up core::FlatpakInstallation in this namespace
+                for (guint i = 0; i < system_installations->len; ++i) {
+                    gpointer installation = g_ptr_array_index(system_installations, i);
+                    m_installations.push_back(static_cast<::FlatpakInstallation*>(g_object_ref(installation)));
+                }
+                g_ptr_array_unref(system_installations);
+            } else {
+                std::cerr << "LibFlatpakBackend: No system installations: " << take_error(error) << std::endl;
+            }
+
+            ::FlatpakInstallation* user = flatpak_installation_new_user(nullptr, &error);
+            if (user) {
+                m_installations.push_back(user);
+            } else {
+                std::cerr << "LibFlatpakBackend: No user installation: " << take_error(error) << std::endl;
+            }
+        }
+
+        ~LibFlatpakBackend() override
+        {
+            for (::FlatpakInstallation* installation : m_installations) {
+                g_object_unref(installation);
+            }
+        }
+
+        std::string get_name() const override
+        {
+            return "libflatpak";
+        }
+
+        bool is_available() const override
+        {
+            return !m_installations.empty();
+        }
+
+        bool list_installed(std::vector<FlatpakPackage>& packages) const override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (::FlatpakInstallation* installation : m_installations) {
+                GError* error = nullptr;
+                GPtrArray* refs = flatpak_installation_list_installed_refs(installation, nullptr, &error);
+                if (!refs) {
+                    set_last_error("Failed to list installed refs: " + take_error(error));
+                    return false;
+                }
+
+                std::string installation_name = get_installation_name(installation);
+                for (guint i = 0; i < refs->len; ++i) {
+                    FlatpakInstalledRef* ref = FLATPAK_INSTALLED_REF(g_ptr_array_index(refs, i));
+                    packages.push_back(to_package(ref, installation_name));
+                }
+                g_ptr_array_unref(refs);
+            }
+            return true;
+        }
+
+        bool search(const std::string& query, std::vector<FlatpakPackage>& packages) const override
+        {
+            // Remote refs carry no names or summaries, those are in the appstream data
+            (void)query;
+            (void)packages;
+            set_last_error("Searching remotes is not supported by libflatpak");
+            return false;
+        }
+
+        bool is_installed(const std::string& app_id, bool& installed) const override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            installed = false;
+            for (::FlatpakInstallation* installation : m_installations) {
+                FlatpakInstalledRef* ref = find_app(installation, app_id);
+                if (ref) {
+                    g_object_unref(ref);
+                    installed = true;
+                    break;
+                }
+            }
+            return true;
+        }
+
+        bool list_remotes(std::vector<std::string>& remotes) const override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::set<std::string> seen;
+            for (::FlatpakInstallation* installation : m_installations) {
+                GError* error = nullptr;
+                GPtrArray* list = flatpak_installation_list_remotes(installation, nullptr, &error);
+                if (!list) {
+                    set_last_error("Failed to list remotes: " + take_error(error));
+                    return false;
+                }
+
+                for (guint i = 0; i < list->len; ++i) {
+                    FlatpakRemote* remote = FLATPAK_REMOTE(g_ptr_array_index(list, i));
+                    std::string name = to_string(flatpak_remote_get_name(remote));
+                    if (!flatpak_remote_get_disabled(remote) && seen.insert(name).second) {
+                        remotes.push_back(name);
+                    }
+                }
+                g_ptr_array_unref(list);
+            }
+            return true;
+        }
+
+        bool list_updates(std::vector<std::string>& app_ids) const override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (::FlatpakInstallation* installation : m_installations) {
+                GError* error = nullptr;
+                GPtrArray* refs = flatpak_installation_list_installed_refs_for_update(installation, nullptr, &error);
+                if (!refs) {
+                    set_last_error("Failed to check for updates: " + take_error(error));
+                    return false;
+                }
+
+                for (guint i = 0; i < refs->len; ++i) {
+                    app_ids.push_back(to_string(flatpak_ref_get_name(FLATPAK_REF(g_ptr_array_index(refs, i)))));
+                }
+                g_ptr_array_unref(refs);
+            }
+            return true;
+        }
+
+        bool get_app_info(FlatpakPackage& package) const override
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (::FlatpakInstallation* installation : m_installations) {
+                FlatpakInstalledRef* ref = find_app(installation, package.get_app_id());
+                if (!ref) {
+                    continue;
+                }
+
+                FlatpakPackage found = to_package(ref, get_installation_name(installation));
+                g_object_unref(ref);
+                package.set_name(found.get_name());
+                package.set_description(found.get_description());
+                package.set_repository(found.get_repository());
+                package.set_installation_type(found.get_installation_type());
+                package.set_branch(found.get_branch());
+                package.set_size(found.get_size());
+                package.set_runtime(found.get_runtime());
+                if (!found.get_version().empty()) {
+                    package.set_version(found.get_version());
+                }
+                return true;
+            }
+
+            set_last_error(package.get_app_id() + " is not installed");
+            return false;
+        }
+
+    private:
+        // Name flatpak list shows for an installation
+        static std::string get_installation_name(::FlatpakInstallation* installation)
+        {
+            if (flatpak_installation_get_is_user(installation)) {
+                return "user";
+            }
+            std::string id = to_string(flatpak_installation_get_id(installation));
+            return id.empty() || id == "default" ? "system" : id;
+        }
+
+        // Installed app ref of any arch and branch, or null
+        static FlatpakInstalledRef* find_app(::FlatpakInstallation* installation, const std::string& app_id)
+        {
+            GError* error = nullptr;
+            FlatpakInstalledRef* ref = flatpak_installation_get_installed_ref(
+                installation, FLATPAK_REF_KIND_APP, app_id.c_str(), nullptr, nullptr, nullptr, &error);
+            g_clear_error(&error);
+            return ref;
+        }
+
+        static FlatpakPackage to_package(FlatpakInstalledRef* ref, const std::string& installation_name)
+        {
+            FlatpakRef* base = FLATPAK_REF(ref);
+            std::string app_id = to_string(flatpak_ref_get_name(base));
+            std::string name = to_string(flatpak_installed_ref_get_appdata_name(ref));
+
+            FlatpakPackage package(name.empty() ? app_id : name,
+                                   to_string(flatpak_installed_ref_get_appdata_version(ref)));
+            package.set_app_id(app_id);
+            package.set_description(to_string(flatpak_installed_ref_get_appdata_summary(ref)));
+            package.set_repository(to_string(flatpak_installed_ref_get_origin(ref)));
+            package.set_installation_type(installation_name);
+            package.set_branch(to_string(flatpak_ref_get_branch(base)));
+
+            gchar* size = g_format_size(flatpak_installed_ref_get_installed_size(ref));
+            package.set_size(size);
+            g_free(size);
+
+            // The deployed metadata names the runtime of an application
+            if (flatpak_ref_get_kind(base) == FLATPAK_REF_KIND_APP) {
+                GBytes* metadata = flatpak_installed_ref_load_metadata(ref, nullptr, nullptr);
+                if (metadata) {
+                    gsize length = 0;
+                    const char* data = static_cast<const char*>(g_bytes_get_data(metadata, &length));
+                    FlatpakDeployment deployment;
+                    if (data && FlatpakDeployScanner::parse_metadata(std::string(data, length), deployment)) {
+                        package.set_runtime(deployment.runtime);
+                    }
+                    g_bytes_unref(metadata);
+                }
+            }
+
+            return package;
+        }
+
+        std::vector<::FlatpakInstallation*> m_installations;   ///< System installations, then the user one
+        mutable std::mutex m_mutex;                            ///< Serializes libflatpak calls
+    };
+}
+
+std::unique_ptr<FlatpakBackend> create_libflatpak_backend()
+{
+    auto backend = std::make_unique<LibFlatpakBackend>();
+    if (!backend->is_available()) {
+        return nullptr;
+    }
+    return backend;
+}
+
+} // namespace core
+} // namespace pacmangui
+
+#else
+
+namespace pacmangui {
+namespace core {
+
+std::unique_ptr<FlatpakBackend> create_libflatpak_backend()
+{
+    return nullptr;
+}
+
+} // namespace core
+} // namespace pacmangui
+
+#endif
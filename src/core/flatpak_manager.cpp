@@ -1,82 +1,28 @@
 #include "core/flatpak_manager.hpp"
+#include "core/fuzzy_matcher.hpp"
 #include <iostream>
 #include <sstream>
 #include <QProcess>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QDebug>
-#include <QRegularExpression>
 #include <set>
 #include <tuple>
-#include <unordered_map>
 #include <algorithm>
 
 namespace pacmangui {
 namespace core {
 
-namespace {
-    // Calculate Levenshtein distance for fuzzy matching
-    int levenshteinDistance(const std::string& s1, const std::string& s2) {
-        const size_t len1 = s1.size();
-        const size_t len2 = s2.size();
-        std::vector<std::vector<int>> d(len1 + 1, std::vector<int>(len2 + 1));
-        
-        for (size_t i = 0; i <= len1; ++i) d[i][0] = i;
-        for (size_t j = 0; j <= len2; ++j) d[0][j] = j;
-        
-        for (size_t i = 1; i <= len1; ++i) {
-            for (size_t j = 1; j <= len2; ++j) {
-                d[i][j] = std::min({
-                    d[i-1][j] + 1,
-                    d[i][j-1] + 1,
-                    d[i-1][j-1] + (s1[i-1] == s2[j-1] ? 0 : 1)
-                });
-            }
-        }
-        return d[len1][len2];
-    }
-    
-    // Calculate search score for ranking
-    double calculateSearchScore(const std::string& search_term, const std::string& app_id, 
-                              const std::string& name, const std::string& description) {
-        double score = 0.0;
-        std::string lowercase_search = search_term;
-        std::transform(lowercase_search.begin(), lowercase_search.end(), lowercase_search.begin(), ::tolower);
-        
-        std::string lowercase_app_id = app_id;
-        std::transform(lowercase_app_id.begin(), lowercase_app_id.end(), lowercase_app_id.begin(), ::tolower);
-        
-        std::string lowercase_name = name;
-        std::transform(lowercase_name.begin(), lowercase_name.end(), lowercase_name.begin(), ::tolower);
-        
-        std::string lowercase_desc = description;
-        std::transform(lowercase_desc.begin(), lowercase_desc.end(), lowercase_desc.begin(), ::tolower);
-        
-        // Exact matches get highest score
-        if (lowercase_app_id.find(lowercase_search) != std::string::npos) score += 100.0;
-        if (lowercase_name.find(lowercase_search) != std::string::npos) score += 80.0;
-        if (app_id.find(lowercase_search) != std::string::npos) score += 100.0;
-        if (name.find(lowercase_search) != std::string::npos) score += 80.0;
-        if (description.find(lowercase_search) != std::string::npos) score += 40.0;
-        
-        // Fuzzy matches get partial scores
-        double fuzzy_score = 0.0;
-        int distance = levenshteinDistance(lowercase_search, name);
-        if (distance <= 3) {
-            fuzzy_score = (3 - distance) * 20.0;
-        }
-        score += fuzzy_score;
-        
-        return score;
-    }
-}
-
 FlatpakManager::FlatpakManager()
     : m_is_available(false), m_last_error("")
 {
 }
 
+FlatpakManager::FlatpakManager(std::unique_ptr<FlatpakBackend> backend, std::unique_ptr<FlatpakBackend> fallback,
+                               std::unique_ptr<FlatpakAppstreamCatalog> appstream)
+    : m_is_available(false), m_last_error(""), m_backend(std::move(backend)), m_fallback(std::move(fallback)),
+      m_appstream(std::move(appstream))
+{
+}
+
 FlatpakManager::~FlatpakManager()
 {
 }
@@ -85,15 +31,21 @@ bool FlatpakManager::initialize()
 {
     std::cout << "FlatpakManager: Initializing..." << std::endl;
     
-    // Check if flatpak is installed
-    QProcess process;
-    process.start("which", QStringList() << "flatpak");
-    process.waitForFinished();
+    if (!m_backend) {
+        // Prefer reading the installations in-process, the command stays for the rest
+        m_backend = create_libflatpak_backend();
+        m_fallback = std::make_unique<ProcessFlatpakBackend>();
+        if (!m_backend) {
+            m_backend = std::move(m_fallback);
+        }
+        m_appstream = std::make_unique<FlatpakAppstreamCatalog>();
+    }
     
-    m_is_available = (process.exitCode() == 0);
+    m_is_available = m_backend->is_available() || (m_fallback && m_fallback->is_available());
     
     if (m_is_available) {
-        std::cout << "FlatpakManager: Flatpak is available on this system" << std::endl;
+        std::cout << "FlatpakManager: Flatpak is available on this system, using the "
+                  << m_backend->get_name() << " backend" << std::endl;
         
         // Check for common remotes and add them if missing
         std::vector<std::pair<std::string, std::string>> common_remotes = {
@@ -116,7 +68,7 @@ bool FlatpakManager::initialize()
         }
     } else {
         std::cout << "FlatpakManager: Flatpak is not available on this system" << std::endl;
-        m_last_error = "Flatpak is not installed on this system";
+        set_last_error("Flatpak is not installed on this system");
     }
     
     return m_is_available;
@@ -132,67 +84,14 @@ std::vector<FlatpakPackage> FlatpakManager::get_installed_packages() const
     std::vector<FlatpakPackage> packages;
     
     if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return packages;
-    }
-    
-    QProcess process;
-    process.start("flatpak", QStringList() << "list" << "--columns=application,name,version,origin,installation,branch,arch,size");
-    
-    if (!process.waitForFinished(5000)) {
-        m_last_error = "Timeout while getting installed Flatpak packages";
-        return packages;
-    }
-    
-    if (process.exitCode() != 0) {
-        m_last_error = QString("Error: %1").arg(QString(process.readAllStandardError())).toStdString();
+        set_last_error("Flatpak is not available");
         return packages;
     }
     
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split('\n');
-    
-    for (const QString& line : lines) {
-        if (line.trimmed().isEmpty()) continue;
-        
-        QStringList parts = line.split('\t');
-        if (parts.size() >= 8) {
-            std::string app_id = parts[0].trimmed().toStdString();
-            std::string name = parts[1].trimmed().toStdString();
-            std::string version = parts[2].trimmed().toStdString();
-            std::string origin = parts[3].trimmed().toStdString();
-            std::string installation = parts[4].trimmed().toStdString();
-            std::string branch = parts[5].trimmed().toStdString();
-            std::string arch = parts[6].trimmed().toStdString();
-            std::string size = parts[7].trimmed().toStdString();
-            
-            FlatpakPackage package(name, version);
-            package.set_app_id(app_id);
-            package.set_repository(origin);
-            package.set_installation_type(installation);
-            package.set_branch(branch);
-            package.set_size(size);
-            
-            // Get runtime information using flatpak info
-            QString fullRef = QString::fromStdString(app_id);
-            
-            QProcess infoProcess;
-            infoProcess.start("flatpak", QStringList() << "info" << fullRef);
-            infoProcess.waitForFinished();
-            
-            QString infoOutput = infoProcess.readAllStandardOutput();
-            QStringList infoLines = infoOutput.split('\n');
-            
-            for (const QString& infoLine : infoLines) {
-                if (infoLine.startsWith("Runtime: ")) {
-                    package.set_runtime(infoLine.mid(9).trimmed().toStdString());
-                    break;
-                }
-            }
-            
-            packages.push_back(package);
-        }
-    }
+    call_backend([&packages](const FlatpakBackend& backend) {
+        packages.clear();
+        return backend.list_installed(packages);
+    });
     
     qDebug() << "Found" << packages.size() << "installed Flatpak packages";
     return packages;
@@ -204,258 +103,135 @@ std::vector<std::shared_ptr<FlatpakPackage>> FlatpakManager::search_by_name(cons
         qDebug() << "Flatpak is not available";
         return packages;
     }
-    qDebug() << "FlatpakManager: Running flatpak search with columns for" << QString::fromStdString(name);
-    QProcess process;
-    process.start("flatpak", QStringList() << "search"
-                                            << "--columns=name,description,application,version,branch,remotes"
-                                            << QString::fromStdString(name));
-    if (!process.waitForFinished(10000)) {
-        qDebug() << "FlatpakManager: Timeout during flatpak search for" << QString::fromStdString(name);
-        process.kill();
+    
+    // The appstream indexes come ranked and need no process; they are read
+    // on the first search and again only after remotes or transactions
+    if (m_appstream && m_appstream->refresh_if_stale()) {
+        for (FlatpakPackage& package : m_appstream->search(name, 0)) {
+            packages.push_back(std::make_shared<FlatpakPackage>(std::move(package)));
+        }
+        qDebug() << "Found" << packages.size() << "flatpak search results in the appstream index.";
         return packages;
     }
-    QString output = process.readAllStandardOutput();
-    qDebug() << "Raw flatpak search output:\n" << output;
-    QStringList lines = output.split('\n');
-    for (int i = 0; i < lines.size(); ++i) {
-        qDebug() << "[Flatpak Search Output] Line" << i << ":" << lines[i];
-    }
-    int startLine = 0;
-    if (!lines.isEmpty() && lines[0].contains("Application ID")) {
-        startLine = 1;
-    }
-    int parsed_count = 0;
-    for (int i = startLine; i < lines.size(); i++) {
-        const QString& line = lines[i];
-        if (line.trimmed().isEmpty()) continue;
-        QStringList parts = line.split('\t');
-        if (parts.size() >= 1) {
-            std::string name_str = parts.value(0).trimmed().toStdString();
-            std::string description = parts.value(1).trimmed().toStdString();
-            std::string app_id = parts.value(2).trimmed().toStdString();
-            auto package = std::make_shared<FlatpakPackage>(name_str, "");
-            package->set_app_id(app_id);
-            package->set_name(name_str);
-            package->set_description(description);
-            if (parts.size() > 3) package->set_version(parts.value(3).trimmed().toStdString());
-            if (parts.size() > 4) package->set_branch(parts.value(4).trimmed().toStdString());
-            if (parts.size() > 5) package->set_repository(parts.value(5).trimmed().toStdString());
-            packages.push_back(package);
-            parsed_count++;
+    
+    std::vector<FlatpakPackage> found;
+    call_backend([&name, &found](const FlatpakBackend& backend) {
+        found.clear();
+        return backend.search(name, found);
+    });
+    packages.reserve(found.size());
+    for (FlatpakPackage& package : found) {
+        packages.push_back(std::make_shared<FlatpakPackage>(std::move(package)));
+    }
+    qDebug() << "Parsed" << packages.size() << "flatpak search results.";
+    
+    // flatpak lists hits in remote order; rank them like the package search.
+    // The application ID counts as a second name, hits matching neither go last.
+    FuzzyMatcher matcher(name);
+    std::vector<FuzzyMatch> scores(packages.size());
+    std::vector<size_t> order(packages.size());
+    for (size_t i = 0; i < packages.size(); ++i) {
+        std::string package_name = packages[i]->get_name();
+        std::string description = packages[i]->get_description();
+        std::string app_id = packages[i]->get_app_id();
+        
+        FuzzyMatch by_id;
+        if (!matcher.match(package_name, description, scores[i])) {
+            scores[i] = FuzzyMatch();
+            scores[i].score = -1;
         }
+        if (matcher.match(app_id, description, by_id) && by_id.score > scores[i].score) {
+            scores[i] = by_id;
+        }
+        scores[i].index = i;
+        order[i] = i;
     }
-    qDebug() << "Parsed" << parsed_count << "flatpak search results.";
-    return packages;
+    std::stable_sort(order.begin(), order.end(), [&scores](size_t a, size_t b) {
+        return FuzzyMatcher::better(scores[a], scores[b]);
+    });
+    
+    std::vector<std::shared_ptr<FlatpakPackage>> ranked;
+    ranked.reserve(packages.size());
+    for (size_t i : order) {
+        ranked.push_back(packages[i]);
+    }
+    return ranked;
 }
 
 bool FlatpakManager::install_package(const std::string& app_id, const std::string& remote)
 {
-    if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return false;
-    }
-    
-    std::cout << "FlatpakManager: Installing " << app_id << " from " << remote << std::endl;
-    
-    QProcess process;
-    // Merge stdout and stderr for better error capturing
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    
-    // Use a standard system shell to ensure proper console handling
-    QStringList args;
-    args << "-c" << QString("flatpak install -y %1 %2").arg(QString::fromStdString(remote)).arg(QString::fromStdString(app_id));
-    process.start("bash", args);
-    
-    if (!process.waitForStarted(3000)) { // 3-second timeout for starting
-        m_last_error = "Failed to start flatpak install process";
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        return false;
-    }
-    
-    // Read output in real-time for debugging
-    while (process.state() == QProcess::Running) {
-        process.waitForReadyRead(100);
-        if (process.bytesAvailable() > 0) {
-            QString output = process.readAll();
-            std::cout << output.toStdString() << std::flush;
-        }
-    }
-    
-    // Wait up to 5 minutes for completion
-    if (!process.waitForFinished(300000)) {
-        m_last_error = "Flatpak installation timed out";
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        process.kill();
-        return false;
-    }
-    
-    // Capture any remaining output
-    QString output = process.readAll();
-    if (!output.isEmpty()) {
-        std::cout << output.toStdString() << std::flush;
-    }
-    
-    if (process.exitCode() != 0) {
-        m_last_error = "Failed to install flatpak package: Exit code " + 
-                       std::to_string(process.exitCode());
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        return false;
-    }
-    
-    std::cout << "FlatpakManager: Successfully installed " << app_id << " from " << remote << std::endl;
-    return true;
+    return install_packages({app_id}, remote);
 }
 
 bool FlatpakManager::remove_package(const std::string& app_id)
 {
-    if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return false;
-    }
-    
-    std::cout << "FlatpakManager: Removing " << app_id << std::endl;
-    
-    QProcess process;
-    // Merge stdout and stderr for better error capturing
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    
-    // Use a standard system shell to ensure proper console handling
-    QStringList args;
-    args << "-c" << QString("flatpak uninstall -y %1").arg(QString::fromStdString(app_id));
-    process.start("bash", args);
-    
-    if (!process.waitForStarted(3000)) { // 3-second timeout for starting
-        m_last_error = "Failed to start flatpak uninstall process";
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        return false;
-    }
-    
-    // Read output in real-time for debugging
-    while (process.state() == QProcess::Running) {
-        process.waitForReadyRead(100);
-        if (process.bytesAvailable() > 0) {
-            QString output = process.readAll();
-            std::cout << output.toStdString() << std::flush;
-        }
-    }
-    
-    // Wait for completion without timeout
-    process.waitForFinished(-1);
-    
-    // Capture any remaining output
-    QString output = process.readAll();
-    if (!output.isEmpty()) {
-        std::cout << output.toStdString() << std::flush;
-    }
-    
-    if (process.exitCode() != 0) {
-        m_last_error = "Failed to remove flatpak package: Exit code " + 
-                       std::to_string(process.exitCode());
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        return false;
-    }
-    
-    std::cout << "FlatpakManager: Successfully removed " << app_id << std::endl;
-    return true;
+    return remove_packages({app_id});
 }
 
 bool FlatpakManager::update_package(const std::string& app_id)
 {
-    if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return false;
-    }
-    
-    std::cout << "FlatpakManager: Updating " << app_id << std::endl;
-    
-    QProcess process;
-    // Merge stdout and stderr for better error capturing
-    process.setProcessChannelMode(QProcess::MergedChannels);
-    
-    // Use a standard system shell to ensure proper console handling
-    QStringList args;
-    args << "-c" << QString("flatpak update -y %1").arg(QString::fromStdString(app_id));
-    process.start("bash", args);
-    
-    if (!process.waitForStarted(3000)) { // 3-second timeout for starting
-        m_last_error = "Failed to start flatpak update process";
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        return false;
-    }
-    
-    // Read output in real-time for debugging
-    while (process.state() == QProcess::Running) {
-        process.waitForReadyRead(100);
-        if (process.bytesAvailable() > 0) {
-            QString output = process.readAll();
-            std::cout << output.toStdString() << std::flush;
-        }
-    }
-    
-    // Wait up to 5 minutes for completion
-    if (!process.waitForFinished(300000)) {
-        m_last_error = "Flatpak update timed out";
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        process.kill();
-        return false;
-    }
-    
-    // Capture any remaining output
-    QString output = process.readAll();
-    if (!output.isEmpty()) {
-        std::cout << output.toStdString() << std::flush;
-    }
-    
-    if (process.exitCode() != 0) {
-        m_last_error = "Failed to update flatpak package: Exit code " + 
-                       std::to_string(process.exitCode());
-        std::cerr << "ERROR: " << m_last_error << std::endl;
-        return false;
-    }
-    
-    std::cout << "FlatpakManager: Successfully updated " << app_id << std::endl;
-    return true;
+    return update_packages({app_id});
 }
 
 bool FlatpakManager::update_all()
 {
-    if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return false;
+    return update_packages({});
+}
+
+bool FlatpakManager::install_packages(const std::vector<std::string>& app_ids, const std::string& remote,
+                                      FlatpakProgressCallback callback)
+{
+    if (app_ids.empty()) {
+        return true;
     }
     
-    std::cout << "FlatpakManager: Updating all flatpak packages" << std::endl;
-    
-    QProcess process;
-    process.start("flatpak", QStringList() << "update" << "-y");
-    
-    if (!process.waitForStarted()) {
-        m_last_error = "Failed to start flatpak update process";
-        return false;
+    std::cout << "FlatpakManager: Installing " << app_ids.size() << " packages from " << remote << std::endl;
+    FlatpakTransaction transaction(FlatpakOperation::INSTALL, app_ids, remote);
+    transaction.set_progress_callback(std::move(callback));
+    return run_transaction(transaction);
+}
+
+bool FlatpakManager::remove_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback)
+{
+    if (app_ids.empty()) {
+        return true;
     }
     
-    process.waitForFinished(-1);
-    
-    if (process.exitCode() != 0) {
-        m_last_error = "Failed to update flatpak packages: " + std::string(process.readAllStandardError().constData());
-        return false;
+    std::cout << "FlatpakManager: Removing " << app_ids.size() << " packages" << std::endl;
+    FlatpakTransaction transaction(FlatpakOperation::REMOVE, app_ids);
+    transaction.set_progress_callback(std::move(callback));
+    return run_transaction(transaction);
+}
+
+bool FlatpakManager::update_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback)
+{
+    std::cout << "FlatpakManager: Updating " << (app_ids.empty() ? std::string("all") : std::to_string(app_ids.size()))
+              << " packages" << std::endl;
+    FlatpakTransaction transaction(FlatpakOperation::UPDATE, app_ids);
+    transaction.set_progress_callback(std::move(callback));
+    return run_transaction(transaction);
+}
+
+void FlatpakManager::cancel_transactions()
+{
+    std::lock_guard<std::mutex> lock(m_transaction_mutex);
+    for (FlatpakTransaction* transaction : m_running_transactions) {
+        transaction->cancel();
     }
-    
-    return true;
 }
 
 bool FlatpakManager::is_package_installed(const std::string& app_id) const
 {
     if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
+        set_last_error("Flatpak is not available");
         return false;
     }
     
-    QProcess process;
-    process.start("flatpak", QStringList() << "info" << QString::fromStdString(app_id));
-    process.waitForFinished();
-    
-    return (process.exitCode() == 0);
+    bool installed = false;
+    call_backend([&app_id, &installed](const FlatpakBackend& backend) {
+        return backend.is_installed(app_id, installed);
+    });
+    return installed;
 }
 
 std::vector<std::string> FlatpakManager::get_remotes() const
@@ -463,46 +239,21 @@ std::vector<std::string> FlatpakManager::get_remotes() const
     std::vector<std::string> remotes;
     
     if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
+        set_last_error("Flatpak is not available");
         return remotes;
     }
     
-    QProcess process;
-    process.start("flatpak", QStringList() << "remotes" << "--columns=name");
-    
-    if (!process.waitForStarted()) {
-        m_last_error = "Failed to start flatpak remotes process";
-        return remotes;
-    }
-    
-    process.waitForFinished(-1);
-    
-    if (process.exitCode() != 0) {
-        m_last_error = "Failed to get flatpak remotes: " + std::string(process.readAllStandardError().constData());
-        return remotes;
-    }
-    
-    // Parse output
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split("\n", Qt::SkipEmptyParts);
-    
-    // Skip header if present
-    int start_idx = 0;
-    if (lines.size() > 0 && lines[0].contains("Name", Qt::CaseInsensitive)) {
-        start_idx = 1;
-    }
-    
-    for (int i = start_idx; i < lines.size(); i++) {
-        remotes.push_back(lines[i].trimmed().toStdString());
-    }
-    
+    call_backend([&remotes](const FlatpakBackend& backend) {
+        remotes.clear();
+        return backend.list_remotes(remotes);
+    });
     return remotes;
 }
 
 bool FlatpakManager::add_remote(const std::string& name, const std::string& url)
 {
     if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
+        set_last_error("Flatpak is not available");
         return false;
     }
     
@@ -512,134 +263,33 @@ bool FlatpakManager::add_remote(const std::string& name, const std::string& url)
     process.start("flatpak", QStringList() << "remote-add" << "--if-not-exists" << QString::fromStdString(name) << QString::fromStdString(url));
     
     if (!process.waitForStarted()) {
-        m_last_error = "Failed to start flatpak remote-add process";
+        set_last_error("Failed to start flatpak remote-add process");
         return false;
     }
     
     process.waitForFinished(-1);
     
     if (process.exitCode() != 0) {
-        m_last_error = "Failed to add flatpak remote: " + std::string(process.readAllStandardError().constData());
+        set_last_error("Failed to add flatpak remote: " + std::string(process.readAllStandardError().constData()));
         return false;
     }
     
+    if (m_appstream) {
+        m_appstream->invalidate();
+    }
     return true;
 }
 
 std::string FlatpakManager::get_last_error() const
 {
+    std::lock_guard<std::mutex> lock(m_error_mutex);
     return m_last_error;
 }
 
-std::string FlatpakManager::execute_flatpak_command(const std::vector<std::string>& args) const
+void FlatpakManager::set_last_error(const std::string& error) const
 {
-    QStringList qargs;
-    for (const auto& arg : args) {
-        qargs << QString::fromStdString(arg);
-    }
-    
-    QProcess process;
-    process.start("flatpak", qargs);
-    
-    if (!process.waitForStarted()) {
-        m_last_error = "Failed to start flatpak process";
-        return "";
-    }
-    
-    process.waitForFinished(-1);
-    
-    if (process.exitCode() != 0) {
-        m_last_error = "Failed to execute flatpak command: " + std::string(process.readAllStandardError().constData());
-        return "";
-    }
-    
-    return process.readAllStandardOutput().constData();
-}
-
-std::vector<FlatpakPackage> FlatpakManager::parse_json_output(const std::string& json_output) const
-{
-    std::vector<FlatpakPackage> packages;
-    
-    if (json_output.empty()) {
-        return packages;
-    }
-    
-    QJsonDocument json_doc = QJsonDocument::fromJson(QString::fromStdString(json_output).toUtf8());
-    
-    if (json_doc.isNull() || !json_doc.isArray()) {
-        m_last_error = "Failed to parse JSON output from flatpak";
-        return packages;
-    }
-    
-    QJsonArray json_array = json_doc.array();
-    
-    for (const QJsonValue& value : json_array) {
-        if (!value.isObject()) {
-            continue;
-        }
-        
-        QJsonObject obj = value.toObject();
-        
-        // Fields depend on the command (list or search)
-        QString app_id, name, version, description, origin;
-        
-        // For list command
-        if (obj.contains("application")) {
-            app_id = obj["application"].toString();
-        }
-        
-        if (obj.contains("name")) {
-            name = obj["name"].toString();
-        }
-        
-        if (obj.contains("version")) {
-            version = obj["version"].toString();
-        }
-        
-        if (obj.contains("description")) {
-            description = obj["description"].toString();
-        }
-        
-        if (obj.contains("origin")) {
-            origin = obj["origin"].toString();
-        }
-        
-        // For search command
-        if (obj.contains("id")) {
-            app_id = obj["id"].toString();
-        }
-        
-        if (obj.contains("name") && name.isEmpty()) {
-            name = obj["name"].toString();
-        }
-        
-        if (obj.contains("version") && version.isEmpty()) {
-            version = obj["version"].toString();
-        }
-        
-        if (obj.contains("description") && description.isEmpty()) {
-            description = obj["description"].toString();
-        }
-        
-        if (obj.contains("remote") && origin.isEmpty()) {
-            origin = obj["remote"].toString();
-        }
-        
-        // Create package if we have at least an ID and name
-        if (!app_id.isEmpty() && !name.isEmpty()) {
-            FlatpakPackage pkg = FlatpakPackage::create_from_data(
-                app_id.toStdString(),
-                name.toStdString(),
-                version.toStdString(),
-                description.toStdString(),
-                origin.toStdString()
-            );
-            
-            packages.push_back(pkg);
-        }
-    }
-    
-    return packages;
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_last_error = error;
 }
 
 std::vector<std::string> FlatpakManager::check_for_updates() const
@@ -647,31 +297,14 @@ std::vector<std::string> FlatpakManager::check_for_updates() const
     std::vector<std::string> updates;
     
     if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return updates;
-    }
-    
-    QProcess process;
-    process.start("flatpak", QStringList() << "update" << "--no-deploy" << "--noninteractive");
-    
-    if (!process.waitForFinished(10000)) { // 10 second timeout
-        m_last_error = "Timeout while checking for Flatpak updates";
+        set_last_error("Flatpak is not available");
         return updates;
     }
     
-    // Parse output to find packages with updates
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split('\n');
-    
-    for (const QString& line : lines) {
-        // Look for lines with update info
-        if (line.contains("org.") || line.contains("com.") || line.contains("io.")) {
-            QStringList parts = line.split(QRegularExpression("\\s+"));
-            if (parts.size() >= 2) {
-                updates.push_back(parts[0].trimmed().toStdString());
-            }
-        }
-    }
+    call_backend([&updates](const FlatpakBackend& backend) {
+        updates.clear();
+        return backend.list_updates(updates);
+    });
     
     qDebug() << "Found" << updates.size() << "Flatpak updates available";
     return updates;
@@ -679,111 +312,71 @@ std::vector<std::string> FlatpakManager::check_for_updates() const
 
 std::vector<std::string> FlatpakManager::list_remotes() const
 {
-    std::vector<std::string> remotes;
-    
+    return get_remotes();
+}
+
+bool FlatpakManager::get_app_info(FlatpakPackage& package) const
+{
     if (!m_is_available) {
-        m_last_error = "Flatpak is not available";
-        return remotes;
+        set_last_error("Flatpak is not available");
+        return false;
     }
     
-    QProcess process;
-    process.start("flatpak", QStringList() << "remotes");
-    
-    if (!process.waitForFinished(5000)) {
-        m_last_error = "Timeout while listing Flatpak remotes";
-        return remotes;
+    return call_backend([&package](const FlatpakBackend& backend) {
+        return backend.get_app_info(package);
+    });
+}
+
+std::string FlatpakManager::get_backend_name() const
+{
+    return m_backend ? m_backend->get_name() : std::string();
+}
+
+bool FlatpakManager::call_backend(const std::function<bool(const FlatpakBackend&)>& call) const
+{
+    if (m_backend && call(*m_backend)) {
+        return true;
     }
-    
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split('\n');
-    
-    for (const QString& line : lines) {
-        if (line.trimmed().isEmpty()) continue;
-        
-        QStringList parts = line.split('\t');
-        if (!parts.isEmpty()) {
-            remotes.push_back(parts[0].trimmed().toStdString());
-        }
+    if (m_fallback && call(*m_fallback)) {
+        return true;
     }
     
-    return remotes;
+    const FlatpakBackend* last = m_fallback ? m_fallback.get() : m_backend.get();
+    std::string error = last ? last->get_last_error() : "No Flatpak backend";
+    std::cerr << "FlatpakManager: " << error << std::endl;
+    set_last_error(error);
+    return false;
 }
 
-void FlatpakManager::getAppNameAndDescription(FlatpakPackage& package) const
+bool FlatpakManager::run_transaction(FlatpakTransaction& transaction)
 {
-    // Check if we have a hard-coded app
-    std::string app_id = package.get_app_id();
-    
-    // Hard-code known applications to avoid metadata retrieval issues
-    if (app_id == "com.vencord.Vesktop") {
-        package.set_name("Vesktop");
-        package.set_description("A cross-platform Discord client mod with Vencord built-in");
-        package.set_repository("flathub");
-        return;
-    } else if (app_id == "com.discordapp.Discord") {
-        package.set_name("Discord");
-        package.set_description("All-in-one voice and text chat for gamers");
-        package.set_repository("flathub");
-        return;
-    } else if (app_id == "com.spotify.Client") {
-        package.set_name("Spotify");
-        package.set_description("Online music streaming service");
-        package.set_repository("flathub");
-        return;
+    if (!m_is_available) {
+        set_last_error("Flatpak is not available");
+        return false;
     }
     
-    QProcess process;
-    
-    // Execute flatpak info --show-metadata to get the full metadata
-    process.start("flatpak", QStringList() << "info" << "--show-metadata" << QString::fromStdString(app_id));
-    
-    // Set a timeout of 2 seconds
-    if (!process.waitForFinished(2000)) {
-        qDebug() << "Timeout getting metadata for" << QString::fromStdString(app_id);
-        process.kill();
-        
-        // If we couldn't get metadata, at least make the name more readable
-        if (app_id.find('.') != std::string::npos) {
-            // Extract the last part after the last dot
-            std::string name = app_id.substr(app_id.find_last_of('.') + 1);
-            
-            // Capitalize first letter
-            if (!name.empty()) {
-                name[0] = std::toupper(name[0]);
-                package.set_name(name);
-            }
-        }
-        
-        return;
+    {
+        std::lock_guard<std::mutex> lock(m_transaction_mutex);
+        m_running_transactions.push_back(&transaction);
     }
     
-    // Get the output
-    QString output = process.readAllStandardOutput();
-    
-    // Extract application name using regex
-    QRegularExpression nameRegex("\\[Application\\]\\s*name=(.*)");
-    QRegularExpressionMatch nameMatch = nameRegex.match(output);
+    bool success = transaction.run();
     
-    if (nameMatch.hasMatch()) {
-        QString name = nameMatch.captured(1).trimmed();
-        if (!name.isEmpty()) {
-            package.set_name(name.toStdString());
-        }
+    // Installs and updates may have pulled newer appstream data
+    if (m_appstream) {
+        m_appstream->invalidate();
     }
     
-    // Extract description using regex
-    QRegularExpression descRegex("\\[Application\\]\\s*description=(.*)");
-    QRegularExpressionMatch descMatch = descRegex.match(output);
-    
-    if (descMatch.hasMatch()) {
-        QString description = descMatch.captured(1).trimmed();
-        if (!description.isEmpty()) {
-            package.set_description(description.toStdString());
-        }
+    {
+        std::lock_guard<std::mutex> lock(m_transaction_mutex);
+        m_running_transactions.erase(std::remove(m_running_transactions.begin(), m_running_transactions.end(), &transaction),
+                                     m_running_transactions.end());
     }
     
-    // Set repository to flathub by default
-    package.set_repository("flathub");
+    if (!success) {
+        set_last_error(transaction.get_last_error());
+    }
+    return success;
 }
 
 } // namespace core
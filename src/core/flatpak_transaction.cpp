@@ -0,0 +1,297 @@
+#include "core/flatpak_transaction.hpp"
+#include <iostream>
+#include <cctype>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    std::string trim(const std::string& text)
+    {
+        size_t begin = text.find_first_not_of(" \t");
+        if (begin == std::string::npos) {
+            return std::string();
+        }
+        size_t end = text.find_last_not_of(" \t");
+        return text.substr(begin, end - begin + 1);
+    }
+
+    bool starts_with_ignore_case(const std::string& text, const std::string& prefix)
+    {
+        if (text.size() < prefix.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < prefix.size(); ++i) {
+            if (std::tolower(static_cast<unsigned char>(text[i])) != std::tolower(static_cast<unsigned char>(prefix[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Last "NN%" in a progress line, or -1
+    int find_percent(const std::string& text)
+    {
+        for (size_t sign = text.rfind('%'); sign != std::string::npos && sign > 0;
+             sign = text.rfind('%', sign - 1)) {
+            size_t digits = sign;
+            while (digits > 0 && std::isdigit(static_cast<unsigned char>(text[digits - 1]))) {
+                --digits;
+            }
+            if (digits < sign && sign - digits <= 3) {
+                int percent = std::stoi(text.substr(digits, sign - digits));
+                if (percent <= 100) {
+                    return percent;
+                }
+            }
+        }
+        return -1;
+    }
+
+    // Name part of a ref: org.gnome.Calculator for app/org.gnome.Calculator/x86_64/stable
+    std::string ref_name(const std::string& ref)
+    {
+        size_t first = ref.find('/');
+        if (first == std::string::npos) {
+            return ref;
+        }
+        std::string kind = ref.substr(0, first);
+        if (kind == "app" || kind == "runtime") {
+            size_t second = ref.find('/', first + 1);
+            return ref.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+        }
+        return ref.substr(0, first);
+    }
+
+    bool is_id_char(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '-' || c == '_';
+    }
+
+    // Whether text names the ref as a whole token, so org.gnome.Calculator
+    // does not match org.gnome.Calculator.Locale; a trailing full stop ends
+    // the token
+    bool mentions_ref(const std::string& text, const std::string& name)
+    {
+        for (size_t pos = text.find(name); pos != std::string::npos; pos = text.find(name, pos + 1)) {
+            size_t end = pos + name.size();
+            bool starts = pos == 0 || !is_id_char(text[pos - 1]);
+            bool ends = end == text.size() || !is_id_char(text[end]) ||
+                        (text[end] == '.' && (end + 1 == text.size() || !is_id_char(text[end + 1])));
+            if (starts && ends) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+FlatpakTransaction::FlatpakTransaction(FlatpakOperation operation, std::vector<std::string> refs, std::string remote)
+    : m_operation(operation)
+    , m_refs(std::move(refs))
+    , m_remote(std::move(remote))
+{
+    for (const std::string& ref : m_refs) {
+        FlatpakRefProgress progress;
+        progress.ref = ref;
+        m_progress.push_back(progress);
+    }
+    m_current = m_progress.size();
+}
+
+void FlatpakTransaction::set_progress_callback(FlatpakProgressCallback callback)
+{
+    m_callback = std::move(callback);
+}
+
+std::vector<std::string> FlatpakTransaction::get_command() const
+{
+    // The progress is read from English output
+    std::vector<std::string> command = {"env", "LC_ALL=C", "flatpak"};
+    switch (m_operation) {
+    case FlatpakOperation::INSTALL: command.push_back("install"); break;
+    case FlatpakOperation::REMOVE: command.push_back("uninstall"); break;
+    case FlatpakOperation::UPDATE: command.push_back("update"); break;
+    }
+    command.push_back("-y");
+    command.push_back("--noninteractive");
+
+    if (m_operation == FlatpakOperation::INSTALL && !m_remote.empty()) {
+        command.push_back(m_remote);
+    }
+    command.insert(command.end(), m_refs.begin(), m_refs.end());
+    return command;
+}
+
+bool FlatpakTransaction::run()
+{
+    m_last_error.clear();
+    std::cout << "FlatpakTransaction: Running flatpak " << get_command()[3] << " for "
+              << (m_refs.empty() ? std::string("all refs") : std::to_string(m_refs.size()) + " refs") << std::endl;
+
+    ProcessStatus status = m_runner.run(get_command(), [this](const std::string& line, OutputStream) {
+        parse_line(line);
+    });
+
+    if (!status.success()) {
+        if (status.cancelled) {
+            m_last_error = "Flatpak transaction was cancelled";
+        } else if (!status.started) {
+            m_last_error = m_runner.get_last_error();
+        } else if (m_last_error.empty()) {
+            m_last_error = "flatpak " + get_command()[3] + " " + status.describe();
+        }
+        std::cerr << "FlatpakTransaction: " << m_last_error << std::endl;
+    }
+
+    finish(status.success());
+    return status.success();
+}
+
+void FlatpakTransaction::cancel()
+{
+    m_runner.cancel();
+}
+
+void FlatpakTransaction::parse_line(const std::string& line)
+{
+    size_t start = 0;
+    while (start <= line.size()) {
+        size_t end = line.find('\r', start);
+        std::string part = trim(line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (!part.empty()) {
+            parse_part(part);
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+}
+
+void FlatpakTransaction::finish(bool success)
+{
+    for (size_t i = 0; i < m_progress.size(); ++i) {
+        FlatpakRefProgress& progress = m_progress[i];
+        if (progress.state == FlatpakRefState::DONE || progress.state == FlatpakRefState::FAILED) {
+            continue;
+        }
+        if (success) {
+            progress.state = FlatpakRefState::DONE;
+            progress.percent = 100;
+        } else {
+            progress.state = FlatpakRefState::FAILED;
+            progress.message = m_last_error;
+        }
+        report(i);
+    }
+    m_current = m_progress.size();
+}
+
+const std::vector<FlatpakRefProgress>& FlatpakTransaction::get_progress() const
+{
+    return m_progress;
+}
+
+std::string FlatpakTransaction::get_last_error() const
+{
+    return m_last_error;
+}
+
+size_t FlatpakTransaction::find_ref(const std::string& ref)
+{
+    std::string name = ref_name(ref);
+    for (size_t i = 0; i < m_progress.size(); ++i) {
+        if (m_progress[i].ref == ref || m_progress[i].ref == name) {
+            return i;
+        }
+    }
+
+    FlatpakRefProgress progress;
+    progress.ref = ref;
+    progress.requested = false;
+    m_progress.push_back(progress);
+    return m_progress.size() - 1;
+}
+
+void FlatpakTransaction::parse_part(const std::string& part)
+{
+    // "Installing app/org.gnome.Calculator/x86_64/stable" starts the next operation;
+    // "Installing 1/3…" and "Installing… 40%" only redraw the running one
+    for (const char* verb : {"Installing ", "Updating ", "Uninstalling "}) {
+        std::string prefix(verb);
+        if (part.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string token = part.substr(prefix.size(), part.find(' ', prefix.size()) - prefix.size());
+        bool requested = false;
+        for (const FlatpakRefProgress& progress : m_progress) {
+            requested = requested || progress.ref == token;
+        }
+        if (token.empty() || std::isdigit(static_cast<unsigned char>(token[0])) ||
+            (token.find('/') == std::string::npos && !requested)) {
+            break;
+        }
+
+        if (m_current < m_progress.size() && m_progress[m_current].state == FlatpakRefState::RUNNING) {
+            m_progress[m_current].state = FlatpakRefState::DONE;
+            m_progress[m_current].percent = 100;
+            report(m_current);
+        }
+        m_current = find_ref(token);
+        m_progress[m_current].state = FlatpakRefState::RUNNING;
+        m_progress[m_current].percent = 0;
+        m_progress[m_current].message = part;
+        report(m_current);
+        return;
+    }
+
+    if (starts_with_ignore_case(part, "error:")) {
+        m_last_error = trim(part.substr(6));
+
+        // Errors name the ref they are about, or else belong to the running one
+        size_t failed = m_current;
+        for (size_t i = 0; i < m_progress.size(); ++i) {
+            if (mentions_ref(part, ref_name(m_progress[i].ref))) {
+                failed = i;
+                break;
+            }
+        }
+        if (failed < m_progress.size()) {
+            m_progress[failed].state = FlatpakRefState::FAILED;
+            m_progress[failed].message = m_last_error;
+            report(failed);
+        }
+        return;
+    }
+
+    int percent = find_percent(part);
+    if (percent >= 0 && m_current < m_progress.size()) {
+        FlatpakRefProgress& progress = m_progress[m_current];
+        if (progress.state == FlatpakRefState::RUNNING && progress.percent != percent) {
+            progress.percent = percent;
+            progress.message = part;
+            report(m_current);
+        }
+        return;
+    }
+
+    // Notes such as "Skipping: ... is already installed" go to the ref they name
+    for (size_t i = 0; i < m_progress.size(); ++i) {
+        if (m_progress[i].requested && mentions_ref(part, ref_name(m_progress[i].ref))) {
+            m_progress[i].message = part;
+            report(i);
+            return;
+        }
+    }
+}
+
+void FlatpakTransaction::report(size_t index)
+{
+    if (m_callback) {
+        m_callback(m_progress[index]);
+    }
+}
+
+} // namespace core
+} // namespace pacmangui
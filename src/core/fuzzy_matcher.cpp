@@ -0,0 +1,257 @@
+#include "core/fuzzy_matcher.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    constexpr int kExactScore = 1000;
+    constexpr int kPrefixScore = 800;
+    constexpr int kWordScore = 600;
+    constexpr int kSubstringScore = 400;
+    constexpr int kTypoScore = 200;
+    constexpr int kTypoPenalty = 50;     // Per edit
+    constexpr int kDescriptionScore = 60;
+    constexpr int kDescriptionBonus = 40;
+
+    // Candidates scanned between two looks at the cancellation flag
+    constexpr size_t kCancelCheckInterval = 1024;
+
+    // ASCII lowercase without a locale lookup per character
+    struct LowerTable {
+        char map[256];
+
+        LowerTable()
+        {
+            for (int c = 0; c < 256; ++c) {
+                map[c] = static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+            }
+        }
+    };
+    const LowerTable kLower;
+
+    char lower(char c)
+    {
+        return kLower.map[static_cast<unsigned char>(c)];
+    }
+
+    // Find a lowercase needle in text of any case
+    size_t find_ignore_case(std::string_view text, std::string_view needle, size_t from = 0)
+    {
+        if (needle.empty() || needle.size() > text.size()) {
+            return needle.empty() ? from : std::string_view::npos;
+        }
+        const char first = needle[0];
+        const size_t last = text.size() - needle.size();
+        for (size_t pos = from; pos <= last; ++pos) {
+            if (lower(text[pos]) != first) {
+                continue;
+            }
+            size_t i = 1;
+            while (i < needle.size() && lower(text[pos + i]) == needle[i]) {
+                ++i;
+            }
+            if (i == needle.size()) {
+                return pos;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    bool is_word_start(std::string_view text, size_t pos)
+    {
+        return pos == 0 || !std::isalnum(static_cast<unsigned char>(text[pos - 1]));
+    }
+}
+
+FuzzyMatcher::FuzzyMatcher(std::string_view query, int max_distance)
+    : m_query(query)
+    , m_max_distance(max_distance)
+    , m_typos_only(false)
+    , m_last_bit(0)
+    , m_peq(256, 0)
+{
+    std::transform(m_query.begin(), m_query.end(), m_query.begin(), lower);
+
+    if (m_max_distance < 0) {
+        // Short queries would match half the names with a single edit
+        m_max_distance = m_query.size() < 4 ? 0 : (m_query.size() < 8 ? 1 : 2);
+    }
+    if (m_query.size() > kMaxQuery) {
+        m_max_distance = 0;
+        return;
+    }
+    // Nothing can be within as many edits as the query has characters
+    m_max_distance = std::min(m_max_distance, static_cast<int>(m_query.size()) - 1);
+    m_max_distance = std::max(m_max_distance, 0);
+
+    for (size_t i = 0; i < m_query.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(m_query[i]);
+        m_peq[c] |= uint64_t(1) << i;
+        m_peq[static_cast<unsigned char>(std::toupper(c))] |= uint64_t(1) << i;
+    }
+    if (!m_query.empty()) {
+        m_last_bit = uint64_t(1) << (m_query.size() - 1);
+    }
+}
+
+const std::string& FuzzyMatcher::get_query() const
+{
+    return m_query;
+}
+
+int FuzzyMatcher::get_max_distance() const
+{
+    return m_max_distance;
+}
+
+void FuzzyMatcher::set_typos_only(bool typos_only)
+{
+    m_typos_only = typos_only;
+}
+
+int FuzzyMatcher::distance(std::string_view text) const
+{
+    if (m_query.empty()) {
+        return 0;
+    }
+    if (m_query.size() > kMaxQuery || m_max_distance == 0) {
+        return find_ignore_case(text, m_query) != std::string_view::npos ? 0 : m_max_distance + 1;
+    }
+
+    // Myers' bit-vector algorithm for approximate search. Bit i of the
+    // vertical delta vectors says how the distance of the query prefix
+    // ending at character i changes from row i - 1; the last bit tracks the
+    // distance of the whole query to the best substring ending here.
+    uint64_t pv = ~uint64_t(0);
+    uint64_t mv = 0;
+    int score = static_cast<int>(m_query.size());
+    int best = score;
+
+    for (char c : text) {
+        uint64_t eq = m_peq[static_cast<unsigned char>(c)];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+
+        if (ph & m_last_bit) {
+            ++score;
+        } else if (mh & m_last_bit) {
+            --score;
+        }
+
+        // A match may start anywhere, so row 0 stays 0 and nothing is shifted in
+        ph <<= 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        best = std::min(best, score);
+        if (best == 0) {
+            break;
+        }
+    }
+
+    return best <= m_max_distance ? best : m_max_distance + 1;
+}
+
+bool FuzzyMatcher::match(std::string_view name, std::string_view description, FuzzyMatch& result) const
+{
+    if (m_query.empty()) {
+        return false;
+    }
+
+    result.name_length = name.size();
+    result.distance = 0;
+
+    // One pass tells whether the name contains the query, with or without typos
+    int edits = distance(name);
+    if (edits == 0) {
+        if (m_typos_only) {
+            return false;
+        }
+        size_t pos = find_ignore_case(name, m_query);
+        if (name.size() == m_query.size()) {
+            result.kind = FuzzyMatchKind::EXACT;
+            result.score = kExactScore;
+        } else if (pos == 0) {
+            result.kind = FuzzyMatchKind::PREFIX;
+            result.score = kPrefixScore;
+        } else {
+            // A later occurrence may start a word, as "qt" in "python-qt"
+            while (pos != std::string_view::npos && !is_word_start(name, pos)) {
+                pos = find_ignore_case(name, m_query, pos + 1);
+            }
+            result.kind = pos != std::string_view::npos ? FuzzyMatchKind::WORD : FuzzyMatchKind::SUBSTRING;
+            result.score = pos != std::string_view::npos ? kWordScore : kSubstringScore;
+        }
+    } else {
+        if (edits <= m_max_distance) {
+            result.kind = FuzzyMatchKind::TYPO;
+            result.score = kTypoScore - kTypoPenalty * edits;
+            result.distance = edits;
+        } else if (!m_typos_only && find_ignore_case(description, m_query) != std::string_view::npos) {
+            result.kind = FuzzyMatchKind::DESCRIPTION;
+            result.score = kDescriptionScore;
+            result.distance = edits;
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    if (find_ignore_case(description, m_query) != std::string_view::npos) {
+        result.score += kDescriptionBonus;
+    }
+    return true;
+}
+
+std::vector<FuzzyMatch> FuzzyMatcher::rank(size_t count, const Candidate& candidate, size_t limit,
+                                           const std::atomic<bool>* cancelled) const
+{
+    // With better() as the ordering, the front of the heap is the worst match kept
+    std::vector<FuzzyMatch> heap;
+    FuzzyMatch current;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (i % kCancelCheckInterval == 0 && cancelled && cancelled->load(std::memory_order_relaxed)) {
+            return {};
+        }
+
+        auto [name, description] = candidate(i);
+        if (!match(name, description, current)) {
+            continue;
+        }
+        current.index = i;
+
+        if (limit == 0 || heap.size() < limit) {
+            heap.push_back(current);
+            if (limit > 0) {
+                std::push_heap(heap.begin(), heap.end(), better);
+            }
+        } else if (better(current, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), better);
+            heap.back() = current;
+            std::push_heap(heap.begin(), heap.end(), better);
+        }
+    }
+
+    std::sort(heap.begin(), heap.end(), better);
+    return heap;
+}
+
+bool FuzzyMatcher::better(const FuzzyMatch& a, const FuzzyMatch& b)
+{
+    if (a.score != b.score) {
+        return a.score > b.score;
+    }
+    if (a.name_length != b.name_length) {
+        return a.name_length < b.name_length;
+    }
+    return a.index < b.index;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,170 @@
+#include "core/helper_client.hpp"
+#include <iostream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+HelperClient::HelperClient(const std::string& socket_path, uid_t trusted_uid)
+    : m_socket_path(socket_path)
+    , m_trusted_uid(trusted_uid)
+    , m_fd(-1)
+{
+}
+
+HelperClient::~HelperClient()
+{
+    disconnect();
+}
+
+std::string HelperClient::default_socket_path()
+{
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && runtime_dir[0] == '/') {
+        return std::string(runtime_dir) + "/pacmangui-helper-" + std::to_string(getpid()) + ".sock";
+    }
+    return "/tmp/pacmangui-helper-" + std::to_string(getuid()) + "-" + std::to_string(getpid()) + ".sock";
+}
+
+const std::string& HelperClient::get_socket_path() const
+{
+    return m_socket_path;
+}
+
+bool HelperClient::connect()
+{
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    if (m_fd >= 0) {
+        return true;
+    }
+
+    sockaddr_un addr{};
+    if (m_socket_path.size() >= sizeof(addr.sun_path)) {
+        m_last_error = "Socket path too long: " + m_socket_path;
+        return false;
+    }
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, m_socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        m_last_error = std::string("Failed to create socket: ") + strerror(errno);
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        m_last_error = "Failed to connect to pacmangui-helper: " + std::string(strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    // Anyone could have created the socket, only talk to a daemon run by the trusted user
+    ucred cred{};
+    socklen_t length = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0 || cred.uid != m_trusted_uid) {
+        m_last_error = "pacmangui-helper socket is not owned by the expected user";
+        std::cerr << "HelperClient: " << m_last_error << ": " << m_socket_path << std::endl;
+        close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    std::cout << "HelperClient: Connected to " << m_socket_path << std::endl;
+    return true;
+}
+
+bool HelperClient::is_connected() const
+{
+    return m_fd >= 0;
+}
+
+bool HelperClient::request(const HelperRequest& request, HelperMessageCallback on_message)
+{
+    std::lock_guard<std::mutex> request_lock(m_request_mutex);
+    m_last_error.clear();
+
+    if (!connect()) {
+        return false;
+    }
+
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(m_write_mutex);
+        sent = m_fd >= 0 && write_helper_frame(m_fd, encode_helper_request(request));
+    }
+    if (!sent) {
+        m_last_error = "Failed to send request to pacmangui-helper";
+        disconnect();
+        return false;
+    }
+
+    std::string error;
+    std::string payload;
+    while (read_helper_frame(m_fd, payload)) {
+        HelperMessage message;
+        if (!decode_helper_message(payload, message)) {
+            m_last_error = "Malformed message from pacmangui-helper";
+            disconnect();
+            return false;
+        }
+
+        if (message.type == HelperMessageType::ERROR) {
+            error = message.text;
+        }
+        if (on_message) {
+            on_message(message);
+        }
+        if (message.type == HelperMessageType::DONE) {
+            if (!message.success) {
+                m_last_error = error.empty() ? "pacmangui-helper reported a failure" : error;
+            }
+            return message.success;
+        }
+    }
+
+    m_last_error = "Lost connection to pacmangui-helper";
+    disconnect();
+    return false;
+}
+
+bool HelperClient::cancel()
+{
+    HelperRequest request;
+    request.operation = HelperOperation::CANCEL;
+
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    return m_fd >= 0 && write_helper_frame(m_fd, encode_helper_request(request));
+}
+
+void HelperClient::shutdown()
+{
+    if (!is_connected()) {
+        return;
+    }
+
+    HelperRequest request;
+    request.operation = HelperOperation::SHUTDOWN;
+    this->request(request, nullptr);
+    disconnect();
+}
+
+void HelperClient::disconnect()
+{
+    std::lock_guard<std::mutex> lock(m_write_mutex);
+    int fd = m_fd.exchange(-1);
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+std::string HelperClient::get_last_error() const
+{
+    return m_last_error;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,394 @@
+#include "core/helper_protocol.hpp"
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    std::string escape(const std::string& value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value) {
+            switch (c) {
+                case '\\': escaped += "\\\\"; break;
+                case '\t': escaped += "\\t"; break;
+                case '\n': escaped += "\\n"; break;
+                case '\r': break;
+                default: escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+
+    std::string unescape(const std::string& value)
+    {
+        std::string result;
+        result.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '\\' && i + 1 < value.size()) {
+                char next = value[++i];
+                result += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+            } else {
+                result += value[i];
+            }
+        }
+        return result;
+    }
+
+    // Binary frames use fixed-width little-endian integers and length-prefixed strings
+    class FrameWriter {
+    public:
+        FrameWriter() : m_data(4, '\0') {}
+
+        void put_u8(uint8_t value) { m_data.push_back(static_cast<char>(value)); }
+
+        void put_u32(uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i) {
+                m_data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+            }
+        }
+
+        void put_u64(uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i) {
+                m_data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+            }
+        }
+
+        void put_string(const std::string& value)
+        {
+            put_u32(static_cast<uint32_t>(value.size()));
+            m_data += value;
+        }
+
+        std::string finish()
+        {
+            uint32_t size = static_cast<uint32_t>(m_data.size() - 4);
+            for (int i = 0; i < 4; ++i) {
+                m_data[i] = static_cast<char>((size >> (8 * i)) & 0xff);
+            }
+            return std::move(m_data);
+        }
+
+    private:
+        std::string m_data;
+    };
+
+    class FrameReader {
+    public:
+        explicit FrameReader(const std::string& data) : m_data(data), m_pos(0), m_ok(true) {}
+
+        uint8_t get_u8()
+        {
+            if (!require(1)) {
+                return 0;
+            }
+            return static_cast<uint8_t>(m_data[m_pos++]);
+        }
+
+        uint32_t get_u32() { return static_cast<uint32_t>(get_uint(4)); }
+
+        uint64_t get_u64() { return get_uint(8); }
+
+        std::string get_string()
+        {
+            uint32_t size = get_u32();
+            if (!require(size)) {
+                return "";
+            }
+            std::string value = m_data.substr(m_pos, size);
+            m_pos += size;
+            return value;
+        }
+
+        bool failed() const { return !m_ok; }
+
+        // Everything was read and nothing is left over
+        bool ok() const { return m_ok && m_pos == m_data.size(); }
+
+    private:
+        bool require(size_t size)
+        {
+            if (!m_ok || m_data.size() - m_pos < size) {
+                m_ok = false;
+                return false;
+            }
+            return true;
+        }
+
+        uint64_t get_uint(int bytes)
+        {
+            if (!require(bytes)) {
+                return 0;
+            }
+            uint64_t value = 0;
+            for (int i = 0; i < bytes; ++i) {
+                value |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_pos++])) << (8 * i);
+            }
+            return value;
+        }
+
+        const std::string& m_data;
+        size_t m_pos;
+        bool m_ok;
+    };
+
+    std::vector<std::string> split_fields(const std::string& line)
+    {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            size_t tab = line.find('\t', start);
+            fields.push_back(line.substr(start, tab - start));
+            if (tab == std::string::npos) {
+                break;
+            }
+            start = tab + 1;
+        }
+        return fields;
+    }
+}
+
+std::string format_helper_message(const HelperMessage& message)
+{
+    switch (message.type) {
+        case HelperMessageType::EVENT:
+            return "@event\t" + escape(message.text) + "\n";
+        case HelperMessageType::PROGRESS:
+            return "@progress\t" + escape(message.operation) + "\t" + escape(message.target) + "\t" +
+                   std::to_string(message.percent) + "\t" + std::to_string(message.current) + "\t" +
+                   std::to_string(message.total) + "\n";
+        case HelperMessageType::DOWNLOAD: {
+            const DownloadProgress& d = message.download;
+            return "@download\t" + escape(d.filename) + "\t" + std::to_string(d.downloaded) + "\t" +
+                   std::to_string(d.total) + "\t" + std::to_string(static_cast<uint64_t>(d.rate)) + "\t" +
+                   std::to_string(d.total_downloaded) + "\t" + std::to_string(d.total_size) + "\t" +
+                   std::to_string(static_cast<uint64_t>(d.total_rate)) + "\t" + std::to_string(d.completed) +
+                   "\t" + std::to_string(d.count) + "\n";
+        }
+        case HelperMessageType::ADD:
+            return "@add\t" + escape(message.text) + "\t" + escape(message.target) + "\n";
+        case HelperMessageType::REMOVE:
+            return "@remove\t" + escape(message.text) + "\t" + escape(message.target) + "\n";
+        case HelperMessageType::ERROR:
+            return "@error\t" + escape(message.text) + "\n";
+        case HelperMessageType::DONE:
+            return std::string("@done\t") + (message.success ? "1" : "0") + "\n";
+    }
+    return "";
+}
+
+bool parse_helper_message(const std::string& line, HelperMessage& message)
+{
+    // Output passed through a pty ends in \r\n
+    std::string clean = line;
+    if (!clean.empty() && clean.back() == '\r') {
+        clean.pop_back();
+    }
+    if (clean.empty() || clean[0] != '@') {
+        return false;
+    }
+
+    std::vector<std::string> fields = split_fields(clean);
+    const std::string& tag = fields[0];
+    message = HelperMessage();
+
+    try {
+        if (tag == "@event" && fields.size() == 2) {
+            message.type = HelperMessageType::EVENT;
+            message.text = unescape(fields[1]);
+        } else if (tag == "@progress" && fields.size() == 6) {
+            message.type = HelperMessageType::PROGRESS;
+            message.operation = unescape(fields[1]);
+            message.target = unescape(fields[2]);
+            message.percent = std::stoi(fields[3]);
+            message.current = std::stoul(fields[4]);
+            message.total = std::stoul(fields[5]);
+        } else if (tag == "@download" && fields.size() == 10) {
+            // Rates travel as whole bytes per second
+            message.type = HelperMessageType::DOWNLOAD;
+            DownloadProgress& d = message.download;
+            d.filename = unescape(fields[1]);
+            d.downloaded = std::stoull(fields[2]);
+            d.total = std::stoull(fields[3]);
+            d.rate = static_cast<double>(std::stoull(fields[4]));
+            d.total_downloaded = std::stoull(fields[5]);
+            d.total_size = std::stoull(fields[6]);
+            d.total_rate = static_cast<double>(std::stoull(fields[7]));
+            d.completed = std::stoul(fields[8]);
+            d.count = std::stoul(fields[9]);
+        } else if ((tag == "@add" || tag == "@remove") && fields.size() == 3) {
+            message.type = tag == "@add" ? HelperMessageType::ADD : HelperMessageType::REMOVE;
+            message.text = unescape(fields[1]);
+            message.target = unescape(fields[2]);
+        } else if (tag == "@error" && fields.size() == 2) {
+            message.type = HelperMessageType::ERROR;
+            message.text = unescape(fields[1]);
+        } else if (tag == "@done" && fields.size() == 2) {
+            message.type = HelperMessageType::DONE;
+            message.success = fields[1] == "1";
+        } else {
+            return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    return true;
+}
+
+std::string encode_helper_request(const HelperRequest& request)
+{
+    FrameWriter writer;
+    writer.put_u8(static_cast<uint8_t>(request.operation));
+    writer.put_u8(request.flags);
+    writer.put_u32(static_cast<uint32_t>(request.targets.size()));
+    for (const auto& target : request.targets) {
+        writer.put_string(target);
+    }
+    writer.put_u32(static_cast<uint32_t>(request.dependencies.size()));
+    for (const auto& dependency : request.dependencies) {
+        writer.put_string(dependency);
+    }
+    return writer.finish();
+}
+
+bool decode_helper_request(const std::string& payload, HelperRequest& request)
+{
+    FrameReader reader(payload);
+    request = HelperRequest();
+
+    uint8_t operation = reader.get_u8();
+    if (operation < static_cast<uint8_t>(HelperOperation::INSTALL) ||
+        operation > static_cast<uint8_t>(HelperOperation::INSTALL_FILES)) {
+        return false;
+    }
+    request.operation = static_cast<HelperOperation>(operation);
+    request.flags = reader.get_u8();
+
+    uint32_t count = reader.get_u32();
+    for (uint32_t i = 0; i < count && !reader.failed(); ++i) {
+        request.targets.push_back(reader.get_string());
+    }
+    count = reader.get_u32();
+    for (uint32_t i = 0; i < count && !reader.failed(); ++i) {
+        request.dependencies.push_back(reader.get_string());
+    }
+
+    return reader.ok();
+}
+
+std::string encode_helper_message(const HelperMessage& message)
+{
+    // Every field is sent, whatever the type, to keep the format trivial
+    FrameWriter writer;
+    writer.put_u8(static_cast<uint8_t>(message.type));
+    writer.put_string(message.text);
+    writer.put_string(message.operation);
+    writer.put_string(message.target);
+    writer.put_u32(static_cast<uint32_t>(message.percent));
+    writer.put_u64(message.current);
+    writer.put_u64(message.total);
+    writer.put_u8(message.success ? 1 : 0);
+
+    const DownloadProgress& download = message.download;
+    writer.put_string(download.filename);
+    writer.put_u64(download.downloaded);
+    writer.put_u64(download.total);
+    writer.put_u64(static_cast<uint64_t>(download.rate));
+    writer.put_u64(download.total_downloaded);
+    writer.put_u64(download.total_size);
+    writer.put_u64(static_cast<uint64_t>(download.total_rate));
+    writer.put_u64(download.completed);
+    writer.put_u64(download.count);
+    return writer.finish();
+}
+
+bool decode_helper_message(const std::string& payload, HelperMessage& message)
+{
+    FrameReader reader(payload);
+    message = HelperMessage();
+
+    uint8_t type = reader.get_u8();
+    if (type > static_cast<uint8_t>(HelperMessageType::DONE)) {
+        return false;
+    }
+    message.type = static_cast<HelperMessageType>(type);
+    message.text = reader.get_string();
+    message.operation = reader.get_string();
+    message.target = reader.get_string();
+    message.percent = static_cast<int>(reader.get_u32());
+    message.current = reader.get_u64();
+    message.total = reader.get_u64();
+    message.success = reader.get_u8() != 0;
+
+    DownloadProgress& download = message.download;
+    download.filename = reader.get_string();
+    download.downloaded = reader.get_u64();
+    download.total = reader.get_u64();
+    download.rate = static_cast<double>(reader.get_u64());
+    download.total_downloaded = reader.get_u64();
+    download.total_size = reader.get_u64();
+    download.total_rate = static_cast<double>(reader.get_u64());
+    download.completed = reader.get_u64();
+    download.count = reader.get_u64();
+
+    return reader.ok();
+}
+
+bool read_helper_frame(int fd, std::string& payload)
+{
+    auto read_exact = [fd](char* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = read(fd, data + done, size - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    };
+
+    unsigned char header[4];
+    if (!read_exact(reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+
+    uint32_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<uint32_t>(header[3]) << 24);
+    if (size > kMaxHelperFrameSize) {
+        return false;
+    }
+
+    payload.resize(size);
+    return read_exact(&payload[0], size);
+}
+
+bool write_helper_frame(int fd, const std::string& frame)
+{
+    size_t written = 0;
+    while (written < frame.size()) {
+        // MSG_NOSIGNAL: a vanished peer is an error, not a SIGPIPE
+        ssize_t n = send(fd, frame.data() + written, frame.size() - written, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,399 @@
+#include "core/json_parser.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    bool is_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool is_number_char(char c)
+    {
+        return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+    }
+
+    int hex_digit(char c)
+    {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool read_hex4(const char* text, unsigned& value)
+    {
+        value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int digit = hex_digit(text[i]);
+            if (digit < 0) {
+                return false;
+            }
+            value = (value << 4) | static_cast<unsigned>(digit);
+        }
+        return true;
+    }
+
+    void append_utf8(std::string& out, unsigned code)
+    {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // JSON numbers: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    bool is_valid_number(std::string_view text)
+    {
+        size_t i = 0;
+        auto digits = [&text, &i]() {
+            size_t start = i;
+            while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+                ++i;
+            }
+            return i > start;
+        };
+
+        if (i < text.size() && text[i] == '-') {
+            ++i;
+        }
+        if (i < text.size() && text[i] == '0') {
+            ++i;
+        } else if (!digits()) {
+            return false;
+        }
+        if (i < text.size() && text[i] == '.') {
+            ++i;
+            if (!digits()) {
+                return false;
+            }
+        }
+        if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+            ++i;
+            if (i < text.size() && (text[i] == '+' || text[i] == '-')) {
+                ++i;
+            }
+            if (!digits()) {
+                return false;
+            }
+        }
+        return i == text.size();
+    }
+}
+
+JsonParser::JsonParser(JsonHandler& handler)
+    : m_handler(handler)
+{
+    reset();
+}
+
+void JsonParser::reset()
+{
+    m_buffer.clear();
+    m_stack.clear();
+    m_expect = Expect::VALUE;
+    m_offset = 0;
+    m_failed = false;
+    m_last_error.clear();
+}
+
+bool JsonParser::feed(const char* data, size_t size)
+{
+    if (m_failed) {
+        return false;
+    }
+
+    m_buffer.append(data, size);
+    return parse(false);
+}
+
+bool JsonParser::finish()
+{
+    if (m_failed || !parse(true)) {
+        return false;
+    }
+    if (!m_buffer.empty()) {
+        return fail("Unexpected end of input");
+    }
+    if (m_expect != Expect::END) {
+        return fail(m_stack.empty() ? "No value in input" : "Unexpected end of input");
+    }
+    return true;
+}
+
+std::string JsonParser::get_last_error() const
+{
+    return m_last_error;
+}
+
+bool JsonParser::fail(const std::string& message)
+{
+    m_failed = true;
+    m_last_error = message + " at offset " + std::to_string(m_offset);
+    return false;
+}
+
+void JsonParser::value_done()
+{
+    m_expect = m_stack.empty() ? Expect::END : Expect::AFTER_VALUE;
+}
+
+bool JsonParser::read_string(size_t& pos, bool& complete)
+{
+    m_text.clear();
+    size_t i = pos + 1;
+
+    while (i < m_buffer.size()) {
+        // Copy runs of plain characters in one go
+        size_t run = i;
+        while (run < m_buffer.size() && m_buffer[run] != '"' && m_buffer[run] != '\\' &&
+               static_cast<unsigned char>(m_buffer[run]) >= 0x20) {
+            ++run;
+        }
+        m_text.append(m_buffer, i, run - i);
+        i = run;
+        if (i >= m_buffer.size()) {
+            break;
+        }
+
+        char c = m_buffer[i];
+        if (c == '"') {
+            pos = i + 1;
+            complete = true;
+            return true;
+        }
+        if (c != '\\') {
+            m_offset += i;
+            return fail("Control character in string");
+        }
+
+        if (i + 1 >= m_buffer.size()) {
+            break;
+        }
+        char escape = m_buffer[i + 1];
+        const char* simple = strchr("\"\\/bfnrt", escape);
+        if (escape != '\0' && simple) {
+            static const char kDecoded[] = "\"\\/\b\f\n\r\t";
+            m_text += kDecoded[simple - "\"\\/bfnrt"];
+            i += 2;
+            continue;
+        }
+        if (escape != 'u') {
+            m_offset += i;
+            return fail("Invalid escape in string");
+        }
+
+        if (i + 6 > m_buffer.size()) {
+            break;
+        }
+        unsigned code;
+        if (!read_hex4(m_buffer.data() + i + 2, code)) {
+            m_offset += i;
+            return fail("Invalid \\u escape in string");
+        }
+        i += 6;
+
+        // Characters outside the BMP come as a surrogate pair
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            if (i + 6 > m_buffer.size()) {
+                break;
+            }
+            unsigned low;
+            if (m_buffer[i] == '\\' && m_buffer[i + 1] == 'u' && read_hex4(m_buffer.data() + i + 2, low) &&
+                low >= 0xDC00 && low <= 0xDFFF) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            } else {
+                code = 0xFFFD;
+            }
+        } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            code = 0xFFFD;
+        }
+        append_utf8(m_text, code);
+    }
+
+    complete = false;
+    return true;
+}
+
+bool JsonParser::parse(bool at_end)
+{
+    size_t pos = 0;
+
+    while (true) {
+        while (pos < m_buffer.size() && is_space(m_buffer[pos])) {
+            ++pos;
+        }
+        if (pos >= m_buffer.size()) {
+            break;
+        }
+
+        const size_t start = pos;
+        const char c = m_buffer[pos];
+
+        if (m_expect == Expect::END) {
+            m_offset += pos;
+            return fail("Trailing data after value");
+        }
+
+        if (m_expect == Expect::COLON) {
+            if (c != ':') {
+                m_offset += pos;
+                return fail("Expected ':'");
+            }
+            ++pos;
+            m_expect = Expect::VALUE;
+            continue;
+        }
+
+        if (m_expect == Expect::AFTER_VALUE) {
+            char open = m_stack.back();
+            if (c == ',') {
+                ++pos;
+                m_expect = open == '{' ? Expect::KEY : Expect::VALUE;
+            } else if ((c == '}' && open == '{') || (c == ']' && open == '[')) {
+                ++pos;
+                m_stack.pop_back();
+                if (open == '{') {
+                    m_handler.end_object();
+                } else {
+                    m_handler.end_array();
+                }
+                value_done();
+            } else {
+                m_offset += pos;
+                return fail("Expected ',' or closing bracket");
+            }
+            continue;
+        }
+
+        // Closing right after opening
+        if ((m_expect == Expect::FIRST_KEY && c == '}') || (m_expect == Expect::FIRST_VALUE && c == ']')) {
+            ++pos;
+            m_stack.pop_back();
+            if (c == '}') {
+                m_handler.end_object();
+            } else {
+                m_handler.end_array();
+            }
+            value_done();
+            continue;
+        }
+
+        if (m_expect == Expect::FIRST_KEY || m_expect == Expect::KEY) {
+            if (c != '"') {
+                m_offset += pos;
+                return fail("Expected member name");
+            }
+            bool complete = false;
+            if (!read_string(pos, complete)) {
+                return false;
+            }
+            if (!complete) {
+                pos = start;
+                break;
+            }
+            m_handler.key(m_text);
+            m_expect = Expect::COLON;
+            continue;
+        }
+
+        // A value is expected from here on
+        if (c == '{' || c == '[') {
+            if (m_stack.size() >= kMaxDepth) {
+                m_offset += pos;
+                return fail("Nesting too deep");
+            }
+            ++pos;
+            m_stack.push_back(c);
+            if (c == '{') {
+                m_handler.begin_object();
+                m_expect = Expect::FIRST_KEY;
+            } else {
+                m_handler.begin_array();
+                m_expect = Expect::FIRST_VALUE;
+            }
+        } else if (c == '"') {
+            bool complete = false;
+            if (!read_string(pos, complete)) {
+                return false;
+            }
+            if (!complete) {
+                pos = start;
+                break;
+            }
+            m_handler.string_value(m_text);
+            value_done();
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            size_t end = pos;
+            while (end < m_buffer.size() && is_number_char(m_buffer[end])) {
+                ++end;
+            }
+            if (end == m_buffer.size() && !at_end) {
+                break;
+            }
+            std::string text = m_buffer.substr(pos, end - pos);
+            if (!is_valid_number(text)) {
+                m_offset += pos;
+                return fail("Invalid number");
+            }
+            pos = end;
+            m_handler.number_value(strtod(text.c_str(), nullptr), text);
+            value_done();
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            const char* literal = c == 't' ? "true" : c == 'f' ? "false" : "null";
+            size_t length = strlen(literal);
+            size_t available = std::min(length, m_buffer.size() - pos);
+            if (m_buffer.compare(pos, available, literal, available) != 0) {
+                m_offset += pos;
+                return fail("Invalid literal");
+            }
+            if (available < length) {
+                if (at_end) {
+                    m_offset += pos;
+                    return fail("Unexpected end of input");
+                }
+                break;
+            }
+            pos += length;
+            if (c == 'n') {
+                m_handler.null_value();
+            } else {
+                m_handler.bool_value(c == 't');
+            }
+            value_done();
+        } else {
+            m_offset += pos;
+            return fail(std::string("Unexpected character '") + c + "'");
+        }
+    }
+
+    // Keep only the incomplete token for the next chunk
+    m_offset += pos;
+    m_buffer.erase(0, pos);
+    return true;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,430 @@
+#include "core/package_catalog.hpp"
+#include <algorithm>
+#include <functional>
+#include <cstring>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    // Open addressing table sizes are kept at a power of two for cheap masking
+    constexpr size_t kInitialTableSize = 64;
+
+    // Snapshot fields are stored in host byte order, the file is a local cache
+    void append_u32(std::string& out, uint32_t value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void append_array(std::string& out, const std::vector<uint32_t>& values)
+    {
+        append_u32(out, static_cast<uint32_t>(values.size()));
+        out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(uint32_t));
+    }
+
+    bool read_u32(const char*& cursor, const char* end, uint32_t& value)
+    {
+        if (static_cast<size_t>(end - cursor) < sizeof(value)) {
+            return false;
+        }
+        memcpy(&value, cursor, sizeof(value));
+        cursor += sizeof(value);
+        return true;
+    }
+
+    bool read_array(const char*& cursor, const char* end, std::vector<uint32_t>& values)
+    {
+        uint32_t count;
+        if (!read_u32(cursor, end, count) ||
+            static_cast<size_t>(end - cursor) / sizeof(uint32_t) < count) {
+            return false;
+        }
+        values.resize(count);
+        memcpy(values.data(), cursor, count * sizeof(uint32_t));
+        cursor += count * sizeof(uint32_t);
+        return true;
+    }
+
+    bool read_bytes(const char*& cursor, const char* end, std::string& value)
+    {
+        uint32_t length;
+        if (!read_u32(cursor, end, length) || static_cast<size_t>(end - cursor) < length) {
+            return false;
+        }
+        value.assign(cursor, length);
+        cursor += length;
+        return true;
+    }
+}
+
+// StringPool implementation
+
+StringPool::StringPool()
+    : m_offsets(1, 0)
+    , m_table(kInitialTableSize, 0)
+{
+}
+
+void StringPool::reserve(size_t strings, size_t bytes)
+{
+    m_data.reserve(bytes);
+    m_offsets.reserve(strings + 1);
+    m_hashes.reserve(strings);
+
+    size_t wanted = kInitialTableSize;
+    while (wanted < strings * 2) {
+        wanted <<= 1;
+    }
+    if (wanted > m_table.size()) {
+        m_table.assign(wanted, 0);
+        for (uint32_t id = 0; id < m_hashes.size(); ++id) {
+            m_table[slot_for(get(id), m_hashes[id])] = id + 1;
+        }
+    }
+}
+
+size_t StringPool::slot_for(std::string_view value, size_t hash) const
+{
+    const size_t mask = m_table.size() - 1;
+    size_t slot = hash & mask;
+
+    // Linear probing until we hit the string or a free slot
+    while (m_table[slot] != 0) {
+        uint32_t id = m_table[slot] - 1;
+        if (m_hashes[id] == hash && get(id) == value) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void StringPool::grow_table()
+{
+    std::vector<uint32_t> old_table(m_table.size() * 2, 0);
+    m_table.swap(old_table);
+
+    const size_t mask = m_table.size() - 1;
+    for (uint32_t id = 0; id < m_hashes.size(); ++id) {
+        size_t slot = m_hashes[id] & mask;
+        while (m_table[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_table[slot] = id + 1;
+    }
+}
+
+uint32_t StringPool::intern(std::string_view value)
+{
+    size_t hash = std::hash<std::string_view>()(value);
+    size_t slot = slot_for(value, hash);
+    if (m_table[slot] != 0) {
+        return m_table[slot] - 1;
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_hashes.size());
+    m_data.append(value.data(), value.size());
+    m_offsets.push_back(static_cast<uint32_t>(m_data.size()));
+    m_hashes.push_back(hash);
+    m_table[slot] = id + 1;
+
+    // Keep the load factor below 0.5 so probe chains stay short
+    if (m_hashes.size() * 2 > m_table.size()) {
+        grow_table();
+    }
+
+    return id;
+}
+
+uint32_t StringPool::find(std::string_view value) const
+{
+    size_t slot = slot_for(value, std::hash<std::string_view>()(value));
+    return m_table[slot] != 0 ? m_table[slot] - 1 : npos;
+}
+
+std::string_view StringPool::get(uint32_t id) const
+{
+    if (id >= m_hashes.size()) {
+        return std::string_view();
+    }
+
+    return std::string_view(m_data.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+}
+
+size_t StringPool::size() const
+{
+    return m_hashes.size();
+}
+
+size_t StringPool::bytes() const
+{
+    return m_data.size();
+}
+
+void StringPool::save(std::string& out) const
+{
+    append_array(out, m_offsets);
+    append_u32(out, static_cast<uint32_t>(m_data.size()));
+    out.append(m_data);
+}
+
+bool StringPool::restore(const char*& cursor, const char* end)
+{
+    std::vector<uint32_t> offsets;
+    std::string data;
+    if (!read_array(cursor, end, offsets) || !read_bytes(cursor, end, data)) {
+        return false;
+    }
+
+    // Offsets have to ascend from 0 to the end of the data
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != data.size() ||
+        !std::is_sorted(offsets.begin(), offsets.end())) {
+        return false;
+    }
+
+    m_data = std::move(data);
+    m_offsets = std::move(offsets);
+    m_hashes.clear();
+    m_table.assign(kInitialTableSize, 0);
+    reserve(m_offsets.size() - 1, m_data.size());
+
+    const size_t mask = m_table.size() - 1;
+    for (uint32_t id = 0; id + 1 < m_offsets.size(); ++id) {
+        std::string_view value(m_data.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+        size_t hash = std::hash<std::string_view>()(value);
+        m_hashes.push_back(hash);
+
+        size_t slot = hash & mask;
+        while (m_table[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_table[slot] = id + 1;
+    }
+
+    return true;
+}
+
+// PackageView implementation
+
+Package PackageView::to_package() const
+{
+    Package package{std::string(name), std::string(version)};
+    package.set_description(std::string(description));
+    package.set_repository(std::string(repository));
+    package.set_installed(installed);
+    return package;
+}
+
+// RepositoryCatalog implementation
+
+RepositoryCatalog::RepositoryCatalog(const std::string& name, bool local)
+    : m_name(name)
+    , m_local(local)
+    , m_fingerprint(0)
+{
+}
+
+void RepositoryCatalog::reserve(size_t count)
+{
+    // Most packages have a unique name and description, versions are often shared
+    m_strings.reserve(count * 3, count * 96);
+    m_names.reserve(count);
+    m_versions.reserve(count);
+    m_descriptions.reserve(count);
+}
+
+void RepositoryCatalog::add(std::string_view name, std::string_view version, std::string_view description)
+{
+    uint32_t package_index = static_cast<uint32_t>(m_names.size());
+    uint32_t name_id = m_strings.intern(name);
+
+    m_names.push_back(name_id);
+    m_versions.push_back(m_strings.intern(version));
+    m_descriptions.push_back(m_strings.intern(description));
+
+    // Map the name's string id back to the package; the first entry wins on duplicates
+    if (name_id >= m_name_index.size()) {
+        m_name_index.resize(m_strings.size(), UINT32_MAX);
+    }
+    if (m_name_index[name_id] == UINT32_MAX) {
+        m_name_index[name_id] = package_index;
+    }
+
+    add_to_fingerprint(name, version);
+}
+
+void RepositoryCatalog::add_to_fingerprint(std::string_view name, std::string_view version)
+{
+    // Order-dependent mix so moved or replaced packages change the result
+    std::hash<std::string_view> hasher;
+    uint64_t entry = hasher(name) ^ (static_cast<uint64_t>(hasher(version)) * 0x9e3779b97f4a7c15ULL);
+    m_fingerprint = (m_fingerprint ^ entry) * 0x100000001b3ULL;
+}
+
+const std::string& RepositoryCatalog::get_name() const
+{
+    return m_name;
+}
+
+bool RepositoryCatalog::is_local() const
+{
+    return m_local;
+}
+
+size_t RepositoryCatalog::size() const
+{
+    return m_names.size();
+}
+
+PackageView RepositoryCatalog::at(size_t index) const
+{
+    PackageView view;
+    view.name = m_strings.get(m_names[index]);
+    view.version = m_strings.get(m_versions[index]);
+    view.description = m_strings.get(m_descriptions[index]);
+    view.repository = m_name;
+    view.installed = m_local;
+    return view;
+}
+
+std::string_view RepositoryCatalog::name_at(size_t index) const
+{
+    return m_strings.get(m_names[index]);
+}
+
+uint64_t RepositoryCatalog::get_fingerprint() const
+{
+    return m_fingerprint;
+}
+
+size_t RepositoryCatalog::find(std::string_view name) const
+{
+    uint32_t name_id = m_strings.find(name);
+    if (name_id == StringPool::npos || name_id >= m_name_index.size() ||
+        m_name_index[name_id] == UINT32_MAX) {
+        return npos;
+    }
+
+    return m_name_index[name_id];
+}
+
+void RepositoryCatalog::save(std::string& out) const
+{
+    append_u32(out, static_cast<uint32_t>(m_name.size()));
+    out.append(m_name);
+    append_u32(out, m_local ? 1 : 0);
+    append_array(out, m_names);
+    append_array(out, m_versions);
+    append_array(out, m_descriptions);
+    append_array(out, m_name_index);
+    m_strings.save(out);
+}
+
+std::shared_ptr<const RepositoryCatalog> RepositoryCatalog::restore(const char*& cursor, const char* end)
+{
+    std::string name;
+    uint32_t local;
+    if (!read_bytes(cursor, end, name) || !read_u32(cursor, end, local)) {
+        return nullptr;
+    }
+
+    auto catalog = std::make_shared<RepositoryCatalog>(name, local != 0);
+    if (!read_array(cursor, end, catalog->m_names) ||
+        !read_array(cursor, end, catalog->m_versions) ||
+        !read_array(cursor, end, catalog->m_descriptions) ||
+        !read_array(cursor, end, catalog->m_name_index) ||
+        !catalog->m_strings.restore(cursor, end)) {
+        return nullptr;
+    }
+
+    // Every id has to point into the pool and every index at a package
+    const size_t strings = catalog->m_strings.size();
+    const size_t packages = catalog->m_names.size();
+    if (catalog->m_versions.size() != packages || catalog->m_descriptions.size() != packages ||
+        catalog->m_name_index.size() > strings) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < packages; ++i) {
+        if (catalog->m_names[i] >= strings || catalog->m_versions[i] >= strings ||
+            catalog->m_descriptions[i] >= strings) {
+            return nullptr;
+        }
+    }
+    for (uint32_t index : catalog->m_name_index) {
+        if (index != UINT32_MAX && index >= packages) {
+            return nullptr;
+        }
+    }
+
+    for (size_t i = 0; i < packages; ++i) {
+        catalog->add_to_fingerprint(catalog->name_at(i), catalog->m_strings.get(catalog->m_versions[i]));
+    }
+
+    return catalog;
+}
+
+// PackageCatalog implementation
+
+PackageCatalog::PackageCatalog(uint64_t generation, RepositoryPtr local, std::vector<RepositoryPtr> sync)
+    : m_generation(generation)
+    , m_local(std::move(local))
+    , m_sync(std::move(sync))
+{
+}
+
+uint64_t PackageCatalog::get_generation() const
+{
+    return m_generation;
+}
+
+const RepositoryCatalog* PackageCatalog::get_local() const
+{
+    return m_local.get();
+}
+
+const PackageCatalog::RepositoryPtr& PackageCatalog::get_local_ptr() const
+{
+    return m_local;
+}
+
+const std::vector<PackageCatalog::RepositoryPtr>& PackageCatalog::get_sync() const
+{
+    return m_sync;
+}
+
+size_t PackageCatalog::size() const
+{
+    size_t total = m_local ? m_local->size() : 0;
+    for (const auto& repo : m_sync) {
+        total += repo->size();
+    }
+    return total;
+}
+
+std::optional<PackageView> PackageCatalog::find(std::string_view name) const
+{
+    if (m_local) {
+        size_t index = m_local->find(name);
+        if (index != RepositoryCatalog::npos) {
+            return m_local->at(index);
+        }
+    }
+
+    for (const auto& repo : m_sync) {
+        size_t index = repo->find(name);
+        if (index != RepositoryCatalog::npos) {
+            return repo->at(index);
+        }
+    }
+
+    return std::nullopt;
+}
+
+bool PackageCatalog::is_installed(std::string_view name) const
+{
+    return m_local && m_local->find(name) != RepositoryCatalog::npos;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -2,77 +2,114 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cerrno>
 #include <cstring>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
-#include <cstdlib>  // For system()
+#include <cstdlib>  // For mkdtemp()
 #include <array>
 #include <memory>
-#include <atomic>
-#include <thread>
 #include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <QSettings>
+#include "core/aur_build_cache.hpp"
+#include "core/aur_builder.hpp"
+#include "core/aur_client.hpp"
+#include "core/helper_protocol.hpp"
+#include "core/pacman_config.hpp"
+#include "core/process_runner.hpp"
+#include "core/system_maintenance.hpp"
+
+#ifndef PACMANGUI_HELPER_PATH
+#define PACMANGUI_HELPER_PATH "/usr/lib/pacmangui/pacmangui-helper"
+#endif
 
 namespace pacmangui {
 namespace core {
 
-// Helper function to execute commands with sudo
-bool execute_with_sudo(const std::string& command) {
-    std::string sudo_cmd = "sudo " + command;
-    std::cout << "Executing: " << sudo_cmd << std::endl;
-    int result = system(sudo_cmd.c_str());
-    return result == 0;
-}
-
-// Helper function to execute commands with sudo and password
-bool execute_with_sudo(const std::string& command, const std::string& password) {
-    std::cout << "PackageManager: Preparing to execute command with sudo" << std::endl;
+namespace {
+    // Typo matches shown next to the exact results of a streaming search
+    constexpr size_t kFuzzySearchResults = 20;
     
-    // Use expect-like behavior to handle sudo password prompt more reliably
-    std::string quoted_password = "'";
-    for (char c : password) {
-        if (c == '\'') {
-            quoted_password += "'\\''"; // Escape single quotes in the password
-        } else {
-            quoted_password += c;
+    // Package names and helper options only use these characters
+    bool is_safe_helper_argument(const std::string& arg) {
+        if (arg.empty()) {
+            return false;
+        }
+        for (unsigned char c : arg) {
+            if (!std::isalnum(c) && c != '@' && c != '.' && c != '_' && c != '+' && c != '-') {
+                return false;
+            }
         }
+        return true;
+    }
+
+    // Built package files are handed to the helper by absolute path
+    bool is_package_file_argument(const std::string& arg) {
+        std::string filename = arg.substr(arg.find_last_of('/') + 1);
+        if (arg.empty() || arg[0] != '/' || arg.find("/../") != std::string::npos ||
+            filename.find(".pkg.tar") == std::string::npos) {
+            return false;
+        }
+        return std::none_of(arg.begin(), arg.end(), [](unsigned char c) { return std::iscntrl(c); });
+    }
+
+    // sudo reads the password from stdin with -S, so it never shows up in a process listing
+    std::vector<std::string> sudo_command(const std::vector<std::string>& command, const std::string& password) {
+        std::vector<std::string> full = {"sudo"};
+        if (!password.empty()) {
+            full.insert(full.end(), {"-S", "-p", ""});
+        }
+        full.insert(full.end(), command.begin(), command.end());
+        return full;
     }
-    quoted_password += "'";
-    
-    // Create a command that:
-    // 1. Uses 'script' to simulate a terminal (sudo sometimes requires a TTY)
-    // 2. Pipes the password directly to sudo
-    // 3. Ensures the password isn't visible in process listings
-    std::string full_cmd = "script -qec 'echo " + quoted_password + " | sudo -S " + command + "' /dev/null";
-    
-    std::cout << "PackageManager: Executing sudo command with password authentication" << std::endl;
     
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_sudo_output.txt";
-    full_cmd += " 2>&1 | tee " + temp_output_file;
+    std::string sudo_input(const std::string& password) {
+        return password.empty() ? "" : password + "\n";
+    }
     
-    // Execute the command
-    int result = system(full_cmd.c_str());
+    HelperRequest helper_request(HelperOperation operation, const std::vector<std::string>& targets = {},
+                                 uint8_t flags = 0) {
+        HelperRequest request;
+        request.operation = operation;
+        request.targets = targets;
+        request.flags = flags;
+        return request;
+    }
     
-    // Read and log the output
-    std::ifstream output_file(temp_output_file);
-    if (output_file.is_open()) {
-        std::string line;
-        while (std::getline(output_file, line)) {
-            std::cout << "PackageManager: Sudo output: " << line << std::endl;
+    ProcessOutputCallback forward_lines(const std::function<void(const std::string&)>& output_callback) {
+        return [output_callback](const std::string& line, OutputStream) {
+            if (output_callback) {
+                output_callback(line + "\n");
+            }
+        };
+    }
+
+    // Refreshing a sync database replaces its file, and installing, upgrading
+    // or removing a package replaces its entry in the local directory, so
+    // either updates the directory's modification time
+    int64_t database_directory_stamp(alpm_handle_t* handle, const char* directory) {
+        struct stat info;
+        std::string path = std::string(alpm_option_get_dbpath(handle)) + directory;
+        if (stat(path.c_str(), &info) != 0) {
+            return 0;
         }
-        output_file.close();
+        return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
     }
     
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
-    
-    if (result == 0) {
-        std::cout << "PackageManager: Sudo command executed successfully" << std::endl;
-        return true;
-    } else {
-        std::cerr << "PackageManager: Sudo command failed with exit code: " << result << std::endl;
-        return false;
+    std::string format_bytes(double bytes) {
+        const char* units[] = {"B", "KiB", "MiB", "GiB"};
+        int unit = 0;
+        while (bytes >= 1024.0 && unit < 3) {
+            bytes /= 1024.0;
+            ++unit;
+        }
+        char text[32];
+        snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.1f %s", bytes, units[unit]);
+        return text;
     }
 }
 
@@ -91,11 +128,27 @@ PackageManager::PackageManager()
     , m_repo_manager(nullptr)
     , m_trans_manager(nullptr)
     , m_last_error("")
+    , m_config_path("/etc/pacman.conf")
+    , m_snapshot_path(CatalogSnapshot::default_path())
+    , m_sync_stamp(0)
+    , m_local_stamp(0)
+    , m_helper(new HelperClient())
+    , m_aur_client(new AurClient())
+    , m_aur_index(new AurIndex())
+    , m_aur_builder(nullptr)
+    , m_name_search(new IncrementalSearch())
+    , m_search_pipeline(new SearchPipeline())
 {
 }
 
 PackageManager::~PackageManager()
 {
+    // Search stages use the AUR client and the databases released below
+    cancel_search(true);
+    
+    // Nothing should keep running as root once the GUI is gone
+    m_helper->shutdown();
+    
     if (m_trans_manager) {
         delete m_trans_manager;
         m_trans_manager = nullptr;
@@ -112,7 +165,8 @@ PackageManager::~PackageManager()
     }
 }
 
-bool PackageManager::initialize(const std::string& root_dir, const std::string& db_path)
+bool PackageManager::initialize(const std::string& root_dir, const std::string& db_path,
+                                CatalogLoadedCallback on_loaded)
 {
     std::cout << "PackageManager: Initializing with root path '" << root_dir << "' and DB path '" << db_path << "'" << std::endl;
     
@@ -129,23 +183,32 @@ bool PackageManager::initialize(const std::string& root_dir, const std::string&
     
     // Set callback for logging
     alpm_option_set_logcb(m_handle, alpm_log_cb, nullptr);
+    m_local_stamp = database_directory_stamp(m_handle, "local");
     
-    // Create repository manager
+    // Create repository and transaction managers
     m_repo_manager = new RepositoryManager(m_handle);
-    if (!m_repo_manager->initialize()) {
-        set_last_error("Failed to initialize repository manager");
-        return false;
-    }
-    
-    // Create transaction manager
     m_trans_manager = new TransactionManager(m_handle);
     
-    // Register sync databases
+    // Register sync databases; registering only records them, nothing is read yet
     if (!register_sync_databases()) {
         set_last_error("Failed to register sync databases");
         return false;
     }
     
+    // Read the package caches once, all databases are registered by now.
+    // In the background case the snapshot serves the catalog meanwhile.
+    m_repo_manager->set_snapshot_path(m_snapshot_path);
+    if (on_loaded) {
+        m_repo_manager->load_snapshot();
+        if (!m_repo_manager->initialize_async(std::move(on_loaded))) {
+            set_last_error("Failed to start loading the repositories");
+            return false;
+        }
+    } else if (!m_repo_manager->initialize()) {
+        set_last_error("Failed to initialize repository manager");
+        return false;
+    }
+    
     // Initialize Flatpak manager
     m_flatpak_manager.initialize();
     
@@ -153,16 +216,37 @@ bool PackageManager::initialize(const std::string& root_dir, const std::string&
     return true;
 }
 
+void PackageManager::set_config_path(const std::string& config_path)
+{
+    m_config_path = config_path;
+}
+
+void PackageManager::set_snapshot_path(const std::string& snapshot_path)
+{
+    m_snapshot_path = snapshot_path;
+}
+
+void PackageManager::wait_until_loaded() const
+{
+    if (m_repo_manager) {
+        m_repo_manager->wait_until_loaded();
+    }
+}
+
 std::vector<Package> PackageManager::get_installed_packages() const
 {
     std::vector<Package> packages;
     
-    if (!m_handle || !m_repo_manager) {
+    std::shared_ptr<const PackageCatalog> catalog = get_catalog();
+    if (!catalog || !catalog->get_local()) {
         return packages;
     }
     
-    Repository local_db = m_repo_manager->get_local_db();
-    packages = local_db.get_packages();
+    const RepositoryCatalog& local = *catalog->get_local();
+    packages.reserve(local.size());
+    for (size_t i = 0; i < local.size(); ++i) {
+        packages.push_back(local.at(i).to_package());
+    }
     
     return packages;
 }
@@ -171,20 +255,30 @@ std::vector<Package> PackageManager::get_available_packages() const
 {
     std::vector<Package> packages;
     
-    if (!m_handle || !m_repo_manager) {
+    std::shared_ptr<const PackageCatalog> catalog = get_catalog();
+    if (!catalog) {
         return packages;
     }
     
     // Get packages from all sync repositories
-    std::vector<Repository> sync_dbs = m_repo_manager->get_sync_dbs();
-    for (const auto& repo : sync_dbs) {
-        std::vector<Package> repo_packages = repo.get_packages();
-        packages.insert(packages.end(), repo_packages.begin(), repo_packages.end());
+    for (const auto& repo : catalog->get_sync()) {
+        for (size_t i = 0; i < repo->size(); ++i) {
+            packages.push_back(repo->at(i).to_package());
+        }
     }
     
     return packages;
 }
 
+std::shared_ptr<const PackageCatalog> PackageManager::get_catalog() const
+{
+    if (!m_handle || !m_repo_manager) {
+        return nullptr;
+    }
+    
+    return m_repo_manager->get_catalog();
+}
+
 std::vector<Package> PackageManager::search_aur(const std::string& name) const
 {
     std::vector<Package> results;
@@ -204,225 +298,90 @@ std::vector<Package> PackageManager::search_aur(const std::string& name) const
         return results;
     }
     
-    try {
-        // Directly call the AUR RPC API using curl
-        // This is inspired by Octopi's approach but simplified
-        std::string tempFile = "/tmp/aur_search_results.json";
-        std::string escapedSearch = name;
-        
-        // Escape special characters in the search term
-        for (size_t i = 0; i < escapedSearch.length(); i++) {
-            if (escapedSearch[i] == ' ') {
-                escapedSearch.replace(i, 1, "%20");
-            }
-        }
-        
-        // Construct the curl command to query the AUR RPC API
-        std::string command = "curl -s 'https://aur.archlinux.org/rpc/?v=5&type=search&arg=" + 
-                             escapedSearch + "' -o " + tempFile;
-        
-        // Execute the curl command
-        std::cout << "PackageManager: Executing AUR API query" << std::endl;
-        int result = system(command.c_str());
-        
-        if (result != 0) {
-            std::cerr << "PackageManager: Failed to execute curl command" << std::endl;
-            return results;
-        }
-        
-        // Parse the JSON response
-        std::ifstream file(tempFile);
-        if (!file.is_open()) {
-            std::cerr << "PackageManager: Failed to open temporary file" << std::endl;
-            return results;
-        }
-        
-        std::string jsonContent((std::istreambuf_iterator<char>(file)), 
-                               std::istreambuf_iterator<char>());
-        file.close();
-        
-        // Very simple JSON parsing (in a real app, use a proper JSON library)
-        if (jsonContent.find("\"resultcount\":0") != std::string::npos) {
-            std::cout << "PackageManager: No AUR packages found matching '" << name << "'" << std::endl;
-            return results;
-        }
-        
-        size_t pos = 0;
-        std::string packageNameKey = "\"Name\":\"";
-        std::string versionKey = "\"Version\":\"";
-        std::string descriptionKey = "\"Description\":\"";
-        
-        while ((pos = jsonContent.find(packageNameKey, pos)) != std::string::npos) {
-            Package aurPackage;
-            
-            // Extract package name
-            size_t nameStart = pos + packageNameKey.length();
-            size_t nameEnd = jsonContent.find("\"", nameStart);
-            if (nameEnd != std::string::npos) {
-                std::string packageName = jsonContent.substr(nameStart, nameEnd - nameStart);
-                aurPackage.set_name(packageName);
-                aurPackage.set_repository("aur");
-                
-                // Extract version (search after the package name)
-                size_t versionPos = jsonContent.find(versionKey, nameEnd);
-                if (versionPos != std::string::npos && versionPos < jsonContent.find(packageNameKey, nameEnd + 1)) {
-                    size_t versionStart = versionPos + versionKey.length();
-                    size_t versionEnd = jsonContent.find("\"", versionStart);
-                    if (versionEnd != std::string::npos) {
-                        std::string version = jsonContent.substr(versionStart, versionEnd - versionStart);
-                        aurPackage.set_version(version);
-                    }
-                }
-                
-                // Extract description (search after the package name)
-                size_t descPos = jsonContent.find(descriptionKey, nameEnd);
-                if (descPos != std::string::npos && descPos < jsonContent.find(packageNameKey, nameEnd + 1)) {
-                    size_t descStart = descPos + descriptionKey.length();
-                    size_t descEnd = jsonContent.find("\"", descStart);
-                    if (descEnd != std::string::npos) {
-                        std::string description = jsonContent.substr(descStart, descEnd - descStart);
-                        aurPackage.set_description(description);
-                    }
-                }
-                
-                // Set AUR-specific information
-                aurPackage.set_aur_info("AUR Package");
-                
-                // Add to results
-                results.push_back(aurPackage);
-            }
-            
-            // Move to the next package
-            pos = nameEnd + 1;
-        }
-        
-        // Clean up the temporary file
-        remove(tempFile.c_str());
-        
-        std::cout << "PackageManager: Found " << results.size() << " AUR packages matching '" << name << "'" << std::endl;
-    } catch (const std::exception& e) {
-        std::cerr << "PackageManager: Exception during AUR search: " << e.what() << std::endl;
+    // Name and description, like the search of pacman and the AUR web interface
+    std::vector<AurPackage> aur_packages;
+    if (settings.value("aur/local_index", false).toBool() && m_aur_index->open()) {
+        aur_packages = m_aur_index->search(name);
+    } else if (!m_aur_client->search(name, AurSearchField::NAME_DESC, aur_packages)) {
+        std::cerr << "PackageManager: AUR search failed: " << m_aur_client->get_last_error() << std::endl;
+        return results;
     }
     
+    results.reserve(aur_packages.size());
+    for (const AurPackage& aur_package : aur_packages) {
+        results.push_back(aur_package.to_package());
+    }
+    
+    std::cout << "PackageManager: Found " << results.size() << " AUR packages matching '" << name << "'" << std::endl;
+    
     return results;
 }
 
-std::vector<Package> PackageManager::search_by_name(const std::string& name) const
+bool PackageManager::refresh_aur_index(std::string& error)
+{
+    if (!m_aur_index->refresh()) {
+        error = "Failed to update the AUR index: " + m_aur_index->get_last_error();
+        return false;
+    }
+    return true;
+}
+
+std::vector<Package> PackageManager::search_by_name(const std::string& name, const std::atomic<bool>* cancelled) const
 {
     std::vector<Package> results;
     
-    if (!m_handle || !m_repo_manager || name.empty()) {
+    std::shared_ptr<const SearchIndex> index = get_search_index();
+    if (!index || name.empty()) {
         return results;
     }
     
     std::cout << "PackageManager: Searching for packages matching '" << name << "'" << std::endl;
     
     try {
-        // First search in installed packages
-        std::vector<Package> installed_packages = get_installed_packages();
-        std::cout << "PackageManager: Searching through " << installed_packages.size() << " installed packages" << std::endl;
-        
-        // Convert search term to lowercase for case-insensitive matching
-        std::string search_term = name;
-        std::transform(search_term.begin(), search_term.end(), search_term.begin(), 
-                    [](unsigned char c){ return std::tolower(c); });
-        
-        // Search in installed packages
-        for (const auto& pkg : installed_packages) {
-            std::string pkg_name = pkg.get_name();
-            std::transform(pkg_name.begin(), pkg_name.end(), pkg_name.begin(), 
-                        [](unsigned char c){ return std::tolower(c); });
-            
-            if (pkg_name.find(search_term) != std::string::npos) {
-            results.push_back(pkg);
-        }
+        // The index lists installed packages first and already skips their sync copies
+        std::vector<SearchHit> hits = m_name_search->search_names(index, name, cancelled);
+        if (cancelled && *cancelled) {
+            std::cout << "PackageManager: Search for '" << name << "' was cancelled" << std::endl;
+            return results;
         }
         
-        std::cout << "PackageManager: Found " << results.size() << " matching installed packages" << std::endl;
-        
-        // Then search in repository packages
-        std::vector<Repository> sync_dbs = m_repo_manager->get_sync_dbs();
-        std::cout << "PackageManager: Searching through " << sync_dbs.size() << " repositories" << std::endl;
+        // Names already in the results, viewed straight from the catalog
+        std::unordered_set<std::string_view> seen;
         
-        int total_repo_packages = 0;
-        std::vector<Package> repo_results;
-        
-        // Search each repository explicitly
-        for (const auto& repo : sync_dbs) {
-            try {
-                std::vector<Package> repo_packages = repo.get_packages();
-                total_repo_packages += repo_packages.size();
-                
-                for (const auto& pkg : repo_packages) {
-                    if (pkg.get_name().empty()) {
-                        continue; // Skip packages with invalid names
-                    }
-                    
-                    std::string pkg_name = pkg.get_name();
-                    std::transform(pkg_name.begin(), pkg_name.end(), pkg_name.begin(), 
-                                [](unsigned char c){ return std::tolower(c); });
-                    
-                    // Check both name and description for matches
-                    if (pkg_name.find(search_term) != std::string::npos) {
-                        // Check if this package is already in results (avoid duplicates)
-                        bool already_added = false;
-                        for (const auto& existing : results) {
-                            if (existing.get_name() == pkg.get_name()) {
-                                already_added = true;
-                                break;
-                            }
-                        }
-                        
-                        if (!already_added) {
-                            repo_results.push_back(pkg);
-                        }
-                    }
-                }
-            } catch (const std::exception& e) {
-                std::cerr << "PackageManager: Error searching repo " << repo.get_name() 
-                        << ": " << e.what() << std::endl;
+        results.reserve(hits.size());
+        size_t installed_matches = 0;
+        for (const SearchHit& hit : hits) {
+            results.push_back(hit.package.to_package());
+            seen.insert(hit.package.name);
+            if (hit.package.installed) {
+                installed_matches++;
             }
         }
         
-        std::cout << "PackageManager: Searched through " << total_repo_packages << " repository packages" << std::endl;
-        std::cout << "PackageManager: Found " << repo_results.size() << " matching repository packages" << std::endl;
-        
-        // Add repository results to the final results
-        results.insert(results.end(), repo_results.begin(), repo_results.end());
-        
+        std::cout << "PackageManager: Found " << installed_matches << " matching installed packages" << std::endl;
+        std::cout << "PackageManager: Found " << (results.size() - installed_matches) << " matching repository packages" << std::endl;
         std::cout << "PackageManager: Total of " << results.size() << " matching packages found" << std::endl;
         
         // Check if AUR is enabled and search AUR packages
         QSettings settings("PacmanGUI", "PacmanGUI");
         bool aurEnabled = settings.value("aur/enabled", false).toBool();
         
-        if (aurEnabled) {
+        if (aurEnabled && !(cancelled && *cancelled)) {
             std::cout << "PackageManager: AUR search is enabled, searching AUR packages" << std::endl;
             
             // Search AUR packages
             std::vector<Package> aur_results = search_aur(name);
             
             // Filter out duplicates (packages already in results)
-            std::vector<Package> filtered_aur_results;
+            size_t unique_aur = 0;
             for (const auto& pkg : aur_results) {
-                bool already_added = false;
-                for (const auto& existing : results) {
-                    if (existing.get_name() == pkg.get_name()) {
-                        already_added = true;
-                        break;
-                    }
-                }
-                
-                if (!already_added) {
-                    filtered_aur_results.push_back(pkg);
+                if (seen.find(pkg.get_name()) == seen.end()) {
+                    results.push_back(pkg);
+                    unique_aur++;
                 }
             }
             
-            std::cout << "PackageManager: Found " << filtered_aur_results.size() << " unique AUR packages" << std::endl;
-            
-            // Add AUR results to the final results
-            results.insert(results.end(), filtered_aur_results.begin(), filtered_aur_results.end());
-            
+            std::cout << "PackageManager: Found " << unique_aur << " unique AUR packages" << std::endl;
             std::cout << "PackageManager: Total of " << results.size() << " matching packages found (including AUR)" << std::endl;
         } else {
             std::cout << "PackageManager: AUR search is disabled" << std::endl;
@@ -434,6 +393,178 @@ std::vector<Package> PackageManager::search_by_name(const std::string& name) con
     return results;
 }
 
+std::vector<SearchStage> PackageManager::get_search_stages(bool include_flatpak) const
+{
+    std::vector<SearchStage> stages;
+    
+    // Each database on its own, so installed packages show up before the sync databases are searched
+    std::shared_ptr<const SearchIndex> index = get_search_index();
+    if (index) {
+        for (size_t segment = 0; segment < index->get_segment_count(); ++segment) {
+            const RepositoryCatalog& repo = index->get_segment(segment).get_repository();
+            SearchStage stage;
+            stage.source = repo.is_local() ? SearchSource::LOCAL : SearchSource::SYNC;
+            stage.name = repo.get_name();
+            IncrementalSearch* names = m_name_search.get();
+            stage.run = [index, segment, names](const std::string& query, const std::atomic<bool>& cancelled) {
+                SearchResults results;
+                std::vector<SearchHit> hits = names->search_names(index, query, segment, &cancelled);
+                results.catalog = index->get_catalog();
+                results.views.reserve(hits.size());
+                for (const SearchHit& hit : hits) {
+                    results.views.push_back(hit.package);
+                }
+                return results;
+            };
+            stages.push_back(std::move(stage));
+        }
+    }
+    
+    if (index) {
+        // Close names for typos, the stages above already have every exact match
+        SearchStage stage;
+        stage.source = SearchSource::FUZZY;
+        stage.name = "fuzzy";
+        stage.run = [index](const std::string& query, const std::atomic<bool>& cancelled) {
+            SearchOptions options;
+            options.descriptions = false;
+            options.typos_only = true;
+            options.limit = kFuzzySearchResults;
+            options.cancelled = &cancelled;
+            
+            SearchResults results;
+            results.catalog = index->get_catalog();
+            for (const SearchHit& hit : index->search_fuzzy(query, options)) {
+                results.views.push_back(hit.package);
+            }
+            return results;
+        };
+        stages.push_back(std::move(stage));
+    }
+    
+    QSettings settings("PacmanGUI", "PacmanGUI");
+    if (settings.value("aur/enabled", false).toBool()) {
+        // Packages in the databases win over AUR packages of the same name, whichever arrives first
+        std::shared_ptr<const PackageCatalog> catalog = index ? index->get_catalog() : nullptr;
+        SearchStage stage;
+        stage.source = SearchSource::AUR;
+        stage.name = "aur";
+        stage.slow = true;
+        stage.run = [this, catalog](const std::string& query, const std::atomic<bool>& cancelled) {
+            SearchResults results;
+            for (auto& package : search_aur(query)) {
+                if (cancelled) {
+                    break;
+                }
+                if (!catalog || !catalog->find(package.get_name())) {
+                    results.packages.push_back(std::move(package));
+                }
+            }
+            return results;
+        };
+        stages.push_back(std::move(stage));
+    }
+    
+    if (include_flatpak && is_flatpak_available()) {
+        SearchStage stage;
+        stage.source = SearchSource::FLATPAK;
+        stage.name = "flatpak";
+        stage.slow = true;
+        stage.run = [this](const std::string& query, const std::atomic<bool>&) {
+            SearchResults results;
+            results.flatpak_packages = search_flatpak_by_name(query);
+            return results;
+        };
+        stages.push_back(std::move(stage));
+    }
+    
+    return stages;
+}
+
+uint64_t PackageManager::search_streaming(const std::string& name, bool include_flatpak,
+                                          SearchPipeline::BatchCallback on_batch,
+                                          SearchPipeline::FinishedCallback on_finished)
+{
+    std::vector<SearchStage> stages;
+    if (!name.empty()) {
+        stages = get_search_stages(include_flatpak);
+    }
+    
+    std::cout << "PackageManager: Streaming search for '" << name << "' over " << stages.size() << " sources" << std::endl;
+    return m_search_pipeline->start(name, std::move(stages), std::move(on_batch), std::move(on_finished));
+}
+
+void PackageManager::cancel_search(bool wait)
+{
+    m_search_pipeline->cancel();
+    if (wait) {
+        m_search_pipeline->wait();
+    }
+}
+
+SearchStats PackageManager::get_search_stats() const
+{
+    return m_search_pipeline->get_last_stats();
+}
+
+std::vector<Package> PackageManager::search_packages(const std::string& query, bool include_descriptions, size_t limit) const
+{
+    std::vector<Package> results;
+    
+    std::shared_ptr<const SearchIndex> index = get_search_index();
+    if (!index || query.empty()) {
+        return results;
+    }
+    
+    SearchOptions options;
+    options.descriptions = include_descriptions;
+    options.limit = limit;
+    
+    std::vector<SearchHit> hits = index->search(query, options);
+    results.reserve(hits.size());
+    for (const SearchHit& hit : hits) {
+        results.push_back(hit.package.to_package());
+    }
+    
+    std::cout << "PackageManager: Ranked search for '" << query << "' found " 
+              << results.size() << " packages" << std::endl;
+    
+    return results;
+}
+
+std::vector<Package> PackageManager::search_fuzzy(const std::string& query, size_t limit) const
+{
+    std::vector<Package> results;
+    
+    std::shared_ptr<const SearchIndex> index = get_search_index();
+    if (!index || query.empty()) {
+        return results;
+    }
+    
+    SearchOptions options;
+    options.limit = limit;
+    
+    std::vector<SearchHit> hits = index->search_fuzzy(query, options);
+    results.reserve(hits.size());
+    for (const SearchHit& hit : hits) {
+        results.push_back(hit.package.to_package());
+    }
+    
+    std::cout << "PackageManager: Fuzzy search for '" << query << "' found " 
+              << results.size() << " packages" << std::endl;
+    
+    return results;
+}
+
+std::shared_ptr<const SearchIndex> PackageManager::get_search_index() const
+{
+    if (!m_handle || !m_repo_manager) {
+        return nullptr;
+    }
+    
+    return m_repo_manager->get_search_index();
+}
+
 Package PackageManager::get_package_details(const std::string& name) const
 {
     if (!m_handle || !m_repo_manager || name.empty()) {
@@ -452,9 +583,8 @@ bool PackageManager::install_package(const std::string& package_name)
     
     std::cout << "PackageManager: Installing package: " << package_name << std::endl;
     
-    // Use pacman directly with sudo
-    std::string command = "pacman -S --noconfirm " + package_name;
-    bool success = execute_with_sudo(command);
+    // pkexec asks for the password itself
+    bool success = run_helper_request(helper_request(HelperOperation::INSTALL, {package_name}), "");
     
     if (success) {
         std::cout << "PackageManager: Package installed successfully: " << package_name << std::endl;
@@ -474,22 +604,20 @@ bool PackageManager::install_package(const std::string& package_name, const std:
     
     std::cout << "PackageManager: Installing package with authentication: " << package_name << std::endl;
     
-    // Use pacman directly with sudo and password
-    std::string command = "pacman -S --noconfirm ";
+    HelperRequest request = helper_request(HelperOperation::INSTALL, {package_name});
     
     // Add overwrite option if requested
     if (use_overwrite) {
-        command += "--overwrite \"*\" ";
+        request.flags |= HELPER_FLAG_OVERWRITE;
     }
     
-    command += package_name;
-    bool success = execute_with_sudo(command, password);
+    bool success = run_helper_request(request, password);
     
     if (success) {
         std::cout << "PackageManager: Package installed successfully: " << package_name << std::endl;
         return true;
     } else {
-        set_last_error("Failed to install package: " + package_name + ". Authentication may have failed.");
+        set_last_error("Failed to install package: " + package_name + ". " + m_last_error);
         return false;
     }
 }
@@ -503,9 +631,8 @@ bool PackageManager::remove_package(const std::string& package_name)
     
     std::cout << "PackageManager: Removing package: " << package_name << std::endl;
     
-    // Use pacman directly with sudo
-    std::string command = "pacman -R --noconfirm " + package_name;
-    bool success = execute_with_sudo(command);
+    // pkexec asks for the password itself
+    bool success = run_helper_request(helper_request(HelperOperation::REMOVE, {package_name}), "");
     
     if (success) {
         std::cout << "PackageManager: Package removed successfully: " << package_name << std::endl;
@@ -525,15 +652,13 @@ bool PackageManager::remove_package(const std::string& package_name, const std::
     
     std::cout << "PackageManager: Removing package with authentication: " << package_name << std::endl;
     
-    // Use pacman directly with sudo and password
-    std::string command = "pacman -R --noconfirm " + package_name;
-    bool success = execute_with_sudo(command, password);
+    bool success = run_helper_request(helper_request(HelperOperation::REMOVE, {package_name}), password);
     
     if (success) {
         std::cout << "PackageManager: Package removed successfully: " << package_name << std::endl;
-    return true;
+        return true;
     } else {
-        set_last_error("Failed to remove package: " + package_name + ". Authentication may have failed.");
+        set_last_error("Failed to remove package: " + package_name + ". " + m_last_error);
         return false;
     }
 }
@@ -547,9 +672,8 @@ bool PackageManager::update_package(const std::string& package_name)
     
     std::cout << "PackageManager: Updating package: " << package_name << std::endl;
     
-    // Use pacman directly with sudo
-    std::string command = "pacman -S --noconfirm " + package_name;
-    bool success = execute_with_sudo(command);
+    // pkexec asks for the password itself
+    bool success = run_helper_request(helper_request(HelperOperation::UPDATE, {package_name}), "");
     
     if (success) {
         std::cout << "PackageManager: Package updated successfully: " << package_name << std::endl;
@@ -569,22 +693,20 @@ bool PackageManager::update_package(const std::string& package_name, const std::
     
     std::cout << "PackageManager: Updating package with authentication: " << package_name << std::endl;
     
-    // Use pacman directly with sudo and password
-    std::string command = "pacman -S --noconfirm ";
+    HelperRequest request = helper_request(HelperOperation::UPDATE, {package_name});
     
     // Add overwrite option if requested
     if (use_overwrite) {
-        command += "--overwrite \"*\" ";
+        request.flags |= HELPER_FLAG_OVERWRITE;
     }
     
-    command += package_name;
-    bool success = execute_with_sudo(command, password);
+    bool success = run_helper_request(request, password);
     
     if (success) {
         std::cout << "PackageManager: Package updated successfully: " << package_name << std::endl;
         return true;
     } else {
-        set_last_error("Failed to update package: " + package_name + ". Authentication may have failed.");
+        set_last_error("Failed to update package: " + package_name + ". " + m_last_error);
         return false;
     }
 }
@@ -594,8 +716,7 @@ bool PackageManager::sync_all()
     std::cout << "PackageManager: Synchronizing all packages" << std::endl;
     
     // First refresh the package databases
-    std::string refresh_cmd = "pacman -Sy";
-    bool refresh_success = execute_with_sudo(refresh_cmd);
+    bool refresh_success = run_helper_request(helper_request(HelperOperation::REFRESH), "");
     
     if (!refresh_success) {
         set_last_error("Failed to refresh package databases");
@@ -604,9 +725,6 @@ bool PackageManager::sync_all()
     
     std::cout << "PackageManager: Package databases refreshed successfully" << std::endl;
     
-    // Re-initialize to get updated package information
-    m_repo_manager->initialize();
-    
     return true;
 }
 
@@ -615,24 +733,21 @@ bool PackageManager::sync_all(const std::string& password)
     std::cout << "PackageManager: Synchronizing all packages with authentication" << std::endl;
     
     // First refresh the package databases
-    std::string refresh_cmd = "pacman -Sy";
-    bool refresh_success = execute_with_sudo(refresh_cmd, password);
+    bool refresh_success = run_helper_request(helper_request(HelperOperation::REFRESH), password);
     
     if (!refresh_success) {
-        set_last_error("Failed to refresh package databases. Authentication may have failed.");
+        set_last_error("Failed to refresh package databases. " + m_last_error);
         return false;
     }
     
     std::cout << "PackageManager: Package databases refreshed successfully" << std::endl;
     
-    // Re-initialize to get updated package information
-    m_repo_manager->initialize();
-    
     return true;
 }
 
 bool PackageManager::install_aur_package(const std::string& package_name, const std::string& password,
-                                        const std::string& aur_helper)
+                                        const std::string& aur_helper,
+                                        std::function<void(const std::string&)> output_callback)
 {
     if (package_name.empty()) {
         set_last_error("Invalid package name");
@@ -651,6 +766,10 @@ bool PackageManager::install_aur_package(const std::string& package_name, const
         return false;
     }
     
+    if (settings.value("aur/native_build", false).toBool()) {
+        return install_aur_packages({package_name}, password, output_callback);
+    }
+    
     // Use provided AUR helper or fall back to configured one
     std::string aurHelper = aur_helper;
     if (aurHelper.empty()) {
@@ -663,70 +782,35 @@ bool PackageManager::install_aur_package(const std::string& package_name, const
         return false;
     }
     
-    std::cout << "PackageManager: Using AUR helper: " << aurHelper << std::endl;
-    
-    // Check if the AUR helper exists
-    std::string which_cmd = "which " + aurHelper;
-    FILE* which_pipe = popen(which_cmd.c_str(), "r");
-    if (!which_pipe) {
-        std::cerr << "PackageManager: Failed to check if AUR helper exists" << std::endl;
-        set_last_error("Failed to verify AUR helper installation");
+    // Both end up on a command line run as root
+    if (!is_safe_helper_argument(package_name) || !is_safe_helper_argument(aurHelper)) {
+        set_last_error("Invalid package name or AUR helper: " + package_name + ", " + aurHelper);
         return false;
     }
     
-    char buffer[256];
-    if (!fgets(buffer, sizeof(buffer), which_pipe)) {
+    std::cout << "PackageManager: Using AUR helper: " << aurHelper << std::endl;
+    
+    // Check if the AUR helper exists
+    ProcessStatus which = run_process({"which", aurHelper}, "", [](const std::string& line, OutputStream) {
+        std::cout << "PackageManager: AUR helper found at: " << line << std::endl;
+    });
+    if (!which.success()) {
         std::cerr << "PackageManager: AUR helper not found in PATH: " << aurHelper << std::endl;
         set_last_error("AUR helper not found: " + aurHelper);
-        pclose(which_pipe);
         return false;
     }
-    pclose(which_pipe);
-    
-    std::cout << "PackageManager: AUR helper found at: " << buffer;
-    
-    // Construct the appropriate command based on the helper
-    std::string command;
-    if (aurHelper == "yay") {
-        command = "yay -S --noconfirm --needed " + package_name;
-    } else if (aurHelper == "paru") {
-        command = "paru -S --noconfirm --needed " + package_name;
-    } else if (aurHelper == "pikaur") {
-        command = "pikaur -S --noconfirm --needed " + package_name;
-    } else if (aurHelper == "trizen") {
-        command = "trizen -S --noconfirm --needed " + package_name;
-    } else if (aurHelper == "pacaur") {
-        command = "pacaur -S --noconfirm --needed " + package_name;
-    } else if (aurHelper == "aurman") {
-        command = "aurman -S --noconfirm --needed " + package_name;
-    } else if (aurHelper == "pamac") {
-        command = "pamac build --no-confirm " + package_name;
+    
+    // pamac has its own syntax, the other helpers follow pacman
+    std::vector<std::string> command;
+    if (aurHelper == "pamac") {
+        command = {"pamac", "build", "--no-confirm", package_name};
     } else {
-        // Generic format for other helpers
-        command = aurHelper + " -S --noconfirm --needed " + package_name;
+        command = {aurHelper, "-S", "--noconfirm", "--needed", package_name};
     }
     
-    std::cout << "PackageManager: Executing authenticated command: " << command << std::endl;
-    
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_aur_install_auth_output.txt";
-    command += " 2>&1 | tee " + temp_output_file;
-    
-    // Execute the command with sudo
-    bool success = execute_with_sudo(command, password);
-    
-    // Read and log the output
-    std::ifstream output_file(temp_output_file);
-    if (output_file.is_open()) {
-        std::string line;
-        while (std::getline(output_file, line)) {
-            std::cout << "PackageManager: AUR output: " << line << std::endl;
-        }
-        output_file.close();
-    }
+    std::cout << "PackageManager: Installing " << package_name << " with " << aurHelper << std::endl;
     
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
+    bool success = run_privileged(command, password, output_callback);
     
     if (success) {
         std::cout << "PackageManager: AUR Package installed successfully: " << package_name << std::endl;
@@ -739,16 +823,132 @@ bool PackageManager::install_aur_package(const std::string& package_name, const
     }
 }
 
-bool PackageManager::is_package_installed(const std::string& package_name) const
+bool PackageManager::install_aur_packages(const std::vector<std::string>& package_names, const std::string& password,
+                                          std::function<void(const std::string&)> output_callback)
 {
-    if (!m_handle || !m_repo_manager || package_name.empty()) {
+    auto report = [&output_callback](const std::string& text) {
+        if (output_callback) {
+            output_callback(text + "\n");
+        }
+    };
+    
+    if (package_names.empty()) {
+        set_last_error("No packages given");
+        return false;
+    }
+    for (const auto& name : package_names) {
+        if (!is_safe_helper_argument(name)) {
+            set_last_error("Invalid package name: " + name);
+            return false;
+        }
+    }
+    if (!m_handle) {
+        set_last_error("Package manager not initialized");
+        return false;
+    }
+    
+    QSettings settings("PacmanGUI", "PacmanGUI");
+    if (!settings.value("aur/enabled", false).toBool()) {
+        set_last_error("AUR support is disabled in settings");
+        report("ERROR: AUR support is disabled in settings");
+        return false;
+    }
+    
+    AurBuilder builder(*m_aur_client);
+    builder.set_jobs(settings.value("aur/build_jobs", 0).toUInt());
+    builder.set_output_callback(output_callback);
+    
+    AurBuildCache cache;
+    bool use_cache = settings.value("aur/build_cache", true).toBool();
+    if (use_cache) {
+        cache.set_shared_directory(settings.value("aur/shared_cache_dir", "").toString().toStdString());
+        builder.set_cache(&cache);
+    }
+    
+    // Packages installed earlier in this session have to count as installed
+    wait_until_loaded();
+    if (!reload_changed_databases()) {
+        std::cerr << "PackageManager: Using previously loaded databases" << std::endl;
+    }
+    
+    // Installed packages and the sync databases are preferred over the AUR, like makepkg -s does.
+    // The handle is looked up on every call, installing dependencies may replace it.
+    AurDependencyResolver resolver = [this](const std::string& depend) {
+        std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+        if (alpm_find_satisfier(alpm_db_get_pkgcache(alpm_get_localdb(m_handle)), depend.c_str())) {
+            return AurDependencyState::INSTALLED;
+        }
+        if (alpm_find_dbs_satisfier(m_handle, alpm_get_syncdbs(m_handle), depend.c_str())) {
+            return AurDependencyState::REPOSITORY;
+        }
+        return AurDependencyState::MISSING;
+    };
+    
+    report("Resolving AUR dependencies...");
+    AurBuildPlan plan;
+    if (!builder.resolve(package_names, resolver, plan)) {
+        set_last_error(builder.get_last_error());
+        report("ERROR: " + m_last_error);
+        return false;
+    }
+    
+    std::string summary = "AUR packages (" + std::to_string(plan.targets.size()) + "):";
+    for (const auto& target : plan.targets) {
+        summary += " " + target.base + "-" + target.version;
+    }
+    report(summary);
+    std::cout << "PackageManager: Building " << plan.targets.size() << " AUR package bases with "
+              << builder.get_jobs() << " jobs" << std::endl;
+    
+    auto install_repo = [&](const std::vector<std::string>& names) {
+        HelperRequest request = helper_request(HelperOperation::INSTALL, names);
+        request.dependencies = names;
+        return run_helper_request(request, password, output_callback);
+    };
+    auto install_files = [&](const std::vector<std::string>& files, const std::vector<std::string>& dependencies) {
+        HelperRequest request = helper_request(HelperOperation::INSTALL_FILES, files);
+        request.dependencies = dependencies;
+        return run_helper_request(request, password, output_callback);
+    };
+    
+    {
+        std::lock_guard<std::mutex> lock(m_process_mutex);
+        m_aur_builder = &builder;
+    }
+    
+    bool success = builder.build(plan, install_repo, install_files);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_process_mutex);
+        m_aur_builder = nullptr;
+    }
+    
+    // Pruned after the build so the entries it just used count as recent
+    if (use_cache) {
+        uint64_t max_bytes = uint64_t(settings.value("aur/cache_max_size_mb", 4096).toUInt()) * 1024 * 1024;
+        time_t max_age = time_t(settings.value("aur/cache_max_age_days", 90).toUInt()) * 24 * 60 * 60;
+        cache.prune(max_bytes, max_age);
+    }
+    
+    if (!success) {
+        set_last_error("Failed to install AUR packages: " + builder.get_last_error());
+        report("ERROR: " + m_last_error);
         return false;
     }
     
-    Repository local_db = m_repo_manager->get_local_db();
-    Package pkg = local_db.find_package(package_name);
+    std::cout << "PackageManager: AUR packages installed successfully" << std::endl;
+    report("AUR packages installed successfully.");
+    return true;
+}
+
+bool PackageManager::is_package_installed(const std::string& package_name) const
+{
+    std::shared_ptr<const PackageCatalog> catalog = get_catalog();
+    if (!catalog || package_name.empty()) {
+        return false;
+    }
     
-    return !pkg.get_name().empty();
+    return catalog->is_installed(package_name);
 }
 
 std::vector<Repository> PackageManager::get_repositories() const
@@ -763,7 +963,7 @@ std::vector<Repository> PackageManager::get_repositories() const
     repositories.push_back(m_repo_manager->get_local_db());
     
     // Add sync repositories
-    std::vector<Repository> sync_dbs = m_repo_manager->get_sync_dbs();
+    const std::vector<Repository>& sync_dbs = m_repo_manager->get_sync_dbs();
     repositories.insert(repositories.end(), sync_dbs.begin(), sync_dbs.end());
     
     return repositories;
@@ -786,102 +986,105 @@ bool PackageManager::register_sync_databases()
         return false;
     }
     
-    // Path to pacman configuration file
-    std::string config_path = "/etc/pacman.conf";
+    std::cout << "PackageManager: Reading repositories from " << m_config_path << std::endl;
     
-    // Open the configuration file
-    std::ifstream config_file(config_path);
-    if (!config_file.is_open()) {
-        std::cerr << "Failed to open pacman configuration file: " << config_path << std::endl;
+    // Parse the configuration file, including the mirrorlists it pulls in
+    PacmanConfig config;
+    if (!config.load(m_config_path)) {
+        std::cerr << "Failed to open pacman configuration file: " << m_config_path << std::endl;
         return false;
     }
     
-    std::string line;
-    std::string current_repo;
-    int repo_count = 0;
-    std::vector<std::string> registered_repos;
+    // Register each repository with its servers and the cache directories
+    config.apply(m_handle);
+    m_sync_stamp = database_directory_stamp(m_handle, "sync");
     
-    std::cout << "PackageManager: Reading repositories from " << config_path << std::endl;
+    // Registering does not read the databases, the repository manager loads them afterwards
+    alpm_list_t* sync_dbs = alpm_get_syncdbs(m_handle);
+    size_t repo_count = alpm_list_count(sync_dbs);
+    if (repo_count == 0) {
+        std::cerr << "PackageManager: No sync databases registered successfully" << std::endl;
+        return false;
+    }
     
-    // Parse the configuration file
-    while (std::getline(config_file, line)) {
-        // Skip comments and empty lines
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        
-        // Check for repository name
-        if (line[0] == '[' && line[line.size() - 1] == ']') {
-            current_repo = line.substr(1, line.size() - 2);
-            
-            // Skip local repositories
-            if (current_repo == "options" || current_repo == "local") {
-                current_repo = "";
-                continue;
-            }
-            
-            std::cout << "PackageManager: Found repository: " << current_repo << std::endl;
-            
-            // Register the repository
-            alpm_db_t* db = alpm_register_syncdb(m_handle, current_repo.c_str(), ALPM_SIG_USE_DEFAULT);
-            if (!db) {
-                alpm_errno_t err = alpm_errno(m_handle);
-                std::cerr << "Failed to register sync database: " << current_repo << ": " << alpm_strerror(err) << std::endl;
-                continue; // Skip this repo but continue with others
-            }
-            
-            // Add to our list of registered repos
-            registered_repos.push_back(current_repo);
-            repo_count++;
-        }
+    std::cout << "PackageManager: Successfully registered " << repo_count << " repositories:" << std::endl;
+    for (alpm_list_t* item = sync_dbs; item; item = alpm_list_next(item)) {
+        std::cout << " - " << alpm_db_get_name(static_cast<alpm_db_t*>(item->data)) << std::endl;
     }
     
-    config_file.close();
+    return true;
+}
+
+bool PackageManager::reload_changed_sync_databases()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+    int64_t stamp = database_directory_stamp(m_handle, "sync");
+    if (stamp == m_sync_stamp) {
+        return true;
+    }
     
-    // Force a refresh of repositories to ensure they have data
-    if (repo_count > 0) {
-        std::cout << "PackageManager: Successfully registered " << repo_count << " repositories:" << std::endl;
-        for (const auto& repo : registered_repos) {
-            std::cout << " - " << repo << std::endl;
-        }
-        
-        // Reinitialize the repository manager to ensure it loads all the registered dbs
-        try {
-            if (!m_repo_manager->initialize()) {
-                std::cerr << "PackageManager: Failed to reinitialize repository manager after registering databases" << std::endl;
-                return false;
-            }
-            
-            // Get the current sync databases
-            std::vector<Repository> sync_dbs = m_repo_manager->get_sync_dbs();
-            std::cout << "PackageManager: Loaded " << sync_dbs.size() << " sync databases" << std::endl;
-            
-            // Display package counts for each repo
-            int total_packages = 0;
-            for (const auto& repo : sync_dbs) {
-                try {
-                    std::vector<Package> repo_packages = repo.get_packages();
-                    int package_count = repo_packages.size();
-                    total_packages += package_count;
-                    std::cout << "PackageManager: Repository '" << repo.get_name() << "' has " 
-                            << package_count << " packages" << std::endl;
-                } catch (const std::exception& e) {
-                    std::cerr << "PackageManager: Error processing repo " << repo.get_name() 
-                            << ": " << e.what() << std::endl;
-                }
-            }
-            
-            std::cout << "PackageManager: Total of " << total_packages << " packages available in repositories" << std::endl;
-            
-            return true;
-        } catch (const std::exception& e) {
-            std::cerr << "PackageManager: Exception during repository initialization: " << e.what() << std::endl;
-            return false;
-        }
-    } else {
-        std::cerr << "PackageManager: No sync databases registered successfully" << std::endl;
+    std::cout << "PackageManager: Sync databases changed on disk, reloading" << std::endl;
+    
+    PacmanConfig config;
+    if (!config.load(m_config_path)) {
+        set_last_error(config.get_last_error());
+        return false;
+    }
+    
+    alpm_unregister_all_syncdbs(m_handle);
+    config.register_repositories(m_handle);
+    m_sync_stamp = stamp;
+    
+    // The repository manager still points at the unregistered databases
+    return m_repo_manager->initialize();
+}
+
+bool PackageManager::reload_changed_local_database()
+{
+    // Worker threads checking for updates use the handle that is released here
+    std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+    int64_t stamp = database_directory_stamp(m_handle, "local");
+    if (stamp == m_local_stamp) {
+        return true;
+    }
+    
+    PacmanConfig config;
+    if (!config.load(m_config_path)) {
+        set_last_error(config.get_last_error());
         return false;
     }
+    
+    alpm_errno_t err;
+    alpm_handle_t* handle = alpm_initialize(alpm_option_get_root(m_handle), alpm_option_get_dbpath(m_handle), &err);
+    if (!handle) {
+        set_last_error(std::string("Failed to initialize alpm: ") + alpm_strerror(err));
+        return false;
+    }
+    alpm_option_set_logcb(handle, alpm_log_cb, nullptr);
+    config.apply(handle);
+    
+    // The repositories point into the old handle until they are loaded from the new one
+    alpm_handle_t* old_handle = m_handle;
+    m_handle = handle;
+    m_repo_manager->set_handle(handle);
+    delete m_trans_manager;
+    m_trans_manager = new TransactionManager(handle);
+    m_local_stamp = stamp;
+    m_sync_stamp = database_directory_stamp(m_handle, "sync");
+    
+    bool loaded = m_repo_manager->initialize();
+    alpm_release(old_handle);
+    return loaded;
+}
+
+bool PackageManager::reload_changed_databases()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+    // A new handle reads the sync databases again as well
+    if (!reload_changed_local_database()) {
+        return false;
+    }
+    return reload_changed_sync_databases();
 }
 
 bool PackageManager::update_system(const std::string& password, std::function<void(const std::string&)> output_callback, bool use_overwrite)
@@ -892,67 +1095,20 @@ bool PackageManager::update_system(const std::string& password, std::function<vo
         output_callback("Starting system update...\n");
     }
     
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_update_output.txt";
-    
-    // Run pacman -Syu with --noconfirm to avoid interactive prompts
-    // Redirect output to the temporary file
-    std::string command = "pacman -Syu --noconfirm ";
+    // Refresh the databases and upgrade in one helper request, like pacman -Syu
+    HelperRequest request = helper_request(HelperOperation::SYSUPGRADE, {}, HELPER_FLAG_REFRESH);
     
     // Add overwrite option if requested
     if (use_overwrite) {
-        command += "--overwrite \"*\" ";
+        request.flags |= HELPER_FLAG_OVERWRITE;
         
         if (output_callback) {
             output_callback("Using --overwrite=\"*\" option. This may overwrite conflicting files.\n");
         }
     }
     
-    command += "| tee " + temp_output_file;
-    
-    // Start a background thread to monitor the output file and send updates
-    std::atomic<bool> running(true);
-    std::thread output_thread;
-    
-    if (output_callback) {
-        output_thread = std::thread([temp_output_file, &output_callback, &running]() {
-            std::ifstream output_file(temp_output_file);
-            if (!output_file.is_open()) {
-                return;
-            }
-            
-            std::string line;
-            while (running) {
-                if (std::getline(output_file, line)) {
-                    output_callback(line + "\n");
-                } else {
-                    // Wait a bit before checking for more output
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            
-            // Read any remaining output
-            while (std::getline(output_file, line)) {
-                output_callback(line + "\n");
-            }
-            
-            output_file.close();
-        });
-    }
-    
-    // Execute the command
-    bool success = execute_with_sudo(command, password);
-    
-    // Stop the output thread and wait for it to finish
-    if (output_callback) {
-        running = false;
-        if (output_thread.joinable()) {
-            output_thread.join();
-        }
-    }
-    
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
+    // Execute the transaction, streaming its events to the callback
+    bool success = run_helper_request(request, password, output_callback);
     
     if (success) {
         std::cout << "PackageManager: System update completed successfully" << std::endl;
@@ -961,12 +1117,9 @@ bool PackageManager::update_system(const std::string& password, std::function<vo
             output_callback("System update completed successfully.\n");
         }
         
-        // Re-initialize to get updated package information
-        m_repo_manager->initialize();
-        
         return true;
     } else {
-        std::string error_message = "Failed to update system. Authentication may have failed.";
+        std::string error_message = "Failed to update system. " + m_last_error;
         set_last_error(error_message);
         
         if (output_callback) {
@@ -983,55 +1136,85 @@ bool PackageManager::update_system(const std::string& password, bool use_overwri
     return update_system(password, nullptr, use_overwrite);
 }
 
-std::vector<std::pair<std::string, std::string>> PackageManager::check_updates() const
+std::vector<PackageUpdate> PackageManager::check_updates()
 {
-    std::vector<std::pair<std::string, std::string>> updates;
+    std::vector<PackageUpdate> updates;
     
     std::cout << "PackageManager: Checking for available updates" << std::endl;
     
-    // Run pacman -Qu to check for updates
-    FILE* pipe = popen("pacman -Qu", "r");
-    if (!pipe) {
-        std::cerr << "PackageManager: Error running pacman -Qu" << std::endl;
+    if (!m_handle) {
+        set_last_error("ALPM handle not initialized");
         return updates;
     }
+    // The startup loader may still be reading the databases
+    m_repo_manager->wait_until_loaded();
+    std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+    if (!reload_changed_databases()) {
+        std::cerr << "PackageManager: Using previously loaded databases" << std::endl;
+    }
     
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
-        std::string line(buffer);
-        
-        // Parse output line (format: package_name old_version -> new_version)
-        size_t first_space = line.find(' ');
-        if (first_space != std::string::npos) {
-            std::string package_name = line.substr(0, first_space);
-            
-            // Find the arrow separator
-            size_t arrow_pos = line.find("->");
-            if (arrow_pos != std::string::npos) {
-                // Extract new version (skip spaces after arrow)
-                size_t version_start = arrow_pos + 2;
-                while (version_start < line.size() && isspace(line[version_start])) {
-                    version_start++;
-                }
-                
-                std::string new_version = line.substr(version_start);
-                // Trim trailing whitespace/newline
-                new_version.erase(new_version.find_last_not_of(" \n\r\t") + 1);
-                
-                updates.push_back(std::make_pair(package_name, new_version));
-            }
+    // One pass over the local database; ALPM looks each name up in the
+    // sync databases' hash tables and compares versions with alpm_pkg_vercmp
+    alpm_list_t* sync_dbs = alpm_get_syncdbs(m_handle);
+    for (alpm_list_t* i = alpm_db_get_pkgcache(alpm_get_localdb(m_handle)); i; i = alpm_list_next(i)) {
+        alpm_pkg_t* installed = static_cast<alpm_pkg_t*>(i->data);
+        alpm_pkg_t* candidate = alpm_sync_get_new_version(installed, sync_dbs);
+        if (!candidate) {
+            continue;
         }
+        
+        PackageUpdate update;
+        update.name = alpm_pkg_get_name(installed);
+        update.old_version = alpm_pkg_get_version(installed);
+        update.new_version = alpm_pkg_get_version(candidate);
+        update.repository = alpm_db_get_name(alpm_pkg_get_db(candidate));
+        update.download_size = static_cast<uint64_t>(alpm_pkg_download_size(candidate));
+        updates.push_back(std::move(update));
     }
     
-    pclose(pipe);
-    
     std::cout << "PackageManager: Found " << updates.size() << " available updates" << std::endl;
     return updates;
 }
 
-std::vector<std::pair<std::string, std::string>> PackageManager::check_aur_updates(const std::string& aur_helper) const
+std::vector<std::pair<std::string, std::string>> PackageManager::get_foreign_packages()
 {
-    std::vector<std::pair<std::string, std::string>> updates;
+    std::vector<std::pair<std::string, std::string>> foreign;
+    
+    if (!m_handle || !m_repo_manager) {
+        return foreign;
+    }
+    m_repo_manager->wait_until_loaded();
+    std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+    if (!reload_changed_databases()) {
+        std::cerr << "PackageManager: Using previously loaded databases" << std::endl;
+    }
+    
+    alpm_list_t* sync_dbs = alpm_get_syncdbs(m_handle);
+    for (alpm_list_t* i = alpm_db_get_pkgcache(alpm_get_localdb(m_handle)); i; i = alpm_list_next(i)) {
+        alpm_pkg_t* installed = static_cast<alpm_pkg_t*>(i->data);
+        const char* name = alpm_pkg_get_name(installed);
+        
+        bool in_sync = false;
+        for (alpm_list_t* j = sync_dbs; j && !in_sync; j = alpm_list_next(j)) {
+            in_sync = alpm_db_get_pkg(static_cast<alpm_db_t*>(j->data), name) != nullptr;
+        }
+        if (!in_sync) {
+            foreign.emplace_back(name, alpm_pkg_get_version(installed));
+        }
+    }
+    
+    return foreign;
+}
+
+std::vector<PackageUpdate> PackageManager::check_aur_updates()
+{
+    return check_aur_updates(get_foreign_packages());
+}
+
+std::vector<PackageUpdate> PackageManager::check_aur_updates(
+    const std::vector<std::pair<std::string, std::string>>& foreign) const
+{
+    std::vector<PackageUpdate> updates;
     
     // Check if AUR is enabled in settings
     QSettings settings("PacmanGUI", "PacmanGUI");
@@ -1042,71 +1225,48 @@ std::vector<std::pair<std::string, std::string>> PackageManager::check_aur_updat
         return updates;
     }
     
-    // Get the AUR helper to use
-    std::string helper = aur_helper;
-    if (helper.empty()) {
-        helper = settings.value("aur/helper", "yay").toString().toStdString();
-    }
-    
-    if (helper.empty()) {
-        std::cerr << "PackageManager: No AUR helper configured" << std::endl;
+    if (foreign.empty()) {
+        std::cout << "PackageManager: No foreign packages installed" << std::endl;
         return updates;
     }
     
-    std::cout << "PackageManager: Checking for available AUR updates using " << helper << std::endl;
+    std::cout << "PackageManager: Checking " << foreign.size() << " foreign packages for AUR updates" << std::endl;
     
-    // Different command formats based on helper
-    std::string update_check_cmd;
-    if (helper == "yay") {
-        update_check_cmd = "yay -Qua";
-    } else if (helper == "paru") {
-        update_check_cmd = "paru -Qua";
-    } else if (helper == "pikaur") {
-        update_check_cmd = "pikaur -Qua";
-    } else if (helper == "trizen") {
-        update_check_cmd = "trizen -Qua";
-    } else if (helper == "pacaur") {
-        update_check_cmd = "pacaur -Qua";
-    } else {
-        // Generic format for other helpers
-        update_check_cmd = helper + " -Qua";
+    std::vector<std::string> names;
+    names.reserve(foreign.size());
+    for (const auto& package : foreign) {
+        names.push_back(package.first);
     }
     
-    // Run the AUR helper to check for updates
-    FILE* pipe = popen(update_check_cmd.c_str(), "r");
-    if (!pipe) {
-        std::cerr << "PackageManager: Error running AUR update check" << std::endl;
+    std::vector<AurPackage> aur_packages;
+    if (!m_aur_client->info(names, aur_packages)) {
+        std::cerr << "PackageManager: AUR update check failed: " << m_aur_client->get_last_error() << std::endl;
         return updates;
     }
     
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
-        std::string line(buffer);
-        
-        // Parse output line (format depends on the helper but usually: package_name old_version -> new_version)
-        size_t first_space = line.find(' ');
-        if (first_space != std::string::npos) {
-            std::string package_name = line.substr(0, first_space);
-            
-            // Find the arrow separator (common in pacman-compatible output)
-            size_t arrow_pos = line.find("->");
-            if (arrow_pos != std::string::npos) {
-                // Extract new version (skip spaces after arrow)
-                size_t version_start = arrow_pos + 2;
-                while (version_start < line.size() && isspace(line[version_start])) {
-                    version_start++;
-                }
-                
-                std::string new_version = line.substr(version_start);
-                // Trim trailing whitespace/newline
-                new_version.erase(new_version.find_last_not_of(" \n\r\t") + 1);
-                
-                updates.push_back(std::make_pair(package_name, new_version));
-            }
-        }
+    // Packages that are not on the AUR either are left out of the response
+    std::unordered_map<std::string_view, const AurPackage*> by_name;
+    for (const AurPackage& aur_package : aur_packages) {
+        by_name.emplace(aur_package.name, &aur_package);
     }
     
-    pclose(pipe);
+    for (const auto& package : foreign) {
+        auto it = by_name.find(package.first);
+        if (it == by_name.end()) {
+            continue;
+        }
+        const AurPackage& aur_package = *it->second;
+        if (alpm_pkg_vercmp(aur_package.version.c_str(), package.second.c_str()) <= 0) {
+            continue;
+        }
+        
+        PackageUpdate update;
+        update.name = package.first;
+        update.old_version = package.second;
+        update.new_version = aur_package.version;
+        update.repository = "aur";
+        updates.push_back(std::move(update));
+    }
     
     std::cout << "PackageManager: Found " << updates.size() << " available AUR updates" << std::endl;
     return updates;
@@ -1128,6 +1288,20 @@ bool PackageManager::update_aur_packages(const std::string& password,
         return false;
     }
     
+    if (settings.value("aur/native_build", false).toBool()) {
+        std::vector<std::string> names;
+        for (const PackageUpdate& update : check_aur_updates()) {
+            names.push_back(update.name);
+        }
+        if (names.empty()) {
+            if (output_callback) {
+                output_callback("AUR packages are up to date.\n");
+            }
+            return true;
+        }
+        return install_aur_packages(names, password, output_callback);
+    }
+    
     // Get the AUR helper to use
     std::string helper = aur_helper;
     if (helper.empty()) {
@@ -1147,74 +1321,16 @@ bool PackageManager::update_aur_packages(const std::string& password,
         output_callback("Updating AUR packages using " + helper + "...\n");
     }
     
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_aur_update_output.txt";
-    
     // Different command formats based on helper
-    std::string update_cmd;
-    if (helper == "yay") {
-        update_cmd = "yay -Sua --noconfirm --needed";
-    } else if (helper == "paru") {
-        update_cmd = "paru -Sua --noconfirm --needed";
-    } else if (helper == "pikaur") {
-        update_cmd = "pikaur -Sua --noconfirm --needed";
-    } else if (helper == "trizen") {
-        update_cmd = "trizen -Sua --noconfirm --needed";
-    } else if (helper == "pacaur") {
-        update_cmd = "pacaur -Sua --noconfirm --needed";
-    } else if (helper == "aurman") {
-        update_cmd = "aurman -Sua --noconfirm --needed";
-    } else if (helper == "pamac") {
-        update_cmd = "pamac upgrade --aur --no-confirm";
+    std::vector<std::string> update_cmd;
+    if (helper == "pamac") {
+        update_cmd = {"pamac", "upgrade", "--aur", "--no-confirm"};
     } else {
-        // Generic format for other helpers
-        update_cmd = helper + " -Sua --noconfirm --needed";
-    }
-    
-    // Add output redirection
-    update_cmd += " | tee " + temp_output_file;
-    
-    // Start a background thread to monitor the output file and send updates
-    std::atomic<bool> running(true);
-    std::thread output_thread;
-    
-    if (output_callback) {
-        output_thread = std::thread([temp_output_file, &output_callback, &running]() {
-            std::ifstream output_file(temp_output_file);
-            if (!output_file.is_open()) {
-                return;
-            }
-            
-            std::string line;
-            while (running) {
-                if (std::getline(output_file, line)) {
-                    output_callback(line + "\n");
-                } else {
-                    // Wait a bit before checking for more output
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            
-            // Read any remaining output
-            while (std::getline(output_file, line)) {
-                output_callback(line + "\n");
-            }
-            
-            output_file.close();
-        });
-    }
-    
-    // Execute the command
-    bool success = execute_with_sudo(update_cmd, password);
-    
-    // Stop the output thread and wait for it to finish
-    if (output_callback && output_thread.joinable()) {
-        running = false;
-        output_thread.join();
+        // yay, paru, pikaur, trizen, pacaur, aurman and most other helpers
+        update_cmd = {helper, "-Sua", "--noconfirm", "--needed"};
     }
     
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
+    bool success = run_privileged(update_cmd, password, output_callback);
     
     if (success) {
         std::cout << "PackageManager: AUR packages updated successfully" << std::endl;
@@ -1223,7 +1339,7 @@ bool PackageManager::update_aur_packages(const std::string& password,
         }
         return true;
     } else {
-        std::string error_message = "Failed to update AUR packages using " + helper + ". Authentication may have failed.";
+        std::string error_message = "Failed to update AUR packages using " + helper + ": " + m_last_error;
         set_last_error(error_message);
         if (output_callback) {
             output_callback("ERROR: " + error_message + "\n");
@@ -1232,60 +1348,214 @@ bool PackageManager::update_aur_packages(const std::string& password,
     }
 }
 
-bool PackageManager::execute_with_sudo(const std::string& command, const std::string& password) {
-    std::cout << "PackageManager: Preparing to execute command with sudo" << std::endl;
+bool PackageManager::ensure_helper(const std::string& password)
+{
+    std::lock_guard<std::mutex> lock(m_helper_mutex);
     
-    // Use expect-like behavior to handle sudo password prompt more reliably
-    std::string quoted_password = "'";
-    for (char c : password) {
-        if (c == '\'') {
-            quoted_password += "'\\''"; // Escape single quotes in the password
-        } else {
-            quoted_password += c;
+    // The daemon serves only this process and exits once the connection closes
+    if (m_helper->is_connected()) {
+        return true;
+    }
+    
+    std::cout << "PackageManager: Starting pacmangui-helper daemon" << std::endl;
+    
+    std::vector<std::string> daemon = {PACMANGUI_HELPER_PATH, "--daemon", m_helper->get_socket_path(),
+                                       "--owner", std::to_string(getpid())};
+    std::vector<std::string> command;
+    if (password.empty()) {
+        command = {"pkexec"};
+        command.insert(command.end(), daemon.begin(), daemon.end());
+    } else {
+        command = sudo_command(daemon, password);
+    }
+    
+    // The helper forks once its socket is ready, so this returns right away
+    ProcessStatus status = run_process(command, sudo_input(password), [](const std::string& line, OutputStream) {
+        std::cout << "PackageManager: Helper output: " << line << std::endl;
+    });
+    if (!status.success()) {
+        set_last_error("pacmangui-helper " + status.describe() + ". Authentication may have failed.");
+        return false;
+    }
+    
+    if (!m_helper->connect()) {
+        set_last_error(m_helper->get_last_error());
+        return false;
+    }
+    return true;
+}
+
+bool PackageManager::run_helper_request(const HelperRequest& request, const std::string& password,
+                                        std::function<void(const std::string&)> output_callback)
+{
+    // Only package names and package files go to the root helper
+    for (const auto& target : request.targets) {
+        bool valid = request.operation == HelperOperation::INSTALL_FILES ? is_package_file_argument(target)
+                                                                         : is_safe_helper_argument(target);
+        if (!valid) {
+            set_last_error("Invalid package name: " + target);
+            return false;
         }
     }
-    quoted_password += "'";
     
-    // Create a command that:
-    // 1. Uses 'script' to simulate a terminal (sudo sometimes requires a TTY)
-    // 2. Pipes the password directly to sudo
-    // 3. Ensures the password isn't visible in process listings
-    std::string full_cmd = "script -qec 'echo " + quoted_password + " | sudo -S " + command + "' /dev/null";
+    if (!ensure_helper(password)) {
+        return false;
+    }
     
-    std::cout << "PackageManager: Executing sudo command with password authentication" << std::endl;
+    bool success = false;
+    bool finished = false;
+    std::string error;
+    std::vector<std::string> to_add;
+    std::vector<std::string> to_remove;
+    std::unordered_set<std::string> downloaded;
     
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_sudo_output.txt";
-    full_cmd += " 2>&1 | tee " + temp_output_file;
+    auto report = [&output_callback](const std::string& text) {
+        if (output_callback) {
+            output_callback(text + "\n");
+        }
+    };
+    
+    auto handle_message = [&](const HelperMessage& message) {
+        switch (message.type) {
+            case HelperMessageType::EVENT:
+                report(message.text);
+                break;
+            case HelperMessageType::PROGRESS:
+                // Only report each package once it is done to keep the log readable
+                if (message.percent == 100 && !message.target.empty()) {
+                    report("(" + std::to_string(message.current) + "/" + std::to_string(message.total) + ") " +
+                           message.operation + " " + message.target);
+                }
+                break;
+            case HelperMessageType::DOWNLOAD: {
+                // One line per finished file, with the run's aggregate throughput
+                const DownloadProgress& download = message.download;
+                if (download.total > 0 && download.downloaded == download.total &&
+                    downloaded.insert(download.filename).second) {
+                    report("(" + std::to_string(download.completed) + "/" + std::to_string(download.count) + ") " +
+                           download.filename + " " + format_bytes(static_cast<double>(download.total)) + " at " +
+                           format_bytes(download.rate) + "/s, total " +
+                           format_bytes(static_cast<double>(download.total_downloaded)) + " of " +
+                           format_bytes(static_cast<double>(download.total_size)) + " at " +
+                           format_bytes(download.total_rate) + "/s");
+                }
+                break;
+            }
+            case HelperMessageType::ADD:
+                to_add.push_back(message.text + "-" + message.target);
+                break;
+            case HelperMessageType::REMOVE:
+                to_remove.push_back(message.text + "-" + message.target);
+                break;
+            case HelperMessageType::ERROR:
+                error = message.text;
+                report("ERROR: " + message.text);
+                break;
+            case HelperMessageType::DONE:
+                success = message.success;
+                finished = true;
+                break;
+        }
+        
+        // The resolved sets arrive before the commit starts
+        if (message.type == HelperMessageType::EVENT || message.type == HelperMessageType::DONE) {
+            if (!to_add.empty()) {
+                std::string summary = "Packages (" + std::to_string(to_add.size()) + "):";
+                for (const auto& pkg : to_add) {
+                    summary += " " + pkg;
+                }
+                report(summary);
+                to_add.clear();
+            }
+            if (!to_remove.empty()) {
+                std::string summary = "Removing (" + std::to_string(to_remove.size()) + "):";
+                for (const auto& pkg : to_remove) {
+                    summary += " " + pkg;
+                }
+                report(summary);
+                to_remove.clear();
+            }
+        }
+    };
     
-    // Execute the command
-    int result = system(full_cmd.c_str());
+    m_helper->request(request, handle_message);
     
-    // Read and log the output
-    std::ifstream output_file(temp_output_file);
-    if (output_file.is_open()) {
-        std::string line;
-        while (std::getline(output_file, line)) {
-            std::cout << "PackageManager: Sudo output: " << line << std::endl;
+    // Even a failed transaction may have changed packages, the catalog and
+    // the installed flags have to follow the databases on disk
+    if (m_repo_manager) {
+        m_repo_manager->wait_until_loaded();
+        if (!reload_changed_databases()) {
+            std::cerr << "PackageManager: Failed to reload the databases after the transaction" << std::endl;
         }
-        output_file.close();
     }
     
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
+    if (!finished) {
+        set_last_error(m_helper->get_last_error());
+        return false;
+    }
     
-    if (result == 0) {
-        std::cout << "PackageManager: Sudo command executed successfully" << std::endl;
-        return true;
-    } else {
-        std::cerr << "PackageManager: Sudo command failed with exit code: " << result << std::endl;
+    if (!success) {
+        set_last_error(error.empty() ? "Operation failed" : error);
         return false;
     }
+    
+    return true;
 }
 
-bool PackageManager::execute_with_sudo(const std::string& command) {
-    // Call the free function
-    return ::pacmangui::core::execute_with_sudo(command);
+ProcessStatus PackageManager::run_process(const std::vector<std::string>& command, const std::string& input,
+                                          ProcessOutputCallback callback)
+{
+    ProcessRunner runner;
+    runner.set_input(input);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_process_mutex);
+        m_running_processes.push_back(&runner);
+    }
+    
+    ProcessStatus status = runner.run(command, std::move(callback));
+    
+    {
+        std::lock_guard<std::mutex> lock(m_process_mutex);
+        m_running_processes.erase(std::remove(m_running_processes.begin(), m_running_processes.end(), &runner),
+                                  m_running_processes.end());
+    }
+    
+    if (!status.started) {
+        std::cerr << "PackageManager: " << runner.get_last_error() << std::endl;
+    }
+    return status;
+}
+
+bool PackageManager::run_privileged(const std::vector<std::string>& command, const std::string& password,
+                                    std::function<void(const std::string&)> output_callback)
+{
+    ProcessStatus status = run_process(sudo_command(command, password), sudo_input(password),
+                                       forward_lines(output_callback));
+    if (!status.success()) {
+        // sudo exits with 1 for a wrong password as well as for a failed command
+        set_last_error(command.front() + " " + status.describe());
+        return false;
+    }
+    return true;
+}
+
+void PackageManager::cancel_running_operations()
+{
+    std::lock_guard<std::mutex> lock(m_process_mutex);
+    for (ProcessRunner* runner : m_running_processes) {
+        runner->cancel();
+    }
+    if (m_aur_builder) {
+        m_aur_builder->cancel();
+    }
+    m_helper->cancel();
+    m_flatpak_manager.cancel_transactions();
+}
+
+void PackageManager::cancel_flatpak_transactions()
+{
+    m_flatpak_manager.cancel_transactions();
 }
 
 bool PackageManager::clear_package_cache(bool clean_all, const std::string& password, 
@@ -1296,54 +1566,8 @@ bool PackageManager::clear_package_cache(bool clean_all, const std::string& pass
         output_callback("Starting package cache cleanup...\n");
     }
     
-    // Create the command based on the clean_all flag
-    std::string cmd = "pacman -S" + std::string(clean_all ? "cc" : "c") + " --noconfirm";
-    
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_cache_cleanup_output.txt";
-    cmd += " | tee " + temp_output_file;
-    
-    // Start a background thread to monitor the output file and send updates
-    std::atomic<bool> running(true);
-    std::thread output_thread;
-    
-    if (output_callback) {
-        output_thread = std::thread([temp_output_file, &output_callback, &running]() {
-            std::ifstream output_file(temp_output_file);
-            if (!output_file.is_open()) {
-                return;
-            }
-            
-            std::string line;
-            while (running) {
-                if (std::getline(output_file, line)) {
-                    output_callback(line + "\n");
-                } else {
-                    // Wait a bit before checking for more output
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            
-            // Read any remaining output
-            while (std::getline(output_file, line)) {
-                output_callback(line + "\n");
-            }
-            
-            output_file.close();
-        });
-    }
-    
-    // Execute the command
-    bool success = execute_with_sudo(cmd, password);
-    
-    // Stop the output thread and wait for it to finish
-    if (output_callback && output_thread.joinable()) {
-        running = false;
-        output_thread.join();
-    }
-    
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
+    HelperRequest request = helper_request(HelperOperation::CLEAN_CACHE, {}, clean_all ? HELPER_FLAG_CLEAN_ALL : 0);
+    bool success = run_helper_request(request, password, output_callback);
     
     if (success) {
         std::string msg = "Package cache cleanup " + std::string(clean_all ? "(all packages)" : "(unused packages)") + " completed successfully";
@@ -1353,7 +1577,7 @@ bool PackageManager::clear_package_cache(bool clean_all, const std::string& pass
         }
         return true;
     } else {
-        std::string error_message = "Failed to clean package cache. Authentication may have failed.";
+        std::string error_message = "Failed to clean package cache: " + m_last_error;
         set_last_error(error_message);
         if (output_callback) {
             output_callback("ERROR: " + error_message + "\n");
@@ -1364,34 +1588,15 @@ bool PackageManager::clear_package_cache(bool clean_all, const std::string& pass
 
 std::vector<std::string> PackageManager::get_orphaned_packages() const
 {
-    std::vector<std::string> orphaned_packages;
-    
     std::cout << "PackageManager: Finding orphaned packages" << std::endl;
     
-    // Use popen to capture the output of the command
-    std::string cmd = "pacman -Qtdq";
-    FILE* pipe = popen(cmd.c_str(), "r");
-    
-    if (!pipe) {
-        std::cerr << "PackageManager: Error executing command: " << cmd << std::endl;
-        return orphaned_packages;
-    }
-    
-    // Read the output line by line
-    char buffer[256];
-    while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-        // Remove newline characters
-        std::string line(buffer);
-        line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
-        
-        // Add the package name to the list
-        if (!line.empty()) {
-            orphaned_packages.push_back(line);
-        }
+    wait_until_loaded();
+    std::vector<std::string> orphaned_packages;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+        orphaned_packages = SystemMaintenance(m_handle).find_orphans();
     }
     
-    pclose(pipe);
-    
     std::cout << "PackageManager: Found " << orphaned_packages.size() << " orphaned packages" << std::endl;
     return orphaned_packages;
 }
@@ -1404,98 +1609,18 @@ bool PackageManager::remove_orphaned_packages(const std::string& password,
         output_callback("Finding and removing orphaned packages...\n");
     }
     
-    // First, get the list of orphaned packages
-    std::vector<std::string> orphaned = get_orphaned_packages();
-    
-    if (orphaned.empty()) {
-        std::string msg = "No orphaned packages found.";
-        std::cout << "PackageManager: " << msg << std::endl;
-        if (output_callback) {
-            output_callback(msg + "\n");
-        }
-        return true;
-    }
-    
-    if (output_callback) {
-        output_callback("Found " + std::to_string(orphaned.size()) + " orphaned packages.\n");
-    }
-    
-    // Create a temporary file to list orphaned packages
-    std::string temp_file = "/tmp/pacmangui_orphaned_packages.txt";
-    std::ofstream ofs(temp_file);
-    if (!ofs.is_open()) {
-        std::string error_message = "Failed to create temporary file for orphaned packages list";
-        set_last_error(error_message);
-        if (output_callback) {
-            output_callback("ERROR: " + error_message + "\n");
-        }
-        return false;
-    }
-    
-    for (const auto& pkg : orphaned) {
-        ofs << pkg << std::endl;
-    }
-    ofs.close();
-    
-    // Create the command to remove orphaned packages
-    std::string cmd = "cat " + temp_file + " | pacman -Rns - --noconfirm";
-    
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_remove_orphans_output.txt";
-    cmd += " | tee " + temp_output_file;
-    
-    // Start a background thread to monitor the output file and send updates
-    std::atomic<bool> running(true);
-    std::thread output_thread;
-    
-    if (output_callback) {
-        output_thread = std::thread([temp_output_file, &output_callback, &running]() {
-            std::ifstream output_file(temp_output_file);
-            if (!output_file.is_open()) {
-                return;
-            }
-            
-            std::string line;
-            while (running) {
-                if (std::getline(output_file, line)) {
-                    output_callback(line + "\n");
-                } else {
-                    // Wait a bit before checking for more output
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            
-            // Read any remaining output
-            while (std::getline(output_file, line)) {
-                output_callback(line + "\n");
-            }
-            
-            output_file.close();
-        });
-    }
-    
-    // Execute the command
-    bool success = execute_with_sudo(cmd, password);
-    
-    // Stop the output thread and wait for it to finish
-    if (output_callback && output_thread.joinable()) {
-        running = false;
-        output_thread.join();
-    }
-    
-    // Clean up temporary files
-    std::remove(temp_file.c_str());
-    std::remove(temp_output_file.c_str());
+    // The helper finds the orphans on its own, up to date handle
+    bool success = run_helper_request(helper_request(HelperOperation::REMOVE_ORPHANS), password, output_callback);
     
     if (success) {
-        std::string msg = "Successfully removed " + std::to_string(orphaned.size()) + " orphaned packages";
+        std::string msg = "Orphaned package removal completed successfully";
         std::cout << "PackageManager: " << msg << std::endl;
         if (output_callback) {
             output_callback(msg + "\n");
         }
         return true;
     } else {
-        std::string error_message = "Failed to remove orphaned packages. Authentication may have failed.";
+        std::string error_message = "Failed to remove orphaned packages: " + m_last_error;
         set_last_error(error_message);
         if (output_callback) {
             output_callback("ERROR: " + error_message + "\n");
@@ -1512,32 +1637,22 @@ bool PackageManager::check_database(bool check_sync_dbs,
         output_callback("Checking pacman database for errors...\n");
     }
     
-    // Create the command based on the check_sync_dbs flag
-    std::string cmd = "pacman -D" + std::string(check_sync_dbs ? "kk" : "k");
-    
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_db_check_output.txt";
-    
-    // Use popen to execute the command and capture the output
-    std::string full_cmd = cmd + " > " + temp_output_file + " 2>&1";
-    int result = system(full_cmd.c_str());
-    bool success = (result == 0);
-    
-    // Read the output file and send updates
-    if (output_callback) {
-        std::ifstream output_file(temp_output_file);
-        if (output_file.is_open()) {
-            std::string line;
-            while (std::getline(output_file, line)) {
+    // A running helper already has the databases loaded, otherwise check them here
+    bool success;
+    if (m_helper->is_connected()) {
+        HelperRequest request = helper_request(HelperOperation::CHECK_DATABASE, {},
+                                               check_sync_dbs ? HELPER_FLAG_CHECK_SYNC : 0);
+        success = run_helper_request(request, "", output_callback);
+    } else {
+        wait_until_loaded();
+        std::lock_guard<std::recursive_mutex> lock(m_handle_mutex);
+        success = SystemMaintenance(m_handle).check_database(check_sync_dbs, [&output_callback](const std::string& line) {
+            if (output_callback) {
                 output_callback(line + "\n");
             }
-            output_file.close();
-        }
+        });
     }
     
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
-    
     if (success) {
         std::string msg = "Database check " + std::string(check_sync_dbs ? "(including sync databases)" : "") + " completed without errors";
         std::cout << "PackageManager: " << msg << std::endl;
@@ -1642,30 +1757,10 @@ bool PackageManager::backup_database(const std::string& backup_path,
     }
     
     // Create the backup command
-    std::string cmd = "tar -czf " + backup_path + " /var/lib/pacman/local";
-    
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_backup_output.txt";
-    cmd += " 2>&1 | tee " + temp_output_file;
+    std::vector<std::string> cmd = {"tar", "-czf", backup_path, "/var/lib/pacman/local"};
     
-    // Execute the command
-    int result = system(cmd.c_str());
-    bool success = (result == 0);
-    
-    // Read the output file and send updates
-    if (output_callback) {
-        std::ifstream output_file(temp_output_file);
-        if (output_file.is_open()) {
-            std::string line;
-            while (std::getline(output_file, line)) {
-                output_callback(line + "\n");
-            }
-            output_file.close();
-        }
-    }
-    
-    // Clean up the temporary file
-    std::remove(temp_output_file.c_str());
+    ProcessStatus status = run_process(cmd, "", forward_lines(output_callback));
+    bool success = status.success();
     
     if (success) {
         std::string msg = "Pacman database backup completed successfully to " + backup_path;
@@ -1675,7 +1770,7 @@ bool PackageManager::backup_database(const std::string& backup_path,
         }
         return true;
     } else {
-        std::string error_message = "Failed to backup pacman database";
+        std::string error_message = "Failed to backup pacman database: tar " + status.describe();
         set_last_error(error_message);
         if (output_callback) {
             output_callback("ERROR: " + error_message + "\n");
@@ -1704,63 +1799,27 @@ bool PackageManager::restore_database(const std::string& backup_path, const std:
     }
     backup_file.close();
     
-    // Create a temporary directory
-    std::string temp_dir = "/tmp/pacmangui_restore_temp";
-    std::string mkdir_cmd = "mkdir -p " + temp_dir;
-    system(mkdir_cmd.c_str());
-    
-    // Command to restore the database
-    std::string cmd = "rm -rf " + temp_dir + "/* && "
-                     "tar -xzf " + backup_path + " -C " + temp_dir + " && "
-                     "rm -rf /var/lib/pacman/local && "
-                     "cp -a " + temp_dir + "/var/lib/pacman/local /var/lib/pacman/ && "
-                     "rm -rf " + temp_dir;
-    
-    // Create a temporary file to capture output
-    std::string temp_output_file = "/tmp/pacmangui_restore_output.txt";
-    cmd += " 2>&1 | tee " + temp_output_file;
-    
-    // Start a background thread to monitor the output file and send updates
-    std::atomic<bool> running(true);
-    std::thread output_thread;
-    
-    if (output_callback) {
-        output_thread = std::thread([temp_output_file, &output_callback, &running]() {
-            std::ifstream output_file(temp_output_file);
-            if (!output_file.is_open()) {
-                return;
-            }
-            
-            std::string line;
-            while (running) {
-                if (std::getline(output_file, line)) {
-                    output_callback(line + "\n");
-                } else {
-                    // Wait a bit before checking for more output
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
-            
-            // Read any remaining output
-            while (std::getline(output_file, line)) {
-                output_callback(line + "\n");
-            }
-            
-            output_file.close();
-        });
+    // A fresh private directory, so nobody can plant files or links in it beforehand
+    char temp_template[] = "/tmp/pacmangui-restore-XXXXXX";
+    if (!mkdtemp(temp_template)) {
+        std::string error_message = std::string("Failed to create a temporary directory: ") + strerror(errno);
+        set_last_error(error_message);
+        if (output_callback) {
+            output_callback("ERROR: " + error_message + "\n");
+        }
+        return false;
     }
+    std::string temp_dir = temp_template;
     
-    // Execute the command
-    bool success = execute_with_sudo(cmd, password);
-    
-    // Stop the output thread and wait for it to finish
-    if (output_callback && output_thread.joinable()) {
-        running = false;
-        output_thread.join();
-    }
+    // Extracted as root so the files keep their owners, then swapped in
+    bool success = run_privileged({"tar", "-xzf", backup_path, "-C", temp_dir}, password, output_callback) &&
+                   run_privileged({"rm", "-rf", "--", "/var/lib/pacman/local"}, password, output_callback) &&
+                   run_privileged({"cp", "-a", "--", temp_dir + "/var/lib/pacman/local", "/var/lib/pacman/"},
+                                  password, output_callback);
     
-    // Clean up temporary files
-    std::remove(temp_output_file.c_str());
+    std::string error = m_last_error;
+    run_privileged({"rm", "-rf", "--", temp_dir}, password, nullptr);
+    m_last_error = error;
     
     if (success) {
         std::string msg = "Pacman database restored successfully from " + backup_path;
@@ -1770,7 +1829,7 @@ bool PackageManager::restore_database(const std::string& backup_path, const std:
         }
         return true;
     } else {
-        std::string error_message = "Failed to restore pacman database. Authentication may have failed.";
+        std::string error_message = "Failed to restore pacman database: " + m_last_error;
         set_last_error(error_message);
         if (output_callback) {
             output_callback("ERROR: " + error_message + "\n");
@@ -1784,6 +1843,11 @@ std::vector<FlatpakPackage> PackageManager::get_installed_flatpak_packages() con
     return m_flatpak_manager.get_installed_packages();
 }
 
+bool PackageManager::get_flatpak_app_info(FlatpakPackage& package) const
+{
+    return m_flatpak_manager.get_app_info(package);
+}
+
 std::vector<FlatpakPackage> PackageManager::search_flatpak_by_name(const std::string& name) const
 {
     if (!is_flatpak_available()) {
@@ -1823,6 +1887,34 @@ bool PackageManager::update_all_flatpak_packages()
     return m_flatpak_manager.update_all();
 }
 
+bool PackageManager::install_flatpak_packages(const std::vector<std::string>& app_ids, const std::string& remote,
+                                              FlatpakProgressCallback callback)
+{
+    if (!m_flatpak_manager.install_packages(app_ids, remote, std::move(callback))) {
+        set_last_error(m_flatpak_manager.get_last_error());
+        return false;
+    }
+    return true;
+}
+
+bool PackageManager::remove_flatpak_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback)
+{
+    if (!m_flatpak_manager.remove_packages(app_ids, std::move(callback))) {
+        set_last_error(m_flatpak_manager.get_last_error());
+        return false;
+    }
+    return true;
+}
+
+bool PackageManager::update_flatpak_packages(const std::vector<std::string>& app_ids, FlatpakProgressCallback callback)
+{
+    if (!m_flatpak_manager.update_packages(app_ids, std::move(callback))) {
+        set_last_error(m_flatpak_manager.get_last_error());
+        return false;
+    }
+    return true;
+}
+
 bool PackageManager::is_flatpak_available() const
 {
     return m_flatpak_manager.is_available();
@@ -0,0 +1,308 @@
+#include "core/pacman_config.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <glob.h>
+#include <sys/utsname.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    // Include directives may nest, but a loop must not recurse forever
+    constexpr int kMaxIncludeDepth = 10;
+
+    std::string trim(const std::string& value)
+    {
+        size_t start = value.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) {
+            return "";
+        }
+        size_t end = value.find_last_not_of(" \t\r\n");
+        return value.substr(start, end - start + 1);
+    }
+
+    std::vector<std::string> split_words(const std::string& value)
+    {
+        std::vector<std::string> words;
+        std::istringstream stream(value);
+        std::string word;
+        while (stream >> word) {
+            words.push_back(word);
+        }
+        return words;
+    }
+
+    void replace_all(std::string& text, const std::string& from, const std::string& to)
+    {
+        size_t pos = 0;
+        while ((pos = text.find(from, pos)) != std::string::npos) {
+            text.replace(pos, from.size(), to);
+            pos += to.size();
+        }
+    }
+}
+
+PacmanConfig::PacmanConfig()
+    : m_cache_dirs{"/var/cache/pacman/pkg/"}
+    , m_root_dir("/")
+    , m_db_path("/var/lib/pacman/")
+    , m_gpg_dir("/etc/pacman.d/gnupg/")
+    , m_log_file("/var/log/pacman.log")
+    , m_parallel_downloads(1)
+    , m_cache_dirs_set(false)
+{
+}
+
+bool PacmanConfig::load(const std::string& path)
+{
+    m_repositories.clear();
+
+    std::string section;
+    if (!parse_file(path, section, 0)) {
+        return false;
+    }
+
+    // pacman always runs hooks shipped by packages, then the admin's own
+    if (m_hook_dirs.empty() || m_hook_dirs.front() != "/usr/share/libalpm/hooks/") {
+        m_hook_dirs.insert(m_hook_dirs.begin(), "/usr/share/libalpm/hooks/");
+    }
+    if (m_hook_dirs.size() == 1) {
+        m_hook_dirs.push_back("/etc/pacman.d/hooks/");
+    }
+
+    if (m_architectures.empty()) {
+        struct utsname uts;
+        if (uname(&uts) == 0) {
+            m_architectures.push_back(uts.machine);
+        }
+    }
+
+    // $arch is only known once the whole file has been read
+    for (auto& repo : m_repositories) {
+        for (auto& server : repo.servers) {
+            server = expand_server(server, repo.name);
+        }
+    }
+
+    std::cout << "PacmanConfig: Loaded " << m_repositories.size() << " repositories from " << path << std::endl;
+    return true;
+}
+
+bool PacmanConfig::parse_file(const std::string& path, std::string& section, int depth)
+{
+    if (depth > kMaxIncludeDepth) {
+        m_last_error = "Include nesting too deep at " + path;
+        return false;
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        m_last_error = "Failed to open " + path;
+        std::cerr << "PacmanConfig: " << m_last_error << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        // Comments may follow a value on the same line
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        line = trim(line);
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.front() == '[' && line.back() == ']') {
+            section = line.substr(1, line.size() - 2);
+            if (section != "options") {
+                m_repositories.push_back(PacmanRepository{section, {}});
+            }
+            continue;
+        }
+
+        std::string key = line;
+        std::string value;
+        size_t equals = line.find('=');
+        if (equals != std::string::npos) {
+            key = trim(line.substr(0, equals));
+            value = trim(line.substr(equals + 1));
+        }
+
+        if (key == "Include") {
+            // Include accepts glob patterns, like pacman.d/*.conf
+            glob_t matches;
+            if (glob(value.c_str(), GLOB_NOCHECK, nullptr, &matches) == 0) {
+                for (size_t i = 0; i < matches.gl_pathc; ++i) {
+                    std::string included = matches.gl_pathv[i];
+                    std::string included_section = section;
+                    parse_file(included, included_section, depth + 1);
+                }
+            }
+            globfree(&matches);
+            continue;
+        }
+
+        if (section == "options") {
+            set_option(key, value);
+        } else if (!section.empty() && key == "Server" && !m_repositories.empty()) {
+            m_repositories.back().servers.push_back(value);
+        }
+    }
+
+    return true;
+}
+
+void PacmanConfig::set_option(const std::string& key, const std::string& value)
+{
+    if (key == "CacheDir") {
+        if (!m_cache_dirs_set) {
+            m_cache_dirs.clear();
+            m_cache_dirs_set = true;
+        }
+        for (const auto& dir : split_words(value)) {
+            m_cache_dirs.push_back(dir);
+        }
+    } else if (key == "HookDir") {
+        for (const auto& dir : split_words(value)) {
+            m_hook_dirs.push_back(dir);
+        }
+    } else if (key == "Architecture") {
+        for (const auto& arch : split_words(value)) {
+            if (arch == "auto") {
+                struct utsname uts;
+                if (uname(&uts) == 0) {
+                    m_architectures.push_back(uts.machine);
+                }
+            } else {
+                m_architectures.push_back(arch);
+            }
+        }
+    } else if (key == "RootDir") {
+        m_root_dir = value;
+    } else if (key == "DBPath") {
+        m_db_path = value;
+    } else if (key == "GPGDir") {
+        m_gpg_dir = value;
+    } else if (key == "LogFile") {
+        m_log_file = value;
+    } else if (key == "ParallelDownloads") {
+        try {
+            m_parallel_downloads = static_cast<unsigned int>(std::max(1, std::stoi(value)));
+        } catch (const std::exception&) {
+            std::cerr << "PacmanConfig: Invalid ParallelDownloads value: " << value << std::endl;
+        }
+    }
+}
+
+std::string PacmanConfig::expand_server(const std::string& url, const std::string& repo) const
+{
+    std::string expanded = url;
+    replace_all(expanded, "$repo", repo);
+    if (!m_architectures.empty()) {
+        replace_all(expanded, "$arch", m_architectures.front());
+    }
+    return expanded;
+}
+
+bool PacmanConfig::apply(alpm_handle_t* handle) const
+{
+    if (!handle) {
+        return false;
+    }
+
+    for (const auto& dir : m_cache_dirs) {
+        alpm_option_add_cachedir(handle, dir.c_str());
+    }
+    for (const auto& dir : m_hook_dirs) {
+        alpm_option_add_hookdir(handle, dir.c_str());
+    }
+    for (const auto& arch : m_architectures) {
+        alpm_option_add_architecture(handle, arch.c_str());
+    }
+    alpm_option_set_gpgdir(handle, m_gpg_dir.c_str());
+    alpm_option_set_logfile(handle, m_log_file.c_str());
+    alpm_option_set_parallel_downloads(handle, m_parallel_downloads);
+
+    return register_repositories(handle);
+}
+
+bool PacmanConfig::register_repositories(alpm_handle_t* handle) const
+{
+    if (!handle) {
+        return false;
+    }
+
+    bool all_registered = true;
+    for (const auto& repo : m_repositories) {
+        alpm_db_t* db = alpm_register_syncdb(handle, repo.name.c_str(), ALPM_SIG_USE_DEFAULT);
+        if (!db) {
+            std::cerr << "PacmanConfig: Failed to register sync database " << repo.name << ": "
+                      << alpm_strerror(alpm_errno(handle)) << std::endl;
+            all_registered = false;
+            continue;
+        }
+
+        for (const auto& server : repo.servers) {
+            alpm_db_add_server(db, server.c_str());
+        }
+    }
+
+    return all_registered;
+}
+
+const std::vector<PacmanRepository>& PacmanConfig::get_repositories() const
+{
+    return m_repositories;
+}
+
+const std::vector<std::string>& PacmanConfig::get_cache_dirs() const
+{
+    return m_cache_dirs;
+}
+
+const std::vector<std::string>& PacmanConfig::get_hook_dirs() const
+{
+    return m_hook_dirs;
+}
+
+const std::vector<std::string>& PacmanConfig::get_architectures() const
+{
+    return m_architectures;
+}
+
+const std::string& PacmanConfig::get_root_dir() const
+{
+    return m_root_dir;
+}
+
+const std::string& PacmanConfig::get_db_path() const
+{
+    return m_db_path;
+}
+
+const std::string& PacmanConfig::get_gpg_dir() const
+{
+    return m_gpg_dir;
+}
+
+const std::string& PacmanConfig::get_log_file() const
+{
+    return m_log_file;
+}
+
+unsigned int PacmanConfig::get_parallel_downloads() const
+{
+    return m_parallel_downloads;
+}
+
+std::string PacmanConfig::get_last_error() const
+{
+    return m_last_error;
+}
+
+} // namespace core
+} // namespace pacmangui
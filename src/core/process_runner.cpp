@@ -0,0 +1,406 @@
+#include "core/process_runner.hpp"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <thread>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Time between SIGTERM and SIGKILL, and after SIGKILL before giving up on the pipes
+    constexpr auto kTerminateGrace = std::chrono::seconds(3);
+
+    // Upper bound for an epoll wait, so cancellation deadlines are checked
+    constexpr int kPollIntervalMs = 100;
+
+    struct OutputPipe {
+        int fd;
+        OutputStream stream;
+        std::string buffer;
+    };
+
+    int open_pidfd(pid_t pid)
+    {
+#ifdef SYS_pidfd_open
+        return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+        (void)pid;
+        return -1;
+#endif
+    }
+
+    // Writing to a child that already exited must not kill us with SIGPIPE
+    bool write_all(int fd, const std::string& data)
+    {
+        sigset_t pipe_set;
+        sigset_t old_set;
+        sigemptyset(&pipe_set);
+        sigaddset(&pipe_set, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+        bool ok = true;
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = write(fd, data.data() + written, data.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok = false;
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+
+        if (!ok && errno == EPIPE) {
+            // Swallow the SIGPIPE that is now pending for this thread
+            struct timespec no_wait = {0, 0};
+            sigtimedwait(&pipe_set, nullptr, &no_wait);
+        }
+        pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+        return ok;
+    }
+
+    void emit_lines(OutputPipe& pipe, const ProcessOutputCallback& callback)
+    {
+        size_t start = 0;
+        size_t newline;
+        while ((newline = pipe.buffer.find('\n', start)) != std::string::npos) {
+            size_t end = newline;
+            if (end > start && pipe.buffer[end - 1] == '\r') {
+                --end;
+            }
+            if (callback) {
+                callback(pipe.buffer.substr(start, end - start), pipe.stream);
+            }
+            start = newline + 1;
+        }
+        pipe.buffer.erase(0, start);
+    }
+
+    void flush_partial_line(OutputPipe& pipe, const ProcessOutputCallback& callback)
+    {
+        if (!pipe.buffer.empty() && callback) {
+            callback(pipe.buffer, pipe.stream);
+        }
+        pipe.buffer.clear();
+    }
+
+    // Reads everything available without blocking, returns false at end of file
+    bool drain(OutputPipe& pipe, const ProcessOutputCallback& callback)
+    {
+        char chunk[4096];
+        while (true) {
+            ssize_t n = read(pipe.fd, chunk, sizeof(chunk));
+            if (n > 0) {
+                pipe.buffer.append(chunk, static_cast<size_t>(n));
+                emit_lines(pipe, callback);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            flush_partial_line(pipe, callback);
+            return false;
+        }
+    }
+
+    void close_fd(int& fd)
+    {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+}
+
+std::string ProcessStatus::describe() const
+{
+    if (!started) {
+        return "could not be started";
+    }
+    if (abandoned) {
+        return "did not exit and was left running";
+    }
+    if (cancelled) {
+        return "was cancelled";
+    }
+    if (signal != 0) {
+        return "was terminated by signal " + std::to_string(signal) + " (" + strsignal(signal) + ")";
+    }
+    return "exited with status " + std::to_string(exit_code);
+}
+
+ProcessRunner::ProcessRunner()
+    : m_pid(0)
+    , m_cancelled(false)
+    , m_wake_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+}
+
+ProcessRunner::~ProcessRunner()
+{
+    close_fd(m_wake_fd);
+}
+
+void ProcessRunner::set_input(const std::string& input)
+{
+    m_input = input;
+}
+
+void ProcessRunner::set_working_directory(const std::string& directory)
+{
+    m_working_directory = directory;
+}
+
+ProcessStatus ProcessRunner::run(const std::vector<std::string>& args, ProcessOutputCallback callback)
+{
+    ProcessStatus status;
+    m_last_error.clear();
+
+    // A cancel() that came before the process could be spawned still counts
+    if (m_cancelled.exchange(false)) {
+        status.cancelled = true;
+        m_last_error = "Cancelled before the process was started";
+        return status;
+    }
+
+    if (args.empty()) {
+        m_last_error = "No program given";
+        return status;
+    }
+    if (m_pid != 0) {
+        m_last_error = "A process is already running";
+        return status;
+    }
+
+    int out[2] = {-1, -1};
+    int err[2] = {-1, -1};
+    int in[2] = {-1, -1};
+    if (pipe2(out, O_CLOEXEC) != 0 || pipe2(err, O_CLOEXEC) != 0 ||
+        (!m_input.empty() && pipe2(in, O_CLOEXEC) != 0)) {
+        m_last_error = std::string("Failed to create pipes: ") + strerror(errno);
+        for (int* fd : {&out[0], &out[1], &err[0], &err[1], &in[0], &in[1]}) {
+            close_fd(*fd);
+        }
+        return status;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err[1], STDERR_FILENO);
+    if (in[0] >= 0) {
+        posix_spawn_file_actions_adddup2(&actions, in[0], STDIN_FILENO);
+    }
+    if (!m_working_directory.empty()) {
+        posix_spawn_file_actions_addchdir_np(&actions, m_working_directory.c_str());
+    }
+
+    // Own process group so cancel() reaches everything the child starts,
+    // with the default signal handling the GUI may have changed
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty_set;
+    sigset_t default_set;
+    sigemptyset(&empty_set);
+    sigfillset(&default_set);
+    posix_spawnattr_setsigmask(&attr, &empty_set);
+    posix_spawnattr_setsigdefault(&attr, &default_set);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    std::vector<char*> argv;
+    argv.reserve(args.size() + 1);
+    for (const auto& arg : args) {
+        argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid = 0;
+    int spawn_result = posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    close_fd(out[1]);
+    close_fd(err[1]);
+    close_fd(in[0]);
+
+    if (spawn_result != 0) {
+        m_last_error = "Failed to start " + args[0] + ": " + strerror(spawn_result);
+        close_fd(out[0]);
+        close_fd(err[0]);
+        close_fd(in[1]);
+        return status;
+    }
+
+    status.started = true;
+    m_pid = pid;
+
+    if (in[1] >= 0) {
+        write_all(in[1], m_input);
+        close_fd(in[1]);
+    }
+
+    fcntl(out[0], F_SETFL, O_NONBLOCK);
+    fcntl(err[0], F_SETFL, O_NONBLOCK);
+
+    OutputPipe pipes[2] = {{out[0], OutputStream::STDOUT, ""}, {err[0], OutputStream::STDERR, ""}};
+    int pidfd = open_pidfd(pid);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    auto watch = [epoll_fd](int fd) {
+        if (fd >= 0) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        }
+    };
+    watch(pipes[0].fd);
+    watch(pipes[1].fd);
+    watch(pidfd);
+    watch(m_wake_fd);
+
+    int open_pipes = 2;
+    int wait_status = 0;
+    bool exited = false;
+    bool reaped = false;
+    bool term_sent = false;
+    bool kill_sent = false;
+    Clock::time_point deadline;
+
+    // Closed pipes do not mean the child exited, so a cancel is still handled while waiting for it
+    while (!exited) {
+        if (m_cancelled && !term_sent) {
+            kill(-pid, SIGTERM);
+            term_sent = true;
+            deadline = Clock::now() + kTerminateGrace;
+        } else if (term_sent && !kill_sent && Clock::now() >= deadline) {
+            kill(-pid, SIGKILL);
+            kill_sent = true;
+            deadline = Clock::now() + kTerminateGrace;
+        } else if (kill_sent && Clock::now() >= deadline) {
+            // A setuid child such as sudo or pkexec cannot be signalled (EPERM)
+            break;
+        }
+
+        epoll_event events[4];
+        int count = epoll_wait(epoll_fd, events, 4, kPollIntervalMs);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            m_last_error = std::string("epoll_wait failed: ") + strerror(errno);
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == m_wake_fd) {
+                uint64_t value;
+                while (read(m_wake_fd, &value, sizeof(value)) > 0) {
+                }
+            } else if (fd == pidfd) {
+                exited = true;
+            } else {
+                for (auto& pipe : pipes) {
+                    if (pipe.fd == fd && !drain(pipe, callback)) {
+                        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe.fd, nullptr);
+                        close_fd(pipe.fd);
+                        --open_pipes;
+                    }
+                }
+            }
+        }
+
+        // Without a pidfd the exit is only noticed by polling
+        if (pidfd < 0 && !exited && waitpid(pid, &wait_status, WNOHANG) == pid) {
+            exited = true;
+            reaped = true;
+        }
+    }
+
+    // Whatever the child wrote before exiting is still in the pipes. Anything
+    // after that would come from background processes it left running, which
+    // must not keep us waiting.
+    for (auto& pipe : pipes) {
+        if (pipe.fd >= 0) {
+            drain(pipe, callback);
+            flush_partial_line(pipe, callback);
+            close_fd(pipe.fd);
+        }
+    }
+    close_fd(pidfd);
+    close_fd(epoll_fd);
+
+    if (exited && !reaped) {
+        // The pidfd reported the exit, so this does not block
+        while (waitpid(pid, &wait_status, 0) < 0 && errno == EINTR) {
+        }
+    } else if (!exited) {
+        // Blocking here could hang forever, the child is reaped in the background whenever it exits
+        std::thread([pid]() {
+            int abandoned_status;
+            while (waitpid(pid, &abandoned_status, 0) < 0 && errno == EINTR) {
+            }
+        }).detach();
+        status.abandoned = true;
+        if (m_last_error.empty()) {
+            m_last_error = args[0] + " did not exit and was left running";
+        }
+    }
+    m_pid = 0;
+
+    status.cancelled = m_cancelled.exchange(false);
+    if (status.abandoned) {
+        return status;
+    }
+    if (WIFEXITED(wait_status)) {
+        status.exited = true;
+        status.exit_code = WEXITSTATUS(wait_status);
+    } else if (WIFSIGNALED(wait_status)) {
+        status.signal = WTERMSIG(wait_status);
+    }
+
+    return status;
+}
+
+void ProcessRunner::cancel()
+{
+    m_cancelled = true;
+    if (m_wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(m_wake_fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+bool ProcessRunner::is_running() const
+{
+    return m_pid != 0;
+}
+
+std::string ProcessRunner::get_last_error() const
+{
+    return m_last_error;
+}
+
+} // namespace core
+} // namespace pacmangui
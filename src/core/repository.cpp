@@ -1,4 +1,5 @@
 #include "repository.hpp"
+#include "core/thread_pool.hpp"
 #include <iostream>
 
 namespace pacmangui {
@@ -53,70 +54,6 @@ alpm_db_t* Repository::get_alpm_db() const
     return m_db;
 }
 
-std::vector<Package> Repository::get_packages() const
-{
-    std::vector<Package> packages;
-    
-    if (!m_db) {
-        std::cerr << "Repository: No database available for " << m_name << std::endl;
-        return packages;
-    }
-    
-    // Get the package cache from the database
-    alpm_list_t* pkg_list = alpm_db_get_pkgcache(m_db);
-    if (!pkg_list) {
-        std::cerr << "Repository: No package cache available for " << m_name << std::endl;
-        return packages;
-    }
-    
-    // Count packages for logging
-    int count = 0;
-    
-    // Convert ALPM packages to our Package objects
-    for (alpm_list_t* i = pkg_list; i; i = alpm_list_next(i)) {
-        alpm_pkg_t* pkg = static_cast<alpm_pkg_t*>(i->data);
-        if (!pkg) {
-            continue;
-        }
-        
-        const char* name = alpm_pkg_get_name(pkg);
-        const char* version = alpm_pkg_get_version(pkg);
-        const char* desc = alpm_pkg_get_desc(pkg);
-        
-        if (!name || !version) {
-            std::cerr << "Repository: Invalid package data in " << m_name << std::endl;
-            continue;
-        }
-        
-        Package package;
-        package.set_name(name);
-        package.set_version(version);
-        package.set_repository(m_name);
-        
-        // Description is optional
-        if (desc) {
-            package.set_description(desc);
-        } else {
-            package.set_description("No description available");
-        }
-        
-        // Set installed flag based on whether this is the local db
-        if (!m_is_sync) {
-            package.set_installed(true);
-        }
-        
-        packages.push_back(package);
-        count++;
-    }
-    
-    // Log how many packages were found for debugging
-    if (count == 0 && m_is_sync) {
-        std::cerr << "Repository: Warning - No packages found in sync repository " << m_name << std::endl;
-    }
-    
-    return packages;
-}
-
 Package Repository::find_package(const std::string& name) const
 {
     if (!m_db || name.empty()) {
@@ -151,6 +88,62 @@ Package Repository::find_package(const std::string& name) const
     return result;
 }
 
+std::vector<Repository::CacheEntry> Repository::read_cache() const
+{
+    std::vector<CacheEntry> entries;
+    if (!m_db) {
+        std::cerr << "Repository: No database available for " << m_name << std::endl;
+        return entries;
+    }
+    
+    alpm_list_t* pkg_list = alpm_db_get_pkgcache(m_db);
+    if (!pkg_list) {
+        std::cerr << "Repository: No package cache available for " << m_name << std::endl;
+        return entries;
+    }
+    
+    entries.reserve(alpm_list_count(pkg_list));
+    
+    // The getters may load package data lazily, so they stay on this thread too
+    for (alpm_list_t* i = pkg_list; i; i = alpm_list_next(i)) {
+        alpm_pkg_t* pkg = static_cast<alpm_pkg_t*>(i->data);
+        if (!pkg) {
+            continue;
+        }
+        
+        CacheEntry entry = {alpm_pkg_get_name(pkg), alpm_pkg_get_version(pkg), alpm_pkg_get_desc(pkg)};
+        if (!entry.name || !entry.version) {
+            std::cerr << "Repository: Invalid package data in " << m_name << std::endl;
+            continue;
+        }
+        entries.push_back(entry);
+    }
+    
+    return entries;
+}
+
+std::shared_ptr<const RepositoryCatalog> Repository::build_catalog(const std::vector<CacheEntry>& entries) const
+{
+    auto catalog = std::make_shared<RepositoryCatalog>(m_name, !m_is_sync);
+    catalog->reserve(entries.size());
+    
+    // Copy the strings straight into the pool
+    for (const CacheEntry& entry : entries) {
+        catalog->add(entry.name, entry.version, entry.desc ? entry.desc : "No description available");
+    }
+    
+    if (catalog->size() == 0 && m_is_sync) {
+        std::cerr << "Repository: Warning - No packages found in sync repository " << m_name << std::endl;
+    }
+    
+    return catalog;
+}
+
+std::shared_ptr<const RepositoryCatalog> Repository::load_catalog() const
+{
+    return build_catalog(read_cache());
+}
+
 void Repository::set_alpm_db(alpm_db_t* db)
 {
     if (db) {
@@ -170,16 +163,106 @@ RepositoryManager::RepositoryManager(alpm_handle_t* handle)
     : m_handle(handle)
     , m_local_db("local")
     , m_sync_dbs()
+    , m_generation(0)
+    , m_loading(false)
 {
 }
 
 RepositoryManager::~RepositoryManager()
 {
+    // The loader still uses the handle, let it finish before the handle goes away
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+    
     // We don't own the alpm handle, so don't free it here
     m_handle = nullptr;
 }
 
 bool RepositoryManager::initialize()
+{
+    wait_until_loaded();
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+    
+    return load(nullptr);
+}
+
+bool RepositoryManager::initialize_async(CatalogLoadedCallback on_loaded)
+{
+    if (!m_handle) {
+        std::cerr << "RepositoryManager: No ALPM handle provided" << std::endl;
+        return false;
+    }
+    
+    wait_until_loaded();
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+    
+    m_loading = true;
+    m_loader = std::thread([this, on_loaded]() {
+        load(on_loaded);
+        
+        {
+            std::lock_guard<std::mutex> lock(m_load_mutex);
+            m_loading = false;
+        }
+        m_load_done.notify_all();
+    });
+    
+    return true;
+}
+
+void RepositoryManager::set_snapshot_path(const std::string& path)
+{
+    m_snapshot_path = path;
+}
+
+void RepositoryManager::set_handle(alpm_handle_t* handle)
+{
+    wait_until_loaded();
+    if (m_loader.joinable()) {
+        m_loader.join();
+    }
+    
+    m_handle = handle;
+}
+
+bool RepositoryManager::load_snapshot()
+{
+    if (!m_handle || m_snapshot_path.empty()) {
+        return false;
+    }
+    wait_until_loaded();
+    
+    std::vector<DatabaseStamp> stamps = CatalogSnapshot::current_stamps(m_handle);
+    CatalogSnapshot snapshot(m_snapshot_path);
+    std::shared_ptr<const PackageCatalog> catalog = snapshot.load(stamps, m_generation + 1);
+    if (!catalog) {
+        std::cout << "RepositoryManager: " << snapshot.get_last_error() << std::endl;
+        return false;
+    }
+    
+    ++m_generation;
+    m_snapshot_stamps = std::move(stamps);
+    publish(std::move(catalog));
+    return true;
+}
+
+void RepositoryManager::wait_until_loaded() const
+{
+    std::unique_lock<std::mutex> lock(m_load_mutex);
+    m_load_done.wait(lock, [this]() { return !m_loading; });
+}
+
+bool RepositoryManager::is_loading() const
+{
+    return m_loading;
+}
+
+bool RepositoryManager::load(const CatalogLoadedCallback& on_loaded)
 {
     if (!m_handle) {
         std::cerr << "RepositoryManager: No ALPM handle provided" << std::endl;
@@ -193,81 +276,203 @@ bool RepositoryManager::initialize()
         return false;
     }
     
+    // Catalogs of the previous generation, so unchanged databases keep theirs
+    std::shared_ptr<const PackageCatalog> previous = get_catalog();
+    auto keep_unchanged = [&previous](std::shared_ptr<const RepositoryCatalog> loaded) -> std::shared_ptr<const RepositoryCatalog> {
+        if (previous) {
+            if (previous->get_local_ptr() && loaded->is_local() &&
+                previous->get_local_ptr()->get_fingerprint() == loaded->get_fingerprint()) {
+                return previous->get_local_ptr();
+            }
+            for (const auto& repo : previous->get_sync()) {
+                if (repo->get_name() == loaded->get_name() && !loaded->is_local() &&
+                    repo->get_fingerprint() == loaded->get_fingerprint()) {
+                    return repo;
+                }
+            }
+        }
+        return loaded;
+    };
+    
+    // Stamp before reading, a change during the load then shows up next time
+    std::vector<DatabaseStamp> stamps;
+    if (!m_snapshot_path.empty()) {
+        stamps = CatalogSnapshot::current_stamps(m_handle);
+    }
+    
+    // Get sync databases; initialize() may run again after a refresh, so start over
     m_local_db = Repository::create_from_alpm(local_db);
-    std::cout << "RepositoryManager: Loaded local database with " 
-              << m_local_db.get_packages().size() << " packages" << std::endl;
+    m_sync_dbs.clear();
     
-    // Get sync databases
     alpm_list_t* sync_dbs = alpm_get_syncdbs(m_handle);
     if (!sync_dbs) {
         std::cerr << "RepositoryManager: No sync databases found" << std::endl;
-        return true; // Still return true since we have the local db
     }
     
-    int repo_count = 0;
+    size_t repo_count = alpm_list_count(sync_dbs);
+    m_sync_dbs.reserve(repo_count);
     for (alpm_list_t* item = sync_dbs; item; item = alpm_list_next(item)) {
         alpm_db_t* db = static_cast<alpm_db_t*>(item->data);
         if (db) {
-            Repository repo = Repository::create_from_alpm(db);
-            m_sync_dbs.push_back(repo);
-            repo_count++;
-            
-            // Display repository info
-            std::cout << "RepositoryManager: Loaded " << repo.get_name() 
-                     << " repository with " << repo.get_packages().size() 
-                     << " packages" << std::endl;
+            m_sync_dbs.push_back(Repository::create_from_alpm(db));
+        }
+    }
+    
+    // All databases share one ALPM handle, which is not thread-safe, so
+    // their package caches are read one after another on this thread. Only
+    // copying the strings into catalogs is spread over the pool; results
+    // keep the configuration order.
+    std::vector<std::shared_ptr<const RepositoryCatalog>> sync_catalogs(m_sync_dbs.size());
+    std::shared_ptr<const RepositoryCatalog> local_catalog;
+    
+    // On the first load the installed packages can be shown before the
+    // much larger sync databases have been read
+    if (on_loaded && !previous) {
+        local_catalog = keep_unchanged(m_local_db.load_catalog());
+        publish(std::make_shared<const PackageCatalog>(
+            ++m_generation, local_catalog, std::vector<std::shared_ptr<const RepositoryCatalog>>()));
+        on_loaded(false);
+    }
+    
+    std::vector<std::vector<Repository::CacheEntry>> sync_entries;
+    sync_entries.reserve(m_sync_dbs.size());
+    for (const Repository& repo : m_sync_dbs) {
+        sync_entries.push_back(repo.read_cache());
+    }
+    std::vector<Repository::CacheEntry> local_entries;
+    if (!local_catalog) {
+        local_entries = m_local_db.read_cache();
+    }
+    
+    auto build_database = [&](size_t index) {
+        if (index == m_sync_dbs.size()) {
+            local_catalog = keep_unchanged(m_local_db.build_catalog(local_entries));
+        } else {
+            sync_catalogs[index] = keep_unchanged(m_sync_dbs[index].build_catalog(sync_entries[index]));
+        }
+    };
+    ThreadPool::shared().parallel_for(m_sync_dbs.size() + (local_catalog ? 0 : 1), build_database);
+    
+    std::cout << "RepositoryManager: Loaded local database with " 
+              << local_catalog->size() << " packages" << std::endl;
+    for (const auto& catalog : sync_catalogs) {
+        std::cout << "RepositoryManager: Loaded " << catalog->get_name() 
+                 << " repository with " << catalog->size() 
+                 << " packages" << std::endl;
+    }
+    
+    // Publish the new generation; readers still holding the old catalog keep it alive
+    previous.reset();
+    auto catalog = std::make_shared<const PackageCatalog>(
+        ++m_generation, std::move(local_catalog), std::move(sync_catalogs));
+    publish(catalog);
+    
+    // Only write the snapshot when the databases moved on since the last one
+    if (!m_snapshot_path.empty() && stamps != m_snapshot_stamps) {
+        CatalogSnapshot snapshot(m_snapshot_path);
+        if (snapshot.save(*catalog, stamps)) {
+            m_snapshot_stamps = std::move(stamps);
+        } else {
+            std::cerr << "RepositoryManager: " << snapshot.get_last_error() << std::endl;
         }
     }
     
     std::cout << "RepositoryManager: Successfully initialized with " 
               << repo_count << " sync repositories" << std::endl;
     
-    return true;
+    if (on_loaded) {
+        on_loaded(true);
+    }
+    
+    return true; // Still true without sync databases since we have the local db
+}
+
+void RepositoryManager::publish(std::shared_ptr<const PackageCatalog> catalog)
+{
+    // Only databases whose catalog changed get indexed again
+    std::shared_ptr<const SearchIndex> previous_index = get_search_index();
+    auto search_index = std::make_shared<const SearchIndex>(catalog, previous_index.get());
+    std::cout << "RepositoryManager: Built search index, reused " 
+              << search_index->get_reused_segments() << " unchanged databases" << std::endl;
+    previous_index.reset();
+    
+    std::lock_guard<std::mutex> lock(m_catalog_mutex);
+    m_catalog = std::move(catalog);
+    m_search_index = std::move(search_index);
 }
 
-Repository RepositoryManager::get_local_db() const
+const Repository& RepositoryManager::get_local_db() const
 {
+    wait_until_loaded();
     return m_local_db;
 }
 
-std::vector<Repository> RepositoryManager::get_sync_dbs() const
+const std::vector<Repository>& RepositoryManager::get_sync_dbs() const
 {
+    wait_until_loaded();
     return m_sync_dbs;
 }
 
+std::shared_ptr<const PackageCatalog> RepositoryManager::get_catalog() const
+{
+    std::lock_guard<std::mutex> lock(m_catalog_mutex);
+    return m_catalog;
+}
+
+std::shared_ptr<const SearchIndex> RepositoryManager::get_search_index() const
+{
+    std::lock_guard<std::mutex> lock(m_catalog_mutex);
+    return m_search_index;
+}
+
 Package RepositoryManager::find_package(const std::string& name) const
 {
-    // First check in local database
-    Package pkg = m_local_db.find_package(name);
-    if (!pkg.get_name().empty()) {
-        return pkg;
+    std::shared_ptr<const PackageCatalog> catalog = get_catalog();
+    if (!catalog) {
+        return Package();
     }
     
-    // Then check in sync databases
-    for (const auto& repo : m_sync_dbs) {
-        pkg = repo.find_package(name);
-        if (!pkg.get_name().empty()) {
-            return pkg;
-        }
+    // The catalog checks the local database first, then the sync databases
+    std::optional<PackageView> view = catalog->find(name);
+    if (!view) {
+        return Package();
     }
     
-    return Package();
+    return view->to_package();
 }
 
 std::vector<Package> RepositoryManager::get_all_packages() const
 {
     std::vector<Package> all_packages;
     
-    // Get packages from local database
-    std::vector<Package> local_packages = m_local_db.get_packages();
-    all_packages.insert(all_packages.end(), local_packages.begin(), local_packages.end());
+    std::shared_ptr<const PackageCatalog> catalog = get_catalog();
+    if (!catalog) {
+        return all_packages;
+    }
     
-    // Get packages from sync databases
-    for (const auto& repo : m_sync_dbs) {
-        std::vector<Package> repo_packages = repo.get_packages();
-        all_packages.insert(all_packages.end(), repo_packages.begin(), repo_packages.end());
+    // Installed packages first, then each sync database in configuration order
+    std::vector<const RepositoryCatalog*> repos;
+    std::vector<size_t> offsets;
+    size_t total = 0;
+    if (catalog->get_local()) {
+        repos.push_back(catalog->get_local());
+    }
+    for (const auto& repo : catalog->get_sync()) {
+        repos.push_back(repo.get());
+    }
+    for (const RepositoryCatalog* repo : repos) {
+        offsets.push_back(total);
+        total += repo->size();
     }
     
+    // Each database converts into its own slice of the result
+    all_packages.resize(total);
+    ThreadPool::shared().parallel_for(repos.size(), [&](size_t r) {
+        for (size_t i = 0; i < repos[r]->size(); ++i) {
+            all_packages[offsets[r] + i] = repos[r]->at(i).to_package();
+        }
+    });
+    
     return all_packages;
 }
 
@@ -0,0 +1,783 @@
+#include "core/search_index.hpp"
+#include "core/thread_pool.hpp"
+#include "core/fuzzy_matcher.hpp"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cctype>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    constexpr int kExactScore = 1000;
+    constexpr int kPrefixScore = 500;
+    constexpr int kSubstringScore = 250;
+    constexpr int kWordWeightScore = 10;
+
+    // Packages scanned between two looks at the cancellation flag
+    constexpr uint32_t kCancelCheckInterval = 1024;
+
+    bool is_cancelled(const std::atomic<bool>* cancelled)
+    {
+        return cancelled && cancelled->load(std::memory_order_relaxed);
+    }
+
+    std::string to_lower(std::string_view value)
+    {
+        std::string lowered(value);
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                       [](unsigned char c){ return std::tolower(c); });
+        return lowered;
+    }
+
+    uint32_t trigram_key(std::string_view text, size_t pos)
+    {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(text[pos])) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 1])) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(text[pos + 2]));
+    }
+
+    // Split lowercase text into words of letters and digits, calling fn for each
+    template <typename Fn>
+    void for_each_word(std::string_view text, Fn&& fn)
+    {
+        size_t start = 0;
+        while (start < text.size()) {
+            while (start < text.size() && !std::isalnum(static_cast<unsigned char>(text[start]))) {
+                ++start;
+            }
+            size_t end = start;
+            while (end < text.size() && std::isalnum(static_cast<unsigned char>(text[end]))) {
+                ++end;
+            }
+            if (end > start) {
+                fn(text.substr(start, end - start));
+            }
+            start = end;
+        }
+    }
+
+    // Turn sorted (key << 32 | package) pairs into an offset table and a postings array
+    void build_postings(std::vector<uint64_t>& pairs, size_t key_count,
+                        std::vector<uint32_t>& offsets, std::vector<uint32_t>& postings)
+    {
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        offsets.assign(key_count + 1, 0);
+        postings.resize(pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            offsets[(pairs[i] >> 32) + 1]++;
+            postings[i] = static_cast<uint32_t>(pairs[i]);
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    }
+
+    int name_score(std::string_view lower_name, std::string_view query, MatchKind& kind)
+    {
+        if (lower_name == query) {
+            kind = MatchKind::Exact;
+            return kExactScore;
+        }
+        if (lower_name.compare(0, query.size(), query) == 0) {
+            kind = MatchKind::Prefix;
+            return kPrefixScore;
+        }
+        kind = MatchKind::Substring;
+        return kSubstringScore;
+    }
+
+    // Higher score first, then shorter and alphabetically earlier names
+    bool hit_before(const SearchHit& a, const SearchHit& b)
+    {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        if (a.package.name.size() != b.package.name.size()) {
+            return a.package.name.size() < b.package.name.size();
+        }
+        return a.package.name < b.package.name;
+    }
+}
+
+// SearchSegment implementation
+
+SearchSegment::SearchSegment(std::shared_ptr<const RepositoryCatalog> repo)
+    : m_repo(std::move(repo))
+{
+    const uint32_t count = static_cast<uint32_t>(m_repo->size());
+
+    // Lowercase names and their trigrams
+    m_name_offsets.reserve(count + 1);
+    m_name_offsets.push_back(0);
+    std::vector<uint64_t> trigram_pairs;
+    trigram_pairs.reserve(static_cast<size_t>(count) * 12);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string_view name = m_repo->name_at(i);
+        size_t start = m_lower_names.size();
+        m_lower_names += to_lower(name);
+        m_name_offsets.push_back(static_cast<uint32_t>(m_lower_names.size()));
+
+        std::string_view lowered(m_lower_names.data() + start, name.size());
+        for (size_t pos = 0; pos + 3 <= lowered.size(); ++pos) {
+            trigram_pairs.push_back((static_cast<uint64_t>(trigram_key(lowered, pos)) << 32) | i);
+        }
+    }
+
+    // Replace raw trigrams by their rank so they can address the offset table
+    std::vector<uint32_t> keys;
+    keys.reserve(trigram_pairs.size());
+    for (uint64_t pair : trigram_pairs) {
+        keys.push_back(static_cast<uint32_t>(pair >> 32));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    for (uint64_t& pair : trigram_pairs) {
+        uint64_t rank = std::lower_bound(keys.begin(), keys.end(), static_cast<uint32_t>(pair >> 32)) - keys.begin();
+        pair = (rank << 32) | static_cast<uint32_t>(pair);
+    }
+    m_trigram_keys = std::move(keys);
+    build_postings(trigram_pairs, m_trigram_keys.size(), m_trigram_offsets, m_trigram_postings);
+
+    // Name order for prefix lookups
+    m_sorted.resize(count);
+    std::iota(m_sorted.begin(), m_sorted.end(), 0);
+    std::sort(m_sorted.begin(), m_sorted.end(), [this](uint32_t a, uint32_t b) {
+        return lower_name(a) < lower_name(b);
+    });
+
+    // Word index over name parts and descriptions
+    std::unordered_map<std::string, uint32_t> vocabulary;
+    std::vector<uint64_t> word_pairs;
+    for (uint32_t i = 0; i < count; ++i) {
+        auto add_word = [&](std::string_view word) {
+            auto inserted = vocabulary.emplace(std::string(word), static_cast<uint32_t>(vocabulary.size()));
+            word_pairs.push_back((static_cast<uint64_t>(inserted.first->second) << 32) | i);
+        };
+        for_each_word(lower_name(i), add_word);
+        for_each_word(to_lower(m_repo->at(i).description), add_word);
+    }
+
+    // Sort the vocabulary so a term can match a range of words by prefix
+    std::vector<const std::string*> words(vocabulary.size());
+    for (const auto& entry : vocabulary) {
+        words[entry.second] = &entry.first;
+    }
+    std::vector<uint32_t> order(words.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&words](uint32_t a, uint32_t b) {
+        return *words[a] < *words[b];
+    });
+
+    std::vector<uint32_t> rank(words.size());
+    m_word_offsets.reserve(words.size() + 1);
+    m_word_offsets.push_back(0);
+    for (uint32_t r = 0; r < order.size(); ++r) {
+        rank[order[r]] = r;
+        m_words += *words[order[r]];
+        m_word_offsets.push_back(static_cast<uint32_t>(m_words.size()));
+    }
+    for (uint64_t& pair : word_pairs) {
+        pair = (static_cast<uint64_t>(rank[pair >> 32]) << 32) | static_cast<uint32_t>(pair);
+    }
+    build_postings(word_pairs, words.size(), m_word_post_offsets, m_word_postings);
+}
+
+const RepositoryCatalog& SearchSegment::get_repository() const
+{
+    return *m_repo;
+}
+
+std::string_view SearchSegment::lower_name(uint32_t index) const
+{
+    return std::string_view(m_lower_names.data() + m_name_offsets[index],
+                            m_name_offsets[index + 1] - m_name_offsets[index]);
+}
+
+void SearchSegment::find_substring(std::string_view needle, std::vector<uint32_t>& out,
+                                   const std::atomic<bool>* cancelled) const
+{
+    const uint32_t count = static_cast<uint32_t>(m_name_offsets.size() - 1);
+
+    // Too short for trigrams, scan the contiguous name buffer instead
+    if (needle.size() < 3) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (i % kCancelCheckInterval == 0 && is_cancelled(cancelled)) {
+                return;
+            }
+            if (lower_name(i).find(needle) != std::string_view::npos) {
+                out.push_back(i);
+            }
+        }
+        return;
+    }
+
+    // Collect the postings of every trigram in the needle, shortest first
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (size_t pos = 0; pos + 3 <= needle.size(); ++pos) {
+        uint32_t key = trigram_key(needle, pos);
+        auto it = std::lower_bound(m_trigram_keys.begin(), m_trigram_keys.end(), key);
+        if (it == m_trigram_keys.end() || *it != key) {
+            return;
+        }
+        size_t k = it - m_trigram_keys.begin();
+        ranges.emplace_back(m_trigram_offsets[k], m_trigram_offsets[k + 1]);
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) {
+        return (a.second - a.first) < (b.second - b.first);
+    });
+    ranges.erase(std::unique(ranges.begin(), ranges.end()), ranges.end());
+
+    std::vector<uint32_t> candidates(m_trigram_postings.begin() + ranges[0].first,
+                                     m_trigram_postings.begin() + ranges[0].second);
+    std::vector<uint32_t> narrowed;
+    for (size_t r = 1; r < ranges.size() && !candidates.empty(); ++r) {
+        narrowed.clear();
+        std::set_intersection(candidates.begin(), candidates.end(),
+                              m_trigram_postings.begin() + ranges[r].first,
+                              m_trigram_postings.begin() + ranges[r].second,
+                              std::back_inserter(narrowed));
+        candidates.swap(narrowed);
+    }
+
+    // Trigrams can match out of order, so confirm each candidate
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (i % kCancelCheckInterval == 0 && is_cancelled(cancelled)) {
+            return;
+        }
+        uint32_t index = candidates[i];
+        if (lower_name(index).find(needle) != std::string_view::npos) {
+            out.push_back(index);
+        }
+    }
+}
+
+void SearchSegment::find_prefix(std::string_view prefix, std::vector<uint32_t>& out) const
+{
+    auto first = std::lower_bound(m_sorted.begin(), m_sorted.end(), prefix,
+                                  [this](uint32_t index, std::string_view value) {
+                                      return lower_name(index) < value;
+                                  });
+
+    for (auto it = first; it != m_sorted.end(); ++it) {
+        if (lower_name(*it).compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        out.push_back(*it);
+    }
+}
+
+void SearchSegment::find_words(const std::vector<std::string>& terms,
+                               std::vector<std::pair<uint32_t, int>>& out) const
+{
+    const uint32_t word_count = static_cast<uint32_t>(m_word_offsets.size() - 1);
+    auto word_at = [this](uint32_t w) {
+        return std::string_view(m_words.data() + m_word_offsets[w], m_word_offsets[w + 1] - m_word_offsets[w]);
+    };
+
+    std::vector<std::pair<uint32_t, int>> accumulated;
+    std::vector<std::pair<uint32_t, int>> term_hits;
+    std::vector<std::pair<uint32_t, int>> merged;
+
+    for (size_t t = 0; t < terms.size(); ++t) {
+        const std::string& term = terms[t];
+        term_hits.clear();
+
+        // Words sharing the term as prefix form one contiguous range of the vocabulary
+        uint32_t lo = 0, hi = word_count;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (word_at(mid) < term) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (uint32_t w = lo; w < word_count; ++w) {
+            std::string_view word = word_at(w);
+            if (word.compare(0, term.size(), term) != 0) {
+                break;
+            }
+            int weight = word.size() == term.size() ? 2 : 1;
+            for (uint32_t p = m_word_post_offsets[w]; p < m_word_post_offsets[w + 1]; ++p) {
+                term_hits.emplace_back(m_word_postings[p], weight);
+            }
+        }
+
+        // Keep the best weight per package
+        std::sort(term_hits.begin(), term_hits.end(), [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first < b.first : a.second > b.second;
+        });
+        term_hits.erase(std::unique(term_hits.begin(), term_hits.end(), [](const auto& a, const auto& b) {
+            return a.first == b.first;
+        }), term_hits.end());
+
+        if (t == 0) {
+            accumulated.swap(term_hits);
+            continue;
+        }
+
+        // Every term has to match, so intersect with the packages found so far
+        merged.clear();
+        auto a = accumulated.begin();
+        auto b = term_hits.begin();
+        while (a != accumulated.end() && b != term_hits.end()) {
+            if (a->first < b->first) {
+                ++a;
+            } else if (b->first < a->first) {
+                ++b;
+            } else {
+                merged.emplace_back(a->first, a->second + b->second);
+                ++a;
+                ++b;
+            }
+        }
+        accumulated.swap(merged);
+        if (accumulated.empty()) {
+            break;
+        }
+    }
+
+    out.insert(out.end(), accumulated.begin(), accumulated.end());
+}
+
+// SearchIndex implementation
+
+SearchIndex::SearchIndex(std::shared_ptr<const PackageCatalog> catalog, const SearchIndex* previous)
+    : m_catalog(std::move(catalog))
+    , m_reused(0)
+{
+    // Segments are keyed by the repository catalog they index; an unchanged
+    // repository keeps its catalog object across generations
+    auto find_segment = [previous](const PackageCatalog::RepositoryPtr& repo) -> SegmentPtr {
+        if (previous) {
+            if (previous->m_local && &previous->m_local->get_repository() == repo.get()) {
+                return previous->m_local;
+            }
+            for (const auto& segment : previous->m_sync) {
+                if (&segment->get_repository() == repo.get()) {
+                    return segment;
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    if (!m_catalog) {
+        return;
+    }
+
+    // Local database first, then the sync databases in configuration order
+    std::vector<PackageCatalog::RepositoryPtr> repos;
+    if (m_catalog->get_local()) {
+        repos.push_back(m_catalog->get_local_ptr());
+    }
+    repos.insert(repos.end(), m_catalog->get_sync().begin(), m_catalog->get_sync().end());
+
+    std::vector<SegmentPtr> segments(repos.size());
+    std::vector<size_t> changed;
+    for (size_t i = 0; i < repos.size(); ++i) {
+        segments[i] = find_segment(repos[i]);
+        if (!segments[i]) {
+            changed.push_back(i);
+        }
+    }
+    m_reused = repos.size() - changed.size();
+
+    // Segments are independent, so changed repositories are indexed in parallel
+    ThreadPool::shared().parallel_for(changed.size(), [&](size_t i) {
+        segments[changed[i]] = std::make_shared<const SearchSegment>(repos[changed[i]]);
+    });
+
+    size_t first_sync = 0;
+    if (m_catalog->get_local()) {
+        m_local = segments[0];
+        first_sync = 1;
+    }
+    m_sync.assign(segments.begin() + first_sync, segments.end());
+}
+
+std::shared_ptr<const PackageCatalog> SearchIndex::get_catalog() const
+{
+    return m_catalog;
+}
+
+size_t SearchIndex::get_reused_segments() const
+{
+    return m_reused;
+}
+
+std::vector<SearchHit> SearchIndex::search_names(std::string_view query, const std::atomic<bool>* cancelled) const
+{
+    std::vector<SearchHit> results;
+    if (!m_catalog || query.empty()) {
+        return results;
+    }
+
+    const std::string needle = to_lower(query);
+
+    return collect_segments([&](const SearchSegment& segment, bool skip_installed, std::vector<SearchHit>& hits) {
+        find_names(segment, skip_installed, needle, hits, cancelled);
+    }, cancelled);
+}
+
+std::vector<SearchHit> SearchIndex::search_names(std::string_view query, size_t segment,
+                                                 const std::atomic<bool>* cancelled) const
+{
+    std::vector<SearchHit> results;
+    if (!m_catalog || query.empty() || segment >= get_segment_count()) {
+        return results;
+    }
+
+    const SearchSegment& searched = get_segment(segment);
+    find_names(searched, &searched != m_local.get(), to_lower(query), results, cancelled);
+    return results;
+}
+
+std::vector<SearchHit> SearchIndex::refine_names(std::string_view query, const std::vector<SearchHit>& previous,
+                                                 const std::atomic<bool>* cancelled) const
+{
+    std::vector<SearchHit> results;
+    if (!m_catalog || query.empty()) {
+        return results;
+    }
+
+    const std::string needle = to_lower(query);
+    std::string lowered;
+
+    // The hits are grouped by database; each group is ranked again on its own
+    // because a longer query can turn a substring match into a prefix match
+    size_t group_start = 0;
+    auto rank_group = [&]() {
+        std::sort(results.begin() + group_start, results.end(), hit_before);
+        group_start = results.size();
+    };
+
+    for (size_t i = 0; i < previous.size(); ++i) {
+        if (i % kCancelCheckInterval == 0 && is_cancelled(cancelled)) {
+            results.clear();
+            return results;
+        }
+
+        const SearchHit& candidate = previous[i];
+        if (i > 0 && candidate.package.repository != previous[i - 1].package.repository) {
+            rank_group();
+        }
+
+        lowered.assign(candidate.package.name);
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                       [](unsigned char c){ return std::tolower(c); });
+        if (lowered.find(needle) == std::string::npos) {
+            continue;
+        }
+        SearchHit hit{candidate.package, MatchKind::Substring, 0};
+        hit.score = name_score(lowered, needle, hit.match);
+        results.push_back(hit);
+    }
+    rank_group();
+
+    return results;
+}
+
+size_t SearchIndex::get_segment_count() const
+{
+    return (m_local ? 1 : 0) + m_sync.size();
+}
+
+const SearchSegment& SearchIndex::get_segment(size_t index) const
+{
+    if (m_local) {
+        return index == 0 ? *m_local : *m_sync[index - 1];
+    }
+    return *m_sync[index];
+}
+
+std::vector<SearchHit> SearchIndex::search_prefix(std::string_view prefix) const
+{
+    std::vector<SearchHit> results;
+    if (!m_catalog || prefix.empty()) {
+        return results;
+    }
+
+    const std::string needle = to_lower(prefix);
+
+    return collect_segments([&](const SearchSegment& segment, bool skip_installed, std::vector<SearchHit>& hits) {
+        std::vector<uint32_t> matches;
+        segment.find_prefix(needle, matches);
+
+        for (uint32_t index : matches) {
+            const RepositoryCatalog& repo = segment.get_repository();
+            if (skip_installed && m_catalog->is_installed(repo.name_at(index))) {
+                continue;
+            }
+            SearchHit hit{repo.at(index), MatchKind::Prefix, 0};
+            hit.score = name_score(segment.lower_name(index), needle, hit.match);
+            hits.push_back(hit);
+        }
+    }, nullptr);
+}
+
+std::vector<SearchHit> SearchIndex::search(std::string_view query, const SearchOptions& options) const
+{
+    std::vector<SearchHit> results;
+    if (!m_catalog || query.empty()) {
+        return results;
+    }
+
+    const std::string needle = to_lower(query);
+    std::vector<std::string> terms;
+    if (options.descriptions) {
+        for_each_word(needle, [&terms](std::string_view word) { terms.emplace_back(word); });
+    }
+
+    results = collect_segments([&](const SearchSegment& segment, bool skip_installed, std::vector<SearchHit>& hits) {
+        const RepositoryCatalog& repo = segment.get_repository();
+        std::vector<uint32_t> name_matches;
+        std::vector<std::pair<uint32_t, int>> word_matches;
+        segment.find_substring(needle, name_matches, options.cancelled);
+        if (!terms.empty() && !is_cancelled(options.cancelled)) {
+            segment.find_words(terms, word_matches);
+        }
+
+        // Both lists are in ascending package order, so merge them in one pass
+        auto n = name_matches.begin();
+        auto w = word_matches.begin();
+        while (n != name_matches.end() || w != word_matches.end()) {
+            uint32_t index;
+            int word_weight = 0;
+            bool name_hit = false;
+
+            if (w == word_matches.end() || (n != name_matches.end() && *n < w->first)) {
+                index = *n++;
+                name_hit = true;
+            } else if (n == name_matches.end() || w->first < *n) {
+                index = w->first;
+                word_weight = (w++)->second;
+            } else {
+                index = *n++;
+                word_weight = (w++)->second;
+                name_hit = true;
+            }
+
+            if (skip_installed && m_catalog->is_installed(repo.name_at(index))) {
+                continue;
+            }
+
+            SearchHit hit{repo.at(index), MatchKind::Description, word_weight * kWordWeightScore};
+            if (name_hit) {
+                hit.score += name_score(segment.lower_name(index), needle, hit.match);
+            }
+            hits.push_back(hit);
+        }
+    }, options.cancelled);
+
+    if (is_cancelled(options.cancelled)) {
+        results.clear();
+        return results;
+    }
+
+    // Stable so equal hits keep the installed-first, configuration order
+    std::stable_sort(results.begin(), results.end(), hit_before);
+    if (options.limit > 0 && options.limit < results.size()) {
+        results.resize(options.limit);
+    }
+
+    return results;
+}
+
+std::vector<SearchHit> SearchIndex::search_fuzzy(std::string_view query, const SearchOptions& options) const
+{
+    std::vector<SearchHit> results;
+    if (!m_catalog || query.empty()) {
+        return results;
+    }
+
+    FuzzyMatcher matcher(query);
+    matcher.set_typos_only(options.typos_only);
+
+    std::vector<const SearchSegment*> segments;
+    if (m_local) {
+        segments.push_back(m_local.get());
+    }
+    for (const auto& segment : m_sync) {
+        segments.push_back(segment.get());
+    }
+
+    // Each database keeps its own best hits, which are then merged
+    std::vector<std::vector<FuzzyMatch>> parts(segments.size());
+    ThreadPool::shared().parallel_for(segments.size(), [&](size_t i) {
+        const RepositoryCatalog& repo = segments[i]->get_repository();
+        bool skip_installed = segments[i] != m_local.get();
+        parts[i] = matcher.rank(repo.size(), [&](size_t index) -> std::pair<std::string_view, std::string_view> {
+            // Skipped packages get an empty name, which never matches
+            if (skip_installed && m_catalog->is_installed(repo.name_at(index))) {
+                return {};
+            }
+            PackageView package = repo.at(index);
+            return {package.name, options.descriptions ? package.description : std::string_view()};
+        }, options.limit, options.cancelled);
+    });
+
+    if (is_cancelled(options.cancelled)) {
+        return results;
+    }
+
+    std::vector<std::pair<size_t, FuzzyMatch>> merged;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        for (const FuzzyMatch& match : parts[i]) {
+            merged.emplace_back(i, match);
+        }
+    }
+    // Stable so equal hits keep the installed-first, configuration order
+    std::stable_sort(merged.begin(), merged.end(), [](const auto& a, const auto& b) {
+        if (a.second.score != b.second.score) {
+            return a.second.score > b.second.score;
+        }
+        return a.second.name_length < b.second.name_length;
+    });
+    if (options.limit > 0 && options.limit < merged.size()) {
+        merged.resize(options.limit);
+    }
+
+    results.reserve(merged.size());
+    for (const auto& [segment, match] : merged) {
+        MatchKind kind = MatchKind::Substring;
+        switch (match.kind) {
+            case FuzzyMatchKind::EXACT:       kind = MatchKind::Exact; break;
+            case FuzzyMatchKind::PREFIX:      kind = MatchKind::Prefix; break;
+            case FuzzyMatchKind::WORD:
+            case FuzzyMatchKind::SUBSTRING:   kind = MatchKind::Substring; break;
+            case FuzzyMatchKind::TYPO:        kind = MatchKind::Fuzzy; break;
+            case FuzzyMatchKind::DESCRIPTION: kind = MatchKind::Description; break;
+        }
+        results.push_back(SearchHit{segments[segment]->get_repository().at(match.index), kind, match.score});
+    }
+    return results;
+}
+
+void SearchIndex::find_names(const SearchSegment& segment, bool skip_installed, const std::string& needle,
+                             std::vector<SearchHit>& hits, const std::atomic<bool>* cancelled) const
+{
+    std::vector<uint32_t> matches;
+    segment.find_substring(needle, matches, cancelled);
+    if (is_cancelled(cancelled)) {
+        return;
+    }
+
+    const RepositoryCatalog& repo = segment.get_repository();
+    for (uint32_t index : matches) {
+        if (skip_installed && m_catalog->is_installed(repo.name_at(index))) {
+            continue;
+        }
+        SearchHit hit{repo.at(index), MatchKind::Substring, 0};
+        hit.score = name_score(segment.lower_name(index), needle, hit.match);
+        hits.push_back(hit);
+    }
+    std::sort(hits.begin(), hits.end(), hit_before);
+}
+
+std::vector<SearchHit> SearchIndex::collect_segments(const SegmentCollector& collect,
+                                                     const std::atomic<bool>* cancelled) const
+{
+    std::vector<const SearchSegment*> segments;
+    if (m_local) {
+        segments.push_back(m_local.get());
+    }
+    for (const auto& segment : m_sync) {
+        segments.push_back(segment.get());
+    }
+
+    // Each repository is searched on its own, then the hits are joined in
+    // segment order so the result does not depend on scheduling
+    std::vector<std::vector<SearchHit>> parts(segments.size());
+    ThreadPool::shared().parallel_for(segments.size(), [&](size_t i) {
+        if (!is_cancelled(cancelled)) {
+            collect(*segments[i], segments[i] != m_local.get(), parts[i]);
+        }
+    });
+
+    std::vector<SearchHit> results;
+    if (is_cancelled(cancelled)) {
+        return results;
+    }
+
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+
+    results.reserve(total);
+    for (const auto& part : parts) {
+        results.insert(results.end(), part.begin(), part.end());
+    }
+    return results;
+}
+
+// IncrementalSearch implementation
+
+std::vector<SearchHit> IncrementalSearch::search_names(const std::shared_ptr<const SearchIndex>& index,
+                                                       std::string_view query, const std::atomic<bool>* cancelled)
+{
+    return search_names(index, query, kAllSegments, cancelled);
+}
+
+std::vector<SearchHit> IncrementalSearch::search_names(const std::shared_ptr<const SearchIndex>& index,
+                                                       std::string_view query, size_t segment,
+                                                       const std::atomic<bool>* cancelled)
+{
+    std::vector<SearchHit> results;
+    if (!index || query.empty()) {
+        return results;
+    }
+
+    const std::string needle = to_lower(query);
+
+    // Narrow the last hits if the query only grew; anything else goes to the index
+    std::shared_ptr<const std::vector<SearchHit>> previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(segment);
+        if (it != m_entries.end() && it->second.index.lock() == index &&
+            needle.find(it->second.needle) != std::string::npos) {
+            previous = it->second.hits;
+        }
+    }
+
+    if (previous) {
+        results = index->refine_names(needle, *previous, cancelled);
+    } else if (segment == kAllSegments) {
+        results = index->search_names(needle, cancelled);
+    } else {
+        results = index->search_names(needle, segment, cancelled);
+    }
+
+    // A cancelled search is incomplete and must not be narrowed later
+    if (is_cancelled(cancelled)) {
+        results.clear();
+        return results;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (previous) {
+        m_narrowed++;
+    }
+    m_entries[segment] = Entry{index, needle, std::make_shared<const std::vector<SearchHit>>(results)};
+    return results;
+}
+
+void IncrementalSearch::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
+
+size_t IncrementalSearch::get_narrowed_searches() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_narrowed;
+}
+
+} // namespace core
+} // namespace pacmangui
@@ -0,0 +1,209 @@
+#include "core/search_pipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double milliseconds_since(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Moves the items of source that fall into [begin, end) of all results into a new vector,
+    // source holding the results from first on
+    template <typename T>
+    std::vector<T> take(std::vector<T>& source, size_t first, size_t begin, size_t end)
+    {
+        size_t from = std::max(begin, first);
+        size_t to = std::min(end, first + source.size());
+        if (from >= to) {
+            return std::vector<T>();
+        }
+        return std::vector<T>(std::make_move_iterator(source.begin() + (from - first)),
+                              std::make_move_iterator(source.begin() + (to - first)));
+    }
+}
+
+struct SearchPipeline::Query {
+    uint64_t id = 0;
+    std::string text;
+    std::atomic<bool> cancelled{false};
+    BatchCallback on_batch;
+    FinishedCallback on_finished;
+    Clock::time_point started;
+
+    std::mutex mutex;       // Guards the members below
+    size_t pending = 0;     // Stages still running
+    SearchStats stats;
+};
+
+SearchPipeline::SearchPipeline(size_t batch_size)
+    : m_batch_size(batch_size > 0 ? batch_size : kDefaultBatchSize)
+    , m_slow_pool(kSlowWorkers)
+    , m_next_id(1)
+    , m_running(0)
+{
+}
+
+SearchPipeline::~SearchPipeline()
+{
+    cancel();
+    wait();
+}
+
+size_t SearchPipeline::get_batch_size() const
+{
+    return m_batch_size;
+}
+
+uint64_t SearchPipeline::start(const std::string& query, std::vector<SearchStage> stages, BatchCallback on_batch,
+                               FinishedCallback on_finished)
+{
+    auto current = std::make_shared<Query>();
+    current->text = query;
+    current->on_batch = std::move(on_batch);
+    current->on_finished = std::move(on_finished);
+    current->started = Clock::now();
+    current->pending = stages.size();
+    current->stats.query = query;
+    current->stats.stages = stages.size();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_current) {
+            m_current->cancelled = true;
+        }
+        current->id = m_next_id++;
+        current->stats.query_id = current->id;
+        m_current = current;
+        m_running++;
+    }
+
+    if (stages.empty()) {
+        // Nothing to wait for, finish as if a stage had just completed
+        current->pending = 1;
+        finish_stage(current);
+        return current->id;
+    }
+
+    // Every stage starts at once; the local and sync ones take milliseconds,
+    // so they are not queued behind a network request
+    for (auto& stage : stages) {
+        bool slow = stage.slow;
+        auto task = [this, current, stage = std::move(stage)]() {
+            run_stage(current, stage);
+        };
+        if (slow) {
+            m_slow_pool.submit(std::move(task));
+        } else {
+            ThreadPool::shared().submit(std::move(task));
+        }
+    }
+    return current->id;
+}
+
+void SearchPipeline::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_current) {
+        m_current->cancelled = true;
+    }
+}
+
+void SearchPipeline::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_running == 0; });
+}
+
+uint64_t SearchPipeline::get_current_query() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_current ? m_current->id : 0;
+}
+
+SearchStats SearchPipeline::get_last_stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_stats;
+}
+
+void SearchPipeline::run_stage(const std::shared_ptr<Query>& query, const SearchStage& stage)
+{
+    SearchResults results;
+    if (!query->cancelled && stage.run) {
+        try {
+            results = stage.run(query->text, query->cancelled);
+        } catch (const std::exception& e) {
+            std::cerr << "SearchPipeline: Stage " << stage.name << " failed: " << e.what() << std::endl;
+        }
+    }
+
+    size_t views = results.views.size();
+    size_t native = views + results.packages.size();
+    size_t total = native + results.flatpak_packages.size();
+    for (size_t offset = 0; offset < total && !query->cancelled; offset += m_batch_size) {
+        SearchBatch batch;
+        batch.query_id = query->id;
+        batch.source = stage.source;
+        batch.stage = stage.name;
+        batch.views = take(results.views, 0, offset, offset + m_batch_size);
+        batch.packages = take(results.packages, views, offset, offset + m_batch_size);
+        batch.flatpak_packages = take(results.flatpak_packages, native, offset, offset + m_batch_size);
+        if (!batch.views.empty()) {
+            batch.catalog = results.catalog;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(query->mutex);
+            if (query->stats.first_result_ms < 0) {
+                query->stats.first_result_ms = milliseconds_since(query->started);
+            }
+            query->stats.results += batch.views.size() + batch.packages.size() + batch.flatpak_packages.size();
+        }
+        if (query->on_batch) {
+            query->on_batch(batch);
+        }
+    }
+
+    finish_stage(query);
+}
+
+void SearchPipeline::finish_stage(const std::shared_ptr<Query>& query)
+{
+    SearchStats stats;
+    {
+        std::lock_guard<std::mutex> lock(query->mutex);
+        if (--query->pending > 0) {
+            return;
+        }
+        query->stats.total_ms = milliseconds_since(query->started);
+        query->stats.cancelled = query->cancelled;
+        stats = query->stats;
+    }
+
+    if (!stats.cancelled) {
+        std::cout << "SearchPipeline: '" << stats.query << "' found " << stats.results << " packages from "
+                  << stats.stages << " sources, first after " << stats.first_result_ms << " ms, all after "
+                  << stats.total_ms << " ms" << std::endl;
+    }
+    if (query->on_finished) {
+        query->on_finished(stats);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!stats.cancelled) {
+        m_last_stats = stats;
+    }
+    if (--m_running == 0) {
+        m_idle.notify_all();
+    }
+}
+
+} // namespace core
+} // namespace pacmangui
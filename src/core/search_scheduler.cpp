@@ -0,0 +1,236 @@
+#include "core/search_scheduler.hpp"
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    // Weight of the latest duration in the moving average
+    constexpr double kAverageWeight = 0.3;
+
+    std::string to_lower(const std::string& text)
+    {
+        std::string lowered(text);
+        std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return lowered;
+    }
+}
+
+SearchToken::SearchToken()
+    : m_generation(0)
+    , m_cancelled(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+uint64_t SearchToken::get_generation() const
+{
+    return m_generation;
+}
+
+const std::string& SearchToken::get_query() const
+{
+    return m_query;
+}
+
+bool SearchToken::is_cancelled() const
+{
+    return *m_cancelled;
+}
+
+const std::atomic<bool>* SearchToken::get_flag() const
+{
+    return m_cancelled.get();
+}
+
+SearchScheduler::SearchScheduler(bool time_tasks)
+    : m_running(0)
+    , m_average_ms(-1)
+    , m_min_delay_ms(kMinDelayMs)
+    , m_max_delay_ms(kMaxDelayMs)
+    , m_time_tasks(time_tasks)
+    , m_stopping(false)
+    , m_timer(&SearchScheduler::run_timer, this)
+{
+}
+
+SearchScheduler::~SearchScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        *m_current.m_cancelled = true;
+        m_pending = nullptr;
+    }
+    m_wakeup.notify_all();
+    m_timer.join();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_running == 0; });
+}
+
+uint64_t SearchScheduler::schedule(const std::string& query, Task task)
+{
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        SearchToken token = next_token(query);
+        generation = token.m_generation;
+        m_pending = std::move(task);
+        m_deadline = Clock::now() + std::chrono::milliseconds(delay_locked(query));
+    }
+    m_wakeup.notify_all();
+    return generation;
+}
+
+uint64_t SearchScheduler::run_now(const std::string& query, Task task)
+{
+    SearchToken token;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        token = next_token(query);
+        m_pending = nullptr;
+        m_running++;
+    }
+    dispatch(token, std::move(task));
+    return token.m_generation;
+}
+
+void SearchScheduler::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *m_current.m_cancelled = true;
+    m_pending = nullptr;
+    if (m_running == 0) {
+        m_idle.notify_all();
+    }
+}
+
+void SearchScheduler::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return !m_pending && m_running == 0; });
+}
+
+bool SearchScheduler::is_current(uint64_t generation) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return generation == m_current.m_generation && !m_current.is_cancelled();
+}
+
+uint64_t SearchScheduler::get_generation() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_current.m_generation;
+}
+
+int SearchScheduler::get_delay_ms(const std::string& query) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return delay_locked(query);
+}
+
+void SearchScheduler::report_duration(double milliseconds)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_average_ms < 0) {
+        m_average_ms = milliseconds;
+    } else {
+        m_average_ms += kAverageWeight * (milliseconds - m_average_ms);
+    }
+}
+
+void SearchScheduler::set_delay_limits(int min_ms, int max_ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_min_delay_ms = std::max(0, min_ms);
+    m_max_delay_ms = std::max(m_min_delay_ms, max_ms);
+}
+
+bool SearchScheduler::extends(const std::string& query, const std::string& previous)
+{
+    if (previous.empty()) {
+        return false;
+    }
+    return to_lower(query).find(to_lower(previous)) != std::string::npos;
+}
+
+SearchToken SearchScheduler::next_token(const std::string& query)
+{
+    *m_current.m_cancelled = true;
+
+    SearchToken token;
+    token.m_generation = m_current.m_generation + 1;
+    token.m_query = query;
+    m_current = token;
+    return token;
+}
+
+void SearchScheduler::dispatch(const SearchToken& token, Task task)
+{
+    ThreadPool::shared().submit([this, token, task = std::move(task)]() {
+        if (!token.is_cancelled()) {
+            auto started = Clock::now();
+            try {
+                task(token);
+            } catch (const std::exception& e) {
+                std::cerr << "SearchScheduler: Search for '" << token.get_query() << "' failed: " << e.what()
+                          << std::endl;
+            }
+            // A cancelled search stopped early, its time says nothing about the next one
+            if (m_time_tasks && !token.is_cancelled()) {
+                report_duration(std::chrono::duration<double, std::milli>(Clock::now() - started).count());
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_running == 0 && !m_pending) {
+            m_idle.notify_all();
+        }
+    });
+}
+
+void SearchScheduler::run_timer()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        if (!m_pending) {
+            m_wakeup.wait(lock);
+            continue;
+        }
+        if (Clock::now() < m_deadline) {
+            // A newer query moves the deadline, so check again after waking up
+            m_wakeup.wait_until(lock, m_deadline);
+            continue;
+        }
+
+        Task task = std::move(m_pending);
+        m_pending = nullptr;
+        SearchToken token = m_current;
+        m_running++;
+        lock.unlock();
+        dispatch(token, std::move(task));
+        lock.lock();
+    }
+}
+
+int SearchScheduler::delay_locked(const std::string& query) const
+{
+    if (query.size() < kShortQuery) {
+        return m_max_delay_ms;
+    }
+    if (m_average_ms < 0) {
+        return m_min_delay_ms;
+    }
+
+    // Wait about twice as long as a search takes, so a search is only
+    // started once the next keystroke is unlikely to make it obsolete
+    int delay = static_cast<int>(2 * m_average_ms);
+    return std::clamp(delay, m_min_delay_ms, m_max_delay_ms);
+}
+
+} // namespace core
+} // namespace pacmangui
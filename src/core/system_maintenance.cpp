@@ -0,0 +1,245 @@
+#include "core/system_maintenance.hpp"
+#include <iostream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace pacmangui {
+namespace core {
+
+namespace {
+    bool ends_with(const std::string& text, const std::string& suffix)
+    {
+        return text.size() >= suffix.size() &&
+               text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::string dependency_string(const alpm_depend_t* depend)
+    {
+        char* text = alpm_dep_compute_string(depend);
+        std::string result = text ? text : "";
+        free(text);
+        return result;
+    }
+}
+
+bool parse_package_filename(const std::string& filename, std::string& name, std::string& version)
+{
+    std::string base = filename;
+    if (ends_with(base, ".sig")) {
+        base.erase(base.size() - 4);
+    }
+
+    size_t extension = base.rfind(".pkg.tar");
+    if (extension == std::string::npos) {
+        return false;
+    }
+    base.erase(extension);
+
+    // arch, pkgrel and pkgver never contain '-', the name may
+    size_t arch_dash = base.rfind('-');
+    if (arch_dash == std::string::npos || arch_dash == 0) {
+        return false;
+    }
+    size_t rel_dash = base.rfind('-', arch_dash - 1);
+    if (rel_dash == std::string::npos || rel_dash == 0) {
+        return false;
+    }
+    size_t ver_dash = base.rfind('-', rel_dash - 1);
+    if (ver_dash == std::string::npos || ver_dash == 0) {
+        return false;
+    }
+
+    name = base.substr(0, ver_dash);
+    version = base.substr(ver_dash + 1, arch_dash - ver_dash - 1);
+    return true;
+}
+
+SystemMaintenance::SystemMaintenance(alpm_handle_t* handle)
+    : m_handle(handle)
+    , m_freed_bytes(0)
+{
+}
+
+std::vector<std::string> SystemMaintenance::find_orphans() const
+{
+    std::vector<std::string> orphans;
+    if (!m_handle) {
+        return orphans;
+    }
+
+    alpm_db_t* localdb = alpm_get_localdb(m_handle);
+    for (alpm_list_t* i = alpm_db_get_pkgcache(localdb); i; i = alpm_list_next(i)) {
+        alpm_pkg_t* pkg = static_cast<alpm_pkg_t*>(i->data);
+        if (alpm_pkg_get_reason(pkg) != ALPM_PKG_REASON_DEPEND) {
+            continue;
+        }
+
+        alpm_list_t* required_by = alpm_pkg_compute_requiredby(pkg);
+        alpm_list_t* optional_for = alpm_pkg_compute_optionalfor(pkg);
+        if (!required_by && !optional_for) {
+            orphans.push_back(alpm_pkg_get_name(pkg));
+        }
+        FREELIST(required_by);
+        FREELIST(optional_for);
+    }
+
+    return orphans;
+}
+
+bool SystemMaintenance::clean_cache(bool clean_all, MaintenanceOutputCallback output_callback)
+{
+    m_last_error.clear();
+    m_freed_bytes = 0;
+    if (!m_handle) {
+        m_last_error = "ALPM handle not initialized";
+        return false;
+    }
+
+    alpm_db_t* localdb = alpm_get_localdb(m_handle);
+    bool success = true;
+
+    for (alpm_list_t* i = alpm_option_get_cachedirs(m_handle); i; i = alpm_list_next(i)) {
+        std::string dir = static_cast<const char*>(i->data);
+        if (!dir.empty() && dir.back() != '/') {
+            dir += '/';
+        }
+
+        DIR* stream = opendir(dir.c_str());
+        if (!stream) {
+            if (errno != ENOENT) {
+                m_last_error = "Failed to open " + dir + ": " + strerror(errno);
+                success = false;
+            }
+            continue;
+        }
+
+        size_t removed = 0;
+        uint64_t freed = 0;
+        while (dirent* entry = readdir(stream)) {
+            std::string filename = entry->d_name;
+            std::string path = dir + filename;
+
+            struct stat info;
+            if (lstat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+                continue;
+            }
+
+            std::string name;
+            std::string version;
+            bool is_package = parse_package_filename(filename, name, version);
+            bool remove = ends_with(filename, ".part");
+            if (is_package && !remove) {
+                alpm_pkg_t* installed = clean_all ? nullptr : alpm_db_get_pkg(localdb, name.c_str());
+                remove = !installed || version != alpm_pkg_get_version(installed);
+            }
+            if (!remove) {
+                continue;
+            }
+
+            if (unlink(path.c_str()) != 0) {
+                m_last_error = "Failed to remove " + path + ": " + strerror(errno);
+                std::cerr << "SystemMaintenance: " << m_last_error << std::endl;
+                success = false;
+                continue;
+            }
+            ++removed;
+            freed += static_cast<uint64_t>(info.st_size);
+        }
+        closedir(stream);
+
+        m_freed_bytes += freed;
+        std::cout << "SystemMaintenance: Removed " << removed << " files from " << dir << std::endl;
+        if (output_callback) {
+            output_callback("Removed " + std::to_string(removed) + " files (" +
+                            std::to_string(freed / (1024 * 1024)) + " MiB) from " + dir);
+        }
+    }
+
+    return success;
+}
+
+bool SystemMaintenance::check_database(bool check_sync, MaintenanceOutputCallback output_callback)
+{
+    m_last_error.clear();
+    if (!m_handle) {
+        m_last_error = "ALPM handle not initialized";
+        return false;
+    }
+
+    alpm_list_t* local_packages = alpm_db_get_pkgcache(alpm_get_localdb(m_handle));
+    size_t problems = check_packages(local_packages, "local", output_callback);
+
+    // Conflicts between installed packages are errors, among repository
+    // packages they are normal, so only the local database is checked for them
+    alpm_list_t* conflicts = alpm_checkconflicts(m_handle, local_packages);
+    for (alpm_list_t* i = conflicts; i; i = alpm_list_next(i)) {
+        alpm_conflict_t* conflict = static_cast<alpm_conflict_t*>(i->data);
+        std::string line = std::string("local: ") + alpm_pkg_get_name(conflict->package1) + " and " +
+                           alpm_pkg_get_name(conflict->package2) + " are in conflict";
+        if (output_callback) {
+            output_callback(line);
+        }
+        alpm_conflict_free(conflict);
+        ++problems;
+    }
+    alpm_list_free(conflicts);
+
+    if (check_sync) {
+        // Repositories may depend on each other, so check them as one set
+        alpm_list_t* sync_packages = nullptr;
+        for (alpm_list_t* i = alpm_get_syncdbs(m_handle); i; i = alpm_list_next(i)) {
+            alpm_db_t* db = static_cast<alpm_db_t*>(i->data);
+            for (alpm_list_t* j = alpm_db_get_pkgcache(db); j; j = alpm_list_next(j)) {
+                sync_packages = alpm_list_add(sync_packages, j->data);
+            }
+        }
+        problems += check_packages(sync_packages, "sync", output_callback);
+        alpm_list_free(sync_packages);
+    }
+
+    std::cout << "SystemMaintenance: Database check found " << problems << " problems" << std::endl;
+    if (problems > 0) {
+        m_last_error = "Database check found " + std::to_string(problems) + " problems";
+        return false;
+    }
+    if (output_callback) {
+        output_callback("No database errors have been found");
+    }
+    return true;
+}
+
+size_t SystemMaintenance::check_packages(alpm_list_t* packages, const std::string& label,
+                                         const MaintenanceOutputCallback& output_callback)
+{
+    size_t problems = 0;
+    alpm_list_t* missing = alpm_checkdeps(m_handle, packages, nullptr, packages, 0);
+    for (alpm_list_t* i = missing; i; i = alpm_list_next(i)) {
+        alpm_depmissing_t* dep = static_cast<alpm_depmissing_t*>(i->data);
+        std::string line = label + ": missing '" + dependency_string(dep->depend) +
+                           "' dependency for '" + dep->target + "'";
+        if (output_callback) {
+            output_callback(line);
+        }
+        alpm_depmissing_free(dep);
+        ++problems;
+    }
+    alpm_list_free(missing);
+    return problems;
+}
+
+uint64_t SystemMaintenance::get_freed_bytes() const
+{
+    return m_freed_bytes;
+}
+
+std::string SystemMaintenance::get_last_error() const
+{
+    return m_last_error;
+}
+
+} // namespace core
+} // namespace pacmangui
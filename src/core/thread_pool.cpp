@@ -0,0 +1,136 @@
+#include "core/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+
+namespace pacmangui {
+namespace core {
+
+ThreadPool::ThreadPool(size_t threads)
+    : m_stopping(false)
+{
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        m_workers.emplace_back([this]() { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wakeup.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    // PACMANGUI_THREADS caps the workers, e.g. to measure scaling
+    static ThreadPool pool([]() -> size_t {
+        const char* threads = getenv("PACMANGUI_THREADS");
+        return threads ? static_cast<size_t>(std::max(0L, strtol(threads, nullptr, 10))) : 0;
+    }());
+    return pool;
+}
+
+size_t ThreadPool::size() const
+{
+    return m_workers.size();
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& fn)
+{
+    if (count == 0) {
+        return;
+    }
+    if (count == 1) {
+        fn(0);
+        return;
+    }
+
+    // Helpers may only get to run after everything is done, so the state
+    // they touch is shared and they bail out once no index is left
+    struct State {
+        std::atomic<size_t> next{0};
+        size_t count = 0;
+        size_t finished = 0;
+        const std::function<void(size_t)>* fn = nullptr;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->fn = &fn;
+
+    auto work = [state]() {
+        size_t index;
+        while ((index = state->next++) < state->count) {
+            std::exception_ptr error;
+            try {
+                (*state->fn)(index);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (error && !state->error) {
+                state->error = error;
+            }
+            if (++state->finished == state->count) {
+                state->done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(count - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        enqueue(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->finished == state->count; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(task));
+    }
+    m_wakeup.notify_one();
+}
+
+void ThreadPool::run()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeup.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace core
+} // namespace pacmangui
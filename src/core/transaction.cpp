@@ -2,13 +2,71 @@
 #include "package.hpp"
 #include <iostream>
 #include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
 
 namespace pacmangui {
 namespace core {
 
+namespace {
+    const char* progress_operation(alpm_progress_t progress)
+    {
+        switch (progress) {
+            case ALPM_PROGRESS_ADD_START:        return "installing";
+            case ALPM_PROGRESS_UPGRADE_START:    return "upgrading";
+            case ALPM_PROGRESS_DOWNGRADE_START:  return "downgrading";
+            case ALPM_PROGRESS_REINSTALL_START:  return "reinstalling";
+            case ALPM_PROGRESS_REMOVE_START:     return "removing";
+            case ALPM_PROGRESS_CONFLICTS_START:  return "checking for file conflicts";
+            case ALPM_PROGRESS_DISKSPACE_START:  return "checking available disk space";
+            case ALPM_PROGRESS_INTEGRITY_START:  return "checking package integrity";
+            case ALPM_PROGRESS_LOAD_START:       return "loading package files";
+            case ALPM_PROGRESS_KEYRING_START:    return "checking keys in keyring";
+        }
+        return "processing";
+    }
+
+    std::string package_label(alpm_pkg_t* pkg)
+    {
+        if (!pkg) {
+            return "";
+        }
+        return std::string(alpm_pkg_get_name(pkg)) + " (" + alpm_pkg_get_version(pkg) + ")";
+    }
+
+    std::string dependency_string(const alpm_depend_t* dep)
+    {
+        char* text = alpm_dep_compute_string(dep);
+        std::string result = text ? text : "";
+        free(text);
+        return result;
+    }
+
+    std::string join_url(const std::string& server, const std::string& filename)
+    {
+        if (!server.empty() && server.back() == '/') {
+            return server + filename;
+        }
+        return server + "/" + filename;
+    }
+
+    bool is_cached(alpm_list_t* cachedirs, const std::string& filename)
+    {
+        for (alpm_list_t* i = cachedirs; i; i = alpm_list_next(i)) {
+            if (access(join_url(static_cast<const char*>(i->data), filename).c_str(), F_OK) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
 Transaction::Transaction(TransactionType type)
     : m_type(type)
     , m_state(TransactionState::IDLE)
+    , m_overwrite_files(false)
+    , m_refresh_databases(false)
+    , m_remove_dependencies(false)
     , m_trans(nullptr)
 {
 }
@@ -51,20 +109,119 @@ std::vector<std::string> Transaction::get_targets() const
     return m_targets;
 }
 
+void Transaction::set_dependency_targets(const std::vector<std::string>& targets)
+{
+    m_dependency_targets = targets;
+}
+
+bool Transaction::is_dependency_target(const std::string& target) const
+{
+    return std::find(m_dependency_targets.begin(), m_dependency_targets.end(), target) != m_dependency_targets.end();
+}
+
 std::vector<Package> Transaction::get_packages() const
 {
     std::vector<Package> packages;
-    
-    if (!m_trans) {
-        return packages;
-    }
-    
-    // For now, since we don't have proper ALPM functions available, return an empty list
-    // alpm_list_t* add_pkgs = alpm_trans_get_add(m_trans);
-    
+    packages.reserve(m_add_packages.size() + m_remove_packages.size());
+    packages.insert(packages.end(), m_add_packages.begin(), m_add_packages.end());
+    packages.insert(packages.end(), m_remove_packages.begin(), m_remove_packages.end());
     return packages;
 }
 
+const std::vector<Package>& Transaction::get_add_packages() const
+{
+    return m_add_packages;
+}
+
+const std::vector<Package>& Transaction::get_remove_packages() const
+{
+    return m_remove_packages;
+}
+
+void Transaction::set_resolved_packages(std::vector<Package> add, std::vector<Package> remove)
+{
+    m_add_packages = std::move(add);
+    m_remove_packages = std::move(remove);
+}
+
+void Transaction::set_overwrite_files(bool overwrite)
+{
+    m_overwrite_files = overwrite;
+}
+
+bool Transaction::get_overwrite_files() const
+{
+    return m_overwrite_files;
+}
+
+void Transaction::set_refresh_databases(bool refresh)
+{
+    m_refresh_databases = refresh;
+}
+
+bool Transaction::get_refresh_databases() const
+{
+    return m_refresh_databases;
+}
+
+void Transaction::set_remove_dependencies(bool recursive)
+{
+    m_remove_dependencies = recursive;
+}
+
+bool Transaction::get_remove_dependencies() const
+{
+    return m_remove_dependencies;
+}
+
+void Transaction::set_event_callback(TransactionEventCallback callback)
+{
+    m_event_callback = std::move(callback);
+}
+
+void Transaction::set_progress_callback(TransactionProgressCallback callback)
+{
+    m_progress_callback = std::move(callback);
+}
+
+void Transaction::set_download_callback(TransactionDownloadCallback callback)
+{
+    m_download_callback = std::move(callback);
+}
+
+void Transaction::notify_event(const std::string& message) const
+{
+    if (m_event_callback) {
+        m_event_callback(message);
+    }
+}
+
+void Transaction::notify_progress(const std::string& operation, const std::string& target,
+                                  int percent, size_t current, size_t total) const
+{
+    if (m_progress_callback) {
+        m_progress_callback(operation, target, percent, current, total);
+    }
+}
+
+void Transaction::notify_download(const DownloadProgress& progress) const
+{
+    if (m_download_callback) {
+        m_download_callback(progress);
+    }
+}
+
+std::string Transaction::get_last_error() const
+{
+    return m_last_error;
+}
+
+void Transaction::set_last_error(const std::string& error)
+{
+    m_last_error = error;
+    std::cerr << "Transaction: " << error << std::endl;
+}
+
 void Transaction::set_alpm_trans(void* trans)
 {
     m_trans = trans;
@@ -79,6 +236,7 @@ void* Transaction::get_alpm_trans() const
 
 TransactionManager::TransactionManager(alpm_handle_t* handle)
     : m_handle(handle)
+    , m_scheduler(nullptr)
 {
 }
 
@@ -97,29 +255,53 @@ bool TransactionManager::prepare_transaction(Transaction* transaction)
     if (!transaction || !m_handle) {
         return false;
     }
-    
+
+    transaction->set_state(TransactionState::PREPARING);
+
+    // pacman -Syu refreshes the databases before the transaction is created
+    if (transaction->get_type() == TransactionType::SYNC && transaction->get_refresh_databases()) {
+        if (!refresh_databases(transaction)) {
+            transaction->set_state(TransactionState::FAILED);
+            return false;
+        }
+    }
+
     // Initialize the transaction in ALPM
     if (!init_alpm_transaction(transaction)) {
+        transaction->set_state(TransactionState::FAILED);
         return false;
     }
-    
-    // Get transaction targets
-    const auto& targets = transaction->get_targets();
-    
-    // Currently, alpm_add_target is not directly accessible
-    // We'll need to create a proper implementation
-    
-    // For now, just print targets
-    for (const auto& target : targets) {
-        std::cout << "Would add target: " << target << std::endl;
-    }
-    
-    // Set state to PREPARING
-    transaction->set_state(TransactionState::PREPARING);
-    
-    // For now, just mark it as successful
-    transaction->set_state(TransactionState::COMMITTING);
-    
+
+    if (!add_targets(transaction)) {
+        release_transaction(transaction);
+        transaction->set_state(TransactionState::FAILED);
+        return false;
+    }
+
+    alpm_list_t* data = nullptr;
+    if (alpm_trans_prepare(m_handle, &data) != 0) {
+        alpm_errno_t err = alpm_errno(m_handle);
+        transaction->set_last_error("Failed to prepare transaction: " + describe_failure(err, data));
+        release_transaction(transaction);
+        transaction->set_state(TransactionState::FAILED);
+        return false;
+    }
+
+    // Record what ALPM resolved the targets to
+    std::vector<Package> add;
+    std::vector<Package> remove;
+    for (alpm_list_t* i = alpm_trans_get_add(m_handle); i; i = alpm_list_next(i)) {
+        add.push_back(Package::create_from_alpm(static_cast<alpm_pkg_t*>(i->data)));
+    }
+    for (alpm_list_t* i = alpm_trans_get_remove(m_handle); i; i = alpm_list_next(i)) {
+        remove.push_back(Package::create_from_alpm(static_cast<alpm_pkg_t*>(i->data)));
+    }
+
+    std::cout << "TransactionManager: Prepared transaction with " << add.size()
+              << " packages to add and " << remove.size() << " to remove" << std::endl;
+
+    transaction->set_resolved_packages(std::move(add), std::move(remove));
+
     return true;
 }
 
@@ -128,19 +310,53 @@ bool TransactionManager::commit_transaction(Transaction* transaction)
     if (!transaction || !m_handle) {
         return false;
     }
-    
-    // Set state to RUNNING
+
+    if (!transaction->get_alpm_trans() && !prepare_transaction(transaction)) {
+        return false;
+    }
+
+    // Nothing to do, e.g. a system upgrade on an up to date system
+    if (transaction->get_add_packages().empty() && transaction->get_remove_packages().empty()) {
+        transaction->notify_event("There is nothing to do");
+        release_transaction(transaction);
+        transaction->set_state(TransactionState::COMPLETED);
+        return true;
+    }
+
     transaction->set_state(TransactionState::COMMITTING);
-    
-    // For now, since we don't have full ALPM implementation
-    std::cout << "Would commit transaction with " << transaction->get_targets().size() << " targets" << std::endl;
-    
-    // Set state to COMPLETED
+
+    // Fill the cache in parallel, ALPM then finds every package already downloaded
+    if (!download_packages(transaction)) {
+        release_transaction(transaction);
+        transaction->set_state(TransactionState::FAILED);
+        return false;
+    }
+
+    alpm_list_t* data = nullptr;
+    if (alpm_trans_commit(m_handle, &data) != 0) {
+        alpm_errno_t err = alpm_errno(m_handle);
+        transaction->set_last_error("Failed to commit transaction: " + describe_failure(err, data));
+        release_transaction(transaction);
+        transaction->set_state(TransactionState::FAILED);
+        return false;
+    }
+
     transaction->set_state(TransactionState::COMPLETED);
-    
+
+    // ALPM records package files as explicitly installed unless told otherwise for the whole transaction
+    alpm_db_t* local_db = alpm_get_localdb(m_handle);
+    for (const auto& name : m_new_dependencies) {
+        alpm_pkg_t* pkg = alpm_db_get_pkg(local_db, name.c_str());
+        if (pkg && alpm_pkg_set_reason(pkg, ALPM_PKG_REASON_DEPEND) != 0) {
+            transaction->notify_event("Failed to mark " + name + " as a dependency: " +
+                                      alpm_strerror(alpm_errno(m_handle)));
+        }
+    }
+    m_new_dependencies.clear();
+
     // Release the transaction
     release_transaction(transaction);
-    
+
     return true;
 }
 
@@ -149,9 +365,24 @@ void TransactionManager::release_transaction(Transaction* transaction)
     if (!transaction || !m_handle) {
         return;
     }
-    
-    std::cout << "Releasing transaction" << std::endl;
-    
+
+    if (transaction->get_alpm_trans()) {
+        std::cout << "TransactionManager: Releasing transaction" << std::endl;
+        alpm_trans_release(m_handle);
+
+        // Callbacks point at the transaction, which may not outlive the handle
+        alpm_option_set_eventcb(m_handle, nullptr, nullptr);
+        alpm_option_set_progresscb(m_handle, nullptr, nullptr);
+        alpm_option_set_questioncb(m_handle, nullptr, nullptr);
+
+        // The handle may serve further transactions, e.g. in the helper daemon.
+        // Only the entry added for this transaction goes, the Overwrite globs
+        // from pacman.conf stay.
+        if (transaction->get_overwrite_files()) {
+            alpm_option_remove_overwrite_file(m_handle, "*");
+        }
+    }
+
     // Clear the transaction pointer
     transaction->set_alpm_trans(nullptr);
 }
@@ -159,15 +390,238 @@ void TransactionManager::release_transaction(Transaction* transaction)
 std::vector<Package> TransactionManager::resolve_dependencies(Transaction* transaction)
 {
     std::vector<Package> dependencies;
-    
+
     if (!transaction || !m_handle) {
         return dependencies;
     }
-    
-    // For now, since we don't have proper ALPM implementation, return empty list
-    std::cout << "Would resolve dependencies for transaction" << std::endl;
-    
-    return dependencies;
+
+    if (!transaction->get_alpm_trans() && !prepare_transaction(transaction)) {
+        return dependencies;
+    }
+
+    return transaction->get_add_packages();
+}
+
+bool TransactionManager::refresh_databases(Transaction* transaction, bool force)
+{
+    if (!transaction || !m_handle) {
+        return false;
+    }
+
+    transaction->notify_event("Synchronizing package databases...");
+
+    if (m_scheduler) {
+        m_scheduler->set_progress_callback([transaction](const DownloadProgress& progress) {
+            transaction->notify_download(progress);
+        });
+    }
+
+    alpm_list_t* dbs = alpm_get_syncdbs(m_handle);
+    int result = alpm_db_update(m_handle, dbs, force ? 1 : 0);
+
+    if (m_scheduler) {
+        m_scheduler->set_progress_callback(nullptr);
+    }
+
+    if (result < 0) {
+        transaction->set_last_error(std::string("Failed to synchronize databases: ") +
+                                    alpm_strerror(alpm_errno(m_handle)));
+        return false;
+    }
+
+    return true;
+}
+
+void TransactionManager::set_download_scheduler(DownloadScheduler* scheduler)
+{
+    m_scheduler = scheduler;
+    if (!m_handle) {
+        return;
+    }
+
+    if (!scheduler) {
+        alpm_option_set_fetchcb(m_handle, nullptr, nullptr);
+        return;
+    }
+
+    // The servers of one repository all carry the same files
+    scheduler->clear_server_groups();
+    for (alpm_list_t* i = alpm_get_syncdbs(m_handle); i; i = alpm_list_next(i)) {
+        std::vector<std::string> servers;
+        for (alpm_list_t* s = alpm_db_get_servers(static_cast<alpm_db_t*>(i->data)); s; s = alpm_list_next(s)) {
+            servers.push_back(static_cast<const char*>(s->data));
+        }
+        scheduler->add_server_group(servers);
+    }
+
+    alpm_option_set_fetchcb(m_handle, &DownloadScheduler::fetch_callback, scheduler);
+}
+
+bool TransactionManager::download_packages(Transaction* transaction)
+{
+    alpm_list_t* cachedirs = alpm_option_get_cachedirs(m_handle);
+    if (!m_scheduler || !cachedirs) {
+        return true;
+    }
+
+    // ALPM downloads into the first cache directory as well
+    std::string cache_dir = static_cast<const char*>(cachedirs->data);
+
+    std::vector<DownloadRequest> requests;
+    for (alpm_list_t* i = alpm_trans_get_add(m_handle); i; i = alpm_list_next(i)) {
+        auto* pkg = static_cast<alpm_pkg_t*>(i->data);
+        const char* filename = alpm_pkg_get_filename(pkg);
+        if (alpm_pkg_get_origin(pkg) != ALPM_PKG_FROM_SYNCDB || !filename || is_cached(cachedirs, filename)) {
+            continue;
+        }
+
+        DownloadRequest request;
+        request.filename = filename;
+        request.destination = cache_dir;
+        request.expected_size = static_cast<uint64_t>(alpm_pkg_get_size(pkg));
+        for (alpm_list_t* s = alpm_db_get_servers(alpm_pkg_get_db(pkg)); s; s = alpm_list_next(s)) {
+            request.urls.push_back(join_url(static_cast<const char*>(s->data), filename));
+        }
+
+        if (!request.urls.empty()) {
+            requests.push_back(std::move(request));
+        }
+    }
+
+    if (requests.empty()) {
+        return true;
+    }
+
+    transaction->notify_event("Retrieving " + std::to_string(requests.size()) + " packages...");
+
+    m_scheduler->set_progress_callback([transaction](const DownloadProgress& progress) {
+        transaction->notify_download(progress);
+    });
+    bool success = m_scheduler->download(requests);
+    m_scheduler->set_progress_callback(nullptr);
+
+    if (!success) {
+        transaction->set_last_error("Failed to retrieve packages: " + m_scheduler->get_last_error());
+    }
+
+    return success;
+}
+
+bool TransactionManager::add_targets(Transaction* transaction)
+{
+    alpm_list_t* sync_dbs = alpm_get_syncdbs(m_handle);
+    alpm_db_t* local_db = alpm_get_localdb(m_handle);
+    m_new_dependencies.clear();
+
+    if (transaction->get_type() == TransactionType::SYNC) {
+        transaction->notify_event("Starting full system upgrade...");
+        if (alpm_sync_sysupgrade(m_handle, 0) != 0) {
+            transaction->set_last_error(std::string("Failed to start system upgrade: ") +
+                                        alpm_strerror(alpm_errno(m_handle)));
+            return false;
+        }
+    }
+
+    for (const auto& target : transaction->get_targets()) {
+        if (transaction->get_type() == TransactionType::REMOVE) {
+            alpm_pkg_t* pkg = alpm_db_get_pkg(local_db, target.c_str());
+            if (!pkg) {
+                transaction->set_last_error("Target not found: " + target);
+                return false;
+            }
+            if (alpm_remove_pkg(m_handle, pkg) != 0 && alpm_errno(m_handle) != ALPM_ERR_TRANS_DUP_TARGET) {
+                transaction->set_last_error("Failed to remove " + target + ": " + alpm_strerror(alpm_errno(m_handle)));
+                return false;
+            }
+        } else if (transaction->get_type() == TransactionType::INSTALL_FILES) {
+            alpm_pkg_t* pkg = nullptr;
+            int siglevel = alpm_option_get_local_file_siglevel(m_handle);
+            if (alpm_pkg_load(m_handle, target.c_str(), 1, siglevel, &pkg) != 0 || !pkg) {
+                transaction->set_last_error("Failed to load " + target + ": " + alpm_strerror(alpm_errno(m_handle)));
+                return false;
+            }
+            std::string name = alpm_pkg_get_name(pkg);
+            if (alpm_add_pkg(m_handle, pkg) != 0) {
+                alpm_errno_t err = alpm_errno(m_handle);
+                alpm_pkg_free(pkg);
+                if (err == ALPM_ERR_TRANS_DUP_TARGET) {
+                    continue;
+                }
+                transaction->set_last_error("Failed to add " + target + ": " + alpm_strerror(err));
+                return false;
+            }
+            if (transaction->is_dependency_target(target) && !alpm_db_get_pkg(local_db, name.c_str())) {
+                m_new_dependencies.push_back(name);
+            }
+        } else {
+            // Accept provisions like pacman does, e.g. "sh" resolves to bash
+            alpm_pkg_t* pkg = alpm_find_dbs_satisfier(m_handle, sync_dbs, target.c_str());
+            if (!pkg) {
+                transaction->set_last_error("Target not found: " + target);
+                return false;
+            }
+            if (alpm_add_pkg(m_handle, pkg) != 0 && alpm_errno(m_handle) != ALPM_ERR_TRANS_DUP_TARGET) {
+                transaction->set_last_error("Failed to add " + target + ": " + alpm_strerror(alpm_errno(m_handle)));
+                return false;
+            }
+            if (transaction->is_dependency_target(target) && !alpm_db_get_pkg(local_db, alpm_pkg_get_name(pkg))) {
+                m_new_dependencies.push_back(alpm_pkg_get_name(pkg));
+            }
+        }
+    }
+
+    return true;
+}
+
+std::string TransactionManager::describe_failure(alpm_errno_t err, alpm_list_t* data)
+{
+    std::string message = alpm_strerror(err);
+
+    switch (err) {
+        case ALPM_ERR_UNSATISFIED_DEPS:
+            for (alpm_list_t* i = data; i; i = alpm_list_next(i)) {
+                auto* miss = static_cast<alpm_depmissing_t*>(i->data);
+                message += "\n  " + std::string(miss->target) + " requires " + dependency_string(miss->depend);
+                alpm_depmissing_free(miss);
+            }
+            break;
+
+        case ALPM_ERR_CONFLICTING_DEPS:
+            for (alpm_list_t* i = data; i; i = alpm_list_next(i)) {
+                auto* conflict = static_cast<alpm_conflict_t*>(i->data);
+                message += "\n  conflict: " + dependency_string(conflict->reason);
+                alpm_conflict_free(conflict);
+            }
+            break;
+
+        case ALPM_ERR_FILE_CONFLICTS:
+            for (alpm_list_t* i = data; i; i = alpm_list_next(i)) {
+                auto* conflict = static_cast<alpm_fileconflict_t*>(i->data);
+                message += "\n  " + std::string(conflict->file) + " exists in " + conflict->target;
+                if (conflict->ctarget && conflict->ctarget[0]) {
+                    message += " and " + std::string(conflict->ctarget);
+                } else {
+                    message += " and the filesystem";
+                }
+                alpm_fileconflict_free(conflict);
+            }
+            break;
+
+        case ALPM_ERR_PKG_INVALID:
+        case ALPM_ERR_PKG_INVALID_CHECKSUM:
+        case ALPM_ERR_PKG_INVALID_SIG:
+            for (alpm_list_t* i = data; i; i = alpm_list_next(i)) {
+                message += "\n  " + std::string(static_cast<char*>(i->data)) + " is invalid or corrupted";
+                free(i->data);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    alpm_list_free(data);
+    return message;
 }
 
 bool TransactionManager::init_alpm_transaction(Transaction* transaction)
@@ -175,48 +629,199 @@ bool TransactionManager::init_alpm_transaction(Transaction* transaction)
     if (!transaction || !m_handle) {
         return false;
     }
-    
+
     int flags = 0;
-    
+
     // Set flags based on transaction type
     switch (transaction->get_type()) {
         case TransactionType::INSTALL:
             std::cout << "Creating install transaction" << std::endl;
-            flags = ALPM_TRANS_FLAG_ALLDEPS;
+            flags = 0;
             break;
-            
+
         case TransactionType::REMOVE:
             std::cout << "Creating remove transaction" << std::endl;
-            flags = ALPM_TRANS_FLAG_RECURSE;
+            flags = transaction->get_remove_dependencies() ? ALPM_TRANS_FLAG_RECURSE : 0;
             break;
-            
+
         case TransactionType::UPDATE:
             std::cout << "Creating update transaction" << std::endl;
-            flags = ALPM_TRANS_FLAG_ALLDEPS;
+            flags = 0;
             break;
-            
+
         case TransactionType::SYNC:
             std::cout << "Creating sync transaction" << std::endl;
-            flags = ALPM_TRANS_FLAG_ALLDEPS;
+            flags = 0;
+            break;
+
+        case TransactionType::INSTALL_FILES:
+            std::cout << "Creating package file transaction" << std::endl;
+            flags = 0;
             break;
     }
-    
+
+    // Route ALPM's callbacks to this transaction for its lifetime
+    alpm_option_set_eventcb(m_handle, &TransactionManager::event_callback, transaction);
+    alpm_option_set_progresscb(m_handle, &TransactionManager::progress_callback, transaction);
+    alpm_option_set_questioncb(m_handle, &TransactionManager::question_callback, transaction);
+
     // Initialize the transaction
     alpm_errno_t err;
     int ret = alpm_trans_init(m_handle, flags);
-    
+
     if (ret != 0) {
         err = alpm_errno(m_handle);
-        std::cerr << "Failed to initialize transaction: " << alpm_strerror(err) << std::endl;
+        transaction->set_last_error(std::string("Failed to initialize transaction: ") + alpm_strerror(err));
+        alpm_option_set_eventcb(m_handle, nullptr, nullptr);
+        alpm_option_set_progresscb(m_handle, nullptr, nullptr);
+        alpm_option_set_questioncb(m_handle, nullptr, nullptr);
         return false;
     }
-    
-    // Store transaction context
-    // Since alpm_trans_get_ctx isn't available, we'll temporarily set a dummy value
-    transaction->set_alpm_trans(m_handle); // Using handle as a placeholder
-    
+
+    if (transaction->get_overwrite_files()) {
+        alpm_option_add_overwrite_file(m_handle, "*");
+    }
+
+    // ALPM keeps one transaction per handle, so the handle identifies it
+    transaction->set_alpm_trans(m_handle);
+
     return true;
 }
 
+void TransactionManager::event_callback(void* ctx, alpm_event_t* event)
+{
+    auto* transaction = static_cast<Transaction*>(ctx);
+    if (!transaction || !event) {
+        return;
+    }
+
+    switch (event->type) {
+        case ALPM_EVENT_CHECKDEPS_START:
+            transaction->notify_event("Checking dependencies...");
+            break;
+        case ALPM_EVENT_RESOLVEDEPS_START:
+            transaction->notify_event("Resolving dependencies...");
+            break;
+        case ALPM_EVENT_INTERCONFLICTS_START:
+            transaction->notify_event("Looking for conflicting packages...");
+            break;
+        case ALPM_EVENT_FILECONFLICTS_START:
+            transaction->notify_event("Checking for file conflicts...");
+            break;
+        case ALPM_EVENT_PKG_RETRIEVE_START:
+            transaction->notify_event("Retrieving packages...");
+            break;
+        case ALPM_EVENT_INTEGRITY_START:
+            transaction->notify_event("Checking package integrity...");
+            break;
+        case ALPM_EVENT_KEYRING_START:
+            transaction->notify_event("Checking keys in keyring...");
+            break;
+        case ALPM_EVENT_LOAD_START:
+            transaction->notify_event("Loading package files...");
+            break;
+        case ALPM_EVENT_DISKSPACE_START:
+            transaction->notify_event("Checking available disk space...");
+            break;
+        case ALPM_EVENT_TRANSACTION_START:
+            transaction->notify_event("Processing package changes...");
+            break;
+        case ALPM_EVENT_PACKAGE_OPERATION_DONE: {
+            const alpm_event_package_operation_t& op = event->package_operation;
+            switch (op.operation) {
+                case ALPM_PACKAGE_INSTALL:
+                    transaction->notify_event("Installed " + package_label(op.newpkg));
+                    break;
+                case ALPM_PACKAGE_UPGRADE:
+                    transaction->notify_event("Upgraded " + std::string(alpm_pkg_get_name(op.newpkg)) + " (" +
+                                              alpm_pkg_get_version(op.oldpkg) + " -> " +
+                                              alpm_pkg_get_version(op.newpkg) + ")");
+                    break;
+                case ALPM_PACKAGE_REINSTALL:
+                    transaction->notify_event("Reinstalled " + package_label(op.newpkg));
+                    break;
+                case ALPM_PACKAGE_DOWNGRADE:
+                    transaction->notify_event("Downgraded " + std::string(alpm_pkg_get_name(op.newpkg)) + " (" +
+                                              alpm_pkg_get_version(op.oldpkg) + " -> " +
+                                              alpm_pkg_get_version(op.newpkg) + ")");
+                    break;
+                case ALPM_PACKAGE_REMOVE:
+                    transaction->notify_event("Removed " + package_label(op.oldpkg));
+                    break;
+            }
+            break;
+        }
+        case ALPM_EVENT_SCRIPTLET_INFO:
+            if (event->scriptlet_info.line) {
+                std::string line = event->scriptlet_info.line;
+                if (!line.empty() && line.back() == '\n') {
+                    line.pop_back();
+                }
+                transaction->notify_event(line);
+            }
+            break;
+        case ALPM_EVENT_HOOK_START:
+            transaction->notify_event("Running hooks...");
+            break;
+        case ALPM_EVENT_HOOK_RUN_START: {
+            const alpm_event_hook_run_t& hook = event->hook_run;
+            transaction->notify_event("(" + std::to_string(hook.position) + "/" + std::to_string(hook.total) + ") " +
+                                      (hook.desc ? hook.desc : hook.name));
+            break;
+        }
+        case ALPM_EVENT_PACNEW_CREATED:
+            transaction->notify_event("Warning: " + std::string(event->pacnew_created.file) +
+                                      " installed as " + event->pacnew_created.file + ".pacnew");
+            break;
+        case ALPM_EVENT_PACSAVE_CREATED:
+            transaction->notify_event("Warning: " + std::string(event->pacsave_created.file) +
+                                      " saved as " + event->pacsave_created.file + ".pacsave");
+            break;
+        case ALPM_EVENT_DATABASE_MISSING:
+            transaction->notify_event("Warning: a sync database is missing, refresh the databases");
+            break;
+        default:
+            break;
+    }
+}
+
+void TransactionManager::progress_callback(void* ctx, alpm_progress_t progress, const char* pkg,
+                                           int percent, size_t howmany, size_t current)
+{
+    auto* transaction = static_cast<Transaction*>(ctx);
+    if (!transaction) {
+        return;
+    }
+
+    transaction->notify_progress(progress_operation(progress), pkg ? pkg : "", percent, current, howmany);
+}
+
+void TransactionManager::question_callback(void* ctx, alpm_question_t* question)
+{
+    auto* transaction = static_cast<Transaction*>(ctx);
+    if (!question) {
+        return;
+    }
+
+    // Nobody can be asked from inside a transaction, so give pacman's --noconfirm defaults
+    switch (question->type) {
+        case ALPM_QUESTION_REPLACE_PKG:
+        case ALPM_QUESTION_CORRUPTED_PKG:
+        case ALPM_QUESTION_IMPORT_KEY:
+            question->any.answer = 1;
+            break;
+        case ALPM_QUESTION_SELECT_PROVIDER:
+            question->select_provider.use_index = 0;
+            break;
+        default:
+            question->any.answer = 0;
+            break;
+    }
+
+    if (transaction && question->type == ALPM_QUESTION_CONFLICT_PKG) {
+        transaction->notify_event("Conflicting packages were found, the transaction cannot continue without removing them");
+    }
+}
+
 } // namespace core
-} // namespace pacmangui 
\ No newline at end of file
+} // namespace pacmangui
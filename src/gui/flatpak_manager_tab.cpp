@@ -39,13 +39,103 @@
 #include <QFutureWatcher>
 #include <QtConcurrent/QtConcurrent>
 #include <QCheckBox>
+#include <QLocale>
 #include "gui/flatpak_process_dialog.hpp"
+#include "core/directory_size.hpp"
 
 namespace pacmangui {
 namespace gui {
 
+namespace {
+    // Runs on a worker thread, so it only touches its arguments
+    FlatpakDetails loadFlatpakDetails(core::PackageManager* packageManager, const QString& appId,
+                                      std::shared_ptr<std::atomic<bool>> cancelled)
+    {
+        FlatpakDetails details;
+        details.appId = appId;
+        
+        // Only the selected application, not every installed ref
+        core::FlatpakPackage package;
+        package.set_app_id(appId.toStdString());
+        if (!packageManager->get_flatpak_app_info(package) || cancelled->load()) {
+            return details;
+        }
+        details.found = true;
+        details.package = package;
+        
+        // Get permissions, killing flatpak once the selection moves on
+        QProcess process;
+        process.start("flatpak", QStringList() << "info" << "--show-permissions" << appId);
+        while (!process.waitForFinished(50)) {
+            if (process.state() == QProcess::NotRunning) {
+                break;
+            }
+            if (cancelled->load()) {
+                process.kill();
+                process.waitForFinished();
+                return details;
+            }
+        }
+        QString output = process.readAllStandardOutput();
+        
+        // Parse and categorize permissions
+        QStringList lines = output.split('\n');
+        bool inPermissions = false;
+        for (const QString& line : lines) {
+            QString trimmed = line.trimmed();
+            if (trimmed.startsWith("Permissions:")) {
+                inPermissions = true;
+                continue;
+            }
+            if (inPermissions) {
+                if (trimmed.isEmpty()) {
+                    continue;
+                }
+                QString perm = trimmed;
+                if (perm.contains("filesystem=") || perm.contains("home") || perm.contains("host") || 
+                    perm.contains("xdg-") || perm.contains("~/"))
+                    details.filesystemPerms << "• " + perm;
+                else if (perm.contains("device=") || perm.contains("dri") || perm.contains("audio") || 
+                         perm.contains("video") || perm.contains("usb"))
+                    details.devicePerms << "• " + perm;
+                else if (perm.contains("socket=") || perm.contains("network") || perm.contains("wayland") || 
+                         perm.contains("x11") || perm.contains("pulseaudio"))
+                    details.socketPerms << "• " + perm;
+                else if (perm.contains("session") || perm.contains("feature") || perm.contains("system-") || 
+                         perm.contains("dbus"))
+                    details.featurePerms << "• " + perm;
+                else
+                    details.otherPerms << "• " + perm;
+            }
+        }
+        return details;
+    }
+    
+    // Runs on a worker thread; the walk itself is spread over the shared pool
+    UserDataSize measureUserData(const QString& appId, const QString& path,
+                                 std::shared_ptr<std::atomic<bool>> cancelled)
+    {
+        UserDataSize result;
+        result.appId = appId;
+        result.path = path;
+        
+        core::DirectorySizeWalker walker;
+        core::DirectoryUsage usage;
+        if (walker.measure(path.toStdString(), usage, cancelled.get())) {
+            result.size = QLocale().formattedDataSize(static_cast<qint64>(usage.bytes));
+        } else if (!cancelled->load()) {
+            qDebug() << "measureUserData -" << QString::fromStdString(walker.get_last_error());
+        }
+        return result;
+    }
+}
+
 FlatpakManagerTab::FlatpakManagerTab(QWidget* parent, core::PackageManager* packageManager)
     : QWidget(parent)
+    , m_detailsWatcher(new QFutureWatcher<FlatpakDetails>(this))
+    , m_userDataWatcher(new QFutureWatcher<UserDataSize>(this))
+    , m_remotesWatcher(new QFutureWatcher<std::vector<std::string>>(this))
+    , m_requestCancelled(std::make_shared<std::atomic<bool>>(false))
     , m_packageManager(packageManager)
 {
     qDebug() << "FlatpakManagerTab::constructor - start";
@@ -63,7 +153,11 @@ FlatpakManagerTab::FlatpakManagerTab(QWidget* parent, core::PackageManager* pack
 
 FlatpakManagerTab::~FlatpakManagerTab()
 {
-    // Clean up any resources if needed
+    // Stop the workers before the watchers go away
+    cancelPendingRequests();
+    m_detailsWatcher->waitForFinished();
+    m_userDataWatcher->waitForFinished();
+    m_remotesWatcher->waitForFinished();
 }
 
 void FlatpakManagerTab::setupUi()
@@ -471,14 +565,22 @@ void FlatpakManagerTab::connectSignals()
     connect(m_removeDataButton, &QPushButton::clicked, this, &FlatpakManagerTab::onRemoveUserData);
     connect(m_createSnapshotButton, &QPushButton::clicked, this, &FlatpakManagerTab::onCreateSnapshot);
     connect(m_restoreSnapshotButton, &QPushButton::clicked, this, &FlatpakManagerTab::onRestoreSnapshot);
+    
+    connect(m_detailsWatcher, &QFutureWatcher<FlatpakDetails>::finished,
+            this, &FlatpakManagerTab::onDetailsLoaded);
+    connect(m_userDataWatcher, &QFutureWatcher<UserDataSize>::finished,
+            this, &FlatpakManagerTab::onUserDataMeasured);
+    connect(m_remotesWatcher, &QFutureWatcher<std::vector<std::string>>::finished,
+            this, &FlatpakManagerTab::onRemotesLoaded);
     qDebug() << "FlatpakManagerTab::connectSignals - end";
 }
 
 void FlatpakManagerTab::refreshFlatpakList()
 {
     qDebug() << "FlatpakManagerTab::refreshFlatpakList - start";
-    // Clear existing data
+    // Clear existing data, installs and removals change the details too
     m_listModel->clear();
+    m_detailsCache.clear();
     m_listModel->setHorizontalHeaderLabels(
         QStringList() << tr("Name") << tr("Application ID") << tr("Version") << tr("Origin"));
     
@@ -518,19 +620,23 @@ void FlatpakManagerTab::refreshFlatpakList()
 void FlatpakManagerTab::refreshFlatpakRemotes()
 {
     qDebug() << "FlatpakManagerTab::refreshFlatpakRemotes - start";
-    // Run flatpak remotes command
-    QProcess process;
-    process.start("flatpak", QStringList() << "remotes");
-    process.waitForFinished();
-    
-    QString output = process.readAllStandardOutput();
-    QStringList lines = output.split('\n', Qt::SkipEmptyParts);
+    if (m_remotesWatcher->isRunning()) {
+        return;
+    }
     
-    // Update status
-    emit statusMessage(tr("Found %1 Flatpak remotes").arg(lines.size()), 3000);
+    core::PackageManager* packageManager = m_packageManager;
+    m_remotesWatcher->setFuture(QtConcurrent::run([packageManager]() {
+        return packageManager->get_flatpak_remotes();
+    }));
     qDebug() << "FlatpakManagerTab::refreshFlatpakRemotes - end";
 }
 
+void FlatpakManagerTab::onRemotesLoaded()
+{
+    // Update status
+    emit statusMessage(tr("Found %1 Flatpak remotes").arg(m_remotesWatcher->result().size()), 3000);
+}
+
 // Implementation of filterFlatpakList
 void FlatpakManagerTab::filterFlatpakList(const QString& filter) {
     // Apply filter to the flatpak list view
@@ -574,6 +680,7 @@ void FlatpakManagerTab::onFlatpakSelected(const QModelIndex& current, const QMod
     Q_UNUSED(previous);
     if (!current.isValid()) {
         qDebug() << "onFlatpakSelected - current index is not valid";
+        cancelPendingRequests();
         if (m_nameLabel) m_nameLabel->clear();
         if (m_versionLabel) m_versionLabel->clear();
         if (m_branchLabel) m_branchLabel->clear();
@@ -647,6 +754,7 @@ void FlatpakManagerTab::onRemoveUserData() {
         QMessageBox::Yes | QMessageBox::No);
     if (reply != QMessageBox::Yes) return;
     QDir dir(dataPath);
+    m_userDataCache.remove(appId);
     if (dir.removeRecursively()) {
         QMessageBox::information(this, tr("Remove Data"), tr("User data for %1 has been deleted.").arg(appId));
     } else {
@@ -684,6 +792,7 @@ void FlatpakManagerTab::onRestoreSnapshot() {
     QDir().mkpath(dataPath);
     // Copy contents of snapshot to data directory
     int result = QProcess::execute("cp", QStringList() << "-r" << backupDir + "/." << dataPath + "/");
+    m_userDataCache.remove(appId);
     if (result == 0) {
         QMessageBox::information(this, tr("Restore Snapshot"), tr("Snapshot restored from %1").arg(backupDir));
     } else {
@@ -717,19 +826,45 @@ void FlatpakManagerTab::updateFlatpakDetails(const QString& appId)
         qDebug() << "updateFlatpakDetails - appId is empty, returning";
         return;
     }
-    // Get package details
-    auto packages = m_packageManager->get_installed_flatpak_packages();
-    qDebug() << "updateFlatpakDetails - got" << packages.size() << "installed packages";
-    auto it = std::find_if(packages.begin(), packages.end(),
-        [&appId](const auto& pkg) {
-            return QString::fromStdString(pkg.get_app_id()) == appId;
-        });
-    if (it == packages.end()) {
-        qDebug() << "updateFlatpakDetails - package not found for appId:" << appId;
+    
+    // Whatever is still loading belongs to the previous selection
+    cancelPendingRequests();
+    m_requestedAppId = appId;
+    
+    if (FlatpakDetails* cached = m_detailsCache.object(appId)) {
+        showFlatpakDetails(*cached);
+    } else {
+        core::PackageManager* packageManager = m_packageManager;
+        std::shared_ptr<std::atomic<bool>> cancelled = m_requestCancelled;
+        m_detailsWatcher->setFuture(QtConcurrent::run([packageManager, appId, cancelled]() {
+            return loadFlatpakDetails(packageManager, appId, cancelled);
+        }));
+    }
+    
+    // Update user data info
+    updateUserDataInfo(appId);
+    qDebug() << "updateFlatpakDetails - end for appId:" << appId;
+}
+
+void FlatpakManagerTab::onDetailsLoaded()
+{
+    FlatpakDetails details = m_detailsWatcher->result();
+    
+    // Cancelled requests come back incomplete, do not keep them
+    if (details.appId != m_requestedAppId) {
         return;
     }
-    const auto& package = *it;
-    qDebug() << "updateFlatpakDetails - found package, updating labels";
+    m_detailsCache.insert(details.appId, new FlatpakDetails(details));
+    showFlatpakDetails(details);
+}
+
+void FlatpakManagerTab::showFlatpakDetails(const FlatpakDetails& details)
+{
+    if (!details.found) {
+        qDebug() << "showFlatpakDetails - package not found for appId:" << details.appId;
+        return;
+    }
+    const auto& package = details.package;
     // Update labels with package information
     m_nameLabel->setText(QString::fromStdString(package.get_name()));
     m_versionLabel->setText(QString::fromStdString(package.get_version()));
@@ -751,79 +886,33 @@ void FlatpakManagerTab::updateFlatpakDetails(const QString& appId)
     m_featurePermsWidget->setVisible(false);
     m_socketPermsWidget->setVisible(false);
     m_otherPermsWidget->setVisible(false);
-    // Get permissions
-    QProcess process;
-    process.start("flatpak", QStringList() << "info" << "--show-permissions" << appId);
-    process.waitForFinished();
-    QString output = process.readAllStandardOutput();
-    qDebug() << "Flatpak permissions output:" << output;
-    // Parse and categorize permissions
-    QStringList lines = output.split('\n');
-    QStringList filesystemPerms, devicePerms, featurePerms, socketPerms, otherPerms;
-    bool inPermissions = false;
-    for (const QString& line : lines) {
-        QString trimmed = line.trimmed();
-        qDebug() << "Processing line:" << trimmed;
-        if (trimmed.startsWith("Permissions:")) {
-            inPermissions = true;
-            continue;
-        }
-        if (inPermissions) {
-            if (trimmed.isEmpty()) {
-                continue;
-            }
-            QString perm = trimmed;
-            qDebug() << "Found permission:" << perm;
-            if (perm.contains("filesystem=") || perm.contains("home") || perm.contains("host") || 
-                perm.contains("xdg-") || perm.contains("~/"))
-                filesystemPerms << "• " + perm;
-            else if (perm.contains("device=") || perm.contains("dri") || perm.contains("audio") || 
-                     perm.contains("video") || perm.contains("usb"))
-                devicePerms << "• " + perm;
-            else if (perm.contains("socket=") || perm.contains("network") || perm.contains("wayland") || 
-                     perm.contains("x11") || perm.contains("pulseaudio"))
-                socketPerms << "• " + perm;
-            else if (perm.contains("session") || perm.contains("feature") || perm.contains("system-") || 
-                     perm.contains("dbus"))
-                featurePerms << "• " + perm;
-            else
-                otherPerms << "• " + perm;
-        }
-    }
     // If no permissions found, show a message
-    if (filesystemPerms.isEmpty() && devicePerms.isEmpty() && 
-        featurePerms.isEmpty() && socketPerms.isEmpty() && otherPerms.isEmpty()) {
+    if (details.filesystemPerms.isEmpty() && details.devicePerms.isEmpty() && 
+        details.featurePerms.isEmpty() && details.socketPerms.isEmpty() && details.otherPerms.isEmpty()) {
         m_filesystemPermsWidget->setVisible(true);
         m_filesystemPermsText->setText(tr("No special permissions required"));
-        m_devicePermsWidget->setVisible(false);
-        m_featurePermsWidget->setVisible(false);
-        m_socketPermsWidget->setVisible(false);
-        m_otherPermsWidget->setVisible(false);
     } else {
-        if (!filesystemPerms.isEmpty()) {
+        if (!details.filesystemPerms.isEmpty()) {
             m_filesystemPermsWidget->setVisible(true);
-            m_filesystemPermsText->setText(filesystemPerms.join('\n'));
+            m_filesystemPermsText->setText(details.filesystemPerms.join('\n'));
         }
-        if (!devicePerms.isEmpty()) {
+        if (!details.devicePerms.isEmpty()) {
             m_devicePermsWidget->setVisible(true);
-            m_devicePermsText->setText(devicePerms.join('\n'));
+            m_devicePermsText->setText(details.devicePerms.join('\n'));
         }
-        if (!featurePerms.isEmpty()) {
+        if (!details.featurePerms.isEmpty()) {
             m_featurePermsWidget->setVisible(true);
-            m_featurePermsText->setText(featurePerms.join('\n'));
+            m_featurePermsText->setText(details.featurePerms.join('\n'));
         }
-        if (!socketPerms.isEmpty()) {
+        if (!details.socketPerms.isEmpty()) {
             m_socketPermsWidget->setVisible(true);
-            m_socketPermsText->setText(socketPerms.join('\n'));
+            m_socketPermsText->setText(details.socketPerms.join('\n'));
         }
-        if (!otherPerms.isEmpty()) {
+        if (!details.otherPerms.isEmpty()) {
             m_otherPermsWidget->setVisible(true);
-            m_otherPermsText->setText(otherPerms.join('\n'));
+            m_otherPermsText->setText(details.otherPerms.join('\n'));
         }
     }
-    // Update user data info
-    updateUserDataInfo(appId);
-    qDebug() << "updateFlatpakDetails - end for appId:" << appId;
 }
 
 void FlatpakManagerTab::updateUserDataInfo(const QString& appId)
@@ -831,29 +920,53 @@ void FlatpakManagerTab::updateUserDataInfo(const QString& appId)
     qDebug() << "updateUserDataInfo - start for appId:" << appId;
     QString dataPath = getDataPath(appId);
     qDebug() << "updateUserDataInfo - dataPath:" << dataPath;
-    QString dataSize = calculateDirSize(dataPath);
-    qDebug() << "updateUserDataInfo - dataSize:" << dataSize;
-    // Update status
-    emit statusMessage(tr("User data size: %1").arg(dataSize), 3000);
+    if (dataPath == tr("Unknown")) {
+        UserDataSize size;
+        size.appId = appId;
+        showUserDataSize(size);
+        return;
+    }
+    
+    // Cached sizes are kept while the data stays where it was
+    UserDataSize* cached = m_userDataCache.object(appId);
+    if (cached && cached->path == dataPath) {
+        showUserDataSize(*cached);
+        return;
+    }
+    
+    std::shared_ptr<std::atomic<bool>> cancelled = m_requestCancelled;
+    m_userDataWatcher->setFuture(QtConcurrent::run([appId, dataPath, cancelled]() {
+        return measureUserData(appId, dataPath, cancelled);
+    }));
     qDebug() << "updateUserDataInfo - end for appId:" << appId;
 }
 
-QString FlatpakManagerTab::calculateDirSize(const QString& path) {
-    if (path.isEmpty() || !QDir(path).exists()) {
-        return tr("Unknown");
+void FlatpakManagerTab::onUserDataMeasured()
+{
+    UserDataSize size = m_userDataWatcher->result();
+    if (size.appId != m_requestedAppId) {
+        return;
     }
-
-    QProcess process;
-    process.start("du", QStringList() << "-sh" << path);
-    process.waitForFinished();
-
-    if (process.exitCode() == 0) {
-        QString output = process.readAllStandardOutput();
-        // du output format is: "size    path"
-        return output.split('\t').first().trimmed();
+    if (!size.size.isEmpty()) {
+        m_userDataCache.insert(size.appId, new UserDataSize(size));
     }
+    showUserDataSize(size);
+}
 
-    return tr("Unknown");
+void FlatpakManagerTab::showUserDataSize(const UserDataSize& size)
+{
+    QString dataSize = size.size.isEmpty() ? tr("Unknown") : size.size;
+    qDebug() << "showUserDataSize - dataSize:" << dataSize;
+    // Update status
+    emit statusMessage(tr("User data size: %1").arg(dataSize), 3000);
+}
+
+void FlatpakManagerTab::cancelPendingRequests()
+{
+    // Workers hold on to the old flag, new requests get a fresh one
+    m_requestCancelled->store(true);
+    m_requestCancelled = std::make_shared<std::atomic<bool>>(false);
+    m_requestedAppId.clear();
 }
 
 QString FlatpakManagerTab::getDataPath(const QString& appId) {
@@ -951,46 +1064,6 @@ void FlatpakManagerTab::applySearchFilters(const QString& searchTerm) {
     performAsyncSearch(searchTerm);
 }
 
-void FlatpakManagerTab::clearSearchCache() {
-    m_searchCache.clear();
-}
-
-void FlatpakManagerTab::addToSearchCache(const QString& searchTerm, const std::vector<pacmangui::core::FlatpakPackage>& results) {
-    // Remove old entries
-    QDateTime now = QDateTime::currentDateTime();
-    m_searchCache.erase(
-        std::remove_if(m_searchCache.begin(), m_searchCache.end(),
-            [now](const SearchCacheEntry& entry) {
-                return entry.timestamp.msecsTo(now) > CACHE_TIMEOUT_MS;
-            }
-        ),
-        m_searchCache.end()
-    );
-
-    // Add new entry
-    SearchCacheEntry entry;
-    entry.searchTerm = searchTerm;
-    entry.results = results;
-    entry.timestamp = now;
-    m_searchCache.prepend(entry);
-
-    // Limit cache size
-    if (m_searchCache.size() > MAX_CACHE_SIZE) {
-        m_searchCache.removeLast();
-    }
-}
-
-bool FlatpakManagerTab::getFromSearchCache(const QString& searchTerm, std::vector<pacmangui::core::FlatpakPackage>& results) {
-    QDateTime now = QDateTime::currentDateTime();
-    for (auto it = m_searchCache.begin(); it != m_searchCache.end(); ++it) {
-        if (it->searchTerm == searchTerm && it->timestamp.msecsTo(now) <= CACHE_TIMEOUT_MS) {
-            results = it->results;
-            return true;
-        }
-    }
-    return false;
-}
-
 void FlatpakManagerTab::filterResults(std::vector<pacmangui::core::FlatpakPackage>& results) {
     results.erase(
         std::remove_if(results.begin(), results.end(),
@@ -1025,17 +1098,6 @@ void FlatpakManagerTab::performAsyncSearch(const QString& searchTerm) {
     // Show searching status
     emit statusMessage(tr("Searching for Flatpak packages matching '%1'...").arg(searchTerm), 0);
     
-    // Check cache first
-    std::vector<pacmangui::core::FlatpakPackage> cachedResults;
-    if (getFromSearchCache(searchTerm, cachedResults)) {
-        // Apply filters to cached results
-        filterResults(cachedResults);
-        
-        // Update UI with filtered results
-        updateSearchResults(cachedResults);
-        return;
-    }
-    
     // Create a new watcher if needed
     if (!m_searchWatcher) {
         m_searchWatcher = new QFutureWatcher<std::vector<pacmangui::core::FlatpakPackage>>(this);
@@ -1043,7 +1105,7 @@ void FlatpakManagerTab::performAsyncSearch(const QString& searchTerm) {
                 this, &FlatpakManagerTab::onSearchCompleted);
     }
     
-    // Start the async search
+    // Start the async search, served from the local appstream index
     auto future = QtConcurrent::run([this, searchTerm]() {
         return m_packageManager->search_flatpak_by_name(searchTerm.toStdString());
     });
@@ -1054,9 +1116,6 @@ void FlatpakManagerTab::performAsyncSearch(const QString& searchTerm) {
 void FlatpakManagerTab::onSearchCompleted() {
     auto results = m_searchWatcher->result();
     
-    // Cache the results
-    addToSearchCache(m_searchInput->text(), results);
-    
     // Apply filters
     filterResults(results);
     
@@ -0,0 +1,71 @@
+#include "gui/flatpak_transaction_job.hpp"
+
+#include <QtConcurrent/QtConcurrent>
+
+namespace pacmangui {
+namespace gui {
+
+FlatpakTransactionJob::FlatpakTransactionJob(core::PackageManager* packageManager, core::FlatpakOperation operation,
+                                             const QStringList& appIds, const QString& remote, QObject* parent)
+    : QObject(parent),
+      m_packageManager(packageManager),
+      m_operation(operation),
+      m_remote(remote.toStdString()),
+      m_watcher(new QFutureWatcher<bool>(this))
+{
+    for (const QString& appId : appIds) {
+        m_appIds.push_back(appId.toStdString());
+    }
+
+    connect(m_watcher, &QFutureWatcher<bool>::finished, this, [this]() {
+        emit finished(m_watcher->result(), m_error);
+    });
+}
+
+void FlatpakTransactionJob::start()
+{
+    if (isRunning()) {
+        return;
+    }
+    m_error.clear();
+
+    m_watcher->setFuture(QtConcurrent::run([this]() {
+        // Emitted on the worker thread, receivers in the GUI thread get them queued
+        auto callback = [this](const core::FlatpakRefProgress& progress) {
+            emit refProgress(QString::fromStdString(progress.ref), static_cast<int>(progress.state),
+                             progress.percent, QString::fromStdString(progress.message), progress.requested);
+        };
+
+        bool success = false;
+        switch (m_operation) {
+        case core::FlatpakOperation::INSTALL:
+            success = m_packageManager->install_flatpak_packages(m_appIds, m_remote, callback);
+            break;
+        case core::FlatpakOperation::REMOVE:
+            success = m_packageManager->remove_flatpak_packages(m_appIds, callback);
+            break;
+        case core::FlatpakOperation::UPDATE:
+            success = m_packageManager->update_flatpak_packages(m_appIds, callback);
+            break;
+        }
+        if (!success) {
+            m_error = QString::fromStdString(m_packageManager->get_last_error());
+        }
+        return success;
+    }));
+}
+
+void FlatpakTransactionJob::cancel()
+{
+    if (isRunning()) {
+        m_packageManager->cancel_flatpak_transactions();
+    }
+}
+
+bool FlatpakTransactionJob::isRunning() const
+{
+    return m_watcher->isRunning();
+}
+
+} // namespace gui
+} // namespace pacmangui
@@ -7,6 +7,7 @@
 #include "wayland/wayland_optimization.hpp"
 #include "gui/install_progress_dialog.hpp"
 #include "gui/password_prompt_dialog.hpp"
+#include "gui/flatpak_transaction_job.hpp"
 
 #include <QMenuBar>
 #include <QStatusBar>
@@ -42,6 +43,7 @@
 #include <QSpacerItem>
 #include <QCheckBox>
 #include <QSortFilterProxyModel>
+#include <QLocale>
 
 #include <iostream>
 #include <functional>
@@ -60,13 +62,16 @@ MainWindow::MainWindow(QWidget* parent)
     m_installedModel(nullptr),
     m_systemUpdatesModel(nullptr),
     m_updatesModel(nullptr),
-    m_searchWatcher(nullptr),
+    m_searchQueryId(0),
+    m_searchScheduler(false),
     m_updateButton(nullptr),
     m_installAurButton(nullptr),
     m_updateInstalledButton(nullptr),
     m_flatpakModel(nullptr),
     m_installedFlatpakModel(nullptr),
     m_flatpakSearchWatcher(nullptr),
+    m_flatpakJob(nullptr),
+    m_aurUpdatesWatcher(nullptr),
     m_flatpakSearchCheckbox(nullptr),
     m_removeFlatpakButton(nullptr),
     m_flatpakSearchEnabled(false)
@@ -74,31 +79,32 @@ MainWindow::MainWindow(QWidget* parent)
     setWindowTitle(tr("PacmanGUI"));
     setMinimumSize(800, 600);
 
-    // Initialize package manager
-    m_packageManager.initialize("/", "/var/lib/pacman");
+    // Initialize package manager; the databases load in the background so
+    // the window appears right away and fills in as the catalogs arrive
+    m_packageManager.initialize("/", "/var/lib/pacman", [this](bool complete) {
+        QMetaObject::invokeMethod(this, [this, complete]() {
+            refreshInstalledPackages();
+            if (complete) {
+                statusBar()->showMessage(tr("Package databases loaded"), 3000);
+            }
+        }, Qt::QueuedConnection);
+    });
 
     // Initialize models before we use them
     // Add a checkbox column at the beginning for multi-selection
-    m_packagesModel = new QStandardItemModel(0, 5, this);
-    m_packagesModel->setHorizontalHeaderLabels(
-        QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
-        
-    m_installedModel = new QStandardItemModel(0, 5, this);
-    m_installedModel->setHorizontalHeaderLabels(
-        QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
+    const QList<PackageTableModel::Column> packageColumns = {
+        PackageTableModel::CHECK_COLUMN, PackageTableModel::NAME_COLUMN, PackageTableModel::VERSION_COLUMN,
+        PackageTableModel::REPOSITORY_COLUMN, PackageTableModel::DESCRIPTION_COLUMN};
+    m_packagesModel = new PackageTableModel(packageColumns, this);
+    m_installedModel = new PackageTableModel(packageColumns, this);
         
     m_updatesModel = new QStandardItemModel(0, 5, this);
     m_updatesModel->setHorizontalHeaderLabels(
         QStringList() << tr("") << tr("Name") << tr("Current Version") << tr("New Version") << tr("Repository"));
         
     // Initialize Flatpak models
-    m_flatpakModel = new QStandardItemModel(0, 5, this);
-    m_flatpakModel->setHorizontalHeaderLabels(
-        QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
-        
-    m_installedFlatpakModel = new QStandardItemModel(0, 5, this);
-    m_installedFlatpakModel->setHorizontalHeaderLabels(
-        QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
+    m_flatpakModel = new PackageTableModel(packageColumns, this);
+    m_installedFlatpakModel = new PackageTableModel(packageColumns, this);
     
     // Set up UI components in the correct order
     setupUi();
@@ -126,7 +132,7 @@ MainWindow::MainWindow(QWidget* parent)
     loadSettings();
     applyTheme(isDarkThemeEnabled());
 
-    // Populate tables - enable these to load actual data
+    // Populate tables - the installed list fills in once the local database is loaded
     refreshInstalledPackages();
     // Don't search packages on startup - let user initiate search
     // searchPackages(""); // Start with empty search to show all packages
@@ -136,6 +142,9 @@ MainWindow::MainWindow(QWidget* parent)
 
     // Check for AUR helper
     checkAurHelper();
+    
+    // Cheap when the AUR dump did not change since the last run
+    refreshAurIndex();
 
     // Show welcome message
     showStatusMessage(tr("Welcome to PacmanGUI"));
@@ -153,15 +162,10 @@ MainWindow::~MainWindow()
         m_slideAnimation = nullptr;
     }
     
-    // Clean up async search resources
-    if (m_searchWatcher) {
-        if (m_searchWatcher->isRunning()) {
-            m_searchWatcher->cancel();
-            m_searchWatcher->waitForFinished();
-        }
-        delete m_searchWatcher;
-        m_searchWatcher = nullptr;
-    }
+    // Clean up async search resources, search callbacks post to this window
+    m_searchScheduler.cancel();
+    m_searchScheduler.wait();
+    m_packageManager.cancel_search(true);
     
     delete m_packagesModel;
     delete m_installedModel;
@@ -179,6 +183,11 @@ MainWindow::~MainWindow()
         m_flatpakSearchWatcher = nullptr;
     }
     
+    // The AUR check uses the package manager, let it finish first
+    if (m_aurUpdatesWatcher) {
+        m_aurUpdatesWatcher->waitForFinished();
+    }
+    
     delete m_flatpakModel;
     delete m_installedFlatpakModel;
 }
@@ -533,10 +542,10 @@ void MainWindow::setupConnections() {
     
     // Connect search signals
     qDebug() << "DEBUG: Connecting search signals";
-    // Remove the automatic search on text change which causes UI freezing
-    // connect(m_searchInput, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
+    // Searches while typing are debounced and cancel each other, so they no longer freeze the UI
+    connect(m_searchInput, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
     
-    // Only search when button is clicked or Enter is pressed
+    // Button and Enter search at once
     connect(m_searchInput, &QLineEdit::returnPressed, this, &MainWindow::onSearchClicked);
     connect(m_searchButton, &QPushButton::clicked, this, &MainWindow::onSearchClicked);
     
@@ -980,23 +989,17 @@ void MainWindow::showStatusMessage(const QString& message, int timeout) {
 // Add implementation for refreshInstalledPackages
 void MainWindow::refreshInstalledPackages() {
     qDebug() << "Refreshing installed packages";
-    m_installedModel->clear();
-    m_installedModel->setHorizontalHeaderLabels(QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
-    std::vector<pacmangui::core::Package> installedPackages = m_packageManager.get_installed_packages();
-    qDebug() << "Loaded" << installedPackages.size() << "installed packages from backend.";
-    for (const auto& pkg : installedPackages) {
-        QList<QStandardItem*> row;
-        QStandardItem* checkItem = new QStandardItem();
-        checkItem->setCheckable(true);
-        checkItem->setCheckState(Qt::Unchecked);
-        checkItem->setData(Qt::AlignCenter, Qt::TextAlignmentRole);
-        QStandardItem* nameItem = new QStandardItem(QString::fromStdString(pkg.get_name()));
-        QStandardItem* versionItem = new QStandardItem(QString::fromStdString(pkg.get_version()));
-        QStandardItem* repoItem = new QStandardItem(QString::fromStdString(pkg.get_repository()));
-        QStandardItem* descItem = new QStandardItem(QString::fromStdString(pkg.get_description()));
-        row << checkItem << nameItem << versionItem << repoItem << descItem;
-        m_installedModel->appendRow(row);
-    }
+    // The model shows the catalog views as they are; cell text is only built for visible rows
+    std::shared_ptr<const pacmangui::core::PackageCatalog> catalog = m_packageManager.get_catalog();
+    const pacmangui::core::RepositoryCatalog* localDb = catalog ? catalog->get_local() : nullptr;
+    size_t installedCount = localDb ? localDb->size() : 0;
+    qDebug() << "Loaded" << installedCount << "installed packages from backend.";
+    std::vector<pacmangui::core::PackageView> installed;
+    installed.reserve(installedCount);
+    for (size_t i = 0; i < installedCount; ++i) {
+        installed.push_back(localDb->at(i));
+    }
+    m_installedModel->setCatalogPackages(catalog, std::move(installed));
 
     // Set column widths after populating data
     m_installedTable->setColumnWidth(0, 30);  // Checkbox column
@@ -1005,7 +1008,7 @@ void MainWindow::refreshInstalledPackages() {
     m_installedTable->setColumnWidth(3, 100);  // Repository column
     m_installedTable->header()->setSectionResizeMode(4, QHeaderView::Stretch);  // Description column takes remaining space
 
-    showStatusMessage(tr("Loaded %1 installed packages").arg(installedPackages.size()), 3000);
+    showStatusMessage(tr("Loaded %1 installed packages").arg(installedCount), 3000);
 }
 
 // Add implementation for searchPackages
@@ -1020,76 +1023,66 @@ void MainWindow::performAsyncSearch(const QString& searchTerm) {
     
     // Initialize model
     m_packagesModel->clear();
-    m_packagesModel->setHorizontalHeaderLabels(QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
     
     if (searchTerm.isEmpty()) {
+        m_packageManager.cancel_search();
         showStatusMessage(tr("Please enter a search term"), 3000);
         return;
     }
     
     showStatusMessage(tr("Searching for packages matching '%1'...").arg(searchTerm), 0);
     
-    QFuture<std::vector<pacmangui::core::Package>> future = QtConcurrent::run(
-        [this, searchTerm]() {
-            return m_packageManager.search_by_name(searchTerm.toStdString());
-        }
-    );
+    // Each source reports as soon as it is done, so local results do not wait for the AUR.
+    // Batches are queued to the GUI thread; those of an older search are dropped there.
+    bool includeFlatpak = m_flatpakSearchEnabled && m_packageManager.is_flatpak_available();
+    m_searchQueryId = m_packageManager.search_streaming(searchTerm.toStdString(), includeFlatpak,
+        [this](const pacmangui::core::SearchBatch& batch) {
+            QMetaObject::invokeMethod(this, [this, batch]() {
+                if (batch.query_id == m_searchQueryId) {
+                    appendSearchBatch(batch);
+                }
+            }, Qt::QueuedConnection);
+        },
+        [this](const pacmangui::core::SearchStats& stats) {
+            QMetaObject::invokeMethod(this, [this, stats]() {
+                if (stats.query_id != m_searchQueryId || stats.cancelled) {
+                    return;
+                }
+                
+                // Lets the debounce delay follow how long searches really take
+                m_searchScheduler.report_duration(stats.total_ms);
+                
+                QString query = QString::fromStdString(stats.query);
+                if (stats.first_result_ms >= 0) {
+                    showStatusMessage(tr("Found %1 packages matching '%2' (first results after %3 ms, all after %4 ms)")
+                                      .arg(stats.results).arg(query)
+                                      .arg(qRound(stats.first_result_ms)).arg(qRound(stats.total_ms)), 5000);
+                } else {
+                    showStatusMessage(tr("No packages found matching '%1'").arg(query), 3000);
+                }
+            }, Qt::QueuedConnection);
+        });
+}
+
+void MainWindow::appendSearchBatch(const pacmangui::core::SearchBatch& batch) {
+    bool first = m_packagesModel->rowCount() == 0;
     
-    QFutureWatcher<std::vector<pacmangui::core::Package>>* watcher = new QFutureWatcher<std::vector<pacmangui::core::Package>>();
+    // One insertion per batch; database rows point into the catalog the batch pinned,
+    // the rest at strings the model keeps
+    m_packagesModel->appendCatalogPackages(batch.catalog, batch.views);
+    m_packagesModel->appendPackages(batch.packages);
+    m_packagesModel->appendFlatpakPackages(batch.flatpak_packages, "Flatpak");
     
-    connect(watcher, &QFutureWatcher<std::vector<pacmangui::core::Package>>::finished, this, [this, watcher, searchTerm]() {
-        std::vector<pacmangui::core::Package> results = watcher->result();
-        
-        // Add packages to model
-        for (const auto& pkg : results) {
-            QList<QStandardItem*> row;
-            
-            // Add checkbox item
-            QStandardItem* checkItem = new QStandardItem();
-            checkItem->setCheckable(true);
-            checkItem->setCheckState(Qt::Unchecked);
-            checkItem->setData(Qt::AlignCenter, Qt::TextAlignmentRole);
-            
-            QStandardItem* nameItem = new QStandardItem(QString::fromStdString(pkg.get_name()));
-            QStandardItem* versionItem = new QStandardItem(QString::fromStdString(pkg.get_version()));
-            
-            // Get repository name
-            QString repo = QString::fromStdString(pkg.get_repository());
-            
-            // Handle repository display
-            if (repo.toLower() == "aur") {
-                // Mark AUR packages
-                checkItem->setData("aur", Qt::UserRole + 1);
-                nameItem->setData("aur", Qt::UserRole + 1);
-                repo = "AUR";
-            } else if (repo.toLower().contains("cachyos")) {
-                // Handle CachyOS repositories
-                repo = repo.toUpper(); // Convert to uppercase for consistency
-            } else if (repo.toLower() == "chaotic-aur") {
-                // Handle Chaotic AUR
-                repo = "Chaotic-AUR";
-            }
-            
-            QStandardItem* repoItem = new QStandardItem(repo);
-            QStandardItem* descItem = new QStandardItem(QString::fromStdString(pkg.get_description()));
-            
-            row << checkItem << nameItem << versionItem << repoItem << descItem;
-            m_packagesModel->appendRow(row);
-        }
-        
-        // Set column widths after populating data
+    if (first) {
+        // Set column widths once the first rows are in
         m_packagesTable->setColumnWidth(0, 30);  // Checkbox column
         m_packagesTable->header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);  // Name column resize to content
         m_packagesTable->setColumnWidth(2, 100);  // Version column
         m_packagesTable->setColumnWidth(3, 120);  // Repository column - slightly wider for readability
         m_packagesTable->header()->setSectionResizeMode(4, QHeaderView::Stretch);  // Description column takes remaining space
-        
-        showStatusMessage(tr("Found %1 packages matching '%2'").arg(results.size()).arg(searchTerm), 3000);
-        
-        watcher->deleteLater();
-    });
+    }
     
-    watcher->setFuture(future);
+    showStatusMessage(tr("Found %1 packages so far, searching...").arg(m_packagesModel->rowCount()), 0);
 }
 
 // Add implementation for checkAurHelper
@@ -1118,6 +1111,27 @@ void MainWindow::checkAurHelper() {
     showStatusMessage(tr("No AUR helper found. AUR functions will be disabled."), 5000);
 }
 
+void MainWindow::refreshAurIndex() {
+    QSettings settings("PacmanGUI", "PacmanGUI");
+    if (!settings.value("aur/enabled", false).toBool() || !settings.value("aur/local_index", false).toBool()) {
+        return;
+    }
+    
+    // The worker hands back the error, empty on success
+    QFutureWatcher<QString>* watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher]() {
+        QString error = watcher->result();
+        if (!error.isEmpty()) {
+            showStatusMessage(tr("Could not update the local AUR index: %1").arg(error), 5000);
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run([this]() {
+        std::string error;
+        return m_packageManager.refresh_aur_index(error) ? QString() : QString::fromStdString(error);
+    }));
+}
+
 // Add implementation for onTabChanged
 void MainWindow::onTabChanged(int index) {
     Q_UNUSED(index);
@@ -1126,21 +1140,22 @@ void MainWindow::onTabChanged(int index) {
 
 // Add implementation for onSearchTextChanged
 void MainWindow::onSearchTextChanged(const QString& text) {
-    // Auto-search after a short delay
+    // Auto-search once typing pauses; the delay grows with how long searches take
     if (text.length() >= 2) {
-        // Don't immediately search on each keystroke, let the user finish typing
-        // We can add a timer for debouncing if needed
-        performAsyncSearch(text);
-        
-        // If Flatpak search is enabled, also search for Flatpak packages
-        if (m_flatpakSearchEnabled && m_packageManager.is_flatpak_available()) {
-            performAsyncFlatpakSearch(text);
-        }
+        // Flatpak remotes are searched as part of it when enabled
+        m_searchScheduler.schedule(text.toStdString(), [this, text](const pacmangui::core::SearchToken& token) {
+            QMetaObject::invokeMethod(this, [this, text, generation = token.get_generation()]() {
+                // A keystroke or click since then has superseded this search
+                if (m_searchScheduler.is_current(generation)) {
+                    performAsyncSearch(text);
+                }
+            }, Qt::QueuedConnection);
+        });
     } else if (text.isEmpty()) {
         // Clear the search results
+        m_searchScheduler.cancel();
+        m_packageManager.cancel_search();
         m_packagesModel->clear();
-        m_packagesModel->setHorizontalHeaderLabels(
-            QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
     }
 }
 
@@ -1154,22 +1169,16 @@ void MainWindow::onSearchClicked()
             }
             
     // Clear the model
-    m_packagesModel->removeRows(0, m_packagesModel->rowCount());
+    m_packagesModel->clear();
     
     // Update status bar
     showStatusMessage(tr("Searching for packages matching '%1'...").arg(text), 0);
     
-    // Perform the search
+    // Perform the search, including Flatpak remotes if Flatpak search is enabled.
+    // A search still waiting for typing to pause would only repeat this one.
+    m_searchScheduler.cancel();
     qDebug() << "Performing async search for:" << text;
     performAsyncSearch(text);
-    
-    // If Flatpak support is enabled, also search for Flatpak packages
-    if (m_packageManager.is_flatpak_available() && m_flatpakSearchEnabled) {
-        qDebug() << "Flatpak search is enabled, searching for Flatpak packages";
-        performAsyncFlatpakSearch(text);
-    } else {
-        qDebug() << "Flatpak search is disabled or not available";
-    }
 }
 
 // Add implementation for onInstallPackage
@@ -1318,7 +1327,7 @@ void MainWindow::onRemovePackage() {
     QStringList flatpakPackages;
     QStringList packageDetails;
     
-    QStandardItemModel* model = m_tabWidget->currentIndex() == 0 ? m_packagesModel : m_installedModel;
+    PackageTableModel* model = m_tabWidget->currentIndex() == 0 ? m_packagesModel : m_installedModel;
     
     for (const QModelIndex& index : selected) {
         QModelIndex nameIndex = model->index(index.row(), 1); // Name column
@@ -1576,7 +1585,8 @@ void MainWindow::onCheckForUpdates() {
     if (m_systemUpdatesModel) {
         m_systemUpdatesModel->clear();
         m_systemUpdatesModel->setHorizontalHeaderLabels(
-            QStringList() << tr("Name") << tr("Current Version") << tr("New Version") << tr("Repository"));
+            QStringList() << tr("Name") << tr("Current Version") << tr("New Version") << tr("Repository")
+                          << tr("Download Size"));
     }
     
     // Find available terminal emulator
@@ -1603,60 +1613,81 @@ void MainWindow::onCheckForUpdates() {
 // New method to check for updates after sync has completed
 void MainWindow::checkForUpdatesAfterSync() {
     try {
-        std::vector<std::pair<std::string, std::string>> updates = m_packageManager.check_updates();
-        
-        // Add updates to the model
-        for (const auto& update : updates) {
-            QList<QStandardItem*> row;
-            
-            // Get package details to find the repository and current version
-            QString pkgName = QString::fromStdString(update.first);
-            QString newVersion = QString::fromStdString(update.second);
-            
-            // Try to get the current version from installed packages
-            QString currentVersion = "Unknown";
-            QString repoName = "Unknown";
-            
-            // Find the package in the installed packages model
-            for (int i = 0; i < m_installedModel->rowCount(); ++i) {
-                QString name = m_installedModel->item(i, 1)->text(); // Name column (was incorrectly 0)
-                if (name == pkgName) {
-                    currentVersion = m_installedModel->item(i, 2)->text(); // Version column (was incorrectly 1)
-                    repoName = m_installedModel->item(i, 3)->text(); // Repository column
-                    break;
-                }
-            }
-            
-            QStandardItem* nameItem = new QStandardItem(pkgName);
-            QStandardItem* currentVersionItem = new QStandardItem(currentVersion);
-            QStandardItem* newVersionItem = new QStandardItem(newVersion);
-            QStandardItem* repoItem = new QStandardItem(repoName);
-            
-            row << nameItem << currentVersionItem << newVersionItem << repoItem;
-            m_systemUpdatesModel->appendRow(row);
-        }
-        
-        // Update status bar and info label
-        if (updates.empty()) {
-            m_systemUpdateInfoLabel->setText(tr("Your system is up to date."));
-            showStatusMessage(tr("Your system is up to date"), 5000);
-            m_systemUpdateLogView->append(tr("No updates available."));
-    } else {
-            m_systemUpdateInfoLabel->setText(tr("Found %1 updates available.").arg(updates.size()));
-            showStatusMessage(tr("Found %1 updates").arg(updates.size()), 5000);
-            m_systemUpdateLogView->append(tr("Found %1 updates available.").arg(updates.size()));
-        }
-        
-        // Auto-size columns
-        for (int i = 0; i < m_systemUpdatesTable->model()->columnCount(); ++i) {
-            m_systemUpdatesTable->resizeColumnToContents(i);
-        }
+        std::vector<pacmangui::core::PackageUpdate> updates = m_packageManager.check_updates();
+        appendSystemUpdates(updates);
+        showSystemUpdateCount();
         
     } catch (const std::exception& e) {
         // Handle any exceptions
         m_systemUpdateInfoLabel->setText(tr("Error checking for updates."));
         showStatusMessage(tr("Error checking for updates: %1").arg(e.what()), 5000);
         m_systemUpdateLogView->append(tr("Error: %1").arg(e.what()));
+        return;
+    }
+    
+    // Foreign packages with a newer version on the AUR, empty if AUR support
+    // is off. The lookup goes over the network, so it runs on a worker and
+    // its results are added to the list once they arrive.
+    if (!m_aurUpdatesWatcher) {
+        m_aurUpdatesWatcher = new QFutureWatcher<std::vector<pacmangui::core::PackageUpdate>>(this);
+        connect(m_aurUpdatesWatcher, &QFutureWatcher<std::vector<pacmangui::core::PackageUpdate>>::finished,
+                this, &MainWindow::onAurUpdatesChecked);
+    }
+    if (m_aurUpdatesWatcher->isRunning()) {
+        return;
+    }
+    
+    // The foreign packages come from the ALPM handle, which stays on this thread
+    std::vector<std::pair<std::string, std::string>> foreign = m_packageManager.get_foreign_packages();
+    m_aurUpdatesWatcher->setFuture(QtConcurrent::run([this, foreign]() {
+        return m_packageManager.check_aur_updates(foreign);
+    }));
+}
+
+void MainWindow::onAurUpdatesChecked() {
+    std::vector<pacmangui::core::PackageUpdate> aurUpdates = m_aurUpdatesWatcher->result();
+    if (aurUpdates.empty()) {
+        return;
+    }
+    
+    appendSystemUpdates(aurUpdates);
+    showSystemUpdateCount();
+}
+
+void MainWindow::appendSystemUpdates(const std::vector<pacmangui::core::PackageUpdate>& updates) {
+    // Add updates to the model
+    for (const auto& update : updates) {
+        QList<QStandardItem*> row;
+        
+        QStandardItem* nameItem = new QStandardItem(QString::fromStdString(update.name));
+        QStandardItem* currentVersionItem = new QStandardItem(QString::fromStdString(update.old_version));
+        QStandardItem* newVersionItem = new QStandardItem(QString::fromStdString(update.new_version));
+        QStandardItem* repoItem = new QStandardItem(QString::fromStdString(update.repository));
+        // AUR packages are built locally, there is no download size
+        QStandardItem* sizeItem = new QStandardItem(update.repository == "aur" ? QString() :
+            QLocale().formattedDataSize(static_cast<qint64>(update.download_size)));
+        
+        row << nameItem << currentVersionItem << newVersionItem << repoItem << sizeItem;
+        m_systemUpdatesModel->appendRow(row);
+    }
+    
+    // Auto-size columns
+    for (int i = 0; i < m_systemUpdatesTable->model()->columnCount(); ++i) {
+        m_systemUpdatesTable->resizeColumnToContents(i);
+    }
+}
+
+void MainWindow::showSystemUpdateCount() {
+    // Update status bar and info label
+    int count = m_systemUpdatesModel->rowCount();
+    if (count == 0) {
+        m_systemUpdateInfoLabel->setText(tr("Your system is up to date."));
+        showStatusMessage(tr("Your system is up to date"), 5000);
+        m_systemUpdateLogView->append(tr("No updates available."));
+    } else {
+        m_systemUpdateInfoLabel->setText(tr("Found %1 updates available.").arg(count));
+        showStatusMessage(tr("Found %1 updates").arg(count), 5000);
+        m_systemUpdateLogView->append(tr("Found %1 updates available.").arg(count));
     }
 }
 
@@ -1965,6 +1996,7 @@ void MainWindow::openSettings() {
             // If AUR is enabled, check if we have a helper
             if (enabled) {
                 checkAurHelper();
+                refreshAurIndex();
                 } else {
                 // If disabled, disable AUR button
                 if (m_installAurButton) {
@@ -1973,6 +2005,13 @@ void MainWindow::openSettings() {
             }
         });
         
+        // Build the local AUR index as soon as it is switched on
+        connect(m_settingsDialog, &SettingsDialog::aurLocalIndexChanged, [this](bool enabled) {
+            if (enabled) {
+                refreshAurIndex();
+            }
+        });
+        
         // Connect Flatpak status changed signal
         connect(m_settingsDialog, &SettingsDialog::flatpakStatusChanged, [this](bool enabled) {
             // Update Flatpak search enabled flag
@@ -2512,8 +2551,6 @@ void MainWindow::onToggleFlatpakSearch(bool enabled)
                 } else {
         // If search is disabled, clear any Flatpak results
         m_flatpakModel->clear();
-        m_flatpakModel->setHorizontalHeaderLabels(
-            QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
         
         // No need to disable a removed button
     }
@@ -2525,34 +2562,12 @@ void MainWindow::refreshInstalledFlatpakPackages()
         return;
     }
     
-    // Clear the model
-    m_installedFlatpakModel->clear();
-    m_installedFlatpakModel->setHorizontalHeaderLabels(
-        QStringList() << tr("") << tr("Name") << tr("Version") << tr("Repository") << tr("Description"));
-    
     // Get installed packages
     std::vector<pacmangui::core::FlatpakPackage> installedPackages = m_packageManager.get_installed_flatpak_packages();
     
-    // Add packages to the model
-    for (const auto& pkg : installedPackages) {
-        QList<QStandardItem*> row;
-        
-        // Add checkbox item
-        QStandardItem* checkItem = new QStandardItem();
-        checkItem->setCheckable(true);
-        checkItem->setCheckState(Qt::Unchecked);
-        checkItem->setData(Qt::AlignCenter, Qt::TextAlignmentRole);
-        
-        QStandardItem* nameItem = new QStandardItem(QString::fromStdString(pkg.get_name()));
-        nameItem->setData(QString::fromStdString(pkg.get_app_id()), Qt::UserRole); // Store app_id for later use
-        
-        QStandardItem* versionItem = new QStandardItem(QString::fromStdString(pkg.get_version()));
-        QStandardItem* repoItem = new QStandardItem(QString::fromStdString(pkg.get_repository()));
-        QStandardItem* descItem = new QStandardItem(QString::fromStdString(pkg.get_description()));
-        
-        row << checkItem << nameItem << versionItem << repoItem << descItem;
-        m_installedFlatpakModel->appendRow(row);
-    }
+    // Replace the rows in one go
+    m_installedFlatpakModel->clear();
+    m_installedFlatpakModel->appendFlatpakPackages(installedPackages);
     
     // Update status bar
     showStatusMessage(tr("Loaded %1 installed Flatpak packages").arg(installedPackages.size()), 3000);
@@ -2590,30 +2605,7 @@ void MainWindow::performAsyncFlatpakSearch(const QString& searchTerm) {
         
         // Update the model with the results
         for (const auto& package : results) {
-            // Create checkbox item
-            auto checkbox = new QStandardItem();
-            checkbox->setCheckable(true);
-            checkbox->setCheckState(Qt::Unchecked);
-            
-            // Create items for other columns
-            auto nameItem = new QStandardItem(QString::fromStdString(package.get_name()));
-            auto versionItem = new QStandardItem(QString::fromStdString(package.get_version()));
-            auto repositoryItem = new QStandardItem("Flatpak");
-            auto descriptionItem = new QStandardItem(QString::fromStdString(package.get_description()));
-            
-            // Store the package in the first column
-            QVariant v;
-            v.setValue(package);
-            checkbox->setData(v, Qt::UserRole);
-            
-            // Mark as Flatpak for later identification
-            checkbox->setData("flatpak", Qt::UserRole + 1);
-            nameItem->setData("flatpak", Qt::UserRole + 1);
-            
-            // Add the row to the main model
-            QList<QStandardItem*> items;
-            items << checkbox << nameItem << versionItem << repositoryItem << descriptionItem;
-            m_packagesModel->appendRow(items);
+            appendFlatpakSearchRow(package);
         }
         
         // Update status
@@ -2712,53 +2704,17 @@ void MainWindow::onInstallFlatpakPackage()
         return;
     }
     
-    // Show progress dialog
-    QProgressDialog progress(tr("Installing Flatpak packages..."), tr("Cancel"), 0, packageAppIds.size(), this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setMinimumDuration(0);
-    progress.setValue(0);
-    
-    // Install packages one by one
-    bool allSuccessful = true;
-    for (int i = 0; i < packageAppIds.size(); i++) {
-        QString appId = packageAppIds[i];
-        QString name = packageNames[i];
-        QString remote = packageRemotes[i];
-        
-        progress.setLabelText(tr("Installing %1...").arg(name));
-        progress.setValue(i);
-        
-        if (progress.wasCanceled()) {
+    // flatpak install takes one remote per transaction; with mixed remotes it
+    // picks the remote of each app itself
+    QString remote = packageRemotes.first();
+    for (const QString& packageRemote : packageRemotes) {
+        if (packageRemote != remote) {
+            remote.clear();
             break;
         }
-        
-        // Install the package
-        bool success = m_packageManager.install_flatpak_package(appId.toStdString(), remote.toStdString());
-        
-        if (!success) {
-            allSuccessful = false;
-            QMessageBox::warning(
-                this,
-                tr("Installation Failed"),
-                tr("Failed to install %1: %2")
-                    .arg(name)
-                    .arg(QString::fromStdString(m_packageManager.get_last_error())),
-                QMessageBox::Ok
-            );
-        }
     }
     
-    progress.setValue(packageAppIds.size());
-    
-    // Show status message
-    if (allSuccessful) {
-        showStatusMessage(tr("Successfully installed Flatpak packages"), 3000);
-        } else {
-        showStatusMessage(tr("Some Flatpak packages failed to install"), 3000);
-    }
-    
-    // Refresh installed packages list
-    refreshInstalledFlatpakPackages();
+    runFlatpakTransaction(core::FlatpakOperation::INSTALL, packageAppIds, packageNames, remote);
 }
 
 void MainWindow::onRemoveFlatpakPackage()
@@ -2830,52 +2786,85 @@ void MainWindow::onRemoveFlatpakPackage()
         return;
     }
     
-    // Show progress dialog
-    QProgressDialog progress(tr("Removing Flatpak packages..."), tr("Cancel"), 0, packageAppIds.size(), this);
-    progress.setWindowModality(Qt::WindowModal);
-    progress.setMinimumDuration(0);
-    progress.setValue(0);
+    runFlatpakTransaction(core::FlatpakOperation::REMOVE, packageAppIds, packageNames);
+}
+
+void MainWindow::runFlatpakTransaction(core::FlatpakOperation operation, const QStringList& appIds,
+                                       const QStringList& names, const QString& remote)
+{
+    if (m_flatpakJob) {
+        showStatusMessage(tr("A Flatpak transaction is already running"), 3000);
+        return;
+    }
     
-    // Remove packages one by one
-    bool allSuccessful = true;
-    for (int i = 0; i < packageAppIds.size(); i++) {
-        QString appId = packageAppIds[i];
-        QString name = packageNames[i];
+    bool installing = operation == core::FlatpakOperation::INSTALL;
+    
+    // All packages go to one transaction; the dialog follows each of them
+    // through the progress signals instead of waiting on flatpak
+    QProgressDialog* progress = new QProgressDialog(
+        installing ? tr("Installing Flatpak packages...") : tr("Removing Flatpak packages..."),
+        tr("Cancel"), 0, appIds.size() * 100, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    progress->setAttribute(Qt::WA_DeleteOnClose);
+    
+    m_flatpakJob = new FlatpakTransactionJob(&m_packageManager, operation, appIds, remote, this);
+    
+    auto percents = std::make_shared<QMap<QString, int>>();
+    auto failures = std::make_shared<QStringList>();
+    connect(m_flatpakJob, &FlatpakTransactionJob::refProgress, progress,
+            [progress, appIds, names, percents, failures](const QString& ref, int state, int percent,
+                                                          const QString& message, bool requested) {
+        QString name = names.value(appIds.indexOf(ref), ref);
+        progress->setLabelText(QString("%1\n%2").arg(name, message));
         
-        progress.setLabelText(tr("Removing %1...").arg(name));
-        progress.setValue(i);
+        // Runtimes pulled in as dependencies show up in the label only
+        if (!requested) {
+            return;
+        }
         
-        if (progress.wasCanceled()) {
-            break;
+        bool ended = state == static_cast<int>(core::FlatpakRefState::DONE) ||
+                     state == static_cast<int>(core::FlatpakRefState::FAILED);
+        (*percents)[ref] = ended ? 100 : percent;
+        if (state == static_cast<int>(core::FlatpakRefState::FAILED)) {
+            failures->append(QString("%1: %2").arg(name, message));
         }
         
-        // Remove the package
-        bool success = m_packageManager.remove_flatpak_package(appId.toStdString());
+        int total = 0;
+        for (int value : *percents) {
+            total += value;
+        }
+        progress->setValue(total);
+    });
+    connect(progress, &QProgressDialog::canceled, m_flatpakJob, &FlatpakTransactionJob::cancel);
+    connect(m_flatpakJob, &FlatpakTransactionJob::finished, this,
+            [this, progress, installing, failures](bool success, const QString& error) {
+        progress->close();
+        m_flatpakJob->deleteLater();
+        m_flatpakJob = nullptr;
         
-        if (!success) {
-            allSuccessful = false;
+        if (success) {
+            showStatusMessage(installing ? tr("Successfully installed Flatpak packages")
+                                         : tr("Successfully removed Flatpak packages"), 3000);
+        } else {
             QMessageBox::warning(
                 this,
-                tr("Removal Failed"),
-                tr("Failed to remove %1: %2")
-                    .arg(name)
-                    .arg(QString::fromStdString(m_packageManager.get_last_error())),
+                installing ? tr("Installation Failed") : tr("Removal Failed"),
+                failures->isEmpty() ? error : failures->join("\n"),
                 QMessageBox::Ok
             );
+            showStatusMessage(installing ? tr("Some Flatpak packages failed to install")
+                                         : tr("Some Flatpak packages failed to remove"), 3000);
         }
-    }
-    
-    progress.setValue(packageAppIds.size());
-    
-    // Show status message
-    if (allSuccessful) {
-        showStatusMessage(tr("Successfully removed Flatpak packages"), 3000);
-    } else {
-        showStatusMessage(tr("Some Flatpak packages failed to remove"), 3000);
-    }
+        
+        // Refresh installed packages list
+        refreshInstalledFlatpakPackages();
+    });
     
-    // Refresh installed packages list
-    refreshInstalledFlatpakPackages();
+    progress->show();
+    m_flatpakJob->start();
 }
 
 // Add Flatpak search functions
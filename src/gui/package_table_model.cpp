@@ -0,0 +1,351 @@
+#include "gui/package_table_model.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <numeric>
+
+namespace pacmangui {
+namespace gui {
+
+namespace {
+    QString toQString(std::string_view text)
+    {
+        return QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+    }
+
+    bool lessIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) < std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+}
+
+PackageTableModel::PackageTableModel(const QList<Column>& columns, QObject* parent)
+    : QAbstractTableModel(parent)
+    , m_columns(columns)
+{
+}
+
+void PackageTableModel::setCatalogPackages(std::shared_ptr<const core::PackageCatalog> catalog,
+                                           std::vector<core::PackageView> packages)
+{
+    beginResetModel();
+    m_rows.clear();
+    m_owned.clear();
+    m_catalogs.clear();
+    if (catalog) {
+        m_catalogs.push_back(std::move(catalog));
+    }
+
+    m_rows.reserve(packages.size());
+    for (const core::PackageView& package : packages) {
+        Row row;
+        row.package = package;
+        m_rows.push_back(row);
+    }
+    m_checked.assign(m_rows.size(), false);
+    endResetModel();
+}
+
+void PackageTableModel::appendCatalogPackages(std::shared_ptr<const core::PackageCatalog> catalog,
+                                              const std::vector<core::PackageView>& packages)
+{
+    if (packages.empty()) {
+        return;
+    }
+    if (catalog && std::find(m_catalogs.begin(), m_catalogs.end(), catalog) == m_catalogs.end()) {
+        m_catalogs.push_back(std::move(catalog));
+    }
+
+    int first = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(packages.size()) - 1);
+    for (const core::PackageView& package : packages) {
+        Row row;
+        row.package = package;
+        m_rows.push_back(row);
+        m_checked.push_back(false);
+    }
+    endInsertRows();
+}
+
+void PackageTableModel::appendPackages(const std::vector<core::Package>& packages)
+{
+    if (packages.empty()) {
+        return;
+    }
+
+    int first = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(packages.size()) - 1);
+    for (const core::Package& package : packages) {
+        OwnedPackage owned;
+        owned.name = package.get_name();
+        owned.version = package.get_version();
+        owned.description = package.get_description();
+        owned.repository = package.get_repository();
+
+        std::string repository = owned.repository;
+        std::transform(repository.begin(), repository.end(), repository.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        appendOwned(std::move(owned), repository == "aur" ? Source::AUR : Source::REPOSITORY);
+    }
+    endInsertRows();
+}
+
+void PackageTableModel::appendFlatpakPackages(const std::vector<core::FlatpakPackage>& packages,
+                                              const std::string& repository)
+{
+    if (packages.empty()) {
+        return;
+    }
+
+    int first = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(packages.size()) - 1);
+    for (const core::FlatpakPackage& package : packages) {
+        OwnedPackage owned;
+        owned.name = package.get_name();
+        owned.version = package.get_version();
+        owned.description = package.get_description();
+        owned.repository = repository.empty() ? package.get_repository() : repository;
+        owned.app_id = package.get_app_id();
+        appendOwned(std::move(owned), Source::FLATPAK);
+    }
+    endInsertRows();
+}
+
+void PackageTableModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_checked.clear();
+    m_owned.clear();
+    m_catalogs.clear();
+    endResetModel();
+}
+
+core::PackageView PackageTableModel::packageAt(int row) const
+{
+    if (row < 0 || row >= static_cast<int>(m_rows.size())) {
+        return core::PackageView();
+    }
+    return m_rows[row].package;
+}
+
+QStringList PackageTableModel::checkedPackageNames() const
+{
+    QStringList names;
+    for (size_t i = 0; i < m_rows.size(); ++i) {
+        if (m_checked[i]) {
+            names.append(toQString(m_rows[i].package.name));
+        }
+    }
+    return names;
+}
+
+int PackageTableModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int PackageTableModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_columns.size());
+}
+
+QVariant PackageTableModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= static_cast<int>(m_rows.size()) || index.column() >= m_columns.size()) {
+        return QVariant();
+    }
+
+    const Row& row = m_rows[index.row()];
+    Column column = m_columns[index.column()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return column == CHECK_COLUMN ? QVariant() : QVariant(text(row, column));
+    case Qt::CheckStateRole:
+        if (column == CHECK_COLUMN) {
+            return static_cast<int>(m_checked[index.row()] ? Qt::Checked : Qt::Unchecked);
+        }
+        return QVariant();
+    case Qt::TextAlignmentRole:
+        return column == CHECK_COLUMN ? QVariant(static_cast<int>(Qt::AlignCenter)) : QVariant();
+    case AppIdRole:
+        return row.app_id.empty() ? QVariant() : QVariant(toQString(row.app_id));
+    case PackageTypeRole:
+        if (row.source == Source::AUR) {
+            return QStringLiteral("aur");
+        }
+        if (row.source == Source::FLATPAK) {
+            return QStringLiteral("flatpak");
+        }
+        return QVariant();
+    default:
+        return QVariant();
+    }
+}
+
+bool PackageTableModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+    if (!index.isValid() || role != Qt::CheckStateRole || index.row() >= static_cast<int>(m_rows.size()) ||
+        index.column() >= m_columns.size() || m_columns[index.column()] != CHECK_COLUMN) {
+        return false;
+    }
+
+    m_checked[index.row()] = value.toInt() == Qt::Checked;
+    emit dataChanged(index, index, {Qt::CheckStateRole});
+    return true;
+}
+
+Qt::ItemFlags PackageTableModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid() || index.column() >= m_columns.size()) {
+        return Qt::NoItemFlags;
+    }
+
+    Qt::ItemFlags result = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    if (m_columns[index.column()] == CHECK_COLUMN) {
+        result |= Qt::ItemIsUserCheckable;
+    }
+    return result;
+}
+
+QVariant PackageTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole || section < 0 || section >= m_columns.size()) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (m_columns[section]) {
+    case CHECK_COLUMN:
+        return QString();
+    case NAME_COLUMN:
+        return tr("Name");
+    case VERSION_COLUMN:
+        return tr("Version");
+    case REPOSITORY_COLUMN:
+        return tr("Repository");
+    case DESCRIPTION_COLUMN:
+        return tr("Description");
+    }
+    return QVariant();
+}
+
+void PackageTableModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= m_columns.size()) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // Sort row numbers by the viewed strings; no cell text is built for this
+    Column shown = m_columns[column];
+    auto key = [shown](const Row& row) -> std::string_view {
+        switch (shown) {
+        case NAME_COLUMN:
+            return row.package.name;
+        case VERSION_COLUMN:
+            return row.package.version;
+        case REPOSITORY_COLUMN:
+            return row.package.repository;
+        case DESCRIPTION_COLUMN:
+            return row.package.description;
+        default:
+            return std::string_view();
+        }
+    };
+    auto less = [this, shown, &key](size_t a, size_t b) {
+        if (shown == CHECK_COLUMN) {
+            return m_checked[a] < m_checked[b];
+        }
+        return lessIgnoreCase(key(m_rows[a]), key(m_rows[b]));
+    };
+
+    std::vector<size_t> sorted(m_rows.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    if (order == Qt::AscendingOrder) {
+        std::stable_sort(sorted.begin(), sorted.end(), less);
+    } else {
+        std::stable_sort(sorted.begin(), sorted.end(), [&less](size_t a, size_t b) { return less(b, a); });
+    }
+
+    std::vector<Row> rows;
+    std::vector<bool> checked;
+    std::vector<int> newRow(m_rows.size());
+    rows.reserve(m_rows.size());
+    checked.reserve(m_rows.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        rows.push_back(m_rows[sorted[i]]);
+        checked.push_back(m_checked[sorted[i]]);
+        newRow[sorted[i]] = static_cast<int>(i);
+    }
+    m_rows.swap(rows);
+    m_checked.swap(checked);
+
+    // Keep selections and the current index on the same packages
+    QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex& index : from) {
+        to.append(createIndex(newRow[index.row()], index.column()));
+    }
+    changePersistentIndexList(from, to);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+QString PackageTableModel::text(const Row& row, Column column) const
+{
+    switch (column) {
+    case NAME_COLUMN:
+        return toQString(row.package.name);
+    case VERSION_COLUMN:
+        return toQString(row.package.version);
+    case REPOSITORY_COLUMN:
+        return repositoryLabel(row);
+    case DESCRIPTION_COLUMN:
+        return toQString(row.package.description);
+    default:
+        return QString();
+    }
+}
+
+QString PackageTableModel::repositoryLabel(const Row& row)
+{
+    QString repo = toQString(row.package.repository);
+    if (row.source == Source::AUR) {
+        return QStringLiteral("AUR");
+    }
+    if (row.source == Source::REPOSITORY) {
+        if (repo.toLower().contains("cachyos")) {
+            // Uppercase for consistency
+            return repo.toUpper();
+        }
+        if (repo.toLower() == "chaotic-aur") {
+            return QStringLiteral("Chaotic-AUR");
+        }
+    }
+    return repo;
+}
+
+void PackageTableModel::appendOwned(OwnedPackage owned, Source source)
+{
+    // Deque elements never move, so the views stay valid as rows are added
+    m_owned.push_back(std::move(owned));
+    const OwnedPackage& stored = m_owned.back();
+
+    Row row;
+    row.package.name = stored.name;
+    row.package.version = stored.version;
+    row.package.description = stored.description;
+    row.package.repository = stored.repository;
+    row.app_id = stored.app_id;
+    row.source = source;
+    m_rows.push_back(row);
+    m_checked.push_back(false);
+}
+
+} // namespace gui
+} // namespace pacmangui
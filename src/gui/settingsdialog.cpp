@@ -15,6 +15,13 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     , m_tabWidget(nullptr)
     , m_aurTab(nullptr)
     , m_enableAurCheckbox(nullptr)
+    , m_aurLocalIndexCheckbox(nullptr)
+    , m_aurNativeBuildCheckbox(nullptr)
+    , m_aurBuildJobsSpinBox(nullptr)
+    , m_aurBuildCacheCheckbox(nullptr)
+    , m_aurCacheSizeSpinBox(nullptr)
+    , m_aurCacheAgeSpinBox(nullptr)
+    , m_aurSharedCacheEdit(nullptr)
     , m_flatpakTab(nullptr)
     , m_enableFlatpakCheckbox(nullptr)
     , m_appearanceTab(nullptr)
@@ -26,6 +33,7 @@ SettingsDialog::SettingsDialog(QWidget* parent)
     , m_cancelButton(nullptr)
     , m_applyButton(nullptr)
     , m_aurEnabled(false)
+    , m_aurLocalIndex(false)
     , m_flatpakEnabled(false)
     , m_selectedTheme("dark_colorful")
     , m_scalingFactor(1.0)
@@ -103,6 +111,48 @@ void SettingsDialog::setupUi()
     m_enableAurCheckbox = new QCheckBox("Enable AUR Support", aurGroupBox);
     aurGroupLayout->addWidget(m_enableAurCheckbox);
     
+    m_aurLocalIndexCheckbox = new QCheckBox("Keep a local copy of the AUR package list for fast and offline search", aurGroupBox);
+    aurGroupLayout->addWidget(m_aurLocalIndexCheckbox);
+    
+    m_aurNativeBuildCheckbox = new QCheckBox("Build AUR packages with makepkg instead of an AUR helper", aurGroupBox);
+    aurGroupLayout->addWidget(m_aurNativeBuildCheckbox);
+    
+    // 0 lets the builder pick a limit from the number of CPUs
+    QHBoxLayout* buildJobsLayout = new QHBoxLayout();
+    m_aurBuildJobsSpinBox = new QSpinBox(aurGroupBox);
+    m_aurBuildJobsSpinBox->setRange(0, 16);
+    m_aurBuildJobsSpinBox->setSpecialValueText("Automatic");
+    buildJobsLayout->addWidget(new QLabel("Parallel AUR builds:", aurGroupBox));
+    buildJobsLayout->addWidget(m_aurBuildJobsSpinBox);
+    buildJobsLayout->addStretch(1);
+    aurGroupLayout->addLayout(buildJobsLayout);
+    
+    m_aurBuildCacheCheckbox = new QCheckBox("Reuse packages built before from the same PKGBUILD", aurGroupBox);
+    aurGroupLayout->addWidget(m_aurBuildCacheCheckbox);
+    
+    // 0 turns either limit off
+    QFormLayout* buildCacheLayout = new QFormLayout();
+    m_aurCacheSizeSpinBox = new QSpinBox(aurGroupBox);
+    m_aurCacheSizeSpinBox->setRange(0, 1024 * 1024);
+    m_aurCacheSizeSpinBox->setSingleStep(512);
+    m_aurCacheSizeSpinBox->setSuffix(" MiB");
+    m_aurCacheSizeSpinBox->setSpecialValueText("Unlimited");
+    buildCacheLayout->addRow("Build cache size limit:", m_aurCacheSizeSpinBox);
+    m_aurCacheAgeSpinBox = new QSpinBox(aurGroupBox);
+    m_aurCacheAgeSpinBox->setRange(0, 3650);
+    m_aurCacheAgeSpinBox->setSuffix(" days");
+    m_aurCacheAgeSpinBox->setSpecialValueText("Unlimited");
+    buildCacheLayout->addRow("Remove builds unused for:", m_aurCacheAgeSpinBox);
+    m_aurSharedCacheEdit = new QLineEdit(aurGroupBox);
+    m_aurSharedCacheEdit->setPlaceholderText("None");
+    m_aurSharedCacheEdit->setToolTip("A directory, for example on a network share, where builds are shared with other machines. It is only used if it and its parents are owned by root and not writable by group or others, and only root adds builds to it");
+    buildCacheLayout->addRow("Shared build cache:", m_aurSharedCacheEdit);
+    aurGroupLayout->addLayout(buildCacheLayout);
+    
+    connect(m_aurBuildCacheCheckbox, &QCheckBox::toggled, m_aurCacheSizeSpinBox, &QWidget::setEnabled);
+    connect(m_aurBuildCacheCheckbox, &QCheckBox::toggled, m_aurCacheAgeSpinBox, &QWidget::setEnabled);
+    connect(m_aurBuildCacheCheckbox, &QCheckBox::toggled, m_aurSharedCacheEdit, &QWidget::setEnabled);
+    
     // Add a note about AUR support
     QLabel* aurNoteLabel = new QLabel("Note: Enabling AUR support allows installing packages from the Arch User Repository. "
                                      "AUR packages are user-produced content and may be less stable than official packages.", 
@@ -233,6 +283,7 @@ void SettingsDialog::onApplyClicked()
     // Store the current settings
     QString previousTheme = m_selectedTheme;
     bool previousAurEnabled = m_aurEnabled;
+    bool previousAurLocalIndex = m_aurLocalIndex;
     bool previousFlatpakEnabled = m_flatpakEnabled;
     std::cout << "SettingsDialog::onApplyClicked - Previous theme: " << previousTheme.toStdString() << std::endl;
     
@@ -252,6 +303,11 @@ void SettingsDialog::onApplyClicked()
         emit aurStatusChanged(m_aurEnabled);
     }
     
+    // If the local AUR index was switched, emit signal
+    if (previousAurLocalIndex != m_aurLocalIndex) {
+        emit aurLocalIndexChanged(m_aurLocalIndex);
+    }
+    
     // If Flatpak status changed, emit signal
     if (previousFlatpakEnabled != m_flatpakEnabled) {
         emit flatpakStatusChanged(m_flatpakEnabled);
@@ -267,6 +323,14 @@ void SettingsDialog::saveSettings()
     // Save AUR settings
     m_aurEnabled = m_enableAurCheckbox->isChecked();
     settings.setValue("aur/enabled", m_aurEnabled);
+    m_aurLocalIndex = m_aurLocalIndexCheckbox->isChecked();
+    settings.setValue("aur/local_index", m_aurLocalIndex);
+    settings.setValue("aur/native_build", m_aurNativeBuildCheckbox->isChecked());
+    settings.setValue("aur/build_jobs", m_aurBuildJobsSpinBox->value());
+    settings.setValue("aur/build_cache", m_aurBuildCacheCheckbox->isChecked());
+    settings.setValue("aur/cache_max_size_mb", m_aurCacheSizeSpinBox->value());
+    settings.setValue("aur/cache_max_age_days", m_aurCacheAgeSpinBox->value());
+    settings.setValue("aur/shared_cache_dir", m_aurSharedCacheEdit->text().trimmed());
     
     // Save Flatpak settings
     m_flatpakEnabled = m_enableFlatpakCheckbox->isChecked();
@@ -303,6 +367,17 @@ void SettingsDialog::loadSettings()
     // Load AUR settings
     m_aurEnabled = settings.value("aur/enabled", false).toBool();
     m_enableAurCheckbox->setChecked(m_aurEnabled);
+    m_aurLocalIndex = settings.value("aur/local_index", false).toBool();
+    m_aurLocalIndexCheckbox->setChecked(m_aurLocalIndex);
+    m_aurNativeBuildCheckbox->setChecked(settings.value("aur/native_build", false).toBool());
+    m_aurBuildJobsSpinBox->setValue(settings.value("aur/build_jobs", 0).toInt());
+    m_aurBuildCacheCheckbox->setChecked(settings.value("aur/build_cache", true).toBool());
+    m_aurCacheSizeSpinBox->setValue(settings.value("aur/cache_max_size_mb", 4096).toInt());
+    m_aurCacheAgeSpinBox->setValue(settings.value("aur/cache_max_age_days", 90).toInt());
+    m_aurSharedCacheEdit->setText(settings.value("aur/shared_cache_dir", "").toString());
+    m_aurCacheSizeSpinBox->setEnabled(m_aurBuildCacheCheckbox->isChecked());
+    m_aurCacheAgeSpinBox->setEnabled(m_aurBuildCacheCheckbox->isChecked());
+    m_aurSharedCacheEdit->setEnabled(m_aurBuildCacheCheckbox->isChecked());
     
     // Load Flatpak settings
     m_flatpakEnabled = settings.value("flatpak/enabled", false).toBool();
@@ -0,0 +1,819 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <alpm.h>
+#include "core/pacman_config.hpp"
+#include "core/transaction.hpp"
+#include "core/helper_protocol.hpp"
+#include "core/download_scheduler.hpp"
+#include "core/system_maintenance.hpp"
+
+using namespace pacmangui::core;
+
+namespace {
+    // The daemon exits if the GUI that started it does not connect within this time
+    constexpr int kConnectTimeoutMs = 60 * 1000;
+
+    // How often the request watcher checks whether the operation finished
+    constexpr int kWatchIntervalMs = 100;
+
+    alpm_handle_t* g_handle = nullptr;
+    DownloadScheduler* g_scheduler = nullptr;
+    std::atomic<bool> g_cancelled(false);
+    volatile sig_atomic_t g_stop = 0;
+
+    // Becomes readable when a signal arrived, the signal handler only writes to it
+    int g_signal_fd = -1;
+
+    // The signal handler sets g_cancelled, which is only safe without a lock
+    static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "std::atomic<bool> must be lock-free");
+
+    // Writes a message to stdout in one-shot mode or to the client socket in daemon mode
+    std::function<void(const HelperMessage&)> g_emit;
+
+    /**
+     * @brief Everything the helper keeps loaded between requests
+     */
+    struct Session {
+        PacmanConfig config;
+        alpm_handle_t* handle = nullptr;
+        std::unique_ptr<DownloadScheduler> scheduler;
+        std::unique_ptr<TransactionManager> manager;
+        timespec local_stamp = {0, 0};
+        timespec sync_stamp = {0, 0};
+    };
+
+    void emit(const HelperMessage& message)
+    {
+        if (g_emit) {
+            g_emit(message);
+        }
+    }
+
+    void emit_line(const HelperMessage& message)
+    {
+        std::string line = format_helper_message(message);
+        fwrite(line.data(), 1, line.size(), stdout);
+        fflush(stdout);
+    }
+
+    void emit_event(const std::string& text)
+    {
+        HelperMessage message;
+        message.type = HelperMessageType::EVENT;
+        message.text = text;
+        emit(message);
+    }
+
+    void emit_done(bool success, const std::string& error)
+    {
+        if (!error.empty()) {
+            HelperMessage message;
+            message.type = HelperMessageType::ERROR;
+            message.text = error;
+            emit(message);
+        }
+
+        HelperMessage done;
+        done.type = HelperMessageType::DONE;
+        done.success = success;
+        emit(done);
+    }
+
+    void log_callback(void* ctx, alpm_loglevel_t level, const char* format, va_list args)
+    {
+        (void)ctx;
+        if (level != ALPM_LOG_ERROR && level != ALPM_LOG_WARNING) {
+            return;
+        }
+
+        char message[1024];
+        vsnprintf(message, sizeof(message), format, args);
+        std::string text = message;
+        if (!text.empty() && text.back() == '\n') {
+            text.pop_back();
+        }
+        emit_event((level == ALPM_LOG_ERROR ? "error: " : "warning: ") + text);
+    }
+
+    // Let ALPM stop at a safe point and roll back instead of dying mid-commit.
+    // ALPM only honours this while committing, so downloads and the step
+    // between prepare and commit check the flags themselves.
+    void request_interrupt()
+    {
+        g_cancelled = true;
+        if (g_scheduler) {
+            g_scheduler->cancel();
+        }
+        if (g_handle) {
+            alpm_trans_interrupt(g_handle);
+        }
+    }
+
+    // Only async-signal-safe work here, the request watcher does the rest
+    void interrupt_handler(int)
+    {
+        int saved_errno = errno;
+        g_stop = 1;
+        g_cancelled = true;
+        uint64_t one = 1;
+        if (write(g_signal_fd, &one, sizeof(one)) < 0) {
+            // The counter is already non-zero
+        }
+        errno = saved_errno;
+    }
+
+    // Without the eventfd signals still set the flags, they are only noticed later
+    void install_signal_handlers()
+    {
+        g_signal_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (g_signal_fd < 0) {
+            std::cerr << "pacmangui-helper: eventfd failed: " << strerror(errno) << std::endl;
+        }
+
+        // No SA_RESTART, so waiting system calls return early as well
+        struct sigaction action = {};
+        action.sa_handler = interrupt_handler;
+        sigemptyset(&action.sa_mask);
+        for (int signum : {SIGINT, SIGTERM, SIGHUP}) {
+            sigaction(signum, &action, nullptr);
+        }
+    }
+
+    // True if a signal arrived, the pending count is cleared
+    bool consume_signal()
+    {
+        uint64_t count = 0;
+        return g_signal_fd >= 0 && read(g_signal_fd, &count, sizeof(count)) == sizeof(count);
+    }
+
+    void database_stamps(const Session& session, timespec& local_stamp, timespec& sync_stamp)
+    {
+        std::string db_path = session.config.get_db_path();
+        if (!db_path.empty() && db_path.back() != '/') {
+            db_path += '/';
+        }
+
+        struct stat info;
+        local_stamp = stat((db_path + "local").c_str(), &info) == 0 ? info.st_mtim : timespec{0, 0};
+        sync_stamp = stat((db_path + "sync").c_str(), &info) == 0 ? info.st_mtim : timespec{0, 0};
+    }
+
+    bool open_session(Session& session, std::string& error)
+    {
+        alpm_errno_t err;
+        session.handle = alpm_initialize(session.config.get_root_dir().c_str(),
+                                         session.config.get_db_path().c_str(), &err);
+        if (!session.handle) {
+            error = std::string("Failed to initialize alpm: ") + alpm_strerror(err);
+            return false;
+        }
+
+        alpm_option_set_logcb(session.handle, log_callback, nullptr);
+        session.config.apply(session.handle);
+
+        // Downloads go through our scheduler so every file reports its throughput
+        session.scheduler.reset(new DownloadScheduler(session.config.get_parallel_downloads()));
+        session.manager.reset(new TransactionManager(session.handle));
+        session.manager->set_download_scheduler(session.scheduler.get());
+
+        database_stamps(session, session.local_stamp, session.sync_stamp);
+        g_scheduler = session.scheduler.get();
+        g_handle = session.handle;
+        return true;
+    }
+
+    void close_session(Session& session)
+    {
+        if (!session.handle) {
+            return;
+        }
+
+        g_handle = nullptr;
+        g_scheduler = nullptr;
+        session.manager->set_download_scheduler(nullptr);
+        session.manager.reset();
+        session.scheduler.reset();
+        alpm_release(session.handle);
+        session.handle = nullptr;
+    }
+
+    // The cached databases go stale when pacman runs outside the helper
+    bool refresh_session(Session& session, std::string& error)
+    {
+        timespec local_stamp;
+        timespec sync_stamp;
+        database_stamps(session, local_stamp, sync_stamp);
+
+        auto same = [](const timespec& a, const timespec& b) {
+            return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+        };
+        if (session.handle && same(local_stamp, session.local_stamp) && same(sync_stamp, session.sync_stamp)) {
+            return true;
+        }
+
+        std::cout << "pacmangui-helper: Databases changed, reloading" << std::endl;
+        close_session(session);
+        return open_session(session, error);
+    }
+
+    bool run_transaction(Session& session, TransactionType type, const HelperRequest& request, std::string& error)
+    {
+        TransactionManager& manager = *session.manager;
+        std::shared_ptr<Transaction> transaction = manager.init_transaction(type);
+        for (const auto& target : request.targets) {
+            transaction->add_target(target);
+        }
+        transaction->set_dependency_targets(request.dependencies);
+        transaction->set_overwrite_files(request.flags & HELPER_FLAG_OVERWRITE);
+        transaction->set_refresh_databases(request.flags & HELPER_FLAG_REFRESH);
+        transaction->set_remove_dependencies(request.flags & HELPER_FLAG_RECURSIVE);
+
+        transaction->set_event_callback([](const std::string& text) {
+            emit_event(text);
+        });
+        transaction->set_progress_callback([](const std::string& op, const std::string& target,
+                                              int percent, size_t current, size_t total) {
+            HelperMessage message;
+            message.type = HelperMessageType::PROGRESS;
+            message.operation = op;
+            message.target = target;
+            message.percent = percent;
+            message.current = current;
+            message.total = total;
+            emit(message);
+        });
+        transaction->set_download_callback([](const DownloadProgress& progress) {
+            HelperMessage message;
+            message.type = HelperMessageType::DOWNLOAD;
+            message.download = progress;
+            emit(message);
+        });
+
+        bool success = false;
+        if (request.operation == HelperOperation::REFRESH) {
+            success = manager.refresh_databases(transaction.get());
+        } else if (manager.prepare_transaction(transaction.get())) {
+            for (const auto& pkg : transaction->get_add_packages()) {
+                HelperMessage message;
+                message.type = HelperMessageType::ADD;
+                message.text = pkg.get_name();
+                message.target = pkg.get_version();
+                emit(message);
+            }
+            for (const auto& pkg : transaction->get_remove_packages()) {
+                HelperMessage message;
+                message.type = HelperMessageType::REMOVE;
+                message.text = pkg.get_name();
+                message.target = pkg.get_version();
+                emit(message);
+            }
+
+            if (g_cancelled) {
+                manager.release_transaction(transaction.get());
+                transaction->set_last_error("Operation cancelled");
+            } else {
+                success = manager.commit_transaction(transaction.get());
+            }
+        }
+
+        if (!success) {
+            error = g_cancelled ? "Operation cancelled" : transaction->get_last_error();
+        }
+        return success;
+    }
+
+    // Nobody but root and the given user may change the file or swap it in its directory
+    bool trusted_by(const struct stat& info, uid_t uid)
+    {
+        return (info.st_uid == 0 || info.st_uid == uid) && !(info.st_mode & (S_IWGRP | S_IWOTH));
+    }
+
+    // Package files come from the user's build directory, never from relative or odd paths.
+    // Their install scriptlets run as root, so only the invoking user or root may have written them.
+    bool check_package_file(const std::string& path, uid_t uid, std::string& error)
+    {
+        struct stat info;
+        std::string filename = path.substr(path.find_last_of('/') + 1);
+        if (path.empty() || path[0] != '/' || path.find("/../") != std::string::npos ||
+            filename.find(".pkg.tar") == std::string::npos) {
+            error = "Not a package file: " + path;
+            return false;
+        }
+        if (lstat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+            error = "Package file not found: " + path;
+            return false;
+        }
+        if (!trusted_by(info, uid)) {
+            error = "Package file is writable by other users: " + path;
+            return false;
+        }
+
+        std::string dir = path.substr(0, std::max<size_t>(path.rfind('/'), 1));
+        if (lstat(dir.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) || !trusted_by(info, uid)) {
+            error = "Package directory is writable by other users: " + dir;
+            return false;
+        }
+        return true;
+    }
+
+    // Runs one request on the session's handle, shared by one-shot and daemon mode.
+    // uid is the user package files have to belong to, besides root.
+    bool execute(Session& session, const HelperRequest& request, uid_t uid, std::string& error)
+    {
+        SystemMaintenance maintenance(session.handle);
+
+        switch (request.operation) {
+            case HelperOperation::INSTALL:
+            case HelperOperation::REMOVE:
+            case HelperOperation::UPDATE:
+                if (request.targets.empty()) {
+                    error = "No targets given";
+                    return false;
+                }
+                if (request.operation == HelperOperation::INSTALL) {
+                    return run_transaction(session, TransactionType::INSTALL, request, error);
+                }
+                if (request.operation == HelperOperation::REMOVE) {
+                    return run_transaction(session, TransactionType::REMOVE, request, error);
+                }
+                return run_transaction(session, TransactionType::UPDATE, request, error);
+
+            case HelperOperation::SYSUPGRADE:
+            case HelperOperation::REFRESH:
+                return run_transaction(session, TransactionType::SYNC, request, error);
+
+            case HelperOperation::INSTALL_FILES:
+                if (request.targets.empty()) {
+                    error = "No targets given";
+                    return false;
+                }
+                for (const auto& target : request.targets) {
+                    if (!check_package_file(target, uid, error)) {
+                        return false;
+                    }
+                }
+                return run_transaction(session, TransactionType::INSTALL_FILES, request, error);
+
+            case HelperOperation::CLEAN_CACHE:
+                if (!maintenance.clean_cache(request.flags & HELPER_FLAG_CLEAN_ALL, emit_event)) {
+                    error = maintenance.get_last_error();
+                    return false;
+                }
+                return true;
+
+            case HelperOperation::REMOVE_ORPHANS: {
+                // Dependencies only the orphans needed are orphans too, like pacman -Rs
+                HelperRequest removal = request;
+                removal.flags |= HELPER_FLAG_RECURSIVE;
+                removal.targets = maintenance.find_orphans();
+                if (removal.targets.empty()) {
+                    emit_event("No orphaned packages found");
+                    return true;
+                }
+                emit_event("Found " + std::to_string(removal.targets.size()) + " orphaned packages");
+                return run_transaction(session, TransactionType::REMOVE, removal, error);
+            }
+
+            case HelperOperation::CHECK_DATABASE:
+                if (!maintenance.check_database(request.flags & HELPER_FLAG_CHECK_SYNC, emit_event)) {
+                    error = maintenance.get_last_error();
+                    return false;
+                }
+                return true;
+
+            case HelperOperation::CANCEL:
+            case HelperOperation::SHUTDOWN:
+                break;
+        }
+
+        error = "Unsupported operation";
+        return false;
+    }
+
+    void reset_interrupt(Session& session)
+    {
+        g_cancelled = false;
+        if (session.scheduler) {
+            session.scheduler->reset_cancel();
+        }
+    }
+
+    // Reads CANCEL requests and signals while an operation runs. A client that
+    // goes away does not stop the operation, a half-applied transaction is worse.
+    // In one-shot mode there is no client, poll skips the negative descriptor.
+    void watch_request(int client, const std::atomic<bool>& finished)
+    {
+        while (!finished) {
+            pollfd poll_fds[] = {{client, POLLIN, 0}, {g_signal_fd, POLLIN, 0}};
+            if (poll(poll_fds, 2, kWatchIntervalMs) <= 0) {
+                continue;
+            }
+            if (poll_fds[1].revents && consume_signal()) {
+                request_interrupt();
+            }
+            if (!poll_fds[0].revents) {
+                continue;
+            }
+
+            std::string payload;
+            HelperRequest request;
+            if (!read_helper_frame(client, payload)) {
+                // Keep watching for signals
+                client = -1;
+                continue;
+            }
+            if (decode_helper_request(payload, request) && request.operation == HelperOperation::CANCEL) {
+                std::cout << "pacmangui-helper: Cancel requested" << std::endl;
+                request_interrupt();
+            }
+        }
+    }
+
+    // Serves requests of the GUI until it disconnects or asks to shut down
+    void serve_client(Session& session, int client, uid_t uid)
+    {
+        g_emit = [client](const HelperMessage& message) {
+            write_helper_frame(client, encode_helper_message(message));
+        };
+
+        std::string payload;
+        while (!g_stop) {
+            // Wait for the next request, or for a signal to stop the daemon
+            pollfd poll_fds[] = {{client, POLLIN, 0}, {g_signal_fd, POLLIN, 0}};
+            int ready = poll(poll_fds, 2, -1);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0 || !poll_fds[0].revents || !read_helper_frame(client, payload)) {
+                break;
+            }
+
+            HelperRequest request;
+            if (!decode_helper_request(payload, request)) {
+                emit_done(false, "Malformed request");
+                break;
+            }
+            if (request.operation == HelperOperation::CANCEL) {
+                // Nothing is running
+                continue;
+            }
+            if (request.operation == HelperOperation::SHUTDOWN) {
+                emit_done(true, "");
+                break;
+            }
+
+            std::string error;
+            if (!refresh_session(session, error)) {
+                emit_done(false, error);
+                continue;
+            }
+
+            reset_interrupt(session);
+            std::atomic<bool> finished(false);
+            std::thread watcher(watch_request, client, std::cref(finished));
+            bool success = execute(session, request, uid, error);
+            finished = true;
+            watcher.join();
+
+            database_stamps(session, session.local_stamp, session.sync_stamp);
+            emit_done(success, error);
+        }
+
+        g_emit = nullptr;
+    }
+
+    // Only the GUI process that started the daemon may connect, not any process of its user
+    bool peer_allowed(int client, uid_t uid, pid_t owner)
+    {
+        ucred cred{};
+        socklen_t length = sizeof(cred);
+        if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0) {
+            return false;
+        }
+        return cred.pid == owner && cred.uid == uid;
+    }
+
+    // Becomes readable when the process exits, so a reused pid is never mistaken for it
+    int open_pidfd(pid_t pid)
+    {
+#ifdef SYS_pidfd_open
+        return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+        (void)pid;
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    int listen_on(const std::string& path, uid_t uid, std::string& error)
+    {
+        sockaddr_un addr{};
+        if (path.empty() || path.front() != '/' || path.size() >= sizeof(addr.sun_path)) {
+            error = "Invalid socket path: " + path;
+            return -1;
+        }
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        // The directory must not let other users swap the socket
+        std::string dir = path.substr(0, std::max<size_t>(path.rfind('/'), 1));
+        struct stat info;
+        if (lstat(dir.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) ||
+            (info.st_uid != uid && info.st_uid != 0) ||
+            ((info.st_mode & (S_IWGRP | S_IWOTH)) && !(info.st_mode & S_ISVTX))) {
+            error = "Unsafe socket directory: " + dir;
+            return -1;
+        }
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            error = std::string("Failed to create socket: ") + strerror(errno);
+            return -1;
+        }
+
+        if (lstat(path.c_str(), &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                error = path + " exists and is not a socket";
+                close(fd);
+                return -1;
+            }
+            if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+                error = "already running";
+                close(fd);
+                return -1;
+            }
+            // Left behind by a daemon that did not exit cleanly
+            unlink(path.c_str());
+        }
+
+        mode_t old_mask = umask(0177);
+        int bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        umask(old_mask);
+
+        if (bound != 0 || lchown(path.c_str(), uid, static_cast<gid_t>(-1)) != 0 || listen(fd, 4) != 0) {
+            error = "Failed to listen on " + path + ": " + strerror(errno);
+            if (bound == 0) {
+                unlink(path.c_str());
+            }
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    // pkexec and sudo both record who started them
+    uid_t invoking_uid()
+    {
+        for (const char* name : {"PKEXEC_UID", "SUDO_UID"}) {
+            const char* value = getenv(name);
+            if (value && *value) {
+                return static_cast<uid_t>(strtoul(value, nullptr, 10));
+            }
+        }
+        return 0;
+    }
+
+    int run_daemon(const std::string& socket_path, pid_t owner)
+    {
+        uid_t uid = invoking_uid();
+        Session session;
+        std::string error;
+
+        // Without pidfds (Linux < 5.3) the owner is only checked by pid
+        int owner_fd = open_pidfd(owner);
+        if (owner <= 0 || (owner_fd < 0 && errno != ENOSYS)) {
+            std::cerr << "pacmangui-helper: Owner process " << owner << " not found" << std::endl;
+            return 1;
+        }
+
+        if (!session.config.load()) {
+            std::cerr << "pacmangui-helper: " << session.config.get_last_error() << std::endl;
+            return 1;
+        }
+        if (!open_session(session, error)) {
+            std::cerr << "pacmangui-helper: " << error << std::endl;
+            return 1;
+        }
+
+        int listen_fd = listen_on(socket_path, uid, error);
+        if (listen_fd < 0) {
+            close_session(session);
+            if (owner_fd >= 0) {
+                close(owner_fd);
+            }
+            if (error == "already running") {
+                std::cout << "pacmangui-helper: Already running on " << socket_path << std::endl;
+                return 0;
+            }
+            std::cerr << "pacmangui-helper: " << error << std::endl;
+            return 1;
+        }
+
+        struct stat socket_info;
+        lstat(socket_path.c_str(), &socket_info);
+
+        // The socket accepts connections already, so pkexec or sudo can return
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "pacmangui-helper: fork failed: " << strerror(errno) << std::endl;
+            unlink(socket_path.c_str());
+            return 1;
+        }
+        if (pid > 0) {
+            std::cout << "pacmangui-helper: Listening on " << socket_path << std::endl;
+            _exit(0);
+        }
+
+        setsid();
+        if (chdir("/") != 0) {
+            std::cerr << "pacmangui-helper: chdir failed" << std::endl;
+        }
+        int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+            if (null_fd > STDERR_FILENO) {
+                close(null_fd);
+            }
+        }
+
+        install_signal_handlers();
+        signal(SIGPIPE, SIG_IGN);
+
+        // Wait for the GUI to connect, then serve that one connection and exit when it closes
+        int client = -1;
+        while (!g_stop && client < 0) {
+            pollfd poll_fds[] = {{listen_fd, POLLIN, 0}, {owner_fd, POLLIN, 0}, {g_signal_fd, POLLIN, 0}};
+            int ready = poll(poll_fds, 3, kConnectTimeoutMs);
+            if (ready < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ready <= 0 || poll_fds[1].revents || poll_fds[2].revents) {
+                break;
+            }
+
+            client = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0 && !peer_allowed(client, uid, owner)) {
+                close(client);
+                client = -1;
+            }
+        }
+
+        // Only remove the socket if it is still ours. Nothing else can connect from here on.
+        struct stat current;
+        if (lstat(socket_path.c_str(), &current) == 0 && current.st_ino == socket_info.st_ino) {
+            unlink(socket_path.c_str());
+        }
+        close(listen_fd);
+
+        if (client >= 0) {
+            serve_client(session, client, uid);
+            close(client);
+        }
+        if (owner_fd >= 0) {
+            close(owner_fd);
+        }
+        close_session(session);
+        return 0;
+    }
+
+    bool parse_operation(const std::string& name, HelperOperation& operation)
+    {
+        static const std::pair<const char*, HelperOperation> operations[] = {
+            {"install", HelperOperation::INSTALL},
+            {"remove", HelperOperation::REMOVE},
+            {"update", HelperOperation::UPDATE},
+            {"sysupgrade", HelperOperation::SYSUPGRADE},
+            {"refresh", HelperOperation::REFRESH},
+            {"clean-cache", HelperOperation::CLEAN_CACHE},
+            {"remove-orphans", HelperOperation::REMOVE_ORPHANS},
+            {"check-database", HelperOperation::CHECK_DATABASE},
+            {"install-files", HelperOperation::INSTALL_FILES},
+        };
+        for (const auto& entry : operations) {
+            if (name == entry.first) {
+                operation = entry.second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void print_usage()
+    {
+        std::cerr << "Usage: pacmangui-helper [--overwrite] [--refresh] [--all] [--sync] [--recursive] [--asdeps] "
+                     "<install|remove|update|sysupgrade|refresh|clean-cache|remove-orphans|check-database|install-files> "
+                     "[targets...]\n"
+                     "       pacmangui-helper --daemon <socket> --owner <pid>" << std::endl;
+    }
+
+    int finish(bool success, const std::string& error)
+    {
+        emit_done(success, error);
+        return success ? 0 : 1;
+    }
+}
+
+// Runs ALPM operations as root on behalf of the GUI. In one-shot mode a
+// single operation reports events, progress and the resolved package sets on
+// stdout using the line protocol from core/helper_protocol.hpp. With --daemon
+// the helper keeps its handle loaded and serves binary requests of the GUI
+// process given by --owner on a Unix socket, so the GUI authenticates once per
+// session. The daemon exits when that connection closes.
+int main(int argc, char* argv[])
+{
+    HelperRequest request;
+    std::string operation;
+    std::string socket_path;
+    pid_t owner = 0;
+    bool daemon = false;
+    bool as_dependencies = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--overwrite") {
+            request.flags |= HELPER_FLAG_OVERWRITE;
+        } else if (arg == "--refresh") {
+            request.flags |= HELPER_FLAG_REFRESH;
+        } else if (arg == "--all") {
+            request.flags |= HELPER_FLAG_CLEAN_ALL;
+        } else if (arg == "--sync") {
+            request.flags |= HELPER_FLAG_CHECK_SYNC;
+        } else if (arg == "--recursive") {
+            request.flags |= HELPER_FLAG_RECURSIVE;
+        } else if (arg == "--asdeps") {
+            as_dependencies = true;
+        } else if (arg == "--daemon" && i + 1 < argc) {
+            daemon = true;
+            socket_path = argv[++i];
+        } else if (arg == "--owner" && i + 1 < argc) {
+            owner = static_cast<pid_t>(strtol(argv[++i], nullptr, 10));
+        } else if (operation.empty()) {
+            operation = arg;
+        } else {
+            request.targets.push_back(arg);
+        }
+    }
+    if (as_dependencies) {
+        request.dependencies = request.targets;
+    }
+
+    if (daemon) {
+        if (geteuid() != 0) {
+            std::cerr << "pacmangui-helper must be run as root" << std::endl;
+            return 1;
+        }
+        return run_daemon(socket_path, owner);
+    }
+
+    g_emit = emit_line;
+
+    if (!parse_operation(operation, request.operation)) {
+        print_usage();
+        return finish(false, "Unknown operation: " + operation);
+    }
+
+    if (geteuid() != 0) {
+        return finish(false, "pacmangui-helper must be run as root");
+    }
+
+    Session session;
+    std::string error;
+    if (!session.config.load()) {
+        return finish(false, session.config.get_last_error());
+    }
+    if (!open_session(session, error)) {
+        return finish(false, error);
+    }
+
+    install_signal_handlers();
+
+    std::atomic<bool> finished(false);
+    std::thread watcher(watch_request, -1, std::cref(finished));
+    bool success = execute(session, request, invoking_uid(), error);
+    finished = true;
+    watcher.join();
+    close_session(session);
+
+    return finish(success, error);
+}
@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+#include "core/appstream_index.hpp"
+#include "core/flatpak_appstream_catalog.hpp"
+#include "temp_dir.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// Trimmed from a flathub catalog, with a translation, an old style desktop
+// file ID and a component that has no name
+const char* kFixture = R"(<?xml version="1.0" encoding="UTF-8"?>
+<!-- generated by flatpak-builder -->
+<components version="0.8" origin="flathub">
+  <component type="desktop-application">
+    <id>org.gnome.Calculator</id>
+    <name>Calculator</name>
+    <name xml:lang="de">Rechner</name>
+    <summary>Perform arithmetic, scientific or financial calculations</summary>
+    <summary xml:lang="de">Arithmetische, wissenschaftliche und finanzielle Berechnungen</summary>
+    <description><p>Calculator is an application that solves mathematical equations.</p></description>
+    <categories>
+      <category>Utility</category>
+      <category>Calculator</category>
+    </categories>
+    <keywords>
+      <keyword>equation</keyword>
+      <keyword xml:lang="de">Gleichung</keyword>
+    </keywords>
+    <releases>
+      <release timestamp="1711843200" version="46.1"/>
+      <release timestamp="1710460800" version="46.0"/>
+    </releases>
+    <bundle type="flatpak" runtime="org.gnome.Platform/x86_64/46" sdk="org.gnome.Sdk/x86_64/46">app/org.gnome.Calculator/x86_64/stable</bundle>
+  </component>
+  <component type="desktop">
+    <id>org.kde.kcalc.desktop</id>
+    <name>KCalc</name>
+    <summary>Scientific calculator &amp; converter</summary>
+    <keywords><keyword>math</keyword></keywords>
+  </component>
+  <component type="desktop-application">
+    <id>com.example.Nameless</id>
+    <summary>Has no name</summary>
+    <bundle type="flatpak">app/com.example.Nameless/x86_64/stable</bundle>
+  </component>
+  <component type="desktop-application">
+    <id>org.gnome.TextEditor</id>
+    <name><![CDATA[Text Editor]]></name>
+    <summary>Edit text files</summary>
+    <bundle type="flatpak">app/org.gnome.TextEditor/x86_64/beta</bundle>
+  </component>
+</components>
+)";
+
+void write_gzip(const std::string& path, const std::string& content)
+{
+    gzFile file = gzopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    ASSERT_EQ(gzwrite(file, content.data(), static_cast<unsigned>(content.size())), static_cast<int>(content.size()));
+    ASSERT_EQ(gzclose(file), Z_OK);
+}
+
+std::vector<AppstreamComponent> parse_fixture()
+{
+    std::vector<AppstreamComponent> components;
+    std::string error;
+    EXPECT_TRUE(AppstreamIndex::parse(kFixture, components, error)) << error;
+    return components;
+}
+
+} // namespace
+
+class AppstreamIndexTest : public TempDirTest {
+protected:
+    // Lays out a remote's appstream data the way flatpak does, with active linking to the commit
+    void deploy_appstream(const std::string& remote, const std::string& commit, const std::string& xml) {
+        std::string arch_dir = dir + "/installation/appstream/" + remote + "/x86_64";
+        std::filesystem::create_directories(arch_dir + "/" + commit);
+        ASSERT_TRUE(std::filesystem::is_directory(arch_dir + "/" + commit));
+        write_gzip(arch_dir + "/" + commit + "/appstream.xml.gz", xml);
+        unlink((arch_dir + "/active").c_str());
+        ASSERT_EQ(symlink(commit.c_str(), (arch_dir + "/active").c_str()), 0);
+    }
+};
+
+TEST_F(AppstreamIndexTest, ParsesUntranslatedComponents) {
+    std::vector<AppstreamComponent> components = parse_fixture();
+    ASSERT_EQ(components.size(), 3u);
+
+    const AppstreamComponent& calculator = components[0];
+    EXPECT_EQ(calculator.id, "org.gnome.Calculator");
+    EXPECT_EQ(calculator.name, "Calculator");
+    EXPECT_EQ(calculator.summary, "Perform arithmetic, scientific or financial calculations");
+    EXPECT_EQ(calculator.branch, "stable");
+    EXPECT_EQ(calculator.version, "46.1");
+    EXPECT_EQ(calculator.keywords, std::vector<std::string>({"equation"}));
+    EXPECT_EQ(calculator.categories, std::vector<std::string>({"Utility", "Calculator"}));
+
+    // Desktop file IDs lose their suffix when there is no bundle
+    EXPECT_EQ(components[1].id, "org.kde.kcalc");
+    EXPECT_EQ(components[1].summary, "Scientific calculator & converter");
+    EXPECT_EQ(components[2].name, "Text Editor");
+    EXPECT_EQ(components[2].branch, "beta");
+
+    std::vector<AppstreamComponent> broken;
+    std::string error;
+    EXPECT_FALSE(AppstreamIndex::parse("<components><component><name>x</component>", broken, error));
+    EXPECT_FALSE(error.empty());
+}
+
+TEST_F(AppstreamIndexTest, MapsAWrittenIndexAndRanksMatches) {
+    std::string path = dir + "/cache/flathub.index";
+    std::string error;
+    ASSERT_TRUE(AppstreamIndex::write(path, "0123abcd", parse_fixture(), error)) << error;
+
+    AppstreamIndex index;
+    ASSERT_TRUE(index.open(path)) << index.get_last_error();
+    EXPECT_EQ(index.get_checksum(), "0123abcd");
+    ASSERT_EQ(index.size(), 3u);
+    EXPECT_EQ(index.at(0).name, "Calculator");
+    EXPECT_EQ(index.at(0).keywords, "equation");
+    EXPECT_EQ(index.at(0).categories, "Utility;Calculator");
+    EXPECT_EQ(index.at(1).version, "");
+
+    // Name prefix first, then the description-only match on the other summary
+    std::vector<FuzzyMatch> matches = index.search(FuzzyMatcher("calcul"), 0);
+    ASSERT_EQ(matches.size(), 2u);
+    EXPECT_EQ(index.at(matches[0].index).id, "org.gnome.Calculator");
+    EXPECT_EQ(index.at(matches[1].index).id, "org.kde.kcalc");
+
+    // Keywords count as description, translations are not indexed
+    matches = index.search(FuzzyMatcher("equation"), 0);
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].kind, FuzzyMatchKind::DESCRIPTION);
+    EXPECT_TRUE(index.search(FuzzyMatcher("rechner"), 0).empty());
+
+    // IDs score as names, and typos are tolerated
+    EXPECT_EQ(index.at(index.search(FuzzyMatcher("texteditor"), 0).at(0).index).name, "Text Editor");
+    EXPECT_EQ(index.at(index.search(FuzzyMatcher("calcualtor"), 1).at(0).index).name, "Calculator");
+
+    std::ofstream(dir + "/garbage.index") << "not an index";
+    EXPECT_FALSE(index.open(dir + "/garbage.index"));
+    EXPECT_FALSE(index.is_open());
+}
+
+TEST_F(AppstreamIndexTest, CatalogRebuildsOnlyWhenTheChecksumChanges) {
+    deploy_appstream("flathub", "1111", kFixture);
+    FlatpakAppstreamCatalog catalog({{dir + "/installation", "system"}, {dir + "/missing", "user"}},
+                                    dir + "/cache", "x86_64");
+
+    std::vector<AppstreamSource> sources = catalog.find_sources();
+    ASSERT_EQ(sources.size(), 1u);
+    EXPECT_EQ(sources[0].remote, "flathub");
+    EXPECT_EQ(sources[0].checksum, "1111");
+
+    ASSERT_TRUE(catalog.refresh()) << catalog.get_last_error();
+    std::vector<FlatpakPackage> results = catalog.search("calculator", 0);
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].get_app_id(), "org.gnome.Calculator");
+    EXPECT_EQ(results[0].get_repository(), "flathub");
+    EXPECT_EQ(results[0].get_version(), "46.1");
+
+    // A second catalog reuses the index file of the first
+    std::string index_path = dir + "/cache/system-flathub-x86_64.index";
+    struct stat before;
+    ASSERT_EQ(stat(index_path.c_str(), &before), 0);
+    FlatpakAppstreamCatalog second({{dir + "/installation", "system"}}, dir + "/cache", "x86_64");
+    ASSERT_TRUE(second.refresh());
+    struct stat after;
+    ASSERT_EQ(stat(index_path.c_str(), &after), 0);
+    EXPECT_EQ(before.st_ino, after.st_ino);
+
+    // A new appstream commit replaces it
+    deploy_appstream("flathub", "2222",
+                     "<components><component><id>org.kde.kate</id><name>Kate</name>"
+                     "<bundle type=\"flatpak\">app/org.kde.kate/x86_64/stable</bundle></component></components>");
+    ASSERT_TRUE(catalog.refresh());
+    EXPECT_TRUE(catalog.search("calculator", 0).empty());
+    results = catalog.search("kate", 0);
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].get_name(), "Kate");
+}
+
+TEST_F(AppstreamIndexTest, CatalogReadsTheDataAgainOnlyWhenInvalidated) {
+    deploy_appstream("flathub", "1111", kFixture);
+    FlatpakAppstreamCatalog catalog({{dir + "/installation", "system"}}, dir + "/cache", "x86_64");
+    ASSERT_TRUE(catalog.refresh_if_stale());
+    EXPECT_EQ(catalog.search("calculator", 0).size(), 2u);
+
+    // Searches keep the indexes they have until told the data changed
+    deploy_appstream("flathub", "2222",
+                     "<components><component><id>org.kde.kate</id><name>Kate</name>"
+                     "<bundle type=\"flatpak\">app/org.kde.kate/x86_64/stable</bundle></component></components>");
+    ASSERT_TRUE(catalog.refresh_if_stale());
+    EXPECT_EQ(catalog.search("calculator", 0).size(), 2u);
+
+    catalog.invalidate();
+    ASSERT_TRUE(catalog.refresh_if_stale());
+    EXPECT_TRUE(catalog.search("calculator", 0).empty());
+    EXPECT_EQ(catalog.search("kate", 0).size(), 1u);
+}
+
+TEST_F(AppstreamIndexTest, UsesSizeAndTimeWithoutACommitLink) {
+    std::string active = dir + "/installation/appstream/flathub/x86_64/active";
+    ASSERT_TRUE(std::filesystem::create_directories(active));
+    write_gzip(active + "/appstream.xml.gz", kFixture);
+
+    FlatpakAppstreamCatalog catalog({{dir + "/installation", "system"}}, dir + "/cache", "x86_64");
+    std::vector<AppstreamSource> sources = catalog.find_sources();
+    ASSERT_EQ(sources.size(), 1u);
+    struct stat info;
+    ASSERT_EQ(stat(sources[0].file.c_str(), &info), 0);
+    EXPECT_EQ(sources[0].checksum.find(std::to_string(info.st_size) + "-"), 0u);
+}
@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+#include "core/aur_build_cache.hpp"
+#include "temp_dir.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+const char* const kSrcinfo = "pkgbase = foo\n"
+                             "\tpkgver = 1.0\n"
+                             "\tpkgrel = 1\n"
+                             "\tinstall = foo.install\n"
+                             "\tsource = https://example.com/foo-1.0.tar.gz\n"
+                             "\tsource = fix-build.patch\n"
+                             "\tsha256sums = 0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\n"
+                             "\tsha256sums = SKIP\n"
+                             "\n"
+                             "pkgname = foo\n"
+                             "\n"
+                             "pkgname = foo-docs\n";
+
+void write_file(const std::string& path, const std::string& content)
+{
+    std::ofstream(path) << content;
+}
+
+} // namespace
+
+class AurBuildCacheTest : public TempDirTest {
+protected:
+    void SetUp() override {
+        TempDirTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+        checkout = dir + "/foo";
+        mkdir(checkout.c_str(), 0755);
+        write_file(checkout + "/PKGBUILD", "pkgbase=foo\npkgname=(foo foo-docs)\npkgver=1.0\n");
+        write_file(checkout + "/.SRCINFO", kSrcinfo);
+        write_file(checkout + "/fix-build.patch", "--- a\n+++ b\n");
+        write_file(checkout + "/foo.install", "post_install() { :; }\n");
+        write_file(dir + "/makepkg.conf", "CARCH=x86_64\n");
+
+        cache.set_config_files({dir + "/makepkg.conf"});
+    }
+
+    std::string key() {
+        std::string result;
+        EXPECT_TRUE(cache.compute_key(checkout, result)) << cache.get_last_error();
+        return result;
+    }
+
+    // Fake package files as makepkg would leave them in the checkout
+    std::vector<std::string> build(const std::vector<std::string>& names, const std::string& content = "package") {
+        std::vector<std::string> files;
+        for (const auto& name : names) {
+            files.push_back(checkout + "/" + name + "-1.0-1-x86_64.pkg.tar.zst");
+            write_file(files.back(), content);
+        }
+        return files;
+    }
+
+    std::string checkout;
+    AurBuildCache cache{"/nonexistent"};
+};
+
+TEST(AurBuildCachePackageNameTest, ParsesPackageFileNames) {
+    EXPECT_EQ(AurBuildCache::package_name("/dest/foo-bar-1.0-2-x86_64.pkg.tar.zst"), "foo-bar");
+    EXPECT_EQ(AurBuildCache::package_name("foo-1:2.0-1-any.pkg.tar.xz"), "foo");
+    EXPECT_EQ(AurBuildCache::package_name("foo-1.0-1.tar.gz"), "");
+    EXPECT_EQ(AurBuildCache::package_name("-1-x86_64.pkg.tar.zst"), "");
+}
+
+TEST_F(AurBuildCacheTest, KeysCoverEveryBuildInput) {
+    std::string original = key();
+    EXPECT_EQ(original.size(), 64u);
+    EXPECT_EQ(key(), original);
+
+    // Files makepkg does not read leave the key alone
+    write_file(checkout + "/README", "unrelated");
+    build({"foo"});
+    EXPECT_EQ(key(), original);
+
+    write_file(checkout + "/fix-build.patch", "--- a\n+++ c\n");
+    std::string patched = key();
+    EXPECT_NE(patched, original);
+
+    write_file(checkout + "/foo.install", "post_upgrade() { :; }\n");
+    std::string installed = key();
+    EXPECT_NE(installed, patched);
+
+    write_file(dir + "/makepkg.conf", "CARCH=aarch64\n");
+    std::string configured = key();
+    EXPECT_NE(configured, installed);
+
+    write_file(checkout + "/PKGBUILD", "pkgbase=foo\npkgver=1.1\n");
+    EXPECT_NE(key(), configured);
+}
+
+TEST_F(AurBuildCacheTest, DoesNotCacheVcsSources) {
+    write_file(checkout + "/.SRCINFO", "pkgbase = foo-git\n\tsource = foo::git+https://example.com/foo.git\n");
+    std::string result = "stale";
+    EXPECT_FALSE(cache.compute_key(checkout, result));
+    EXPECT_TRUE(result.empty());
+    EXPECT_NE(cache.get_last_error().find("VCS"), std::string::npos);
+
+    EXPECT_FALSE(cache.compute_key(dir + "/missing", result));
+}
+
+TEST_F(AurBuildCacheTest, StoresAndFindsBuilds) {
+    AurBuildCache local(dir + "/cache");
+    local.set_config_files({});
+    std::string build_key;
+    ASSERT_TRUE(local.compute_key(checkout, build_key));
+
+    std::vector<std::string> files;
+    EXPECT_FALSE(local.lookup(build_key, {"foo"}, files));
+
+    ASSERT_TRUE(local.store(build_key, build({"foo", "foo-docs"}))) << local.get_last_error();
+    ASSERT_TRUE(local.lookup(build_key, {"foo-docs", "foo"}, files));
+    EXPECT_EQ(files, (std::vector<std::string>{dir + "/cache/" + build_key + "/foo-docs-1.0-1-x86_64.pkg.tar.zst",
+                                               dir + "/cache/" + build_key + "/foo-1.0-1-x86_64.pkg.tar.zst"}));
+
+    // The cached copy outlives the build directory
+    std::ifstream copy(files[1]);
+    std::string content;
+    std::getline(copy, content);
+    EXPECT_EQ(content, "package");
+
+    EXPECT_FALSE(local.lookup(build_key, {"foo", "foo-extras"}, files));
+    EXPECT_FALSE(local.lookup("../" + build_key, {"foo"}, files));
+    EXPECT_FALSE(local.store("not-a-key", {}));
+}
+
+TEST_F(AurBuildCacheTest, SharesBuildsThroughASharedDirectory) {
+    ASSERT_EQ(mkdir((dir + "/shared").c_str(), 0755), 0);
+    chmod((dir + "/shared").c_str(), 0755);
+
+    AurBuildCache first(dir + "/first");
+    first.set_shared_directory(dir + "/shared", getuid());
+    first.set_config_files({});
+    std::string build_key;
+    ASSERT_TRUE(first.compute_key(checkout, build_key));
+    ASSERT_TRUE(first.store(build_key, build({"foo"})));
+
+    AurBuildCache second(dir + "/second");
+    second.set_shared_directory(dir + "/shared", getuid());
+    std::vector<std::string> files;
+    ASSERT_TRUE(second.lookup(build_key, {"foo"}, files));
+    EXPECT_EQ(files, std::vector<std::string>{dir + "/shared/" + build_key + "/foo-1.0-1-x86_64.pkg.tar.zst"});
+
+    AurBuildCache unshared(dir + "/second");
+    EXPECT_FALSE(unshared.lookup(build_key, {"foo"}, files));
+}
+
+TEST_F(AurBuildCacheTest, IgnoresSharedDirectoryOthersCanWrite) {
+    ASSERT_EQ(mkdir((dir + "/shared").c_str(), 0755), 0);
+    chmod((dir + "/shared").c_str(), 0755);
+
+    AurBuildCache first(dir + "/first");
+    first.set_shared_directory(dir + "/shared", getuid());
+    first.set_config_files({});
+    std::string build_key;
+    ASSERT_TRUE(first.compute_key(checkout, build_key));
+    ASSERT_TRUE(first.store(build_key, build({"foo"})));
+    std::string planted = dir + "/shared/" + build_key + "/foo-1.0-1-x86_64.pkg.tar.zst";
+
+    // Owned by somebody else than the trusted user
+    AurBuildCache other_owner(dir + "/second");
+    other_owner.set_shared_directory(dir + "/shared", getuid() + 1);
+    std::vector<std::string> files;
+    EXPECT_FALSE(other_owner.lookup(build_key, {"foo"}, files));
+
+    // A package file anyone may replace
+    AurBuildCache second(dir + "/second");
+    second.set_shared_directory(dir + "/shared", getuid());
+    chmod(planted.c_str(), 0666);
+    EXPECT_FALSE(second.lookup(build_key, {"foo"}, files));
+    chmod(planted.c_str(), 0644);
+    EXPECT_TRUE(second.lookup(build_key, {"foo"}, files));
+
+    // A directory anyone may add entries to
+    chmod((dir + "/shared").c_str(), 0777);
+    EXPECT_FALSE(second.lookup(build_key, {"foo"}, files));
+}
+
+TEST_F(AurBuildCacheTest, IgnoresSharedDirectoryReachedThroughOthers) {
+    ASSERT_EQ(mkdir((dir + "/shared").c_str(), 0755), 0);
+    chmod((dir + "/shared").c_str(), 0755);
+
+    AurBuildCache first(dir + "/first");
+    first.set_shared_directory(dir + "/shared", getuid());
+    first.set_config_files({});
+    std::string build_key;
+    ASSERT_TRUE(first.compute_key(checkout, build_key));
+    ASSERT_TRUE(first.store(build_key, build({"foo"})));
+
+    // Only the trusted owner writes to the shared directory
+    AurBuildCache reader(dir + "/reader");
+    reader.set_shared_directory(dir + "/shared", getuid() + 1);
+    reader.set_config_files({});
+    ASSERT_TRUE(reader.store(build_key, build({"bar"})));
+    struct stat info;
+    EXPECT_NE(stat((dir + "/shared/" + build_key + "/bar-1.0-1-x86_64.pkg.tar.zst").c_str(), &info), 0);
+
+    // A symbolic link anyone could have pointed elsewhere
+    ASSERT_EQ(symlink((dir + "/shared").c_str(), (dir + "/link").c_str()), 0);
+    AurBuildCache linked(dir + "/second");
+    linked.set_shared_directory(dir + "/link", getuid());
+    std::vector<std::string> files;
+    EXPECT_FALSE(linked.lookup(build_key, {"foo"}, files));
+
+    // A parent anyone may rename the directory in
+    ASSERT_EQ(mkdir((dir + "/open").c_str(), 0755), 0);
+    ASSERT_EQ(rename((dir + "/shared").c_str(), (dir + "/open/shared").c_str()), 0);
+    AurBuildCache nested(dir + "/second");
+    nested.set_shared_directory(dir + "/open/shared", getuid());
+    EXPECT_TRUE(nested.lookup(build_key, {"foo"}, files));
+    chmod((dir + "/open").c_str(), 0777);
+    EXPECT_FALSE(nested.lookup(build_key, {"foo"}, files));
+    chmod((dir + "/open").c_str(), 0755);
+}
+
+TEST_F(AurBuildCacheTest, PrunesBySizeAndAge) {
+    AurBuildCache local(dir + "/cache");
+    time_t now = time(nullptr);
+    const char* keys[] = {"1111111111111111111111111111111111111111111111111111111111111111",
+                          "2222222222222222222222222222222222222222222222222222222222222222",
+                          "3333333333333333333333333333333333333333333333333333333333333333",
+                          "4444444444444444444444444444444444444444444444444444444444444444"};
+    time_t ages[] = {100 * 86400, 3 * 86400, 2 * 86400, 60};
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(local.store(keys[i], build({"foo"}, std::string(1000, 'x'))));
+        struct timespec times[2] = {{now - ages[i], 0}, {now - ages[i], 0}};
+        utimensat(AT_FDCWD, (dir + "/cache/" + keys[i]).c_str(), times, 0);
+    }
+    mkdir((dir + "/cache/not-an-entry").c_str(), 0755);
+
+    std::vector<AurCacheEntry> entries = local.get_entries();
+    ASSERT_EQ(entries.size(), 4u);
+    EXPECT_EQ(entries[0].key, keys[0]);
+    EXPECT_EQ(entries[0].size, 1000u);
+
+    // The expired entry goes first, then the least recently used until 2000 bytes are left
+    EXPECT_EQ(local.prune(2000, 30 * 86400), 2u);
+    entries = local.get_entries();
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].key, keys[2]);
+    EXPECT_EQ(entries[1].key, keys[3]);
+
+    // A lookup counts as a use
+    std::vector<std::string> files;
+    ASSERT_TRUE(local.lookup(keys[2], {"foo"}, files));
+    EXPECT_EQ(local.prune(1000, 0), 1u);
+    entries = local.get_entries();
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].key, keys[2]);
+
+    EXPECT_EQ(local.prune(0, 0), 0u);
+}
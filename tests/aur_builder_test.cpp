@@ -0,0 +1,325 @@
+#include <gtest/gtest.h>
+#include "core/aur_builder.hpp"
+#include "core/aur_build_cache.hpp"
+#include "temp_dir.hpp"
+#include "rpc_stand_in.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// app needs libfoo (split from base foo) to build, libfoo needs libbar
+const char* const kInfoApp = R"({"resultcount":1,"results":[)"
+    R"({"Name":"app","PackageBase":"app","Version":"1.0-1","Depends":["libfoo>=2","glibc"],)"
+    R"("MakeDepends":["cmake"],"CheckDepends":["python-pytest"]})"
+    R"(],"type":"multiinfo","version":5})";
+
+const char* const kInfoLibfoo = R"({"resultcount":1,"results":[)"
+    R"({"Name":"libfoo","PackageBase":"foo","Version":"2.1-1","Depends":["libbar"],"Provides":["libfoo.so=2-64"]})"
+    R"(],"type":"multiinfo","version":5})";
+
+const char* const kInfoLibbar = R"({"resultcount":1,"results":[)"
+    R"({"Name":"libbar","PackageBase":"libbar","Version":"0.3-2","MakeDepends":["cmake"]})"
+    R"(],"type":"multiinfo","version":5})";
+
+const char* const kInfoNone = R"({"resultcount":0,"results":[],"type":"multiinfo","version":5})";
+
+AurDependencyState resolve_system(const std::string& depend)
+{
+    if (depend == "glibc") {
+        return AurDependencyState::INSTALLED;
+    }
+    if (depend == "cmake" || depend == "python-pytest") {
+        return AurDependencyState::REPOSITORY;
+    }
+    return AurDependencyState::MISSING;
+}
+
+// Stands in for makepkg: logs when a build starts and ends, "fails" refuses to build
+const char* const kFakeMakepkg = R"(#!/bin/sh
+base=$(basename "$PWD")
+if [ "$1" = "--packagelist" ]; then
+    for name in $(cat pkgnames); do echo "$PWD/$name-1-1-any.pkg.tar.zst"; done
+    exit 0
+fi
+echo "start $base" >> "$BUILD_LOG"
+echo "building $base"
+sleep 0.3
+if [ "$base" = "fails" ]; then
+    echo "error in $base" >&2
+    exit 4
+fi
+for name in $(cat pkgnames); do touch "$name-1-1-any.pkg.tar.zst"; done
+echo "end $base" >> "$BUILD_LOG"
+)";
+
+AurBuildTarget make_target(const std::string& base, std::vector<std::string> depends_on = {})
+{
+    AurBuildTarget target;
+    target.base = base;
+    target.version = "1-1";
+    target.packages = {base};
+    target.depends_on = std::move(depends_on);
+    return target;
+}
+
+std::vector<std::string> bases(const std::vector<AurBuildTarget>& targets)
+{
+    std::vector<std::string> names;
+    for (const auto& target : targets) {
+        names.push_back(target.base);
+    }
+    return names;
+}
+
+} // namespace
+
+class AurBuilderTest : public TempDirTest {
+protected:
+    void SetUp() override {
+        TempDirTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+        log = dir + "/build.log";
+        makepkg = dir + "/makepkg";
+        std::ofstream(makepkg) << kFakeMakepkg;
+        chmod(makepkg.c_str(), 0755);
+        setenv("BUILD_LOG", log.c_str(), 1);
+
+        server.add_response("/rpc/?v=5&type=info&arg[]=app", kInfoApp);
+        server.add_response("/rpc/?v=5&type=info&arg[]=libfoo", kInfoLibfoo);
+        server.add_response("/rpc/?v=5&type=info&arg[]=libbar", kInfoLibbar);
+        server.add_response("/rpc/?v=5&type=info&arg[]=nope", kInfoNone);
+        server.add_response("/rpc/?v=5&type=info&arg[]=broken", R"({"resultcount":1,"results":[)"
+                            R"({"Name":"broken","PackageBase":"broken","Version":"1-1","Depends":["nope"]})"
+                            R"(],"type":"multiinfo","version":5})");
+    }
+
+    // A git repository like the AUR's, with the package names the fake makepkg builds
+    void add_repository(const std::string& base, const std::vector<std::string>& packages) {
+        std::string repo = dir + "/remote/" + base + ".git";
+        std::string names;
+        for (const auto& name : packages) {
+            names += name + "\n";
+        }
+        std::string command = "mkdir -p '" + repo + "' && cd '" + repo + "' && git init -q && printf '" + names +
+                              "' > pkgnames && printf 'pkgbase = " + base + "\\n' > .SRCINFO && "
+                              "echo pkgbase=" + base + " > PKGBUILD && git add pkgnames .SRCINFO PKGBUILD && "
+                              "git -c user.name=test -c user.email=test@example.com commit -q -m init";
+        ASSERT_EQ(system(command.c_str()), 0);
+    }
+
+    std::vector<std::string> build_log() {
+        std::ifstream file(log);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    RpcStandIn server;
+    AurClient client{server.url()};
+    std::string log;
+    std::string makepkg;
+};
+
+TEST(AurBuilderOrderTest, PutsDependenciesFirst) {
+    std::vector<AurBuildTarget> targets = {make_target("a", {"b"}), make_target("b", {"c"}), make_target("c"),
+                                           make_target("d")};
+    std::string error;
+    ASSERT_TRUE(AurBuilder::order(targets, error)) << error;
+    EXPECT_EQ(bases(targets), (std::vector<std::string>{"c", "b", "a", "d"}));
+}
+
+TEST(AurBuilderOrderTest, DetectsCycles) {
+    std::vector<AurBuildTarget> targets = {make_target("a", {"b"}), make_target("b", {"a"}), make_target("c")};
+    std::string error;
+    EXPECT_FALSE(AurBuilder::order(targets, error));
+    EXPECT_NE(error.find("cycle"), std::string::npos) << error;
+    EXPECT_NE(error.find("a, b"), std::string::npos) << error;
+}
+
+TEST_F(AurBuilderTest, ResolvesTheDependencyGraph) {
+    AurBuilder builder(client, dir + "/build");
+    AurBuildPlan plan;
+    ASSERT_TRUE(builder.resolve({"app"}, resolve_system, plan)) << builder.get_last_error();
+
+    EXPECT_EQ(bases(plan.targets), (std::vector<std::string>{"libbar", "foo", "app"}));
+    EXPECT_EQ(plan.repo_dependencies, (std::vector<std::string>{"cmake", "python-pytest"}));
+
+    const AurBuildTarget& foo = plan.targets[1];
+    EXPECT_EQ(foo.packages, std::vector<std::string>{"libfoo"});
+    EXPECT_EQ(foo.version, "2.1-1");
+    EXPECT_EQ(foo.depends_on, std::vector<std::string>{"libbar"});
+    EXPECT_TRUE(foo.dependency);
+
+    const AurBuildTarget& app = plan.targets[2];
+    EXPECT_EQ(app.depends_on, std::vector<std::string>{"foo"});
+    EXPECT_FALSE(app.dependency);
+
+    // One request per level of the graph
+    EXPECT_EQ(server.request_count(), 3);
+}
+
+TEST_F(AurBuilderTest, ReportsMissingPackages) {
+    AurBuilder builder(client, dir + "/build");
+    AurBuildPlan plan;
+    EXPECT_FALSE(builder.resolve({"nope"}, resolve_system, plan));
+    EXPECT_EQ(builder.get_last_error(), "Package not found in the AUR: nope");
+
+    EXPECT_FALSE(builder.resolve({"broken"}, resolve_system, plan));
+    EXPECT_NE(builder.get_last_error().find("nope of broken"), std::string::npos) << builder.get_last_error();
+}
+
+TEST_F(AurBuilderTest, BuildsIndependentBasesConcurrently) {
+    add_repository("a", {"a"});
+    add_repository("b", {"b", "b-docs"});
+    add_repository("c", {"c"});
+
+    AurBuilder builder(client, dir + "/build");
+    builder.set_git_url("file://" + dir + "/remote");
+    builder.set_makepkg(makepkg);
+    builder.set_jobs(2);
+
+    std::mutex output_mutex;
+    std::vector<std::string> output;
+    builder.set_output_callback([&](const std::string& line) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        output.push_back(line);
+    });
+
+    AurBuildPlan plan;
+    plan.targets = {make_target("a"), make_target("b"), make_target("c", {"a"})};
+    plan.targets[0].dependency = true;
+    plan.targets[1].packages = {"b", "b-docs"};
+    plan.repo_dependencies = {"cmake"};
+
+    std::vector<std::string> repo_installs;
+    std::vector<std::vector<std::string>> installs;
+    std::vector<std::vector<std::string>> dependencies;
+    auto install_repo = [&](const std::vector<std::string>& names) {
+        repo_installs = names;
+        return true;
+    };
+    auto install_files = [&](const std::vector<std::string>& files, const std::vector<std::string>& deps) {
+        std::vector<std::string> names;
+        for (const auto& file : files) {
+            names.push_back(file.substr(file.find_last_of('/') + 1));
+        }
+        installs.push_back(names);
+        dependencies.push_back(deps);
+        return true;
+    };
+
+    ASSERT_TRUE(builder.build(plan, install_repo, install_files)) << builder.get_last_error();
+    EXPECT_EQ(repo_installs, std::vector<std::string>{"cmake"});
+
+    // a and b build side by side, c waits for a to be installed
+    std::vector<std::string> log_lines = build_log();
+    ASSERT_EQ(log_lines.size(), 6u);
+    std::vector<std::string> first_two(log_lines.begin(), log_lines.begin() + 2);
+    std::sort(first_two.begin(), first_two.end());
+    EXPECT_EQ(first_two, (std::vector<std::string>{"start a", "start b"}));
+    EXPECT_EQ(log_lines.back(), "end c");
+
+    ASSERT_EQ(installs.size(), 2u);
+    EXPECT_EQ(installs[0], std::vector<std::string>{"a-1-1-any.pkg.tar.zst"});
+    EXPECT_EQ(dependencies[0].size(), 1u);
+    EXPECT_EQ(installs[1], (std::vector<std::string>{"b-1-1-any.pkg.tar.zst", "b-docs-1-1-any.pkg.tar.zst",
+                                                     "c-1-1-any.pkg.tar.zst"}));
+    EXPECT_TRUE(dependencies[1].empty());
+
+    // Build output is prefixed with the base
+    EXPECT_NE(std::find(output.begin(), output.end(), "[b] building b\n"), output.end());
+
+    // A second run updates the checkouts instead of cloning them again
+    ASSERT_TRUE(builder.build(plan, install_repo, install_files)) << builder.get_last_error();
+    EXPECT_NE(std::find(output.begin(), output.end(), "[a] Updating " + dir + "/build/a\n"), output.end());
+}
+
+TEST_F(AurBuilderTest, SkipsBasesDependingOnFailedBuilds) {
+    add_repository("fails", {"fails"});
+    add_repository("b", {"b"});
+    add_repository("c", {"c"});
+
+    AurBuilder builder(client, dir + "/build");
+    builder.set_git_url("file://" + dir + "/remote");
+    builder.set_makepkg(makepkg);
+    builder.set_jobs(1);
+    builder.set_output_callback([](const std::string&) {});
+
+    AurBuildPlan plan;
+    plan.targets = {make_target("fails"), make_target("c", {"fails"}), make_target("b")};
+
+    std::vector<std::string> installed;
+    auto install_files = [&](const std::vector<std::string>& files, const std::vector<std::string>&) {
+        installed.insert(installed.end(), files.begin(), files.end());
+        return true;
+    };
+
+    EXPECT_FALSE(builder.build(plan, nullptr, install_files));
+    std::string error = builder.get_last_error();
+    EXPECT_NE(error.find("fails: " + makepkg + " exited with status 4"), std::string::npos) << error;
+    EXPECT_NE(error.find("c skipped"), std::string::npos) << error;
+
+    ASSERT_EQ(installed.size(), 1u);
+    EXPECT_EQ(installed[0], dir + "/build/b/b-1-1-any.pkg.tar.zst");
+}
+
+TEST_F(AurBuilderTest, FailsForMissingRepositories) {
+    AurBuilder builder(client, dir + "/build");
+    builder.set_git_url("file://" + dir + "/remote");
+    builder.set_output_callback([](const std::string&) {});
+
+    AurBuildPlan plan;
+    plan.targets = {make_target("missing")};
+    EXPECT_FALSE(builder.build(plan, nullptr, nullptr));
+    EXPECT_NE(builder.get_last_error().find("missing: git exited with status"), std::string::npos)
+        << builder.get_last_error();
+}
+
+TEST_F(AurBuilderTest, ReusesCachedBuilds) {
+    add_repository("a", {"a"});
+    add_repository("b", {"b"});
+
+    AurBuildCache cache(dir + "/cache");
+    cache.set_config_files({});
+    AurBuilder builder(client, dir + "/build");
+    builder.set_git_url("file://" + dir + "/remote");
+    builder.set_makepkg(makepkg);
+    builder.set_cache(&cache);
+    builder.set_output_callback([](const std::string&) {});
+
+    AurBuildPlan plan;
+    plan.targets = {make_target("a"), make_target("b", {"a"})};
+
+    std::vector<std::string> installed;
+    auto install_files = [&](const std::vector<std::string>& files, const std::vector<std::string>&) {
+        installed.insert(installed.end(), files.begin(), files.end());
+        return true;
+    };
+
+    ASSERT_TRUE(builder.build(plan, nullptr, install_files)) << builder.get_last_error();
+    EXPECT_EQ(build_log().size(), 4u);
+    EXPECT_EQ(cache.get_entries().size(), 2u);
+
+    // Nothing is built again, b still waits for a to be installed
+    installed.clear();
+    ASSERT_TRUE(builder.build(plan, nullptr, install_files)) << builder.get_last_error();
+    EXPECT_EQ(build_log().size(), 4u);
+    ASSERT_EQ(installed.size(), 2u);
+    EXPECT_EQ(installed[0].compare(0, dir.size() + 7, dir + "/cache/"), 0) << installed[0];
+    EXPECT_EQ(AurBuildCache::package_name(installed[0]), "a");
+    EXPECT_EQ(AurBuildCache::package_name(installed[1]), "b");
+}
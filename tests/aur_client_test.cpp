@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include "core/aur_client.hpp"
+#include "rpc_stand_in.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// Responses recorded from aur.archlinux.org, trimmed to a few packages
+const char* const kSearchYay = R"({"resultcount":2,"results":[)"
+    R"({"Description":"Yet another yogurt. Pacman wrapper and AUR helper written in go.","FirstSubmitted":1475688004,)"
+    R"("ID":1424916,"LastModified":1700143521,"Maintainer":"jguer","Name":"yay","NumVotes":2345,"OutOfDate":null,)"
+    R"("PackageBase":"yay","PackageBaseID":115973,"Popularity":29.88,"URL":"https://github.com/Jguer/yay",)"
+    R"("URLPath":"/cgit/aur.git/snapshot/yay.tar.gz","Version":"12.3.5-1"},)"
+    R"({"Description":"Yet another yogurt. Pacman wrapper and AUR helper written in go. Pre-compiled.",)"
+    R"("FirstSubmitted":1478965454,"ID":1424917,"LastModified":1700143590,"Maintainer":null,"Name":"yay-bin",)"
+    R"("NumVotes":469,"OutOfDate":1700200000,"PackageBase":"yay-bin","PackageBaseID":116686,"Popularity":7.5,)"
+    R"("URL":"https://github.com/Jguer/yay","URLPath":"/cgit/aur.git/snapshot/yay-bin.tar.gz","Version":"12.3.5-1"})"
+    R"(],"type":"search","version":5})";
+
+const char* const kInfo = R"({"resultcount":2,"results":[)"
+    R"({"Conflicts":["yay-bin"],"Depends":["pacman>6.1","git"],"Description":"Yet another \"yogurt\"",)"
+    R"("FirstSubmitted":1475688004,"ID":1424916,"Keywords":["arm","AUR","go","helper"],"LastModified":1700143521,)"
+    R"("License":["GPL-3.0-or-later"],"Maintainer":"jguer","MakeDepends":["go>=1.21"],"Name":"yay","NumVotes":2345,)"
+    R"("OutOfDate":null,"PackageBase":"yay","PackageBaseID":115973,"Popularity":29.88,)"
+    R"("URL":"https://github.com/Jguer/yay","URLPath":"/cgit/aur.git/snapshot/yay.tar.gz","Version":"12.3.5-1"},)"
+    R"({"CheckDepends":["python-pytest"],"Depends":["python"],"Description":"Café 😀 tool",)"
+    R"("FirstSubmitted":1500000000,"ID":99,"LastModified":1600000000,"License":["MIT"],"Maintainer":"someone",)"
+    R"("MakeDepends":["python-build","python-installer"],"Name":"python-cafe","NumVotes":3,)"
+    R"("OptDepends":["python-rich: colored output"],"OutOfDate":null,"PackageBase":"python-cafe","PackageBaseID":98,)"
+    R"("Popularity":0.01,"Provides":["cafe"],"URL":null,"URLPath":"/cgit/aur.git/snapshot/python-cafe.tar.gz","Version":"1.0-2"})"
+    R"(],"type":"multiinfo","version":5})";
+
+const char* const kTooSmall = R"({"error":"Query arg too small.","resultcount":0,"results":[],"type":"error","version":5})";
+
+const char* const kEmpty = R"({"resultcount":0,"results":[],"type":"search","version":5})";
+
+} // namespace
+
+class AurClientTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        server.add_response("/rpc/?v=5&type=search&by=name-desc&arg=yay", kSearchYay);
+        server.add_response("/rpc/?v=5&type=search&by=maintainer&arg=jguer", kSearchYay);
+        server.add_response("/rpc/?v=5&type=search&by=depends&arg=pacman", kSearchYay);
+        server.add_response("/rpc/?v=5&type=search&by=name&arg=no%20such%20package", kEmpty);
+        server.add_response("/rpc/?v=5&type=search&by=name-desc&arg=y", kTooSmall);
+        server.add_response("/rpc/?v=5&type=info&arg[]=yay&arg[]=python-cafe&arg[]=missing", kInfo);
+    }
+
+    RpcStandIn server;
+};
+
+TEST_F(AurClientTest, SearchParsesPackages) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    ASSERT_TRUE(client.search("yay", AurSearchField::NAME_DESC, results)) << client.get_last_error();
+
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].name, "yay");
+    EXPECT_EQ(results[0].version, "12.3.5-1");
+    EXPECT_EQ(results[0].maintainer, "jguer");
+    EXPECT_EQ(results[0].num_votes, 2345u);
+    EXPECT_DOUBLE_EQ(results[0].popularity, 29.88);
+    EXPECT_EQ(results[0].out_of_date, 0);
+    EXPECT_EQ(results[0].last_modified, 1700143521);
+    EXPECT_EQ(results[0].url_path, "/cgit/aur.git/snapshot/yay.tar.gz");
+
+    EXPECT_EQ(results[1].name, "yay-bin");
+    EXPECT_TRUE(results[1].maintainer.empty());
+    EXPECT_EQ(results[1].out_of_date, 1700200000);
+}
+
+TEST_F(AurClientTest, InfoRequestsSeveralPackagesAtOnce) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    ASSERT_TRUE(client.info({"yay", "python-cafe", "missing"}, results)) << client.get_last_error();
+    EXPECT_EQ(server.request_count(), 1);
+
+    ASSERT_EQ(results.size(), 2u);
+    const AurPackage& yay = results[0];
+    EXPECT_EQ(yay.description, "Yet another \"yogurt\"");
+    EXPECT_EQ(yay.depends, (std::vector<std::string>{"pacman>6.1", "git"}));
+    EXPECT_EQ(yay.make_depends, std::vector<std::string>{"go>=1.21"});
+    EXPECT_EQ(yay.conflicts, std::vector<std::string>{"yay-bin"});
+    EXPECT_EQ(yay.licenses, std::vector<std::string>{"GPL-3.0-or-later"});
+    EXPECT_EQ(yay.keywords.size(), 4u);
+
+    const AurPackage& cafe = results[1];
+    EXPECT_EQ(cafe.description, "Caf\xC3\xA9 \xF0\x9F\x98\x80 tool");
+    EXPECT_EQ(cafe.check_depends, std::vector<std::string>{"python-pytest"});
+    EXPECT_EQ(cafe.opt_depends, std::vector<std::string>{"python-rich: colored output"});
+    EXPECT_EQ(cafe.provides, std::vector<std::string>{"cafe"});
+    EXPECT_TRUE(cafe.url.empty());
+    EXPECT_TRUE(cafe.depends.size() == 1 && cafe.depends[0] == "python");
+}
+
+TEST_F(AurClientTest, SplitsLongInfoRequests) {
+    std::vector<std::string> names;
+    for (int i = 0; i < 500; ++i) {
+        names.push_back("some-rather-long-package-name-" + std::to_string(i));
+    }
+
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    ASSERT_TRUE(client.info(names, results)) << client.get_last_error();
+
+    // Responses are merged in request order
+    ASSERT_EQ(results.size(), names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        EXPECT_EQ(results[i].name, names[i]);
+    }
+
+    std::vector<std::string> targets = server.targets();
+    EXPECT_GT(targets.size(), 1u);
+    EXPECT_EQ(static_cast<int>(targets.size()), server.request_count());
+    for (const std::string& target : targets) {
+        EXPECT_LE(server.url().size() - 5 + target.size(), AurClient::kMaxUrlLength);
+    }
+
+    // A second round reuses the connections of the first
+    int connections = server.connection_count();
+    ASSERT_TRUE(client.info(names, results));
+    EXPECT_EQ(server.connection_count(), connections);
+}
+
+TEST_F(AurClientTest, InfoWithoutNames) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results(1);
+    EXPECT_TRUE(client.info({}, results));
+    EXPECT_TRUE(results.empty());
+    EXPECT_EQ(server.request_count(), 0);
+}
+
+TEST_F(AurClientTest, SearchesByField) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    EXPECT_TRUE(client.search("jguer", AurSearchField::MAINTAINER, results));
+    EXPECT_EQ(results.size(), 2u);
+    EXPECT_TRUE(client.search("pacman", AurSearchField::DEPENDS, results));
+    EXPECT_EQ(results.size(), 2u);
+
+    EXPECT_TRUE(client.search("no such package", AurSearchField::NAME, results)) << client.get_last_error();
+    EXPECT_TRUE(results.empty());
+}
+
+TEST_F(AurClientTest, ReusesTheConnectionWithGzip) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(client.search("yay", AurSearchField::NAME_DESC, results)) << client.get_last_error();
+        ASSERT_EQ(results.size(), 2u);
+    }
+
+    EXPECT_EQ(server.request_count(), 5);
+    EXPECT_EQ(server.connection_count(), 1);
+    EXPECT_EQ(server.gzip_count(), 5);
+}
+
+TEST_F(AurClientTest, ReportsRpcErrors) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    EXPECT_FALSE(client.search("y", AurSearchField::NAME_DESC, results));
+    EXPECT_EQ(client.get_last_error(), "AUR error: Query arg too small.");
+    EXPECT_TRUE(results.empty());
+}
+
+TEST_F(AurClientTest, ReportsHttpErrors) {
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    EXPECT_FALSE(client.search("unknown", AurSearchField::NAME, results));
+    EXPECT_NE(client.get_last_error().find("404"), std::string::npos) << client.get_last_error();
+
+    // A failed request leaves the connection usable
+    EXPECT_TRUE(client.search("yay", AurSearchField::NAME_DESC, results));
+    EXPECT_EQ(results.size(), 2u);
+}
+
+TEST_F(AurClientTest, ReportsMalformedResponses) {
+    server.add_response("/rpc/?v=5&type=search&by=name&arg=broken", R"({"resultcount":1,"results":[{"Name":"x",)");
+    AurClient client(server.url());
+    std::vector<AurPackage> results;
+    EXPECT_FALSE(client.search("broken", AurSearchField::NAME, results));
+    EXPECT_NE(client.get_last_error().find("Invalid AUR response"), std::string::npos) << client.get_last_error();
+    EXPECT_TRUE(results.empty());
+}
+
+TEST_F(AurClientTest, ReportsConnectionFailures) {
+    AurClient client("http://127.0.0.1:1/rpc/");
+    std::vector<AurPackage> results;
+    EXPECT_FALSE(client.search("yay", AurSearchField::NAME, results));
+    EXPECT_NE(client.get_last_error().find("AUR request failed"), std::string::npos) << client.get_last_error();
+}
+
+TEST(AurPackageTest, ConvertsToPackage) {
+    AurPackage aur;
+    aur.name = "yay";
+    aur.version = "12.3.5-1";
+    aur.description = "AUR helper";
+
+    Package package = aur.to_package();
+    EXPECT_EQ(package.get_name(), "yay");
+    EXPECT_EQ(package.get_version(), "12.3.5-1");
+    EXPECT_EQ(package.get_description(), "AUR helper");
+    EXPECT_EQ(package.get_repository(), "aur");
+}
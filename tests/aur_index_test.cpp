@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include "core/aur_index.hpp"
+#include "temp_dir.hpp"
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// Same layout as packages-meta-ext-v1.json.gz, trimmed to a few packages
+const char* const kDump = R"([
+{"ID":1,"Name":"yay","PackageBaseID":115973,"PackageBase":"yay","Version":"12.3.5-1",
+ "Description":"Yet another yogurt. Pacman wrapper and AUR helper written in go.","URL":"https://github.com/Jguer/yay",
+ "NumVotes":2345,"Popularity":29.88,"OutOfDate":null,"Maintainer":"jguer","FirstSubmitted":1475688004,
+ "LastModified":1700143521,"URLPath":"/cgit/aur.git/snapshot/yay.tar.gz",
+ "Depends":["pacman>6.1","git"],"MakeDepends":["go>=1.21"],"Conflicts":["yay-bin"],"License":["GPL-3.0-or-later"]},
+{"ID":2,"Name":"yay-bin","PackageBaseID":116686,"PackageBase":"yay-bin","Version":"12.3.5-1",
+ "Description":"Pre-compiled yay","URL":"https://github.com/Jguer/yay","NumVotes":469,"Popularity":7.5,
+ "OutOfDate":1700200000,"Maintainer":null,"FirstSubmitted":1478965454,"LastModified":1700143590,
+ "URLPath":"/cgit/aur.git/snapshot/yay-bin.tar.gz","Depends":["pacman>6.1","git"],"Provides":["yay"],"Conflicts":["yay"]},
+{"ID":3,"Name":"paru","PackageBaseID":150000,"PackageBase":"paru","Version":"2.0.3-1",
+ "Description":"Feature packed AUR helper","URL":"https://github.com/morganamilo/paru","NumVotes":600,"Popularity":15.2,
+ "OutOfDate":null,"Maintainer":"Morganamilo","FirstSubmitted":1600000000,"LastModified":1710000000,
+ "URLPath":"/cgit/aur.git/snapshot/paru.tar.gz","Depends":["git","pacman"],"MakeDepends":["cargo"]},
+{"ID":4,"Name":"python-yaypy","PackageBaseID":160000,"PackageBase":"python-yaypy","Version":"0.1-1",
+ "Description":"Python bindings","NumVotes":0,"Popularity":0,"OutOfDate":null,"Maintainer":"someone",
+ "FirstSubmitted":1600000000,"LastModified":1600000000,"URLPath":"/cgit/aur.git/snapshot/python-yaypy.tar.gz",
+ "OptDepends":["python-rich: colored output"],"CheckDepends":["python-pytest"]}
+])";
+
+void write_gzip(const std::string& path, const std::string& content)
+{
+    gzFile file = gzopen(path.c_str(), "wb");
+    gzwrite(file, content.data(), static_cast<unsigned>(content.size()));
+    gzclose(file);
+}
+
+void set_mtime(const std::string& path, time_t mtime)
+{
+    struct timeval times[2] = {{mtime, 0}, {mtime, 0}};
+    utimes(path.c_str(), times);
+}
+
+ino_t inode_of(const std::string& path)
+{
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? info.st_ino : 0;
+}
+
+} // namespace
+
+class AurIndexTest : public TempDirTest {
+protected:
+    void SetUp() override {
+        TempDirTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+        dump = dir + "/packages-meta-ext-v1.json.gz";
+        index_path = dir + "/cache/aur.index";
+        write_gzip(dump, kDump);
+        set_mtime(dump, 1700000000);
+    }
+
+    std::string dump_url() const { return "file://" + dump; }
+
+    std::string dump;
+    std::string index_path;
+};
+
+TEST_F(AurIndexTest, RefreshBuildsTheIndex) {
+    AurIndex index(index_path);
+    EXPECT_FALSE(index.open());
+
+    ASSERT_TRUE(index.refresh(dump_url())) << index.get_last_error();
+    EXPECT_TRUE(index.is_open());
+    EXPECT_EQ(index.size(), 4u);
+    EXPECT_EQ(index.get_source_time(), 1700000000);
+
+    AurPackage yay;
+    ASSERT_TRUE(index.find("yay", yay));
+    EXPECT_EQ(yay.version, "12.3.5-1");
+    EXPECT_EQ(yay.maintainer, "jguer");
+    EXPECT_EQ(yay.num_votes, 2345u);
+    EXPECT_DOUBLE_EQ(yay.popularity, 29.88);
+    EXPECT_EQ(yay.depends, (std::vector<std::string>{"pacman>6.1", "git"}));
+    EXPECT_EQ(yay.make_depends, std::vector<std::string>{"go>=1.21"});
+    EXPECT_EQ(yay.conflicts, std::vector<std::string>{"yay-bin"});
+    EXPECT_EQ(yay.url_path, "/cgit/aur.git/snapshot/yay.tar.gz");
+
+    AurPackage yay_bin;
+    ASSERT_TRUE(index.find("yay-bin", yay_bin));
+    EXPECT_TRUE(yay_bin.maintainer.empty());
+    EXPECT_EQ(yay_bin.out_of_date, 1700200000);
+    EXPECT_EQ(yay_bin.provides, std::vector<std::string>{"yay"});
+
+    AurPackage missing;
+    EXPECT_FALSE(index.find("ya", missing));
+    EXPECT_FALSE(index.find("zzz", missing));
+}
+
+TEST_F(AurIndexTest, ReopensWithoutParsing) {
+    {
+        AurIndex index(index_path);
+        ASSERT_TRUE(index.refresh(dump_url()));
+    }
+    ASSERT_EQ(unlink(dump.c_str()), 0);
+
+    AurIndex index(index_path);
+    ASSERT_TRUE(index.open()) << index.get_last_error();
+    EXPECT_EQ(index.size(), 4u);
+
+    AurPackage package;
+    ASSERT_TRUE(index.find("python-yaypy", package));
+    EXPECT_EQ(package.check_depends, std::vector<std::string>{"python-pytest"});
+    EXPECT_EQ(package.opt_depends, std::vector<std::string>{"python-rich: colored output"});
+}
+
+TEST_F(AurIndexTest, SearchRanksNameMatchesFirst) {
+    AurIndex index(index_path);
+    ASSERT_TRUE(index.refresh(dump_url()));
+
+    std::vector<AurPackage> results = index.search("YAY");
+    std::vector<std::string> names;
+    for (const AurPackage& package : results) {
+        names.push_back(package.name);
+    }
+    // Exact, prefix, substring, then "yay" only in the description
+    EXPECT_EQ(names, (std::vector<std::string>{"yay", "yay-bin", "python-yaypy"}));
+
+    results = index.search("aur helper");
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].name, "yay");
+    EXPECT_EQ(results[1].name, "paru");
+
+    EXPECT_TRUE(index.search("aur helper", false).empty());
+    EXPECT_EQ(index.search("yay", true, 1).size(), 1u);
+    EXPECT_EQ(index.search("BINDINGS").size(), 1u);
+    EXPECT_TRUE(index.search("go").empty());
+    EXPECT_TRUE(index.search("").empty());
+}
+
+TEST_F(AurIndexTest, SearchFindsNamesThroughTrigrams) {
+    AurIndex index(index_path);
+    ASSERT_TRUE(index.refresh(dump_url()));
+
+    auto names = [&index](const std::string& term) {
+        std::vector<std::string> found;
+        for (const AurPackage& package : index.search(term, false)) {
+            found.push_back(package.name);
+        }
+        return found;
+    };
+    // Too short to search, only an exact name would match
+    EXPECT_TRUE(names("ru").empty());
+    EXPECT_EQ(names("AYPY"), std::vector<std::string>{"python-yaypy"});
+    EXPECT_EQ(names("yay-"), std::vector<std::string>{"yay-bin"});
+    EXPECT_TRUE(names("yaypyz").empty());
+    EXPECT_TRUE(names("unknown").empty());
+}
+
+TEST_F(AurIndexTest, UnchangedDumpIsNotReread) {
+    AurIndex index(index_path);
+    ASSERT_TRUE(index.refresh(dump_url()));
+    ino_t built = inode_of(index_path);
+
+    ASSERT_TRUE(index.refresh(dump_url())) << index.get_last_error();
+    EXPECT_EQ(inode_of(index_path), built);
+
+    // A new dump replaces the index
+    std::string updated = kDump;
+    updated.replace(updated.find("12.3.5-1"), 8, "12.4.0-1");
+    write_gzip(dump, updated);
+    set_mtime(dump, 1700086400);
+
+    ASSERT_TRUE(index.refresh(dump_url())) << index.get_last_error();
+    EXPECT_NE(inode_of(index_path), built);
+    EXPECT_EQ(index.get_source_time(), 1700086400);
+
+    AurPackage yay;
+    ASSERT_TRUE(index.find("yay", yay));
+    EXPECT_EQ(yay.version, "12.4.0-1");
+}
+
+TEST_F(AurIndexTest, BuildsFromPlainJson) {
+    std::string plain = dir + "/dump.json";
+    std::ofstream(plain) << kDump;
+
+    AurIndex index(index_path);
+    ASSERT_TRUE(index.build(plain)) << index.get_last_error();
+    EXPECT_EQ(index.size(), 4u);
+}
+
+TEST_F(AurIndexTest, KeepsTheOldIndexOnErrors) {
+    AurIndex index(index_path);
+    ASSERT_TRUE(index.refresh(dump_url()));
+
+    write_gzip(dump, std::string(kDump).substr(0, 400));
+    set_mtime(dump, 1700086400);
+    EXPECT_FALSE(index.refresh(dump_url()));
+    EXPECT_NE(index.get_last_error().find("Invalid dump"), std::string::npos) << index.get_last_error();
+
+    EXPECT_FALSE(index.refresh("file://" + dir + "/missing.json.gz"));
+    EXPECT_EQ(index.size(), 4u);
+
+    AurIndex reopened(index_path);
+    ASSERT_TRUE(reopened.open());
+    EXPECT_EQ(reopened.size(), 4u);
+}
+
+TEST_F(AurIndexTest, RejectsDamagedIndex) {
+    {
+        AurIndex index(index_path);
+        ASSERT_TRUE(index.refresh(dump_url()));
+    }
+    ASSERT_EQ(truncate(index_path.c_str(), 100), 0);
+
+    AurIndex index(index_path);
+    EXPECT_FALSE(index.open());
+    EXPECT_FALSE(index.is_open());
+    EXPECT_TRUE(index.search("yay").empty());
+}
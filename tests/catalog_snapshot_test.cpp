@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "core/catalog_snapshot.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+std::shared_ptr<const RepositoryCatalog> make_repo(const std::string& name, bool local, int count) {
+    auto repo = std::make_shared<RepositoryCatalog>(name, local);
+    for (int i = 0; i < count; ++i) {
+        repo->add(name + "-pkg-" + std::to_string(i), "1." + std::to_string(i % 7) + "-1",
+                  "Package number " + std::to_string(i));
+    }
+    return repo;
+}
+
+} // namespace
+
+class CatalogSnapshotTest : public TempDirTest {
+protected:
+    void SetUp() override {
+        TempDirTest::SetUp();
+        if (HasFatalFailure()) {
+            return;
+        }
+        path = dir + "/cache/pacmangui/catalog.snapshot";
+
+        catalog = std::make_shared<const PackageCatalog>(
+            1, make_repo("local", true, 50),
+            std::vector<PackageCatalog::RepositoryPtr>{make_repo("core", false, 200), make_repo("extra", false, 500)});
+        stamps = {{"local", 100, 0}, {"core", 200, 4096}, {"extra", 300, 8192}};
+    }
+
+    std::string path;
+    std::shared_ptr<const PackageCatalog> catalog;
+    std::vector<DatabaseStamp> stamps;
+};
+
+TEST_F(CatalogSnapshotTest, RoundTripKeepsPackagesAndFingerprints) {
+    CatalogSnapshot snapshot(path);
+    ASSERT_TRUE(snapshot.save(*catalog, stamps)) << snapshot.get_last_error();
+
+    std::shared_ptr<const PackageCatalog> loaded = snapshot.load(stamps, 7);
+    ASSERT_NE(loaded, nullptr) << snapshot.get_last_error();
+    EXPECT_EQ(loaded->get_generation(), 7u);
+    EXPECT_EQ(loaded->size(), catalog->size());
+    ASSERT_NE(loaded->get_local(), nullptr);
+    EXPECT_EQ(loaded->get_local()->get_fingerprint(), catalog->get_local()->get_fingerprint());
+    ASSERT_EQ(loaded->get_sync().size(), 2u);
+    EXPECT_EQ(loaded->get_sync()[1]->get_name(), "extra");
+    EXPECT_EQ(loaded->get_sync()[1]->get_fingerprint(), catalog->get_sync()[1]->get_fingerprint());
+
+    std::optional<PackageView> view = loaded->find("core-pkg-42");
+    ASSERT_TRUE(view.has_value());
+    EXPECT_EQ(view->version, "1.0-1");
+    EXPECT_EQ(view->description, "Package number 42");
+    EXPECT_EQ(view->repository, "core");
+    EXPECT_TRUE(loaded->is_installed("local-pkg-3"));
+    EXPECT_FALSE(loaded->is_installed("core-pkg-3"));
+}
+
+TEST_F(CatalogSnapshotTest, RejectsChangedDatabases) {
+    CatalogSnapshot snapshot(path);
+    ASSERT_TRUE(snapshot.save(*catalog, stamps));
+
+    std::vector<DatabaseStamp> refreshed = stamps;
+    refreshed[2].mtime += 1;
+    EXPECT_EQ(snapshot.load(refreshed, 2), nullptr);
+
+    std::vector<DatabaseStamp> fewer(stamps.begin(), stamps.end() - 1);
+    EXPECT_EQ(snapshot.load(fewer, 2), nullptr);
+}
+
+TEST_F(CatalogSnapshotTest, RejectsTruncatedFile) {
+    CatalogSnapshot snapshot(path);
+    ASSERT_TRUE(snapshot.save(*catalog, stamps));
+
+    std::ifstream in(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << data.substr(0, data.size() / 2);
+
+    EXPECT_EQ(snapshot.load(stamps, 2), nullptr);
+}
+
+TEST_F(CatalogSnapshotTest, RejectsForeignFile) {
+    CatalogSnapshot snapshot(dir + "/other");
+    std::ofstream(dir + "/other") << "not a snapshot at all";
+    EXPECT_EQ(snapshot.load(stamps, 2), nullptr);
+}
+
+TEST_F(CatalogSnapshotTest, MissingFileIsNotAnError) {
+    CatalogSnapshot snapshot(path);
+    EXPECT_EQ(snapshot.load(stamps, 2), nullptr);
+    EXPECT_FALSE(snapshot.get_last_error().empty());
+}
+
+TEST_F(CatalogSnapshotTest, SaveReplacesPreviousSnapshot) {
+    CatalogSnapshot snapshot(path);
+    ASSERT_TRUE(snapshot.save(*catalog, stamps));
+
+    PackageCatalog smaller(2, make_repo("local", true, 5), {make_repo("core", false, 10), make_repo("extra", false, 10)});
+    ASSERT_TRUE(snapshot.save(smaller, stamps));
+
+    std::shared_ptr<const PackageCatalog> loaded = snapshot.load(stamps, 3);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(loaded->size(), 25u);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "core/directory_size.hpp"
+#include "core/thread_pool.hpp"
+#include "temp_dir.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace pacmangui::core;
+
+class DirectorySizeTest : public TempDirTest {
+protected:
+    void write(const std::string& path, size_t size) {
+        std::ofstream(dir + "/" + path) << std::string(size, 'x');
+    }
+
+    // What du -s reports for the tree, in bytes
+    uint64_t du(const std::string& path) {
+        std::string command = "du -s -B1 '" + path + "'";
+        FILE* pipe = popen(command.c_str(), "r");
+        unsigned long long bytes = 0;
+        EXPECT_EQ(fscanf(pipe, "%llu", &bytes), 1);
+        pclose(pipe);
+        return bytes;
+    }
+};
+
+TEST_F(DirectorySizeTest, MatchesDuAcrossLevels) {
+    ASSERT_EQ(mkdir((dir + "/config").c_str(), 0755), 0);
+    ASSERT_EQ(mkdir((dir + "/cache").c_str(), 0755), 0);
+    ASSERT_EQ(mkdir((dir + "/cache/fontconfig").c_str(), 0755), 0);
+    write("config/settings.ini", 300);
+    write("cache/fontconfig/cache-1", 70000);
+    write("cache/fontconfig/cache-2", 5000);
+    ASSERT_EQ(link((dir + "/cache/fontconfig/cache-1").c_str(), (dir + "/config/linked").c_str()), 0);
+    ASSERT_EQ(symlink("/usr", (dir + "/config/usr").c_str()), 0);
+
+    ThreadPool pool(4);
+    DirectorySizeWalker walker(&pool);
+    DirectoryUsage usage;
+    ASSERT_TRUE(walker.measure(dir, usage)) << walker.get_last_error();
+
+    // The hard link is counted once and the symlink is not followed
+    EXPECT_EQ(usage.bytes, du(dir));
+    EXPECT_EQ(usage.directories, 4u);
+    EXPECT_EQ(usage.files, 5u);
+    EXPECT_EQ(usage.unreadable, 0u);
+}
+
+TEST_F(DirectorySizeTest, RefusesMissingRootsAndFiles) {
+    DirectorySizeWalker walker;
+    DirectoryUsage usage;
+    EXPECT_FALSE(walker.measure(dir + "/missing", usage));
+    EXPECT_NE(walker.get_last_error().find("missing"), std::string::npos);
+
+    write("file", 10);
+    EXPECT_FALSE(walker.measure(dir + "/file", usage));
+}
+
+TEST_F(DirectorySizeTest, StopsWhenCancelled) {
+    ASSERT_EQ(mkdir((dir + "/data").c_str(), 0755), 0);
+    write("data/file", 10);
+
+    std::atomic<bool> cancelled(true);
+    DirectorySizeWalker walker;
+    DirectoryUsage usage;
+    EXPECT_FALSE(walker.measure(dir, usage, &cancelled));
+
+    cancelled = false;
+    EXPECT_TRUE(walker.measure(dir, usage, &cancelled));
+    EXPECT_EQ(usage.files, 1u);
+}
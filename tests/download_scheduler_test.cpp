@@ -0,0 +1,382 @@
+#include <gtest/gtest.h>
+#include "core/download_scheduler.hpp"
+#include "temp_dir.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+/**
+ * @brief Minimal HTTP/1.0 server serving canned files from memory
+ *
+ * Supports "Range: bytes=N-" and answers 304 to If-Modified-Since, which is
+ * all the scheduler relies on. Every connection is handled on its own thread
+ * so the number of concurrent downloads can be observed.
+ */
+class CannedHttpServer {
+public:
+    explicit CannedHttpServer(int delay_ms = 0) : m_delay_ms(delay_ms) {
+        m_socket = socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(m_socket, 64);
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_socket, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+
+        m_acceptor = std::thread([this]() { accept_loop(); });
+    }
+
+    ~CannedHttpServer() {
+        m_stopping = true;
+        shutdown(m_socket, SHUT_RDWR);
+        close(m_socket);
+        m_acceptor.join();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    void add_file(const std::string& path, const std::string& content) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_files[path] = content;
+    }
+
+    std::string url(const std::string& path = "") const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + path;
+    }
+
+    int max_concurrent() const { return m_max_active; }
+    int request_count() const { return m_requests; }
+
+    std::vector<std::string> ranges() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_ranges;
+    }
+
+private:
+    void accept_loop() {
+        while (!m_stopping) {
+            int client = accept(m_socket, nullptr, nullptr);
+            if (client < 0) {
+                break;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_workers.emplace_back([this, client]() { handle(client); });
+        }
+    }
+
+    void handle(int client) {
+        int active = ++m_active;
+        int seen = m_max_active;
+        while (active > seen && !m_max_active.compare_exchange_weak(seen, active)) {
+        }
+        ++m_requests;
+
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                break;
+            }
+            request.append(buffer, n);
+        }
+
+        std::istringstream stream(request);
+        std::string method, path, line;
+        stream >> method >> path;
+        std::getline(stream, line);
+
+        size_t offset = 0;
+        bool conditional = false;
+        while (std::getline(stream, line) && line != "\r") {
+            if (line.rfind("Range: bytes=", 0) == 0) {
+                offset = std::stoul(line.substr(13));
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_ranges.push_back(line.substr(13, line.find('\r') - 13));
+            } else if (line.rfind("If-Modified-Since:", 0) == 0) {
+                conditional = true;
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_delay_ms));
+
+        std::string content;
+        bool found;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_files.find(path);
+            found = it != m_files.end();
+            if (found) {
+                content = it->second;
+            }
+        }
+
+        std::string response;
+        if (!found) {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        } else if (conditional) {
+            response = "HTTP/1.0 304 Not Modified\r\n\r\n";
+        } else if (offset > 0 && offset < content.size()) {
+            response = "HTTP/1.0 206 Partial Content\r\nContent-Length: " +
+                       std::to_string(content.size() - offset) + "\r\nContent-Range: bytes " +
+                       std::to_string(offset) + "-" + std::to_string(content.size() - 1) + "/" +
+                       std::to_string(content.size()) + "\r\n\r\n" + content.substr(offset);
+        } else if (offset > 0) {
+            response = "HTTP/1.0 416 Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n";
+        } else {
+            response = "HTTP/1.0 200 OK\r\nContent-Length: " + std::to_string(content.size()) +
+                       "\r\nLast-Modified: Mon, 01 Jan 2024 00:00:00 GMT\r\n\r\n" + content;
+        }
+
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+
+        --m_active;
+        close(client);
+    }
+
+    int m_socket = -1;
+    int m_port = 0;
+    int m_delay_ms;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<int> m_active{0};
+    std::atomic<int> m_max_active{0};
+    std::atomic<int> m_requests{0};
+    std::thread m_acceptor;
+    std::mutex m_mutex;
+    std::vector<std::thread> m_workers;
+    std::map<std::string, std::string> m_files;
+    std::vector<std::string> m_ranges;
+};
+
+std::string canned_package(size_t size, char seed) {
+    std::string content(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        content[i] = static_cast<char>(seed + i * 31);
+    }
+    return content;
+}
+
+} // namespace
+
+class DownloadSchedulerTest : public TempDirTest {
+protected:
+    std::string read_file(const std::string& name) {
+        std::ifstream file(dir + "/" + name, std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    bool exists(const std::string& name) {
+        return access((dir + "/" + name).c_str(), F_OK) == 0;
+    }
+
+    DownloadRequest request(const std::string& name, const std::vector<std::string>& servers, uint64_t size = 0) {
+        DownloadRequest req;
+        req.filename = name;
+        req.destination = dir;
+        req.expected_size = size;
+        for (const auto& server : servers) {
+            req.urls.push_back(server + "/" + name);
+        }
+        return req;
+    }
+};
+
+TEST_F(DownloadSchedulerTest, DownloadsFilesConcurrently) {
+    CannedHttpServer server(150);
+    std::vector<DownloadRequest> requests;
+    for (int i = 0; i < 6; ++i) {
+        std::string name = "pkg" + std::to_string(i) + "-1.0-1-x86_64.pkg.tar.zst";
+        server.add_file("/" + name, canned_package(64 * 1024 + i, 'a' + i));
+        requests.push_back(request(name, {server.url()}, 64 * 1024 + i));
+    }
+
+    DownloadScheduler scheduler(4, 4);
+    ASSERT_TRUE(scheduler.download(requests)) << scheduler.get_last_error();
+
+    for (int i = 0; i < 6; ++i) {
+        std::string name = "pkg" + std::to_string(i) + "-1.0-1-x86_64.pkg.tar.zst";
+        EXPECT_EQ(read_file(name), canned_package(64 * 1024 + i, 'a' + i));
+        EXPECT_FALSE(exists(name + ".part"));
+    }
+    EXPECT_GT(server.max_concurrent(), 1);
+    EXPECT_LE(server.max_concurrent(), 4);
+}
+
+TEST_F(DownloadSchedulerTest, SpreadsFilesOverMirrorsWithinLimit) {
+    CannedHttpServer first(150);
+    CannedHttpServer second(150);
+    std::vector<DownloadRequest> requests;
+    for (int i = 0; i < 4; ++i) {
+        std::string name = "file" + std::to_string(i);
+        first.add_file("/" + name, canned_package(1000, 'x'));
+        second.add_file("/" + name, canned_package(1000, 'x'));
+        requests.push_back(request(name, {first.url(), second.url()}));
+    }
+
+    DownloadScheduler scheduler(4, 1);
+    ASSERT_TRUE(scheduler.download(requests));
+
+    EXPECT_EQ(first.max_concurrent(), 1);
+    EXPECT_EQ(second.max_concurrent(), 1);
+    EXPECT_GT(first.request_count(), 0);
+    EXPECT_GT(second.request_count(), 0);
+    EXPECT_EQ(first.request_count() + second.request_count(), 4);
+}
+
+TEST_F(DownloadSchedulerTest, FallsBackToNextMirror) {
+    CannedHttpServer outdated;
+    CannedHttpServer current;
+    current.add_file("/core.db", "database");
+
+    DownloadScheduler scheduler;
+    ASSERT_TRUE(scheduler.download({request("core.db", {outdated.url(), current.url()})}));
+    EXPECT_EQ(read_file("core.db"), "database");
+    EXPECT_EQ(outdated.request_count(), 1);
+}
+
+TEST_F(DownloadSchedulerTest, ResumesPartFile) {
+    CannedHttpServer server;
+    std::string content = canned_package(100000, 'r');
+    server.add_file("/big.pkg.tar.zst", content);
+    std::ofstream(dir + "/big.pkg.tar.zst.part", std::ios::binary) << content.substr(0, 40000);
+
+    DownloadScheduler scheduler;
+    ASSERT_TRUE(scheduler.download({request("big.pkg.tar.zst", {server.url()}, content.size())}));
+
+    EXPECT_EQ(read_file("big.pkg.tar.zst"), content);
+    ASSERT_EQ(server.ranges().size(), 1u);
+    EXPECT_EQ(server.ranges()[0], "40000-");
+}
+
+TEST_F(DownloadSchedulerTest, RestartsOversizedPartFile) {
+    CannedHttpServer server;
+    server.add_file("/small.pkg.tar.zst", "0123456789");
+    std::ofstream(dir + "/small.pkg.tar.zst.part") << std::string(50, 'z');
+
+    DownloadScheduler scheduler;
+    ASSERT_TRUE(scheduler.download({request("small.pkg.tar.zst", {server.url()})}));
+    EXPECT_EQ(read_file("small.pkg.tar.zst"), "0123456789");
+}
+
+TEST_F(DownloadSchedulerTest, RejectsSizeMismatch) {
+    CannedHttpServer server;
+    server.add_file("/short.pkg.tar.zst", "truncated");
+
+    DownloadScheduler scheduler;
+    EXPECT_FALSE(scheduler.download({request("short.pkg.tar.zst", {server.url()}, 1000)}));
+    ASSERT_EQ(scheduler.get_failed().size(), 1u);
+    EXPECT_EQ(scheduler.get_failed()[0], "short.pkg.tar.zst");
+    EXPECT_FALSE(exists("short.pkg.tar.zst"));
+    EXPECT_FALSE(exists("short.pkg.tar.zst.part"));
+}
+
+TEST_F(DownloadSchedulerTest, CancelAbortsRunningDownloads) {
+    CannedHttpServer server(1000);
+    server.add_file("/slow.pkg.tar.zst", canned_package(1000, 's'));
+
+    DownloadScheduler scheduler;
+    std::thread canceller([&scheduler]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        scheduler.cancel();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    bool success = scheduler.download({request("slow.pkg.tar.zst", {server.url()})});
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    EXPECT_FALSE(success);
+    EXPECT_EQ(scheduler.get_last_error(), "Download cancelled");
+    EXPECT_LT(elapsed, std::chrono::milliseconds(800));
+    EXPECT_FALSE(exists("slow.pkg.tar.zst"));
+
+    // Stays cancelled until reset
+    EXPECT_FALSE(scheduler.download({request("slow.pkg.tar.zst", {server.url()})}));
+    scheduler.reset_cancel();
+    EXPECT_TRUE(scheduler.download({request("slow.pkg.tar.zst", {server.url()})}));
+    EXPECT_EQ(read_file("slow.pkg.tar.zst"), canned_package(1000, 's'));
+}
+
+TEST_F(DownloadSchedulerTest, ReportsPerFileAndAggregateProgress) {
+    CannedHttpServer server;
+    server.add_file("/a", canned_package(3000, 'a'));
+    server.add_file("/b", canned_package(5000, 'b'));
+
+    std::vector<DownloadProgress> updates;
+    DownloadScheduler scheduler;
+    scheduler.set_progress_callback([&updates](const DownloadProgress& progress) {
+        updates.push_back(progress);
+    });
+    ASSERT_TRUE(scheduler.download({request("a", {server.url()}, 3000), request("b", {server.url()}, 5000)}));
+
+    ASSERT_FALSE(updates.empty());
+    const DownloadProgress& last = updates.back();
+    EXPECT_EQ(last.count, 2u);
+    EXPECT_EQ(last.completed, 2u);
+    EXPECT_EQ(last.total_downloaded, 8000u);
+    EXPECT_EQ(last.total_size, 8000u);
+    EXPECT_EQ(last.downloaded, last.total);
+
+    bool saw_a = false;
+    for (const auto& update : updates) {
+        if (update.filename == "a" && update.downloaded == 3000) {
+            saw_a = true;
+        }
+    }
+    EXPECT_TRUE(saw_a);
+}
+
+TEST_F(DownloadSchedulerTest, FetchCallbackUsesServerGroupAndConditionalRequests) {
+    CannedHttpServer broken;
+    CannedHttpServer mirror;
+    mirror.add_file("/core/os/x86_64/core.db", "sync database");
+
+    DownloadScheduler scheduler;
+    scheduler.add_server_group({broken.url("/core/os/x86_64"), mirror.url("/core/os/x86_64")});
+
+    std::string url = broken.url("/core/os/x86_64/core.db");
+    EXPECT_EQ(DownloadScheduler::fetch_callback(&scheduler, url.c_str(), dir.c_str(), 0), 0);
+    EXPECT_EQ(read_file("core.db"), "sync database");
+
+    // The copy on disk is current, the mirror answers 304
+    EXPECT_EQ(DownloadScheduler::fetch_callback(&scheduler, url.c_str(), dir.c_str(), 0), 1);
+    EXPECT_EQ(read_file("core.db"), "sync database");
+
+    // Forced downloads ignore the local copy
+    EXPECT_EQ(DownloadScheduler::fetch_callback(&scheduler, url.c_str(), dir.c_str(), 1), 0);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "core/flatpak_deploy_scanner.hpp"
+#include "temp_dir.hpp"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace pacmangui::core;
+
+class FlatpakDeployScannerTest : public TempDirTest {
+protected:
+    // Lays out a deployment the way flatpak does, with active linking to the commit
+    void deploy(const std::string& installation, const std::string& ref, const std::string& metadata) {
+        std::string branch_dir = dir + "/" + installation + "/app/" + ref;
+        ASSERT_TRUE(std::filesystem::create_directories(branch_dir + "/0123abcd/files"));
+        std::ofstream(branch_dir + "/0123abcd/metadata") << metadata;
+        ASSERT_EQ(symlink("0123abcd", (branch_dir + "/active").c_str()), 0);
+    }
+};
+
+TEST_F(FlatpakDeployScannerTest, ParsesTheApplicationGroup) {
+    FlatpakDeployment deployment;
+    ASSERT_TRUE(FlatpakDeployScanner::parse_metadata(
+        "[Application]\n"
+        "name=org.gnome.Calculator\n"
+        "runtime=org.gnome.Platform/x86_64/46\n"
+        "sdk=org.gnome.Sdk/x86_64/46\n"
+        "command=gnome-calculator\n"
+        "\n"
+        "[Context]\n"
+        "shared=network;ipc;\n"
+        "command=not-this-one\n",
+        deployment));
+
+    EXPECT_EQ(deployment.runtime, "org.gnome.Platform/x86_64/46");
+    EXPECT_EQ(deployment.sdk, "org.gnome.Sdk/x86_64/46");
+    EXPECT_EQ(deployment.command, "gnome-calculator");
+
+    FlatpakDeployment runtime;
+    EXPECT_FALSE(FlatpakDeployScanner::parse_metadata("[Runtime]\nname=org.gnome.Platform\n", runtime));
+}
+
+TEST_F(FlatpakDeployScannerTest, ScansEveryInstallationInOnePass) {
+    deploy("system", "org.kde.kate/x86_64/stable",
+           "[Application]\nname=org.kde.kate\nruntime=org.kde.Platform/x86_64/6.7\n");
+    deploy("system", "org.kde.kate/aarch64/beta",
+           "[Application]\nname=org.kde.kate\nruntime=org.kde.Platform/aarch64/6.8\n");
+    deploy("user", "com.example.Tool/x86_64/stable",
+           "[Application]\nname=com.example.Tool\nruntime=org.freedesktop.Platform/x86_64/23.08\n");
+    ASSERT_EQ(symlink("x86_64/stable", (dir + "/system/app/org.kde.kate/current").c_str()), 0);
+
+    // A branch whose deployment was removed keeps its directory but loses active
+    ASSERT_TRUE(std::filesystem::create_directories(dir + "/system/app/org.old.App/x86_64/stable"));
+
+    FlatpakDeployScanner scanner({{dir + "/system", "system"},
+                                  {dir + "/user", "user"},
+                                  {dir + "/missing", "custom"}});
+    std::vector<FlatpakDeployment> deployments = scanner.scan();
+
+    ASSERT_EQ(deployments.size(), 3u);
+    EXPECT_EQ(deployments[0].app_id, "org.kde.kate");
+    EXPECT_EQ(deployments[0].arch, "aarch64");
+    EXPECT_EQ(deployments[0].branch, "beta");
+    EXPECT_EQ(deployments[0].runtime, "org.kde.Platform/aarch64/6.8");
+    EXPECT_EQ(deployments[1].arch, "x86_64");
+    EXPECT_EQ(deployments[1].installation, "system");
+    EXPECT_EQ(deployments[1].runtime, "org.kde.Platform/x86_64/6.7");
+    EXPECT_EQ(deployments[2].app_id, "com.example.Tool");
+    EXPECT_EQ(deployments[2].installation, "user");
+}
+
+TEST_F(FlatpakDeployScannerTest, DefaultInstallationsFollowTheEnvironment) {
+    setenv("FLATPAK_SYSTEM_DIR", "/srv/flatpak", 1);
+    setenv("FLATPAK_USER_DIR", "/home/test/flatpak", 1);
+    std::vector<FlatpakInstallation> installations = FlatpakDeployScanner::default_installations();
+    unsetenv("FLATPAK_SYSTEM_DIR");
+    unsetenv("FLATPAK_USER_DIR");
+
+    ASSERT_EQ(installations.size(), 2u);
+    EXPECT_EQ(installations[0].path, "/srv/flatpak");
+    EXPECT_EQ(installations[0].name, "system");
+    EXPECT_EQ(installations[1].path, "/home/test/flatpak");
+    EXPECT_EQ(installations[1].name, "user");
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include "core/flatpak_manager.hpp"
+#include "temp_dir.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// Answers from fixed data and counts the calls; an empty search means unsupported
+class FakeBackend : public FlatpakBackend {
+public:
+    explicit FakeBackend(const std::string& name) : m_name(name) {}
+
+    std::string get_name() const override { return m_name; }
+    bool is_available() const override { return true; }
+
+    bool list_installed(std::vector<FlatpakPackage>& packages) const override {
+        ++calls;
+        packages = installed;
+        return true;
+    }
+
+    bool search(const std::string& query, std::vector<FlatpakPackage>& packages) const override {
+        ++calls;
+        if (remote.empty()) {
+            set_last_error(m_name + " cannot search for " + query);
+            return false;
+        }
+        packages = remote;
+        return true;
+    }
+
+    bool is_installed(const std::string& app_id, bool& result) const override {
+        ++calls;
+        result = false;
+        for (const auto& package : installed) {
+            result = result || package.get_app_id() == app_id;
+        }
+        return true;
+    }
+
+    bool list_remotes(std::vector<std::string>& remotes) const override {
+        ++calls;
+        // Every remote initialize() would otherwise add
+        remotes = {"flathub", "flathub-beta", "gnome-nightly", "kdeapps"};
+        return true;
+    }
+
+    bool list_updates(std::vector<std::string>& app_ids) const override {
+        ++calls;
+        set_last_error(m_name + " is offline");
+        (void)app_ids;
+        return false;
+    }
+
+    bool get_app_info(FlatpakPackage& package) const override {
+        ++calls;
+        package.set_name(m_name + " name");
+        return true;
+    }
+
+    std::vector<FlatpakPackage> installed;
+    std::vector<FlatpakPackage> remote;
+    mutable int calls = 0;
+
+private:
+    std::string m_name;
+};
+
+FlatpakPackage make_package(const std::string& app_id, const std::string& name, const std::string& description = "")
+{
+    FlatpakPackage package(name, "1.0");
+    package.set_app_id(app_id);
+    package.set_description(description);
+    return package;
+}
+
+} // namespace
+
+class FlatpakManagerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto backend_ptr = std::make_unique<FakeBackend>("in-process");
+        auto fallback_ptr = std::make_unique<FakeBackend>("command");
+        backend = backend_ptr.get();
+        fallback = fallback_ptr.get();
+
+        backend->installed = {make_package("org.kde.kate", "Kate")};
+        fallback->remote = {make_package("org.gnome.gedit", "gedit", "Text editor"),
+                            make_package("org.kde.kwrite", "KWrite", "Simple text editor"),
+                            make_package("org.kde.kate", "Kate", "Advanced text editor")};
+
+        manager = std::make_unique<FlatpakManager>(std::move(backend_ptr), std::move(fallback_ptr));
+        ASSERT_TRUE(manager->initialize());
+        backend->calls = 0;
+        fallback->calls = 0;
+    }
+
+    std::unique_ptr<FlatpakManager> manager;
+    FakeBackend* backend = nullptr;
+    FakeBackend* fallback = nullptr;
+};
+
+TEST_F(FlatpakManagerTest, AsksTheFirstBackendFirst) {
+    std::vector<FlatpakPackage> installed = manager->get_installed_packages();
+    ASSERT_EQ(installed.size(), 1u);
+    EXPECT_EQ(installed[0].get_app_id(), "org.kde.kate");
+    EXPECT_TRUE(manager->is_package_installed("org.kde.kate"));
+    EXPECT_FALSE(manager->is_package_installed("org.gnome.gedit"));
+
+    FlatpakPackage package = make_package("org.kde.kate", "");
+    EXPECT_TRUE(manager->get_app_info(package));
+    EXPECT_EQ(package.get_name(), "in-process name");
+
+    EXPECT_EQ(manager->get_backend_name(), "in-process");
+    EXPECT_EQ(fallback->calls, 0);
+}
+
+TEST_F(FlatpakManagerTest, FallsBackForWhatTheBackendCannotDo) {
+    auto results = manager->search_by_name("kate");
+    EXPECT_EQ(backend->calls, 1);
+    EXPECT_EQ(fallback->calls, 1);
+
+    // Ranked by the fuzzy matcher, hits matching neither name nor ID last
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0]->get_app_id(), "org.kde.kate");
+}
+
+TEST_F(FlatpakManagerTest, ReportsTheFallbackErrorWhenBothFail) {
+    EXPECT_TRUE(manager->check_for_updates().empty());
+    EXPECT_EQ(manager->get_last_error(), "command is offline");
+}
+
+TEST(FlatpakManagerAppstreamTest, SearchesTheAppstreamIndexWithoutTheBackends) {
+    TempDir temp_dir("flatpak_manager_test");
+    ASSERT_FALSE(temp_dir.path().empty()) << temp_dir.error();
+    const std::string& dir = temp_dir.path();
+    ASSERT_TRUE(std::filesystem::create_directories(dir + "/system/appstream/flathub/x86_64/active"));
+    std::ofstream(dir + "/system/appstream/flathub/x86_64/active/appstream.xml")
+        << "<components><component><id>org.gnome.gedit</id><name>gedit</name><summary>Text editor</summary>"
+           "<bundle type=\"flatpak\">app/org.gnome.gedit/x86_64/stable</bundle></component></components>";
+
+    auto backend_ptr = std::make_unique<FakeBackend>("in-process");
+    FakeBackend* backend = backend_ptr.get();
+    FlatpakManager manager(std::move(backend_ptr), nullptr,
+                           std::make_unique<FlatpakAppstreamCatalog>(
+                               std::vector<FlatpakInstallation>{{dir + "/system", "system"}}, dir + "/cache", "x86_64"));
+    ASSERT_TRUE(manager.initialize());
+    backend->calls = 0;
+
+    auto results = manager.search_by_name("gedit");
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0]->get_app_id(), "org.gnome.gedit");
+    EXPECT_EQ(results[0]->get_repository(), "flathub");
+    EXPECT_EQ(backend->calls, 0);
+}
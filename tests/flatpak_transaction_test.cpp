@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "core/flatpak_transaction.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+TEST(FlatpakTransactionTest, PutsAllRefsInOneCommand) {
+    FlatpakTransaction install(FlatpakOperation::INSTALL, {"org.gnome.Calculator", "org.kde.kate"}, "flathub");
+    EXPECT_EQ(install.get_command(),
+              std::vector<std::string>({"env", "LC_ALL=C", "flatpak", "install", "-y", "--noninteractive",
+                                        "flathub", "org.gnome.Calculator", "org.kde.kate"}));
+
+    FlatpakTransaction remove(FlatpakOperation::REMOVE, {"org.kde.kate"}, "flathub");
+    EXPECT_EQ(remove.get_command(),
+              std::vector<std::string>({"env", "LC_ALL=C", "flatpak", "uninstall", "-y", "--noninteractive",
+                                        "org.kde.kate"}));
+
+    FlatpakTransaction update_all(FlatpakOperation::UPDATE, {});
+    EXPECT_EQ(update_all.get_command().back(), "--noninteractive");
+}
+
+TEST(FlatpakTransactionTest, FollowsEachRefThroughTheOutput) {
+    FlatpakTransaction transaction(FlatpakOperation::INSTALL, {"org.gnome.Calculator", "org.kde.kate"}, "flathub");
+    std::vector<FlatpakRefProgress> updates;
+    transaction.set_progress_callback([&updates](const FlatpakRefProgress& progress) {
+        updates.push_back(progress);
+    });
+
+    transaction.parse_line("Looking for matches…");
+    transaction.parse_line("Installing runtime/org.gnome.Platform/x86_64/46");
+    transaction.parse_line("\rInstalling… 10%\rInstalling… 55%\rInstalling… 55%");
+    transaction.parse_line("Installing app/org.gnome.Calculator/x86_64/stable");
+    transaction.parse_line("Installing 2/3… 40%  1.2 MB/s  00:03");
+    transaction.parse_line("Installing app/org.kde.kate/x86_64/stable");
+    transaction.parse_line("error: Failed to install org.kde.kate: No space left on device");
+    transaction.finish(false);
+
+    const std::vector<FlatpakRefProgress>& progress = transaction.get_progress();
+    ASSERT_EQ(progress.size(), 3u);
+    EXPECT_EQ(progress[0].ref, "org.gnome.Calculator");
+    EXPECT_EQ(progress[0].state, FlatpakRefState::DONE);
+    EXPECT_EQ(progress[1].ref, "org.kde.kate");
+    EXPECT_EQ(progress[1].state, FlatpakRefState::FAILED);
+    EXPECT_EQ(progress[1].message, "Failed to install org.kde.kate: No space left on device");
+
+    // The runtime was pulled in by flatpak and finished before the apps
+    EXPECT_EQ(progress[2].ref, "runtime/org.gnome.Platform/x86_64/46");
+    EXPECT_FALSE(progress[2].requested);
+    EXPECT_EQ(progress[2].state, FlatpakRefState::DONE);
+    EXPECT_EQ(transaction.get_last_error(), "Failed to install org.kde.kate: No space left on device");
+
+    // Redraws without a change are not reported
+    ASSERT_GE(updates.size(), 4u);
+    EXPECT_EQ(updates[0].ref, "runtime/org.gnome.Platform/x86_64/46");
+    EXPECT_EQ(updates[0].state, FlatpakRefState::RUNNING);
+    EXPECT_EQ(updates[1].percent, 10);
+    EXPECT_EQ(updates[2].percent, 55);
+    EXPECT_EQ(updates[3].state, FlatpakRefState::DONE);
+    int calculator_updates = 0;
+    for (const FlatpakRefProgress& update : updates) {
+        calculator_updates += update.ref == "org.gnome.Calculator";
+    }
+    EXPECT_EQ(calculator_updates, 3);
+}
+
+TEST(FlatpakTransactionTest, SettlesRefsFlatpakSkipped) {
+    FlatpakTransaction transaction(FlatpakOperation::INSTALL, {"org.kde.kate"}, "flathub");
+    transaction.parse_line("Skipping: org.kde.kate/x86_64/stable is already installed");
+    EXPECT_EQ(transaction.get_progress()[0].state, FlatpakRefState::QUEUED);
+    EXPECT_EQ(transaction.get_progress()[0].message, "Skipping: org.kde.kate/x86_64/stable is already installed");
+
+    transaction.finish(true);
+    EXPECT_EQ(transaction.get_progress()[0].state, FlatpakRefState::DONE);
+    EXPECT_EQ(transaction.get_progress()[0].percent, 100);
+}
+
+TEST(FlatpakTransactionTest, MatchesErrorsToWholeRefs) {
+    FlatpakTransaction transaction(FlatpakOperation::INSTALL, {"org.gnome.Calculator", "org.kde.kate"}, "flathub");
+    transaction.parse_line("Installing app/org.kde.kate/x86_64/stable");
+    transaction.parse_line("error: Failed to install org.gnome.Calculator.Locale: Server returned 404");
+
+    // The locale extension is not the app, the error goes to the running ref
+    EXPECT_EQ(transaction.get_progress()[0].state, FlatpakRefState::QUEUED);
+    EXPECT_EQ(transaction.get_progress()[1].state, FlatpakRefState::FAILED);
+
+    transaction.parse_line("Skipping: org.gnome.Calculator/x86_64/stable is already installed");
+    EXPECT_EQ(transaction.get_progress()[0].message, "Skipping: org.gnome.Calculator/x86_64/stable is already installed");
+}
+
+TEST(FlatpakTransactionTest, CancelBeforeRunStartsNothing) {
+    FlatpakTransaction transaction(FlatpakOperation::REMOVE, {"org.kde.kate"});
+    transaction.cancel();
+
+    EXPECT_FALSE(transaction.run());
+    EXPECT_EQ(transaction.get_last_error(), "Flatpak transaction was cancelled");
+    EXPECT_EQ(transaction.get_progress()[0].state, FlatpakRefState::FAILED);
+}
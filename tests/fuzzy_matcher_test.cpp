@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "core/fuzzy_matcher.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// Edit distance of pattern to the closest substring of text, the slow way
+int reference_distance(const std::string& pattern, const std::string& text)
+{
+    std::vector<int> previous(pattern.size() + 1), current(pattern.size() + 1);
+    for (size_t i = 0; i <= pattern.size(); ++i) {
+        previous[i] = static_cast<int>(i);
+    }
+    int best = previous[pattern.size()];
+    for (char c : text) {
+        current[0] = 0;
+        for (size_t i = 1; i <= pattern.size(); ++i) {
+            current[i] = std::min({previous[i] + 1, current[i - 1] + 1,
+                                   previous[i - 1] + (pattern[i - 1] == c ? 0 : 1)});
+        }
+        best = std::min(best, current[pattern.size()]);
+        previous.swap(current);
+    }
+    return best;
+}
+
+std::vector<std::string> rank_names(const FuzzyMatcher& matcher, const std::vector<std::string>& names, size_t limit)
+{
+    std::vector<std::string> result;
+    auto matches = matcher.rank(names.size(), [&names](size_t i) {
+        return std::make_pair(std::string_view(names[i]), std::string_view());
+    }, limit);
+    for (const FuzzyMatch& match : matches) {
+        result.push_back(names[match.index]);
+    }
+    return result;
+}
+
+} // namespace
+
+TEST(FuzzyMatcherTest, BitParallelDistanceMatchesDynamicProgramming) {
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> letter('a', 'd');
+    std::uniform_int_distribution<int> length(1, 12);
+
+    for (int round = 0; round < 2000; ++round) {
+        std::string pattern, text;
+        for (int i = length(random); i > 0; --i) {
+            pattern += static_cast<char>(letter(random));
+        }
+        for (int i = length(random) * 2; i > 0; --i) {
+            text += static_cast<char>(letter(random));
+        }
+
+        FuzzyMatcher matcher(pattern, 3);
+        int expected = std::min(reference_distance(pattern, text), matcher.get_max_distance() + 1);
+        ASSERT_EQ(matcher.distance(text), expected) << pattern << " in " << text;
+    }
+}
+
+TEST(FuzzyMatcherTest, DistanceIgnoresCase) {
+    FuzzyMatcher matcher("Firefox", 2);
+    EXPECT_EQ(matcher.distance("FIREFOX-I18N"), 0);
+    EXPECT_EQ(matcher.distance("firefx"), 1);
+    EXPECT_EQ(matcher.distance("chromium"), 3);
+}
+
+TEST(FuzzyMatcherTest, RanksByKindOfMatch) {
+    FuzzyMatcher matcher("qt");
+    FuzzyMatch match;
+
+    ASSERT_TRUE(matcher.match("qt", "", match));
+    EXPECT_EQ(match.kind, FuzzyMatchKind::EXACT);
+    ASSERT_TRUE(matcher.match("qtcreator", "", match));
+    EXPECT_EQ(match.kind, FuzzyMatchKind::PREFIX);
+    ASSERT_TRUE(matcher.match("python-qt", "", match));
+    EXPECT_EQ(match.kind, FuzzyMatchKind::WORD);
+    ASSERT_TRUE(matcher.match("libqtxdg", "", match));
+    EXPECT_EQ(match.kind, FuzzyMatchKind::SUBSTRING);
+    ASSERT_TRUE(matcher.match("kate", "Editor using Qt", match));
+    EXPECT_EQ(match.kind, FuzzyMatchKind::DESCRIPTION);
+    EXPECT_FALSE(matcher.match("gtk", "", match));
+}
+
+TEST(FuzzyMatcherTest, ShortQueriesAllowNoTypos) {
+    EXPECT_EQ(FuzzyMatcher("vim").get_max_distance(), 0);
+    EXPECT_EQ(FuzzyMatcher("firefx").get_max_distance(), 1);
+    EXPECT_EQ(FuzzyMatcher("libreoffice").get_max_distance(), 2);
+}
+
+TEST(FuzzyMatcherTest, KeepsOnlyTheBestMatches) {
+    std::vector<std::string> names = {"firefox-i18n", "fire", "firefox", "firefax", "thunderbird", "firefox-esr"};
+
+    FuzzyMatcher matcher("firefox");
+    EXPECT_EQ(rank_names(matcher, names, 0),
+              (std::vector<std::string>{"firefox", "firefox-esr", "firefox-i18n", "firefax"}));
+    EXPECT_EQ(rank_names(matcher, names, 2), (std::vector<std::string>{"firefox", "firefox-esr"}));
+
+    matcher.set_typos_only(true);
+    EXPECT_EQ(rank_names(matcher, names, 0), (std::vector<std::string>{"firefax"}));
+}
+
+TEST(FuzzyMatcherTest, CancelledRankReturnsNothing) {
+    std::vector<std::string> names = {"firefox"};
+    std::atomic<bool> cancelled{true};
+    FuzzyMatcher matcher("firefox");
+    EXPECT_TRUE(matcher.rank(names.size(), [&names](size_t i) {
+        return std::make_pair(std::string_view(names[i]), std::string_view());
+    }, 0, &cancelled).empty());
+}
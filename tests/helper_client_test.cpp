@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include "core/helper_client.hpp"
+#include "temp_dir.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+/**
+ * @brief Stand-in for pacmangui-helper --daemon
+ *
+ * Accepts connections on a Unix socket in a temporary directory and hands
+ * each received request to a handler, which answers through the socket.
+ */
+class FakeDaemon {
+public:
+    using Handler = std::function<void(int fd, const HelperRequest& request)>;
+
+    explicit FakeDaemon(Handler handler) : m_handler(std::move(handler)), m_dir("helper_client_test") {
+        EXPECT_FALSE(m_dir.path().empty()) << "Cannot create a temporary directory: " << m_dir.error();
+        m_path = m_dir.path() + "/helper.sock";
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, m_path.c_str(), sizeof(addr.sun_path) - 1);
+        m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+        bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(m_socket, 4);
+
+        m_thread = std::thread([this]() { serve(); });
+    }
+
+    ~FakeDaemon() {
+        ::shutdown(m_socket, SHUT_RDWR);
+        close(m_socket);
+        m_thread.join();
+    }
+
+    const std::string& path() const { return m_path; }
+    const std::vector<HelperRequest>& requests() const { return m_requests; }
+
+    static void send(int fd, HelperMessageType type, const std::string& text = "", bool success = false) {
+        HelperMessage message;
+        message.type = type;
+        message.text = text;
+        message.success = success;
+        write_helper_frame(fd, encode_helper_message(message));
+    }
+
+private:
+    void serve() {
+        while (true) {
+            int client = accept(m_socket, nullptr, nullptr);
+            if (client < 0) {
+                return;
+            }
+            std::string payload;
+            HelperRequest request;
+            while (read_helper_frame(client, payload) && decode_helper_request(payload, request)) {
+                m_requests.push_back(request);
+                m_handler(client, request);
+                if (request.operation == HelperOperation::SHUTDOWN) {
+                    break;
+                }
+            }
+            close(client);
+        }
+    }
+
+    Handler m_handler;
+    TempDir m_dir;
+    std::string m_path;
+    int m_socket = -1;
+    std::thread m_thread;
+    std::vector<HelperRequest> m_requests;
+};
+
+HelperRequest make_request(HelperOperation operation, std::vector<std::string> targets = {}) {
+    HelperRequest request;
+    request.operation = operation;
+    request.targets = std::move(targets);
+    return request;
+}
+
+} // namespace
+
+TEST(HelperClientTest, StreamsMessagesUntilDone) {
+    FakeDaemon daemon([](int fd, const HelperRequest&) {
+        FakeDaemon::send(fd, HelperMessageType::EVENT, "Checking dependencies...");
+        FakeDaemon::send(fd, HelperMessageType::ADD, "firefox");
+        FakeDaemon::send(fd, HelperMessageType::DONE, "", true);
+    });
+
+    HelperClient client(daemon.path(), getuid());
+    std::vector<HelperMessage> messages;
+    bool success = client.request(make_request(HelperOperation::INSTALL, {"firefox"}),
+                                  [&messages](const HelperMessage& message) { messages.push_back(message); });
+
+    EXPECT_TRUE(success) << client.get_last_error();
+    ASSERT_EQ(messages.size(), 3u);
+    EXPECT_EQ(messages[0].text, "Checking dependencies...");
+    EXPECT_EQ(messages[1].type, HelperMessageType::ADD);
+    EXPECT_EQ(messages[2].type, HelperMessageType::DONE);
+    ASSERT_EQ(daemon.requests().size(), 1u);
+    EXPECT_EQ(daemon.requests()[0].targets, std::vector<std::string>{"firefox"});
+}
+
+TEST(HelperClientTest, KeepsConnectionBetweenRequests) {
+    FakeDaemon daemon([](int fd, const HelperRequest&) {
+        FakeDaemon::send(fd, HelperMessageType::DONE, "", true);
+    });
+
+    HelperClient client(daemon.path(), getuid());
+    EXPECT_TRUE(client.request(make_request(HelperOperation::CLEAN_CACHE), nullptr));
+    EXPECT_TRUE(client.is_connected());
+    EXPECT_TRUE(client.request(make_request(HelperOperation::CHECK_DATABASE), nullptr));
+    EXPECT_EQ(daemon.requests().size(), 2u);
+}
+
+TEST(HelperClientTest, ReportsErrorFromDaemon) {
+    FakeDaemon daemon([](int fd, const HelperRequest&) {
+        FakeDaemon::send(fd, HelperMessageType::ERROR, "target not found: nosuchpkg");
+        FakeDaemon::send(fd, HelperMessageType::DONE, "", false);
+    });
+
+    HelperClient client(daemon.path(), getuid());
+    EXPECT_FALSE(client.request(make_request(HelperOperation::INSTALL, {"nosuchpkg"}), nullptr));
+    EXPECT_EQ(client.get_last_error(), "target not found: nosuchpkg");
+    EXPECT_TRUE(client.is_connected());
+}
+
+TEST(HelperClientTest, CancelReachesDaemonDuringRequest) {
+    FakeDaemon daemon([](int fd, const HelperRequest& request) {
+        if (request.operation == HelperOperation::SYSUPGRADE) {
+            // Busy until the client asks to stop
+            std::string payload;
+            HelperRequest cancel;
+            if (read_helper_frame(fd, payload) && decode_helper_request(payload, cancel) &&
+                cancel.operation == HelperOperation::CANCEL) {
+                FakeDaemon::send(fd, HelperMessageType::ERROR, "Operation cancelled");
+            }
+            FakeDaemon::send(fd, HelperMessageType::DONE, "", false);
+        }
+    });
+
+    HelperClient client(daemon.path(), getuid());
+    ASSERT_TRUE(client.connect());
+    std::thread canceller([&client]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        client.cancel();
+    });
+
+    EXPECT_FALSE(client.request(make_request(HelperOperation::SYSUPGRADE), nullptr));
+    canceller.join();
+    EXPECT_EQ(client.get_last_error(), "Operation cancelled");
+}
+
+TEST(HelperClientTest, ReconnectsAfterLostConnection) {
+    int calls = 0;
+    FakeDaemon daemon([&calls](int fd, const HelperRequest&) {
+        if (++calls == 1) {
+            ::shutdown(fd, SHUT_RDWR);
+            return;
+        }
+        FakeDaemon::send(fd, HelperMessageType::DONE, "", true);
+    });
+
+    HelperClient client(daemon.path(), getuid());
+    EXPECT_FALSE(client.request(make_request(HelperOperation::REFRESH), nullptr));
+    EXPECT_EQ(client.get_last_error(), "Lost connection to pacmangui-helper");
+    EXPECT_FALSE(client.is_connected());
+
+    EXPECT_TRUE(client.request(make_request(HelperOperation::REFRESH), nullptr));
+}
+
+TEST(HelperClientTest, ShutdownStopsDaemonSession) {
+    FakeDaemon daemon([](int fd, const HelperRequest&) {
+        FakeDaemon::send(fd, HelperMessageType::DONE, "", true);
+    });
+
+    HelperClient client(daemon.path(), getuid());
+    ASSERT_TRUE(client.connect());
+    client.shutdown();
+
+    EXPECT_FALSE(client.is_connected());
+    ASSERT_EQ(daemon.requests().size(), 1u);
+    EXPECT_EQ(daemon.requests()[0].operation, HelperOperation::SHUTDOWN);
+}
+
+TEST(HelperClientTest, RejectsDaemonOfOtherUser) {
+    FakeDaemon daemon([](int, const HelperRequest&) {});
+
+    HelperClient client(daemon.path(), getuid() + 1);
+    EXPECT_FALSE(client.connect());
+    EXPECT_FALSE(client.is_connected());
+}
+
+TEST(HelperClientTest, FailsWithoutDaemon) {
+    HelperClient client("/tmp/pacmangui-helper-test-missing.sock", getuid());
+    EXPECT_FALSE(client.request(make_request(HelperOperation::REFRESH), nullptr));
+    EXPECT_FALSE(client.get_last_error().empty());
+}
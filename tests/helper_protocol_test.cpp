@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include "core/helper_protocol.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace pacmangui::core;
+
+TEST(HelperProtocolTest, EventRoundTripKeepsSpecialCharacters) {
+    HelperMessage event;
+    event.type = HelperMessageType::EVENT;
+    event.text = "line one\n\tline two \\ done";
+
+    std::string line = format_helper_message(event);
+    ASSERT_EQ(line.back(), '\n');
+    EXPECT_EQ(line.find('\n'), line.size() - 1);
+    line.pop_back();
+
+    HelperMessage parsed;
+    ASSERT_TRUE(parse_helper_message(line, parsed));
+    EXPECT_EQ(parsed.type, HelperMessageType::EVENT);
+    EXPECT_EQ(parsed.text, event.text);
+}
+
+TEST(HelperProtocolTest, ProgressRoundTrip) {
+    HelperMessage progress;
+    progress.type = HelperMessageType::PROGRESS;
+    progress.operation = "upgrading";
+    progress.target = "linux";
+    progress.percent = 42;
+    progress.current = 3;
+    progress.total = 7;
+
+    std::string line = format_helper_message(progress);
+    line.pop_back();
+
+    HelperMessage parsed;
+    ASSERT_TRUE(parse_helper_message(line + "\r", parsed));
+    EXPECT_EQ(parsed.type, HelperMessageType::PROGRESS);
+    EXPECT_EQ(parsed.operation, "upgrading");
+    EXPECT_EQ(parsed.target, "linux");
+    EXPECT_EQ(parsed.percent, 42);
+    EXPECT_EQ(parsed.current, 3u);
+    EXPECT_EQ(parsed.total, 7u);
+}
+
+TEST(HelperProtocolTest, DownloadRoundTrip) {
+    HelperMessage download;
+    download.type = HelperMessageType::DOWNLOAD;
+    download.download.filename = "linux-6.9.1.arch1-1-x86_64.pkg.tar.zst";
+    download.download.downloaded = 5000000;
+    download.download.total = 140000000;
+    download.download.rate = 2500000.7;
+    download.download.total_downloaded = 9000000;
+    download.download.total_size = 150000000;
+    download.download.total_rate = 4800000.2;
+    download.download.completed = 1;
+    download.download.count = 3;
+
+    std::string line = format_helper_message(download);
+    line.pop_back();
+
+    HelperMessage parsed;
+    ASSERT_TRUE(parse_helper_message(line, parsed));
+    EXPECT_EQ(parsed.type, HelperMessageType::DOWNLOAD);
+    EXPECT_EQ(parsed.download.filename, download.download.filename);
+    EXPECT_EQ(parsed.download.downloaded, 5000000u);
+    EXPECT_EQ(parsed.download.total, 140000000u);
+    EXPECT_DOUBLE_EQ(parsed.download.rate, 2500000.0);
+    EXPECT_EQ(parsed.download.total_downloaded, 9000000u);
+    EXPECT_EQ(parsed.download.total_size, 150000000u);
+    EXPECT_DOUBLE_EQ(parsed.download.total_rate, 4800000.0);
+    EXPECT_EQ(parsed.download.completed, 1u);
+    EXPECT_EQ(parsed.download.count, 3u);
+}
+
+TEST(HelperProtocolTest, DoneCarriesResult) {
+    HelperMessage done;
+    done.type = HelperMessageType::DONE;
+    done.success = true;
+
+    HelperMessage parsed;
+    std::string line = format_helper_message(done);
+    line.pop_back();
+    ASSERT_TRUE(parse_helper_message(line, parsed));
+    EXPECT_EQ(parsed.type, HelperMessageType::DONE);
+    EXPECT_TRUE(parsed.success);
+}
+
+TEST(HelperProtocolTest, RejectsOtherOutput) {
+    HelperMessage parsed;
+    EXPECT_FALSE(parse_helper_message("[sudo] password for user:", parsed));
+    EXPECT_FALSE(parse_helper_message("@progress\tonly\ttwo", parsed));
+    EXPECT_FALSE(parse_helper_message("@progress\ta\tb\tnot-a-number\t1\t2", parsed));
+    EXPECT_FALSE(parse_helper_message("", parsed));
+}
+
+TEST(HelperProtocolTest, RequestFrameRoundTrip) {
+    HelperRequest request;
+    request.operation = HelperOperation::INSTALL;
+    request.flags = HELPER_FLAG_OVERWRITE | HELPER_FLAG_REFRESH;
+    request.targets = {"firefox", "lib32-mesa", ""};
+
+    std::string frame = encode_helper_request(request);
+    ASSERT_GE(frame.size(), 4u);
+
+    HelperRequest decoded;
+    ASSERT_TRUE(decode_helper_request(frame.substr(4), decoded));
+    EXPECT_EQ(decoded.operation, HelperOperation::INSTALL);
+    EXPECT_EQ(decoded.flags, HELPER_FLAG_OVERWRITE | HELPER_FLAG_REFRESH);
+    EXPECT_EQ(decoded.targets, request.targets);
+    EXPECT_TRUE(decoded.dependencies.empty());
+}
+
+TEST(HelperProtocolTest, PackageFileRequestRoundTrip) {
+    HelperRequest request;
+    request.operation = HelperOperation::INSTALL_FILES;
+    request.targets = {"/tmp/a/a-1-1-x86_64.pkg.tar.zst", "/tmp/b/b-2-1-any.pkg.tar.zst"};
+    request.dependencies = {"/tmp/b/b-2-1-any.pkg.tar.zst"};
+
+    HelperRequest decoded;
+    ASSERT_TRUE(decode_helper_request(encode_helper_request(request).substr(4), decoded));
+    EXPECT_EQ(decoded.operation, HelperOperation::INSTALL_FILES);
+    EXPECT_EQ(decoded.targets, request.targets);
+    EXPECT_EQ(decoded.dependencies, request.dependencies);
+}
+
+TEST(HelperProtocolTest, MessageFrameRoundTrip) {
+    HelperMessage message;
+    message.type = HelperMessageType::PROGRESS;
+    message.operation = "upgrading";
+    message.target = "linux\twith\ttabs\n";
+    message.percent = 73;
+    message.current = 2;
+    message.total = 9;
+    message.download.filename = "linux.pkg.tar.zst";
+    message.download.total_size = 1ull << 40;
+
+    std::string frame = encode_helper_message(message);
+
+    HelperMessage decoded;
+    ASSERT_TRUE(decode_helper_message(frame.substr(4), decoded));
+    EXPECT_EQ(decoded.type, HelperMessageType::PROGRESS);
+    EXPECT_EQ(decoded.operation, "upgrading");
+    EXPECT_EQ(decoded.target, message.target);
+    EXPECT_EQ(decoded.percent, 73);
+    EXPECT_EQ(decoded.current, 2u);
+    EXPECT_EQ(decoded.total, 9u);
+    EXPECT_EQ(decoded.download.filename, "linux.pkg.tar.zst");
+    EXPECT_EQ(decoded.download.total_size, 1ull << 40);
+}
+
+TEST(HelperProtocolTest, RejectsMalformedFrames) {
+    HelperRequest request;
+    request.operation = HelperOperation::REMOVE;
+    request.targets = {"vim"};
+    std::string payload = encode_helper_request(request).substr(4);
+
+    HelperRequest decoded;
+    EXPECT_FALSE(decode_helper_request(payload.substr(0, payload.size() - 1), decoded));
+    EXPECT_FALSE(decode_helper_request(payload + "x", decoded));
+    EXPECT_FALSE(decode_helper_request(std::string(1, '\0'), decoded));
+    EXPECT_FALSE(decode_helper_request(std::string("\x63\x00\x00\x00\x00\x00", 6), decoded));
+
+    HelperMessage message;
+    EXPECT_FALSE(decode_helper_message("", message));
+}
+
+TEST(HelperProtocolTest, FramesTravelOverSocket) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    HelperMessage done;
+    done.type = HelperMessageType::DONE;
+    done.success = true;
+    HelperRequest request;
+    request.operation = HelperOperation::CLEAN_CACHE;
+    request.flags = HELPER_FLAG_CLEAN_ALL;
+
+    ASSERT_TRUE(write_helper_frame(fds[0], encode_helper_request(request)));
+    ASSERT_TRUE(write_helper_frame(fds[0], encode_helper_message(done)));
+
+    std::string payload;
+    HelperRequest received_request;
+    ASSERT_TRUE(read_helper_frame(fds[1], payload));
+    ASSERT_TRUE(decode_helper_request(payload, received_request));
+    EXPECT_EQ(received_request.operation, HelperOperation::CLEAN_CACHE);
+    EXPECT_EQ(received_request.flags, HELPER_FLAG_CLEAN_ALL);
+
+    HelperMessage received_message;
+    ASSERT_TRUE(read_helper_frame(fds[1], payload));
+    ASSERT_TRUE(decode_helper_message(payload, received_message));
+    EXPECT_EQ(received_message.type, HelperMessageType::DONE);
+    EXPECT_TRUE(received_message.success);
+
+    // An oversized length prefix is refused instead of allocated
+    const char huge[4] = {'\xff', '\xff', '\xff', '\x7f'};
+    ASSERT_EQ(write(fds[0], huge, sizeof(huge)), 4);
+    EXPECT_FALSE(read_helper_frame(fds[1], payload));
+
+    close(fds[0]);
+    EXPECT_FALSE(read_helper_frame(fds[1], payload));
+    close(fds[1]);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "core/json_parser.hpp"
+
+#include <string>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+/**
+ * @brief Writes every event as a token so a test can compare the sequence
+ */
+class RecordingHandler : public JsonHandler {
+public:
+    void begin_object() override { events.push_back("{"); }
+    void end_object() override { events.push_back("}"); }
+    void begin_array() override { events.push_back("["); }
+    void end_array() override { events.push_back("]"); }
+    void key(std::string_view name) override { events.push_back("key:" + std::string(name)); }
+    void string_value(std::string_view value) override { events.push_back("str:" + std::string(value)); }
+    void number_value(double, std::string_view text) override { events.push_back("num:" + std::string(text)); }
+    void bool_value(bool value) override { events.push_back(value ? "true" : "false"); }
+    void null_value() override { events.push_back("null"); }
+
+    std::vector<std::string> events;
+};
+
+bool parse_all(const std::string& json, RecordingHandler& handler, size_t chunk = 0) {
+    JsonParser parser(handler);
+    if (chunk == 0) {
+        chunk = json.size();
+    }
+    for (size_t i = 0; i < json.size(); i += chunk) {
+        if (!parser.feed(json.data() + i, std::min(chunk, json.size() - i))) {
+            return false;
+        }
+    }
+    return parser.finish();
+}
+
+const char* const kRpcResponse =
+    R"({"resultcount":1,"results":[{"Name":"yay","Version":"12.3.5-1","Description":"Yet another \"yogurt\"",)"
+    R"("NumVotes":2345,"Popularity":12.5,"OutOfDate":null,"Depends":["pacman>5","git"]}],"type":"multiinfo","version":5})";
+
+} // namespace
+
+TEST(JsonParserTest, ReportsEventsInOrder) {
+    RecordingHandler handler;
+    ASSERT_TRUE(parse_all(R"({"a":[1,-2.5e3,true,false,null],"b":{}})", handler));
+
+    std::vector<std::string> expected = {"{", "key:a", "[", "num:1", "num:-2.5e3", "true", "false", "null", "]",
+                                         "key:b", "{", "}", "}"};
+    EXPECT_EQ(handler.events, expected);
+}
+
+TEST(JsonParserTest, DecodesEscapes) {
+    RecordingHandler handler;
+    ASSERT_TRUE(parse_all(R"(["quote \" slash \/ tab \t", "é€", "😀"])", handler));
+
+    ASSERT_EQ(handler.events.size(), 5u);
+    EXPECT_EQ(handler.events[1], "str:quote \" slash / tab \t");
+    EXPECT_EQ(handler.events[2], "str:\xC3\xA9\xE2\x82\xAC");
+    EXPECT_EQ(handler.events[3], "str:\xF0\x9F\x98\x80");
+}
+
+TEST(JsonParserTest, SameEventsForAnyChunkSize) {
+    RecordingHandler whole;
+    ASSERT_TRUE(parse_all(kRpcResponse, whole));
+
+    for (size_t chunk : {1u, 2u, 3u, 7u, 64u}) {
+        RecordingHandler split;
+        ASSERT_TRUE(parse_all(kRpcResponse, split, chunk)) << "chunk size " << chunk;
+        EXPECT_EQ(split.events, whole.events) << "chunk size " << chunk;
+    }
+}
+
+TEST(JsonParserTest, NumberAtEndOfInput) {
+    RecordingHandler handler;
+    ASSERT_TRUE(parse_all("42", handler, 1));
+    EXPECT_EQ(handler.events, std::vector<std::string>{"num:42"});
+}
+
+TEST(JsonParserTest, RejectsMalformedInput) {
+    for (const char* json : {"{\"a\" 1}", "[1,]", "[1 2]", "{\"a\":tru}", "[01]", "\"unterminated",
+                             "[1]]", "{1:2}", "[\"bad \\x escape\"]", "", "[", "nul"}) {
+        RecordingHandler handler;
+        EXPECT_FALSE(parse_all(json, handler)) << json;
+    }
+}
+
+TEST(JsonParserTest, ReportsErrorOffset) {
+    RecordingHandler handler;
+    JsonParser parser(handler);
+    std::string json = "[1, 2, }";
+    EXPECT_FALSE(parser.feed(json.data(), json.size()));
+    EXPECT_NE(parser.get_last_error().find("offset 7"), std::string::npos) << parser.get_last_error();
+}
+
+TEST(JsonParserTest, RejectsExcessiveNesting) {
+    RecordingHandler handler;
+    std::string json(JsonParser::kMaxDepth + 1, '[');
+    EXPECT_FALSE(parse_all(json, handler));
+}
+
+TEST(JsonParserTest, ResetAllowsAnotherDocument) {
+    RecordingHandler handler;
+    JsonParser parser(handler);
+    ASSERT_FALSE(parser.feed("}", 1));
+    parser.reset();
+    ASSERT_TRUE(parser.feed("[true]", 6));
+    EXPECT_TRUE(parser.finish());
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "core/package_catalog.hpp"
+
+#include <string>
+
+using namespace pacmangui::core;
+
+TEST(StringPoolTest, InternReturnsSameIdForEqualStrings) {
+    StringPool pool;
+    uint32_t first = pool.intern("1.0-1");
+    uint32_t second = pool.intern(std::string("1.0-1"));
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.get(first), "1.0-1");
+}
+
+TEST(StringPoolTest, FindDoesNotAddStrings) {
+    StringPool pool;
+    pool.intern("bash");
+
+    EXPECT_NE(pool.find("bash"), StringPool::npos);
+    EXPECT_EQ(pool.find("zsh"), StringPool::npos);
+    EXPECT_EQ(pool.size(), 1u);
+}
+
+TEST(StringPoolTest, SurvivesTableGrowth) {
+    StringPool pool;
+    for (int i = 0; i < 10000; ++i) {
+        pool.intern("pkg-" + std::to_string(i));
+    }
+
+    EXPECT_EQ(pool.size(), 10000u);
+    EXPECT_EQ(pool.get(pool.find("pkg-4242")), "pkg-4242");
+}
+
+class RepositoryCatalogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        repo.add("bash", "5.2-1", "The GNU Bourne Again shell");
+        repo.add("zsh", "5.9-1", "A very advanced shell");
+        repo.add("fish", "5.2-1", "Smart and user friendly shell");
+    }
+
+    RepositoryCatalog repo{"extra", false};
+};
+
+TEST_F(RepositoryCatalogTest, ViewsExposeColumns) {
+    ASSERT_EQ(repo.size(), 3u);
+
+    PackageView view = repo.at(1);
+    EXPECT_EQ(view.name, "zsh");
+    EXPECT_EQ(view.version, "5.9-1");
+    EXPECT_EQ(view.repository, "extra");
+    EXPECT_FALSE(view.installed);
+}
+
+TEST_F(RepositoryCatalogTest, FindByName) {
+    EXPECT_EQ(repo.find("fish"), 2u);
+    EXPECT_EQ(repo.find("5.2-1"), RepositoryCatalog::npos);
+    EXPECT_EQ(repo.find("missing"), RepositoryCatalog::npos);
+}
+
+TEST_F(RepositoryCatalogTest, ToPackageCopiesFields) {
+    Package pkg = repo.at(0).to_package();
+    EXPECT_EQ(pkg.get_name(), "bash");
+    EXPECT_EQ(pkg.get_description(), "The GNU Bourne Again shell");
+    EXPECT_EQ(pkg.get_repository(), "extra");
+}
+
+TEST(PackageCatalogTest, FindPrefersInstalledPackage) {
+    auto local = std::make_shared<RepositoryCatalog>("local", true);
+    local->add("bash", "5.1-1", "installed");
+    auto core = std::make_shared<RepositoryCatalog>("core", false);
+    core->add("bash", "5.2-1", "from core");
+    core->add("glibc", "2.39-1", "GNU C Library");
+
+    PackageCatalog catalog(1, local, {core});
+
+    EXPECT_EQ(catalog.size(), 3u);
+    EXPECT_TRUE(catalog.is_installed("bash"));
+    EXPECT_FALSE(catalog.is_installed("glibc"));
+
+    auto bash = catalog.find("bash");
+    ASSERT_TRUE(bash.has_value());
+    EXPECT_EQ(bash->version, "5.1-1");
+    EXPECT_TRUE(bash->installed);
+
+    auto glibc = catalog.find("glibc");
+    ASSERT_TRUE(glibc.has_value());
+    EXPECT_EQ(glibc->repository, "core");
+}
+
+TEST(PackageCatalogTest, ForEachVisitsLocalFirst) {
+    auto local = std::make_shared<RepositoryCatalog>("local", true);
+    local->add("a", "1", "");
+    auto extra = std::make_shared<RepositoryCatalog>("extra", false);
+    extra->add("b", "1", "");
+
+    PackageCatalog catalog(7, local, {extra});
+
+    std::string order;
+    catalog.for_each([&order](const PackageView& view) { order += std::string(view.name); });
+
+    EXPECT_EQ(order, "ab");
+    EXPECT_EQ(catalog.get_generation(), 7u);
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "core/pacman_config.hpp"
+#include "temp_dir.hpp"
+
+#include <fstream>
+#include <string>
+
+using namespace pacmangui::core;
+
+class PacmanConfigTest : public TempDirTest {
+protected:
+    std::string write_file(const std::string& name, const std::string& content) {
+        std::string path = dir + "/" + name;
+        std::ofstream(path) << content;
+        return path;
+    }
+};
+
+TEST_F(PacmanConfigTest, ParsesOptionsAndRepositories) {
+    std::string mirrorlist = write_file("mirrorlist",
+        "## Germany\n"
+        "Server = https://mirror.example.org/$repo/os/$arch\n"
+        "#Server = https://disabled.example.org/$repo/os/$arch\n");
+
+    std::string conf = write_file("pacman.conf",
+        "[options]\n"
+        "CacheDir = /var/cache/pacman/pkg/ /srv/cache/  # two dirs\n"
+        "Architecture = x86_64\n"
+        "ParallelDownloads = 5\n"
+        "\n"
+        "[core]\n"
+        "Include = " + mirrorlist + "\n"
+        "\n"
+        "[custom]\n"
+        "Server = file:///srv/$repo\n");
+
+    PacmanConfig config;
+    ASSERT_TRUE(config.load(conf));
+
+    ASSERT_EQ(config.get_repositories().size(), 2u);
+    const PacmanRepository& core = config.get_repositories()[0];
+    EXPECT_EQ(core.name, "core");
+    ASSERT_EQ(core.servers.size(), 1u);
+    EXPECT_EQ(core.servers[0], "https://mirror.example.org/core/os/x86_64");
+    EXPECT_EQ(config.get_repositories()[1].servers[0], "file:///srv/custom");
+
+    EXPECT_EQ(config.get_cache_dirs(), (std::vector<std::string>{"/var/cache/pacman/pkg/", "/srv/cache/"}));
+    EXPECT_EQ(config.get_parallel_downloads(), 5u);
+    EXPECT_EQ(config.get_hook_dirs().front(), "/usr/share/libalpm/hooks/");
+}
+
+TEST_F(PacmanConfigTest, ArchitectureDeclaredAfterServersIsStillExpanded) {
+    std::string conf = write_file("pacman.conf",
+        "[extra]\n"
+        "Server = https://mirror.example.org/$repo/os/$arch\n"
+        "[options]\n"
+        "Architecture = aarch64\n");
+
+    PacmanConfig config;
+    ASSERT_TRUE(config.load(conf));
+    EXPECT_EQ(config.get_repositories()[0].servers[0], "https://mirror.example.org/extra/os/aarch64");
+}
+
+TEST_F(PacmanConfigTest, MissingFileFails) {
+    PacmanConfig config;
+    EXPECT_FALSE(config.load(dir + "/missing.conf"));
+    EXPECT_FALSE(config.get_last_error().empty());
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "core/process_runner.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+    struct Collected {
+        std::vector<std::string> out;
+        std::vector<std::string> err;
+    };
+
+    ProcessOutputCallback collect(Collected& collected) {
+        return [&collected](const std::string& line, OutputStream stream) {
+            (stream == OutputStream::STDOUT ? collected.out : collected.err).push_back(line);
+        };
+    }
+}
+
+TEST(ProcessRunnerTest, StreamsStdoutAndStderrLines) {
+    ProcessRunner runner;
+    Collected collected;
+    ProcessStatus status = runner.run({"sh", "-c", "echo one; echo two >&2; printf 'three\\r\\nfour'"},
+                                      collect(collected));
+
+    EXPECT_TRUE(status.success());
+    EXPECT_EQ(collected.out, (std::vector<std::string>{"one", "three", "four"}));
+    EXPECT_EQ(collected.err, (std::vector<std::string>{"two"}));
+}
+
+TEST(ProcessRunnerTest, ReportsExitStatus) {
+    ProcessRunner runner;
+    ProcessStatus status = runner.run({"sh", "-c", "exit 3"}, nullptr);
+
+    EXPECT_TRUE(status.started);
+    EXPECT_TRUE(status.exited);
+    EXPECT_EQ(status.exit_code, 3);
+    EXPECT_FALSE(status.success());
+    EXPECT_EQ(status.describe(), "exited with status 3");
+}
+
+TEST(ProcessRunnerTest, ReportsTerminatingSignal) {
+    ProcessRunner runner;
+    ProcessStatus status = runner.run({"sh", "-c", "kill -9 $$"}, nullptr);
+
+    EXPECT_FALSE(status.exited);
+    EXPECT_EQ(status.signal, SIGKILL);
+    EXPECT_FALSE(status.success());
+}
+
+TEST(ProcessRunnerTest, PassesArgumentsWithoutShell) {
+    ProcessRunner runner;
+    Collected collected;
+    ProcessStatus status = runner.run({"printf", "%s\\n", "a b", "$HOME", "; rm -rf /"}, collect(collected));
+
+    EXPECT_TRUE(status.success());
+    EXPECT_EQ(collected.out, (std::vector<std::string>{"a b", "$HOME", "; rm -rf /"}));
+}
+
+TEST(ProcessRunnerTest, WritesInputToStdin) {
+    ProcessRunner runner;
+    runner.set_input("secret\nsecond line\n");
+    Collected collected;
+    ProcessStatus status = runner.run({"cat"}, collect(collected));
+
+    EXPECT_TRUE(status.success());
+    EXPECT_EQ(collected.out, (std::vector<std::string>{"secret", "second line"}));
+}
+
+TEST(ProcessRunnerTest, StartsInWorkingDirectory) {
+    ProcessRunner runner;
+    runner.set_working_directory("/tmp");
+    Collected collected;
+    ProcessStatus status = runner.run({"pwd"}, collect(collected));
+
+    EXPECT_TRUE(status.success());
+    EXPECT_EQ(collected.out, std::vector<std::string>{"/tmp"});
+}
+
+TEST(ProcessRunnerTest, FailsForMissingProgram) {
+    ProcessRunner runner;
+    ProcessStatus status = runner.run({"/nonexistent/pacmangui-test-program"}, nullptr);
+
+    EXPECT_FALSE(status.started);
+    EXPECT_FALSE(status.success());
+    EXPECT_FALSE(runner.get_last_error().empty());
+}
+
+TEST(ProcessRunnerTest, CancelStopsProcess) {
+    ProcessRunner runner;
+    Collected collected;
+
+    std::thread canceller([&runner]() {
+        while (!runner.is_running()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        runner.cancel();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessStatus status = runner.run({"sh", "-c", "echo started; sleep 30"}, collect(collected));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    EXPECT_TRUE(status.cancelled);
+    EXPECT_FALSE(status.success());
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_EQ(collected.out, (std::vector<std::string>{"started"}));
+    EXPECT_FALSE(runner.is_running());
+}
+
+TEST(ProcessRunnerTest, CancelStopsProcessThatClosedItsOutput) {
+    ProcessRunner runner;
+    Collected collected;
+
+    std::thread canceller([&runner]() {
+        while (!runner.is_running()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        runner.cancel();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessStatus status = runner.run({"sh", "-c", "echo started; exec >&- 2>&-; sleep 30"}, collect(collected));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    canceller.join();
+
+    EXPECT_TRUE(status.cancelled);
+    EXPECT_FALSE(status.abandoned);
+    EXPECT_LT(elapsed, std::chrono::seconds(5));
+    EXPECT_EQ(collected.out, (std::vector<std::string>{"started"}));
+    EXPECT_FALSE(runner.is_running());
+}
+
+TEST(ProcessRunnerTest, DoesNotWaitForBackgroundChildren) {
+    ProcessRunner runner;
+    Collected collected;
+
+    auto start = std::chrono::steady_clock::now();
+    ProcessStatus status = runner.run({"sh", "-c", "sleep 5 & echo done"}, collect(collected));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_TRUE(status.success());
+    EXPECT_EQ(collected.out, (std::vector<std::string>{"done"}));
+    EXPECT_LT(elapsed, std::chrono::seconds(3));
+}
+
+TEST(ProcessRunnerTest, RunnersAreIndependent) {
+    Collected first_output;
+    Collected second_output;
+    ProcessStatus first_status;
+    ProcessStatus second_status;
+
+    std::thread first([&]() {
+        ProcessRunner runner;
+        first_status = runner.run({"sh", "-c", "for i in 1 2 3; do echo a$i; sleep 0.05; done"},
+                                  collect(first_output));
+    });
+    std::thread second([&]() {
+        ProcessRunner runner;
+        second_status = runner.run({"sh", "-c", "for i in 1 2 3; do echo b$i; sleep 0.05; done"},
+                                   collect(second_output));
+    });
+    first.join();
+    second.join();
+
+    EXPECT_TRUE(first_status.success());
+    EXPECT_TRUE(second_status.success());
+    EXPECT_EQ(first_output.out, (std::vector<std::string>{"a1", "a2", "a3"}));
+    EXPECT_EQ(second_output.out, (std::vector<std::string>{"b1", "b2", "b3"}));
+}
+
+TEST(ProcessRunnerTest, CancelBeforeRunIsKept) {
+    ProcessRunner runner;
+    runner.cancel();
+
+    Collected collected;
+    ProcessStatus status = runner.run({"echo", "never"}, collect(collected));
+    EXPECT_FALSE(status.started);
+    EXPECT_TRUE(status.cancelled);
+    EXPECT_TRUE(collected.out.empty());
+
+    // The cancel is used up by that run
+    status = runner.run({"echo", "next"}, collect(collected));
+    EXPECT_TRUE(status.success());
+    EXPECT_EQ(collected.out, std::vector<std::string>{"next"});
+}
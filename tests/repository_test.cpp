@@ -21,10 +21,6 @@ TEST_F(RepositoryTest, NewRepositoryIsNotSync) {
     EXPECT_FALSE(repo.is_sync());
 }
 
-TEST_F(RepositoryTest, GetPackagesReturnsEmptyListForNewRepository) {
-    EXPECT_TRUE(repo.get_packages().empty());
-}
-
 TEST_F(RepositoryTest, FindPackageReturnsEmptyPackageIfNotFound) {
     Package pkg = repo.find_package("non-existent-package");
     EXPECT_EQ(pkg.get_name(), "");
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Shared by the tests talking to the AUR RPC interface
+
+inline std::string gzip(const std::string& data)
+{
+    z_stream stream{};
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&stream, data.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+    deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return out;
+}
+
+// An info response listing every requested name, like the AUR does for existing packages
+inline std::string echo_info(const std::string& target)
+{
+    std::string body = R"({"resultcount":0,"results":[)";
+    bool first = true;
+    for (size_t pos = target.find("&arg[]="); pos != std::string::npos; pos = target.find("&arg[]=", pos + 1)) {
+        size_t start = pos + 7;
+        size_t end = target.find('&', start);
+        std::string name = target.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        body += std::string(first ? "" : ",") + R"({"Name":")" + name + R"(","Version":"2.0-1"})";
+        first = false;
+    }
+    return body + R"(],"type":"multiinfo","version":5})";
+}
+
+/**
+ * @brief HTTP/1.1 stand-in for the AUR RPC endpoint
+ *
+ * Serves canned responses keyed by the full request target and keeps
+ * connections open between requests; info requests without a canned
+ * response are answered by echo_info(). Bodies are gzip compressed when the
+ * client accepts it. Connections and requests are counted so connection
+ * reuse can be checked.
+ */
+class RpcStandIn {
+public:
+    RpcStandIn() {
+        m_socket = socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(m_socket, 16);
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_socket, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+
+        m_acceptor = std::thread([this]() { accept_loop(); });
+    }
+
+    ~RpcStandIn() {
+        m_stopping = true;
+        shutdown(m_socket, SHUT_RDWR);
+        close(m_socket);
+        m_acceptor.join();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int client : m_clients) {
+            shutdown(client, SHUT_RDWR);
+        }
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+        for (int client : m_clients) {
+            close(client);
+        }
+    }
+
+    void add_response(const std::string& target, const std::string& body, int status = 200) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_responses[target] = {status, body};
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + "/rpc/";
+    }
+
+    int connection_count() const { return m_connections; }
+    int request_count() const { return m_requests; }
+    int gzip_count() const { return m_gzipped; }
+
+    std::vector<std::string> targets() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_targets;
+    }
+
+private:
+    void accept_loop() {
+        while (!m_stopping) {
+            int client = accept(m_socket, nullptr, nullptr);
+            if (client < 0) {
+                break;
+            }
+            ++m_connections;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_clients.push_back(client);
+            m_workers.emplace_back([this, client]() { serve(client); });
+        }
+    }
+
+    void serve(int client) {
+        std::string pending;
+        char buffer[4096];
+        while (true) {
+            size_t end;
+            while ((end = pending.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    return;
+                }
+                pending.append(buffer, n);
+            }
+            std::string head = pending.substr(0, end);
+            pending.erase(0, end + 4);
+            ++m_requests;
+
+            std::istringstream stream(head);
+            std::string method, target, line;
+            stream >> method >> target;
+            bool accepts_gzip = false;
+            while (std::getline(stream, line)) {
+                if (line.rfind("Accept-Encoding:", 0) == 0 && line.find("gzip") != std::string::npos) {
+                    accepts_gzip = true;
+                }
+            }
+
+            std::pair<int, std::string> response(404, "Not Found");
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_targets.push_back(target);
+                auto it = m_responses.find(target);
+                if (it != m_responses.end()) {
+                    response = it->second;
+                } else if (target.rfind("/rpc/?v=5&type=info&", 0) == 0) {
+                    response = {200, echo_info(target)};
+                }
+            }
+
+            std::string body = response.second;
+            std::string headers = "HTTP/1.1 " + std::to_string(response.first) +
+                                  (response.first == 200 ? " OK" : " Error") +
+                                  "\r\nContent-Type: application/json\r\n";
+            if (accepts_gzip) {
+                body = gzip(body);
+                headers += "Content-Encoding: gzip\r\n";
+                ++m_gzipped;
+            }
+            std::string reply = headers + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+            size_t sent = 0;
+            while (sent < reply.size()) {
+                ssize_t n = send(client, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    return;
+                }
+                sent += n;
+            }
+        }
+    }
+
+    int m_socket = -1;
+    int m_port = 0;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<int> m_connections{0};
+    std::atomic<int> m_requests{0};
+    std::atomic<int> m_gzipped{0};
+    std::thread m_acceptor;
+    std::mutex m_mutex;
+    std::vector<int> m_clients;
+    std::vector<std::thread> m_workers;
+    std::map<std::string, std::pair<int, std::string>> m_responses;
+    std::vector<std::string> m_targets;
+};
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "core/search_index.hpp"
+
+#include <string>
+
+using namespace pacmangui::core;
+
+class SearchIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        auto local = std::make_shared<RepositoryCatalog>("local", true);
+        local->add("bash", "5.2-1", "The GNU Bourne Again shell");
+
+        auto core = std::make_shared<RepositoryCatalog>("core", false);
+        core->add("bash", "5.2-1", "The GNU Bourne Again shell");
+        core->add("bash-completion", "2.11-1", "Programmable completion for the bash shell");
+        core->add("fish", "3.7-1", "Smart and user friendly shell");
+        core->add("rebash", "1.0-1", "Tool that wraps a shell");
+        core->add("vim", "9.1-1", "Vi Improved, a highly configurable text editor");
+
+        catalog = std::make_shared<PackageCatalog>(1, local, std::vector<PackageCatalog::RepositoryPtr>{core});
+        index = std::make_shared<SearchIndex>(catalog);
+    }
+
+    static std::vector<std::string> names(const std::vector<SearchHit>& hits) {
+        std::vector<std::string> result;
+        for (const auto& hit : hits) {
+            result.emplace_back(hit.package.name);
+        }
+        return result;
+    }
+
+    std::shared_ptr<PackageCatalog> catalog;
+    std::shared_ptr<SearchIndex> index;
+};
+
+TEST_F(SearchIndexTest, SubstringSearchRanksAndSkipsInstalledCopies) {
+    std::vector<SearchHit> hits = index->search_names("BASH");
+
+    ASSERT_EQ(hits.size(), 3u);
+    EXPECT_EQ(names(hits), (std::vector<std::string>{"bash", "bash-completion", "rebash"}));
+    EXPECT_TRUE(hits[0].package.installed);
+    EXPECT_EQ(hits[0].match, MatchKind::Exact);
+    EXPECT_EQ(hits[1].match, MatchKind::Prefix);
+    EXPECT_EQ(hits[2].match, MatchKind::Substring);
+}
+
+TEST_F(SearchIndexTest, SegmentSearchesAddUpToTheWholeSearch) {
+    ASSERT_EQ(index->get_segment_count(), 2u);
+    EXPECT_EQ(index->get_segment(0).get_repository().get_name(), "local");
+    EXPECT_EQ(index->get_segment(1).get_repository().get_name(), "core");
+
+    std::vector<SearchHit> hits;
+    for (size_t segment = 0; segment < index->get_segment_count(); ++segment) {
+        std::vector<SearchHit> part = index->search_names("bash", segment);
+        hits.insert(hits.end(), part.begin(), part.end());
+    }
+    EXPECT_EQ(names(hits), names(index->search_names("bash")));
+    EXPECT_TRUE(index->search_names("bash", 2).empty());
+}
+
+TEST_F(SearchIndexTest, ShortQueriesFallBackToScan) {
+    EXPECT_EQ(names(index->search_names("im")), (std::vector<std::string>{"vim"}));
+    EXPECT_TRUE(index->search_names("zz").empty());
+}
+
+TEST_F(SearchIndexTest, TrigramCandidatesAreVerified) {
+    // Every trigram of "ashba" occurs in "bash-completion"/"rebash" but not in sequence
+    EXPECT_TRUE(index->search_names("ashba").empty());
+    EXPECT_EQ(names(index->search_names("completion")), (std::vector<std::string>{"bash-completion"}));
+}
+
+TEST_F(SearchIndexTest, CancelledSearchesReturnNothing) {
+    std::atomic<bool> cancelled{true};
+    EXPECT_TRUE(index->search_names("bash", &cancelled).empty());
+    EXPECT_TRUE(index->search_names("im", 1, &cancelled).empty());
+
+    SearchOptions options;
+    options.cancelled = &cancelled;
+    EXPECT_TRUE(index->search("shell", options).empty());
+
+    cancelled = false;
+    EXPECT_EQ(index->search_names("bash", &cancelled).size(), 3u);
+}
+
+TEST_F(SearchIndexTest, RefiningMatchesAFreshSearch) {
+    std::vector<SearchHit> previous = index->search_names("as");
+    std::vector<SearchHit> refined = index->refine_names("BASH", previous);
+
+    EXPECT_EQ(names(refined), names(index->search_names("bash")));
+    ASSERT_EQ(refined.size(), 3u);
+    EXPECT_EQ(refined[0].match, MatchKind::Exact);
+    EXPECT_EQ(refined[1].match, MatchKind::Prefix);
+}
+
+TEST_F(SearchIndexTest, IncrementalSearchNarrowsWhileTyping) {
+    IncrementalSearch search;
+    for (const char* query : {"b", "ba", "bas", "bash", "bash-c", "bash", "vi", "vim"}) {
+        EXPECT_EQ(names(search.search_names(index, query)), names(index->search_names(query))) << query;
+        EXPECT_EQ(names(search.search_names(index, query, 1)), names(index->search_names(query, 1))) << query;
+    }
+    // Every step but the deletion back to "bash" and the switch to "vi" narrowed, for both keys
+    EXPECT_EQ(search.get_narrowed_searches(), 10u);
+
+    // A new generation is searched in full
+    auto rebuilt = std::make_shared<SearchIndex>(catalog, index.get());
+    EXPECT_EQ(names(search.search_names(rebuilt, "vim")), (std::vector<std::string>{"vim"}));
+    EXPECT_EQ(search.get_narrowed_searches(), 10u);
+}
+
+TEST_F(SearchIndexTest, FuzzySearchToleratesTypos) {
+    std::vector<SearchHit> hits = index->search_fuzzy("bash-compleshun");
+    ASSERT_TRUE(hits.empty());
+
+    hits = index->search_fuzzy("bash-complation");
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].package.name, "bash-completion");
+    EXPECT_EQ(hits[0].match, MatchKind::Fuzzy);
+
+    // Exact hits rank first, the installed copy of bash is not listed twice
+    EXPECT_EQ(names(index->search_fuzzy("bash")), (std::vector<std::string>{"bash", "bash-completion", "rebash"}));
+
+    SearchOptions options;
+    options.typos_only = true;
+    EXPECT_EQ(names(index->search_fuzzy("fisk", options)), (std::vector<std::string>{"fish"}));
+    EXPECT_TRUE(index->search_fuzzy("fish", options).empty());
+}
+
+TEST_F(SearchIndexTest, PrefixSearch) {
+    EXPECT_EQ(names(index->search_prefix("ba")), (std::vector<std::string>{"bash", "bash-completion"}));
+    EXPECT_TRUE(index->search_prefix("ash").empty());
+}
+
+TEST_F(SearchIndexTest, DescriptionSearchRequiresAllWords) {
+    std::vector<SearchHit> hits = index->search("text edit");
+    ASSERT_EQ(hits.size(), 1u);
+    EXPECT_EQ(hits[0].package.name, "vim");
+    EXPECT_EQ(hits[0].match, MatchKind::Description);
+
+    SearchOptions names_only;
+    names_only.descriptions = false;
+    EXPECT_TRUE(index->search("text edit", names_only).empty());
+}
+
+TEST_F(SearchIndexTest, NameMatchesRankAboveDescriptions) {
+    std::vector<SearchHit> hits = index->search("shell");
+    ASSERT_EQ(hits.size(), 4u);
+    EXPECT_EQ(hits[0].package.name, "bash");
+
+    SearchOptions limited;
+    limited.limit = 2;
+    EXPECT_EQ(index->search("bash", limited).size(), 2u);
+    EXPECT_EQ(index->search("bash", limited)[0].match, MatchKind::Exact);
+}
+
+TEST_F(SearchIndexTest, RebuildReusesUnchangedSegments) {
+    auto extra = std::make_shared<RepositoryCatalog>("extra", false);
+    extra->add("zsh", "5.9-1", "A very advanced shell");
+
+    std::vector<PackageCatalog::RepositoryPtr> sync = catalog->get_sync();
+    sync.push_back(extra);
+    auto next = std::make_shared<PackageCatalog>(2, catalog->get_local_ptr(), sync);
+
+    SearchIndex rebuilt(next, index.get());
+    EXPECT_EQ(rebuilt.get_reused_segments(), 2u);
+    EXPECT_EQ(names(rebuilt.search_names("zsh")), (std::vector<std::string>{"zsh"}));
+}
@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include "core/search_pipeline.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+SearchStage make_stage(SearchSource source, const std::string& name, size_t count, int delay_ms = 0,
+                       bool slow = false)
+{
+    SearchStage stage;
+    stage.source = source;
+    stage.name = name;
+    stage.slow = slow;
+    stage.run = [name, count, delay_ms](const std::string& query, const std::atomic<bool>&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        SearchResults results;
+        for (size_t i = 0; i < count; ++i) {
+            results.packages.emplace_back(query + "-" + name + "-" + std::to_string(i), "1.0-1");
+        }
+        return results;
+    };
+    return stage;
+}
+
+// Collects what the pipeline delivers and lets the test wait for the end of a query
+class Receiver {
+public:
+    SearchPipeline::BatchCallback on_batch() {
+        return [this](const SearchBatch& batch) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            batches.push_back(batch);
+        };
+    }
+
+    SearchPipeline::FinishedCallback on_finished() {
+        return [this](const SearchStats& stats) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            finished.push_back(stats);
+            m_changed.notify_all();
+        };
+    }
+
+    void wait_for(size_t queries) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        ASSERT_TRUE(m_changed.wait_for(lock, std::chrono::seconds(5), [&]() { return finished.size() >= queries; }));
+    }
+
+    std::vector<SearchBatch> batches;
+    std::vector<SearchStats> finished;
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+};
+
+} // namespace
+
+TEST(SearchPipelineTest, DeliversFastStagesWithoutWaitingForSlowOnes) {
+    SearchPipeline pipeline;
+    Receiver receiver;
+
+    std::vector<SearchStage> stages = {make_stage(SearchSource::AUR, "aur", 2, 300, true),
+                                       make_stage(SearchSource::LOCAL, "local", 1),
+                                       make_stage(SearchSource::SYNC, "core", 3, 20)};
+    uint64_t id = pipeline.start("vim", stages, receiver.on_batch(), receiver.on_finished());
+    receiver.wait_for(1);
+
+    ASSERT_EQ(receiver.batches.size(), 3u);
+    EXPECT_EQ(receiver.batches[0].stage, "local");
+    EXPECT_EQ(receiver.batches[0].source, SearchSource::LOCAL);
+    EXPECT_EQ(receiver.batches[0].packages[0].get_name(), "vim-local-0");
+    EXPECT_EQ(receiver.batches[1].stage, "core");
+    EXPECT_EQ(receiver.batches[2].stage, "aur");
+    EXPECT_EQ(receiver.batches[2].query_id, id);
+
+    const SearchStats& stats = receiver.finished[0];
+    EXPECT_EQ(stats.query_id, id);
+    EXPECT_FALSE(stats.cancelled);
+    EXPECT_EQ(stats.stages, 3u);
+    EXPECT_EQ(stats.results, 6u);
+    EXPECT_GE(stats.first_result_ms, 0);
+    EXPECT_LT(stats.first_result_ms, 250);
+    EXPECT_GE(stats.total_ms, 300);
+
+    pipeline.wait();
+    EXPECT_EQ(pipeline.get_last_stats().query_id, id);
+}
+
+TEST(SearchPipelineTest, SplitsResultsIntoBatches) {
+    SearchPipeline pipeline(100);
+    Receiver receiver;
+
+    SearchStage mixed = make_stage(SearchSource::FLATPAK, "mixed", 150);
+    mixed.run = [](const std::string&, const std::atomic<bool>&) {
+        SearchResults results;
+        results.packages.resize(150);
+        results.flatpak_packages.resize(120);
+        return results;
+    };
+    pipeline.start("x", {make_stage(SearchSource::SYNC, "extra", 250), mixed}, receiver.on_batch(),
+                   receiver.on_finished());
+    receiver.wait_for(1);
+
+    std::vector<std::pair<size_t, size_t>> extra_sizes;
+    std::vector<std::pair<size_t, size_t>> mixed_sizes;
+    for (const auto& batch : receiver.batches) {
+        auto& sizes = batch.stage == "extra" ? extra_sizes : mixed_sizes;
+        sizes.emplace_back(batch.packages.size(), batch.flatpak_packages.size());
+    }
+    using Sizes = std::vector<std::pair<size_t, size_t>>;
+    EXPECT_EQ(extra_sizes, (Sizes{{100, 0}, {100, 0}, {50, 0}}));
+    EXPECT_EQ(mixed_sizes, (Sizes{{100, 0}, {50, 50}, {0, 70}}));
+    EXPECT_EQ(receiver.finished[0].results, 520u);
+}
+
+TEST(SearchPipelineTest, BatchesPinTheCatalogOfTheirViews) {
+    SearchPipeline pipeline(100);
+    Receiver receiver;
+
+    SearchStage database = make_stage(SearchSource::SYNC, "extra", 0);
+    database.run = [](const std::string&, const std::atomic<bool>&) {
+        auto extra = std::make_shared<RepositoryCatalog>("extra", false);
+        for (int i = 0; i < 130; ++i) {
+            extra->add("vim-" + std::to_string(i), "9.1-1", "Vi Improved");
+        }
+        SearchResults results;
+        results.catalog = std::make_shared<PackageCatalog>(1, nullptr, std::vector<PackageCatalog::RepositoryPtr>{extra});
+        for (size_t i = 0; i < extra->size(); ++i) {
+            results.views.push_back(extra->at(i));
+        }
+        results.packages.resize(20);
+        return results;
+    };
+    pipeline.start("vim", {database}, receiver.on_batch(), receiver.on_finished());
+    receiver.wait_for(1);
+
+    // The stage has dropped its catalog, only the batches keep it alive
+    ASSERT_EQ(receiver.batches.size(), 2u);
+    EXPECT_EQ(receiver.batches[0].views.size(), 100u);
+    EXPECT_TRUE(receiver.batches[0].packages.empty());
+    EXPECT_EQ(receiver.batches[1].views.size(), 30u);
+    EXPECT_EQ(receiver.batches[1].packages.size(), 20u);
+    ASSERT_TRUE(receiver.batches[1].catalog);
+    EXPECT_EQ(receiver.batches[1].catalog->size(), 130u);
+    EXPECT_EQ(receiver.batches[1].views.back().name, "vim-129");
+    EXPECT_EQ(receiver.finished[0].results, 150u);
+}
+
+TEST(SearchPipelineTest, NewerQueriesCancelOlderOnes) {
+    SearchPipeline pipeline;
+    Receiver receiver;
+
+    // Stands in for a network request that gives up once the query is stale
+    SearchStage waiting;
+    waiting.source = SearchSource::AUR;
+    waiting.name = "aur";
+    waiting.slow = true;
+    waiting.run = [](const std::string& query, const std::atomic<bool>& cancelled) {
+        for (int i = 0; i < 500 && !cancelled; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        SearchResults results;
+        results.packages.emplace_back(query + "-late", "1");
+        return results;
+    };
+
+    uint64_t first = pipeline.start("vi", {waiting}, receiver.on_batch(), receiver.on_finished());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t second = pipeline.start("vim", {make_stage(SearchSource::LOCAL, "local", 1)}, receiver.on_batch(),
+                                     receiver.on_finished());
+    EXPECT_GT(second, first);
+    EXPECT_EQ(pipeline.get_current_query(), second);
+    receiver.wait_for(2);
+    pipeline.wait();
+
+    for (const auto& batch : receiver.batches) {
+        EXPECT_EQ(batch.query_id, second);
+    }
+    ASSERT_EQ(receiver.finished.size(), 2u);
+    for (const auto& stats : receiver.finished) {
+        EXPECT_EQ(stats.cancelled, stats.query_id == first);
+    }
+    EXPECT_EQ(pipeline.get_last_stats().query_id, second);
+
+    pipeline.cancel();
+    EXPECT_EQ(pipeline.get_last_stats().query_id, second);
+}
+
+TEST(SearchPipelineTest, FinishesQueriesWithoutResults) {
+    SearchPipeline pipeline;
+    Receiver receiver;
+
+    SearchStage failing;
+    failing.name = "broken";
+    failing.run = [](const std::string&, const std::atomic<bool>&) -> SearchResults {
+        throw std::runtime_error("database gone");
+    };
+    pipeline.start("none", {failing, make_stage(SearchSource::SYNC, "core", 0)}, receiver.on_batch(),
+                   receiver.on_finished());
+    pipeline.start("nothing", {}, receiver.on_batch(), receiver.on_finished());
+    receiver.wait_for(2);
+
+    EXPECT_TRUE(receiver.batches.empty());
+    for (const auto& stats : receiver.finished) {
+        EXPECT_EQ(stats.results, 0u);
+        EXPECT_LT(stats.first_result_ms, 0);
+    }
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "core/search_scheduler.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pacmangui::core;
+
+namespace {
+
+// Records the queries that actually ran
+class Recorder {
+public:
+    SearchScheduler::Task task(int duration_ms = 0) {
+        return [this, duration_ms](const SearchToken& token) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+            std::lock_guard<std::mutex> lock(m_mutex);
+            queries.push_back(token.get_query());
+        };
+    }
+
+    std::vector<std::string> ran() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return queries;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::string> queries;
+};
+
+} // namespace
+
+TEST(SearchSchedulerTest, OnlyTheLastKeystrokeRuns) {
+    SearchScheduler scheduler;
+    scheduler.set_delay_limits(50, 50);
+    Recorder recorder;
+
+    uint64_t first = scheduler.schedule("pyt", recorder.task());
+    scheduler.schedule("pyth", recorder.task());
+    uint64_t last = scheduler.schedule("python", recorder.task());
+    scheduler.wait();
+
+    EXPECT_EQ(recorder.ran(), (std::vector<std::string>{"python"}));
+    EXPECT_GT(last, first);
+    EXPECT_FALSE(scheduler.is_current(first));
+    EXPECT_TRUE(scheduler.is_current(last));
+}
+
+TEST(SearchSchedulerTest, NewerQueriesCancelRunningOnes) {
+    SearchScheduler scheduler;
+    std::atomic<bool> started{false};
+    std::atomic<bool> saw_cancel{false};
+
+    uint64_t first = scheduler.run_now("vim", [&](const SearchToken& token) {
+        started = true;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!token.is_cancelled() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        saw_cancel = token.get_flag()->load();
+    });
+    while (!started) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    Recorder recorder;
+    uint64_t second = scheduler.run_now("neovim", recorder.task());
+    scheduler.wait();
+
+    EXPECT_TRUE(saw_cancel);
+    EXPECT_FALSE(scheduler.is_current(first));
+    EXPECT_TRUE(scheduler.is_current(second));
+    EXPECT_EQ(recorder.ran(), (std::vector<std::string>{"neovim"}));
+}
+
+TEST(SearchSchedulerTest, CancelDropsThePendingSearch) {
+    SearchScheduler scheduler;
+    scheduler.set_delay_limits(100, 100);
+    Recorder recorder;
+
+    uint64_t generation = scheduler.schedule("firefox", recorder.task());
+    scheduler.cancel();
+    scheduler.wait();
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+    EXPECT_TRUE(recorder.ran().empty());
+    EXPECT_FALSE(scheduler.is_current(generation));
+}
+
+TEST(SearchSchedulerTest, DelayFollowsSearchDuration) {
+    SearchScheduler scheduler;
+    scheduler.set_delay_limits(20, 300);
+
+    EXPECT_EQ(scheduler.get_delay_ms("gimp"), 20);
+    EXPECT_EQ(scheduler.get_delay_ms("gi"), 300);
+
+    scheduler.report_duration(50);
+    EXPECT_EQ(scheduler.get_delay_ms("gimp"), 100);
+
+    for (int i = 0; i < 20; ++i) {
+        scheduler.report_duration(1000);
+    }
+    EXPECT_EQ(scheduler.get_delay_ms("gimp"), 300);
+
+    for (int i = 0; i < 40; ++i) {
+        scheduler.report_duration(1);
+    }
+    EXPECT_EQ(scheduler.get_delay_ms("gimp"), 20);
+}
+
+TEST(SearchSchedulerTest, ExtendsMatchesNarrowingQueries) {
+    EXPECT_TRUE(SearchScheduler::extends("pytho", "pyth"));
+    EXPECT_TRUE(SearchScheduler::extends("python-pip", "PIP"));
+    EXPECT_FALSE(SearchScheduler::extends("pyt", "pyth"));
+    EXPECT_FALSE(SearchScheduler::extends("ruby", "pyth"));
+    EXPECT_FALSE(SearchScheduler::extends("pyth", ""));
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "core/sha256.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace pacmangui::core;
+
+// Test vectors from FIPS 180-4 and NIST CAVS
+TEST(Sha256Test, HashesKnownVectors) {
+    EXPECT_EQ(Sha256::hash(""), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(Sha256::hash("abc"), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(Sha256::hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    EXPECT_EQ(Sha256::hash(std::string(1000000, 'a')),
+              "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST(Sha256Test, SplitUpdatesMatchOneUpdate) {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += static_cast<char>(i * 7);
+    }
+
+    // Split at every offset around the 55/56/64 byte padding boundaries and beyond
+    for (size_t split : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 999}) {
+        Sha256 sha;
+        sha.update(data.substr(0, split));
+        sha.update(data.substr(split));
+        EXPECT_EQ(sha.hex_digest(), Sha256::hash(data)) << "split at " << split;
+    }
+
+    Sha256 sha;
+    sha.update("first");
+    sha.hex_digest();
+    sha.reset();
+    sha.update("abc");
+    EXPECT_EQ(sha.hex_digest(), Sha256::hash("abc"));
+}
+
+TEST(Sha256Test, HashesFiles) {
+    char path[] = "/tmp/sha256_testXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    std::string data(200000, 'x');
+    ASSERT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+    close(fd);
+
+    Sha256 sha;
+    EXPECT_TRUE(sha.update_file(path));
+    EXPECT_EQ(sha.hex_digest(), Sha256::hash(data));
+    unlink(path);
+
+    Sha256 missing;
+    EXPECT_FALSE(missing.update_file("/nonexistent/file"));
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+
+// Shared by the tests that work on files
+
+/**
+ * @brief A new directory under the system temporary directory
+ *
+ * Removed with its contents when the object goes away, unless remove()
+ * already did.
+ */
+class TempDir {
+public:
+    explicit TempDir(const std::string& prefix) {
+        std::error_code error;
+        std::filesystem::path base = std::filesystem::temp_directory_path(error);
+        if (error) {
+            m_error = error.message();
+            return;
+        }
+
+        std::random_device random;
+        for (int attempt = 0; attempt < 100 && m_path.empty(); ++attempt) {
+            std::filesystem::path candidate = base / (prefix + "_" + std::to_string(random()));
+            if (std::filesystem::create_directory(candidate, error)) {
+                m_path = candidate.string();
+            } else if (error) {
+                m_error = error.message();
+                return;
+            }
+        }
+        if (m_path.empty()) {
+            m_error = "no unused name under " + base.string();
+        }
+    }
+
+    ~TempDir() {
+        std::string error;
+        remove(error);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    /**
+     * @brief Get the directory
+     * @return const std::string& Its path, empty if it could not be created
+     */
+    const std::string& path() const { return m_path; }
+
+    /**
+     * @brief Get why the directory could not be created
+     * @return const std::string& The reason, empty on success
+     */
+    const std::string& error() const { return m_error; }
+
+    /**
+     * @brief Remove the directory and everything in it
+     * @param error Receives the reason on failure
+     * @return bool True if nothing is left
+     */
+    bool remove(std::string& error) {
+        if (m_path.empty()) {
+            return true;
+        }
+        std::error_code code;
+        std::filesystem::remove_all(m_path, code);
+        if (code) {
+            error = m_path + ": " + code.message();
+            return false;
+        }
+        m_path.clear();
+        return true;
+    }
+
+private:
+    std::string m_path;
+    std::string m_error;
+};
+
+/**
+ * @brief Fixture giving every test an empty directory in dir
+ *
+ * Fixtures deriving from it call TempDirTest::SetUp() first when they
+ * override SetUp(), and TempDirTest::TearDown() last.
+ */
+class TempDirTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const ::testing::TestInfo* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        m_temp_dir = std::make_unique<TempDir>(info->test_suite_name());
+        ASSERT_FALSE(m_temp_dir->path().empty()) << "Cannot create a temporary directory: " << m_temp_dir->error();
+        dir = m_temp_dir->path();
+    }
+
+    void TearDown() override {
+        std::string error;
+        ASSERT_TRUE(!m_temp_dir || m_temp_dir->remove(error)) << error;
+    }
+
+    std::string dir;
+
+private:
+    std::unique_ptr<TempDir> m_temp_dir;
+};
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "core/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace pacmangui::core;
+
+TEST(ThreadPoolTest, SubmitReturnsResult) {
+    ThreadPool pool(2);
+    std::future<int> result = pool.submit([]() { return 6 * 7; });
+    EXPECT_EQ(result.get(), 42);
+}
+
+TEST(ThreadPoolTest, SubmitPassesExceptionThroughFuture) {
+    ThreadPool pool(1);
+    std::future<void> result = pool.submit([]() { throw std::runtime_error("failed"); });
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndexOnce) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> visits(1000);
+    pool.parallel_for(visits.size(), [&visits](size_t i) { visits[i]++; });
+
+    for (const auto& count : visits) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+TEST(ThreadPoolTest, ParallelForUsesSeveralThreads) {
+    ThreadPool pool(3);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    pool.parallel_for(4, [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    });
+
+    EXPECT_GT(threads.size(), 1u);
+}
+
+TEST(ThreadPoolTest, NestedParallelForDoesNotDeadlock) {
+    // Every worker is busy in the outer loop, the callers do the inner work
+    ThreadPool pool(2);
+    std::atomic<int> total{0};
+    pool.parallel_for(4, [&](size_t) {
+        pool.parallel_for(8, [&total](size_t) { total++; });
+    });
+
+    EXPECT_EQ(total.load(), 32);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrowsAfterAllIndicesFinished) {
+    ThreadPool pool(2);
+    std::atomic<int> visited{0};
+    EXPECT_THROW(pool.parallel_for(16, [&visited](size_t i) {
+        visited++;
+        if (i == 3) {
+            throw std::runtime_error("failed");
+        }
+    }), std::runtime_error);
+    EXPECT_EQ(visited.load(), 16);
+}
+
+TEST(ThreadPoolTest, DestructorFinishesQueuedTasks) {
+    std::atomic<int> done{0};
+    {
+        ThreadPool pool(1);
+        for (int i = 0; i < 10; ++i) {
+            pool.submit([&done]() { done++; });
+        }
+    }
+    EXPECT_EQ(done.load(), 10);
+}